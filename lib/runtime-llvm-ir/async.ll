@@ -0,0 +1,209 @@
+; Async runtime, linked into every program. 'async func's are stackless:
+; each is lowered to an LLVM coroutine, with the switched-resume ABI, whose
+; frame holds what lives across its 'await's. Coroutines run on the thread
+; that entered their executor, which resumes them when what they await
+; completes, and asks its driver, such as std.io's, for completions when
+; none are ready.
+;
+; An 'async func f(...) -> T' is lowered to 'define i8* @f(...)' with
+; "coroutine.presplit"="0", which:
+;   - Has an '{ %async_SEP_Promise, T }' promise, for 'llvm.coro.id', with
+;     its continuation set to null before anything else.
+;   - Allocates its frame with 'malloc' when 'llvm.coro.alloc' says to, and
+;     frees 'llvm.coro.free' in its cleanup, so callers can elide it.
+;   - Starts straight away, with no initial suspend, and returns its handle
+;     at its first suspend, which may be its final one.
+;   - Stores its result in its promise, then calls 'async_SEP_complete' and
+;     suspends for the last time.
+;
+; 'await f(...)' calls '@f', and if 'llvm.coro.done' says it has not
+; completed, stores a waiter for the awaiting coroutine as its promise's
+; continuation and suspends. Once it has completed, it loads the result from
+; its promise and destroys it, on every path, so the inliner can inline
+; '@f' once it is split and LLVM can allocate its frame in the caller's.
+; Awaiting anything else, like std.io's 'io_SEP_wait', hands a waiter to
+; whatever completes it, then suspends. Waiters live in the awaiting
+; coroutine's frame, so awaiting never allocates.
+
+; A suspended coroutine, waiting for something to complete.
+%async_SEP_Waiter = type {
+    i8*,                    ; 0: _handle - the coroutine to resume
+    %async_SEP_Waiter*,     ; 1: _next - the next waiter in its executor's ready queue
+    i64                     ; 2: result - what completed it, like the events std.io polled
+}
+
+; The start of every async function's promise, followed by its result.
+%async_SEP_Promise = type {
+    %async_SEP_Waiter*      ; 0: _continuation - the coroutine awaiting it, or null
+}
+
+; Resumes coroutines whose waits completed, on the thread that entered it.
+%async_SEP_Executor = type {
+    %async_SEP_Waiter*,                                 ; 0: _ready - waiters to resume, first in first out
+    %async_SEP_Waiter*,                                 ; 1: _ready_last
+    i64 (%async_SEP_Executor*, i8*, i1)*,               ; 2: _driver - wakes waiters that completed, see 'set_driver'
+    i8*                                                 ; 3: _driver_context - passed to the driver
+}
+
+@async_current_executor = internal thread_local global %async_SEP_Executor* null
+
+declare void @llvm.coro.resume(i8*)
+declare i1 @llvm.coro.done(i8*)
+
+define void @async_SEP_Executor_SEP___init__(%async_SEP_Executor* %self) nounwind {
+    store %async_SEP_Executor zeroinitializer, %async_SEP_Executor* %self
+
+    ret void
+}
+
+; Enters an executor, for 'using', so coroutines on this thread complete
+; through it. Returns the executor entered before, to exit back to.
+define %async_SEP_Executor* @async_SEP_Executor_SEP___enter__(%async_SEP_Executor* %self) nounwind {
+    %previous = load %async_SEP_Executor*, %async_SEP_Executor** @async_current_executor
+    store %async_SEP_Executor* %self, %async_SEP_Executor** @async_current_executor
+
+    ret %async_SEP_Executor* %previous
+}
+
+; Exits an executor at the end of a 'using' scope, returning to the one
+; entered before it.
+define void @async_SEP_Executor_SEP___exit__(%async_SEP_Executor* %self, %async_SEP_Executor* %previous) nounwind {
+    store %async_SEP_Executor* %previous, %async_SEP_Executor** @async_current_executor
+
+    ret void
+}
+
+; Gets the executor entered on this thread, or null.
+define %async_SEP_Executor* @async_SEP_executor() nounwind readonly {
+    %executor = load %async_SEP_Executor*, %async_SEP_Executor** @async_current_executor
+
+    ret %async_SEP_Executor* %executor
+}
+
+; Sets what an executor calls when no coroutine is ready to resume. It is
+; called with the executor, 'context', and whether to block until
+; something completes, and wakes the waiters that did, returning how many.
+define void @async_SEP_Executor_SEP_set_driver(%async_SEP_Executor* %self,
+                                              i64 (%async_SEP_Executor*, i8*, i1)* %driver, i8* %context) nounwind {
+    %driver_pointer = getelementptr %async_SEP_Executor, %async_SEP_Executor* %self, i64 0, i32 2
+    store i64 (%async_SEP_Executor*, i8*, i1)* %driver, i64 (%async_SEP_Executor*, i8*, i1)** %driver_pointer
+    %context_pointer = getelementptr %async_SEP_Executor, %async_SEP_Executor* %self, i64 0, i32 3
+    store i8* %context, i8** %context_pointer
+
+    ret void
+}
+
+; Queues a waiter whose wait completed, to be resumed by the executor
+; after those queued before it.
+define void @async_SEP_Executor_SEP_wake(%async_SEP_Executor* %self, %async_SEP_Waiter* %waiter) nounwind {
+entry:
+    %next_pointer = getelementptr %async_SEP_Waiter, %async_SEP_Waiter* %waiter, i64 0, i32 1
+    store %async_SEP_Waiter* null, %async_SEP_Waiter** %next_pointer
+    %ready_pointer = getelementptr %async_SEP_Executor, %async_SEP_Executor* %self, i64 0, i32 0
+    %last_pointer = getelementptr %async_SEP_Executor, %async_SEP_Executor* %self, i64 0, i32 1
+    %last = load %async_SEP_Waiter*, %async_SEP_Waiter** %last_pointer
+    %is_empty = icmp eq %async_SEP_Waiter* %last, null
+    br i1 %is_empty, label %first, label %append
+
+first:
+    store %async_SEP_Waiter* %waiter, %async_SEP_Waiter** %ready_pointer
+    br label %exit
+
+append:
+    %last_next_pointer = getelementptr %async_SEP_Waiter, %async_SEP_Waiter* %last, i64 0, i32 1
+    store %async_SEP_Waiter* %waiter, %async_SEP_Waiter** %last_next_pointer
+    br label %exit
+
+exit:
+    store %async_SEP_Waiter* %waiter, %async_SEP_Waiter** %last_pointer
+
+    ret void
+}
+
+; Called by an async function as it completes, before its final suspend.
+; Wakes the coroutine awaiting it, if it suspended to.
+define void @async_SEP_complete(%async_SEP_Promise* %promise) nounwind {
+entry:
+    %continuation_pointer = getelementptr %async_SEP_Promise, %async_SEP_Promise* %promise, i64 0, i32 0
+    %continuation = load %async_SEP_Waiter*, %async_SEP_Waiter** %continuation_pointer
+    %is_awaited = icmp ne %async_SEP_Waiter* %continuation, null
+    br i1 %is_awaited, label %wake, label %exit
+
+wake:
+    %executor = load %async_SEP_Executor*, %async_SEP_Executor** @async_current_executor
+    call void @async_SEP_Executor_SEP_wake(%async_SEP_Executor* %executor, %async_SEP_Waiter* %continuation)
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Takes the first waiter from an executor's ready queue, or null.
+define private %async_SEP_Waiter* @async_SEP_Executor_SEP__take_ready(%async_SEP_Executor* %self) nounwind {
+entry:
+    %ready_pointer = getelementptr %async_SEP_Executor, %async_SEP_Executor* %self, i64 0, i32 0
+    %first = load %async_SEP_Waiter*, %async_SEP_Waiter** %ready_pointer
+    %is_empty = icmp eq %async_SEP_Waiter* %first, null
+    br i1 %is_empty, label %exit, label %take
+
+take:
+    %next_pointer = getelementptr %async_SEP_Waiter, %async_SEP_Waiter* %first, i64 0, i32 1
+    %next = load %async_SEP_Waiter*, %async_SEP_Waiter** %next_pointer
+    store %async_SEP_Waiter* %next, %async_SEP_Waiter** %ready_pointer
+    %was_last = icmp eq %async_SEP_Waiter* %next, null
+    br i1 %was_last, label %clear_last, label %exit
+
+clear_last:
+    %last_pointer = getelementptr %async_SEP_Executor, %async_SEP_Executor* %self, i64 0, i32 1
+    store %async_SEP_Waiter* null, %async_SEP_Waiter** %last_pointer
+    br label %exit
+
+exit:
+    %waiter = phi %async_SEP_Waiter* [ null, %entry ], [ %first, %take ], [ %first, %clear_last ]
+
+    ret %async_SEP_Waiter* %waiter
+}
+
+; Resumes coroutines as their waits complete, until the coroutine 'handle'
+; has, calling the driver, blocking, whenever none are ready. The executor
+; is entered while it runs. Returns false if nothing was left to complete
+; the coroutine, which is then left suspended.
+define i1 @async_SEP_Executor_SEP_run(%async_SEP_Executor* %self, i8* %handle) nounwind {
+entry:
+    %previous = call %async_SEP_Executor* @async_SEP_Executor_SEP___enter__(%async_SEP_Executor* %self)
+    %driver_pointer = getelementptr %async_SEP_Executor, %async_SEP_Executor* %self, i64 0, i32 2
+    %context_pointer = getelementptr %async_SEP_Executor, %async_SEP_Executor* %self, i64 0, i32 3
+    br label %condition
+
+condition:
+    %is_done = call i1 @llvm.coro.done(i8* %handle)
+    br i1 %is_done, label %exit, label %take
+
+take:
+    %waiter = call %async_SEP_Waiter* @async_SEP_Executor_SEP__take_ready(%async_SEP_Executor* %self)
+    %is_ready = icmp ne %async_SEP_Waiter* %waiter, null
+    br i1 %is_ready, label %resume, label %check_driver
+
+resume:
+    %waiter_handle_pointer = getelementptr %async_SEP_Waiter, %async_SEP_Waiter* %waiter, i64 0, i32 0
+    %waiter_handle = load i8*, i8** %waiter_handle_pointer
+    call void @llvm.coro.resume(i8* %waiter_handle)
+    br label %condition
+
+check_driver:
+    %driver = load i64 (%async_SEP_Executor*, i8*, i1)*, i64 (%async_SEP_Executor*, i8*, i1)** %driver_pointer
+    %has_driver = icmp ne i64 (%async_SEP_Executor*, i8*, i1)* %driver, null
+    br i1 %has_driver, label %drive, label %exit
+
+drive:
+    %context = load i8*, i8** %context_pointer
+    %woken = call i64 %driver(%async_SEP_Executor* %self, i8* %context, i1 true)
+    %has_woken = icmp ne i64 %woken, 0
+    br i1 %has_woken, label %take, label %exit
+
+exit:
+    %completed = phi i1 [ true, %condition ], [ false, %check_driver ], [ false, %drive ]
+    call void @async_SEP_Executor_SEP___exit__(%async_SEP_Executor* %self, %async_SEP_Executor* %previous)
+
+    ret i1 %completed
+}
@@ -0,0 +1,1006 @@
+; Scheduler runtime, linked into every program. Runs green threads, tasks
+; with their own small stacks, on one worker thread per core. Each worker
+; has a Chase-Lev deque of tasks it pushes to and pops from, and takes from
+; the other end of the others' deques when it runs out, so spawning and
+; running tasks only touches other workers' cache lines when stealing.
+; Workers with nothing to run or steal park until a task is spawned.
+;
+; Switching between tasks saves and restores registers by hand, so this is
+; x86-64 only, with the System V ABI.
+
+; A green thread. It only gets a stack when it first runs, so spawning many
+; tasks at once, that mostly wait in deques, does not map a stack for each.
+; Stacks have a guard page at the bottom.
+%scheduler_SEP_Task = type {
+    i8*,                        ; 0: _stack_pointer - where its registers were saved when it last switched out
+    i8*,                        ; 1: _stack - the start of its stack's mapping, or null until it first runs
+    void (i8*)*,                ; 2: _function - what it runs
+    i8*,                        ; 3: _argument - what its function is passed
+    %scheduler_SEP_Worker*,     ; 4: _worker - the worker running it
+    i64,                        ; 5: _state - RUNNING (0), PARKING (1), PARKED (2) or NOTIFIED (3)
+    %scheduler_SEP_Task*        ; 6: _next - the next task in the injection queue
+}
+
+; Tasks to run, as a Chase-Lev deque. Its owner pushes and pops at the
+; bottom, and other workers steal from the top, which has a cache line to
+; itself.
+%scheduler_SEP_Deque = type {
+    i64,                            ; 0: _top - the index of the next task to steal
+    [7 x i64],                      ; 1: padding
+    i64,                            ; 2: _bottom - the index after the last task pushed
+    %scheduler_SEP_DequeArray*,     ; 3: _array - ring buffer of tasks, indexed modulo its capacity
+    [6 x i64]                       ; 4: padding
+}
+
+%scheduler_SEP_DequeArray = type {
+    i64,                            ; 0: mask - its capacity minus 1, which is a power of 2
+    %scheduler_SEP_DequeArray*,     ; 1: previous - the array it replaced, kept as thieves may still read it
+    [0 x %scheduler_SEP_Task*]      ; 2: tasks
+}
+
+; An OS thread running tasks, 192 bytes so workers never share cache lines.
+%scheduler_SEP_Worker = type {
+    %scheduler_SEP_Deque,       ; 0: _deque
+    i8*,                        ; 1: _stack_pointer - where its registers were saved while a task runs
+    %scheduler_SEP_Task*,       ; 2: _current - the task it is running, or null
+    i64,                        ; 3: _reason - why its task switched back, YIELD (0), PARK (1) or FINISH (2)
+    i64,                        ; 4: _random - xorshift state, for picking workers to steal from
+    i8*,                        ; 5: _cache - finished tasks' stacks, to reuse
+    i64,                        ; 6: _cached - the number of stacks in its cache
+    [2 x i64]                   ; 7: padding
+}
+
+@scheduler_started = internal global i64 0 ; Whether the workers have started
+@scheduler_workers = internal global %scheduler_SEP_Worker* null
+@scheduler_workers_length = internal global i64 0
+@scheduler_key = internal global i32 0 ; Thread-specific key for each thread's worker, or null
+@scheduler_live = internal global i64 0 ; Tasks spawned but not finished
+@scheduler_idle = internal global i64 0 ; Parked workers
+@scheduler_injected = internal global %scheduler_SEP_Task* null ; Tasks from outside workers, first in first out
+@scheduler_injected_last = internal global %scheduler_SEP_Task* null
+@scheduler_injected_length = internal global i64 0
+@scheduler_spare = internal global i8* null ; Finished tasks' stacks shared by all workers, to reuse
+@scheduler_spare_length = internal global i64 0
+@scheduler_lock = internal global [5 x i64] zeroinitializer ; pthread_mutex_t, zeroed is initialised
+@scheduler_work = internal global [6 x i64] zeroinitializer ; pthread_cond_t, signalled when a task is spawned
+@scheduler_done = internal global [6 x i64] zeroinitializer ; pthread_cond_t, signalled when no tasks are live
+
+@.scheduler_workers_variable = private unnamed_addr constant [15 x i8] c"EXEME_WORKERS\00\00"
+@.scheduler_map_failed = private unnamed_addr constant [40 x i8] c"scheduler: failed to map a task's stack\0A"
+
+declare i8* @malloc(i64)
+declare void @free(i8*)
+declare i8* @aligned_alloc(i64, i64)
+declare void @llvm.memset.p0i8.i64(i8*, i8, i64, i1)
+declare void @llvm.memcpy.p0i8.p0i8.i64(i8*, i8*, i64, i1)
+declare i8* @mmap(i8*, i64, i32, i32, i32, i64)
+declare i32 @mprotect(i8*, i64, i32)
+declare i32 @munmap(i8*, i64)
+declare i64 @write(i32, i8*, i64)
+declare void @abort() noreturn nounwind
+declare i64 @sysconf(i32)
+declare i8* @getenv(i8*)
+declare i64 @strtol(i8*, i8**, i32)
+declare i32 @pthread_create(i64*, i8*, i8* (i8*)*, i8*)
+declare i32 @pthread_detach(i64)
+declare i32 @pthread_key_create(i32*, void (i8*)*)
+declare i8* @pthread_getspecific(i32)
+declare i32 @pthread_setspecific(i32, i8*)
+declare i32 @pthread_mutex_lock(i8*)
+declare i32 @pthread_mutex_unlock(i8*)
+declare i32 @pthread_cond_wait(i8*, i8*)
+declare i32 @pthread_cond_signal(i8*)
+declare i32 @pthread_cond_broadcast(i8*)
+declare void @io_SEP_flush_thread() ; From 'std-llvm-ir/std.ll'
+
+; Saves the callee-saved registers on the current stack, stores the stack
+; pointer in 'save', and restores the registers saved on the stack at
+; 'target', returning to wherever that stack switched out from.
+define private void @scheduler_SEP__switch(i8** %save, i8* %target) naked noinline nounwind {
+    call void asm sideeffect "pushq %rbp\0Apushq %rbx\0Apushq %r12\0Apushq %r13\0Apushq %r14\0Apushq %r15", "~{memory}"()
+    call void asm sideeffect "movq %rsp, (%rdi)\0Amovq %rsi, %rsp", "~{memory}"()
+    call void asm sideeffect "popq %r15\0Apopq %r14\0Apopq %r13\0Apopq %r12\0Apopq %rbx\0Apopq %rbp\0Aretq", "~{memory}"()
+    unreachable
+}
+
+; Where a new task's stack first returns to, from '_switch'. Its stack is
+; set up so %r12 holds the task and %r13 holds '_run_task'.
+define private void @scheduler_SEP__task_entry() naked noinline nounwind {
+    call void asm sideeffect "movq %r12, %rdi\0Ajmpq *%r13", "~{memory}"()
+    unreachable
+}
+
+; Runs a task's function, then switches back to its worker for good.
+define private void @scheduler_SEP__run_task(%scheduler_SEP_Task* %task) noreturn nounwind {
+    %function_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %task, i64 0, i32 2
+    %function = load void (i8*)*, void (i8*)** %function_pointer
+    %argument_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %task, i64 0, i32 3
+    %argument = load i8*, i8** %argument_pointer
+    call void %function(i8* %argument)
+
+    %worker_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %task, i64 0, i32 4
+    %worker = load %scheduler_SEP_Worker*, %scheduler_SEP_Worker** %worker_pointer ; It may have moved
+    %reason_pointer = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 3
+    store i64 2, i64* %reason_pointer ; FINISH
+    %worker_stack_pointer_pointer = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 1
+    %worker_stack_pointer = load i8*, i8** %worker_stack_pointer_pointer
+    %stack_pointer_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %task, i64 0, i32 0
+    call void @scheduler_SEP__switch(i8** %stack_pointer_pointer, i8* %worker_stack_pointer)
+    unreachable
+}
+
+; Gets the calling thread's worker, or null outside of workers.
+define private %scheduler_SEP_Worker* @scheduler_SEP__worker() nounwind alwaysinline {
+    %key = load i32, i32* @scheduler_key
+    %specific = call i8* @pthread_getspecific(i32 %key)
+    %worker = bitcast i8* %specific to %scheduler_SEP_Worker*
+
+    ret %scheduler_SEP_Worker* %worker
+}
+
+; Gets the task that is running, or null outside of tasks.
+define %scheduler_SEP_Task* @scheduler_SEP_current() nounwind {
+entry:
+    %started = load atomic i64, i64* @scheduler_started acquire, align 8
+    %is_started = icmp ne i64 %started, 0
+    br i1 %is_started, label %check_worker, label %exit
+
+check_worker:
+    %worker = call %scheduler_SEP_Worker* @scheduler_SEP__worker()
+    %is_worker = icmp ne %scheduler_SEP_Worker* %worker, null
+    br i1 %is_worker, label %worker_current, label %exit
+
+worker_current:
+    %current_pointer = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 2
+    %worker_task = load %scheduler_SEP_Task*, %scheduler_SEP_Task** %current_pointer
+    br label %exit
+
+exit:
+    %task = phi %scheduler_SEP_Task* [ null, %entry ], [ null, %check_worker ], [ %worker_task, %worker_current ]
+
+    ret %scheduler_SEP_Task* %task
+}
+
+; Gets the number of workers, starting them if needed.
+define i64 @scheduler_SEP_workers() nounwind {
+    call void @scheduler_SEP__start()
+    %length = load i64, i64* @scheduler_workers_length
+
+    ret i64 %length
+}
+
+; Gets whether the calling worker has tasks queued that other workers could
+; steal, so work can be split lazily: only while it would not be, when
+; other workers would have nothing to steal. False outside of workers.
+define i1 @scheduler_SEP_has_queued() nounwind {
+entry:
+    %started = load atomic i64, i64* @scheduler_started acquire, align 8
+    %is_started = icmp ne i64 %started, 0
+    br i1 %is_started, label %check_worker, label %exit
+
+check_worker:
+    %worker = call %scheduler_SEP_Worker* @scheduler_SEP__worker()
+    %is_worker = icmp ne %scheduler_SEP_Worker* %worker, null
+    br i1 %is_worker, label %check_deque, label %exit
+
+check_deque:
+    %deque = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 0
+    %deque_has_tasks = call i1 @scheduler_SEP_Deque_SEP__has_tasks(%scheduler_SEP_Deque* %deque)
+    br label %exit
+
+exit:
+    %has_queued = phi i1 [ false, %entry ], [ false, %check_worker ], [ %deque_has_tasks, %check_deque ]
+
+    ret i1 %has_queued
+}
+
+; Pushes a task to the bottom of a worker's deque. Only its worker pushes.
+define private void @scheduler_SEP_Deque_SEP_push(%scheduler_SEP_Deque* %self, %scheduler_SEP_Task* %task) nounwind {
+entry:
+    %top_pointer = getelementptr %scheduler_SEP_Deque, %scheduler_SEP_Deque* %self, i64 0, i32 0
+    %bottom_pointer = getelementptr %scheduler_SEP_Deque, %scheduler_SEP_Deque* %self, i64 0, i32 2
+    %array_pointer = getelementptr %scheduler_SEP_Deque, %scheduler_SEP_Deque* %self, i64 0, i32 3
+    %bottom = load atomic i64, i64* %bottom_pointer monotonic, align 8
+    %top = load atomic i64, i64* %top_pointer acquire, align 8
+    %array = load atomic %scheduler_SEP_DequeArray*, %scheduler_SEP_DequeArray** %array_pointer monotonic, align 8
+    %mask_pointer = getelementptr %scheduler_SEP_DequeArray, %scheduler_SEP_DequeArray* %array, i64 0, i32 0
+    %mask = load i64, i64* %mask_pointer
+    %size = sub i64 %bottom, %top
+    %is_full = icmp sge i64 %size, %mask
+    br i1 %is_full, label %grow, label %store
+
+grow: ; Into an array twice the size, leaving the old one for thieves
+    %new_mask_partial = shl i64 %mask, 1
+    %new_mask = or i64 %new_mask_partial, 1
+    %new_capacity = add i64 %new_mask, 1
+    %new_tasks_size = shl i64 %new_capacity, 3
+    %new_size = add i64 %new_tasks_size, 16
+    %new_bytes = call i8* @malloc(i64 %new_size)
+    %new_array = bitcast i8* %new_bytes to %scheduler_SEP_DequeArray*
+    %new_mask_pointer = getelementptr %scheduler_SEP_DequeArray, %scheduler_SEP_DequeArray* %new_array, i64 0, i32 0
+    store i64 %new_mask, i64* %new_mask_pointer
+    %previous_pointer = getelementptr %scheduler_SEP_DequeArray, %scheduler_SEP_DequeArray* %new_array, i64 0, i32 1
+    store %scheduler_SEP_DequeArray* %array, %scheduler_SEP_DequeArray** %previous_pointer
+    br label %copy
+
+copy:
+    %index = phi i64 [ %top, %grow ], [ %next_index, %copy_task ]
+    %is_copying = icmp slt i64 %index, %bottom
+    br i1 %is_copying, label %copy_task, label %publish
+
+copy_task:
+    %old_slot = and i64 %index, %mask
+    %old_pointer = getelementptr %scheduler_SEP_DequeArray, %scheduler_SEP_DequeArray* %array, i64 0, i32 2, i64 %old_slot
+    %copied = load atomic %scheduler_SEP_Task*, %scheduler_SEP_Task** %old_pointer monotonic, align 8
+    %new_slot = and i64 %index, %new_mask
+    %new_tasks = getelementptr %scheduler_SEP_DequeArray, %scheduler_SEP_DequeArray* %new_array, i64 0, i32 2
+    %new_pointer = getelementptr [0 x %scheduler_SEP_Task*], [0 x %scheduler_SEP_Task*]* %new_tasks, i64 0, i64 %new_slot
+    store atomic %scheduler_SEP_Task* %copied, %scheduler_SEP_Task** %new_pointer monotonic, align 8
+    %next_index = add i64 %index, 1
+    br label %copy
+
+publish:
+    store atomic %scheduler_SEP_DequeArray* %new_array, %scheduler_SEP_DequeArray** %array_pointer release, align 8
+    br label %store
+
+store:
+    %target_array = phi %scheduler_SEP_DequeArray* [ %array, %entry ], [ %new_array, %publish ]
+    %target_mask = phi i64 [ %mask, %entry ], [ %new_mask, %publish ]
+    %slot = and i64 %bottom, %target_mask
+    %target_tasks = getelementptr %scheduler_SEP_DequeArray, %scheduler_SEP_DequeArray* %target_array, i64 0, i32 2
+    %task_pointer = getelementptr [0 x %scheduler_SEP_Task*], [0 x %scheduler_SEP_Task*]* %target_tasks, i64 0, i64 %slot
+    store atomic %scheduler_SEP_Task* %task, %scheduler_SEP_Task** %task_pointer monotonic, align 8
+    fence release
+    %new_bottom = add i64 %bottom, 1
+    store atomic i64 %new_bottom, i64* %bottom_pointer monotonic, align 8
+
+    ret void
+}
+
+; Pops the task pushed last from the bottom of a worker's deque, or null
+; when it is empty. Only its worker pops.
+define private %scheduler_SEP_Task* @scheduler_SEP_Deque_SEP_pop(%scheduler_SEP_Deque* %self) nounwind {
+entry:
+    %top_pointer = getelementptr %scheduler_SEP_Deque, %scheduler_SEP_Deque* %self, i64 0, i32 0
+    %bottom_pointer = getelementptr %scheduler_SEP_Deque, %scheduler_SEP_Deque* %self, i64 0, i32 2
+    %array_pointer = getelementptr %scheduler_SEP_Deque, %scheduler_SEP_Deque* %self, i64 0, i32 3
+    %old_bottom = load atomic i64, i64* %bottom_pointer monotonic, align 8
+    %bottom = sub i64 %old_bottom, 1
+    %array = load atomic %scheduler_SEP_DequeArray*, %scheduler_SEP_DequeArray** %array_pointer monotonic, align 8
+    store atomic i64 %bottom, i64* %bottom_pointer monotonic, align 8
+    fence seq_cst ; Thieves see the claim before it reads the top
+    %top = load atomic i64, i64* %top_pointer monotonic, align 8
+    %has_task = icmp sle i64 %top, %bottom
+    br i1 %has_task, label %take, label %empty
+
+take:
+    %mask_pointer = getelementptr %scheduler_SEP_DequeArray, %scheduler_SEP_DequeArray* %array, i64 0, i32 0
+    %mask = load i64, i64* %mask_pointer
+    %slot = and i64 %bottom, %mask
+    %task_pointer = getelementptr %scheduler_SEP_DequeArray, %scheduler_SEP_DequeArray* %array, i64 0, i32 2, i64 %slot
+    %task = load atomic %scheduler_SEP_Task*, %scheduler_SEP_Task** %task_pointer monotonic, align 8
+    %is_last = icmp eq i64 %top, %bottom
+    br i1 %is_last, label %race, label %exit
+
+race: ; The last task, which a thief may take first
+    %new_top = add i64 %top, 1
+    %result = cmpxchg i64* %top_pointer, i64 %top, i64 %new_top seq_cst monotonic
+    %won = extractvalue { i64, i1 } %result, 1
+    store atomic i64 %old_bottom, i64* %bottom_pointer monotonic, align 8
+    %race_task = select i1 %won, %scheduler_SEP_Task* %task, %scheduler_SEP_Task* null
+    br label %exit
+
+empty:
+    store atomic i64 %old_bottom, i64* %bottom_pointer monotonic, align 8
+    br label %exit
+
+exit:
+    %popped = phi %scheduler_SEP_Task* [ %task, %take ], [ %race_task, %race ], [ null, %empty ]
+
+    ret %scheduler_SEP_Task* %popped
+}
+
+; Steals the task pushed first from the top of another worker's deque, or
+; null when it is empty or another thief won.
+define private %scheduler_SEP_Task* @scheduler_SEP_Deque_SEP_steal(%scheduler_SEP_Deque* %self) nounwind {
+entry:
+    %top_pointer = getelementptr %scheduler_SEP_Deque, %scheduler_SEP_Deque* %self, i64 0, i32 0
+    %bottom_pointer = getelementptr %scheduler_SEP_Deque, %scheduler_SEP_Deque* %self, i64 0, i32 2
+    %array_pointer = getelementptr %scheduler_SEP_Deque, %scheduler_SEP_Deque* %self, i64 0, i32 3
+    %top = load atomic i64, i64* %top_pointer acquire, align 8
+    fence seq_cst
+    %bottom = load atomic i64, i64* %bottom_pointer acquire, align 8
+    %has_task = icmp slt i64 %top, %bottom
+    br i1 %has_task, label %take, label %exit
+
+take:
+    %array = load atomic %scheduler_SEP_DequeArray*, %scheduler_SEP_DequeArray** %array_pointer acquire, align 8
+    %mask_pointer = getelementptr %scheduler_SEP_DequeArray, %scheduler_SEP_DequeArray* %array, i64 0, i32 0
+    %mask = load i64, i64* %mask_pointer
+    %slot = and i64 %top, %mask
+    %task_pointer = getelementptr %scheduler_SEP_DequeArray, %scheduler_SEP_DequeArray* %array, i64 0, i32 2, i64 %slot
+    %task = load atomic %scheduler_SEP_Task*, %scheduler_SEP_Task** %task_pointer monotonic, align 8
+    %new_top = add i64 %top, 1
+    %result = cmpxchg i64* %top_pointer, i64 %top, i64 %new_top seq_cst monotonic
+    %won = extractvalue { i64, i1 } %result, 1
+    %stolen = select i1 %won, %scheduler_SEP_Task* %task, %scheduler_SEP_Task* null
+    br label %exit
+
+exit:
+    %result_task = phi %scheduler_SEP_Task* [ null, %entry ], [ %stolen, %take ]
+
+    ret %scheduler_SEP_Task* %result_task
+}
+
+; Gets whether a deque looks like it has tasks.
+define private i1 @scheduler_SEP_Deque_SEP__has_tasks(%scheduler_SEP_Deque* %self) nounwind alwaysinline {
+    %top_pointer = getelementptr %scheduler_SEP_Deque, %scheduler_SEP_Deque* %self, i64 0, i32 0
+    %top = load atomic i64, i64* %top_pointer acquire, align 8
+    %bottom_pointer = getelementptr %scheduler_SEP_Deque, %scheduler_SEP_Deque* %self, i64 0, i32 2
+    %bottom = load atomic i64, i64* %bottom_pointer acquire, align 8
+    %has_tasks = icmp slt i64 %top, %bottom
+
+    ret i1 %has_tasks
+}
+
+; Starts a worker thread per core, or as many as 'EXEME_WORKERS' says, the
+; first time it is called.
+define private void @scheduler_SEP__start() nounwind {
+entry:
+    %started = load atomic i64, i64* @scheduler_started acquire, align 8
+    %is_started = icmp ne i64 %started, 0
+    br i1 %is_started, label %exit, label %lock
+
+lock:
+    %lock_bytes = bitcast [5 x i64]* @scheduler_lock to i8*
+    call i32 @pthread_mutex_lock(i8* %lock_bytes)
+    %locked_started = load atomic i64, i64* @scheduler_started monotonic, align 8
+    %was_started = icmp ne i64 %locked_started, 0 ; By another thread, while this one waited
+    br i1 %was_started, label %unlock, label %count
+
+count:
+    call i32 @pthread_key_create(i32* @scheduler_key, void (i8*)* null)
+    %variable = getelementptr [15 x i8], [15 x i8]* @.scheduler_workers_variable, i64 0, i64 0
+    %requested = call i8* @getenv(i8* %variable)
+    %has_requested = icmp ne i8* %requested, null
+    br i1 %has_requested, label %parse, label %cores
+
+parse:
+    %parsed = call i64 @strtol(i8* %requested, i8** null, i32 10)
+    br label %allocate
+
+cores:
+    %cores_count = call i64 @sysconf(i32 84) ; _SC_NPROCESSORS_ONLN
+    br label %allocate
+
+allocate:
+    %wanted = phi i64 [ %parsed, %parse ], [ %cores_count, %cores ]
+    %too_few = icmp slt i64 %wanted, 1
+    %length = select i1 %too_few, i64 1, i64 %wanted
+    %size = mul i64 %length, 192
+    %bytes = call i8* @aligned_alloc(i64 64, i64 %size)
+    call void @llvm.memset.p0i8.i64(i8* %bytes, i8 0, i64 %size, i1 false)
+    %workers = bitcast i8* %bytes to %scheduler_SEP_Worker*
+    store %scheduler_SEP_Worker* %workers, %scheduler_SEP_Worker** @scheduler_workers
+    store i64 %length, i64* @scheduler_workers_length
+    br label %initialise
+
+initialise: ; Every deque, before any worker can steal from it
+    %index = phi i64 [ 0, %allocate ], [ %next_index, %initialise_worker ]
+    %is_initialising = icmp ult i64 %index, %length
+    br i1 %is_initialising, label %initialise_worker, label %spawn
+
+initialise_worker:
+    %worker = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %workers, i64 %index
+    %array_bytes = call i8* @malloc(i64 2064) ; 256 tasks
+    %array = bitcast i8* %array_bytes to %scheduler_SEP_DequeArray*
+    %mask_pointer = getelementptr %scheduler_SEP_DequeArray, %scheduler_SEP_DequeArray* %array, i64 0, i32 0
+    store i64 255, i64* %mask_pointer
+    %previous_pointer = getelementptr %scheduler_SEP_DequeArray, %scheduler_SEP_DequeArray* %array, i64 0, i32 1
+    store %scheduler_SEP_DequeArray* null, %scheduler_SEP_DequeArray** %previous_pointer
+    %array_pointer = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 0, i32 3
+    store %scheduler_SEP_DequeArray* %array, %scheduler_SEP_DequeArray** %array_pointer
+    %random_pointer = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 4
+    %next_index = add i64 %index, 1
+    %seed = mul i64 %next_index, -7046029254386353131 ; Nonzero, as xorshift would stay at 0
+    store i64 %seed, i64* %random_pointer
+    br label %initialise
+
+spawn:
+    %thread = alloca i64
+    store atomic i64 1, i64* @scheduler_started release, align 8
+    br label %spawn_condition
+
+spawn_condition:
+    %thread_index = phi i64 [ 0, %spawn ], [ %next_thread_index, %spawn_thread ]
+    %is_spawning = icmp ult i64 %thread_index, %length
+    br i1 %is_spawning, label %spawn_thread, label %unlock
+
+spawn_thread:
+    %thread_worker = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %workers, i64 %thread_index
+    %thread_argument = bitcast %scheduler_SEP_Worker* %thread_worker to i8*
+    call i32 @pthread_create(i64* %thread, i8* null, i8* (i8*)* @scheduler_SEP__worker_main, i8* %thread_argument)
+    %thread_id = load i64, i64* %thread
+    call i32 @pthread_detach(i64 %thread_id)
+    %next_thread_index = add i64 %thread_index, 1
+    br label %spawn_condition
+
+unlock:
+    call i32 @pthread_mutex_unlock(i8* %lock_bytes)
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Wakes a parked worker, if there is one, after a task was made runnable.
+define private void @scheduler_SEP__notify() nounwind {
+entry:
+    fence seq_cst ; Parking workers see the task, or this sees them
+    %idle = load atomic i64, i64* @scheduler_idle monotonic, align 8
+    %has_idle = icmp ne i64 %idle, 0
+    br i1 %has_idle, label %signal, label %exit
+
+signal:
+    %lock_bytes = bitcast [5 x i64]* @scheduler_lock to i8*
+    call i32 @pthread_mutex_lock(i8* %lock_bytes)
+    %work_bytes = bitcast [6 x i64]* @scheduler_work to i8*
+    call i32 @pthread_cond_signal(i8* %work_bytes)
+    call i32 @pthread_mutex_unlock(i8* %lock_bytes)
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Adds a task to the injection queue, for tasks made runnable outside of
+; workers, and for yielding.
+define private void @scheduler_SEP__inject(%scheduler_SEP_Task* %task) nounwind {
+entry:
+    %next_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %task, i64 0, i32 6
+    store %scheduler_SEP_Task* null, %scheduler_SEP_Task** %next_pointer
+    %lock_bytes = bitcast [5 x i64]* @scheduler_lock to i8*
+    call i32 @pthread_mutex_lock(i8* %lock_bytes)
+    %last = load %scheduler_SEP_Task*, %scheduler_SEP_Task** @scheduler_injected_last
+    %is_empty = icmp eq %scheduler_SEP_Task* %last, null
+    br i1 %is_empty, label %first, label %append
+
+first:
+    store %scheduler_SEP_Task* %task, %scheduler_SEP_Task** @scheduler_injected
+    br label %link
+
+append:
+    %last_next_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %last, i64 0, i32 6
+    store %scheduler_SEP_Task* %task, %scheduler_SEP_Task** %last_next_pointer
+    br label %link
+
+link:
+    store %scheduler_SEP_Task* %task, %scheduler_SEP_Task** @scheduler_injected_last
+    atomicrmw add i64* @scheduler_injected_length, i64 1 seq_cst
+    call i32 @pthread_mutex_unlock(i8* %lock_bytes)
+    call void @scheduler_SEP__notify()
+
+    ret void
+}
+
+; Takes the first task from the injection queue, or null when it is empty.
+define private %scheduler_SEP_Task* @scheduler_SEP__take_injected() nounwind {
+entry:
+    %length = load atomic i64, i64* @scheduler_injected_length monotonic, align 8
+    %is_empty = icmp eq i64 %length, 0 ; Checked before locking, as it usually is
+    br i1 %is_empty, label %exit, label %lock
+
+lock:
+    %lock_bytes = bitcast [5 x i64]* @scheduler_lock to i8*
+    call i32 @pthread_mutex_lock(i8* %lock_bytes)
+    %first = load %scheduler_SEP_Task*, %scheduler_SEP_Task** @scheduler_injected
+    %has_first = icmp ne %scheduler_SEP_Task* %first, null
+    br i1 %has_first, label %take, label %unlock
+
+take:
+    %next_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %first, i64 0, i32 6
+    %next = load %scheduler_SEP_Task*, %scheduler_SEP_Task** %next_pointer
+    store %scheduler_SEP_Task* %next, %scheduler_SEP_Task** @scheduler_injected
+    %was_last = icmp eq %scheduler_SEP_Task* %next, null
+    br i1 %was_last, label %clear_last, label %taken
+
+clear_last:
+    store %scheduler_SEP_Task* null, %scheduler_SEP_Task** @scheduler_injected_last
+    br label %taken
+
+taken:
+    atomicrmw sub i64* @scheduler_injected_length, i64 1 seq_cst
+    br label %unlock
+
+unlock:
+    %taken_task = phi %scheduler_SEP_Task* [ null, %lock ], [ %first, %taken ]
+    call i32 @pthread_mutex_unlock(i8* %lock_bytes)
+    br label %exit
+
+exit:
+    %task = phi %scheduler_SEP_Task* [ null, %entry ], [ %taken_task, %unlock ]
+
+    ret %scheduler_SEP_Task* %task
+}
+
+; Makes a task runnable, on the calling worker if there is one.
+define private void @scheduler_SEP__schedule(%scheduler_SEP_Task* %task) nounwind {
+entry:
+    %worker = call %scheduler_SEP_Worker* @scheduler_SEP__worker()
+    %is_worker = icmp ne %scheduler_SEP_Worker* %worker, null
+    br i1 %is_worker, label %push, label %inject
+
+push:
+    %deque = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 0
+    call void @scheduler_SEP_Deque_SEP_push(%scheduler_SEP_Deque* %deque, %scheduler_SEP_Task* %task)
+    call void @scheduler_SEP__notify()
+    br label %exit
+
+inject:
+    call void @scheduler_SEP__inject(%scheduler_SEP_Task* %task)
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Finds a task for a worker to run: its own newest, then the injection
+; queue's oldest, then another worker's oldest. Returns null if there is
+; none.
+define private %scheduler_SEP_Task* @scheduler_SEP__find_task(%scheduler_SEP_Worker* %worker) nounwind {
+entry:
+    %deque = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 0
+    %own = call %scheduler_SEP_Task* @scheduler_SEP_Deque_SEP_pop(%scheduler_SEP_Deque* %deque)
+    %has_own = icmp ne %scheduler_SEP_Task* %own, null
+    br i1 %has_own, label %exit, label %injected
+
+injected:
+    %injected_task = call %scheduler_SEP_Task* @scheduler_SEP__take_injected()
+    %has_injected = icmp ne %scheduler_SEP_Task* %injected_task, null
+    br i1 %has_injected, label %exit, label %steal_setup
+
+steal_setup: ; Tries twice as many victims as there are workers, at random
+    %workers = load %scheduler_SEP_Worker*, %scheduler_SEP_Worker** @scheduler_workers
+    %length = load i64, i64* @scheduler_workers_length
+    %attempts = shl i64 %length, 1
+    %random_pointer = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 4
+    br label %steal_condition
+
+steal_condition:
+    %attempt = phi i64 [ 0, %steal_setup ], [ %next_attempt, %steal ], [ %next_attempt, %skip ]
+    %is_attempting = icmp ult i64 %attempt, %attempts
+    %next_attempt = add i64 %attempt, 1
+    br i1 %is_attempting, label %pick, label %exit
+
+pick:
+    %random = load i64, i64* %random_pointer
+    %shifted_left = shl i64 %random, 13
+    %mixed_left = xor i64 %random, %shifted_left
+    %shifted_right = lshr i64 %mixed_left, 7
+    %mixed_right = xor i64 %mixed_left, %shifted_right
+    %shifted_again = shl i64 %mixed_right, 17
+    %next_random = xor i64 %mixed_right, %shifted_again
+    store i64 %next_random, i64* %random_pointer
+    %victim_index = urem i64 %next_random, %length
+    %victim = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %workers, i64 %victim_index
+    %is_self = icmp eq %scheduler_SEP_Worker* %victim, %worker
+    br i1 %is_self, label %skip, label %steal
+
+skip:
+    br label %steal_condition
+
+steal:
+    %victim_deque = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %victim, i64 0, i32 0
+    %stolen = call %scheduler_SEP_Task* @scheduler_SEP_Deque_SEP_steal(%scheduler_SEP_Deque* %victim_deque)
+    %has_stolen = icmp ne %scheduler_SEP_Task* %stolen, null
+    br i1 %has_stolen, label %exit, label %steal_condition
+
+exit:
+    %task = phi %scheduler_SEP_Task* [ %own, %entry ], [ %injected_task, %injected ], [ null, %steal_condition ],
+                                     [ %stolen, %steal ]
+
+    ret %scheduler_SEP_Task* %task
+}
+
+; Gets whether any task looks runnable, for a worker about to park.
+define private i1 @scheduler_SEP__has_work() nounwind {
+entry:
+    %injected_length = load atomic i64, i64* @scheduler_injected_length seq_cst, align 8
+    %has_injected = icmp ne i64 %injected_length, 0
+    %workers = load %scheduler_SEP_Worker*, %scheduler_SEP_Worker** @scheduler_workers
+    %length = load i64, i64* @scheduler_workers_length
+    br i1 %has_injected, label %exit, label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %check ]
+    %is_checking = icmp ult i64 %index, %length
+    br i1 %is_checking, label %check, label %exit
+
+check:
+    %deque = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %workers, i64 %index, i32 0
+    %has_tasks = call i1 @scheduler_SEP_Deque_SEP__has_tasks(%scheduler_SEP_Deque* %deque)
+    %next_index = add i64 %index, 1
+    br i1 %has_tasks, label %exit, label %condition
+
+exit:
+    %has_work = phi i1 [ true, %entry ], [ false, %condition ], [ true, %check ]
+
+    ret i1 %has_work
+}
+
+; Parks a worker until a task is made runnable, unless one already is.
+define private void @scheduler_SEP__park_worker() nounwind {
+entry:
+    %lock_bytes = bitcast [5 x i64]* @scheduler_lock to i8*
+    call i32 @pthread_mutex_lock(i8* %lock_bytes)
+    atomicrmw add i64* @scheduler_idle, i64 1 seq_cst ; Before checking, so notifiers see it or it sees their task
+    %has_work = call i1 @scheduler_SEP__has_work()
+    br i1 %has_work, label %exit, label %wait
+
+wait:
+    %work_bytes = bitcast [6 x i64]* @scheduler_work to i8*
+    call i32 @pthread_cond_wait(i8* %work_bytes, i8* %lock_bytes)
+    br label %exit
+
+exit:
+    atomicrmw sub i64* @scheduler_idle, i64 1 seq_cst
+    call i32 @pthread_mutex_unlock(i8* %lock_bytes)
+
+    ret void
+}
+
+; Gets the link to the next stack in a cache, in the 64 bytes at the top of
+; a stack's mapping that tasks' frames start below.
+define private i8** @scheduler_SEP__stack_link(i8* %stack) nounwind alwaysinline {
+    %link_bytes = getelementptr i8, i8* %stack, i64 262080
+    %link = bitcast i8* %link_bytes to i8**
+
+    ret i8** %link
+}
+
+; Gets a stack, reusing a finished task's from the worker's cache, or the
+; shared one, if it can. Stacks reserve 256 KiB, but the OS only backs the
+; pages they touch, so they start at 4 KiB and grow as they are used.
+define private i8* @scheduler_SEP__allocate_stack(%scheduler_SEP_Worker* %worker) nounwind {
+entry:
+    %cache_pointer = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 5
+    %cached_stack = load i8*, i8** %cache_pointer
+    %has_cached = icmp ne i8* %cached_stack, null
+    br i1 %has_cached, label %reuse, label %check_spare
+
+reuse:
+    %cached_link = call i8** @scheduler_SEP__stack_link(i8* %cached_stack)
+    %cached_next = load i8*, i8** %cached_link
+    store i8* %cached_next, i8** %cache_pointer
+    %cached_pointer = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 6
+    %cached = load i64, i64* %cached_pointer
+    %new_cached = sub i64 %cached, 1
+    store i64 %new_cached, i64* %cached_pointer
+    br label %exit
+
+check_spare:
+    %spare_length = load atomic i64, i64* @scheduler_spare_length monotonic, align 8
+    %has_spare_length = icmp ne i64 %spare_length, 0 ; Checked before locking, as it is often empty
+    br i1 %has_spare_length, label %lock, label %map
+
+lock:
+    %lock_bytes = bitcast [5 x i64]* @scheduler_lock to i8*
+    call i32 @pthread_mutex_lock(i8* %lock_bytes)
+    %spare_stack = load i8*, i8** @scheduler_spare
+    %has_spare = icmp ne i8* %spare_stack, null
+    br i1 %has_spare, label %reuse_spare, label %unlock
+
+reuse_spare:
+    %spare_link = call i8** @scheduler_SEP__stack_link(i8* %spare_stack)
+    %spare_next = load i8*, i8** %spare_link
+    store i8* %spare_next, i8** @scheduler_spare
+    atomicrmw sub i64* @scheduler_spare_length, i64 1 monotonic
+    br label %unlock
+
+unlock:
+    %unlocked_stack = phi i8* [ null, %lock ], [ %spare_stack, %reuse_spare ]
+    call i32 @pthread_mutex_unlock(i8* %lock_bytes)
+    br i1 %has_spare, label %exit, label %map
+
+map:
+    ; PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE
+    %mapped_stack = call i8* @mmap(i8* null, i64 262144, i32 3, i32 16418, i32 -1, i64 0)
+    %is_mapped = icmp ne i8* %mapped_stack, inttoptr (i64 -1 to i8*) ; MAP_FAILED
+    br i1 %is_mapped, label %guard, label %map_failed
+
+guard:
+    call i32 @mprotect(i8* %mapped_stack, i64 4096, i32 0) ; The guard page, PROT_NONE
+    br label %exit
+
+map_failed: ; Out of memory or mappings, so a task can't start and its spawner can't be told
+    %message = getelementptr [40 x i8], [40 x i8]* @.scheduler_map_failed, i64 0, i64 0
+    call i64 @write(i32 2, i8* %message, i64 40)
+    call void @abort()
+    unreachable
+
+exit:
+    %stack = phi i8* [ %cached_stack, %reuse ], [ %unlocked_stack, %unlock ], [ %mapped_stack, %guard ]
+
+    ret i8* %stack
+}
+
+; Keeps a finished task's stack in its worker's cache, of up to 64, else
+; the shared one, of up to 1024, else unmaps it.
+define private void @scheduler_SEP__release_stack(%scheduler_SEP_Worker* %worker, i8* %stack) nounwind {
+entry:
+    %link = call i8** @scheduler_SEP__stack_link(i8* %stack)
+    %cached_pointer = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 6
+    %cached = load i64, i64* %cached_pointer
+    %is_full = icmp uge i64 %cached, 64
+    br i1 %is_full, label %check_spare, label %cache
+
+cache:
+    %cache_pointer = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 5
+    %first = load i8*, i8** %cache_pointer
+    store i8* %first, i8** %link
+    store i8* %stack, i8** %cache_pointer
+    %new_cached = add i64 %cached, 1
+    store i64 %new_cached, i64* %cached_pointer
+    br label %exit
+
+check_spare:
+    %spare_length = load atomic i64, i64* @scheduler_spare_length monotonic, align 8
+    %is_spare_full = icmp uge i64 %spare_length, 1024
+    br i1 %is_spare_full, label %unmap, label %spare
+
+spare:
+    %lock_bytes = bitcast [5 x i64]* @scheduler_lock to i8*
+    call i32 @pthread_mutex_lock(i8* %lock_bytes)
+    %first_spare = load i8*, i8** @scheduler_spare
+    store i8* %first_spare, i8** %link
+    store i8* %stack, i8** @scheduler_spare
+    atomicrmw add i64* @scheduler_spare_length, i64 1 monotonic
+    call i32 @pthread_mutex_unlock(i8* %lock_bytes)
+    br label %exit
+
+unmap:
+    call i32 @munmap(i8* %stack, i64 262144)
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Gives a task that is about to run for the first time a stack, with
+; registers for '_switch' to pop, then '_task_entry' to return to.
+define private void @scheduler_SEP__prepare(%scheduler_SEP_Worker* %worker, %scheduler_SEP_Task* %task) nounwind {
+    %stack = call i8* @scheduler_SEP__allocate_stack(%scheduler_SEP_Worker* %worker)
+    %stack_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %task, i64 0, i32 1
+    store i8* %stack, i8** %stack_pointer
+
+    ; 80 bytes below the link, so '_run_task' starts with the stack aligned
+    ; like after a call
+    %frame_bytes = getelementptr i8, i8* %stack, i64 262000
+    %frame = bitcast i8* %frame_bytes to [7 x i8*]*
+    %run_task = bitcast void (%scheduler_SEP_Task*)* @scheduler_SEP__run_task to i8*
+    %entry = bitcast void ()* @scheduler_SEP__task_entry to i8*
+    %header = bitcast %scheduler_SEP_Task* %task to i8*
+    store [7 x i8*] zeroinitializer, [7 x i8*]* %frame
+    %r13_pointer = getelementptr [7 x i8*], [7 x i8*]* %frame, i64 0, i64 2
+    store i8* %run_task, i8** %r13_pointer
+    %r12_pointer = getelementptr [7 x i8*], [7 x i8*]* %frame, i64 0, i64 3
+    store i8* %header, i8** %r12_pointer
+    %return_pointer = getelementptr [7 x i8*], [7 x i8*]* %frame, i64 0, i64 6
+    store i8* %entry, i8** %return_pointer
+    %task_stack_pointer_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %task, i64 0, i32 0
+    store i8* %frame_bytes, i8** %task_stack_pointer_pointer
+
+    ret void
+}
+
+; Runs a task on a worker until it switches back, then deals with why.
+define private void @scheduler_SEP__run(%scheduler_SEP_Worker* %worker, %scheduler_SEP_Task* %task) nounwind {
+entry:
+    %stack_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %task, i64 0, i32 1
+    %stack = load i8*, i8** %stack_pointer
+    %is_new = icmp eq i8* %stack, null
+    br i1 %is_new, label %prepare, label %switch
+
+prepare:
+    call void @scheduler_SEP__prepare(%scheduler_SEP_Worker* %worker, %scheduler_SEP_Task* %task)
+    br label %switch
+
+switch:
+    %task_worker_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %task, i64 0, i32 4
+    store %scheduler_SEP_Worker* %worker, %scheduler_SEP_Worker** %task_worker_pointer
+    %current_pointer = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 2
+    store %scheduler_SEP_Task* %task, %scheduler_SEP_Task** %current_pointer
+    %worker_stack_pointer = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 1
+    %task_stack_pointer_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %task, i64 0, i32 0
+    %task_stack_pointer = load i8*, i8** %task_stack_pointer_pointer
+    call void @scheduler_SEP__switch(i8** %worker_stack_pointer, i8* %task_stack_pointer)
+
+    store %scheduler_SEP_Task* null, %scheduler_SEP_Task** %current_pointer
+    %reason_pointer = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 3
+    %reason = load i64, i64* %reason_pointer
+    switch i64 %reason, label %yield [ i64 1, label %park
+                                       i64 2, label %finish ]
+
+yield: ; Behind every waiting task, rather than straight back
+    call void @scheduler_SEP__inject(%scheduler_SEP_Task* %task)
+    br label %exit
+
+park: ; Unless it was unparked while switching back
+    %state_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %task, i64 0, i32 5
+    %result = cmpxchg i64* %state_pointer, i64 1, i64 2 acq_rel acquire ; PARKING to PARKED
+    %parked = extractvalue { i64, i1 } %result, 1
+    br i1 %parked, label %exit, label %notified
+
+notified:
+    store atomic i64 0, i64* %state_pointer monotonic, align 8 ; RUNNING
+    %deque = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 0
+    call void @scheduler_SEP_Deque_SEP_push(%scheduler_SEP_Deque* %deque, %scheduler_SEP_Task* %task)
+    br label %exit
+
+finish: ; Flushing what it wrote, as workers never exit to flush it
+    call void @io_SEP_flush_thread()
+    %finished_stack = load i8*, i8** %stack_pointer
+    call void @scheduler_SEP__release_stack(%scheduler_SEP_Worker* %worker, i8* %finished_stack)
+    %task_bytes = bitcast %scheduler_SEP_Task* %task to i8*
+    call void @free(i8* %task_bytes)
+    %live = atomicrmw sub i64* @scheduler_live, i64 1 acq_rel
+    %was_last = icmp eq i64 %live, 1
+    br i1 %was_last, label %done, label %exit
+
+done:
+    %lock_bytes = bitcast [5 x i64]* @scheduler_lock to i8*
+    call i32 @pthread_mutex_lock(i8* %lock_bytes)
+    %done_bytes = bitcast [6 x i64]* @scheduler_done to i8*
+    call i32 @pthread_cond_broadcast(i8* %done_bytes)
+    call i32 @pthread_mutex_unlock(i8* %lock_bytes)
+    br label %exit
+
+exit:
+    ret void
+}
+
+; What each worker thread runs, forever.
+define private i8* @scheduler_SEP__worker_main(i8* %argument) nounwind {
+entry:
+    %worker = bitcast i8* %argument to %scheduler_SEP_Worker*
+    %key = load i32, i32* @scheduler_key
+    call i32 @pthread_setspecific(i32 %key, i8* %argument)
+    br label %find
+
+find: ; Tries a few times before parking, as tasks often arrive soon after
+    %tries = phi i64 [ 0, %entry ], [ 0, %run ], [ %next_tries, %retry ], [ 0, %park ]
+    %task = call %scheduler_SEP_Task* @scheduler_SEP__find_task(%scheduler_SEP_Worker* %worker)
+    %has_task = icmp ne %scheduler_SEP_Task* %task, null
+    br i1 %has_task, label %run, label %idle
+
+run:
+    call void @scheduler_SEP__run(%scheduler_SEP_Worker* %worker, %scheduler_SEP_Task* %task)
+    br label %find
+
+idle:
+    %next_tries = add i64 %tries, 1
+    %is_tired = icmp uge i64 %next_tries, 16
+    br i1 %is_tired, label %park, label %retry
+
+retry:
+    call void asm sideeffect "pause", ""()
+    br label %find
+
+park:
+    call void @io_SEP_flush_thread()
+    call void @scheduler_SEP__park_worker()
+    br label %find
+}
+
+; Spawns a task running 'function' with 'argument', on the calling worker,
+; or any worker when called from outside of them. Returns the task.
+define %scheduler_SEP_Task* @scheduler_SEP_spawn(void (i8*)* %function, i8* %argument) nounwind {
+    call void @scheduler_SEP__start()
+    atomicrmw add i64* @scheduler_live, i64 1 acq_rel
+    %task_bytes = call i8* @aligned_alloc(i64 64, i64 64) ; A cache line to itself
+    %task = bitcast i8* %task_bytes to %scheduler_SEP_Task*
+    store %scheduler_SEP_Task { i8* null, i8* null, void (i8*)* null, i8* null, %scheduler_SEP_Worker* null, i64 0,
+                                %scheduler_SEP_Task* null }, %scheduler_SEP_Task* %task ; RUNNING, without a stack
+    %function_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %task, i64 0, i32 2
+    store void (i8*)* %function, void (i8*)** %function_pointer
+    %argument_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %task, i64 0, i32 3
+    store i8* %argument, i8** %argument_pointer
+
+    call void @scheduler_SEP__schedule(%scheduler_SEP_Task* %task)
+
+    ret %scheduler_SEP_Task* %task
+}
+
+; Lets other tasks run before the calling task carries on. Does nothing
+; outside of tasks.
+define void @scheduler_SEP_yield() nounwind {
+entry:
+    %task = call %scheduler_SEP_Task* @scheduler_SEP_current()
+    %is_task = icmp ne %scheduler_SEP_Task* %task, null
+    br i1 %is_task, label %switch, label %exit
+
+switch:
+    call void @scheduler_SEP__switch_out(%scheduler_SEP_Task* %task, i64 0) ; YIELD
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Switches from a task back to its worker, saying why.
+define private void @scheduler_SEP__switch_out(%scheduler_SEP_Task* %task, i64 %reason) nounwind {
+    %worker_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %task, i64 0, i32 4
+    %worker = load %scheduler_SEP_Worker*, %scheduler_SEP_Worker** %worker_pointer
+    %reason_pointer = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 3
+    store i64 %reason, i64* %reason_pointer
+    %worker_stack_pointer_pointer = getelementptr %scheduler_SEP_Worker, %scheduler_SEP_Worker* %worker, i64 0, i32 1
+    %worker_stack_pointer = load i8*, i8** %worker_stack_pointer_pointer
+    %stack_pointer_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %task, i64 0, i32 0
+    call void @scheduler_SEP__switch(i8** %stack_pointer_pointer, i8* %worker_stack_pointer)
+
+    ret void
+}
+
+; Suspends the calling task until 'unpark' is called on it. An 'unpark'
+; before this is remembered, and makes this return straight away.
+define void @scheduler_SEP_park() nounwind {
+entry:
+    %task = call %scheduler_SEP_Task* @scheduler_SEP_current()
+    %state_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %task, i64 0, i32 5
+    %result = cmpxchg i64* %state_pointer, i64 0, i64 1 acq_rel acquire ; RUNNING to PARKING
+    %parking = extractvalue { i64, i1 } %result, 1
+    br i1 %parking, label %switch, label %notified
+
+switch:
+    call void @scheduler_SEP__switch_out(%scheduler_SEP_Task* %task, i64 1) ; PARK
+    br label %exit
+
+notified:
+    store atomic i64 0, i64* %state_pointer monotonic, align 8 ; RUNNING
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Makes a task parked with 'park' runnable again, or makes its next 'park'
+; return straight away if it is not parked yet.
+define void @scheduler_SEP_unpark(%scheduler_SEP_Task* %task) nounwind {
+entry:
+    %state_pointer = getelementptr %scheduler_SEP_Task, %scheduler_SEP_Task* %task, i64 0, i32 5
+    %state = atomicrmw xchg i64* %state_pointer, i64 3 acq_rel ; NOTIFIED
+    %was_parked = icmp eq i64 %state, 2 ; Else its worker or its next 'park' sees the notification
+    br i1 %was_parked, label %schedule, label %exit
+
+schedule:
+    store atomic i64 0, i64* %state_pointer monotonic, align 8 ; RUNNING
+    call void @scheduler_SEP__schedule(%scheduler_SEP_Task* %task)
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Blocks the calling thread until every spawned task has finished. Called
+; from outside of tasks, such as by 'main'.
+define void @scheduler_SEP_wait() nounwind {
+entry:
+    %lock_bytes = bitcast [5 x i64]* @scheduler_lock to i8*
+    %done_bytes = bitcast [6 x i64]* @scheduler_done to i8*
+    call i32 @pthread_mutex_lock(i8* %lock_bytes)
+    br label %condition
+
+condition:
+    %live = load atomic i64, i64* @scheduler_live acquire, align 8
+    %is_done = icmp eq i64 %live, 0
+    br i1 %is_done, label %exit, label %wait
+
+wait:
+    call i32 @pthread_cond_wait(i8* %done_bytes, i8* %lock_bytes)
+    br label %condition
+
+exit:
+    call i32 @pthread_mutex_unlock(i8* %lock_bytes)
+
+    ret void
+}
@@ -0,0 +1,106 @@
+; Profile runtime, linked into programs built with '--profile-generate'.
+; Writes the counters inserted by the compiler to a profile when the program
+; exits. See the profile-guided optimisation guide for the file format.
+
+%profile_function = type {
+    i8*,    ; 0: name - name of the function
+    i64,    ; 1: hash - hash of the function's IR when it was instrumented
+    i64,    ; 2: length - number of counters
+    i64*    ; 3: counters - block counters, followed by branch counters
+}
+
+@profile_functions = internal global %profile_function* null
+@profile_functions_length = internal global i64 0
+
+@.profile_default_path = private unnamed_addr constant [16 x i8] c"default.exlprof\00"
+@.profile_path_variable = private unnamed_addr constant [19 x i8] c"EXEME_PROFILE_FILE\00"
+@.profile_mode = private unnamed_addr constant [2 x i8] c"a\00"
+@.profile_header = private unnamed_addr constant [11 x i8] c"exlprof 1\0A\00"
+@.profile_function_format = private unnamed_addr constant [16 x i8] c"%s %016llx %llu\00"
+@.profile_counter_format = private unnamed_addr constant [6 x i8] c" %llu\00"
+
+declare i32 @atexit(void ()*)
+declare i8* @getenv(i8*)
+declare i8* @fopen(i8*, i8*)
+declare i32 @fclose(i8*)
+declare i32 @fputs(i8*, i8*)
+declare i32 @fputc(i32, i8*)
+declare i32 @fprintf(i8*, i8*, ...)
+
+; Registers the functions to write counters for when the program exits.
+; Called by the compiler at the start of 'main'.
+define void @__exeme_profile_register(%profile_function* %functions, i64 %length) nounwind {
+    store %profile_function* %functions, %profile_function** @profile_functions
+    store i64 %length, i64* @profile_functions_length
+
+    call i32 @atexit(void ()* @__exeme_profile_write)
+
+    ret void
+}
+
+; Appends this run's counters to the profile. Runs are merged when the
+; profile is read, so nothing has to be read back here.
+define void @__exeme_profile_write() nounwind {
+entry:
+    %variable = getelementptr [19 x i8], [19 x i8]* @.profile_path_variable, i64 0, i64 0
+    %environment_path = call i8* @getenv(i8* %variable)
+    %has_environment_path = icmp ne i8* %environment_path, null
+    %default_path = getelementptr [16 x i8], [16 x i8]* @.profile_default_path, i64 0, i64 0
+    %path = select i1 %has_environment_path, i8* %environment_path, i8* %default_path
+
+    %mode = getelementptr [2 x i8], [2 x i8]* @.profile_mode, i64 0, i64 0
+    %file = call i8* @fopen(i8* %path, i8* %mode)
+    %opened = icmp ne i8* %file, null
+    br i1 %opened, label %header, label %exit
+
+header:
+    %header_string = getelementptr [11 x i8], [11 x i8]* @.profile_header, i64 0, i64 0
+    call i32 @fputs(i8* %header_string, i8* %file)
+
+    %functions = load %profile_function*, %profile_function** @profile_functions
+    %functions_length = load i64, i64* @profile_functions_length
+    %function_format = getelementptr [16 x i8], [16 x i8]* @.profile_function_format, i64 0, i64 0
+    %counter_format = getelementptr [6 x i8], [6 x i8]* @.profile_counter_format, i64 0, i64 0
+    br label %function_condition
+
+function_condition:
+    %function_index = phi i64 [ 0, %header ], [ %next_function_index, %function_end ]
+    %more_functions = icmp ult i64 %function_index, %functions_length
+    br i1 %more_functions, label %function, label %close
+
+function:
+    %name_pointer = getelementptr %profile_function, %profile_function* %functions, i64 %function_index, i32 0
+    %name = load i8*, i8** %name_pointer
+    %hash_pointer = getelementptr %profile_function, %profile_function* %functions, i64 %function_index, i32 1
+    %hash = load i64, i64* %hash_pointer
+    %length_pointer = getelementptr %profile_function, %profile_function* %functions, i64 %function_index, i32 2
+    %length = load i64, i64* %length_pointer
+    %counters_pointer = getelementptr %profile_function, %profile_function* %functions, i64 %function_index, i32 3
+    %counters = load i64*, i64** %counters_pointer
+    call i32 (i8*, i8*, ...) @fprintf(i8* %file, i8* %function_format, i8* %name, i64 %hash, i64 %length)
+    br label %counter_condition
+
+counter_condition:
+    %counter_index = phi i64 [ 0, %function ], [ %next_counter_index, %counter ]
+    %more_counters = icmp ult i64 %counter_index, %length
+    br i1 %more_counters, label %counter, label %function_end
+
+counter:
+    %counter_pointer = getelementptr i64, i64* %counters, i64 %counter_index
+    %count = load i64, i64* %counter_pointer
+    call i32 (i8*, i8*, ...) @fprintf(i8* %file, i8* %counter_format, i64 %count)
+    %next_counter_index = add i64 %counter_index, 1
+    br label %counter_condition
+
+function_end:
+    call i32 @fputc(i32 10, i8* %file) ; '\n'
+    %next_function_index = add i64 %function_index, 1
+    br label %function_condition
+
+close:
+    call i32 @fclose(i8* %file)
+    br label %exit
+
+exit:
+    ret void
+}
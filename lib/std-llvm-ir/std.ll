@@ -1,16 +1,4877 @@
+; A 24 byte string. Strings of up to 22 bytes are stored inline, so they
+; never allocate, followed by their terminator, with byte 23 holding their
+; length, so a zeroed string is empty. Longer strings are on the heap, and
+; set the top bit of the capacity, which is byte 23's top bit on
+; little-endian targets, so it is never set for inline strings. The next
+; bit is set when the buffer belongs to an arena, moved there with
+; 'reserve_in', so it is not freed and grows in the same arena.
 %str = type {
-    i8*,    ; 0: _char_buf - pointer to the character buffer
+    i8*,    ; 0: _char_buf - pointer to the character buffer, when on the heap
+    i64,    ; 1: length - number of characters in the buffer, when on the heap
+    i64     ; 2: _capacity - characters the buffer can hold, not counting the terminator, when on the heap
+}
+
+declare i8* @malloc(i64)
+declare i8* @realloc(i8*, i64)
+declare void @free(i8*)
+declare i32 @memcmp(i8*, i8*, i64)
+declare void @llvm.memcpy.p0i8.p0i8.i64(i8*, i8*, i64, i1)
+declare void @llvm.memset.p0i8.i64(i8*, i8, i64, i1)
+declare void @llvm.memmove.p0i8.p0i8.i64(i8*, i8*, i64, i1)
+declare i64 @llvm.ctlz.i64(i64, i1)
+
+; Gets whether a string's characters are on the heap.
+define private i1 @str_SEP__is_heap(%str* %self) nounwind readonly alwaysinline {
+    %bytes = bitcast %str* %self to [24 x i8]*
+    %tag_pointer = getelementptr [24 x i8], [24 x i8]* %bytes, i64 0, i64 23
+    %tag = load i8, i8* %tag_pointer
+    %is_heap = icmp slt i8 %tag, 0 ; Top bit set
+
+    ret i1 %is_heap
+}
+
+define void @str_SEP___init__(%str* %self) nounwind {
+    ; An empty inline string
+    %bytes = bitcast %str* %self to i8*
+    call void @llvm.memset.p0i8.i64(i8* %bytes, i8 0, i64 24, i1 false)
+
+    ret void
+}
+
+; Frees a string's characters, leaving it empty.
+define void @str_SEP___del__(%str* %self) nounwind {
+entry:
+    %is_heap = call i1 @str_SEP__is_heap(%str* %self)
+    %capacity_pointer = getelementptr %str, %str* %self, i64 0, i32 2
+    %flagged_capacity = load i64, i64* %capacity_pointer
+    %arena_flag = and i64 %flagged_capacity, 4611686018427387904 ; 1 << 62
+    %is_malloced = icmp eq i64 %arena_flag, 0
+    %is_freed = and i1 %is_heap, %is_malloced ; Arenas free their memory together
+    br i1 %is_freed, label %heap, label %exit
+
+heap:
+    %buffer_pointer = getelementptr %str, %str* %self, i64 0, i32 0
+    %buffer = load i8*, i8** %buffer_pointer
+    call void @free(i8* %buffer)
+    br label %exit
+
+exit:
+    call void @str_SEP___init__(%str* %self)
+
+    ret void
+}
+
+; Gets the number of characters in a string.
+define i64 @str_SEP_length(%str* %self) nounwind readonly {
+entry:
+    %is_heap = call i1 @str_SEP__is_heap(%str* %self)
+    br i1 %is_heap, label %heap, label %inline
+
+heap:
+    %length_pointer = getelementptr %str, %str* %self, i64 0, i32 1
+    %heap_length = load i64, i64* %length_pointer
+    ret i64 %heap_length
+
+inline:
+    %bytes = bitcast %str* %self to i8*
+    %tag_pointer = getelementptr i8, i8* %bytes, i64 23
+    %tag = load i8, i8* %tag_pointer
+    %inline_length = zext i8 %tag to i64
+    ret i64 %inline_length
+}
+
+; Gets how many characters a string can hold without allocating.
+define i64 @str_SEP_capacity(%str* %self) nounwind readonly {
+entry:
+    %is_heap = call i1 @str_SEP__is_heap(%str* %self)
+    br i1 %is_heap, label %heap, label %inline
+
+heap:
+    %capacity_pointer = getelementptr %str, %str* %self, i64 0, i32 2
+    %flagged_capacity = load i64, i64* %capacity_pointer
+    %capacity = and i64 %flagged_capacity, 4611686018427387903 ; Without the heap and arena flags
+    ret i64 %capacity
+
+inline:
+    ret i64 22
+}
+
+; Gets a string's characters, which are followed by a terminator.
+define i8* @str_SEP_data(%str* %self) nounwind readonly {
+    %is_heap = call i1 @str_SEP__is_heap(%str* %self)
+    %buffer_pointer = getelementptr %str, %str* %self, i64 0, i32 0
+    %buffer = load i8*, i8** %buffer_pointer
+    %inline = bitcast %str* %self to i8*
+    %data = select i1 %is_heap, i8* %buffer, i8* %inline
+
+    ret i8* %data
+}
+
+; Sets a string's length, and terminates it.
+define private void @str_SEP__set_length(%str* %self, i64 %length) nounwind alwaysinline {
+entry:
+    %data = call i8* @str_SEP_data(%str* %self)
+    %terminator = getelementptr i8, i8* %data, i64 %length
+    store i8 0, i8* %terminator
+
+    %is_heap = call i1 @str_SEP__is_heap(%str* %self)
+    br i1 %is_heap, label %heap, label %inline
+
+heap:
+    %length_pointer = getelementptr %str, %str* %self, i64 0, i32 1
+    store i64 %length, i64* %length_pointer
+    ret void
+
+inline:
+    %tag = trunc i64 %length to i8
+    %tag_pointer = getelementptr i8, i8* %data, i64 23
+    store i8 %tag, i8* %tag_pointer
+    ret void
+}
+
+; Gets the arena a string's characters are in, or null.
+define private %mem_SEP_Arena* @str_SEP__get_arena(%str* %self) nounwind readonly alwaysinline {
+entry:
+    %is_heap = call i1 @str_SEP__is_heap(%str* %self)
+    %capacity_pointer = getelementptr %str, %str* %self, i64 0, i32 2
+    %flagged_capacity = load i64, i64* %capacity_pointer
+    %arena_flag = and i64 %flagged_capacity, 4611686018427387904 ; 1 << 62
+    %has_arena_flag = icmp ne i64 %arena_flag, 0
+    %in_arena = and i1 %is_heap, %has_arena_flag
+    br i1 %in_arena, label %arena, label %exit
+
+arena:
+    %buffer_pointer = getelementptr %str, %str* %self, i64 0, i32 0
+    %buffer = load i8*, i8** %buffer_pointer
+    %buffer_arena = call %mem_SEP_Arena* @mem_SEP__get_arena(i8* %buffer)
+    br label %exit
+
+exit:
+    %result = phi %mem_SEP_Arena* [ null, %entry ], [ %buffer_arena, %arena ]
+    ret %mem_SEP_Arena* %result
+}
+
+; Moves a string's characters to a buffer in 'arena', or on the heap if it is
+; null, with room for at least 'capacity' characters. When the capacity
+; grows it at least doubles, so appending one character at a time is
+; amortised O(1).
+define private void @str_SEP__move(%str* %self, i64 %capacity, %mem_SEP_Arena* %arena) nounwind {
+    %current_capacity = call i64 @str_SEP_capacity(%str* %self)
+    %grows = icmp ugt i64 %capacity, %current_capacity
+    %doubled = shl i64 %current_capacity, 1
+    %use_doubled = icmp ugt i64 %doubled, %capacity
+    %grown = select i1 %use_doubled, i64 %doubled, i64 %capacity
+    %new_capacity = select i1 %grows, i64 %grown, i64 %current_capacity
+    %size = add i64 %new_capacity, 1 ; With the terminator
+    %length = call i64 @str_SEP_length(%str* %self)
+    %terminated_length = add i64 %length, 1
+    %is_heap = call i1 @str_SEP__is_heap(%str* %self)
+    %capacity_pointer = getelementptr %str, %str* %self, i64 0, i32 2
+    %old_flagged_capacity = load i64, i64* %capacity_pointer
+    %old_arena_flag = and i64 %old_flagged_capacity, 4611686018427387904 ; 1 << 62
+    %was_malloced = icmp eq i64 %old_arena_flag, 0
+    %is_malloced = and i1 %is_heap, %was_malloced
+    %data = call i8* @str_SEP_data(%str* %self)
+    %moved = call { i8*, i1 } @mem_SEP__grow(i8* %data, i64 %terminated_length, i64 %size, i1 %is_malloced,
+                                             %mem_SEP_Arena* %arena)
+    %buffer = extractvalue { i8*, i1 } %moved, 0
+    %in_arena = extractvalue { i8*, i1 } %moved, 1
+
+    %buffer_pointer = getelementptr %str, %str* %self, i64 0, i32 0
+    store i8* %buffer, i8** %buffer_pointer
+    %length_pointer = getelementptr %str, %str* %self, i64 0, i32 1
+    store i64 %length, i64* %length_pointer
+    %arena_flag = select i1 %in_arena, i64 4611686018427387904, i64 0
+    %heap_capacity = or i64 %new_capacity, -9223372036854775808 ; 1 << 63, the heap flag
+    %flagged_capacity = or i64 %heap_capacity, %arena_flag
+    store i64 %flagged_capacity, i64* %capacity_pointer
+
+    ret void
+}
+
+; Makes room for at least 'capacity' characters, moving an inline string to
+; the heap if it no longer fits. Strings moved into an arena grow in it.
+define void @str_SEP_reserve(%str* %self, i64 %capacity) nounwind {
+entry:
+    %current_capacity = call i64 @str_SEP_capacity(%str* %self)
+    %fits = icmp ule i64 %capacity, %current_capacity
+    br i1 %fits, label %exit, label %grow
+
+grow:
+    %arena = call %mem_SEP_Arena* @str_SEP__get_arena(%str* %self)
+    call void @str_SEP__move(%str* %self, i64 %capacity, %mem_SEP_Arena* %arena)
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Makes room for at least 'capacity' characters in 'arena', moving the
+; string's characters there if they are not yet, so it takes the arena as
+; its allocator. It then grows in the arena, and must not outlive it.
+define void @str_SEP_reserve_in(%str* %self, i64 %capacity, %mem_SEP_Arena* %arena) nounwind {
+entry:
+    %current_capacity = call i64 @str_SEP_capacity(%str* %self)
+    %fits = icmp ule i64 %capacity, %current_capacity
+    %current_arena = call %mem_SEP_Arena* @str_SEP__get_arena(%str* %self)
+    %in_arena = icmp eq %mem_SEP_Arena* %current_arena, %arena
+    %is_reserved = and i1 %fits, %in_arena
+    br i1 %is_reserved, label %exit, label %move
+
+move:
+    call void @str_SEP__move(%str* %self, i64 %capacity, %mem_SEP_Arena* %arena)
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Appends characters to a string. They cannot be the string's own.
+define void @str_SEP_append(%str* %self, i8* %characters, i64 %count) nounwind {
+    %length = call i64 @str_SEP_length(%str* %self)
+    %new_length = add i64 %length, %count
+    call void @str_SEP_reserve(%str* %self, i64 %new_length)
+
+    %data = call i8* @str_SEP_data(%str* %self)
+    %end = getelementptr i8, i8* %data, i64 %length
+    call void @llvm.memcpy.p0i8.p0i8.i64(i8* %end, i8* %characters, i64 %count, i1 false)
+    call void @str_SEP__set_length(%str* %self, i64 %new_length)
+
+    ret void
+}
+
+; Replaces a string's characters. They cannot be the string's own.
+define void @str_SEP_assign(%str* %self, i8* %characters, i64 %count) nounwind {
+    call void @str_SEP__set_length(%str* %self, i64 0)
+    call void @str_SEP_append(%str* %self, i8* %characters, i64 %count)
+
+    ret void
+}
+
+; Gets whether two strings have the same characters.
+define i1 @str_SEP___eq__(%str* %self, %str* %other) nounwind readonly {
+entry:
+    %length = call i64 @str_SEP_length(%str* %self)
+    %other_length = call i64 @str_SEP_length(%str* %other)
+    %same_length = icmp eq i64 %length, %other_length
+    br i1 %same_length, label %compare, label %exit
+
+compare:
+    %data = call i8* @str_SEP_data(%str* %self)
+    %other_data = call i8* @str_SEP_data(%str* %other)
+    %difference = call i32 @memcmp(i8* %data, i8* %other_data, i64 %length)
+    %same_characters = icmp eq i32 %difference, 0
+    br label %exit
+
+exit:
+    %equal = phi i1 [ false, %entry ], [ %same_characters, %compare ]
+    ret i1 %equal
+}
+
+; std.strings.Builder, which builds a string by appending to spare capacity,
+; so building one is amortised O(1) per character.
+%strings_SEP_Builder = type {
+    i8*,    ; 0: _buffer - pointer to the character buffer, with room for a terminator after the capacity
     i64,    ; 1: length - number of characters in the buffer
+    i64     ; 2: capacity - characters the buffer can hold, not counting the terminator, with the top bit set
+            ;    when the buffer belongs to an arena, moved there with 'reserve_in'
+}
+
+define void @strings_SEP_Builder_SEP___init__(%strings_SEP_Builder* %self) nounwind {
+    %bytes = bitcast %strings_SEP_Builder* %self to i8*
+    call void @llvm.memset.p0i8.i64(i8* %bytes, i8 0, i64 24, i1 false)
+
+    ret void
+}
+
+; Frees a builder's characters, leaving it empty.
+define void @strings_SEP_Builder_SEP___del__(%strings_SEP_Builder* %self) nounwind {
+entry:
+    %capacity_pointer = getelementptr %strings_SEP_Builder, %strings_SEP_Builder* %self, i64 0, i32 2
+    %flagged_capacity = load i64, i64* %capacity_pointer
+    %in_arena = icmp slt i64 %flagged_capacity, 0
+    br i1 %in_arena, label %exit, label %free
+
+free:
+    %buffer_pointer = getelementptr %strings_SEP_Builder, %strings_SEP_Builder* %self, i64 0, i32 0
+    %buffer = load i8*, i8** %buffer_pointer
+    call void @free(i8* %buffer)
+    br label %exit
+
+exit:
+    call void @strings_SEP_Builder_SEP___init__(%strings_SEP_Builder* %self)
+
+    ret void
+}
+
+; Gets the number of characters in a builder.
+define i64 @strings_SEP_Builder_SEP_length(%strings_SEP_Builder* %self) nounwind readonly {
+    %length_pointer = getelementptr %strings_SEP_Builder, %strings_SEP_Builder* %self, i64 0, i32 1
+    %length = load i64, i64* %length_pointer
+
+    ret i64 %length
+}
+
+; Gets the arena a builder's characters are in, or null.
+define private %mem_SEP_Arena* @strings_SEP_Builder_SEP__get_arena(%strings_SEP_Builder* %self) nounwind readonly {
+entry:
+    %capacity_pointer = getelementptr %strings_SEP_Builder, %strings_SEP_Builder* %self, i64 0, i32 2
+    %flagged_capacity = load i64, i64* %capacity_pointer
+    %in_arena = icmp slt i64 %flagged_capacity, 0
+    br i1 %in_arena, label %arena, label %exit
+
+arena:
+    %buffer_pointer = getelementptr %strings_SEP_Builder, %strings_SEP_Builder* %self, i64 0, i32 0
+    %buffer = load i8*, i8** %buffer_pointer
+    %buffer_arena = call %mem_SEP_Arena* @mem_SEP__get_arena(i8* %buffer)
+    br label %exit
+
+exit:
+    %result = phi %mem_SEP_Arena* [ null, %entry ], [ %buffer_arena, %arena ]
+    ret %mem_SEP_Arena* %result
+}
+
+; Moves a builder's characters to a buffer in 'arena', or on the heap if it
+; is null, with room for at least 'count' more characters. When the
+; capacity grows it at least doubles, and starts at 32.
+define private void @strings_SEP_Builder_SEP__move(%strings_SEP_Builder* %self, i64 %count,
+                                                   %mem_SEP_Arena* %arena) nounwind {
+    %length_pointer = getelementptr %strings_SEP_Builder, %strings_SEP_Builder* %self, i64 0, i32 1
+    %length = load i64, i64* %length_pointer
+    %capacity_pointer = getelementptr %strings_SEP_Builder, %strings_SEP_Builder* %self, i64 0, i32 2
+    %flagged_capacity = load i64, i64* %capacity_pointer
+    %capacity = and i64 %flagged_capacity, 9223372036854775807 ; Without the arena flag
+    %needed = add i64 %length, %count
+    %grows = icmp ugt i64 %needed, %capacity
+    %doubled = shl i64 %capacity, 1
+    %use_doubled = icmp ugt i64 %doubled, %needed
+    %grown = select i1 %use_doubled, i64 %doubled, i64 %needed
+    %kept = select i1 %grows, i64 %grown, i64 %capacity
+    %too_small = icmp ult i64 %kept, 32
+    %new_capacity = select i1 %too_small, i64 32, i64 %kept
+    %size = add i64 %new_capacity, 1 ; With the terminator
+    %buffer_pointer = getelementptr %strings_SEP_Builder, %strings_SEP_Builder* %self, i64 0, i32 0
+    %buffer = load i8*, i8** %buffer_pointer
+    %was_in_arena = icmp slt i64 %flagged_capacity, 0
+    %is_malloced = xor i1 %was_in_arena, true ; Or null, which realloc allocates for
+    %moved = call { i8*, i1 } @mem_SEP__grow(i8* %buffer, i64 %length, i64 %size, i1 %is_malloced,
+                                             %mem_SEP_Arena* %arena)
+    %new_buffer = extractvalue { i8*, i1 } %moved, 0
+    %in_arena = extractvalue { i8*, i1 } %moved, 1
+    %arena_flag = select i1 %in_arena, i64 -9223372036854775808, i64 0
+    %new_flagged_capacity = or i64 %new_capacity, %arena_flag
+    store i8* %new_buffer, i8** %buffer_pointer
+    store i64 %new_flagged_capacity, i64* %capacity_pointer
+
+    ret void
+}
+
+; Makes room for at least 'count' more characters. Builders moved into an
+; arena grow in it.
+define void @strings_SEP_Builder_SEP_reserve(%strings_SEP_Builder* %self, i64 %count) nounwind {
+entry:
+    %length_pointer = getelementptr %strings_SEP_Builder, %strings_SEP_Builder* %self, i64 0, i32 1
+    %length = load i64, i64* %length_pointer
+    %capacity_pointer = getelementptr %strings_SEP_Builder, %strings_SEP_Builder* %self, i64 0, i32 2
+    %flagged_capacity = load i64, i64* %capacity_pointer
+    %capacity = and i64 %flagged_capacity, 9223372036854775807 ; Without the arena flag
+    %needed = add i64 %length, %count
+    %fits = icmp ule i64 %needed, %capacity
+    br i1 %fits, label %exit, label %grow
+
+grow:
+    %arena = call %mem_SEP_Arena* @strings_SEP_Builder_SEP__get_arena(%strings_SEP_Builder* %self)
+    call void @strings_SEP_Builder_SEP__move(%strings_SEP_Builder* %self, i64 %count, %mem_SEP_Arena* %arena)
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Makes room for at least 'count' more characters in 'arena', moving the
+; builder's characters there if they are not yet, so it takes the arena as
+; its allocator. It then grows in the arena, and must not outlive it.
+define void @strings_SEP_Builder_SEP_reserve_in(%strings_SEP_Builder* %self, i64 %count,
+                                                %mem_SEP_Arena* %arena) nounwind {
+entry:
+    %length_pointer = getelementptr %strings_SEP_Builder, %strings_SEP_Builder* %self, i64 0, i32 1
+    %length = load i64, i64* %length_pointer
+    %capacity_pointer = getelementptr %strings_SEP_Builder, %strings_SEP_Builder* %self, i64 0, i32 2
+    %flagged_capacity = load i64, i64* %capacity_pointer
+    %capacity = and i64 %flagged_capacity, 9223372036854775807 ; Without the arena flag
+    %needed = add i64 %length, %count
+    %fits = icmp ule i64 %needed, %capacity
+    %current_arena = call %mem_SEP_Arena* @strings_SEP_Builder_SEP__get_arena(%strings_SEP_Builder* %self)
+    %in_arena = icmp eq %mem_SEP_Arena* %current_arena, %arena
+    %is_reserved = and i1 %fits, %in_arena
+    br i1 %is_reserved, label %exit, label %move
+
+move:
+    call void @strings_SEP_Builder_SEP__move(%strings_SEP_Builder* %self, i64 %count, %mem_SEP_Arena* %arena)
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Gets where the next character of a builder goes.
+define private i8* @strings_SEP_Builder_SEP__end(%strings_SEP_Builder* %self) nounwind readonly alwaysinline {
+    %buffer_pointer = getelementptr %strings_SEP_Builder, %strings_SEP_Builder* %self, i64 0, i32 0
+    %buffer = load i8*, i8** %buffer_pointer
+    %length_pointer = getelementptr %strings_SEP_Builder, %strings_SEP_Builder* %self, i64 0, i32 1
+    %length = load i64, i64* %length_pointer
+    %end = getelementptr i8, i8* %buffer, i64 %length
+
+    ret i8* %end
+}
+
+; Adds to the length of a builder, once characters are written after it.
+define private void @strings_SEP_Builder_SEP__extend(%strings_SEP_Builder* %self, i64 %count) nounwind alwaysinline {
+    %length_pointer = getelementptr %strings_SEP_Builder, %strings_SEP_Builder* %self, i64 0, i32 1
+    %length = load i64, i64* %length_pointer
+    %new_length = add i64 %length, %count
+    store i64 %new_length, i64* %length_pointer
+
+    ret void
+}
+
+; Appends characters to a builder.
+define void @strings_SEP_Builder_SEP_append(%strings_SEP_Builder* %self, i8* %characters, i64 %count) nounwind {
+    call void @strings_SEP_Builder_SEP_reserve(%strings_SEP_Builder* %self, i64 %count)
+    %end = call i8* @strings_SEP_Builder_SEP__end(%strings_SEP_Builder* %self)
+    call void @llvm.memcpy.p0i8.p0i8.i64(i8* %end, i8* %characters, i64 %count, i1 false)
+    call void @strings_SEP_Builder_SEP__extend(%strings_SEP_Builder* %self, i64 %count)
+
+    ret void
+}
+
+; Appends a string to a builder.
+define void @strings_SEP_Builder_SEP_append_str(%strings_SEP_Builder* %self, %str* %string) nounwind {
+    %data = call i8* @str_SEP_data(%str* %string)
+    %length = call i64 @str_SEP_length(%str* %string)
+    call void @strings_SEP_Builder_SEP_append(%strings_SEP_Builder* %self, i8* %data, i64 %length)
+
+    ret void
+}
+
+; Appends an integer to a builder, in decimal, writing its digits straight
+; into the buffer.
+define void @strings_SEP_Builder_SEP_append_int(%strings_SEP_Builder* %self, i64 %value) nounwind {
+    call void @strings_SEP_Builder_SEP_reserve(%strings_SEP_Builder* %self, i64 20) ; "-9223372036854775808"
+    %end = call i8* @strings_SEP_Builder_SEP__end(%strings_SEP_Builder* %self)
+    %written = call i64 @io_SEP__format_int(i8* %end, i64 %value)
+    call void @strings_SEP_Builder_SEP__extend(%strings_SEP_Builder* %self, i64 %written)
+
+    ret void
+}
+
+; Appends a float to a builder, with the fewest digits which read back as
+; the same float, writing them straight into the buffer.
+define void @strings_SEP_Builder_SEP_append_float(%strings_SEP_Builder* %self, double %value) nounwind {
+    call void @strings_SEP_Builder_SEP_reserve(%strings_SEP_Builder* %self, i64 24) ; "-2.2250738585072014e-308"
+    %end = call i8* @strings_SEP_Builder_SEP__end(%strings_SEP_Builder* %self)
+    %written = call i64 @io_SEP__format_float(i8* %end, double %value)
+    call void @strings_SEP_Builder_SEP__extend(%strings_SEP_Builder* %self, i64 %written)
+
+    ret void
+}
+
+; Moves a builder's characters into a string, leaving the builder empty.
+; Long strings take the builder's buffer as is, and short ones are stored
+; inline, so neither copies to a new buffer.
+define void @strings_SEP_Builder_SEP_finish(%strings_SEP_Builder* %self, %str* %string) nounwind {
+entry:
+    %buffer_pointer = getelementptr %strings_SEP_Builder, %strings_SEP_Builder* %self, i64 0, i32 0
+    %buffer = load i8*, i8** %buffer_pointer
+    %length = call i64 @strings_SEP_Builder_SEP_length(%strings_SEP_Builder* %self)
+    %capacity_pointer = getelementptr %strings_SEP_Builder, %strings_SEP_Builder* %self, i64 0, i32 2
+    %builder_capacity = load i64, i64* %capacity_pointer
+    %in_arena = icmp slt i64 %builder_capacity, 0
+    %capacity = and i64 %builder_capacity, 9223372036854775807 ; Without the arena flag
+    call void @str_SEP___init__(%str* %string)
+    %fits_inline = icmp ule i64 %length, 22
+    br i1 %fits_inline, label %inline, label %heap
+
+inline:
+    call void @str_SEP_append(%str* %string, i8* %buffer, i64 %length) ; Never allocates
+    br i1 %in_arena, label %exit, label %free
+
+free:
+    call void @free(i8* %buffer)
+    br label %exit
+
+heap:
+    %end = getelementptr i8, i8* %buffer, i64 %length
+    store i8 0, i8* %end
+    %string_buffer_pointer = getelementptr %str, %str* %string, i64 0, i32 0
+    store i8* %buffer, i8** %string_buffer_pointer
+    %string_length_pointer = getelementptr %str, %str* %string, i64 0, i32 1
+    store i64 %length, i64* %string_length_pointer
+    %string_capacity_pointer = getelementptr %str, %str* %string, i64 0, i32 2
+    %heap_capacity = or i64 %capacity, -9223372036854775808 ; 1 << 63, the heap flag
+    %arena_flag = select i1 %in_arena, i64 4611686018427387904, i64 0 ; 1 << 62
+    %flagged_capacity = or i64 %heap_capacity, %arena_flag
+    store i64 %flagged_capacity, i64* %string_capacity_pointer
+    br label %exit
+
+exit:
+    call void @strings_SEP_Builder_SEP___init__(%strings_SEP_Builder* %self)
+
+    ret void
 }
 
-define void @str_SEP___init__(%str* %self, i8* %string) nounwind {
-    ; Initialize '_char_buf'
-    %1 = getelementptr %str* %self, i64 0, i64, 0 ; get pointer to '_char_buf'
-    store i8* null, i8** %1 ; store null pointer
+; std.mem.Arena, which allocates by bumping a pointer through chunks, and
+; frees everything it allocated together. Strings and builders take an arena
+; as their allocator with 'reserve_in', and an arena entered with 'using' is
+; freed at the end of the scope.
+%mem_SEP_Arena = type {
+    %mem_SEP_ArenaChunk*,   ; 0: _chunk - the chunk being allocated from, or null
+    i8*,                    ; 1: _next - where the next allocation starts
+    i8*                     ; 2: _end - the end of the chunk
+}
+
+%mem_SEP_ArenaChunk = type {
+    %mem_SEP_ArenaChunk*,   ; 0: previous - the chunk allocated before it, or null
+    i64                     ; 1: size - bytes after the header, which is 16 bytes so they stay aligned
+}
+
+; A point to release an arena back to, freeing everything allocated since.
+%mem_SEP_ArenaMark = type {
+    %mem_SEP_ArenaChunk*,   ; 0: chunk
+    i8*                     ; 1: next
+}
+
+@mem_current_arena = internal thread_local global %mem_SEP_Arena* null
+
+define void @mem_SEP_Arena_SEP___init__(%mem_SEP_Arena* %self) nounwind {
+    %bytes = bitcast %mem_SEP_Arena* %self to i8*
+    call void @llvm.memset.p0i8.i64(i8* %bytes, i8 0, i64 24, i1 false)
+
+    ret void
+}
+
+; Frees everything an arena allocated.
+define void @mem_SEP_Arena_SEP___del__(%mem_SEP_Arena* %self) nounwind {
+    call void @mem_SEP_Arena_SEP_release(%mem_SEP_Arena* %self, %mem_SEP_ArenaMark zeroinitializer)
+
+    ret void
+}
+
+; Adds a chunk with room for at least 'size' bytes. Chunks double in size,
+; from 4 KiB up to 1 MiB, so few are needed.
+define private void @mem_SEP_Arena_SEP__add_chunk(%mem_SEP_Arena* %self, i64 %size) nounwind noinline {
+entry:
+    %chunk_pointer = getelementptr %mem_SEP_Arena, %mem_SEP_Arena* %self, i64 0, i32 0
+    %previous = load %mem_SEP_ArenaChunk*, %mem_SEP_ArenaChunk** %chunk_pointer
+    %has_previous = icmp ne %mem_SEP_ArenaChunk* %previous, null
+    br i1 %has_previous, label %double, label %allocate
+
+double:
+    %previous_size_pointer = getelementptr %mem_SEP_ArenaChunk, %mem_SEP_ArenaChunk* %previous, i64 0, i32 1
+    %previous_size = load i64, i64* %previous_size_pointer
+    %doubled = shl i64 %previous_size, 1
+    %too_large = icmp ugt i64 %doubled, 1048576
+    %capped = select i1 %too_large, i64 1048576, i64 %doubled
+    br label %allocate
+
+allocate:
+    %preferred = phi i64 [ 4096, %entry ], [ %capped, %double ]
+    %use_preferred = icmp ugt i64 %preferred, %size
+    %chunk_size = select i1 %use_preferred, i64 %preferred, i64 %size
+    %allocation_size = add i64 %chunk_size, 16
+    %allocation = call i8* @malloc(i64 %allocation_size)
+    %chunk = bitcast i8* %allocation to %mem_SEP_ArenaChunk*
+
+    %previous_field = getelementptr %mem_SEP_ArenaChunk, %mem_SEP_ArenaChunk* %chunk, i64 0, i32 0
+    store %mem_SEP_ArenaChunk* %previous, %mem_SEP_ArenaChunk** %previous_field
+    %size_field = getelementptr %mem_SEP_ArenaChunk, %mem_SEP_ArenaChunk* %chunk, i64 0, i32 1
+    store i64 %chunk_size, i64* %size_field
+
+    store %mem_SEP_ArenaChunk* %chunk, %mem_SEP_ArenaChunk** %chunk_pointer
+    %next = getelementptr i8, i8* %allocation, i64 16
+    %next_pointer = getelementptr %mem_SEP_Arena, %mem_SEP_Arena* %self, i64 0, i32 1
+    store i8* %next, i8** %next_pointer
+    %end = getelementptr i8, i8* %next, i64 %chunk_size
+    %end_pointer = getelementptr %mem_SEP_Arena, %mem_SEP_Arena* %self, i64 0, i32 2
+    store i8* %end, i8** %end_pointer
+
+    ret void
+}
+
+; Allocates 'size' bytes from an arena, aligned to 'alignment', a power of
+; 2 of at most 16.
+define i8* @mem_SEP_Arena_SEP_allocate(%mem_SEP_Arena* %self, i64 %size, i64 %alignment) nounwind {
+entry:
+    %next_pointer = getelementptr %mem_SEP_Arena, %mem_SEP_Arena* %self, i64 0, i32 1
+    %end_pointer = getelementptr %mem_SEP_Arena, %mem_SEP_Arena* %self, i64 0, i32 2
+    br label %bump
+
+bump:
+    %next = load i8*, i8** %next_pointer
+    %end = load i8*, i8** %end_pointer
+    %next_address = ptrtoint i8* %next to i64
+    %end_address = ptrtoint i8* %end to i64
+    %mask = sub i64 %alignment, 1
+    %rounded_up = add i64 %next_address, %mask
+    %inverse_mask = xor i64 %mask, -1
+    %aligned_address = and i64 %rounded_up, %inverse_mask
+    %space = sub i64 %end_address, %aligned_address
+    %fits = icmp ule i64 %size, %space
+    %has_chunk = icmp ne i8* %next, null
+    %allocated = and i1 %has_chunk, %fits
+    br i1 %allocated, label %exit, label %grow
+
+grow:
+    call void @mem_SEP_Arena_SEP__add_chunk(%mem_SEP_Arena* %self, i64 %size) ; Chunks start aligned to 16
+    br label %bump
+
+exit:
+    %offset = sub i64 %aligned_address, %next_address
+    %aligned = getelementptr i8, i8* %next, i64 %offset
+    %new_next = getelementptr i8, i8* %aligned, i64 %size
+    store i8* %new_next, i8** %next_pointer
+
+    ret i8* %aligned
+}
+
+; Marks where an arena has allocated up to, to release it back to later.
+define %mem_SEP_ArenaMark @mem_SEP_Arena_SEP_mark(%mem_SEP_Arena* %self) nounwind readonly {
+    %chunk_pointer = getelementptr %mem_SEP_Arena, %mem_SEP_Arena* %self, i64 0, i32 0
+    %chunk = load %mem_SEP_ArenaChunk*, %mem_SEP_ArenaChunk** %chunk_pointer
+    %next_pointer = getelementptr %mem_SEP_Arena, %mem_SEP_Arena* %self, i64 0, i32 1
+    %next = load i8*, i8** %next_pointer
+    %with_chunk = insertvalue %mem_SEP_ArenaMark undef, %mem_SEP_ArenaChunk* %chunk, 0
+    %mark = insertvalue %mem_SEP_ArenaMark %with_chunk, i8* %next, 1
+
+    ret %mem_SEP_ArenaMark %mark
+}
+
+; Frees everything an arena allocated after a mark, so marks nest like
+; scopes.
+define void @mem_SEP_Arena_SEP_release(%mem_SEP_Arena* %self, %mem_SEP_ArenaMark %mark) nounwind {
+entry:
+    %mark_chunk = extractvalue %mem_SEP_ArenaMark %mark, 0
+    %mark_next = extractvalue %mem_SEP_ArenaMark %mark, 1
+    %chunk_pointer = getelementptr %mem_SEP_Arena, %mem_SEP_Arena* %self, i64 0, i32 0
+    %first_chunk = load %mem_SEP_ArenaChunk*, %mem_SEP_ArenaChunk** %chunk_pointer
+    br label %condition
+
+condition:
+    %chunk = phi %mem_SEP_ArenaChunk* [ %first_chunk, %entry ], [ %previous, %free ]
+    %after_mark = icmp ne %mem_SEP_ArenaChunk* %chunk, %mark_chunk
+    br i1 %after_mark, label %free, label %restore
+
+free:
+    %previous_pointer = getelementptr %mem_SEP_ArenaChunk, %mem_SEP_ArenaChunk* %chunk, i64 0, i32 0
+    %previous = load %mem_SEP_ArenaChunk*, %mem_SEP_ArenaChunk** %previous_pointer
+    %allocation = bitcast %mem_SEP_ArenaChunk* %chunk to i8*
+    call void @free(i8* %allocation)
+    br label %condition
+
+restore:
+    store %mem_SEP_ArenaChunk* %mark_chunk, %mem_SEP_ArenaChunk** %chunk_pointer
+    %next_pointer = getelementptr %mem_SEP_Arena, %mem_SEP_Arena* %self, i64 0, i32 1
+    store i8* %mark_next, i8** %next_pointer
+    %has_chunk = icmp ne %mem_SEP_ArenaChunk* %mark_chunk, null
+    br i1 %has_chunk, label %end, label %exit
+
+end:
+    %size_pointer = getelementptr %mem_SEP_ArenaChunk, %mem_SEP_ArenaChunk* %mark_chunk, i64 0, i32 1
+    %size = load i64, i64* %size_pointer
+    %start = bitcast %mem_SEP_ArenaChunk* %mark_chunk to i8*
+    %end_offset = add i64 %size, 16
+    %chunk_end = getelementptr i8, i8* %start, i64 %end_offset
+    br label %exit
+
+exit:
+    %end_value = phi i8* [ null, %restore ], [ %chunk_end, %end ]
+    %end_pointer = getelementptr %mem_SEP_Arena, %mem_SEP_Arena* %self, i64 0, i32 2
+    store i8* %end_value, i8** %end_pointer
+
+    ret void
+}
+
+; Frees everything an arena allocated, but keeps its first chunk to
+; allocate from again.
+define void @mem_SEP_Arena_SEP_reset(%mem_SEP_Arena* %self) nounwind {
+entry:
+    %chunk_pointer = getelementptr %mem_SEP_Arena, %mem_SEP_Arena* %self, i64 0, i32 0
+    %last_chunk = load %mem_SEP_ArenaChunk*, %mem_SEP_ArenaChunk** %chunk_pointer
+    %has_chunk = icmp ne %mem_SEP_ArenaChunk* %last_chunk, null
+    br i1 %has_chunk, label %find_first, label %exit
+
+find_first:
+    %chunk = phi %mem_SEP_ArenaChunk* [ %last_chunk, %entry ], [ %previous, %find_first ]
+    %previous_pointer = getelementptr %mem_SEP_ArenaChunk, %mem_SEP_ArenaChunk* %chunk, i64 0, i32 0
+    %previous = load %mem_SEP_ArenaChunk*, %mem_SEP_ArenaChunk** %previous_pointer
+    %is_first = icmp eq %mem_SEP_ArenaChunk* %previous, null
+    br i1 %is_first, label %release, label %find_first
+
+release:
+    %start = bitcast %mem_SEP_ArenaChunk* %chunk to i8*
+    %next = getelementptr i8, i8* %start, i64 16
+    %with_chunk = insertvalue %mem_SEP_ArenaMark undef, %mem_SEP_ArenaChunk* %chunk, 0
+    %mark = insertvalue %mem_SEP_ArenaMark %with_chunk, i8* %next, 1
+    call void @mem_SEP_Arena_SEP_release(%mem_SEP_Arena* %self, %mem_SEP_ArenaMark %mark)
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Enters an arena, for 'using'. Returns the arena entered before, to exit
+; back to.
+define %mem_SEP_Arena* @mem_SEP_Arena_SEP___enter__(%mem_SEP_Arena* %self) nounwind {
+    %previous = load %mem_SEP_Arena*, %mem_SEP_Arena** @mem_current_arena
+    store %mem_SEP_Arena* %self, %mem_SEP_Arena** @mem_current_arena
+
+    ret %mem_SEP_Arena* %previous
+}
+
+; Exits an arena at the end of a 'using' scope, returning to the arena
+; entered before it, and frees everything it allocated.
+define void @mem_SEP_Arena_SEP___exit__(%mem_SEP_Arena* %self, %mem_SEP_Arena* %previous) nounwind {
+    store %mem_SEP_Arena* %previous, %mem_SEP_Arena** @mem_current_arena
+    call void @mem_SEP_Arena_SEP___del__(%mem_SEP_Arena* %self)
+
+    ret void
+}
+
+; Gets the arena entered on this thread with 'using', or null, for objects
+; made in the scope to take as their allocator with 'reserve_in'.
+define %mem_SEP_Arena* @mem_SEP_current_arena() nounwind readonly {
+    %arena = load %mem_SEP_Arena*, %mem_SEP_Arena** @mem_current_arena
+
+    ret %mem_SEP_Arena* %arena
+}
+
+; Gets the arena a buffer 'mem_SEP__grow' allocated in an arena belongs to,
+; which is kept in the 16 bytes before it.
+define private %mem_SEP_Arena* @mem_SEP__get_arena(i8* %buffer) nounwind readonly alwaysinline {
+    %header = getelementptr i8, i8* %buffer, i64 -16
+    %arena_pointer = bitcast i8* %header to %mem_SEP_Arena**
+    %arena = load %mem_SEP_Arena*, %mem_SEP_Arena** %arena_pointer
+
+    ret %mem_SEP_Arena* %arena
+}
+
+; Moves a buffer to one of 'size' bytes, in 'arena' if it is not null, else
+; on the heap. Returns the new buffer, and whether it is in an arena. 'used'
+; bytes are kept, and the old buffer is freed if it was malloced. Buffers in
+; an arena are given the arena before them, so they keep growing in the one
+; they were moved into, rather than whichever is entered.
+define private { i8*, i1 } @mem_SEP__grow(i8* %buffer, i64 %used, i64 %size, i1 %is_malloced,
+                                          %mem_SEP_Arena* %arena) nounwind {
+entry:
+    %has_arena = icmp ne %mem_SEP_Arena* %arena, null
+    br i1 %has_arena, label %arena_allocate, label %heap
+
+heap:
+    br i1 %is_malloced, label %reallocate, label %allocate
+
+reallocate:
+    %reallocated = call i8* @realloc(i8* %buffer, i64 %size)
+    br label %exit
+
+allocate:
+    %allocated = call i8* @malloc(i64 %size)
+    call void @llvm.memcpy.p0i8.p0i8.i64(i8* %allocated, i8* %buffer, i64 %used, i1 false)
+    br label %exit
+
+arena_allocate:
+    %size_with_header = add i64 %size, 16 ; Keeping the buffer aligned to 16
+    %allocation = call i8* @mem_SEP_Arena_SEP_allocate(%mem_SEP_Arena* %arena, i64 %size_with_header, i64 16)
+    %arena_pointer = bitcast i8* %allocation to %mem_SEP_Arena**
+    store %mem_SEP_Arena* %arena, %mem_SEP_Arena** %arena_pointer
+    %arena_allocated = getelementptr i8, i8* %allocation, i64 16
+    call void @llvm.memcpy.p0i8.p0i8.i64(i8* %arena_allocated, i8* %buffer, i64 %used, i1 false)
+    br i1 %is_malloced, label %free_old, label %exit
 
-    ; Initialize 'length'
-    %2 = getelementptr %str* %self, i64 0, i64 1 ; get pointer to 'length'
-    store i64 0, i64* %2 ; store 0
+free_old:
+    call void @free(i8* %buffer)
+    br label %exit
 
+exit:
+    %new_buffer = phi i8* [ %reallocated, %reallocate ], [ %allocated, %allocate ],
+                          [ %arena_allocated, %arena_allocate ], [ %arena_allocated, %free_old ]
+    %in_arena = phi i1 [ false, %reallocate ], [ false, %allocate ], [ true, %arena_allocate ], [ true, %free_old ]
+    %with_buffer = insertvalue { i8*, i1 } undef, i8* %new_buffer, 0
+    %grown = insertvalue { i8*, i1 } %with_buffer, i1 %in_arena, 1
+
+    ret { i8*, i1 } %grown
+}
+
+; std.io, a buffered stream to a file descriptor. Each thread has its own
+; stdout and stderr streams, so writes never take a lock. Buffers are 4 KiB
+; and flushed on each newline when writing to a terminal, so output shows
+; as it is written, and are 64 KiB otherwise, so output takes few syscalls.
+; Open streams are kept in a registry, which is flushed at exit, as threads
+; like the scheduler's workers never exit to flush their own.
+%io_SEP_Stream = type {
+    i8*,            ; 0: _buffer - allocated on the first write
+    i64,            ; 1: _length - bytes buffered
+    i64,            ; 2: _capacity - bytes the buffer can hold, 0 until the first write
+    i32,            ; 3: _fd - the file descriptor written to
+    i1,             ; 4: _flush_lines - whether each newline flushes the buffer
+    %io_SEP_Stream* ; 5: _next - the next open stream in the registry
+}
+
+; A segment of bytes to write, laid out as a 'struct iovec'.
+%io_SEP_Segment = type {
+    i8*,    ; 0: data
+    i64     ; 1: length
+}
+
+@io_stdout = internal thread_local global %io_SEP_Stream { i8* null, i64 0, i64 0, i32 1, i1 false, %io_SEP_Stream* null }
+@io_stderr = internal thread_local global %io_SEP_Stream { i8* null, i64 0, i64 0, i32 2, i1 false, %io_SEP_Stream* null }
+@io_streams = internal global %io_SEP_Stream* null ; The registry of open streams, of every thread
+@io_streams_lock = internal global [5 x i64] zeroinitializer ; pthread_mutex_t guarding the registry
+@io_streams_registered = internal global i1 false ; Whether the registry is flushed at exit
+@.io_newline = private unnamed_addr constant [1 x i8] c"\0A"
+
+declare i64 @writev(i32, %io_SEP_Segment*, i32)
+declare i32 @isatty(i32)
+declare i8* @memchr(i8*, i32, i64)
+declare i32 @__cxa_thread_atexit_impl(void (i8*)*, i8*, i8*)
+declare i32 @__cxa_atexit(void (i8*)*, i8*, i8*)
+@__dso_handle = external hidden global i8
+
+; Writes segments to a file descriptor with as few 'writev' calls as it
+; takes, which may write only part of them. Segments are updated past what
+; has been written, and writing stops at the first error.
+define private void @io_SEP__write_all(i32 %fd, %io_SEP_Segment* %segments, i32 %count) nounwind {
+entry:
+    br label %condition
+
+condition:
+    %remaining_segments = phi %io_SEP_Segment* [ %segments, %entry ], [ %skipped_segments, %advance ]
+    %remaining_count = phi i32 [ %count, %entry ], [ %skipped_count, %advance ]
+    %is_done = icmp sle i32 %remaining_count, 0
+    br i1 %is_done, label %exit, label %write
+
+write:
+    %written = call i64 @writev(i32 %fd, %io_SEP_Segment* %remaining_segments, i32 %remaining_count)
+    %failed = icmp slt i64 %written, 0
+    br i1 %failed, label %exit, label %skip
+
+skip: ; Past the segments written in full
+    %skip_segments = phi %io_SEP_Segment* [ %remaining_segments, %write ], [ %next_segments, %skip_whole ]
+    %skip_count = phi i32 [ %remaining_count, %write ], [ %next_count, %skip_whole ]
+    %left = phi i64 [ %written, %write ], [ %next_left, %skip_whole ]
+    %has_segments = icmp sgt i32 %skip_count, 0
+    br i1 %has_segments, label %check_whole, label %advance
+
+check_whole:
+    %length_pointer = getelementptr %io_SEP_Segment, %io_SEP_Segment* %skip_segments, i64 0, i32 1
+    %length = load i64, i64* %length_pointer
+    %is_whole = icmp uge i64 %left, %length
+    br i1 %is_whole, label %skip_whole, label %skip_part
+
+skip_whole:
+    %next_left = sub i64 %left, %length
+    %next_segments = getelementptr %io_SEP_Segment, %io_SEP_Segment* %skip_segments, i64 1
+    %next_count = sub i32 %skip_count, 1
+    br label %skip
+
+skip_part:
+    %data_pointer = getelementptr %io_SEP_Segment, %io_SEP_Segment* %skip_segments, i64 0, i32 0
+    %data = load i8*, i8** %data_pointer
+    %rest = getelementptr i8, i8* %data, i64 %left
+    store i8* %rest, i8** %data_pointer
+    %rest_length = sub i64 %length, %left
+    store i64 %rest_length, i64* %length_pointer
+    br label %advance
+
+advance:
+    %skipped_segments = phi %io_SEP_Segment* [ %skip_segments, %skip ], [ %skip_segments, %skip_part ]
+    %skipped_count = phi i32 [ %skip_count, %skip ], [ %skip_count, %skip_part ]
+    br label %condition
+
+exit:
+    ret void
+}
+
+; Flushes every open stream, of every thread, at exit. Threads still
+; writing may race with it, so tasks' output is also flushed as they finish.
+define private void @io_SEP__flush_all(i8* %unused) nounwind {
+entry:
+    %lock_bytes = bitcast [5 x i64]* @io_streams_lock to i8*
+    call i32 @pthread_mutex_lock(i8* %lock_bytes)
+    %first = load %io_SEP_Stream*, %io_SEP_Stream** @io_streams
+    br label %condition
+
+condition:
+    %stream = phi %io_SEP_Stream* [ %first, %entry ], [ %next, %flush ]
+    %is_done = icmp eq %io_SEP_Stream* %stream, null
+    br i1 %is_done, label %exit, label %flush
+
+flush:
+    call void @io_SEP_Stream_SEP_flush(%io_SEP_Stream* %stream)
+    %next_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %stream, i64 0, i32 5
+    %next = load %io_SEP_Stream*, %io_SEP_Stream** %next_pointer
+    br label %condition
+
+exit:
+    call i32 @pthread_mutex_unlock(i8* %lock_bytes)
+
+    ret void
+}
+
+; Flushes and frees a stream's buffer, and removes it from the registry,
+; when its thread exits.
+define private void @io_SEP_Stream_SEP__close(i8* %stream) nounwind {
+entry:
+    %self = bitcast i8* %stream to %io_SEP_Stream*
+    %lock_bytes = bitcast [5 x i64]* @io_streams_lock to i8*
+    call i32 @pthread_mutex_lock(i8* %lock_bytes)
+    %self_next_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 5
+    %self_next = load %io_SEP_Stream*, %io_SEP_Stream** %self_next_pointer
+    br label %find
+
+find: ; The link to this stream
+    %link = phi %io_SEP_Stream** [ @io_streams, %entry ], [ %next_link, %advance ]
+    %linked = load %io_SEP_Stream*, %io_SEP_Stream** %link
+    %is_missing = icmp eq %io_SEP_Stream* %linked, null
+    br i1 %is_missing, label %close, label %compare
+
+compare:
+    %is_self = icmp eq %io_SEP_Stream* %linked, %self
+    br i1 %is_self, label %unlink, label %advance
+
+advance:
+    %next_link = getelementptr %io_SEP_Stream, %io_SEP_Stream* %linked, i64 0, i32 5
+    br label %find
+
+unlink:
+    store %io_SEP_Stream* %self_next, %io_SEP_Stream** %link
+    br label %close
+
+close:
+    call i32 @pthread_mutex_unlock(i8* %lock_bytes)
+    call void @io_SEP_Stream_SEP_flush(%io_SEP_Stream* %self)
+    %buffer_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 0
+    %buffer = load i8*, i8** %buffer_pointer
+    call void @free(i8* %buffer)
+    store i8* null, i8** %buffer_pointer
+    %capacity_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 2
+    store i64 0, i64* %capacity_pointer
+
+    ret void
+}
+
+; Allocates a stream's buffer, sized by whether it writes to a terminal,
+; and adds it to the registry, flushed when its thread exits or at exit.
+define private void @io_SEP_Stream_SEP__open(%io_SEP_Stream* %self) nounwind noinline {
+entry:
+    %fd_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 3
+    %fd = load i32, i32* %fd_pointer
+    %terminal = call i32 @isatty(i32 %fd)
+    %is_terminal = icmp ne i32 %terminal, 0
+    %capacity = select i1 %is_terminal, i64 4096, i64 65536
+    %buffer = call i8* @malloc(i64 %capacity)
+
+    %buffer_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 0
+    store i8* %buffer, i8** %buffer_pointer
+    %capacity_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 2
+    store i64 %capacity, i64* %capacity_pointer
+    %flush_lines_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 4
+    store i1 %is_terminal, i1* %flush_lines_pointer
+
+    %lock_bytes = bitcast [5 x i64]* @io_streams_lock to i8*
+    call i32 @pthread_mutex_lock(i8* %lock_bytes)
+    %first = load %io_SEP_Stream*, %io_SEP_Stream** @io_streams
+    %next_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 5
+    store %io_SEP_Stream* %first, %io_SEP_Stream** %next_pointer
+    store %io_SEP_Stream* %self, %io_SEP_Stream** @io_streams
+    %is_registered = load i1, i1* @io_streams_registered
+    store i1 true, i1* @io_streams_registered
+    call i32 @pthread_mutex_unlock(i8* %lock_bytes)
+    br i1 %is_registered, label %exit, label %register
+
+register:
+    call i32 @__cxa_atexit(void (i8*)* @io_SEP__flush_all, i8* null, i8* @__dso_handle)
+    br label %exit
+
+exit:
+    %stream = bitcast %io_SEP_Stream* %self to i8*
+    call i32 @__cxa_thread_atexit_impl(void (i8*)* @io_SEP_Stream_SEP__close, i8* %stream, i8* @__dso_handle)
+
+    ret void
+}
+
+; Flushes this thread's stdout and stderr streams. The scheduler calls it
+; as tasks finish and before workers park, as workers never exit.
+define void @io_SEP_flush_thread() nounwind {
+    call void @io_SEP_Stream_SEP_flush(%io_SEP_Stream* @io_stdout)
+    call void @io_SEP_Stream_SEP_flush(%io_SEP_Stream* @io_stderr)
+
+    ret void
+}
+
+; Gets this thread's stdout stream.
+define %io_SEP_Stream* @io_SEP_stdout() nounwind {
+    ret %io_SEP_Stream* @io_stdout
+}
+
+; Gets this thread's stderr stream.
+define %io_SEP_Stream* @io_SEP_stderr() nounwind {
+    ret %io_SEP_Stream* @io_stderr
+}
+
+; Writes everything buffered in a stream.
+define void @io_SEP_Stream_SEP_flush(%io_SEP_Stream* %self) nounwind {
+entry:
+    %length_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 1
+    %length = load i64, i64* %length_pointer
+    %is_empty = icmp eq i64 %length, 0
+    br i1 %is_empty, label %exit, label %write
+
+write:
+    %segment = alloca %io_SEP_Segment
+    %buffer_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 0
+    %buffer = load i8*, i8** %buffer_pointer
+    %data_pointer = getelementptr %io_SEP_Segment, %io_SEP_Segment* %segment, i64 0, i32 0
+    store i8* %buffer, i8** %data_pointer
+    %segment_length_pointer = getelementptr %io_SEP_Segment, %io_SEP_Segment* %segment, i64 0, i32 1
+    store i64 %length, i64* %segment_length_pointer
+    %fd_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 3
+    %fd = load i32, i32* %fd_pointer
+    call void @io_SEP__write_all(i32 %fd, %io_SEP_Segment* %segment, i32 1)
+    store i64 0, i64* %length_pointer
+    br label %exit
+
+exit:
     ret void
 }
+
+; Writes segments to a stream. Segments that fit are copied into the
+; buffer, otherwise the buffer and the segments are written together, with
+; one 'writev' call for up to 255 segments. The segments may be updated.
+define void @io_SEP_Stream_SEP_write_segments(%io_SEP_Stream* %self, %io_SEP_Segment* %segments, i64 %count) nounwind {
+entry:
+    %capacity_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 2
+    %initial_capacity = load i64, i64* %capacity_pointer
+    %is_open = icmp ne i64 %initial_capacity, 0
+    br i1 %is_open, label %measure, label %open
+
+open:
+    call void @io_SEP_Stream_SEP__open(%io_SEP_Stream* %self)
+    br label %measure
+
+measure:
+    %index = phi i64 [ 0, %entry ], [ 0, %open ], [ %next_index, %measure_segment ]
+    %total = phi i64 [ 0, %entry ], [ 0, %open ], [ %next_total, %measure_segment ]
+    %has_segment = icmp ult i64 %index, %count
+    br i1 %has_segment, label %measure_segment, label %place
+
+measure_segment:
+    %measured_length_pointer = getelementptr %io_SEP_Segment, %io_SEP_Segment* %segments, i64 %index, i32 1
+    %measured_length = load i64, i64* %measured_length_pointer
+    %next_total = add i64 %total, %measured_length
+    %next_index = add i64 %index, 1
+    br label %measure
+
+place:
+    %buffer_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 0
+    %buffer = load i8*, i8** %buffer_pointer
+    %length_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 1
+    %length = load i64, i64* %length_pointer
+    %capacity = load i64, i64* %capacity_pointer
+    %space = sub i64 %capacity, %length
+    %fits = icmp ule i64 %total, %space
+    br i1 %fits, label %copy, label %write
+
+copy:
+    %copy_index = phi i64 [ 0, %place ], [ %next_copy_index, %copy_segment ]
+    %copied = phi i64 [ %length, %place ], [ %next_copied, %copy_segment ]
+    %has_copy = icmp ult i64 %copy_index, %count
+    br i1 %has_copy, label %copy_segment, label %copied_all
+
+copy_segment:
+    %data_pointer = getelementptr %io_SEP_Segment, %io_SEP_Segment* %segments, i64 %copy_index, i32 0
+    %data = load i8*, i8** %data_pointer
+    %copy_length_pointer = getelementptr %io_SEP_Segment, %io_SEP_Segment* %segments, i64 %copy_index, i32 1
+    %copy_length = load i64, i64* %copy_length_pointer
+    %destination = getelementptr i8, i8* %buffer, i64 %copied
+    call void @llvm.memcpy.p0i8.p0i8.i64(i8* %destination, i8* %data, i64 %copy_length, i1 false)
+    %next_copied = add i64 %copied, %copy_length
+    %next_copy_index = add i64 %copy_index, 1
+    br label %copy
+
+copied_all:
+    store i64 %copied, i64* %length_pointer
+    %flush_lines_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 4
+    %flush_lines = load i1, i1* %flush_lines_pointer
+    br i1 %flush_lines, label %find_newline, label %exit
+
+find_newline: ; Only in what was just copied, as the rest had none
+    %appended = getelementptr i8, i8* %buffer, i64 %length
+    %newline = call i8* @memchr(i8* %appended, i32 10, i64 %total)
+    %has_newline = icmp ne i8* %newline, null
+    br i1 %has_newline, label %flush, label %exit
+
+flush:
+    call void @io_SEP_Stream_SEP_flush(%io_SEP_Stream* %self)
+    br label %exit
+
+write: ; The buffer goes first, then the segments in batches well under 'IOV_MAX'
+    %batch = alloca [256 x %io_SEP_Segment]
+    %first = getelementptr [256 x %io_SEP_Segment], [256 x %io_SEP_Segment]* %batch, i64 0, i64 0
+    %first_data_pointer = getelementptr %io_SEP_Segment, %io_SEP_Segment* %first, i64 0, i32 0
+    store i8* %buffer, i8** %first_data_pointer
+    %first_length_pointer = getelementptr %io_SEP_Segment, %io_SEP_Segment* %first, i64 0, i32 1
+    store i64 %length, i64* %first_length_pointer
+    %fd_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 3
+    %fd = load i32, i32* %fd_pointer
+    br label %batch_condition
+
+batch_condition:
+    %batch_start = phi i64 [ 0, %write ], [ %batch_end, %write_batch ]
+    %batch_offset = phi i64 [ 1, %write ], [ 0, %write_batch ]
+    %has_batch = icmp ult i64 %batch_start, %count
+    br i1 %has_batch, label %fill_batch, label %written
+
+fill_batch:
+    %unbatched = sub i64 %count, %batch_start
+    %room = sub i64 256, %batch_offset
+    %batch_full = icmp ugt i64 %unbatched, %room
+    %batch_count = select i1 %batch_full, i64 %room, i64 %unbatched
+    %batch_destination = getelementptr [256 x %io_SEP_Segment], [256 x %io_SEP_Segment]* %batch, i64 0, i64 %batch_offset
+    %batch_destination_bytes = bitcast %io_SEP_Segment* %batch_destination to i8*
+    %batch_source = getelementptr %io_SEP_Segment, %io_SEP_Segment* %segments, i64 %batch_start
+    %batch_source_bytes = bitcast %io_SEP_Segment* %batch_source to i8*
+    %batch_bytes = shl i64 %batch_count, 4
+    call void @llvm.memcpy.p0i8.p0i8.i64(i8* %batch_destination_bytes, i8* %batch_source_bytes, i64 %batch_bytes, i1 false)
+    br label %write_batch
+
+write_batch:
+    %batch_length = add i64 %batch_offset, %batch_count
+    %batch_length_32 = trunc i64 %batch_length to i32
+    call void @io_SEP__write_all(i32 %fd, %io_SEP_Segment* %first, i32 %batch_length_32)
+    %batch_end = add i64 %batch_start, %batch_count
+    br label %batch_condition
+
+written:
+    store i64 0, i64* %length_pointer
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Writes 'length' bytes to a stream.
+define void @io_SEP_Stream_SEP_write(%io_SEP_Stream* %self, i8* %data, i64 %length) nounwind {
+    %segment = alloca %io_SEP_Segment
+    %data_pointer = getelementptr %io_SEP_Segment, %io_SEP_Segment* %segment, i64 0, i32 0
+    store i8* %data, i8** %data_pointer
+    %length_pointer = getelementptr %io_SEP_Segment, %io_SEP_Segment* %segment, i64 0, i32 1
+    store i64 %length, i64* %length_pointer
+    call void @io_SEP_Stream_SEP_write_segments(%io_SEP_Stream* %self, %io_SEP_Segment* %segment, i64 1)
+
+    ret void
+}
+
+; Writes a string and a newline to this thread's stdout, in one batch.
+define void @io_SEP_out(%str* %string) nounwind {
+    %segments = alloca [2 x %io_SEP_Segment]
+    %data = call i8* @str_SEP_data(%str* %string)
+    %length = call i64 @str_SEP_length(%str* %string)
+    %string_segment = insertvalue %io_SEP_Segment undef, i8* %data, 0
+    %string_segment_length = insertvalue %io_SEP_Segment %string_segment, i64 %length, 1
+    %newline = getelementptr [1 x i8], [1 x i8]* @.io_newline, i64 0, i64 0
+    %newline_segment = insertvalue %io_SEP_Segment undef, i8* %newline, 0
+    %newline_segment_length = insertvalue %io_SEP_Segment %newline_segment, i64 1, 1
+    %first = getelementptr [2 x %io_SEP_Segment], [2 x %io_SEP_Segment]* %segments, i64 0, i64 0
+    store %io_SEP_Segment %string_segment_length, %io_SEP_Segment* %first
+    %second = getelementptr [2 x %io_SEP_Segment], [2 x %io_SEP_Segment]* %segments, i64 0, i64 1
+    store %io_SEP_Segment %newline_segment_length, %io_SEP_Segment* %second
+    call void @io_SEP_Stream_SEP_write_segments(%io_SEP_Stream* @io_stdout, %io_SEP_Segment* %first, i64 2)
+
+    ret void
+}
+
+; Pairs of decimal digits, "00" to "99", so numbers are formatted 2 digits
+; at a time.
+@.io_digit_pairs = private unnamed_addr constant <{ [100 x i8], [100 x i8] }> <{
+    [100 x i8] c"0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849",
+    [100 x i8] c"5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899"
+}>
+
+@.io_powers_of_10 = private unnamed_addr constant [20 x i64] [
+    i64 1, i64 10, i64 100, i64 1000, i64 10000, i64 100000, i64 1000000, i64 10000000, i64 100000000,
+    i64 1000000000, i64 10000000000, i64 100000000000, i64 1000000000000, i64 10000000000000,
+    i64 100000000000000, i64 1000000000000000, i64 10000000000000000, i64 100000000000000000,
+    i64 1000000000000000000, i64 -8446744073709551616 ; 10^19, unsigned
+]
+
+; 126 bit approximations of the powers of 10 from 10^-292 to 10^324, for
+; formatting floats, as pairs of the high and low 63 bits of
+; floor(10^e / 2^r) + 1, where r = floor(log2(10^e)) - 125, see Giulietti's
+; "The Schubfach way to render doubles".
+@.io_power_significands = private unnamed_addr constant [1234 x i64] [
+    i64 9204188850495057447, i64 5294608251188331487, i64 5752618031559410904, i64 6767894670813248108,
+    i64 7190772539449263630, i64 8459868338516560134, i64 8988465674311579538, i64 5963149404718312264,
+    i64 5617791046444737211, i64 6032811387162639117, i64 7022238808055921514, i64 5235171224739604944,
+    i64 8777798510069901893, i64 1932278012497118276, i64 5486124068793688683, i64 2360595262417545899,
+    i64 6857655085992110854, i64 644901068808238421, i64 8572068857490138567, i64 5417812354437685931,
+    i64 5357543035931336604, i64 6844897235344094635, i64 6696928794914170755, i64 8556121544180118293,
+    i64 8371160993642713444, i64 8389308921011453915, i64 5231975621026695903, i64 631632057204770793,
+    i64 6539969526283369878, i64 7707069099147045347, i64 8174961907854212348, i64 5022150355506418780,
+    i64 5109351192408882717, i64 7750529990618899641, i64 6386688990511103397, i64 2770633460632542696,
+    i64 7983361238138879246, i64 5769134835004372321, i64 4989600773836799529, i64 1299866262664038749,
+    i64 6237000967295999411, i64 3930675837543742388, i64 7796251209119999264, i64 2607501787715984033,
+    i64 4872657005699999540, i64 1629688617322490021, i64 6090821257124999425, i64 2037110771653112526,
+    i64 7613526571406249281, i64 4852231473780084609, i64 4758454107128905800, i64 8797252194146787761,
+    i64 5948067633911132251, i64 1773193205828708893, i64 7435084542388915313, i64 9134020534926967972,
+    i64 4646927838993072071, i64 2249998320508814055, i64 5808659798741340089, i64 506654891422323617,
+    i64 7260824748426675111, i64 2939161623491598473, i64 9076030935533343889, i64 1368109020150804139,
+    i64 5672519334708339930, i64 6619675660628487467, i64 7090649168385424913, i64 3662908557358221429,
+    i64 8863311460481781141, i64 6884478705911470739, i64 5539569662801113213, i64 5455720695801516188,
+    i64 6924462078501391516, i64 9125493878965589187, i64 8655577598126739396, i64 2183495311852210675,
+    i64 5409735998829212122, i64 5976370588335019576, i64 6762169998536515153, i64 2858777216991386566,
+    i64 8452712498170643941, i64 5879314530452927160, i64 5282945311356652463, i64 4827493086139926451,
+    i64 6603681639195815579, i64 3728523348461214111, i64 8254602048994769474, i64 2354811176362823687,
+    i64 5159126280621730921, i64 3777599994440458757, i64 6448907850777163651, i64 7027843002264267398,
+    i64 8061134813471454564, i64 6478960743616640295, i64 5038209258419659102, i64 8661036483187788089,
+    i64 6297761573024573878, i64 6214609585557347207, i64 7872201966280717348, i64 3156575963519296104,
+    i64 4920126228925448342, i64 6584545995626947969, i64 6150157786156810428, i64 3618996476106297057,
+    i64 7687697232696013035, i64 4523745595132871322, i64 4804810770435008147, i64 1674419492351197600,
+    i64 6006013463043760183, i64 9010553393080078856, i64 7507516828804700229, i64 8957348732136404618,
+    i64 4692198018002937643, i64 6751264462192099863, i64 5865247522503672054, i64 6133237568526430876,
+    i64 7331559403129590068, i64 3054860942230650691, i64 9164449253911987585, i64 3818576177788313364,
+    i64 5727780783694992240, i64 8151217634151930732, i64 7159725979618740301, i64 965650005835137607,
+    i64 8949657474523425376, i64 3512905516507615961, i64 5593535921577140860, i64 2195565947817259976,
+    i64 6991919901971426075, i64 2744457434771574970, i64 8739899877464282594, i64 1124728784250774760,
+    i64 5462437423415176621, i64 3008798499370428177, i64 6828046779268970776, i64 6066841133426729173,
+    i64 8535058474086213470, i64 7583551416783411467, i64 5334411546303883419, i64 2433876626275938215,
+    i64 6668014432879854274, i64 736502773631228816, i64 8335018041099817842, i64 5532314485466423924,
+    i64 5209386275687386151, i64 5763539562630208905, i64 6511732844609232689, i64 4898581444074067179,
+    i64 8139666055761540861, i64 8429069814306277926, i64 5087291284850963038, i64 6421090138548270680,
+    i64 6359114106063703798, i64 3414676654757950445, i64 7948892632579629747, i64 8880031836874825961,
+    i64 4968057895362268592, i64 4397098393439919250, i64 6210072369202835740, i64 5496372991799899062,
+    i64 7762590461503544675, i64 6870466239749873827, i64 4851619038439715422, i64 3141119895236824166,
+    i64 6064523798049644277, i64 8538085887473418112, i64 7580654747562055347, i64 3755078331700690783,
+    i64 4737909217226284592, i64 1194002452706084764, i64 5922386521532855740, i64 1492503065882605955,
+    i64 7402983151916069675, i64 1865628832353257443, i64 4626864469947543547, i64 13096515613938926,
+    i64 5783580587434429433, i64 6933899672158505514, i64 7229475734293036792, i64 1749845562557050036,
+    i64 9036844667866295990, i64 2187306953196312545, i64 5648027917416434993, i64 8284595873388777197,
+    i64 7060034896770543742, i64 3438215814094889640, i64 8825043620963179677, i64 8909455786045999954,
+    i64 5515652263101987298, i64 6721331370885596947, i64 6894565328877484123, i64 3789978195179608280,
+    i64 8618206661096855154, i64 2431629734760816398, i64 5386379163185534471, i64 3825611593439204201,
+    i64 6732973953981918089, i64 2476171482585311299, i64 8416217442477397611, i64 5401057362445333075,
+    i64 5260135901548373507, i64 2222739346921486196, i64 6575169876935466884, i64 472581174438163793,
+    i64 8218962346169333605, i64 590726468047704741, i64 5136851466355833503, i64 1522125547136662440,
+    i64 6421064332944791878, i64 8820185961561909905, i64 8026330416180989848, i64 6413546433524999478,
+    i64 5016456510113118655, i64 4008466520953124674, i64 6270570637641398319, i64 2704740141977711890,
+    i64 7838213297051747899, i64 1075082168258445910, i64 4898883310657342436, i64 8742376887409457526,
+    i64 6123604138321678046, i64 1704599072407046100, i64 7654505172902097557, i64 6742434858936195528,
+    i64 4784065733063810973, i64 5366943291441969181, i64 5980082166329763716, i64 9014522123516155429,
+    i64 7475102707912204646, i64 2044780617540418478, i64 4671939192445127903, i64 8195516913603843405,
+    i64 5839923990556409879, i64 7938553132791110304, i64 7299904988195512349, i64 7617348406775193928,
+    i64 9124881235244390437, i64 2604156480827910553, i64 5703050772027744023, i64 2780519305124291072,
+    i64 7128813465034680029, i64 1169806122191669888, i64 8911016831293350036, i64 3768100661953281312,
+    i64 5569385519558343772, i64 6966748932148188724, i64 6961731899447929715, i64 8708436165185235905,
+    i64 8702164874309912144, i64 8579702197267850929, i64 5438853046443695090, i64 5362313873292406831,
+    i64 6798566308054618863, i64 2091206323188120634, i64 8498207885068273579, i64 308164894771456841,
+    i64 5311379928167670986, i64 8263053591480089358, i64 6639224910209588733, i64 5717130970922723793,
+    i64 8299031137761985917, i64 228884686012322885, i64 5186894461101241198, i64 1295974433364548779,
+    i64 6483618076376551497, i64 6231654060133073878, i64 8104522595470689372, i64 872038547525260492,
+    i64 5065326622169180857, i64 5156710110630675711, i64 6331658277711476071, i64 8751730647502038591,
+    i64 7914572847139345089, i64 8633820300163854287, i64 4946608029462090681, i64 1937373173781868001,
+    i64 6183260036827613351, i64 4727559476441028954, i64 7729075046034516689, i64 3603606336337592240,
+    i64 4830671903771572930, i64 8016861483245230030, i64 6038339879714466163, i64 5409390835629149634,
+    i64 7547924849643082704, i64 4455895535322743090, i64 4717453031026926690, i64 2784934709576714431,
+    i64 5896816288783658362, i64 8092854405398280943, i64 7371020360979572953, i64 5504381988320463275,
+    i64 9213775451224466191, i64 9186320494614273045, i64 5758609657015291369, i64 9200214822954461581,
+    i64 7198262071269114212, i64 4582739501051995121, i64 8997827589086392765, i64 5728424376314993901,
+    i64 5623642243178995478, i64 4733186739803718164, i64 7029552803973744348, i64 1304797406327259801,
+    i64 8786941004967180435, i64 1630996757909074751, i64 5491838128104487771, i64 9089823505941100552,
+    i64 6864797660130609714, i64 9056436373212681737, i64 8580997075163262143, i64 6708859448088464268,
+    i64 5363123171977038839, i64 7651801668875831096, i64 6703903964971298549, i64 7258909076881094917,
+    i64 8379879956214123187, i64 2156107318460286790, i64 5237424972633826992, i64 194645569430832268,
+    i64 6546781215792283740, i64 243306961788540335, i64 8183476519740354675, i64 304133702235675419,
+    i64 5114672824837721671, i64 8260534096145225969, i64 6393341031047152089, i64 8019824610967838509,
+    i64 7991676288808940112, i64 3107251736068716280, i64 4994797680505587570, i64 1942032335042947675,
+    i64 6243497100631984462, i64 7039226437231072498, i64 7804371375789980578, i64 4187347028111452718,
+    i64 4877732109868737861, i64 4922934901783351901, i64 6097165137335922326, i64 8459511636442883828,
+    i64 7621456421669902908, i64 5962703527126216881, i64 4763410263543689317, i64 8338375722881273455,
+    i64 5954262829429611647, i64 3505440625960509963, i64 7442828536787014559, i64 2075957773236943501,
+    i64 4651767835491884099, i64 4756238122093630616, i64 5814709794364855124, i64 3639454643403344318,
+    i64 7268387242956068905, i64 4549318304254180398, i64 9085484053695086131, i64 7992490889531419449,
+    i64 5678427533559428832, i64 3842385301350290180, i64 7098034416949286040, i64 4802981626687862725,
+    i64 8872543021186607550, i64 6003727033359828406, i64 5545339388241629719, i64 1446486386636198802,
+    i64 6931674235302037148, i64 8725637010936330358, i64 8664592794127546436, i64 1683674226815637140,
+    i64 5415370496329716522, i64 5663982410187161116, i64 6769213120412145653, i64 2468291994306563491,
+    i64 8461516400515182066, i64 5391208002096898316, i64 5288447750321988791, i64 5675348010524255400,
+    i64 6610559687902485989, i64 4788342003941625298, i64 8263199609878107486, i64 8291270514140725574,
+    i64 5164499756173817179, i64 2876201062124259532, i64 6455624695217271474, i64 1289408318441630463,
+    i64 8069530869021589342, i64 6223446416479425982, i64 5043456793138493339, i64 1583811001085947287,
+    i64 6304320991423116673, i64 8897292778998515965, i64 7880401239278895842, i64 4204086946107063100,
+    i64 4925250774549309901, i64 4933397350530608390, i64 6156563468186637376, i64 8472589697376954439,
+    i64 7695704335233296721, i64 1367365084866417240, i64 4809815209520810450, i64 6619210701075745655,
+    i64 6012269011901013063, i64 3662327357917294165, i64 7515336264876266329, i64 2272066188182923754,
+    i64 4697085165547666455, i64 7184648890648562227, i64 5871356456934583069, i64 6674968104097008831,
+    i64 7339195571168228837, i64 1426181102480179183, i64 9173994463960286046, i64 4088569387313917931,
+    i64 5733746539975178779, i64 249512857857504755, i64 7167183174968973473, i64 7229420099962962799,
+    i64 8958978968711216842, i64 2119246097312621643, i64 5599361855444510526, i64 3630371820034082479,
+    i64 6999202319305638157, i64 9149650793469991003, i64 8749002899132047697, i64 4519534464196406897,
+    i64 5468126811957529810, i64 8589316563156989191, i64 6835158514946912263, i64 6124959685518848585,
+    i64 8543948143683640329, i64 5350356597684866779, i64 5339967589802275205, i64 9108580396587276617,
+    i64 6674959487252844007, i64 4468196468093013915, i64 8343699359066055009, i64 3279402575902573442,
+    i64 5214812099416284380, i64 7814234132973343281, i64 6518515124270355476, i64 544420629361903293,
+    i64 8148143905337944345, i64 680525786702379117, i64 5092589940836215215, i64 6189936139723221828,
+    i64 6365737426045269019, i64 5431577165440333333, i64 7957171782556586274, i64 4483628447586722714,
+    i64 4973232364097866421, i64 5108110788955395648, i64 6216540455122333026, i64 8690981495407938512,
+    i64 7770675568902916283, i64 6252040850832535236, i64 4856672230564322677, i64 2754604027163487547,
+    i64 6070840288205403346, i64 5749098043168053386, i64 7588550360256754183, i64 2574686535532678828,
+    i64 4742843975160471364, i64 5067943598528465196, i64 5928554968950589205, i64 6334929498160581494,
+    i64 7410693711188236507, i64 1001132845059645012, i64 4631683569492647816, i64 8696158560410206965,
+    i64 5789604461865809771, i64 1646826163657982898, i64 7237005577332262213, i64 8976061732213560478,
+    i64 9046256971665327767, i64 4302548137625868741, i64 5653910607290829854, i64 6147857099836708891,
+    i64 7067388259113537318, i64 3073135356368498210, i64 8834235323891921647, i64 8453105213888010667,
+    i64 5521397077432451029, i64 8741955272500547595, i64 6901746346790563787, i64 4009915062984602637,
+    i64 8627182933488204734, i64 2706550819517059345, i64 5391989333430127958, i64 8609123289839243947,
+    i64 6739986666787659948, i64 6149718093871667029, i64 8424983333484574935, i64 7687147617339583786,
+    i64 5265614583427859334, i64 8263231774657780795, i64 6582018229284824168, i64 5717353699894838089,
+    i64 8227522786606030210, i64 7146692124868547611, i64 5142201741628768881, i64 6772525587256536209,
+    i64 6427752177035961102, i64 1548127956429588405, i64 8034690221294951377, i64 6546845963964373411,
+    i64 5021681388309344611, i64 633014213657192454, i64 6277101735386680763, i64 7708796794712572423,
+    i64 7846377169233350954, i64 7330152984177021577, i64 4903985730770844346, i64 6887188624324332438,
+    i64 6129982163463555433, i64 3997299761978027643, i64 7662477704329444291, i64 7302467711686228506,
+    i64 4789048565205902682, i64 3411120815197045840, i64 5986310706507378352, i64 8875587037423695204,
+    i64 7482888383134222941, i64 1871111759924843197, i64 4676805239458889338, i64 2322366354559873974,
+    i64 5846006549323611672, i64 7514643961627230372, i64 7307508186654514591, i64 169932915179262157,
+    i64 9134385233318143238, i64 7129945171615159552, i64 5708990770823839524, i64 2150372723045780768,
+    i64 7136238463529799405, i64 2687965903807225960, i64 8920298079412249256, i64 5665800388972726402,
+    i64 5575186299632655785, i64 3541125243107954001, i64 6968982874540819731, i64 6732249563098636453,
+    i64 8711228593176024664, i64 6109468944659601615, i64 5444517870735015415, i64 3818418090412251009,
+    i64 6805647338418769269, i64 2467179603801619810, i64 8507059173023461586, i64 5389817513965718714,
+    i64 5316911983139663491, i64 5674478955442268148, i64 6646139978924579364, i64 4787255685089141233,
+    i64 8307674973655724205, i64 5984069606361426541, i64 5192296858534827628, i64 4892965008582738565,
+    i64 6490371073168534535, i64 6116206260728423206, i64 8112963841460668169, i64 5339414816696835055,
+    i64 5070602400912917605, i64 9101741783469756789, i64 6338253001141147007, i64 4459648201696114131,
+    i64 7922816251426433759, i64 3268717242906448711, i64 4951760157141521099, i64 5501712790637071373,
+    i64 6189700196426901374, i64 4571297979082645264, i64 7737125245533626718, i64 1102436455425918676,
+    i64 4835703278458516698, i64 7606551812282281028, i64 6044629098073145873, i64 4896503746925463381,
+    i64 7555786372591432341, i64 8426472692870523179, i64 4722366482869645213, i64 6419466937650923963,
+    i64 5902958103587056517, i64 1106804644422573097, i64 7378697629483820646, i64 3689348814741910324,
+    i64 4611686018427387904, i64 1, i64 5764607523034234880, i64 1,
+    i64 7205759403792793600, i64 1, i64 9007199254740992000, i64 1,
+    i64 5629499534213120000, i64 1, i64 7036874417766400000, i64 1,
+    i64 8796093022208000000, i64 1, i64 5497558138880000000, i64 1,
+    i64 6871947673600000000, i64 1, i64 8589934592000000000, i64 1,
+    i64 5368709120000000000, i64 1, i64 6710886400000000000, i64 1,
+    i64 8388608000000000000, i64 1, i64 5242880000000000000, i64 1,
+    i64 6553600000000000000, i64 1, i64 8192000000000000000, i64 1,
+    i64 5120000000000000000, i64 1, i64 6400000000000000000, i64 1,
+    i64 8000000000000000000, i64 1, i64 5000000000000000000, i64 1,
+    i64 6250000000000000000, i64 1, i64 7812500000000000000, i64 1,
+    i64 4882812500000000000, i64 1, i64 6103515625000000000, i64 1,
+    i64 7629394531250000000, i64 1, i64 4768371582031250000, i64 1,
+    i64 5960464477539062500, i64 1, i64 7450580596923828125, i64 1,
+    i64 4656612873077392578, i64 1152921504606846977, i64 5820766091346740722, i64 6052837899185946625,
+    i64 7275957614183425903, i64 2954361355555045377, i64 9094947017729282379, i64 1387108685230112769,
+    i64 5684341886080801486, i64 8937393460516749313, i64 7105427357601001858, i64 6560055807218548737,
+    i64 8881784197001252323, i64 3588383740595798017, i64 5551115123125782702, i64 1089818333265526785,
+    i64 6938893903907228377, i64 5973958935009296385, i64 8673617379884035472, i64 549919641120538625,
+    i64 5421010862427522170, i64 343699775700336641, i64 6776263578034402712, i64 5041310738052808705,
+    i64 8470329472543003390, i64 6301638422566010881, i64 5293955920339377119, i64 1632681004890062849,
+    i64 6617444900424221398, i64 8958380283753660417, i64 8271806125530276748, i64 6586289336264687617,
+    i64 5169878828456422967, i64 8728116853592817665, i64 6462348535570528709, i64 8604303057777328129,
+    i64 8077935669463160887, i64 3837849794580578305, i64 5048709793414475554, i64 5857420635433402369,
+    i64 6310887241768094443, i64 2710089775864365057, i64 7888609052210118054, i64 1081769210616762369,
+    i64 4930380657631323783, i64 7593634784276558337, i64 6162975822039154729, i64 7186200471132003969,
+    i64 7703719777548943412, i64 2065221561273923105, i64 4814824860968089632, i64 5902449494223589845,
+    i64 6018531076210112040, i64 7378061867779487306, i64 7523163845262640050, i64 9222577334724359132,
+    i64 4701977403289150031, i64 8069953843416418410, i64 5877471754111437539, i64 7781599295056829060,
+    i64 7346839692639296924, i64 7421156109607342373, i64 9183549615799121156, i64 53073100154402158,
+    i64 5739718509874450722, i64 4644856706023889253, i64 7174648137343063403, i64 1194384864102473662,
+    i64 8968310171678829253, i64 8410510107769173933, i64 5605193857299268283, i64 6409490321962580684,
+    i64 7006492321624085354, i64 5706019893239531903, i64 8758115402030106693, i64 2520838848122026975,
+    i64 5473822126268816683, i64 2728445784683113836, i64 6842277657836020854, i64 1104714221640198342,
+    i64 8552847072295026067, i64 5992578795477635832, i64 5345529420184391292, i64 2592440242566675419,
+    i64 6681911775230489115, i64 3240550303208344274, i64 8352389719038111394, i64 1744844869796736390,
+    i64 5220243574398819621, i64 3396371052836654196, i64 6525304467998524526, i64 6551306825259511697,
+    i64 8156630584998155658, i64 3577447513147001717, i64 5097894115623847286, i64 4541747704930570025,
+    i64 6372367644529809108, i64 1065498612735824627, i64 7965459555662261385, i64 1331873265919780784,
+    i64 4978412222288913365, i64 6597028314234097870, i64 6223015277861141707, i64 1328756365151540482,
+    i64 7778769097326427133, i64 8578474484080507458, i64 4861730685829016958, i64 6514468057157164137,
+    i64 6077163357286271198, i64 3531399053019067268, i64 7596454196607838997, i64 9025934834701221989,
+    i64 4747783872879899373, i64 6794130776295110719, i64 5934729841099874217, i64 1575134442727806543,
+    i64 7418412301374842771, i64 4274761062623452130, i64 4636507688359276732, i64 1518804159532810606,
+    i64 5795634610449095915, i64 1898505199416013257, i64 7244543263061369894, i64 67288490056322619,
+    i64 9055679078826712367, i64 4695796630997791177, i64 5659799424266695229, i64 6393637408194160414,
+    i64 7074749280333369037, i64 1074517732601618662, i64 8843436600416711296, i64 3648990174965717279,
+    i64 5527147875260444560, i64 2280618859353573299, i64 6908934844075555700, i64 2850773574191966624,
+    i64 8636168555094444625, i64 3563466967739958280, i64 5397605346934027890, i64 7991774377871708805,
+    i64 6747006683667534863, i64 5378031953912248102, i64 8433758354584418579, i64 4416696933176616176,
+    i64 5271098971615261612, i64 1607514078628538134, i64 6588873714519077015, i64 2009392598285672668,
+    i64 8236092143148846269, i64 205897738643396882, i64 5147557589468028918, i64 1281607591258970028,
+    i64 6434446986835036147, i64 6213695507501100438, i64 8043058733543795184, i64 5461276375162681596,
+    i64 5026911708464871990, i64 3413297734476675998, i64 6283639635581089987, i64 8878308186523232901,
+    i64 7854549544476362484, i64 8792042223940347174, i64 4909093465297726553, i64 883340371535329080,
+    i64 6136366831622158191, i64 3410018473632855302, i64 7670458539527697739, i64 1956680082827375175,
+    i64 4794036587204811087, i64 70003547160262509, i64 5992545734006013858, i64 7005033461591409992,
+    i64 7490682167507517323, i64 4144605808561874585, i64 4681676354692198327, i64 1437457125744324640,
+    i64 5852095443365247908, i64 8714350434821487656, i64 7315119304206559886, i64 1669566006672083762,
+    i64 9143899130258199857, i64 6698643526767492606, i64 5714936956411374911, i64 727887690409141951,
+    i64 7143671195514218638, i64 7827388640652509295, i64 8929588994392773298, i64 5172549782388248714,
+    i64 5580993121495483311, i64 5538686623206349399, i64 6976241401869354139, i64 4617515269794242796,
+    i64 8720301752336692674, i64 3466051078029109543, i64 5450188595210432921, i64 4472124932981887417,
+    i64 6812735744013041151, i64 7895999175441053223, i64 8515919680016301439, i64 7564155960087622576,
+    i64 5322449800010188399, i64 8186361988875305038, i64 6653062250012735499, i64 7927109476880437346,
+    i64 8316327812515919374, i64 7603043836886852730, i64 5197704882822449609, i64 2446059388840589004,
+    i64 6497131103528062011, i64 5363417245264430207, i64 8121413879410077514, i64 4398428547366843807,
+    i64 5075883674631298446, i64 5054860851317971332, i64 6344854593289123058, i64 1706890045720076260,
+    i64 7931068241611403822, i64 6745298575577483229, i64 4956917651007127389, i64 1909968600522233067,
+    i64 6196147063758909236, i64 4693303759866485285, i64 7745183829698636545, i64 5866629699833106606,
+    i64 4840739893561647841, i64 207879048575150701, i64 6050924866952059801, i64 2565691819932632328,
+    i64 7563656083690074751, i64 5512957784129484362, i64 4727285052306296719, i64 6904363128901468655,
+    i64 5909106315382870899, i64 6324610901913141866, i64 7386382894228588624, i64 5599920618177733380,
+    i64 4616489308892867890, i64 3499950386361083363, i64 5770611636116084862, i64 8986624001378742108,
+    i64 7213264545145106078, i64 6621593983296039730, i64 9016580681431382598, i64 3665306460692661759,
+    i64 5635362925894614123, i64 9208345565573995455, i64 7044203657368267654, i64 9204588947753800367,
+    i64 8805254571710334568, i64 6894050166264862555, i64 5503284107318959105, i64 4308781353915539097,
+    i64 6879105134148698881, i64 7691819701608117823, i64 8598881417685873602, i64 2697245599369065423,
+    i64 5374300886053671001, i64 3991621508819359841, i64 6717876107567088751, i64 7295369895237893754,
+    i64 8397345134458860939, i64 6813369359833673240, i64 5248340709036788087, i64 3105434345289198799,
+    i64 6560425886295985109, i64 1575949922397804547, i64 8200532357869981386, i64 4275780412210949635,
+    i64 5125332723668738366, i64 4978205766845537474, i64 6406665904585922958, i64 1611071190129533939,
+    i64 8008332380732403697, i64 6625525006089305327, i64 5005207737957752311, i64 682188614985274902,
+    i64 6256509672447190388, i64 7770264796372675483, i64 7820637090558987986, i64 489458958611068546,
+    i64 4887898181599367491, i64 2611754858345611793, i64 6109872726999209364, i64 958850563718320789,
+    i64 7637340908749011705, i64 1198563204647900987, i64 4773338067968132315, i64 6513709525939172997,
+    i64 5966672584960165394, i64 5836293898210272294, i64 7458340731200206743, i64 2683681354335452463,
+    i64 4661462957000129214, i64 5136065360280198718, i64 5826828696250161518, i64 1808395681922860493,
+    i64 7283535870312701897, i64 6872180620830963520, i64 9104419837890877372, i64 1672696748397622544,
+    i64 5690262398681798357, i64 5657121486175901994, i64 7112827998352247947, i64 153872830078795637,
+    i64 8891034997940309933, i64 7109870065239576402, i64 5556896873712693708, i64 5596590295381582227,
+    i64 6946121092140867135, i64 6995737869226977784, i64 8682651365176083919, i64 6438829327320028278,
+    i64 5426657103235052449, i64 7483032843395558602, i64 6783321379043815562, i64 2436262026603366396,
+    i64 8479151723804769452, i64 7657013551681595899, i64 5299469827377980908, i64 173947451373609533,
+    i64 6624337284222476135, i64 217434314217011916, i64 8280421605278095168, i64 7189321920412346751,
+    i64 5175263503298809480, i64 4493326200257716720, i64 6469079379123511850, i64 5616657750322145900,
+    i64 8086349223904389813, i64 2409136169475294470, i64 5053968264940243633, i64 2658631610528906020,
+    i64 6317460331175304541, i64 5629132522374826477, i64 7896825413969130677, i64 118886625327451240,
+    i64 4935515883730706673, i64 1227225645436504001, i64 6169394854663383341, i64 3839875066009323953,
+    i64 7711743568329229176, i64 7105686841725348894, i64 4819839730205768235, i64 4441054276078343059,
+    i64 6024799662757210294, i64 3245474835884234871, i64 7530999578446512867, i64 8668529563282681493,
+    i64 4706874736529070542, i64 4264909472444828957, i64 5883593420661338178, i64 719450822128648293,
+    i64 7354491775826672722, i64 5510999546088198270, i64 9193114719783340903, i64 2277063414182859933,
+    i64 5745696699864588064, i64 4881929147684828386, i64 7182120874830735080, i64 6102411434606035483,
+    i64 8977651093538418850, i64 7628014293257544353, i64 5611031933461511781, i64 7073351942499659173,
+    i64 7013789916826889727, i64 1924160900483492110, i64 8767237396033612159, i64 99358116390671185,
+    i64 5479523372521007599, i64 3520863336564710419, i64 6849404215651259499, i64 2095236161492194072,
+    i64 8561755269564074374, i64 313202192651548637, i64 5351097043477546483, i64 7113280398048299755,
+    i64 6688871304346933104, i64 6585757488346680741, i64 8361089130433666380, i64 8232196860433350926,
+    i64 5225680706521041488, i64 533437019343456425, i64 6532100883151301860, i64 666796274179320531,
+    i64 8165126103939127325, i64 833495342724150664, i64 5103203814961954578, i64 1673856093809441141,
+    i64 6379004768702443222, i64 6704006135689189330, i64 7973755960878054028, i64 3768321651184098759,
+    i64 4983597475548783767, i64 6966887050417449628, i64 6229496844435979709, i64 6402765803808118083,
+    i64 7786871055544974637, i64 1085928227119065748, i64 4866794409715609148, i64 1831626646556263069,
+    i64 6083493012144511435, i64 2289533308195328836, i64 7604366265180639294, i64 556073626030467093,
+    i64 4752728915737899558, i64 7265075043910123789, i64 5940911144672374448, i64 4469657786460266832,
+    i64 7426138930840468060, i64 5587072233075333540, i64 4641336831775292537, i64 8103606164099471367,
+    i64 5801671039719115672, i64 3211978677483257352, i64 7252088799648894590, i64 4014973346854071690,
+    i64 9065110999561118238, i64 407030665140201709, i64 5665694374725698898, i64 7171923193353707924,
+    i64 7082117968407123623, i64 4353217973264747001, i64 8852647460508904529, i64 3135679457367239799,
+    i64 5532904662818065330, i64 7724407183888759755, i64 6916130828522581663, i64 5043822961433561789,
+    i64 8645163535653227079, i64 3998935692578258285, i64 5403227209783266924, i64 5958099321681952356,
+    i64 6754034012229083655, i64 7447624152102440445, i64 8442542515286354569, i64 7003687180914356604,
+    i64 5276589072053971606, i64 918539974250931950, i64 6595736340067464507, i64 5759860986241052841,
+    i64 8244670425084330634, i64 4893983223587622099, i64 5152919015677706646, i64 5364582523955957764,
+    i64 6441148769597133308, i64 2094042136517559301, i64 8051435961996416635, i64 2617552670646949126,
+    i64 5032147476247760397, i64 483048914547496228, i64 6290184345309700496, i64 2909654152398064237,
+    i64 7862730431637125620, i64 3637067690497580296, i64 4914206519773203512, i64 6884853324988375589,
+    i64 6142758149716504390, i64 8606066656235469486, i64 7678447687145630488, i64 6145897301866948954,
+    i64 4799029804466019055, i64 3841185813666843096, i64 5998787255582523819, i64 2495639257869859918,
+    i64 7498484069478154774, i64 813706063123630946, i64 4686552543423846733, i64 7426095317093351197,
+    i64 5858190679279808417, i64 2365090118725607140, i64 7322738349099760521, i64 5262205657620702877,
+    i64 9153422936374700651, i64 8883600081239572549, i64 5720889335234187907, i64 4399328546167885867,
+    i64 7151111669042734884, i64 3193317673496163382, i64 8938889586303418605, i64 3991647091870204227,
+    i64 5586805991439636628, i64 3647700937025724618, i64 6983507489299545785, i64 4559626171282155773,
+    i64 8729384361624432231, i64 8005375723316388668, i64 5455865226015270144, i64 8462124340893283845,
+    i64 6819831532519087681, i64 1354283389261828999, i64 8524789415648859601, i64 3998697245790980200,
+    i64 5327993384780537250, i64 8263793301653597505, i64 6659991730975671563, i64 5718055608639608977,
+    i64 8324989663719589454, i64 4841726501585817270, i64 5203118539824743409, i64 720236054277441842,
+    i64 6503898174780929261, i64 3206138077060496254, i64 8129872718476161576, i64 6313515605539314269,
+    i64 5081170449047600985, i64 3945947253462071419, i64 6351463061309501231, i64 7238277076041283225,
+    i64 7939328826636876539, i64 6742003335837910079, i64 4962080516648047837, i64 3060830580291846824,
+    i64 6202600645810059796, i64 6131881234578502482, i64 7753250807262574745, i64 7664851543223128102,
+    i64 4845781754539109216, i64 1331767700693914136, i64 6057227193173886520, i64 1664709625867392670,
+    i64 7571533991467358150, i64 2080887032334240837, i64 4732208744667098843, i64 8218083422849982379,
+    i64 5915260930833873554, i64 7966761269348784022, i64 7394076163542341943, i64 5346765568258592123,
+    i64 4621297602213963714, i64 6800492993982161005, i64 5776622002767454643, i64 3888930224050313352,
+    i64 7220777503459318304, i64 2555319770849197738, i64 9025971879324147880, i64 3194149713561497173,
+    i64 5641232424577592425, i64 1996343570975935733, i64 7051540530721990531, i64 4801272472933613619,
+    i64 8814425663402488164, i64 3695747581953323071, i64 5509016039626555102, i64 6921528257148214824,
+    i64 6886270049533193878, i64 4040224303007880625, i64 8607837561916492348, i64 438594360332462878,
+    i64 5379898476197807717, i64 4885807493635177203, i64 6724873095247259646, i64 8413102376257665455,
+    i64 8406091369059074558, i64 5904691951894693915, i64 5253807105661921599, i64 1384589460720489745,
+    i64 6567258882077401998, i64 8648265853541694037, i64 8209073602596752498, i64 6198646298499729642,
+    i64 5130671001622970311, i64 6179996945776024979, i64 6413338752028712889, i64 5419153173006337271,
+    i64 8016673440035891111, i64 9079784475471615541, i64 5010420900022431944, i64 9133629810990300641,
+    i64 6263026125028039931, i64 2193665226883099993, i64 7828782656285049914, i64 436238524390181040,
+    i64 4892989160178156196, i64 2578492086957557102, i64 6116236450222695245, i64 3223115108696946377,
+    i64 7645295562778369056, i64 6334736895084876923, i64 4778309726736480660, i64 3959210559428048077,
+    i64 5972887158420600825, i64 4949013199285060097, i64 7466108948025751031, i64 8492109508320019073,
+    i64 4666318092516094394, i64 8766332956520552849, i64 5832897615645117993, i64 6346230177223303157,
+    i64 7291122019556397492, i64 1015258693888047090, i64 9113902524445496865, i64 1269073367360058862,
+    i64 5696189077778435540, i64 6557778377634271669
+]
+
+@.io_nan = private unnamed_addr constant [3 x i8] c"nan"
+@.io_inf = private unnamed_addr constant [3 x i8] c"inf"
+
+; Counts the decimal digits of an unsigned integer, from its bit length.
+define private i64 @io_SEP__count_digits(i64 %value) nounwind readnone alwaysinline {
+    %nonzero = or i64 %value, 1
+    %leading_zeros = call i64 @llvm.ctlz.i64(i64 %nonzero, i1 true)
+    %bits = sub i64 64, %leading_zeros
+    %scaled = mul i64 %bits, 1233 ; 1233 / 4096 is just over log10(2)
+    %estimate = lshr i64 %scaled, 12
+    %power_pointer = getelementptr [20 x i64], [20 x i64]* @.io_powers_of_10, i64 0, i64 %estimate
+    %power = load i64, i64* %power_pointer
+    %over_estimate = icmp ult i64 %nonzero, %power
+    %correction = zext i1 %over_estimate to i64
+    %estimated_digits = add i64 %estimate, 1
+    %digits = sub i64 %estimated_digits, %correction
+
+    ret i64 %digits
+}
+
+; Writes the decimal digits of an unsigned integer, 2 at a time, so they
+; end just before 'end'.
+define private void @io_SEP__write_digits(i8* %end, i64 %value) nounwind {
+entry:
+    %pairs = bitcast <{ [100 x i8], [100 x i8] }>* @.io_digit_pairs to i8*
+    br label %condition
+
+condition:
+    %remaining = phi i64 [ %value, %entry ], [ %quotient, %write_pair ]
+    %position = phi i8* [ %end, %entry ], [ %pair_destination, %write_pair ]
+    %has_pairs = icmp uge i64 %remaining, 100
+    br i1 %has_pairs, label %write_pair, label %write_last
+
+write_pair:
+    %quotient = udiv i64 %remaining, 100
+    %hundreds = mul i64 %quotient, 100
+    %pair = sub i64 %remaining, %hundreds
+    %pair_offset = shl i64 %pair, 1
+    %pair_source = getelementptr i8, i8* %pairs, i64 %pair_offset
+    %pair_destination = getelementptr i8, i8* %position, i64 -2
+    call void @llvm.memcpy.p0i8.p0i8.i64(i8* %pair_destination, i8* %pair_source, i64 2, i1 false)
+    br label %condition
+
+write_last:
+    %is_pair = icmp uge i64 %remaining, 10
+    br i1 %is_pair, label %write_last_pair, label %write_digit
+
+write_last_pair:
+    %last_offset = shl i64 %remaining, 1
+    %last_source = getelementptr i8, i8* %pairs, i64 %last_offset
+    %last_destination = getelementptr i8, i8* %position, i64 -2
+    call void @llvm.memcpy.p0i8.p0i8.i64(i8* %last_destination, i8* %last_source, i64 2, i1 false)
+    br label %exit
+
+write_digit:
+    %digit = trunc i64 %remaining to i8
+    %digit_character = add i8 %digit, 48 ; '0'
+    %digit_destination = getelementptr i8, i8* %position, i64 -1
+    store i8 %digit_character, i8* %digit_destination
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Formats an integer in decimal, straight into 'destination', which needs
+; room for 20 characters. Returns how many were written.
+define private i64 @io_SEP__format_int(i8* %destination, i64 %value) nounwind {
+entry:
+    %negative = icmp slt i64 %value, 0
+    %negated = sub i64 0, %value
+    %magnitude = select i1 %negative, i64 %negated, i64 %value ; Unsigned, so the most negative value fits
+    %sign = zext i1 %negative to i64
+    store i8 45, i8* %destination ; '-', overwritten by the digits when positive
+    %start = getelementptr i8, i8* %destination, i64 %sign
+    %digits = call i64 @io_SEP__count_digits(i64 %magnitude)
+    %end = getelementptr i8, i8* %start, i64 %digits
+    call void @io_SEP__write_digits(i8* %end, i64 %magnitude)
+    %written = add i64 %sign, %digits
+
+    ret i64 %written
+}
+
+; Multiplies a 126 bit power of 10 by 'scaled', keeping the top 64 bits, and
+; sets the lowest bit when any bits below are set, so the result rounds to
+; odd.
+define private i64 @io_SEP__round_to_odd(i64 %high, i64 %low, i64 %scaled) nounwind readnone alwaysinline {
+    %scaled_wide = zext i64 %scaled to i128
+    %low_wide = zext i64 %low to i128
+    %low_product = mul i128 %low_wide, %scaled_wide
+    %low_product_high = lshr i128 %low_product, 64
+    %x1 = trunc i128 %low_product_high to i64
+    %high_wide = zext i64 %high to i128
+    %high_product = mul i128 %high_wide, %scaled_wide
+    %y0 = trunc i128 %high_product to i64
+    %high_product_high = lshr i128 %high_product, 64
+    %y1 = trunc i128 %high_product_high to i64
+
+    %y0_halved = lshr i64 %y0, 1
+    %z = add i64 %y0_halved, %x1
+    %carry = lshr i64 %z, 63
+    %truncated = add i64 %y1, %carry
+    %z_low = and i64 %z, 9223372036854775807
+    %z_low_nonzero = add i64 %z_low, 9223372036854775807
+    %sticky = lshr i64 %z_low_nonzero, 63
+
+    %rounded = or i64 %truncated, %sticky
+
+    ret i64 %rounded
+}
+
+; Finds the shortest decimal, digits * 10^exponent, which reads back as a
+; positive, finite, nonzero float, given its bits, with Schubfach. That is
+; exact, unlike trying more digits until it reads back, and needs no big
+; integers, unlike Dragon4. The digits may have trailing zeros.
+define private { i64, i64 } @io_SEP__shortest(i64 %bits) nounwind readonly {
+entry:
+    %biased_exponent = lshr i64 %bits, 52
+    %fraction = and i64 %bits, 4503599627370495 ; 2^52 - 1
+    %is_normal = icmp ne i64 %biased_exponent, 0
+    br i1 %is_normal, label %normal, label %subnormal
+
+normal:
+    %significand = or i64 %fraction, 4503599627370496 ; The implicit 2^52
+    %shift = sub i64 1075, %biased_exponent
+    %shift_positive = icmp sgt i64 %shift, 0
+    %shift_small = icmp slt i64 %shift, 53
+    %may_be_integer = and i1 %shift_positive, %shift_small
+    br i1 %may_be_integer, label %integer_check, label %normal_decimal
+
+integer_check: ; Integers below 2^53 are their own shortest decimal
+    %integer = lshr i64 %significand, %shift
+    %restored = shl i64 %integer, %shift
+    %is_integer = icmp eq i64 %restored, %significand
+    br i1 %is_integer, label %exit, label %normal_decimal
+
+normal_decimal:
+    %normal_q = sub i64 0, %shift
+    br label %decimal
+
+subnormal:
+    br label %decimal
+
+decimal: ; The float is c * 2^q
+    %q = phi i64 [ %normal_q, %normal_decimal ], [ -1074, %subnormal ]
+    %c = phi i64 [ %significand, %normal_decimal ], [ %fraction, %subnormal ]
+    %out = and i64 %c, 1 ; Odd significands exclude the bounds of their rounding interval
+    %cb = shl i64 %c, 2
+    %cbr = add i64 %cb, 2
+    %is_not_power_of_2 = icmp ne i64 %c, 4503599627370496
+    %is_min_q = icmp eq i64 %q, -1074
+    %is_symmetric = or i1 %is_not_power_of_2, %is_min_q ; Else the float below is closer than the one above
+    %symmetric_cbl = sub i64 %cb, 2
+    %closer_cbl = sub i64 %cb, 1
+    %cbl = select i1 %is_symmetric, i64 %symmetric_cbl, i64 %closer_cbl
+    %q_log10 = mul i64 %q, 661971961083 ; floor(log10(2^q)) * 2^41
+    %q_three_quarters_log10 = sub i64 %q_log10, 274743187321 ; floor(log10(3/4 2^q)) * 2^41
+    %k_scaled = select i1 %is_symmetric, i64 %q_log10, i64 %q_three_quarters_log10
+    %k = ashr i64 %k_scaled, 41
+    %negative_k = sub i64 0, %k
+    %power_log2_scaled = mul i64 %negative_k, 913124641741 ; floor(log2(10^-k)) * 2^38
+    %power_log2 = ashr i64 %power_log2_scaled, 38
+    %h_partial = add i64 %q, %power_log2
+    %h = add i64 %h_partial, 2
+
+    %power_index = add i64 %negative_k, 292
+    %high_index = shl i64 %power_index, 1
+    %high_pointer = getelementptr [1234 x i64], [1234 x i64]* @.io_power_significands, i64 0, i64 %high_index
+    %high = load i64, i64* %high_pointer
+    %low_pointer = getelementptr i64, i64* %high_pointer, i64 1
+    %low = load i64, i64* %low_pointer
+
+    %cb_scaled = shl i64 %cb, %h
+    %vb = call i64 @io_SEP__round_to_odd(i64 %high, i64 %low, i64 %cb_scaled)
+    %cbl_scaled = shl i64 %cbl, %h
+    %vbl = call i64 @io_SEP__round_to_odd(i64 %high, i64 %low, i64 %cbl_scaled)
+    %cbr_scaled = shl i64 %cbr, %h
+    %vbr = call i64 @io_SEP__round_to_odd(i64 %high, i64 %low, i64 %cbr_scaled)
+    %lower = add i64 %vbl, %out
+    %s = lshr i64 %vb, 2
+    %has_tens = icmp uge i64 %s, 100
+    br i1 %has_tens, label %tens, label %units
+
+tens: ; Whether exactly one multiple of 10 next to s is in the rounding interval
+    %s_tens = udiv i64 %s, 10
+    %sp10 = mul i64 %s_tens, 10
+    %tp10 = add i64 %sp10, 10
+    %sp10_scaled = shl i64 %sp10, 2
+    %sp10_inside = icmp ule i64 %lower, %sp10_scaled
+    %tp10_scaled = shl i64 %tp10, 2
+    %tp10_upper = add i64 %tp10_scaled, %out
+    %tp10_inside = icmp ule i64 %tp10_upper, %vbr
+    %one_ten_inside = xor i1 %sp10_inside, %tp10_inside
+    %ten_digits = select i1 %sp10_inside, i64 %sp10, i64 %tp10
+    br i1 %one_ten_inside, label %exit, label %units
+
+units: ; Whether exactly one of s and s + 1 is
+    %s_scaled = shl i64 %s, 2
+    %s_inside = icmp ule i64 %lower, %s_scaled
+    %s_next = add i64 %s, 1
+    %s_next_scaled = shl i64 %s_next, 2
+    %s_next_upper = add i64 %s_next_scaled, %out
+    %s_next_inside = icmp ule i64 %s_next_upper, %vbr
+    %one_inside = xor i1 %s_inside, %s_next_inside
+    %unit_digits = select i1 %s_inside, i64 %s, i64 %s_next
+    br i1 %one_inside, label %exit, label %closest
+
+closest: ; Both are, so whichever is closer, or even when tied
+    %s_doubled = shl i64 %s, 1
+    %midpoint_halved = or i64 %s_doubled, 1
+    %midpoint = shl i64 %midpoint_halved, 1
+    %difference = sub i64 %vb, %midpoint
+    %is_below = icmp slt i64 %difference, 0
+    %is_tie = icmp eq i64 %difference, 0
+    %s_odd = and i64 %s, 1
+    %s_even = icmp eq i64 %s_odd, 0
+    %tie_down = and i1 %is_tie, %s_even
+    %round_down = or i1 %is_below, %tie_down
+    %closest_digits = select i1 %round_down, i64 %s, i64 %s_next
+    br label %exit
+
+exit:
+    %digits = phi i64 [ %integer, %integer_check ], [ %ten_digits, %tens ], [ %unit_digits, %units ],
+                      [ %closest_digits, %closest ]
+    %exponent = phi i64 [ 0, %integer_check ], [ %k, %tens ], [ %k, %units ], [ %k, %closest ]
+    %with_digits = insertvalue { i64, i64 } undef, i64 %digits, 0
+    %decimal_value = insertvalue { i64, i64 } %with_digits, i64 %exponent, 1
+
+    ret { i64, i64 } %decimal_value
+}
+
+; Formats a float with the fewest digits which read back as the same float,
+; straight into 'destination', which needs room for 24 characters. Like
+; '%g', it uses an exponent for those below 1e-4, or of at least 1e16.
+; Returns how many characters were written.
+define private i64 @io_SEP__format_float(i8* %destination, double %value) nounwind {
+entry:
+    %bits = bitcast double %value to i64
+    %negative = icmp slt i64 %bits, 0
+    %sign = zext i1 %negative to i64
+    store i8 45, i8* %destination ; '-', overwritten when positive
+    %start = getelementptr i8, i8* %destination, i64 %sign
+    %magnitude_bits = and i64 %bits, 9223372036854775807
+    %is_zero = icmp eq i64 %magnitude_bits, 0
+    br i1 %is_zero, label %zero, label %check_finite
+
+zero:
+    store i8 48, i8* %start ; '0'
+    br label %exit
+
+check_finite:
+    %is_special = icmp uge i64 %magnitude_bits, 9218868437227405312 ; Exponent bits all set
+    br i1 %is_special, label %special, label %finite
+
+special:
+    %is_nan = icmp ugt i64 %magnitude_bits, 9218868437227405312
+    %nan = getelementptr [3 x i8], [3 x i8]* @.io_nan, i64 0, i64 0
+    %inf = getelementptr [3 x i8], [3 x i8]* @.io_inf, i64 0, i64 0
+    %special_text = select i1 %is_nan, i8* %nan, i8* %inf
+    call void @llvm.memcpy.p0i8.p0i8.i64(i8* %start, i8* %special_text, i64 3, i1 false)
+    br label %exit
+
+finite:
+    %decimal_value = call { i64, i64 } @io_SEP__shortest(i64 %magnitude_bits)
+    %shortest_digits = extractvalue { i64, i64 } %decimal_value, 0
+    %shortest_exponent = extractvalue { i64, i64 } %decimal_value, 1
+    br label %strip
+
+strip:
+    %digits = phi i64 [ %shortest_digits, %finite ], [ %stripped_digits, %strip_zero ]
+    %exponent = phi i64 [ %shortest_exponent, %finite ], [ %stripped_exponent, %strip_zero ]
+    %stripped_digits = udiv i64 %digits, 10
+    %tens = mul i64 %stripped_digits, 10
+    %has_trailing_zero = icmp eq i64 %tens, %digits
+    br i1 %has_trailing_zero, label %strip_zero, label %place
+
+strip_zero:
+    %stripped_exponent = add i64 %exponent, 1
+    br label %strip
+
+place: ; The decimal point goes after 'point' digits
+    %count = call i64 @io_SEP__count_digits(i64 %digits)
+    %point = add i64 %count, %exponent
+    %too_small = icmp slt i64 %point, -3
+    %too_large = icmp sgt i64 %point, 16
+    %is_scientific = or i1 %too_small, %too_large
+    br i1 %is_scientific, label %scientific, label %check_fraction
+
+scientific: ; "d.ddde+XX"
+    %after_first = getelementptr i8, i8* %start, i64 1
+    %scientific_end = getelementptr i8, i8* %after_first, i64 %count
+    call void @io_SEP__write_digits(i8* %scientific_end, i64 %digits)
+    %first_digit = load i8, i8* %after_first
+    store i8 %first_digit, i8* %start
+    store i8 46, i8* %after_first ; '.', overwritten by the exponent without a fraction
+    %has_fraction = icmp ugt i64 %count, 1
+    %fraction_length = add i64 %count, 1
+    %mantissa_length = select i1 %has_fraction, i64 %fraction_length, i64 1
+    %e_pointer = getelementptr i8, i8* %start, i64 %mantissa_length
+    store i8 101, i8* %e_pointer ; 'e'
+    %power = sub i64 %point, 1
+    %power_negative = icmp slt i64 %power, 0
+    %power_sign = select i1 %power_negative, i8 45, i8 43 ; '-' or '+'
+    %power_sign_pointer = getelementptr i8, i8* %e_pointer, i64 1
+    store i8 %power_sign, i8* %power_sign_pointer
+    %power_negated = sub i64 0, %power
+    %power_magnitude = select i1 %power_negative, i64 %power_negated, i64 %power
+    %power_count = call i64 @io_SEP__count_digits(i64 %power_magnitude)
+    %power_short = icmp ult i64 %power_count, 2
+    %power_length = select i1 %power_short, i64 2, i64 %power_count ; At least 2 digits, like '%g'
+    %power_digits = getelementptr i8, i8* %e_pointer, i64 2
+    store i8 48, i8* %power_digits ; '0', overwritten when there are 2 digits
+    %power_end = getelementptr i8, i8* %power_digits, i64 %power_length
+    call void @io_SEP__write_digits(i8* %power_end, i64 %power_magnitude)
+    %scientific_length_partial = add i64 %mantissa_length, 2
+    %scientific_length = add i64 %scientific_length_partial, %power_length
+    br label %exit
+
+check_fraction:
+    %is_fraction = icmp sle i64 %point, 0
+    br i1 %is_fraction, label %fraction, label %check_integer
+
+fraction: ; "0.000ddd"
+    store i8 48, i8* %start ; '0'
+    %fraction_point = getelementptr i8, i8* %start, i64 1
+    store i8 46, i8* %fraction_point ; '.'
+    %fraction_zeros = getelementptr i8, i8* %start, i64 2
+    %zeros = sub i64 0, %point
+    call void @llvm.memset.p0i8.i64(i8* %fraction_zeros, i8 48, i64 %zeros, i1 false)
+    %fraction_prefix = add i64 %zeros, 2
+    %fraction_digits_length = add i64 %fraction_prefix, %count
+    %fraction_end = getelementptr i8, i8* %start, i64 %fraction_digits_length
+    call void @io_SEP__write_digits(i8* %fraction_end, i64 %digits)
+    br label %exit
+
+check_integer:
+    %is_integer = icmp sle i64 %count, %point
+    br i1 %is_integer, label %integer, label %decimal
+
+integer: ; "ddd000"
+    %integer_end = getelementptr i8, i8* %start, i64 %count
+    call void @io_SEP__write_digits(i8* %integer_end, i64 %digits)
+    %trailing_zeros = sub i64 %point, %count
+    call void @llvm.memset.p0i8.i64(i8* %integer_end, i8 48, i64 %trailing_zeros, i1 false)
+    br label %exit
+
+decimal: ; "ddd.ddd", written one character late then moved back to make room for the point
+    %decimal_digits = getelementptr i8, i8* %start, i64 1
+    %decimal_end = getelementptr i8, i8* %decimal_digits, i64 %count
+    call void @io_SEP__write_digits(i8* %decimal_end, i64 %digits)
+    call void @llvm.memmove.p0i8.p0i8.i64(i8* %start, i8* %decimal_digits, i64 %point, i1 false)
+    %decimal_point = getelementptr i8, i8* %start, i64 %point
+    store i8 46, i8* %decimal_point ; '.'
+    %decimal_length = add i64 %count, 1
+    br label %exit
+
+exit:
+    %length = phi i64 [ 1, %zero ], [ 3, %special ], [ %scientific_length, %scientific ],
+                      [ %fraction_digits_length, %fraction ], [ %point, %integer ], [ %decimal_length, %decimal ]
+    %written = add i64 %sign, %length
+
+    ret i64 %written
+}
+
+; Makes room for at least 'count' more bytes in a stream's buffer, flushing
+; it if needed, and gets where they go.
+define private i8* @io_SEP_Stream_SEP__reserve(%io_SEP_Stream* %self, i64 %count) nounwind {
+entry:
+    %capacity_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 2
+    %initial_capacity = load i64, i64* %capacity_pointer
+    %is_open = icmp ne i64 %initial_capacity, 0
+    br i1 %is_open, label %check_space, label %open
+
+open:
+    call void @io_SEP_Stream_SEP__open(%io_SEP_Stream* %self)
+    br label %check_space
+
+check_space:
+    %length_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 1
+    %length = load i64, i64* %length_pointer
+    %capacity = load i64, i64* %capacity_pointer
+    %space = sub i64 %capacity, %length
+    %fits = icmp ule i64 %count, %space
+    br i1 %fits, label %exit, label %flush
+
+flush:
+    call void @io_SEP_Stream_SEP_flush(%io_SEP_Stream* %self)
+    br label %exit
+
+exit:
+    %buffer_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 0
+    %buffer = load i8*, i8** %buffer_pointer
+    %end_length = load i64, i64* %length_pointer
+    %end = getelementptr i8, i8* %buffer, i64 %end_length
+
+    ret i8* %end
+}
+
+; Adds to the length of a stream's buffer, once bytes are written after it.
+define private void @io_SEP_Stream_SEP__extend(%io_SEP_Stream* %self, i64 %count) nounwind alwaysinline {
+    %length_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 1
+    %length = load i64, i64* %length_pointer
+    %new_length = add i64 %length, %count
+    store i64 %new_length, i64* %length_pointer
+
+    ret void
+}
+
+; Ends a line written straight into a stream's buffer, at 'end', after
+; 'count' bytes, flushing it for terminals.
+define private void @io_SEP_Stream_SEP__end_line(%io_SEP_Stream* %self, i8* %end, i64 %count) nounwind {
+entry:
+    store i8 10, i8* %end ; '\n'
+    %line_length = add i64 %count, 1
+    call void @io_SEP_Stream_SEP__extend(%io_SEP_Stream* %self, i64 %line_length)
+    %flush_lines_pointer = getelementptr %io_SEP_Stream, %io_SEP_Stream* %self, i64 0, i32 4
+    %flush_lines = load i1, i1* %flush_lines_pointer
+    br i1 %flush_lines, label %flush, label %exit
+
+flush:
+    call void @io_SEP_Stream_SEP_flush(%io_SEP_Stream* %self)
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Writes an integer to a stream, in decimal, straight into its buffer.
+define void @io_SEP_Stream_SEP_write_int(%io_SEP_Stream* %self, i64 %value) nounwind {
+    %end = call i8* @io_SEP_Stream_SEP__reserve(%io_SEP_Stream* %self, i64 20)
+    %written = call i64 @io_SEP__format_int(i8* %end, i64 %value)
+    call void @io_SEP_Stream_SEP__extend(%io_SEP_Stream* %self, i64 %written)
+
+    ret void
+}
+
+; Writes a float to a stream, with the fewest digits which read back as the
+; same float, straight into its buffer.
+define void @io_SEP_Stream_SEP_write_float(%io_SEP_Stream* %self, double %value) nounwind {
+    %end = call i8* @io_SEP_Stream_SEP__reserve(%io_SEP_Stream* %self, i64 24)
+    %written = call i64 @io_SEP__format_float(i8* %end, double %value)
+    call void @io_SEP_Stream_SEP__extend(%io_SEP_Stream* %self, i64 %written)
+
+    ret void
+}
+
+; Writes an integer and a newline to this thread's stdout.
+define void @io_SEP_out_int(i64 %value) nounwind {
+    %end = call i8* @io_SEP_Stream_SEP__reserve(%io_SEP_Stream* @io_stdout, i64 21)
+    %written = call i64 @io_SEP__format_int(i8* %end, i64 %value)
+    %line_end = getelementptr i8, i8* %end, i64 %written
+    call void @io_SEP_Stream_SEP__end_line(%io_SEP_Stream* @io_stdout, i8* %line_end, i64 %written)
+
+    ret void
+}
+
+; Writes a float and a newline to this thread's stdout.
+define void @io_SEP_out_float(double %value) nounwind {
+    %end = call i8* @io_SEP_Stream_SEP__reserve(%io_SEP_Stream* @io_stdout, i64 25)
+    %written = call i64 @io_SEP__format_float(i8* %end, double %value)
+    %line_end = getelementptr i8, i8* %end, i64 %written
+    call void @io_SEP_Stream_SEP__end_line(%io_SEP_Stream* @io_stdout, i8* %line_end, i64 %written)
+
+    ret void
+}
+
+; std.io's driver for async executors. Coroutines wait for file descriptors
+; to be ready with 'io_SEP_wait', and when the executor has none ready to
+; resume, one 'poll' of every descriptor waited on wakes those that are.
+%io_SEP_Poller = type {
+    %io_SEP_PollFd*,        ; 0: _polled - the descriptors waited on
+    %async_SEP_Waiter**,    ; 1: _waiters - the waiter for each descriptor
+    i64,                    ; 2: _length
+    i64                     ; 3: _capacity
+}
+
+; A descriptor to poll, laid out as a 'struct pollfd'.
+%io_SEP_PollFd = type {
+    i32,    ; 0: fd
+    i16,    ; 1: events - what to wait for
+    i16     ; 2: revents - what happened
+}
+
+%async_SEP_Waiter = type { i8*, %async_SEP_Waiter*, i64 } ; See 'runtime-llvm-ir/async.ll'
+%async_SEP_Executor = type opaque
+
+@io_poller = internal thread_local global %io_SEP_Poller zeroinitializer
+
+declare i32 @poll(%io_SEP_PollFd*, i64, i32)
+declare i32* @__errno_location()
+declare %async_SEP_Executor* @async_SEP_executor()
+declare void @async_SEP_Executor_SEP_set_driver(%async_SEP_Executor*, i64 (%async_SEP_Executor*, i8*, i1)*, i8*)
+declare void @async_SEP_Executor_SEP_wake(%async_SEP_Executor*, %async_SEP_Waiter*)
+
+; Waits for a file descriptor to have any of 'events', POLLIN (1) or
+; POLLOUT (4), from the coroutine 'waiter' is for, which suspends after
+; calling this. The executor entered on this thread resumes it once the
+; descriptor is ready, with the events polled as the waiter's result, which
+; may be POLLERR (8) or POLLHUP (16) instead.
+define void @io_SEP_wait(i32 %fd, i16 %events, %async_SEP_Waiter* %waiter) nounwind {
+entry:
+    %polled_pointer = getelementptr %io_SEP_Poller, %io_SEP_Poller* @io_poller, i64 0, i32 0
+    %waiters_pointer = getelementptr %io_SEP_Poller, %io_SEP_Poller* @io_poller, i64 0, i32 1
+    %length_pointer = getelementptr %io_SEP_Poller, %io_SEP_Poller* @io_poller, i64 0, i32 2
+    %capacity_pointer = getelementptr %io_SEP_Poller, %io_SEP_Poller* @io_poller, i64 0, i32 3
+    %length = load i64, i64* %length_pointer
+    %capacity = load i64, i64* %capacity_pointer
+    %is_full = icmp eq i64 %length, %capacity
+    br i1 %is_full, label %grow, label %add
+
+grow: ; Doubling, from 16
+    %doubled = shl i64 %capacity, 1
+    %is_first = icmp eq i64 %capacity, 0
+    %new_capacity = select i1 %is_first, i64 16, i64 %doubled
+    %polled_size = mul i64 %new_capacity, 8
+    %old_polled = load %io_SEP_PollFd*, %io_SEP_PollFd** %polled_pointer
+    %old_polled_bytes = bitcast %io_SEP_PollFd* %old_polled to i8*
+    %grown_polled_bytes = call i8* @realloc(i8* %old_polled_bytes, i64 %polled_size)
+    %grown_polled = bitcast i8* %grown_polled_bytes to %io_SEP_PollFd*
+    store %io_SEP_PollFd* %grown_polled, %io_SEP_PollFd** %polled_pointer
+    %old_waiters = load %async_SEP_Waiter**, %async_SEP_Waiter*** %waiters_pointer
+    %old_waiters_bytes = bitcast %async_SEP_Waiter** %old_waiters to i8*
+    %grown_waiters_bytes = call i8* @realloc(i8* %old_waiters_bytes, i64 %polled_size)
+    %grown_waiters = bitcast i8* %grown_waiters_bytes to %async_SEP_Waiter**
+    store %async_SEP_Waiter** %grown_waiters, %async_SEP_Waiter*** %waiters_pointer
+    store i64 %new_capacity, i64* %capacity_pointer
+    br label %add
+
+add:
+    %polled = load %io_SEP_PollFd*, %io_SEP_PollFd** %polled_pointer
+    %entry_pointer = getelementptr %io_SEP_PollFd, %io_SEP_PollFd* %polled, i64 %length
+    %with_fd = insertvalue %io_SEP_PollFd zeroinitializer, i32 %fd, 0
+    %poll_entry = insertvalue %io_SEP_PollFd %with_fd, i16 %events, 1
+    store %io_SEP_PollFd %poll_entry, %io_SEP_PollFd* %entry_pointer
+    %waiters = load %async_SEP_Waiter**, %async_SEP_Waiter*** %waiters_pointer
+    %waiter_pointer = getelementptr %async_SEP_Waiter*, %async_SEP_Waiter** %waiters, i64 %length
+    store %async_SEP_Waiter* %waiter, %async_SEP_Waiter** %waiter_pointer
+    %new_length = add i64 %length, 1
+    store i64 %new_length, i64* %length_pointer
+
+    %executor = call %async_SEP_Executor* @async_SEP_executor()
+    %context = bitcast %io_SEP_Poller* @io_poller to i8*
+    call void @async_SEP_Executor_SEP_set_driver(%async_SEP_Executor* %executor,
+                                                 i64 (%async_SEP_Executor*, i8*, i1)* @io_SEP__drive, i8* %context)
+
+    ret void
+}
+
+; Polls the descriptors waited on, blocking until one is ready if told to,
+; and wakes the waiters of those that are. Returns how many were woken.
+define private i64 @io_SEP__drive(%async_SEP_Executor* %executor, i8* %context, i1 %block) nounwind {
+entry:
+    %poller = bitcast i8* %context to %io_SEP_Poller*
+    %polled_pointer = getelementptr %io_SEP_Poller, %io_SEP_Poller* %poller, i64 0, i32 0
+    %waiters_pointer = getelementptr %io_SEP_Poller, %io_SEP_Poller* %poller, i64 0, i32 1
+    %length_pointer = getelementptr %io_SEP_Poller, %io_SEP_Poller* %poller, i64 0, i32 2
+    %length = load i64, i64* %length_pointer
+    %is_empty = icmp eq i64 %length, 0
+    %timeout = select i1 %block, i32 -1, i32 0
+    br i1 %is_empty, label %exit, label %poll
+
+poll:
+    %polled = load %io_SEP_PollFd*, %io_SEP_PollFd** %polled_pointer
+    %ready = call i32 @poll(%io_SEP_PollFd* %polled, i64 %length, i32 %timeout)
+    %failed = icmp slt i32 %ready, 0
+    br i1 %failed, label %check_interrupted, label %scan
+
+check_interrupted:
+    %errno_pointer = call i32* @__errno_location()
+    %errno = load i32, i32* %errno_pointer
+    %is_interrupted = icmp eq i32 %errno, 4 ; EINTR
+    br i1 %is_interrupted, label %poll, label %exit
+
+scan:
+    %waiters = load %async_SEP_Waiter**, %async_SEP_Waiter*** %waiters_pointer
+    br label %scan_condition
+
+scan_condition: ; Backwards, so ready entries can be swapped with the last one, which was already looked at
+    %index = phi i64 [ %length, %scan ], [ %previous_index, %scan_next ]
+    %remaining = phi i64 [ %length, %scan ], [ %next_remaining, %scan_next ]
+    %woken = phi i64 [ 0, %scan ], [ %next_woken, %scan_next ]
+    %is_scanning = icmp ne i64 %index, 0
+    br i1 %is_scanning, label %check, label %finish
+
+check:
+    %previous_index = sub i64 %index, 1
+    %entry_pointer = getelementptr %io_SEP_PollFd, %io_SEP_PollFd* %polled, i64 %previous_index
+    %revents_pointer = getelementptr %io_SEP_PollFd, %io_SEP_PollFd* %entry_pointer, i64 0, i32 2
+    %revents = load i16, i16* %revents_pointer
+    %is_ready = icmp ne i16 %revents, 0
+    br i1 %is_ready, label %wake, label %scan_next
+
+wake:
+    %waiter_pointer = getelementptr %async_SEP_Waiter*, %async_SEP_Waiter** %waiters, i64 %previous_index
+    %waiter = load %async_SEP_Waiter*, %async_SEP_Waiter** %waiter_pointer
+    %result_pointer = getelementptr %async_SEP_Waiter, %async_SEP_Waiter* %waiter, i64 0, i32 2
+    %result = zext i16 %revents to i64
+    store i64 %result, i64* %result_pointer
+    call void @async_SEP_Executor_SEP_wake(%async_SEP_Executor* %executor, %async_SEP_Waiter* %waiter)
+
+    %last_index = sub i64 %remaining, 1
+    %last_entry_pointer = getelementptr %io_SEP_PollFd, %io_SEP_PollFd* %polled, i64 %last_index
+    %last_entry = load %io_SEP_PollFd, %io_SEP_PollFd* %last_entry_pointer
+    store %io_SEP_PollFd %last_entry, %io_SEP_PollFd* %entry_pointer
+    %last_waiter_pointer = getelementptr %async_SEP_Waiter*, %async_SEP_Waiter** %waiters, i64 %last_index
+    %last_waiter = load %async_SEP_Waiter*, %async_SEP_Waiter** %last_waiter_pointer
+    store %async_SEP_Waiter* %last_waiter, %async_SEP_Waiter** %waiter_pointer
+    %woken_one = add i64 %woken, 1
+    br label %scan_next
+
+scan_next:
+    %next_remaining = phi i64 [ %remaining, %check ], [ %last_index, %wake ]
+    %next_woken = phi i64 [ %woken, %check ], [ %woken_one, %wake ]
+    br label %scan_condition
+
+finish:
+    store i64 %remaining, i64* %length_pointer
+    br label %exit
+
+exit:
+    %total = phi i64 [ 0, %entry ], [ 0, %check_interrupted ], [ %woken, %finish ]
+
+    ret i64 %total
+}
+
+; std.parallel, which runs loops' iterations across the scheduler's
+; workers. 'for i = prange(start, end)' is lowered to 'parallel_SEP_for',
+; with the loop's body as a function running the iterations from its first
+; index to before its second. Loops that only add to, or take the min or
+; max into, a variable are lowered to 'parallel_SEP_reduce' instead, with
+; the matching combinator.
+;
+; Loops are split lazily: a task runs its iterations a chunk at a time,
+; and before each chunk it splits the iterations it has left in half, for
+; other workers to steal, but only if its worker has no tasks queued
+; already. So loops are split as often as workers run out of work, however
+; uneven their iterations are, and not more.
+%parallel_SEP_Loop = type {
+    i64 (i8*, i64, i64)*,       ; 0: _body - runs iterations, returning what they combine to
+    i8*,                        ; 1: _context - passed to the body
+    i64 (i64, i64)*,            ; 2: _combine - combines 2 results
+    i64,                        ; 3: _identity - what combining with changes nothing
+    i64,                        ; 4: _chunk - iterations run between checks for whether to split
+    i64,                        ; 5: _pending - iterations not run yet, plus 1 until its caller waits
+    i64,                        ; 6: _result - what the iterations run so far combine to
+    %scheduler_SEP_Task*        ; 7: _waiter - the task which is waiting for it, or null for a thread
+}
+
+; Iterations split off a loop, for a task to run.
+%parallel_SEP_Range = type {
+    %parallel_SEP_Loop*,    ; 0: loop
+    i64,                    ; 1: start
+    i64                     ; 2: end
+}
+
+; A 'parallel_SEP_for' loop's body, for '_for_body' to run.
+%parallel_SEP_ForBody = type {
+    void (i8*, i64, i64)*,  ; 0: body
+    i8*                     ; 1: context
+}
+
+%scheduler_SEP_Task = type opaque
+
+@parallel_lock = internal global [5 x i64] zeroinitializer ; pthread_mutex_t, zeroed is initialised
+@parallel_done = internal global [6 x i64] zeroinitializer ; pthread_cond_t, broadcast when a loop finishes
+
+declare i32 @pthread_mutex_lock(i8*)
+declare i32 @pthread_mutex_unlock(i8*)
+declare i32 @pthread_cond_wait(i8*, i8*)
+declare i32 @pthread_cond_broadcast(i8*)
+declare %scheduler_SEP_Task* @scheduler_SEP_spawn(void (i8*)*, i8*)
+declare %scheduler_SEP_Task* @scheduler_SEP_current()
+declare i64 @scheduler_SEP_workers()
+declare i1 @scheduler_SEP_has_queued()
+declare void @scheduler_SEP_park()
+declare void @scheduler_SEP_unpark(%scheduler_SEP_Task*)
+
+; Adds two results, for loops summing their iterations.
+define i64 @parallel_SEP_sum(i64 %a, i64 %b) nounwind readnone {
+    %sum = add i64 %a, %b
+
+    ret i64 %sum
+}
+
+; Takes the smaller result, for loops finding their iterations' minimum.
+define i64 @parallel_SEP_min(i64 %a, i64 %b) nounwind readnone {
+    %is_less = icmp slt i64 %a, %b
+    %min = select i1 %is_less, i64 %a, i64 %b
+
+    ret i64 %min
+}
+
+; Takes the larger result, for loops finding their iterations' maximum.
+define i64 @parallel_SEP_max(i64 %a, i64 %b) nounwind readnone {
+    %is_greater = icmp sgt i64 %a, %b
+    %max = select i1 %is_greater, i64 %a, i64 %b
+
+    ret i64 %max
+}
+
+; Combines what some iterations combined to into a loop's result.
+define private void @parallel_SEP_Loop_SEP__add_result(%parallel_SEP_Loop* %self, i64 %value) nounwind {
+entry:
+    %combine_pointer = getelementptr %parallel_SEP_Loop, %parallel_SEP_Loop* %self, i64 0, i32 2
+    %combine = load i64 (i64, i64)*, i64 (i64, i64)** %combine_pointer
+    %result_pointer = getelementptr %parallel_SEP_Loop, %parallel_SEP_Loop* %self, i64 0, i32 6
+    %initial = load atomic i64, i64* %result_pointer monotonic, align 8
+    br label %exchange
+
+exchange:
+    %current = phi i64 [ %initial, %entry ], [ %seen, %exchange ]
+    %combined = call i64 %combine(i64 %current, i64 %value)
+    %exchanged = cmpxchg i64* %result_pointer, i64 %current, i64 %combined acq_rel monotonic
+    %seen = extractvalue { i64, i1 } %exchanged, 0
+    %is_exchanged = extractvalue { i64, i1 } %exchanged, 1
+    br i1 %is_exchanged, label %exit, label %exchange
+
+exit:
+    ret void
+}
+
+; Counts 'count' of a loop's iterations as run, waking whatever is waiting
+; for it if they were the last.
+define private void @parallel_SEP_Loop_SEP__finish(%parallel_SEP_Loop* %self, i64 %count) nounwind {
+entry:
+    ; Loaded first, as the loop may be gone once the waiter sees it finished
+    %waiter_pointer = getelementptr %parallel_SEP_Loop, %parallel_SEP_Loop* %self, i64 0, i32 7
+    %waiter = load %scheduler_SEP_Task*, %scheduler_SEP_Task** %waiter_pointer
+    %pending_pointer = getelementptr %parallel_SEP_Loop, %parallel_SEP_Loop* %self, i64 0, i32 5
+    %pending = atomicrmw sub i64* %pending_pointer, i64 %count acq_rel
+    %is_last = icmp eq i64 %pending, %count
+    br i1 %is_last, label %check_waiter, label %exit
+
+check_waiter:
+    %is_task = icmp ne %scheduler_SEP_Task* %waiter, null
+    br i1 %is_task, label %unpark, label %broadcast
+
+unpark:
+    call void @scheduler_SEP_unpark(%scheduler_SEP_Task* %waiter)
+    br label %exit
+
+broadcast:
+    %lock_bytes = bitcast [5 x i64]* @parallel_lock to i8*
+    %done_bytes = bitcast [6 x i64]* @parallel_done to i8*
+    call i32 @pthread_mutex_lock(i8* %lock_bytes)
+    call i32 @pthread_cond_broadcast(i8* %done_bytes)
+    call i32 @pthread_mutex_unlock(i8* %lock_bytes)
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Runs a loop's iterations from 'start' to before 'end', a chunk at a time,
+; splitting off the second half of those left before each chunk while the
+; worker has no tasks queued for others to steal.
+define private void @parallel_SEP_Loop_SEP__run(%parallel_SEP_Loop* %self, i64 %start, i64 %end) nounwind {
+entry:
+    %body_pointer = getelementptr %parallel_SEP_Loop, %parallel_SEP_Loop* %self, i64 0, i32 0
+    %body = load i64 (i8*, i64, i64)*, i64 (i8*, i64, i64)** %body_pointer
+    %context_pointer = getelementptr %parallel_SEP_Loop, %parallel_SEP_Loop* %self, i64 0, i32 1
+    %context = load i8*, i8** %context_pointer
+    %combine_pointer = getelementptr %parallel_SEP_Loop, %parallel_SEP_Loop* %self, i64 0, i32 2
+    %combine = load i64 (i64, i64)*, i64 (i64, i64)** %combine_pointer
+    %identity_pointer = getelementptr %parallel_SEP_Loop, %parallel_SEP_Loop* %self, i64 0, i32 3
+    %identity = load i64, i64* %identity_pointer
+    %chunk_pointer = getelementptr %parallel_SEP_Loop, %parallel_SEP_Loop* %self, i64 0, i32 4
+    %chunk = load i64, i64* %chunk_pointer
+    br label %condition
+
+condition:
+    %next = phi i64 [ %start, %entry ], [ %next, %split ], [ %chunk_end, %run_chunk ]
+    %last = phi i64 [ %end, %entry ], [ %middle, %split ], [ %last, %run_chunk ]
+    %result = phi i64 [ %identity, %entry ], [ %result, %split ], [ %chunk_combined, %run_chunk ]
+    %remaining = sub i64 %last, %next
+    %is_chunked = icmp ugt i64 %remaining, %chunk
+    br i1 %is_chunked, label %check_queued, label %run_rest
+
+check_queued:
+    %has_queued = call i1 @scheduler_SEP_has_queued()
+    br i1 %has_queued, label %run_chunk, label %split
+
+split:
+    %half = lshr i64 %remaining, 1
+    %middle = sub i64 %last, %half
+    %range_bytes = call i8* @malloc(i64 24)
+    %range = bitcast i8* %range_bytes to %parallel_SEP_Range*
+    %with_loop = insertvalue %parallel_SEP_Range zeroinitializer, %parallel_SEP_Loop* %self, 0
+    %with_start = insertvalue %parallel_SEP_Range %with_loop, i64 %middle, 1
+    %split_range = insertvalue %parallel_SEP_Range %with_start, i64 %last, 2
+    store %parallel_SEP_Range %split_range, %parallel_SEP_Range* %range
+    call %scheduler_SEP_Task* @scheduler_SEP_spawn(void (i8*)* @parallel_SEP__run_range, i8* %range_bytes)
+    br label %condition
+
+run_chunk:
+    %chunk_end = add i64 %next, %chunk
+    %chunk_result = call i64 %body(i8* %context, i64 %next, i64 %chunk_end)
+    %chunk_combined = call i64 %combine(i64 %result, i64 %chunk_result)
+    br label %condition
+
+run_rest:
+    %rest_result = call i64 %body(i8* %context, i64 %next, i64 %last)
+    %combined = call i64 %combine(i64 %result, i64 %rest_result)
+    call void @parallel_SEP_Loop_SEP__add_result(%parallel_SEP_Loop* %self, i64 %combined)
+    %ran = sub i64 %last, %start ; Those after 'last' were split off
+    call void @parallel_SEP_Loop_SEP__finish(%parallel_SEP_Loop* %self, i64 %ran)
+
+    ret void
+}
+
+; What tasks running iterations split off a loop run.
+define private void @parallel_SEP__run_range(i8* %argument) nounwind {
+    %range = bitcast i8* %argument to %parallel_SEP_Range*
+    %split_range = load %parallel_SEP_Range, %parallel_SEP_Range* %range
+    call void @free(i8* %argument)
+    %loop = extractvalue %parallel_SEP_Range %split_range, 0
+    %start = extractvalue %parallel_SEP_Range %split_range, 1
+    %end = extractvalue %parallel_SEP_Range %split_range, 2
+    call void @parallel_SEP_Loop_SEP__run(%parallel_SEP_Loop* %loop, i64 %start, i64 %end)
+
+    ret void
+}
+
+; Runs 'body' over the iterations from 'start' to before 'end' across the
+; workers, and combines what it returns for each range of them with
+; 'combine', such as 'parallel_SEP_sum', starting from 'identity'. Returns
+; once every iteration has run. Called from a task, it runs iterations
+; itself; called from outside of tasks, it blocks the thread.
+define i64 @parallel_SEP_reduce(i64 %start, i64 %end, i64 (i8*, i64, i64)* %body, i8* %context,
+                                i64 (i64, i64)* %combine, i64 %identity) nounwind {
+entry:
+    %loop = alloca %parallel_SEP_Loop
+    %is_empty = icmp sle i64 %end, %start
+    br i1 %is_empty, label %exit, label %start_loop
+
+start_loop:
+    ; Chunks of a 64th of each worker's share, so splitting is checked often enough to balance uneven iterations,
+    ; but not on every iteration. With one worker there is no one to split for.
+    %count = sub i64 %end, %start
+    %workers = call i64 @scheduler_SEP_workers()
+    %shares = mul i64 %workers, 64
+    %share = udiv i64 %count, %shares
+    %is_tiny = icmp eq i64 %share, 0
+    %at_least_one = select i1 %is_tiny, i64 1, i64 %share
+    %is_alone = icmp eq i64 %workers, 1
+    %chunk = select i1 %is_alone, i64 %count, i64 %at_least_one
+    %waiter = call %scheduler_SEP_Task* @scheduler_SEP_current()
+    %pending = add i64 %count, 1
+    %with_body = insertvalue %parallel_SEP_Loop zeroinitializer, i64 (i8*, i64, i64)* %body, 0
+    %with_context = insertvalue %parallel_SEP_Loop %with_body, i8* %context, 1
+    %with_combine = insertvalue %parallel_SEP_Loop %with_context, i64 (i64, i64)* %combine, 2
+    %with_identity = insertvalue %parallel_SEP_Loop %with_combine, i64 %identity, 3
+    %with_chunk = insertvalue %parallel_SEP_Loop %with_identity, i64 %chunk, 4
+    %with_pending = insertvalue %parallel_SEP_Loop %with_chunk, i64 %pending, 5
+    %with_result = insertvalue %parallel_SEP_Loop %with_pending, i64 %identity, 6
+    %initial = insertvalue %parallel_SEP_Loop %with_result, %scheduler_SEP_Task* %waiter, 7
+    store %parallel_SEP_Loop %initial, %parallel_SEP_Loop* %loop
+    %is_task = icmp ne %scheduler_SEP_Task* %waiter, null
+    br i1 %is_task, label %run, label %spawn
+
+run:
+    call void @parallel_SEP_Loop_SEP__run(%parallel_SEP_Loop* %loop, i64 %start, i64 %end)
+    br label %release
+
+spawn:
+    %range_bytes = call i8* @malloc(i64 24)
+    %range = bitcast i8* %range_bytes to %parallel_SEP_Range*
+    %with_loop = insertvalue %parallel_SEP_Range zeroinitializer, %parallel_SEP_Loop* %loop, 0
+    %with_start = insertvalue %parallel_SEP_Range %with_loop, i64 %start, 1
+    %whole_range = insertvalue %parallel_SEP_Range %with_start, i64 %end, 2
+    store %parallel_SEP_Range %whole_range, %parallel_SEP_Range* %range
+    call %scheduler_SEP_Task* @scheduler_SEP_spawn(void (i8*)* @parallel_SEP__run_range, i8* %range_bytes)
+    br label %release
+
+release: ; Of the caller's 1, after which whoever runs the last iterations wakes it
+    %pending_pointer = getelementptr %parallel_SEP_Loop, %parallel_SEP_Loop* %loop, i64 0, i32 5
+    %left = atomicrmw sub i64* %pending_pointer, i64 1 acq_rel
+    %is_finished = icmp eq i64 %left, 1
+    br i1 %is_finished, label %finished, label %wait
+
+wait:
+    br i1 %is_task, label %park, label %lock
+
+park: ; Once, as the task which runs the last iterations unparks it exactly once
+    call void @scheduler_SEP_park()
+    br label %finished
+
+lock:
+    %lock_bytes = bitcast [5 x i64]* @parallel_lock to i8*
+    %done_bytes = bitcast [6 x i64]* @parallel_done to i8*
+    call i32 @pthread_mutex_lock(i8* %lock_bytes)
+    br label %blocked_condition
+
+blocked_condition:
+    %blocked_pending = load atomic i64, i64* %pending_pointer acquire, align 8
+    %is_blocked_finished = icmp eq i64 %blocked_pending, 0
+    br i1 %is_blocked_finished, label %unlock, label %block
+
+block:
+    call i32 @pthread_cond_wait(i8* %done_bytes, i8* %lock_bytes)
+    br label %blocked_condition
+
+unlock:
+    call i32 @pthread_mutex_unlock(i8* %lock_bytes)
+    br label %finished
+
+finished:
+    %result_pointer = getelementptr %parallel_SEP_Loop, %parallel_SEP_Loop* %loop, i64 0, i32 6
+    %loop_result = load atomic i64, i64* %result_pointer acquire, align 8
+    br label %exit
+
+exit:
+    %result = phi i64 [ %identity, %entry ], [ %loop_result, %finished ]
+
+    ret i64 %result
+}
+
+; Runs a 'parallel_SEP_for' loop's body, which returns nothing to combine.
+define private i64 @parallel_SEP__for_body(i8* %context, i64 %start, i64 %end) nounwind {
+    %for_body = bitcast i8* %context to %parallel_SEP_ForBody*
+    %body_pointer = getelementptr %parallel_SEP_ForBody, %parallel_SEP_ForBody* %for_body, i64 0, i32 0
+    %body = load void (i8*, i64, i64)*, void (i8*, i64, i64)** %body_pointer
+    %body_context_pointer = getelementptr %parallel_SEP_ForBody, %parallel_SEP_ForBody* %for_body, i64 0, i32 1
+    %body_context = load i8*, i8** %body_context_pointer
+    call void %body(i8* %body_context, i64 %start, i64 %end)
+
+    ret i64 0
+}
+
+; Runs 'body' over the iterations from 'start' to before 'end' across the
+; workers, like 'parallel_SEP_reduce' without a result.
+define void @parallel_SEP_for(i64 %start, i64 %end, void (i8*, i64, i64)* %body, i8* %context) nounwind {
+    %for_body = alloca %parallel_SEP_ForBody
+    %with_body = insertvalue %parallel_SEP_ForBody zeroinitializer, void (i8*, i64, i64)* %body, 0
+    %initial = insertvalue %parallel_SEP_ForBody %with_body, i8* %context, 1
+    store %parallel_SEP_ForBody %initial, %parallel_SEP_ForBody* %for_body
+    %for_body_bytes = bitcast %parallel_SEP_ForBody* %for_body to i8*
+    call i64 @parallel_SEP_reduce(i64 %start, i64 %end, i64 (i8*, i64, i64)* @parallel_SEP__for_body,
+                                  i8* %for_body_bytes, i64 (i64, i64)* @parallel_SEP_sum, i64 0)
+
+    ret void
+}
+
+; std.sync's channels, bounded and for any number of tasks sending and
+; receiving, and queues, unbounded and for one task sending and one
+; receiving. Sending and receiving never lock: a lock only guards the tasks
+; waiting to, which are parked, and is only taken while there are some.
+; Outside of tasks, waiting yields the thread instead.
+;
+; Channels are Vyukov's ring buffer. Each cell has a sequence number, which
+; says whether the value for a position was sent to it yet, and whether it
+; was received, so senders and receivers claim positions with one
+; compare-and-swap, and never wait for each other unless it is full or
+; empty.
+%sync_SEP_Channel = type {
+    i64,                            ; 0: _send_position - the position the next value sent goes in
+    [7 x i64],                      ; 1: padding
+    i64,                            ; 2: _receive_position - the position the next value received is from
+    [7 x i64],                      ; 3: padding
+    %sync_SEP_ChannelCell*,         ; 4: _cells - indexed by position modulo their capacity
+    i64,                            ; 5: _mask - their capacity minus 1, which is a power of 2
+    i64,                            ; 6: _senders_waiting - how many tasks are in '_senders'
+    i64,                            ; 7: _receivers_waiting - how many tasks are in '_receivers'
+    %sync_SEP_Waiter*,              ; 8: _senders - tasks parked until there is room
+    %sync_SEP_Waiter*,              ; 9: _receivers - tasks parked until there are values
+    [5 x i64]                       ; 10: _lock - pthread_mutex_t guarding the parked tasks
+}
+
+%sync_SEP_ChannelCell = type {
+    i64,    ; 0: sequence - its position when free to send to, its position plus 1 once sent to
+    i64     ; 1: value
+}
+
+; A task parked on a channel, on its stack.
+%sync_SEP_Waiter = type {
+    %scheduler_SEP_Task*,   ; 0: task
+    %sync_SEP_Waiter*       ; 1: next
+}
+
+; Queues are linked lists of segments, of 4 KiB. Sending publishes how many
+; values were sent, and receiving reads that only once it has received
+; every value it saw the last time, so the producer's and consumer's cache
+; lines are only shared as often as the queue runs out.
+%sync_SEP_Queue = type {
+    %sync_SEP_QueueSegment*,    ; 0: _tail - the segment values are sent to
+    i64,                        ; 1: _tail_index - where in it the next value goes
+    i64,                        ; 2: _sent - how many values were sent
+    [5 x i64],                  ; 3: padding
+    %sync_SEP_QueueSegment*,    ; 4: _head - the segment values are received from
+    i64,                        ; 5: _head_index - where in it the next value is
+    i64,                        ; 6: _received - how many values were received
+    i64,                        ; 7: _sent_seen - '_sent' when the consumer last read it
+    [4 x i64],                  ; 8: padding
+    %sync_SEP_QueueSegment*,    ; 9: _spare - a segment the consumer is done with, for the producer to reuse
+    %scheduler_SEP_Task*        ; 10: _waiter - the consumer while it is parked, or null
+}
+
+%sync_SEP_QueueSegment = type {
+    %sync_SEP_QueueSegment*,    ; 0: next - the segment sent to after it, or null
+    [511 x i64]                 ; 1: values
+}
+
+declare i32 @sched_yield()
+declare i8* @aligned_alloc(i64, i64)
+
+; Makes a channel with room for at least 'capacity' values, rounded up to a
+; power of 2 of at least 4.
+define void @sync_SEP_Channel_SEP___init__(%sync_SEP_Channel* %self, i64 %capacity) nounwind {
+entry:
+    store %sync_SEP_Channel zeroinitializer, %sync_SEP_Channel* %self
+    %is_small = icmp ult i64 %capacity, 4
+    %at_least_4 = select i1 %is_small, i64 4, i64 %capacity
+    %largest_index = sub i64 %at_least_4, 1
+    %leading_zeros = call i64 @llvm.ctlz.i64(i64 %largest_index, i1 true)
+    %bits = sub i64 64, %leading_zeros
+    %rounded = shl i64 1, %bits
+    %mask = sub i64 %rounded, 1
+    %size = mul i64 %rounded, 16
+    %cells_bytes = call i8* @aligned_alloc(i64 64, i64 %size)
+    %cells = bitcast i8* %cells_bytes to %sync_SEP_ChannelCell*
+    %cells_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 4
+    store %sync_SEP_ChannelCell* %cells, %sync_SEP_ChannelCell** %cells_pointer
+    %mask_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 5
+    store i64 %mask, i64* %mask_pointer
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %body ]
+    %is_initialising = icmp ult i64 %index, %rounded
+    br i1 %is_initialising, label %body, label %exit
+
+body:
+    %sequence_pointer = getelementptr %sync_SEP_ChannelCell, %sync_SEP_ChannelCell* %cells, i64 %index, i32 0
+    store i64 %index, i64* %sequence_pointer
+    %next_index = add i64 %index, 1
+    br label %condition
+
+exit:
+    ret void
+}
+
+; Frees a channel's cells. No task can be waiting on it.
+define void @sync_SEP_Channel_SEP___del__(%sync_SEP_Channel* %self) nounwind {
+    %cells_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 4
+    %cells = load %sync_SEP_ChannelCell*, %sync_SEP_ChannelCell** %cells_pointer
+    %cells_bytes = bitcast %sync_SEP_ChannelCell* %cells to i8*
+    call void @free(i8* %cells_bytes)
+    store %sync_SEP_ChannelCell* null, %sync_SEP_ChannelCell** %cells_pointer
+
+    ret void
+}
+
+; Gets a channel's cell for a position.
+define private %sync_SEP_ChannelCell* @sync_SEP_Channel_SEP__cell(%sync_SEP_Channel* %self,
+                                                                   i64 %position) nounwind readonly alwaysinline {
+    %cells_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 4
+    %cells = load %sync_SEP_ChannelCell*, %sync_SEP_ChannelCell** %cells_pointer
+    %mask_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 5
+    %mask = load i64, i64* %mask_pointer
+    %index = and i64 %position, %mask
+    %cell = getelementptr %sync_SEP_ChannelCell, %sync_SEP_ChannelCell* %cells, i64 %index
+
+    ret %sync_SEP_ChannelCell* %cell
+}
+
+; Unparks up to 'count' of the tasks in a channel's 'waiters'.
+define private void @sync_SEP_Channel_SEP__unpark(%sync_SEP_Channel* %self, %sync_SEP_Waiter** %waiters,
+                                                 i64* %waiting, i64 %count) nounwind noinline {
+entry:
+    %lock_array = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 10
+    %lock_bytes = bitcast [5 x i64]* %lock_array to i8*
+    call i32 @pthread_mutex_lock(i8* %lock_bytes)
+    br label %condition
+
+condition:
+    %unparked = phi i64 [ 0, %entry ], [ %next_unparked, %unpark ]
+    %first = load %sync_SEP_Waiter*, %sync_SEP_Waiter** %waiters
+    %has_waiter = icmp ne %sync_SEP_Waiter* %first, null
+    %has_room = icmp ult i64 %unparked, %count
+    %is_unparking = and i1 %has_waiter, %has_room
+    br i1 %is_unparking, label %unpark, label %exit
+
+unpark: ; While locked, so the waiter is still on its task's stack
+    %next_pointer = getelementptr %sync_SEP_Waiter, %sync_SEP_Waiter* %first, i64 0, i32 1
+    %next = load %sync_SEP_Waiter*, %sync_SEP_Waiter** %next_pointer
+    store %sync_SEP_Waiter* %next, %sync_SEP_Waiter** %waiters
+    atomicrmw sub i64* %waiting, i64 1 seq_cst
+    %task_pointer = getelementptr %sync_SEP_Waiter, %sync_SEP_Waiter* %first, i64 0, i32 0
+    %task = load %scheduler_SEP_Task*, %scheduler_SEP_Task** %task_pointer
+    call void @scheduler_SEP_unpark(%scheduler_SEP_Task* %task)
+    %next_unparked = add i64 %unparked, 1
+    br label %condition
+
+exit:
+    call i32 @pthread_mutex_unlock(i8* %lock_bytes)
+
+    ret void
+}
+
+; Wakes up to 'count' tasks waiting for values when 'is_send', else for
+; room, after that many were sent or received.
+define private void @sync_SEP_Channel_SEP__wake(%sync_SEP_Channel* %self, i1 %is_send, i64 %count) nounwind alwaysinline {
+entry:
+    %receivers_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 9
+    %senders_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 8
+    %waiters = select i1 %is_send, %sync_SEP_Waiter** %receivers_pointer, %sync_SEP_Waiter** %senders_pointer
+    %receivers_waiting_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 7
+    %senders_waiting_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 6
+    %waiting_pointer = select i1 %is_send, i64* %receivers_waiting_pointer, i64* %senders_waiting_pointer
+    fence seq_cst ; Orders the cell's sequence before the count, as '_wait' does the other way around
+    %waiting = load atomic i64, i64* %waiting_pointer monotonic, align 8
+    %has_waiting = icmp ne i64 %waiting, 0
+    br i1 %has_waiting, label %unpark, label %exit
+
+unpark:
+    call void @sync_SEP_Channel_SEP__unpark(%sync_SEP_Channel* %self, %sync_SEP_Waiter** %waiters,
+                                            i64* %waiting_pointer, i64 %count)
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Gets whether a channel looks like it has room when 'is_send', else
+; values, or whether others got there first.
+define private i1 @sync_SEP_Channel_SEP__is_ready(%sync_SEP_Channel* %self, i1 %is_send) nounwind {
+    %send_position_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 0
+    %receive_position_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 2
+    %position_pointer = select i1 %is_send, i64* %send_position_pointer, i64* %receive_position_pointer
+    %position = load atomic i64, i64* %position_pointer monotonic, align 8
+    %cell = call %sync_SEP_ChannelCell* @sync_SEP_Channel_SEP__cell(%sync_SEP_Channel* %self, i64 %position)
+    %sequence_pointer = getelementptr %sync_SEP_ChannelCell, %sync_SEP_ChannelCell* %cell, i64 0, i32 0
+    %sequence = load atomic i64, i64* %sequence_pointer acquire, align 8
+    %offset = select i1 %is_send, i64 0, i64 1 ; Received from once sent to
+    %expected = add i64 %position, %offset
+    %difference = sub i64 %sequence, %expected
+    %is_ready = icmp sge i64 %difference, 0
+
+    ret i1 %is_ready
+}
+
+; Removes a waiter from a list, if it is still in it.
+define private i1 @sync_SEP_Waiter_SEP__remove(%sync_SEP_Waiter** %waiters, %sync_SEP_Waiter* %waiter) nounwind {
+entry:
+    br label %condition
+
+condition:
+    %link = phi %sync_SEP_Waiter** [ %waiters, %entry ], [ %next_link, %next ]
+    %current = load %sync_SEP_Waiter*, %sync_SEP_Waiter** %link
+    %is_end = icmp eq %sync_SEP_Waiter* %current, null
+    br i1 %is_end, label %exit, label %check
+
+check:
+    %next_link = getelementptr %sync_SEP_Waiter, %sync_SEP_Waiter* %current, i64 0, i32 1
+    %is_waiter = icmp eq %sync_SEP_Waiter* %current, %waiter
+    br i1 %is_waiter, label %remove, label %next
+
+next:
+    br label %condition
+
+remove:
+    %after = load %sync_SEP_Waiter*, %sync_SEP_Waiter** %next_link
+    store %sync_SEP_Waiter* %after, %sync_SEP_Waiter** %link
+    br label %exit
+
+exit:
+    %is_removed = phi i1 [ false, %condition ], [ true, %remove ]
+
+    ret i1 %is_removed
+}
+
+; Waits until a channel may have room when 'is_send', else values. Tasks
+; park until woken, and other threads yield.
+define private void @sync_SEP_Channel_SEP__wait(%sync_SEP_Channel* %self, i1 %is_send) nounwind noinline {
+entry:
+    %waiter = alloca %sync_SEP_Waiter
+    %task = call %scheduler_SEP_Task* @scheduler_SEP_current()
+    %is_task = icmp ne %scheduler_SEP_Task* %task, null
+    br i1 %is_task, label %add, label %yield
+
+yield:
+    call i32 @sched_yield()
+    br label %exit
+
+add:
+    %senders_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 8
+    %receivers_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 9
+    %waiters = select i1 %is_send, %sync_SEP_Waiter** %senders_pointer, %sync_SEP_Waiter** %receivers_pointer
+    %senders_waiting_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 6
+    %receivers_waiting_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 7
+    %waiting_pointer = select i1 %is_send, i64* %senders_waiting_pointer, i64* %receivers_waiting_pointer
+    %lock_array = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 10
+    %lock_bytes = bitcast [5 x i64]* %lock_array to i8*
+    call i32 @pthread_mutex_lock(i8* %lock_bytes)
+    %first = load %sync_SEP_Waiter*, %sync_SEP_Waiter** %waiters
+    %with_task = insertvalue %sync_SEP_Waiter zeroinitializer, %scheduler_SEP_Task* %task, 0
+    %added = insertvalue %sync_SEP_Waiter %with_task, %sync_SEP_Waiter* %first, 1
+    store %sync_SEP_Waiter %added, %sync_SEP_Waiter* %waiter
+    store %sync_SEP_Waiter* %waiter, %sync_SEP_Waiter** %waiters
+    atomicrmw add i64* %waiting_pointer, i64 1 seq_cst
+    call i32 @pthread_mutex_unlock(i8* %lock_bytes)
+
+    ; Checked again once counted, as what it waits for may have happened before '_wake' could see it
+    fence seq_cst
+    %is_ready = call i1 @sync_SEP_Channel_SEP__is_ready(%sync_SEP_Channel* %self, i1 %is_send)
+    br i1 %is_ready, label %withdraw, label %park
+
+withdraw:
+    call i32 @pthread_mutex_lock(i8* %lock_bytes)
+    %is_removed = call i1 @sync_SEP_Waiter_SEP__remove(%sync_SEP_Waiter** %waiters, %sync_SEP_Waiter* %waiter)
+    br i1 %is_removed, label %uncount, label %unlock
+
+uncount:
+    atomicrmw sub i64* %waiting_pointer, i64 1 seq_cst
+    br label %unlock
+
+unlock:
+    call i32 @pthread_mutex_unlock(i8* %lock_bytes)
+    br i1 %is_removed, label %exit, label %park ; Else it was already unparked, which 'park' consumes
+
+park:
+    call void @scheduler_SEP_park()
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Sends a value if a channel has room, returning whether it did.
+define i1 @sync_SEP_Channel_SEP_try_send(%sync_SEP_Channel* %self, i64 %value) nounwind {
+entry:
+    %position_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 0
+    %initial = load atomic i64, i64* %position_pointer monotonic, align 8
+    br label %claim
+
+claim:
+    %position = phi i64 [ %initial, %entry ], [ %seen, %swap ], [ %reloaded, %reload ]
+    %cell = call %sync_SEP_ChannelCell* @sync_SEP_Channel_SEP__cell(%sync_SEP_Channel* %self, i64 %position)
+    %sequence_pointer = getelementptr %sync_SEP_ChannelCell, %sync_SEP_ChannelCell* %cell, i64 0, i32 0
+    %sequence = load atomic i64, i64* %sequence_pointer acquire, align 8
+    %difference = sub i64 %sequence, %position
+    %is_free = icmp eq i64 %difference, 0
+    br i1 %is_free, label %swap, label %check_full
+
+swap:
+    %next_position = add i64 %position, 1
+    %swapped = cmpxchg weak i64* %position_pointer, i64 %position, i64 %next_position monotonic monotonic
+    %seen = extractvalue { i64, i1 } %swapped, 0
+    %is_claimed = extractvalue { i64, i1 } %swapped, 1
+    br i1 %is_claimed, label %send, label %claim
+
+check_full:
+    %is_full = icmp slt i64 %difference, 0 ; Not received from since the last time round
+    br i1 %is_full, label %exit, label %reload
+
+reload: ; Another sender claimed it first
+    %reloaded = load atomic i64, i64* %position_pointer monotonic, align 8
+    br label %claim
+
+send:
+    %value_pointer = getelementptr %sync_SEP_ChannelCell, %sync_SEP_ChannelCell* %cell, i64 0, i32 1
+    store i64 %value, i64* %value_pointer
+    store atomic i64 %next_position, i64* %sequence_pointer release, align 8
+    call void @sync_SEP_Channel_SEP__wake(%sync_SEP_Channel* %self, i1 true, i64 1)
+    br label %exit
+
+exit:
+    %is_sent = phi i1 [ false, %check_full ], [ true, %send ]
+
+    ret i1 %is_sent
+}
+
+; Receives a value into 'value' if a channel has one, returning whether it
+; did.
+define i1 @sync_SEP_Channel_SEP_try_receive(%sync_SEP_Channel* %self, i64* %value) nounwind {
+entry:
+    %position_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 2
+    %mask_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 5
+    %mask = load i64, i64* %mask_pointer
+    %initial = load atomic i64, i64* %position_pointer monotonic, align 8
+    br label %claim
+
+claim:
+    %position = phi i64 [ %initial, %entry ], [ %seen, %swap ], [ %reloaded, %reload ]
+    %cell = call %sync_SEP_ChannelCell* @sync_SEP_Channel_SEP__cell(%sync_SEP_Channel* %self, i64 %position)
+    %sequence_pointer = getelementptr %sync_SEP_ChannelCell, %sync_SEP_ChannelCell* %cell, i64 0, i32 0
+    %sequence = load atomic i64, i64* %sequence_pointer acquire, align 8
+    %next_position = add i64 %position, 1
+    %difference = sub i64 %sequence, %next_position
+    %is_sent = icmp eq i64 %difference, 0
+    br i1 %is_sent, label %swap, label %check_empty
+
+swap:
+    %swapped = cmpxchg weak i64* %position_pointer, i64 %position, i64 %next_position monotonic monotonic
+    %seen = extractvalue { i64, i1 } %swapped, 0
+    %is_claimed = extractvalue { i64, i1 } %swapped, 1
+    br i1 %is_claimed, label %receive, label %claim
+
+check_empty:
+    %is_empty = icmp slt i64 %difference, 0 ; Not sent to since the last time round
+    br i1 %is_empty, label %exit, label %reload
+
+reload: ; Another receiver claimed it first
+    %reloaded = load atomic i64, i64* %position_pointer monotonic, align 8
+    br label %claim
+
+receive:
+    %value_pointer = getelementptr %sync_SEP_ChannelCell, %sync_SEP_ChannelCell* %cell, i64 0, i32 1
+    %received_value = load i64, i64* %value_pointer
+    store i64 %received_value, i64* %value
+    %next_round = add i64 %next_position, %mask ; Free to send to for the position a capacity later
+    store atomic i64 %next_round, i64* %sequence_pointer release, align 8
+    call void @sync_SEP_Channel_SEP__wake(%sync_SEP_Channel* %self, i1 false, i64 1)
+    br label %exit
+
+exit:
+    %is_received = phi i1 [ false, %check_empty ], [ true, %receive ]
+
+    ret i1 %is_received
+}
+
+; Claims up to 'count' positions at once, to send to when 'is_send', else
+; receive from, as many as a channel has room or values for, going by its
+; positions. Returns the first, and how many.
+define private { i64, i64 } @sync_SEP_Channel_SEP__claim(%sync_SEP_Channel* %self, i1 %is_send, i64 %count) nounwind {
+entry:
+    %send_position_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 0
+    %receive_position_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 2
+    %position_pointer = select i1 %is_send, i64* %send_position_pointer, i64* %receive_position_pointer
+    %mask_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 5
+    %mask = load i64, i64* %mask_pointer
+    %capacity = add i64 %mask, 1
+    br label %claim
+
+claim:
+    %send_position = load atomic i64, i64* %send_position_pointer monotonic, align 8
+    %receive_position = load atomic i64, i64* %receive_position_pointer monotonic, align 8
+    %position = select i1 %is_send, i64 %send_position, i64 %receive_position
+    %used = sub i64 %send_position, %receive_position ; Claimed, maybe not sent to or received from yet
+    %is_negative = icmp slt i64 %used, 0 ; Loaded while others claimed more, so the swap fails
+    %clamped_used = select i1 %is_negative, i64 0, i64 %used
+    %is_over = icmp ugt i64 %clamped_used, %capacity
+    %bounded_used = select i1 %is_over, i64 %capacity, i64 %clamped_used
+    %room = sub i64 %capacity, %bounded_used
+    %available = select i1 %is_send, i64 %room, i64 %bounded_used
+    %is_fewer = icmp ult i64 %available, %count
+    %claimable = select i1 %is_fewer, i64 %available, i64 %count
+    %is_none = icmp eq i64 %claimable, 0
+    br i1 %is_none, label %exit, label %swap
+
+swap:
+    %next_position = add i64 %position, %claimable
+    %swapped = cmpxchg i64* %position_pointer, i64 %position, i64 %next_position monotonic monotonic
+    %is_claimed = extractvalue { i64, i1 } %swapped, 1
+    br i1 %is_claimed, label %exit, label %claim
+
+exit:
+    %claimed = phi i64 [ 0, %claim ], [ %claimable, %swap ]
+    %with_position = insertvalue { i64, i64 } undef, i64 %position, 0
+    %result = insertvalue { i64, i64 } %with_position, i64 %claimed, 1
+
+    ret { i64, i64 } %result
+}
+
+; Spins until a cell's sequence is 'expected', as positions claimed in a
+; batch may still be being received from, or sent to, by whoever claimed
+; them a capacity before. Yields the thread after a while, in case they
+; were preempted.
+define private void @sync_SEP_ChannelCell_SEP__await(%sync_SEP_ChannelCell* %self, i64 %expected) nounwind {
+entry:
+    %sequence_pointer = getelementptr %sync_SEP_ChannelCell, %sync_SEP_ChannelCell* %self, i64 0, i32 0
+    br label %condition
+
+condition:
+    %spins = phi i64 [ 0, %entry ], [ %next_spins, %spin ], [ 0, %yield ]
+    %sequence = load atomic i64, i64* %sequence_pointer acquire, align 8
+    %is_ready = icmp eq i64 %sequence, %expected
+    br i1 %is_ready, label %exit, label %check_spins
+
+check_spins:
+    %is_spinning = icmp ult i64 %spins, 64
+    br i1 %is_spinning, label %spin, label %yield
+
+spin:
+    call void asm sideeffect "pause", ""()
+    %next_spins = add i64 %spins, 1
+    br label %condition
+
+yield:
+    call i32 @sched_yield()
+    br label %condition
+
+exit:
+    ret void
+}
+
+; Sends up to 'count' values from 'values' in one go, as many as a channel
+; has room for. Returns how many were sent.
+define i64 @sync_SEP_Channel_SEP_try_send_batch(%sync_SEP_Channel* %self, i64* %values, i64 %count) nounwind {
+entry:
+    %claim = call { i64, i64 } @sync_SEP_Channel_SEP__claim(%sync_SEP_Channel* %self, i1 true, i64 %count)
+    %first = extractvalue { i64, i64 } %claim, 0
+    %claimed = extractvalue { i64, i64 } %claim, 1
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %send ]
+    %is_sending = icmp ult i64 %index, %claimed
+    br i1 %is_sending, label %send, label %wake
+
+send:
+    %position = add i64 %first, %index
+    %cell = call %sync_SEP_ChannelCell* @sync_SEP_Channel_SEP__cell(%sync_SEP_Channel* %self, i64 %position)
+    call void @sync_SEP_ChannelCell_SEP__await(%sync_SEP_ChannelCell* %cell, i64 %position)
+    %source = getelementptr i64, i64* %values, i64 %index
+    %value = load i64, i64* %source
+    %value_pointer = getelementptr %sync_SEP_ChannelCell, %sync_SEP_ChannelCell* %cell, i64 0, i32 1
+    store i64 %value, i64* %value_pointer
+    %sequence_pointer = getelementptr %sync_SEP_ChannelCell, %sync_SEP_ChannelCell* %cell, i64 0, i32 0
+    %next_index = add i64 %index, 1
+    %sent_sequence = add i64 %position, 1
+    store atomic i64 %sent_sequence, i64* %sequence_pointer release, align 8
+    br label %condition
+
+wake:
+    %is_any = icmp ne i64 %claimed, 0
+    br i1 %is_any, label %wake_receivers, label %exit
+
+wake_receivers:
+    call void @sync_SEP_Channel_SEP__wake(%sync_SEP_Channel* %self, i1 true, i64 %claimed)
+    br label %exit
+
+exit:
+    ret i64 %claimed
+}
+
+; Receives up to 'count' values into 'values' in one go, as many as a
+; channel has. Returns how many were received.
+define i64 @sync_SEP_Channel_SEP_try_receive_batch(%sync_SEP_Channel* %self, i64* %values, i64 %count) nounwind {
+entry:
+    %mask_pointer = getelementptr %sync_SEP_Channel, %sync_SEP_Channel* %self, i64 0, i32 5
+    %mask = load i64, i64* %mask_pointer
+    %claim = call { i64, i64 } @sync_SEP_Channel_SEP__claim(%sync_SEP_Channel* %self, i1 false, i64 %count)
+    %first = extractvalue { i64, i64 } %claim, 0
+    %claimed = extractvalue { i64, i64 } %claim, 1
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %receive ]
+    %is_receiving = icmp ult i64 %index, %claimed
+    br i1 %is_receiving, label %receive, label %wake
+
+receive:
+    %position = add i64 %first, %index
+    %cell = call %sync_SEP_ChannelCell* @sync_SEP_Channel_SEP__cell(%sync_SEP_Channel* %self, i64 %position)
+    %sent_sequence = add i64 %position, 1
+    call void @sync_SEP_ChannelCell_SEP__await(%sync_SEP_ChannelCell* %cell, i64 %sent_sequence)
+    %value_pointer = getelementptr %sync_SEP_ChannelCell, %sync_SEP_ChannelCell* %cell, i64 0, i32 1
+    %value = load i64, i64* %value_pointer
+    %destination = getelementptr i64, i64* %values, i64 %index
+    store i64 %value, i64* %destination
+    %sequence_pointer = getelementptr %sync_SEP_ChannelCell, %sync_SEP_ChannelCell* %cell, i64 0, i32 0
+    %next_round = add i64 %sent_sequence, %mask
+    store atomic i64 %next_round, i64* %sequence_pointer release, align 8
+    %next_index = add i64 %index, 1
+    br label %condition
+
+wake:
+    %is_any = icmp ne i64 %claimed, 0
+    br i1 %is_any, label %wake_senders, label %exit
+
+wake_senders:
+    call void @sync_SEP_Channel_SEP__wake(%sync_SEP_Channel* %self, i1 false, i64 %claimed)
+    br label %exit
+
+exit:
+    ret i64 %claimed
+}
+
+; Sends a value, waiting for room if a channel is full.
+define void @sync_SEP_Channel_SEP_send(%sync_SEP_Channel* %self, i64 %value) nounwind {
+entry:
+    br label %send
+
+send:
+    %is_sent = call i1 @sync_SEP_Channel_SEP_try_send(%sync_SEP_Channel* %self, i64 %value)
+    br i1 %is_sent, label %exit, label %wait
+
+wait:
+    call void @sync_SEP_Channel_SEP__wait(%sync_SEP_Channel* %self, i1 true)
+    br label %send
+
+exit:
+    ret void
+}
+
+; Receives a value, waiting for one if a channel is empty.
+define i64 @sync_SEP_Channel_SEP_receive(%sync_SEP_Channel* %self) nounwind {
+entry:
+    %value = alloca i64
+    br label %receive
+
+receive:
+    %is_received = call i1 @sync_SEP_Channel_SEP_try_receive(%sync_SEP_Channel* %self, i64* %value)
+    br i1 %is_received, label %exit, label %wait
+
+wait:
+    call void @sync_SEP_Channel_SEP__wait(%sync_SEP_Channel* %self, i1 false)
+    br label %receive
+
+exit:
+    %received = load i64, i64* %value
+
+    ret i64 %received
+}
+
+; Sends every value in 'values', in batches of as many as a channel has
+; room for, waiting for room whenever it is full.
+define void @sync_SEP_Channel_SEP_send_batch(%sync_SEP_Channel* %self, i64* %values, i64 %count) nounwind {
+entry:
+    br label %condition
+
+condition:
+    %sent = phi i64 [ 0, %entry ], [ %sent, %wait ], [ %next_sent, %send ]
+    %is_sending = icmp ult i64 %sent, %count
+    br i1 %is_sending, label %send, label %exit
+
+send:
+    %remaining = sub i64 %count, %sent
+    %next_values = getelementptr i64, i64* %values, i64 %sent
+    %batch = call i64 @sync_SEP_Channel_SEP_try_send_batch(%sync_SEP_Channel* %self, i64* %next_values, i64 %remaining)
+    %next_sent = add i64 %sent, %batch
+    %is_full = icmp eq i64 %batch, 0
+    br i1 %is_full, label %wait, label %condition
+
+wait:
+    call void @sync_SEP_Channel_SEP__wait(%sync_SEP_Channel* %self, i1 true)
+    br label %condition
+
+exit:
+    ret void
+}
+
+; Receives up to 'count' values into 'values' in one go, waiting for at
+; least one if a channel is empty. Returns how many were received.
+define i64 @sync_SEP_Channel_SEP_receive_batch(%sync_SEP_Channel* %self, i64* %values, i64 %count) nounwind {
+entry:
+    br label %receive
+
+receive:
+    %received = call i64 @sync_SEP_Channel_SEP_try_receive_batch(%sync_SEP_Channel* %self, i64* %values, i64 %count)
+    %is_empty = icmp eq i64 %received, 0
+    br i1 %is_empty, label %wait, label %exit
+
+wait:
+    call void @sync_SEP_Channel_SEP__wait(%sync_SEP_Channel* %self, i1 false)
+    br label %receive
+
+exit:
+    ret i64 %received
+}
+
+; Allocates a segment, reusing the spare one if the consumer left one.
+define private %sync_SEP_QueueSegment* @sync_SEP_Queue_SEP__new_segment(%sync_SEP_Queue* %self) nounwind {
+entry:
+    %spare_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 9
+    %spare_bits_pointer = bitcast %sync_SEP_QueueSegment** %spare_pointer to i64*
+    %spare_bits = atomicrmw xchg i64* %spare_bits_pointer, i64 0 acquire
+    %spare = inttoptr i64 %spare_bits to %sync_SEP_QueueSegment*
+    %has_spare = icmp ne %sync_SEP_QueueSegment* %spare, null
+    br i1 %has_spare, label %exit, label %allocate
+
+allocate:
+    %bytes = call i8* @malloc(i64 4096)
+    %allocated = bitcast i8* %bytes to %sync_SEP_QueueSegment*
+    br label %exit
+
+exit:
+    %segment = phi %sync_SEP_QueueSegment* [ %spare, %entry ], [ %allocated, %allocate ]
+    %next_pointer = getelementptr %sync_SEP_QueueSegment, %sync_SEP_QueueSegment* %segment, i64 0, i32 0
+    store %sync_SEP_QueueSegment* null, %sync_SEP_QueueSegment** %next_pointer
+
+    ret %sync_SEP_QueueSegment* %segment
+}
+
+define void @sync_SEP_Queue_SEP___init__(%sync_SEP_Queue* %self) nounwind {
+    store %sync_SEP_Queue zeroinitializer, %sync_SEP_Queue* %self
+    %segment = call %sync_SEP_QueueSegment* @sync_SEP_Queue_SEP__new_segment(%sync_SEP_Queue* %self)
+    %tail_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 0
+    store %sync_SEP_QueueSegment* %segment, %sync_SEP_QueueSegment** %tail_pointer
+    %head_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 4
+    store %sync_SEP_QueueSegment* %segment, %sync_SEP_QueueSegment** %head_pointer
+
+    ret void
+}
+
+; Frees a queue's segments, and any values left in it.
+define void @sync_SEP_Queue_SEP___del__(%sync_SEP_Queue* %self) nounwind {
+entry:
+    %head_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 4
+    %head = load %sync_SEP_QueueSegment*, %sync_SEP_QueueSegment** %head_pointer
+    br label %condition
+
+condition:
+    %segment = phi %sync_SEP_QueueSegment* [ %head, %entry ], [ %next, %free ]
+    %is_freeing = icmp ne %sync_SEP_QueueSegment* %segment, null
+    br i1 %is_freeing, label %free, label %free_spare
+
+free:
+    %next_pointer = getelementptr %sync_SEP_QueueSegment, %sync_SEP_QueueSegment* %segment, i64 0, i32 0
+    %next = load %sync_SEP_QueueSegment*, %sync_SEP_QueueSegment** %next_pointer
+    %bytes = bitcast %sync_SEP_QueueSegment* %segment to i8*
+    call void @free(i8* %bytes)
+    br label %condition
+
+free_spare:
+    %spare_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 9
+    %spare = load %sync_SEP_QueueSegment*, %sync_SEP_QueueSegment** %spare_pointer
+    %spare_bytes = bitcast %sync_SEP_QueueSegment* %spare to i8*
+    call void @free(i8* %spare_bytes)
+    store %sync_SEP_Queue zeroinitializer, %sync_SEP_Queue* %self
+
+    ret void
+}
+
+; Publishes that values were sent, then unparks the consumer if it is
+; waiting for them.
+define private void @sync_SEP_Queue_SEP__publish(%sync_SEP_Queue* %self, i64 %count) nounwind alwaysinline {
+entry:
+    %sent_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 2
+    %sent = load i64, i64* %sent_pointer ; Only the producer stores it
+    %new_sent = add i64 %sent, %count
+    store atomic i64 %new_sent, i64* %sent_pointer release, align 8
+    %waiter_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 10
+    fence seq_cst ; Orders '_sent' before '_waiter', as 'receive' does the other way around
+    %waiter = load atomic %scheduler_SEP_Task*, %scheduler_SEP_Task** %waiter_pointer monotonic, align 8
+    %has_waiter = icmp ne %scheduler_SEP_Task* %waiter, null
+    br i1 %has_waiter, label %take, label %exit
+
+take: ; Whoever takes it unparks it, so it is unparked once
+    %waiter_bits_pointer = bitcast %scheduler_SEP_Task** %waiter_pointer to i64*
+    %taken_bits = atomicrmw xchg i64* %waiter_bits_pointer, i64 0 acq_rel
+    %taken = inttoptr i64 %taken_bits to %scheduler_SEP_Task*
+    %is_taken = icmp ne %scheduler_SEP_Task* %taken, null
+    br i1 %is_taken, label %unpark, label %exit
+
+unpark:
+    call void @scheduler_SEP_unpark(%scheduler_SEP_Task* %taken)
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Gets where the next value sent to a queue goes, adding a segment when
+; the last one is full. Only the producer calls it.
+define private i64* @sync_SEP_Queue_SEP__tail(%sync_SEP_Queue* %self, i64* %room) nounwind alwaysinline {
+entry:
+    %tail_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 0
+    %tail_index_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 1
+    %tail = load %sync_SEP_QueueSegment*, %sync_SEP_QueueSegment** %tail_pointer
+    %tail_index = load i64, i64* %tail_index_pointer
+    %is_full = icmp eq i64 %tail_index, 511
+    br i1 %is_full, label %grow, label %exit
+
+grow: ; Linked before the values sent to it are published, which publishes the link
+    %segment = call %sync_SEP_QueueSegment* @sync_SEP_Queue_SEP__new_segment(%sync_SEP_Queue* %self)
+    %next_pointer = getelementptr %sync_SEP_QueueSegment, %sync_SEP_QueueSegment* %tail, i64 0, i32 0
+    store %sync_SEP_QueueSegment* %segment, %sync_SEP_QueueSegment** %next_pointer
+    store %sync_SEP_QueueSegment* %segment, %sync_SEP_QueueSegment** %tail_pointer
+    store i64 0, i64* %tail_index_pointer
+    br label %exit
+
+exit:
+    %segment_used = phi %sync_SEP_QueueSegment* [ %tail, %entry ], [ %segment, %grow ]
+    %index = phi i64 [ %tail_index, %entry ], [ 0, %grow ]
+    %left = sub i64 511, %index
+    store i64 %left, i64* %room
+    %slot = getelementptr %sync_SEP_QueueSegment, %sync_SEP_QueueSegment* %segment_used, i64 0, i32 1, i64 %index
+
+    ret i64* %slot
+}
+
+; Sends a value. Only one task can send to a queue.
+define void @sync_SEP_Queue_SEP_send(%sync_SEP_Queue* %self, i64 %value) nounwind {
+    %room = alloca i64
+    %slot = call i64* @sync_SEP_Queue_SEP__tail(%sync_SEP_Queue* %self, i64* %room)
+    store i64 %value, i64* %slot
+    %tail_index_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 1
+    %tail_index = load i64, i64* %tail_index_pointer
+    %next_tail_index = add i64 %tail_index, 1
+    store i64 %next_tail_index, i64* %tail_index_pointer
+    call void @sync_SEP_Queue_SEP__publish(%sync_SEP_Queue* %self, i64 1)
+
+    ret void
+}
+
+; Sends 'count' values from 'values', publishing them, and waking the
+; consumer, once.
+define void @sync_SEP_Queue_SEP_send_batch(%sync_SEP_Queue* %self, i64* %values, i64 %count) nounwind {
+entry:
+    %room = alloca i64
+    %tail_index_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 1
+    %is_empty = icmp eq i64 %count, 0
+    br i1 %is_empty, label %exit, label %condition
+
+condition:
+    %sent = phi i64 [ 0, %entry ], [ %next_sent, %copy ]
+    %is_sending = icmp ult i64 %sent, %count
+    br i1 %is_sending, label %copy, label %publish
+
+copy: ; As much as fits in the last segment
+    %slot = call i64* @sync_SEP_Queue_SEP__tail(%sync_SEP_Queue* %self, i64* %room)
+    %segment_room = load i64, i64* %room
+    %remaining = sub i64 %count, %sent
+    %is_fitting = icmp ult i64 %remaining, %segment_room
+    %copied = select i1 %is_fitting, i64 %remaining, i64 %segment_room
+    %slot_bytes = bitcast i64* %slot to i8*
+    %source = getelementptr i64, i64* %values, i64 %sent
+    %source_bytes = bitcast i64* %source to i8*
+    %copied_size = mul i64 %copied, 8
+    call void @llvm.memcpy.p0i8.p0i8.i64(i8* %slot_bytes, i8* %source_bytes, i64 %copied_size, i1 false)
+    %tail_index = load i64, i64* %tail_index_pointer
+    %next_tail_index = add i64 %tail_index, %copied
+    store i64 %next_tail_index, i64* %tail_index_pointer
+    %next_sent = add i64 %sent, %copied
+    br label %condition
+
+publish:
+    call void @sync_SEP_Queue_SEP__publish(%sync_SEP_Queue* %self, i64 %count)
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Gets how many values a queue has for the consumer, only reading what the
+; producer published when it has received everything it saw before.
+define private i64 @sync_SEP_Queue_SEP__available(%sync_SEP_Queue* %self) nounwind alwaysinline {
+entry:
+    %received_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 6
+    %received = load i64, i64* %received_pointer
+    %sent_seen_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 7
+    %sent_seen = load i64, i64* %sent_seen_pointer
+    %is_caught_up = icmp eq i64 %received, %sent_seen
+    br i1 %is_caught_up, label %refresh, label %exit
+
+refresh:
+    %sent_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 2
+    %sent = load atomic i64, i64* %sent_pointer acquire, align 8
+    store i64 %sent, i64* %sent_seen_pointer
+    br label %exit
+
+exit:
+    %latest = phi i64 [ %sent_seen, %entry ], [ %sent, %refresh ]
+    %available = sub i64 %latest, %received
+
+    ret i64 %available
+}
+
+; Gets where the next value received from a queue is, moving on to the
+; next segment, and leaving the one it finished for the producer to reuse,
+; at the end of one. Only the consumer calls it, when a value is available.
+define private i64* @sync_SEP_Queue_SEP__head(%sync_SEP_Queue* %self, i64* %left) nounwind alwaysinline {
+entry:
+    %head_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 4
+    %head_index_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 5
+    %head = load %sync_SEP_QueueSegment*, %sync_SEP_QueueSegment** %head_pointer
+    %head_index = load i64, i64* %head_index_pointer
+    %is_finished = icmp eq i64 %head_index, 511
+    br i1 %is_finished, label %advance, label %exit
+
+advance:
+    %next_pointer = getelementptr %sync_SEP_QueueSegment, %sync_SEP_QueueSegment* %head, i64 0, i32 0
+    %next = load %sync_SEP_QueueSegment*, %sync_SEP_QueueSegment** %next_pointer
+    store %sync_SEP_QueueSegment* %next, %sync_SEP_QueueSegment** %head_pointer
+    store i64 0, i64* %head_index_pointer
+    %spare_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 9
+    %spare_bits_pointer = bitcast %sync_SEP_QueueSegment** %spare_pointer to i64*
+    %head_bits = ptrtoint %sync_SEP_QueueSegment* %head to i64
+    %previous_spare_bits = atomicrmw xchg i64* %spare_bits_pointer, i64 %head_bits release
+    %previous_spare = inttoptr i64 %previous_spare_bits to %sync_SEP_QueueSegment*
+    %previous_spare_bytes = bitcast %sync_SEP_QueueSegment* %previous_spare to i8*
+    call void @free(i8* %previous_spare_bytes)
+    br label %exit
+
+exit:
+    %segment = phi %sync_SEP_QueueSegment* [ %head, %entry ], [ %next, %advance ]
+    %index = phi i64 [ %head_index, %entry ], [ 0, %advance ]
+    %segment_left = sub i64 511, %index
+    store i64 %segment_left, i64* %left
+    %slot = getelementptr %sync_SEP_QueueSegment, %sync_SEP_QueueSegment* %segment, i64 0, i32 1, i64 %index
+
+    ret i64* %slot
+}
+
+; Receives a value into 'value' if a queue has one, returning whether it
+; did. Only one task can receive from a queue.
+define i1 @sync_SEP_Queue_SEP_try_receive(%sync_SEP_Queue* %self, i64* %value) nounwind {
+entry:
+    %left = alloca i64
+    %available = call i64 @sync_SEP_Queue_SEP__available(%sync_SEP_Queue* %self)
+    %is_empty = icmp eq i64 %available, 0
+    br i1 %is_empty, label %exit, label %receive
+
+receive:
+    %slot = call i64* @sync_SEP_Queue_SEP__head(%sync_SEP_Queue* %self, i64* %left)
+    %received_value = load i64, i64* %slot
+    store i64 %received_value, i64* %value
+    %head_index_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 5
+    %head_index = load i64, i64* %head_index_pointer
+    %next_head_index = add i64 %head_index, 1
+    store i64 %next_head_index, i64* %head_index_pointer
+    %received_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 6
+    %received = load i64, i64* %received_pointer
+    %next_received = add i64 %received, 1
+    store i64 %next_received, i64* %received_pointer
+    br label %exit
+
+exit:
+    %is_received = phi i1 [ false, %entry ], [ true, %receive ]
+
+    ret i1 %is_received
+}
+
+; Receives up to 'count' values into 'values' in one go, as many as a
+; queue has. Returns how many were received.
+define i64 @sync_SEP_Queue_SEP_try_receive_batch(%sync_SEP_Queue* %self, i64* %values, i64 %count) nounwind {
+entry:
+    %left = alloca i64
+    %head_index_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 5
+    %received_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 6
+    %available = call i64 @sync_SEP_Queue_SEP__available(%sync_SEP_Queue* %self)
+    %is_fewer = icmp ult i64 %available, %count
+    %receivable = select i1 %is_fewer, i64 %available, i64 %count
+    br label %condition
+
+condition:
+    %received = phi i64 [ 0, %entry ], [ %next_received, %copy ]
+    %is_receiving = icmp ult i64 %received, %receivable
+    br i1 %is_receiving, label %copy, label %exit
+
+copy: ; As much as is left in the first segment
+    %slot = call i64* @sync_SEP_Queue_SEP__head(%sync_SEP_Queue* %self, i64* %left)
+    %segment_left = load i64, i64* %left
+    %remaining = sub i64 %receivable, %received
+    %is_fitting = icmp ult i64 %remaining, %segment_left
+    %copied = select i1 %is_fitting, i64 %remaining, i64 %segment_left
+    %slot_bytes = bitcast i64* %slot to i8*
+    %destination = getelementptr i64, i64* %values, i64 %received
+    %destination_bytes = bitcast i64* %destination to i8*
+    %copied_size = mul i64 %copied, 8
+    call void @llvm.memcpy.p0i8.p0i8.i64(i8* %destination_bytes, i8* %slot_bytes, i64 %copied_size, i1 false)
+    %head_index = load i64, i64* %head_index_pointer
+    %next_head_index = add i64 %head_index, %copied
+    store i64 %next_head_index, i64* %head_index_pointer
+    %next_received = add i64 %received, %copied
+    br label %condition
+
+exit:
+    %total_received = load i64, i64* %received_pointer
+    %new_total_received = add i64 %total_received, %receivable
+    store i64 %new_total_received, i64* %received_pointer
+
+    ret i64 %receivable
+}
+
+; Waits until a queue may have values for the consumer. A task parks until
+; the producer unparks it, and another thread yields.
+define private void @sync_SEP_Queue_SEP__wait(%sync_SEP_Queue* %self) nounwind noinline {
+entry:
+    %task = call %scheduler_SEP_Task* @scheduler_SEP_current()
+    %is_task = icmp ne %scheduler_SEP_Task* %task, null
+    br i1 %is_task, label %register, label %yield
+
+yield:
+    call i32 @sched_yield()
+    br label %exit
+
+register:
+    %waiter_pointer = getelementptr %sync_SEP_Queue, %sync_SEP_Queue* %self, i64 0, i32 10
+    store atomic %scheduler_SEP_Task* %task, %scheduler_SEP_Task** %waiter_pointer seq_cst, align 8
+    fence seq_cst ; Checked again once registered, as values may have been sent before '_publish' could see it
+    %available = call i64 @sync_SEP_Queue_SEP__available(%sync_SEP_Queue* %self)
+    %is_empty = icmp eq i64 %available, 0
+    br i1 %is_empty, label %park, label %withdraw
+
+withdraw:
+    %waiter_bits_pointer = bitcast %scheduler_SEP_Task** %waiter_pointer to i64*
+    %taken_bits = atomicrmw xchg i64* %waiter_bits_pointer, i64 0 acq_rel
+    %taken = inttoptr i64 %taken_bits to %scheduler_SEP_Task*
+    %is_withdrawn = icmp ne %scheduler_SEP_Task* %taken, null
+    br i1 %is_withdrawn, label %exit, label %park ; Else the producer took it, and its unpark is consumed
+
+park:
+    call void @scheduler_SEP_park()
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Receives a value, waiting for one if a queue is empty.
+define i64 @sync_SEP_Queue_SEP_receive(%sync_SEP_Queue* %self) nounwind {
+entry:
+    %value = alloca i64
+    br label %receive
+
+receive:
+    %is_received = call i1 @sync_SEP_Queue_SEP_try_receive(%sync_SEP_Queue* %self, i64* %value)
+    br i1 %is_received, label %exit, label %wait
+
+wait:
+    call void @sync_SEP_Queue_SEP__wait(%sync_SEP_Queue* %self)
+    br label %receive
+
+exit:
+    %received = load i64, i64* %value
+
+    ret i64 %received
+}
+
+; Receives up to 'count' values into 'values' in one go, waiting for at
+; least one if a queue is empty. Returns how many were received.
+define i64 @sync_SEP_Queue_SEP_receive_batch(%sync_SEP_Queue* %self, i64* %values, i64 %count) nounwind {
+entry:
+    br label %receive
+
+receive:
+    %received = call i64 @sync_SEP_Queue_SEP_try_receive_batch(%sync_SEP_Queue* %self, i64* %values, i64 %count)
+    %is_empty = icmp eq i64 %received, 0
+    br i1 %is_empty, label %wait, label %exit
+
+wait:
+    call void @sync_SEP_Queue_SEP__wait(%sync_SEP_Queue* %self)
+    br label %receive
+
+exit:
+    ret i64 %received
+}
+
+; std.atomic, integers, pointers and flags which threads and tasks can
+; share without locks, for writing lock-free structures. Every operation
+; takes the memory ordering it needs, as an 'i32':
+;   - 0, relaxed: only the operation itself is atomic.
+;   - 1, acquire: loads and stores after it stay after it.
+;   - 2, release: loads and stores before it stay before it.
+;   - 3, acq_rel: both, for operations which load and store.
+;   - 4, seq_cst: both, and every seq_cst operation happens in one order
+;     which all threads agree on.
+; Each is mapped to the LLVM ordering of the same name, relaxed being
+; 'monotonic'. Operations which only load or only store use the half of
+; the ordering which applies to them, as C++ does. The operations are
+; always inlined, so orderings which are constants, as they almost always
+; are, leave just the one instruction.
+;
+; Structures shared between threads should be marked '@align(64)', so
+; ones next to each other, or to anything else, never share a cache line,
+; see 'codegen/align.c'. Their fields which are written by different
+; threads should be 64 bytes apart, as 'std.sync's are, for the same
+; reason.
+%atomic_SEP_Int = type {
+    i64     ; 0: _value
+}
+
+%atomic_SEP_Int32 = type {
+    i32     ; 0: _value
+}
+
+%atomic_SEP_Pointer = type {
+    i8*     ; 0: _value
+}
+
+; Zeroed is clear.
+%atomic_SEP_Flag = type {
+    i8      ; 0: _value - 1 when set
+}
+
+; Makes an atomic integer holding 'value'.
+define void @atomic_SEP_Int_SEP___init__(%atomic_SEP_Int* %self, i64 %value) nounwind {
+    %pointer = getelementptr %atomic_SEP_Int, %atomic_SEP_Int* %self, i64 0, i32 0
+    store i64 %value, i64* %pointer
+
+    ret void
+}
+
+; Loads an atomic integer. Release orderings load with their acquire half.
+define i64 @atomic_SEP_Int_SEP_load(%atomic_SEP_Int* %self, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int, %atomic_SEP_Int* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %relaxed
+        i32 3, label %acquire
+    ]
+
+relaxed:
+    %relaxed_value = load atomic i64, i64* %pointer monotonic, align 8
+    br label %exit
+
+acquire:
+    %acquire_value = load atomic i64, i64* %pointer acquire, align 8
+    br label %exit
+
+seq_cst:
+    %seq_cst_value = load atomic i64, i64* %pointer seq_cst, align 8
+    br label %exit
+
+exit:
+    %value = phi i64 [ %relaxed_value, %relaxed ], [ %acquire_value, %acquire ], [ %seq_cst_value, %seq_cst ]
+
+    ret i64 %value
+}
+
+; Stores to an atomic integer. Acquire orderings store with their release half.
+define void @atomic_SEP_Int_SEP_store(%atomic_SEP_Int* %self, i64 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int, %atomic_SEP_Int* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %relaxed
+        i32 2, label %release
+        i32 3, label %release
+    ]
+
+relaxed:
+    store atomic i64 %value, i64* %pointer monotonic, align 8
+    br label %exit
+
+release:
+    store atomic i64 %value, i64* %pointer release, align 8
+    br label %exit
+
+seq_cst:
+    store atomic i64 %value, i64* %pointer seq_cst, align 8
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Stores 'value' to an atomic integer, returning what it held before.
+define i64 @atomic_SEP_Int_SEP_exchange(%atomic_SEP_Int* %self, i64 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int, %atomic_SEP_Int* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous = atomicrmw xchg i64* %pointer, i64 %value monotonic
+    br label %exit
+
+acquire:
+    %acquire_previous = atomicrmw xchg i64* %pointer, i64 %value acquire
+    br label %exit
+
+release:
+    %release_previous = atomicrmw xchg i64* %pointer, i64 %value release
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous = atomicrmw xchg i64* %pointer, i64 %value acq_rel
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous = atomicrmw xchg i64* %pointer, i64 %value seq_cst
+    br label %exit
+
+exit:
+    %previous = phi i64 [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                        [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+
+    ret i64 %previous
+}
+
+; Stores 'desired' to an atomic integer if it holds what 'expected' points to,
+; returning whether it did. If not, what it held is stored to 'expected'
+; for the next attempt. Failing uses the ordering's load half.
+define i1 @atomic_SEP_Int_SEP_compare_exchange(%atomic_SEP_Int* %self, i64* %expected, i64 %desired,
+                                               i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int, %atomic_SEP_Int* %self, i64 0, i32 0
+    %expected_value = load i64, i64* %expected
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_pair = cmpxchg i64* %pointer, i64 %expected_value, i64 %desired monotonic monotonic
+    %relaxed_actual = extractvalue { i64, i1 } %relaxed_pair, 0
+    %relaxed_exchanged = extractvalue { i64, i1 } %relaxed_pair, 1
+    br label %exit
+
+acquire:
+    %acquire_pair = cmpxchg i64* %pointer, i64 %expected_value, i64 %desired acquire acquire
+    %acquire_actual = extractvalue { i64, i1 } %acquire_pair, 0
+    %acquire_exchanged = extractvalue { i64, i1 } %acquire_pair, 1
+    br label %exit
+
+release:
+    %release_pair = cmpxchg i64* %pointer, i64 %expected_value, i64 %desired release monotonic
+    %release_actual = extractvalue { i64, i1 } %release_pair, 0
+    %release_exchanged = extractvalue { i64, i1 } %release_pair, 1
+    br label %exit
+
+acq_rel:
+    %acq_rel_pair = cmpxchg i64* %pointer, i64 %expected_value, i64 %desired acq_rel acquire
+    %acq_rel_actual = extractvalue { i64, i1 } %acq_rel_pair, 0
+    %acq_rel_exchanged = extractvalue { i64, i1 } %acq_rel_pair, 1
+    br label %exit
+
+seq_cst:
+    %seq_cst_pair = cmpxchg i64* %pointer, i64 %expected_value, i64 %desired seq_cst seq_cst
+    %seq_cst_actual = extractvalue { i64, i1 } %seq_cst_pair, 0
+    %seq_cst_exchanged = extractvalue { i64, i1 } %seq_cst_pair, 1
+    br label %exit
+
+exit:
+    %actual = phi i64 [ %relaxed_actual, %relaxed ], [ %acquire_actual, %acquire ], [ %release_actual, %release ],
+                      [ %acq_rel_actual, %acq_rel ], [ %seq_cst_actual, %seq_cst ]
+    %exchanged = phi i1 [ %relaxed_exchanged, %relaxed ], [ %acquire_exchanged, %acquire ], [ %release_exchanged, %release ],
+                        [ %acq_rel_exchanged, %acq_rel ], [ %seq_cst_exchanged, %seq_cst ]
+    br i1 %exchanged, label %done, label %failed
+
+failed:
+    store i64 %actual, i64* %expected
+    br label %done
+
+done:
+    ret i1 %exchanged
+}
+
+; Like 'compare_exchange', but can fail even when it held what was
+; expected, which is cheaper on some machines, for loops retrying until
+; it succeeds.
+define i1 @atomic_SEP_Int_SEP_compare_exchange_weak(%atomic_SEP_Int* %self, i64* %expected, i64 %desired,
+                                                    i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int, %atomic_SEP_Int* %self, i64 0, i32 0
+    %expected_value = load i64, i64* %expected
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_pair = cmpxchg weak i64* %pointer, i64 %expected_value, i64 %desired monotonic monotonic
+    %relaxed_actual = extractvalue { i64, i1 } %relaxed_pair, 0
+    %relaxed_exchanged = extractvalue { i64, i1 } %relaxed_pair, 1
+    br label %exit
+
+acquire:
+    %acquire_pair = cmpxchg weak i64* %pointer, i64 %expected_value, i64 %desired acquire acquire
+    %acquire_actual = extractvalue { i64, i1 } %acquire_pair, 0
+    %acquire_exchanged = extractvalue { i64, i1 } %acquire_pair, 1
+    br label %exit
+
+release:
+    %release_pair = cmpxchg weak i64* %pointer, i64 %expected_value, i64 %desired release monotonic
+    %release_actual = extractvalue { i64, i1 } %release_pair, 0
+    %release_exchanged = extractvalue { i64, i1 } %release_pair, 1
+    br label %exit
+
+acq_rel:
+    %acq_rel_pair = cmpxchg weak i64* %pointer, i64 %expected_value, i64 %desired acq_rel acquire
+    %acq_rel_actual = extractvalue { i64, i1 } %acq_rel_pair, 0
+    %acq_rel_exchanged = extractvalue { i64, i1 } %acq_rel_pair, 1
+    br label %exit
+
+seq_cst:
+    %seq_cst_pair = cmpxchg weak i64* %pointer, i64 %expected_value, i64 %desired seq_cst seq_cst
+    %seq_cst_actual = extractvalue { i64, i1 } %seq_cst_pair, 0
+    %seq_cst_exchanged = extractvalue { i64, i1 } %seq_cst_pair, 1
+    br label %exit
+
+exit:
+    %actual = phi i64 [ %relaxed_actual, %relaxed ], [ %acquire_actual, %acquire ], [ %release_actual, %release ],
+                      [ %acq_rel_actual, %acq_rel ], [ %seq_cst_actual, %seq_cst ]
+    %exchanged = phi i1 [ %relaxed_exchanged, %relaxed ], [ %acquire_exchanged, %acquire ], [ %release_exchanged, %release ],
+                        [ %acq_rel_exchanged, %acq_rel ], [ %seq_cst_exchanged, %seq_cst ]
+    br i1 %exchanged, label %done, label %failed
+
+failed:
+    store i64 %actual, i64* %expected
+    br label %done
+
+done:
+    ret i1 %exchanged
+}
+
+; Adds 'value' to an atomic integer, returning what it held before.
+define i64 @atomic_SEP_Int_SEP_fetch_add(%atomic_SEP_Int* %self, i64 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int, %atomic_SEP_Int* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous = atomicrmw add i64* %pointer, i64 %value monotonic
+    br label %exit
+
+acquire:
+    %acquire_previous = atomicrmw add i64* %pointer, i64 %value acquire
+    br label %exit
+
+release:
+    %release_previous = atomicrmw add i64* %pointer, i64 %value release
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous = atomicrmw add i64* %pointer, i64 %value acq_rel
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous = atomicrmw add i64* %pointer, i64 %value seq_cst
+    br label %exit
+
+exit:
+    %previous = phi i64 [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                        [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+
+    ret i64 %previous
+}
+
+; Subtracts 'value' from an atomic integer, returning what it held before.
+define i64 @atomic_SEP_Int_SEP_fetch_sub(%atomic_SEP_Int* %self, i64 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int, %atomic_SEP_Int* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous = atomicrmw sub i64* %pointer, i64 %value monotonic
+    br label %exit
+
+acquire:
+    %acquire_previous = atomicrmw sub i64* %pointer, i64 %value acquire
+    br label %exit
+
+release:
+    %release_previous = atomicrmw sub i64* %pointer, i64 %value release
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous = atomicrmw sub i64* %pointer, i64 %value acq_rel
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous = atomicrmw sub i64* %pointer, i64 %value seq_cst
+    br label %exit
+
+exit:
+    %previous = phi i64 [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                        [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+
+    ret i64 %previous
+}
+
+; Ands 'value' into an atomic integer, returning what it held before.
+define i64 @atomic_SEP_Int_SEP_fetch_and(%atomic_SEP_Int* %self, i64 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int, %atomic_SEP_Int* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous = atomicrmw and i64* %pointer, i64 %value monotonic
+    br label %exit
+
+acquire:
+    %acquire_previous = atomicrmw and i64* %pointer, i64 %value acquire
+    br label %exit
+
+release:
+    %release_previous = atomicrmw and i64* %pointer, i64 %value release
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous = atomicrmw and i64* %pointer, i64 %value acq_rel
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous = atomicrmw and i64* %pointer, i64 %value seq_cst
+    br label %exit
+
+exit:
+    %previous = phi i64 [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                        [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+
+    ret i64 %previous
+}
+
+; Ors 'value' into an atomic integer, returning what it held before.
+define i64 @atomic_SEP_Int_SEP_fetch_or(%atomic_SEP_Int* %self, i64 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int, %atomic_SEP_Int* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous = atomicrmw or i64* %pointer, i64 %value monotonic
+    br label %exit
+
+acquire:
+    %acquire_previous = atomicrmw or i64* %pointer, i64 %value acquire
+    br label %exit
+
+release:
+    %release_previous = atomicrmw or i64* %pointer, i64 %value release
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous = atomicrmw or i64* %pointer, i64 %value acq_rel
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous = atomicrmw or i64* %pointer, i64 %value seq_cst
+    br label %exit
+
+exit:
+    %previous = phi i64 [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                        [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+
+    ret i64 %previous
+}
+
+; Xors 'value' into an atomic integer, returning what it held before.
+define i64 @atomic_SEP_Int_SEP_fetch_xor(%atomic_SEP_Int* %self, i64 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int, %atomic_SEP_Int* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous = atomicrmw xor i64* %pointer, i64 %value monotonic
+    br label %exit
+
+acquire:
+    %acquire_previous = atomicrmw xor i64* %pointer, i64 %value acquire
+    br label %exit
+
+release:
+    %release_previous = atomicrmw xor i64* %pointer, i64 %value release
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous = atomicrmw xor i64* %pointer, i64 %value acq_rel
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous = atomicrmw xor i64* %pointer, i64 %value seq_cst
+    br label %exit
+
+exit:
+    %previous = phi i64 [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                        [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+
+    ret i64 %previous
+}
+
+; Stores the smaller of 'value' and an atomic integer, signed, returning what it held before.
+define i64 @atomic_SEP_Int_SEP_fetch_min(%atomic_SEP_Int* %self, i64 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int, %atomic_SEP_Int* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous = atomicrmw min i64* %pointer, i64 %value monotonic
+    br label %exit
+
+acquire:
+    %acquire_previous = atomicrmw min i64* %pointer, i64 %value acquire
+    br label %exit
+
+release:
+    %release_previous = atomicrmw min i64* %pointer, i64 %value release
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous = atomicrmw min i64* %pointer, i64 %value acq_rel
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous = atomicrmw min i64* %pointer, i64 %value seq_cst
+    br label %exit
+
+exit:
+    %previous = phi i64 [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                        [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+
+    ret i64 %previous
+}
+
+; Stores the larger of 'value' and an atomic integer, signed, returning what it held before.
+define i64 @atomic_SEP_Int_SEP_fetch_max(%atomic_SEP_Int* %self, i64 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int, %atomic_SEP_Int* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous = atomicrmw max i64* %pointer, i64 %value monotonic
+    br label %exit
+
+acquire:
+    %acquire_previous = atomicrmw max i64* %pointer, i64 %value acquire
+    br label %exit
+
+release:
+    %release_previous = atomicrmw max i64* %pointer, i64 %value release
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous = atomicrmw max i64* %pointer, i64 %value acq_rel
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous = atomicrmw max i64* %pointer, i64 %value seq_cst
+    br label %exit
+
+exit:
+    %previous = phi i64 [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                        [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+
+    ret i64 %previous
+}
+
+; Makes an atomic 32-bit integer holding 'value'.
+define void @atomic_SEP_Int32_SEP___init__(%atomic_SEP_Int32* %self, i32 %value) nounwind {
+    %pointer = getelementptr %atomic_SEP_Int32, %atomic_SEP_Int32* %self, i64 0, i32 0
+    store i32 %value, i32* %pointer
+
+    ret void
+}
+
+; Loads an atomic 32-bit integer. Release orderings load with their acquire half.
+define i32 @atomic_SEP_Int32_SEP_load(%atomic_SEP_Int32* %self, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int32, %atomic_SEP_Int32* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %relaxed
+        i32 3, label %acquire
+    ]
+
+relaxed:
+    %relaxed_value = load atomic i32, i32* %pointer monotonic, align 4
+    br label %exit
+
+acquire:
+    %acquire_value = load atomic i32, i32* %pointer acquire, align 4
+    br label %exit
+
+seq_cst:
+    %seq_cst_value = load atomic i32, i32* %pointer seq_cst, align 4
+    br label %exit
+
+exit:
+    %value = phi i32 [ %relaxed_value, %relaxed ], [ %acquire_value, %acquire ], [ %seq_cst_value, %seq_cst ]
+
+    ret i32 %value
+}
+
+; Stores to an atomic 32-bit integer. Acquire orderings store with their release half.
+define void @atomic_SEP_Int32_SEP_store(%atomic_SEP_Int32* %self, i32 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int32, %atomic_SEP_Int32* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %relaxed
+        i32 2, label %release
+        i32 3, label %release
+    ]
+
+relaxed:
+    store atomic i32 %value, i32* %pointer monotonic, align 4
+    br label %exit
+
+release:
+    store atomic i32 %value, i32* %pointer release, align 4
+    br label %exit
+
+seq_cst:
+    store atomic i32 %value, i32* %pointer seq_cst, align 4
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Stores 'value' to an atomic 32-bit integer, returning what it held before.
+define i32 @atomic_SEP_Int32_SEP_exchange(%atomic_SEP_Int32* %self, i32 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int32, %atomic_SEP_Int32* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous = atomicrmw xchg i32* %pointer, i32 %value monotonic
+    br label %exit
+
+acquire:
+    %acquire_previous = atomicrmw xchg i32* %pointer, i32 %value acquire
+    br label %exit
+
+release:
+    %release_previous = atomicrmw xchg i32* %pointer, i32 %value release
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous = atomicrmw xchg i32* %pointer, i32 %value acq_rel
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous = atomicrmw xchg i32* %pointer, i32 %value seq_cst
+    br label %exit
+
+exit:
+    %previous = phi i32 [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                        [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+
+    ret i32 %previous
+}
+
+; Stores 'desired' to an atomic 32-bit integer if it holds what 'expected' points to,
+; returning whether it did. If not, what it held is stored to 'expected'
+; for the next attempt. Failing uses the ordering's load half.
+define i1 @atomic_SEP_Int32_SEP_compare_exchange(%atomic_SEP_Int32* %self, i32* %expected, i32 %desired,
+                                                 i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int32, %atomic_SEP_Int32* %self, i64 0, i32 0
+    %expected_value = load i32, i32* %expected
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_pair = cmpxchg i32* %pointer, i32 %expected_value, i32 %desired monotonic monotonic
+    %relaxed_actual = extractvalue { i32, i1 } %relaxed_pair, 0
+    %relaxed_exchanged = extractvalue { i32, i1 } %relaxed_pair, 1
+    br label %exit
+
+acquire:
+    %acquire_pair = cmpxchg i32* %pointer, i32 %expected_value, i32 %desired acquire acquire
+    %acquire_actual = extractvalue { i32, i1 } %acquire_pair, 0
+    %acquire_exchanged = extractvalue { i32, i1 } %acquire_pair, 1
+    br label %exit
+
+release:
+    %release_pair = cmpxchg i32* %pointer, i32 %expected_value, i32 %desired release monotonic
+    %release_actual = extractvalue { i32, i1 } %release_pair, 0
+    %release_exchanged = extractvalue { i32, i1 } %release_pair, 1
+    br label %exit
+
+acq_rel:
+    %acq_rel_pair = cmpxchg i32* %pointer, i32 %expected_value, i32 %desired acq_rel acquire
+    %acq_rel_actual = extractvalue { i32, i1 } %acq_rel_pair, 0
+    %acq_rel_exchanged = extractvalue { i32, i1 } %acq_rel_pair, 1
+    br label %exit
+
+seq_cst:
+    %seq_cst_pair = cmpxchg i32* %pointer, i32 %expected_value, i32 %desired seq_cst seq_cst
+    %seq_cst_actual = extractvalue { i32, i1 } %seq_cst_pair, 0
+    %seq_cst_exchanged = extractvalue { i32, i1 } %seq_cst_pair, 1
+    br label %exit
+
+exit:
+    %actual = phi i32 [ %relaxed_actual, %relaxed ], [ %acquire_actual, %acquire ], [ %release_actual, %release ],
+                      [ %acq_rel_actual, %acq_rel ], [ %seq_cst_actual, %seq_cst ]
+    %exchanged = phi i1 [ %relaxed_exchanged, %relaxed ], [ %acquire_exchanged, %acquire ], [ %release_exchanged, %release ],
+                        [ %acq_rel_exchanged, %acq_rel ], [ %seq_cst_exchanged, %seq_cst ]
+    br i1 %exchanged, label %done, label %failed
+
+failed:
+    store i32 %actual, i32* %expected
+    br label %done
+
+done:
+    ret i1 %exchanged
+}
+
+; Like 'compare_exchange', but can fail even when it held what was
+; expected, which is cheaper on some machines, for loops retrying until
+; it succeeds.
+define i1 @atomic_SEP_Int32_SEP_compare_exchange_weak(%atomic_SEP_Int32* %self, i32* %expected, i32 %desired,
+                                                      i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int32, %atomic_SEP_Int32* %self, i64 0, i32 0
+    %expected_value = load i32, i32* %expected
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_pair = cmpxchg weak i32* %pointer, i32 %expected_value, i32 %desired monotonic monotonic
+    %relaxed_actual = extractvalue { i32, i1 } %relaxed_pair, 0
+    %relaxed_exchanged = extractvalue { i32, i1 } %relaxed_pair, 1
+    br label %exit
+
+acquire:
+    %acquire_pair = cmpxchg weak i32* %pointer, i32 %expected_value, i32 %desired acquire acquire
+    %acquire_actual = extractvalue { i32, i1 } %acquire_pair, 0
+    %acquire_exchanged = extractvalue { i32, i1 } %acquire_pair, 1
+    br label %exit
+
+release:
+    %release_pair = cmpxchg weak i32* %pointer, i32 %expected_value, i32 %desired release monotonic
+    %release_actual = extractvalue { i32, i1 } %release_pair, 0
+    %release_exchanged = extractvalue { i32, i1 } %release_pair, 1
+    br label %exit
+
+acq_rel:
+    %acq_rel_pair = cmpxchg weak i32* %pointer, i32 %expected_value, i32 %desired acq_rel acquire
+    %acq_rel_actual = extractvalue { i32, i1 } %acq_rel_pair, 0
+    %acq_rel_exchanged = extractvalue { i32, i1 } %acq_rel_pair, 1
+    br label %exit
+
+seq_cst:
+    %seq_cst_pair = cmpxchg weak i32* %pointer, i32 %expected_value, i32 %desired seq_cst seq_cst
+    %seq_cst_actual = extractvalue { i32, i1 } %seq_cst_pair, 0
+    %seq_cst_exchanged = extractvalue { i32, i1 } %seq_cst_pair, 1
+    br label %exit
+
+exit:
+    %actual = phi i32 [ %relaxed_actual, %relaxed ], [ %acquire_actual, %acquire ], [ %release_actual, %release ],
+                      [ %acq_rel_actual, %acq_rel ], [ %seq_cst_actual, %seq_cst ]
+    %exchanged = phi i1 [ %relaxed_exchanged, %relaxed ], [ %acquire_exchanged, %acquire ], [ %release_exchanged, %release ],
+                        [ %acq_rel_exchanged, %acq_rel ], [ %seq_cst_exchanged, %seq_cst ]
+    br i1 %exchanged, label %done, label %failed
+
+failed:
+    store i32 %actual, i32* %expected
+    br label %done
+
+done:
+    ret i1 %exchanged
+}
+
+; Adds 'value' to an atomic 32-bit integer, returning what it held before.
+define i32 @atomic_SEP_Int32_SEP_fetch_add(%atomic_SEP_Int32* %self, i32 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int32, %atomic_SEP_Int32* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous = atomicrmw add i32* %pointer, i32 %value monotonic
+    br label %exit
+
+acquire:
+    %acquire_previous = atomicrmw add i32* %pointer, i32 %value acquire
+    br label %exit
+
+release:
+    %release_previous = atomicrmw add i32* %pointer, i32 %value release
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous = atomicrmw add i32* %pointer, i32 %value acq_rel
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous = atomicrmw add i32* %pointer, i32 %value seq_cst
+    br label %exit
+
+exit:
+    %previous = phi i32 [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                        [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+
+    ret i32 %previous
+}
+
+; Subtracts 'value' from an atomic 32-bit integer, returning what it held before.
+define i32 @atomic_SEP_Int32_SEP_fetch_sub(%atomic_SEP_Int32* %self, i32 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int32, %atomic_SEP_Int32* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous = atomicrmw sub i32* %pointer, i32 %value monotonic
+    br label %exit
+
+acquire:
+    %acquire_previous = atomicrmw sub i32* %pointer, i32 %value acquire
+    br label %exit
+
+release:
+    %release_previous = atomicrmw sub i32* %pointer, i32 %value release
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous = atomicrmw sub i32* %pointer, i32 %value acq_rel
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous = atomicrmw sub i32* %pointer, i32 %value seq_cst
+    br label %exit
+
+exit:
+    %previous = phi i32 [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                        [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+
+    ret i32 %previous
+}
+
+; Ands 'value' into an atomic 32-bit integer, returning what it held before.
+define i32 @atomic_SEP_Int32_SEP_fetch_and(%atomic_SEP_Int32* %self, i32 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int32, %atomic_SEP_Int32* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous = atomicrmw and i32* %pointer, i32 %value monotonic
+    br label %exit
+
+acquire:
+    %acquire_previous = atomicrmw and i32* %pointer, i32 %value acquire
+    br label %exit
+
+release:
+    %release_previous = atomicrmw and i32* %pointer, i32 %value release
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous = atomicrmw and i32* %pointer, i32 %value acq_rel
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous = atomicrmw and i32* %pointer, i32 %value seq_cst
+    br label %exit
+
+exit:
+    %previous = phi i32 [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                        [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+
+    ret i32 %previous
+}
+
+; Ors 'value' into an atomic 32-bit integer, returning what it held before.
+define i32 @atomic_SEP_Int32_SEP_fetch_or(%atomic_SEP_Int32* %self, i32 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int32, %atomic_SEP_Int32* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous = atomicrmw or i32* %pointer, i32 %value monotonic
+    br label %exit
+
+acquire:
+    %acquire_previous = atomicrmw or i32* %pointer, i32 %value acquire
+    br label %exit
+
+release:
+    %release_previous = atomicrmw or i32* %pointer, i32 %value release
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous = atomicrmw or i32* %pointer, i32 %value acq_rel
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous = atomicrmw or i32* %pointer, i32 %value seq_cst
+    br label %exit
+
+exit:
+    %previous = phi i32 [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                        [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+
+    ret i32 %previous
+}
+
+; Xors 'value' into an atomic 32-bit integer, returning what it held before.
+define i32 @atomic_SEP_Int32_SEP_fetch_xor(%atomic_SEP_Int32* %self, i32 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int32, %atomic_SEP_Int32* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous = atomicrmw xor i32* %pointer, i32 %value monotonic
+    br label %exit
+
+acquire:
+    %acquire_previous = atomicrmw xor i32* %pointer, i32 %value acquire
+    br label %exit
+
+release:
+    %release_previous = atomicrmw xor i32* %pointer, i32 %value release
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous = atomicrmw xor i32* %pointer, i32 %value acq_rel
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous = atomicrmw xor i32* %pointer, i32 %value seq_cst
+    br label %exit
+
+exit:
+    %previous = phi i32 [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                        [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+
+    ret i32 %previous
+}
+
+; Stores the smaller of 'value' and an atomic 32-bit integer, signed, returning what it held before.
+define i32 @atomic_SEP_Int32_SEP_fetch_min(%atomic_SEP_Int32* %self, i32 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int32, %atomic_SEP_Int32* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous = atomicrmw min i32* %pointer, i32 %value monotonic
+    br label %exit
+
+acquire:
+    %acquire_previous = atomicrmw min i32* %pointer, i32 %value acquire
+    br label %exit
+
+release:
+    %release_previous = atomicrmw min i32* %pointer, i32 %value release
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous = atomicrmw min i32* %pointer, i32 %value acq_rel
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous = atomicrmw min i32* %pointer, i32 %value seq_cst
+    br label %exit
+
+exit:
+    %previous = phi i32 [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                        [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+
+    ret i32 %previous
+}
+
+; Stores the larger of 'value' and an atomic 32-bit integer, signed, returning what it held before.
+define i32 @atomic_SEP_Int32_SEP_fetch_max(%atomic_SEP_Int32* %self, i32 %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Int32, %atomic_SEP_Int32* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous = atomicrmw max i32* %pointer, i32 %value monotonic
+    br label %exit
+
+acquire:
+    %acquire_previous = atomicrmw max i32* %pointer, i32 %value acquire
+    br label %exit
+
+release:
+    %release_previous = atomicrmw max i32* %pointer, i32 %value release
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous = atomicrmw max i32* %pointer, i32 %value acq_rel
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous = atomicrmw max i32* %pointer, i32 %value seq_cst
+    br label %exit
+
+exit:
+    %previous = phi i32 [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                        [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+
+    ret i32 %previous
+}
+
+; Makes an atomic pointer holding 'value'.
+define void @atomic_SEP_Pointer_SEP___init__(%atomic_SEP_Pointer* %self, i8* %value) nounwind {
+    %pointer = getelementptr %atomic_SEP_Pointer, %atomic_SEP_Pointer* %self, i64 0, i32 0
+    store i8* %value, i8** %pointer
+
+    ret void
+}
+
+; Loads an atomic pointer. Release orderings load with their acquire half.
+define i8* @atomic_SEP_Pointer_SEP_load(%atomic_SEP_Pointer* %self, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Pointer, %atomic_SEP_Pointer* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %relaxed
+        i32 3, label %acquire
+    ]
+
+relaxed:
+    %relaxed_value = load atomic i8*, i8** %pointer monotonic, align 8
+    br label %exit
+
+acquire:
+    %acquire_value = load atomic i8*, i8** %pointer acquire, align 8
+    br label %exit
+
+seq_cst:
+    %seq_cst_value = load atomic i8*, i8** %pointer seq_cst, align 8
+    br label %exit
+
+exit:
+    %value = phi i8* [ %relaxed_value, %relaxed ], [ %acquire_value, %acquire ], [ %seq_cst_value, %seq_cst ]
+
+    ret i8* %value
+}
+
+; Stores to an atomic pointer. Acquire orderings store with their release half.
+define void @atomic_SEP_Pointer_SEP_store(%atomic_SEP_Pointer* %self, i8* %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Pointer, %atomic_SEP_Pointer* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %relaxed
+        i32 2, label %release
+        i32 3, label %release
+    ]
+
+relaxed:
+    store atomic i8* %value, i8** %pointer monotonic, align 8
+    br label %exit
+
+release:
+    store atomic i8* %value, i8** %pointer release, align 8
+    br label %exit
+
+seq_cst:
+    store atomic i8* %value, i8** %pointer seq_cst, align 8
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Stores 'value' to an atomic pointer, returning what it held before.
+define i8* @atomic_SEP_Pointer_SEP_exchange(%atomic_SEP_Pointer* %self, i8* %value, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Pointer, %atomic_SEP_Pointer* %self, i64 0, i32 0
+    %address = bitcast i8** %pointer to i64*
+    %value_address = ptrtoint i8* %value to i64
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous_address = atomicrmw xchg i64* %address, i64 %value_address monotonic
+    %relaxed_previous = inttoptr i64 %relaxed_previous_address to i8*
+    br label %exit
+
+acquire:
+    %acquire_previous_address = atomicrmw xchg i64* %address, i64 %value_address acquire
+    %acquire_previous = inttoptr i64 %acquire_previous_address to i8*
+    br label %exit
+
+release:
+    %release_previous_address = atomicrmw xchg i64* %address, i64 %value_address release
+    %release_previous = inttoptr i64 %release_previous_address to i8*
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous_address = atomicrmw xchg i64* %address, i64 %value_address acq_rel
+    %acq_rel_previous = inttoptr i64 %acq_rel_previous_address to i8*
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous_address = atomicrmw xchg i64* %address, i64 %value_address seq_cst
+    %seq_cst_previous = inttoptr i64 %seq_cst_previous_address to i8*
+    br label %exit
+
+exit:
+    %previous = phi i8* [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                        [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+
+    ret i8* %previous
+}
+
+; Stores 'desired' to an atomic pointer if it holds what 'expected' points to,
+; returning whether it did. If not, what it held is stored to 'expected'
+; for the next attempt. Failing uses the ordering's load half.
+define i1 @atomic_SEP_Pointer_SEP_compare_exchange(%atomic_SEP_Pointer* %self, i8** %expected, i8* %desired,
+                                                   i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Pointer, %atomic_SEP_Pointer* %self, i64 0, i32 0
+    %expected_value = load i8*, i8** %expected
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_pair = cmpxchg i8** %pointer, i8* %expected_value, i8* %desired monotonic monotonic
+    %relaxed_actual = extractvalue { i8*, i1 } %relaxed_pair, 0
+    %relaxed_exchanged = extractvalue { i8*, i1 } %relaxed_pair, 1
+    br label %exit
+
+acquire:
+    %acquire_pair = cmpxchg i8** %pointer, i8* %expected_value, i8* %desired acquire acquire
+    %acquire_actual = extractvalue { i8*, i1 } %acquire_pair, 0
+    %acquire_exchanged = extractvalue { i8*, i1 } %acquire_pair, 1
+    br label %exit
+
+release:
+    %release_pair = cmpxchg i8** %pointer, i8* %expected_value, i8* %desired release monotonic
+    %release_actual = extractvalue { i8*, i1 } %release_pair, 0
+    %release_exchanged = extractvalue { i8*, i1 } %release_pair, 1
+    br label %exit
+
+acq_rel:
+    %acq_rel_pair = cmpxchg i8** %pointer, i8* %expected_value, i8* %desired acq_rel acquire
+    %acq_rel_actual = extractvalue { i8*, i1 } %acq_rel_pair, 0
+    %acq_rel_exchanged = extractvalue { i8*, i1 } %acq_rel_pair, 1
+    br label %exit
+
+seq_cst:
+    %seq_cst_pair = cmpxchg i8** %pointer, i8* %expected_value, i8* %desired seq_cst seq_cst
+    %seq_cst_actual = extractvalue { i8*, i1 } %seq_cst_pair, 0
+    %seq_cst_exchanged = extractvalue { i8*, i1 } %seq_cst_pair, 1
+    br label %exit
+
+exit:
+    %actual = phi i8* [ %relaxed_actual, %relaxed ], [ %acquire_actual, %acquire ], [ %release_actual, %release ],
+                      [ %acq_rel_actual, %acq_rel ], [ %seq_cst_actual, %seq_cst ]
+    %exchanged = phi i1 [ %relaxed_exchanged, %relaxed ], [ %acquire_exchanged, %acquire ], [ %release_exchanged, %release ],
+                        [ %acq_rel_exchanged, %acq_rel ], [ %seq_cst_exchanged, %seq_cst ]
+    br i1 %exchanged, label %done, label %failed
+
+failed:
+    store i8* %actual, i8** %expected
+    br label %done
+
+done:
+    ret i1 %exchanged
+}
+
+; Like 'compare_exchange', but can fail even when it held what was
+; expected, which is cheaper on some machines, for loops retrying until
+; it succeeds.
+define i1 @atomic_SEP_Pointer_SEP_compare_exchange_weak(%atomic_SEP_Pointer* %self, i8** %expected, i8* %desired,
+                                                        i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Pointer, %atomic_SEP_Pointer* %self, i64 0, i32 0
+    %expected_value = load i8*, i8** %expected
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_pair = cmpxchg weak i8** %pointer, i8* %expected_value, i8* %desired monotonic monotonic
+    %relaxed_actual = extractvalue { i8*, i1 } %relaxed_pair, 0
+    %relaxed_exchanged = extractvalue { i8*, i1 } %relaxed_pair, 1
+    br label %exit
+
+acquire:
+    %acquire_pair = cmpxchg weak i8** %pointer, i8* %expected_value, i8* %desired acquire acquire
+    %acquire_actual = extractvalue { i8*, i1 } %acquire_pair, 0
+    %acquire_exchanged = extractvalue { i8*, i1 } %acquire_pair, 1
+    br label %exit
+
+release:
+    %release_pair = cmpxchg weak i8** %pointer, i8* %expected_value, i8* %desired release monotonic
+    %release_actual = extractvalue { i8*, i1 } %release_pair, 0
+    %release_exchanged = extractvalue { i8*, i1 } %release_pair, 1
+    br label %exit
+
+acq_rel:
+    %acq_rel_pair = cmpxchg weak i8** %pointer, i8* %expected_value, i8* %desired acq_rel acquire
+    %acq_rel_actual = extractvalue { i8*, i1 } %acq_rel_pair, 0
+    %acq_rel_exchanged = extractvalue { i8*, i1 } %acq_rel_pair, 1
+    br label %exit
+
+seq_cst:
+    %seq_cst_pair = cmpxchg weak i8** %pointer, i8* %expected_value, i8* %desired seq_cst seq_cst
+    %seq_cst_actual = extractvalue { i8*, i1 } %seq_cst_pair, 0
+    %seq_cst_exchanged = extractvalue { i8*, i1 } %seq_cst_pair, 1
+    br label %exit
+
+exit:
+    %actual = phi i8* [ %relaxed_actual, %relaxed ], [ %acquire_actual, %acquire ], [ %release_actual, %release ],
+                      [ %acq_rel_actual, %acq_rel ], [ %seq_cst_actual, %seq_cst ]
+    %exchanged = phi i1 [ %relaxed_exchanged, %relaxed ], [ %acquire_exchanged, %acquire ], [ %release_exchanged, %release ],
+                        [ %acq_rel_exchanged, %acq_rel ], [ %seq_cst_exchanged, %seq_cst ]
+    br i1 %exchanged, label %done, label %failed
+
+failed:
+    store i8* %actual, i8** %expected
+    br label %done
+
+done:
+    ret i1 %exchanged
+}
+
+; Makes an atomic flag which is clear.
+define void @atomic_SEP_Flag_SEP___init__(%atomic_SEP_Flag* %self) nounwind {
+    store %atomic_SEP_Flag zeroinitializer, %atomic_SEP_Flag* %self
+
+    ret void
+}
+
+; Sets an atomic flag, returning whether it was set before.
+define i1 @atomic_SEP_Flag_SEP_test_and_set(%atomic_SEP_Flag* %self, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Flag, %atomic_SEP_Flag* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+relaxed:
+    %relaxed_previous = atomicrmw xchg i8* %pointer, i8 1 monotonic
+    br label %exit
+
+acquire:
+    %acquire_previous = atomicrmw xchg i8* %pointer, i8 1 acquire
+    br label %exit
+
+release:
+    %release_previous = atomicrmw xchg i8* %pointer, i8 1 release
+    br label %exit
+
+acq_rel:
+    %acq_rel_previous = atomicrmw xchg i8* %pointer, i8 1 acq_rel
+    br label %exit
+
+seq_cst:
+    %seq_cst_previous = atomicrmw xchg i8* %pointer, i8 1 seq_cst
+    br label %exit
+
+exit:
+    %previous = phi i8 [ %relaxed_previous, %relaxed ], [ %acquire_previous, %acquire ], [ %release_previous, %release ],
+                       [ %acq_rel_previous, %acq_rel ], [ %seq_cst_previous, %seq_cst ]
+    %was_set = trunc i8 %previous to i1
+
+    ret i1 %was_set
+}
+
+; Clears an atomic flag. Acquire orderings store with their release half.
+define void @atomic_SEP_Flag_SEP_clear(%atomic_SEP_Flag* %self, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Flag, %atomic_SEP_Flag* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %relaxed
+        i32 2, label %release
+        i32 3, label %release
+    ]
+
+relaxed:
+    store atomic i8 0, i8* %pointer monotonic, align 1
+    br label %exit
+
+release:
+    store atomic i8 0, i8* %pointer release, align 1
+    br label %exit
+
+seq_cst:
+    store atomic i8 0, i8* %pointer seq_cst, align 1
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Gets whether an atomic flag is set. Release orderings load with their
+; acquire half.
+define i1 @atomic_SEP_Flag_SEP_test(%atomic_SEP_Flag* %self, i32 %order) nounwind alwaysinline {
+entry:
+    %pointer = getelementptr %atomic_SEP_Flag, %atomic_SEP_Flag* %self, i64 0, i32 0
+    switch i32 %order, label %seq_cst [
+        i32 0, label %relaxed
+        i32 1, label %acquire
+        i32 2, label %relaxed
+        i32 3, label %acquire
+    ]
+
+relaxed:
+    %relaxed_value = load atomic i8, i8* %pointer monotonic, align 1
+    br label %exit
+
+acquire:
+    %acquire_value = load atomic i8, i8* %pointer acquire, align 1
+    br label %exit
+
+seq_cst:
+    %seq_cst_value = load atomic i8, i8* %pointer seq_cst, align 1
+    br label %exit
+
+exit:
+    %value = phi i8 [ %relaxed_value, %relaxed ], [ %acquire_value, %acquire ], [ %seq_cst_value, %seq_cst ]
+    %is_set = trunc i8 %value to i1
+
+    ret i1 %is_set
+}
+
+; Orders the loads and stores around it for other threads, as 'order'
+; says, pairing with other fences and atomic operations.
+define void @atomic_SEP_fence(i32 %order) nounwind alwaysinline {
+entry:
+    switch i32 %order, label %seq_cst [
+        i32 0, label %exit
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+acquire:
+    fence acquire
+    br label %exit
+
+release:
+    fence release
+    br label %exit
+
+acq_rel:
+    fence acq_rel
+    br label %exit
+
+seq_cst:
+    fence seq_cst
+    br label %exit
+
+exit:
+    ret void
+}
+
+; Like 'fence', but only orders them for signal handlers on the same
+; thread, so it stops the compiler reordering them without emitting an
+; instruction.
+define void @atomic_SEP_signal_fence(i32 %order) nounwind alwaysinline {
+entry:
+    switch i32 %order, label %seq_cst [
+        i32 0, label %exit
+        i32 1, label %acquire
+        i32 2, label %release
+        i32 3, label %acq_rel
+    ]
+
+acquire:
+    fence syncscope("singlethread") acquire
+    br label %exit
+
+release:
+    fence syncscope("singlethread") release
+    br label %exit
+
+acq_rel:
+    fence syncscope("singlethread") acq_rel
+    br label %exit
+
+seq_cst:
+    fence syncscope("singlethread") seq_cst
+    br label %exit
+
+exit:
+    ret void
+}
+
+; The classes marked '@align(64)', whose instances start cache lines, see
+; 'codegen/align.c'.
+!exeme.align = !{!0, !1}
+!0 = !{%sync_SEP_Channel* null, i64 64}
+!1 = !{%sync_SEP_Queue* null, i64 64}
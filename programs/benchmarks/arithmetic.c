@@ -0,0 +1,105 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+/**
+ * Builds the kernels 'programs/benchmarks/arithmetic.ll' times with the
+ * builders in 'codegen/arithmetic.c', so it measures what they emit, and
+ * writes them to the file given as a package to build it with.
+ */
+
+#include "../../src/includes.c"
+
+#include <llvm-c/Analysis.h>
+#include <llvm-c/BitWriter.h>
+#include <llvm-c/Core.h>
+
+#include "../../src/codegen/arithmetic.c"
+#include "../../src/utils/panic.c"
+#include "../../src/utils/string.c"
+
+/**
+ * Represents the kernel being built.
+ */
+struct Kernel {
+    LLVMBuilderRef builder;
+    LLVMValueRef left, right;
+};
+
+/**
+ * Adds a kernel taking two operands, positioning a builder in its body.
+ *
+ * @param module The module.
+ * @param NAME   The name of the kernel.
+ * @param result The type of the kernel's result.
+ * @param left   The type of its left operand.
+ * @param right  The type of its right operand.
+ *
+ * @return The kernel, to finish with kernel_end_.
+ */
+struct Kernel kernel_begin_(LLVMModuleRef module, const char *NAME, LLVMTypeRef result, LLVMTypeRef left,
+                            LLVMTypeRef right) {
+    LLVMContextRef context = LLVMGetModuleContext(module);
+    LLVMValueRef function =
+        LLVMAddFunction(module, NAME, LLVMFunctionType(result, (LLVMTypeRef[]){left, right}, 2, false));
+    struct Kernel kernel = {LLVMCreateBuilderInContext(context), LLVMGetParam(function, 0), LLVMGetParam(function, 1)};
+
+    LLVMPositionBuilderAtEnd(kernel.builder, LLVMAppendBasicBlockInContext(context, function, "entry"));
+
+    return kernel;
+}
+
+/**
+ * Returns a kernel's result.
+ *
+ * @param kernel The kernel.
+ * @param result The result.
+ */
+void kernel_end_(struct Kernel kernel, LLVMValueRef result) {
+    LLVMBuildRet(kernel.builder, result);
+    LLVMDisposeBuilder(kernel.builder);
+}
+
+int main(const int argc, const char **argv) {
+    LLVMContextRef context = LLVMContextCreate();
+    LLVMModuleRef module = LLVMModuleCreateWithNameInContext("arithmetic", context);
+    LLVMTypeRef int32 = LLVMInt32TypeInContext(context), int64 = LLVMInt64TypeInContext(context),
+                float64 = LLVMDoubleTypeInContext(context);
+    struct Kernel kernel;
+    char *error = NULL;
+
+    if (argc != 2) {
+        panic("expected the file to write the kernels to");
+    }
+
+    kernel = kernel_begin_(module, "power_by_squaring", int64, int64, int64); // u64 ** u64
+    kernel_end_(kernel, arithmetic_buildPower(kernel.builder, kernel.left, kernel.right, false));
+
+    kernel = kernel_begin_(module, "float_power_by_integer", float64, float64, int32); // f64 ** i32
+    kernel_end_(kernel, arithmetic_buildPower(kernel.builder, kernel.left, kernel.right, true));
+
+    kernel = kernel_begin_(module, "float_power_by_float", float64, float64, float64); // f64 ** f64
+    kernel_end_(kernel, arithmetic_buildPower(kernel.builder, kernel.left, kernel.right, true));
+
+    kernel = kernel_begin_(module, "floor_divide", int64, int64, int64); // i64 // i64
+    kernel_end_(kernel, arithmetic_buildFloorDivision(kernel.builder, kernel.left, kernel.right, true));
+
+    kernel = kernel_begin_(module, "floor_divide_by_7", int64, int64, int64); // i64 // 7, ignoring the divisor given
+    kernel_end_(kernel, arithmetic_buildFloorDivision(kernel.builder, kernel.left, LLVMConstInt(int64, 7, false), true));
+
+    kernel = kernel_begin_(module, "floor_modulo", int64, int64, int64); // The remainder of i64 // i64
+    kernel_end_(kernel, arithmetic_buildFloorModulo(kernel.builder, kernel.left, kernel.right, true));
+
+    if (LLVMVerifyModule(module, LLVMReturnStatusAction, &error)) {
+        panic(stringConcatenate(2, "built invalid kernels: ", error));
+    } else if (LLVMWriteBitcodeToFile(module, argv[1]) != 0) {
+        panic(stringConcatenate(3, "failed to write '", argv[1], "'"));
+    }
+
+    LLVMDisposeMessage(error);
+    LLVMDisposeModule(module);
+    LLVMContextDispose(context);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,281 @@
+; Benchmarks the '**' and '//' operators, with operands known only at
+; runtime, against naive lowerings of them. The kernels timed for Exeme are
+; built by 'codegen/arithmetic.c' itself, from 'arithmetic.c' next to this
+; file, so they measure what the compiler emits. Integers to integer powers
+; are lowered to a loop of exponentiation by squaring, which runs once per
+; bit of the power, rather than once per multiply. Floats to integer powers
+; use 'llvm.powi' rather than converting the power to a float for libm's
+; 'pow', which is still called for floats to float powers. '//' corrects a
+; truncating divide rather than flooring a float divide, and constant
+; divisors need no correction. Build the kernels with the
+; 'arithmetic-kernels' target, then build and run with
+; 'build/bin/arithmetic-kernels arithmetic-kernels.bc', 'exeme build
+; programs/benchmarks/arithmetic.ll -p arithmetic-kernels.bc -o
+; arithmetic' and './arithmetic'.
+;
+;   power: u64 = 21
+;   total: u64 = 0
+;   for n = range(1, 10000001) {
+;       total += n ** power
+;   }
+;
+;   divisor: i64 = 7
+;   total: i64 = 0
+;   for n = range(-5000000, 5000000) {
+;       total += n // divisor
+;   }
+
+%timespec = type { i64, i64 }
+
+@.integer_format = private unnamed_addr constant [33 x i8] c"%-40s %8.2f ns/op  (result %ld)\0A\00"
+@.float_format = private unnamed_addr constant [32 x i8] c"%-40s %8.2f ns/op  (result %g)\0A\00"
+@.squaring_name = private unnamed_addr constant [24 x i8] c"u64 ** u64, by squaring\00"
+@.multiplying_name = private unnamed_addr constant [28 x i8] c"u64 ** u64, naive, multiply\00"
+@.powi_name = private unnamed_addr constant [22 x i8] c"f64 ** i32, llvm.powi\00"
+@.pow_name = private unnamed_addr constant [28 x i8] c"f64 ** i32, naive, libm pow\00"
+@.float_pow_name = private unnamed_addr constant [21 x i8] c"f64 ** f64, libm pow\00"
+@.floor_divide_name = private unnamed_addr constant [27 x i8] c"i64 // i64, corrected sdiv\00"
+@.floor_divide_by_7_name = private unnamed_addr constant [28 x i8] c"i64 // 7, complemented udiv\00"
+@.float_floor_divide_name = private unnamed_addr constant [30 x i8] c"i64 // i64, naive, libm floor\00"
+@.floor_modulo_name = private unnamed_addr constant [36 x i8] c"i64 // i64 remainder, adjusted srem\00"
+@.float_floor_modulo_name = private unnamed_addr constant [40 x i8] c"i64 // i64 remainder, naive, libm floor\00"
+
+; Read through volatile loads, so the operands are not known when optimising
+@power = internal global i64 21
+@divisor = internal global i64 7
+
+; Built by 'codegen/arithmetic.c', see 'arithmetic.c'
+declare i64 @power_by_squaring(i64, i64)
+declare double @float_power_by_integer(double, i32)
+declare double @float_power_by_float(double, double)
+declare i64 @floor_divide(i64, i64)
+declare i64 @floor_divide_by_7(i64, i64)
+declare i64 @floor_modulo(i64, i64)
+
+declare double @llvm.floor.f64(double)
+declare double @pow(double, double)
+declare i32 @clock_gettime(i32, %timespec*)
+declare i32 @printf(i8*, ...)
+
+; Gets the time, in nanoseconds.
+define internal i64 @now() {
+    %time = alloca %timespec
+    call i32 @clock_gettime(i32 1, %timespec* %time) ; CLOCK_MONOTONIC
+    %seconds_pointer = getelementptr %timespec, %timespec* %time, i64 0, i32 0
+    %seconds = load i64, i64* %seconds_pointer
+    %nanoseconds_pointer = getelementptr %timespec, %timespec* %time, i64 0, i32 1
+    %nanoseconds = load i64, i64* %nanoseconds_pointer
+    %scaled = mul i64 %seconds, 1000000000
+    %total = add i64 %scaled, %nanoseconds
+
+    ret i64 %total
+}
+
+; Raises 'base' to 'exponent' by multiplying it in 'exponent' times.
+define internal i64 @power_by_multiplying(i64 %base, i64 %exponent) {
+entry:
+    br label %condition
+
+condition:
+    %result = phi i64 [ 1, %entry ], [ %next_result, %body ]
+    %count = phi i64 [ 0, %entry ], [ %next_count, %body ]
+    %is_raising = icmp ult i64 %count, %exponent
+    br i1 %is_raising, label %body, label %exit
+
+body:
+    %next_result = mul i64 %result, %base
+    %next_count = add i64 %count, 1
+    br label %condition
+
+exit:
+    ret i64 %result
+}
+
+; Raises 'base' to 'exponent', converting the power to a float every time
+; for libm's 'pow', as a naive lowering would.
+define internal double @float_power_by_converting(double %base, i32 %exponent) {
+    %converted = sitofp i32 %exponent to double
+    %raised = call double @pow(double %base, double %converted) nobuiltin
+    ret double %raised
+}
+
+; Divides 'left' by 'right' as floats, and floors the quotient.
+define internal i64 @float_floor_divide(i64 %left, i64 %right) {
+    %left_float = sitofp i64 %left to double
+    %right_float = sitofp i64 %right to double
+    %quotient = fdiv double %left_float, %right_float
+    %floored = call double @llvm.floor.f64(double %quotient)
+    %result = fptosi double %floored to i64
+    ret i64 %result
+}
+
+; Gets the remainder of 'left // right' from the floored float quotient.
+define internal i64 @float_floor_modulo(i64 %left, i64 %right) {
+    %quotient = call i64 @float_floor_divide(i64 %left, i64 %right)
+    %product = mul i64 %quotient, %right
+    %result = sub i64 %left, %product
+    ret i64 %result
+}
+
+; Sums 'n ** power' for 'n' from 1 to 10000000, raising with 'raise'.
+define internal i64 @sum_integers(i64 (i64, i64)* %raise) {
+entry:
+    %power = load volatile i64, i64* @power
+    br label %condition
+
+condition:
+    %n = phi i64 [ 1, %entry ], [ %next_n, %body ]
+    %total = phi i64 [ 0, %entry ], [ %next_total, %body ]
+    %is_summing = icmp ule i64 %n, 10000000
+    br i1 %is_summing, label %body, label %exit
+
+body:
+    %raised = call i64 %raise(i64 %n, i64 %power)
+    %next_total = add i64 %total, %raised
+    %next_n = add i64 %n, 1
+    br label %condition
+
+exit:
+    ret i64 %total
+}
+
+; Sums 'n ** power' for 'n' from 1 to 10000000 divided by 10000000, with
+; 'raise' taking the power as an integer, or 'raise_by_float' taking it as
+; a float from the start if 'raise' is null.
+define internal double @sum_floats(double (double, i32)* %raise, double (double, double)* %raise_by_float) {
+entry:
+    %power = load volatile i64, i64* @power
+    %integer_power = trunc i64 %power to i32
+    %float_power = sitofp i64 %power to double
+    %is_by_integer = icmp ne double (double, i32)* %raise, null
+    br label %condition
+
+condition:
+    %n = phi i64 [ 1, %entry ], [ %next_n, %next ]
+    %total = phi double [ 0.0, %entry ], [ %next_total, %next ]
+    %is_summing = icmp ule i64 %n, 10000000
+    br i1 %is_summing, label %body, label %exit
+
+body:
+    %n_float = sitofp i64 %n to double
+    %base = fdiv double %n_float, 10000000.0
+    br i1 %is_by_integer, label %by_integer, label %by_float
+
+by_integer:
+    %by_integer_raised = call double %raise(double %base, i32 %integer_power)
+    br label %next
+
+by_float:
+    %by_float_raised = call double %raise_by_float(double %base, double %float_power)
+    br label %next
+
+next:
+    %raised = phi double [ %by_integer_raised, %by_integer ], [ %by_float_raised, %by_float ]
+    %next_total = fadd double %total, %raised
+    %next_n = add i64 %n, 1
+    br label %condition
+
+exit:
+    ret double %total
+}
+
+; Sums 'n // divisor' for 'n' from -5000000 to 4999999, dividing with
+; 'divide', so half of the dividends are negative.
+define internal i64 @sum_divisions(i64 (i64, i64)* %divide) {
+entry:
+    %divisor = load volatile i64, i64* @divisor
+    br label %condition
+
+condition:
+    %n = phi i64 [ -5000000, %entry ], [ %next_n, %body ]
+    %total = phi i64 [ 0, %entry ], [ %next_total, %body ]
+    %is_summing = icmp slt i64 %n, 5000000
+    br i1 %is_summing, label %body, label %exit
+
+body:
+    %divided = call i64 %divide(i64 %n, i64 %divisor)
+    %next_total = add i64 %total, %divided
+    %next_n = add i64 %n, 1
+    br label %condition
+
+exit:
+    ret i64 %total
+}
+
+; Gets how long each operation took, in nanoseconds, since 'start'.
+define internal double @per_operation(i64 %start) {
+    %end = call i64 @now()
+    %elapsed = sub i64 %end, %start
+    %elapsed_float = sitofp i64 %elapsed to double
+    %per_operation = fdiv double %elapsed_float, 10000000.0
+
+    ret double %per_operation
+}
+
+define internal void @report_integers(i8* %name, i64 %start, i64 %result) {
+    %per_operation = call double @per_operation(i64 %start)
+    %format = getelementptr [33 x i8], [33 x i8]* @.integer_format, i64 0, i64 0
+    call i32 (i8*, ...) @printf(i8* %format, i8* %name, double %per_operation, i64 %result)
+
+    ret void
+}
+
+define internal void @report_floats(i8* %name, i64 %start, double %result) {
+    %per_operation = call double @per_operation(i64 %start)
+    %format = getelementptr [32 x i8], [32 x i8]* @.float_format, i64 0, i64 0
+    call i32 (i8*, ...) @printf(i8* %format, i8* %name, double %per_operation, double %result)
+
+    ret void
+}
+
+; Times 'sum_divisions' with 'divide', and reports it under 'name'.
+define internal void @time_divisions(i64 (i64, i64)* %divide, i8* %name) {
+    %start = call i64 @now()
+    %total = call i64 @sum_divisions(i64 (i64, i64)* %divide)
+    call void @report_integers(i8* %name, i64 %start, i64 %total)
+
+    ret void
+}
+
+define i32 @main() {
+    %squaring_start = call i64 @now()
+    %squaring_total = call i64 @sum_integers(i64 (i64, i64)* @power_by_squaring)
+    %squaring_name = getelementptr [24 x i8], [24 x i8]* @.squaring_name, i64 0, i64 0
+    call void @report_integers(i8* %squaring_name, i64 %squaring_start, i64 %squaring_total)
+
+    %multiplying_start = call i64 @now()
+    %multiplying_total = call i64 @sum_integers(i64 (i64, i64)* @power_by_multiplying)
+    %multiplying_name = getelementptr [28 x i8], [28 x i8]* @.multiplying_name, i64 0, i64 0
+    call void @report_integers(i8* %multiplying_name, i64 %multiplying_start, i64 %multiplying_total)
+
+    %powi_start = call i64 @now()
+    %powi_total = call double @sum_floats(double (double, i32)* @float_power_by_integer,
+                                          double (double, double)* null)
+    %powi_name = getelementptr [22 x i8], [22 x i8]* @.powi_name, i64 0, i64 0
+    call void @report_floats(i8* %powi_name, i64 %powi_start, double %powi_total)
+
+    %pow_start = call i64 @now()
+    %pow_total = call double @sum_floats(double (double, i32)* @float_power_by_converting,
+                                         double (double, double)* null)
+    %pow_name = getelementptr [28 x i8], [28 x i8]* @.pow_name, i64 0, i64 0
+    call void @report_floats(i8* %pow_name, i64 %pow_start, double %pow_total)
+
+    %float_pow_start = call i64 @now()
+    %float_pow_total = call double @sum_floats(double (double, i32)* null,
+                                               double (double, double)* @float_power_by_float)
+    %float_pow_name = getelementptr [21 x i8], [21 x i8]* @.float_pow_name, i64 0, i64 0
+    call void @report_floats(i8* %float_pow_name, i64 %float_pow_start, double %float_pow_total)
+
+    %floor_divide_name = getelementptr [27 x i8], [27 x i8]* @.floor_divide_name, i64 0, i64 0
+    call void @time_divisions(i64 (i64, i64)* @floor_divide, i8* %floor_divide_name)
+    %floor_divide_by_7_name = getelementptr [28 x i8], [28 x i8]* @.floor_divide_by_7_name, i64 0, i64 0
+    call void @time_divisions(i64 (i64, i64)* @floor_divide_by_7, i8* %floor_divide_by_7_name)
+    %float_floor_divide_name = getelementptr [30 x i8], [30 x i8]* @.float_floor_divide_name, i64 0, i64 0
+    call void @time_divisions(i64 (i64, i64)* @float_floor_divide, i8* %float_floor_divide_name)
+    %floor_modulo_name = getelementptr [36 x i8], [36 x i8]* @.floor_modulo_name, i64 0, i64 0
+    call void @time_divisions(i64 (i64, i64)* @floor_modulo, i8* %floor_modulo_name)
+    %float_floor_modulo_name = getelementptr [40 x i8], [40 x i8]* @.float_floor_modulo_name, i64 0, i64 0
+    call void @time_divisions(i64 (i64, i64)* @float_floor_modulo, i8* %float_floor_modulo_name)
+
+    ret i32 0
+}
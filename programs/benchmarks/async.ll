@@ -0,0 +1,298 @@
+; Benchmarks awaiting, with 'async func's lowered as 'runtime-llvm-ir/async.ll'
+; describes. Build and run with 'exeme build programs/benchmarks/async.ll -o
+; async' and './async'.
+;
+;   async func increment(value: i64) -> i64 {
+;       return value + 1
+;   }
+;
+;   async func count(times: i64) -> i64 {
+;       total = 0
+;       for _ in range(times) {
+;           total = await increment(total)
+;       }
+;       return total
+;   }
+;
+;   async func echo(read_fd: i32, write_fd: i32, times: i64) -> i64 {
+;       for _ in range(times) {
+;           write(write_fd, "!", 1)
+;           await io.wait(read_fd, POLLIN)
+;           read(read_fd, buffer, 1)
+;       }
+;       return times
+;   }
+
+%async_SEP_Waiter = type { i8*, %async_SEP_Waiter*, i64 }
+%async_SEP_Promise = type { %async_SEP_Waiter* }
+%async_SEP_Executor = type { %async_SEP_Waiter*, %async_SEP_Waiter*, i64 (%async_SEP_Executor*, i8*, i1)*, i8* }
+%promise_i64 = type { %async_SEP_Promise, i64 }
+%timespec = type { i64, i64 }
+
+@.count_format = private unnamed_addr constant [48 x i8] c"%-28s %10.1f ns/await  (%ld awaits, total %ld)\0A\00"
+@.count_name = private unnamed_addr constant [19 x i8] c"await, synchronous\00"
+@.echo_name = private unnamed_addr constant [19 x i8] c"await, std.io poll\00"
+@.exclamation = private unnamed_addr constant [1 x i8] c"!"
+
+declare token @llvm.coro.id(i32, i8*, i8*, i8*)
+declare i1 @llvm.coro.alloc(token)
+declare i64 @llvm.coro.size.i64()
+declare i8* @llvm.coro.begin(token, i8*)
+declare token @llvm.coro.save(i8*)
+declare i8 @llvm.coro.suspend(token, i1)
+declare i8* @llvm.coro.free(token, i8*)
+declare i1 @llvm.coro.end(i8*, i1)
+declare i1 @llvm.coro.done(i8*)
+declare void @llvm.coro.destroy(i8*)
+declare i8* @llvm.coro.promise(i8*, i32, i1)
+declare i8* @malloc(i64)
+declare void @free(i8*)
+declare i32 @pipe([2 x i32]*)
+declare i64 @read(i32, i8*, i64)
+declare i64 @write(i32, i8*, i64)
+declare i32 @clock_gettime(i32, %timespec*)
+declare i32 @printf(i8*, ...)
+declare void @async_SEP_Executor_SEP___init__(%async_SEP_Executor*)
+declare %async_SEP_Executor* @async_SEP_Executor_SEP___enter__(%async_SEP_Executor*)
+declare void @async_SEP_Executor_SEP___exit__(%async_SEP_Executor*, %async_SEP_Executor*)
+declare i1 @async_SEP_Executor_SEP_run(%async_SEP_Executor*, i8*)
+declare void @async_SEP_complete(%async_SEP_Promise*)
+declare void @io_SEP_wait(i32, i16, %async_SEP_Waiter*)
+
+define internal i8* @increment(i64 %value) "coroutine.presplit"="0" {
+entry:
+    %promise = alloca %promise_i64
+    %promise_bytes = bitcast %promise_i64* %promise to i8*
+    %id = call token @llvm.coro.id(i32 0, i8* %promise_bytes, i8* null, i8* null)
+    %needs_frame = call i1 @llvm.coro.alloc(token %id)
+    br i1 %needs_frame, label %allocate, label %begin
+
+allocate:
+    %size = call i64 @llvm.coro.size.i64()
+    %allocated = call i8* @malloc(i64 %size)
+    br label %begin
+
+begin:
+    %memory = phi i8* [ null, %entry ], [ %allocated, %allocate ]
+    %handle = call i8* @llvm.coro.begin(token %id, i8* %memory)
+    %header = getelementptr %promise_i64, %promise_i64* %promise, i64 0, i32 0
+    store %async_SEP_Promise zeroinitializer, %async_SEP_Promise* %header
+
+    %incremented = add i64 %value, 1
+    %result_pointer = getelementptr %promise_i64, %promise_i64* %promise, i64 0, i32 1
+    store i64 %incremented, i64* %result_pointer
+    call void @async_SEP_complete(%async_SEP_Promise* %header)
+    %final = call i8 @llvm.coro.suspend(token none, i1 true)
+    switch i8 %final, label %suspend [ i8 1, label %cleanup ]
+
+cleanup:
+    %frame = call i8* @llvm.coro.free(token %id, i8* %handle)
+    call void @free(i8* %frame)
+    br label %suspend
+
+suspend:
+    call i1 @llvm.coro.end(i8* %handle, i1 false)
+
+    ret i8* %handle
+}
+
+define internal i8* @count(i64 %times) "coroutine.presplit"="0" {
+entry:
+    %promise = alloca %promise_i64
+    %waiter = alloca %async_SEP_Waiter
+    %promise_bytes = bitcast %promise_i64* %promise to i8*
+    %id = call token @llvm.coro.id(i32 0, i8* %promise_bytes, i8* null, i8* null)
+    %needs_frame = call i1 @llvm.coro.alloc(token %id)
+    br i1 %needs_frame, label %allocate, label %begin
+
+allocate:
+    %size = call i64 @llvm.coro.size.i64()
+    %allocated = call i8* @malloc(i64 %size)
+    br label %begin
+
+begin:
+    %memory = phi i8* [ null, %entry ], [ %allocated, %allocate ]
+    %handle = call i8* @llvm.coro.begin(token %id, i8* %memory)
+    %header = getelementptr %promise_i64, %promise_i64* %promise, i64 0, i32 0
+    store %async_SEP_Promise zeroinitializer, %async_SEP_Promise* %header
+    %waiter_handle_pointer = getelementptr %async_SEP_Waiter, %async_SEP_Waiter* %waiter, i64 0, i32 0
+    store i8* %handle, i8** %waiter_handle_pointer
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %begin ], [ %next_index, %ready ]
+    %total = phi i64 [ 0, %begin ], [ %incremented, %ready ]
+    %is_counting = icmp ult i64 %index, %times
+    br i1 %is_counting, label %await, label %complete
+
+await:
+    %child = call i8* @increment(i64 %total)
+    %is_done = call i1 @llvm.coro.done(i8* %child)
+    br i1 %is_done, label %ready, label %wait
+
+wait:
+    %child_promise_bytes = call i8* @llvm.coro.promise(i8* %child, i32 8, i1 false)
+    %child_promise = bitcast i8* %child_promise_bytes to %promise_i64*
+    %continuation_pointer = getelementptr %promise_i64, %promise_i64* %child_promise, i64 0, i32 0, i32 0
+    store %async_SEP_Waiter* %waiter, %async_SEP_Waiter** %continuation_pointer
+    %save = call token @llvm.coro.save(i8* %handle)
+    %resumed = call i8 @llvm.coro.suspend(token %save, i1 false)
+    switch i8 %resumed, label %suspend [ i8 0, label %ready
+                                         i8 1, label %destroy_child ]
+
+destroy_child:
+    call void @llvm.coro.destroy(i8* %child)
+    br label %cleanup
+
+ready:
+    %ready_promise_bytes = call i8* @llvm.coro.promise(i8* %child, i32 8, i1 false)
+    %ready_promise = bitcast i8* %ready_promise_bytes to %promise_i64*
+    %child_result_pointer = getelementptr %promise_i64, %promise_i64* %ready_promise, i64 0, i32 1
+    %incremented = load i64, i64* %child_result_pointer
+    call void @llvm.coro.destroy(i8* %child)
+    %next_index = add i64 %index, 1
+    br label %condition
+
+complete:
+    %result_pointer = getelementptr %promise_i64, %promise_i64* %promise, i64 0, i32 1
+    store i64 %total, i64* %result_pointer
+    call void @async_SEP_complete(%async_SEP_Promise* %header)
+    %final = call i8 @llvm.coro.suspend(token none, i1 true)
+    switch i8 %final, label %suspend [ i8 1, label %cleanup ]
+
+cleanup:
+    %frame = call i8* @llvm.coro.free(token %id, i8* %handle)
+    call void @free(i8* %frame)
+    br label %suspend
+
+suspend:
+    call i1 @llvm.coro.end(i8* %handle, i1 false)
+
+    ret i8* %handle
+}
+
+define internal i8* @echo(i32 %read_fd, i32 %write_fd, i64 %times) "coroutine.presplit"="0" {
+entry:
+    %promise = alloca %promise_i64
+    %waiter = alloca %async_SEP_Waiter
+    %buffer = alloca i8
+    %promise_bytes = bitcast %promise_i64* %promise to i8*
+    %id = call token @llvm.coro.id(i32 0, i8* %promise_bytes, i8* null, i8* null)
+    %needs_frame = call i1 @llvm.coro.alloc(token %id)
+    br i1 %needs_frame, label %allocate, label %begin
+
+allocate:
+    %size = call i64 @llvm.coro.size.i64()
+    %allocated = call i8* @malloc(i64 %size)
+    br label %begin
+
+begin:
+    %memory = phi i8* [ null, %entry ], [ %allocated, %allocate ]
+    %handle = call i8* @llvm.coro.begin(token %id, i8* %memory)
+    %header = getelementptr %promise_i64, %promise_i64* %promise, i64 0, i32 0
+    store %async_SEP_Promise zeroinitializer, %async_SEP_Promise* %header
+    %waiter_handle_pointer = getelementptr %async_SEP_Waiter, %async_SEP_Waiter* %waiter, i64 0, i32 0
+    store i8* %handle, i8** %waiter_handle_pointer
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %begin ], [ %next_index, %ready ]
+    %is_echoing = icmp ult i64 %index, %times
+    br i1 %is_echoing, label %await, label %complete
+
+await:
+    %exclamation = getelementptr [1 x i8], [1 x i8]* @.exclamation, i64 0, i64 0
+    call i64 @write(i32 %write_fd, i8* %exclamation, i64 1)
+    call void @io_SEP_wait(i32 %read_fd, i16 1, %async_SEP_Waiter* %waiter) ; POLLIN
+    %save = call token @llvm.coro.save(i8* %handle)
+    %resumed = call i8 @llvm.coro.suspend(token %save, i1 false)
+    switch i8 %resumed, label %suspend [ i8 0, label %ready
+                                         i8 1, label %cleanup ]
+
+ready:
+    call i64 @read(i32 %read_fd, i8* %buffer, i64 1)
+    %next_index = add i64 %index, 1
+    br label %condition
+
+complete:
+    %result_pointer = getelementptr %promise_i64, %promise_i64* %promise, i64 0, i32 1
+    store i64 %times, i64* %result_pointer
+    call void @async_SEP_complete(%async_SEP_Promise* %header)
+    %final = call i8 @llvm.coro.suspend(token none, i1 true)
+    switch i8 %final, label %suspend [ i8 1, label %cleanup ]
+
+cleanup:
+    %frame = call i8* @llvm.coro.free(token %id, i8* %handle)
+    call void @free(i8* %frame)
+    br label %suspend
+
+suspend:
+    call i1 @llvm.coro.end(i8* %handle, i1 false)
+
+    ret i8* %handle
+}
+
+; Gets the time, in nanoseconds.
+define internal i64 @now() {
+    %time = alloca %timespec
+    call i32 @clock_gettime(i32 1, %timespec* %time) ; CLOCK_MONOTONIC
+    %seconds_pointer = getelementptr %timespec, %timespec* %time, i64 0, i32 0
+    %seconds = load i64, i64* %seconds_pointer
+    %nanoseconds_pointer = getelementptr %timespec, %timespec* %time, i64 0, i32 1
+    %nanoseconds = load i64, i64* %nanoseconds_pointer
+    %scaled = mul i64 %seconds, 1000000000
+    %total = add i64 %scaled, %nanoseconds
+
+    ret i64 %total
+}
+
+; Runs a coroutine to completion on an executor, then reports how long each
+; of its 'times' awaits took, and its result.
+define internal void @finish(%async_SEP_Executor* %executor, i8* %handle, i8* %name, i64 %times, i64 %start) {
+    call i1 @async_SEP_Executor_SEP_run(%async_SEP_Executor* %executor, i8* %handle)
+    %end = call i64 @now()
+    %promise_bytes = call i8* @llvm.coro.promise(i8* %handle, i32 8, i1 false)
+    %promise = bitcast i8* %promise_bytes to %promise_i64*
+    %result_pointer = getelementptr %promise_i64, %promise_i64* %promise, i64 0, i32 1
+    %result = load i64, i64* %result_pointer
+    call void @llvm.coro.destroy(i8* %handle)
+
+    %elapsed = sub i64 %end, %start
+    %elapsed_float = sitofp i64 %elapsed to double
+    %times_float = sitofp i64 %times to double
+    %per_await = fdiv double %elapsed_float, %times_float
+    %format = getelementptr [48 x i8], [48 x i8]* @.count_format, i64 0, i64 0
+    call i32 (i8*, ...) @printf(i8* %format, i8* %name, double %per_await, i64 %times, i64 %result)
+
+    ret void
+}
+
+define i32 @main() {
+    %executor = alloca %async_SEP_Executor
+    %fds = alloca [2 x i32]
+    call void @async_SEP_Executor_SEP___init__(%async_SEP_Executor* %executor)
+    %previous = call %async_SEP_Executor* @async_SEP_Executor_SEP___enter__(%async_SEP_Executor* %executor)
+
+    ; Awaiting async functions which complete without suspending, so which
+    ; have their frames elided
+    %count_start = call i64 @now()
+    %count = call i8* @count(i64 10000000)
+    %count_name = getelementptr [19 x i8], [19 x i8]* @.count_name, i64 0, i64 0
+    call void @finish(%async_SEP_Executor* %executor, i8* %count, i8* %count_name, i64 10000000, i64 %count_start)
+
+    ; Awaiting std.io, through a pipe, so each await suspends and is resumed
+    ; by the executor once 'poll' says the pipe is readable
+    call i32 @pipe([2 x i32]* %fds)
+    %read_fd_pointer = getelementptr [2 x i32], [2 x i32]* %fds, i64 0, i64 0
+    %read_fd = load i32, i32* %read_fd_pointer
+    %write_fd_pointer = getelementptr [2 x i32], [2 x i32]* %fds, i64 0, i64 1
+    %write_fd = load i32, i32* %write_fd_pointer
+    %echo_start = call i64 @now()
+    %echo = call i8* @echo(i32 %read_fd, i32 %write_fd, i64 100000)
+    %echo_name = getelementptr [19 x i8], [19 x i8]* @.echo_name, i64 0, i64 0
+    call void @finish(%async_SEP_Executor* %executor, i8* %echo, i8* %echo_name, i64 100000, i64 %echo_start)
+
+    call void @async_SEP_Executor_SEP___exit__(%async_SEP_Executor* %executor, %async_SEP_Executor* %previous)
+
+    ret i32 0
+}
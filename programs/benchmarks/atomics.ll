@@ -0,0 +1,272 @@
+; Benchmarks std.atomic. 1 to 8 threads each add to a counter of their
+; own, packed next to each other, then each in a class marked '@align(64)',
+; so no two share a cache line. Then they add to one counter they share,
+; with 'fetch_add', with a 'compare_exchange_weak' loop, and under a lock
+; made of a flag. Build and run with 'exeme build
+; programs/benchmarks/atomics.ll -o atomics' and './atomics'.
+;
+;   @align(64)
+;   class Counter {
+;       count: AtomicInt,
+;   }
+
+%atomic_SEP_Int = type { i64 }
+%atomic_SEP_Flag = type { i8 }
+%Counter = type { %atomic_SEP_Int, [7 x i64] }
+%timespec = type { i64, i64 }
+
+@.format = private unnamed_addr constant [37 x i8] c"%-28s %8.2f ns/add  (%ld threads%s)\0A\00"
+@.packed_name = private unnamed_addr constant [20 x i8] c"own counter, packed\00"
+@.padded_name = private unnamed_addr constant [24 x i8] c"own counter, @align(64)\00"
+@.add_name = private unnamed_addr constant [18 x i8] c"shared, fetch_add\00"
+@.exchange_name = private unnamed_addr constant [30 x i8] c"shared, compare_exchange_weak\00"
+@.lock_name = private unnamed_addr constant [18 x i8] c"shared, flag lock\00"
+@.correct = private unnamed_addr constant [1 x i8] zeroinitializer
+@.incorrect = private unnamed_addr constant [13 x i8] c", adds lost!\00"
+
+@packed = internal global [8 x %atomic_SEP_Int] zeroinitializer
+@padded = internal global [8 x %Counter] zeroinitializer
+@shared = internal global %Counter zeroinitializer
+@lock = internal global %atomic_SEP_Flag zeroinitializer
+@locked_count = internal global i64 0
+
+declare i64 @atomic_SEP_Int_SEP_load(%atomic_SEP_Int*, i32)
+declare i64 @atomic_SEP_Int_SEP_exchange(%atomic_SEP_Int*, i64, i32)
+declare i64 @atomic_SEP_Int_SEP_fetch_add(%atomic_SEP_Int*, i64, i32)
+declare i1 @atomic_SEP_Int_SEP_compare_exchange_weak(%atomic_SEP_Int*, i64*, i64, i32)
+declare i1 @atomic_SEP_Flag_SEP_test_and_set(%atomic_SEP_Flag*, i32)
+declare void @atomic_SEP_Flag_SEP_clear(%atomic_SEP_Flag*, i32)
+declare i32 @sched_yield()
+declare i32 @pthread_create(i64*, i8*, i8* (i8*)*, i8*)
+declare i32 @pthread_join(i64, i8**)
+declare i32 @clock_gettime(i32, %timespec*)
+declare i32 @printf(i8*, ...)
+
+; Gets the time, in nanoseconds.
+define internal i64 @now() {
+    %time = alloca %timespec
+    call i32 @clock_gettime(i32 1, %timespec* %time) ; CLOCK_MONOTONIC
+    %seconds_pointer = getelementptr %timespec, %timespec* %time, i64 0, i32 0
+    %seconds = load i64, i64* %seconds_pointer
+    %nanoseconds_pointer = getelementptr %timespec, %timespec* %time, i64 0, i32 1
+    %nanoseconds = load i64, i64* %nanoseconds_pointer
+    %scaled = mul i64 %seconds, 1000000000
+    %total = add i64 %scaled, %nanoseconds
+
+    ret i64 %total
+}
+
+; Adds 1 to 'counter' 2^20 times.
+define internal void @add(%atomic_SEP_Int* %counter) {
+entry:
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %body ]
+    %is_adding = icmp ult i64 %index, 1048576
+    br i1 %is_adding, label %body, label %exit
+
+body:
+    call i64 @atomic_SEP_Int_SEP_fetch_add(%atomic_SEP_Int* %counter, i64 1, i32 0) ; relaxed
+    %next_index = add i64 %index, 1
+    br label %condition
+
+exit:
+    ret void
+}
+
+; Adds to the packed counter 'argument' indexes.
+define internal i8* @add_packed(i8* %argument) {
+    %index = ptrtoint i8* %argument to i64
+    %counter = getelementptr [8 x %atomic_SEP_Int], [8 x %atomic_SEP_Int]* @packed, i64 0, i64 %index
+    call void @add(%atomic_SEP_Int* %counter)
+
+    ret i8* null
+}
+
+; Adds to the aligned counter 'argument' indexes.
+define internal i8* @add_padded(i8* %argument) {
+    %index = ptrtoint i8* %argument to i64
+    %counter = getelementptr [8 x %Counter], [8 x %Counter]* @padded, i64 0, i64 %index, i32 0
+    call void @add(%atomic_SEP_Int* %counter)
+
+    ret i8* null
+}
+
+; Adds to the shared counter.
+define internal i8* @add_shared(i8* %argument) {
+    %counter = getelementptr %Counter, %Counter* @shared, i64 0, i32 0
+    call void @add(%atomic_SEP_Int* %counter)
+
+    ret i8* null
+}
+
+; Adds 1 to the shared counter 2^20 times, by loading it and storing it
+; plus 1 if no other thread stored to it in between.
+define internal i8* @exchange_shared(i8* %argument) {
+entry:
+    %counter = getelementptr %Counter, %Counter* @shared, i64 0, i32 0
+    %expected = alloca i64
+    %first = call i64 @atomic_SEP_Int_SEP_load(%atomic_SEP_Int* %counter, i32 0) ; relaxed
+    store i64 %first, i64* %expected
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %exchange ]
+    %is_adding = icmp ult i64 %index, 1048576
+    br i1 %is_adding, label %exchange, label %exit
+
+exchange: ; A failure stores what the counter held to 'expected', for the next attempt
+    %value = load i64, i64* %expected
+    %desired = add i64 %value, 1
+    %is_exchanged = call i1 @atomic_SEP_Int_SEP_compare_exchange_weak(%atomic_SEP_Int* %counter, i64* %expected,
+                                                                      i64 %desired, i32 3) ; acq_rel
+    %increment = zext i1 %is_exchanged to i64
+    %next_index = add i64 %index, %increment
+    br label %condition
+
+exit:
+    ret i8* null
+}
+
+; Adds 1 to a plain counter 2^20 times, taking a lock made of a flag around
+; each add. The lock is taken with acquire, so the add stays after it, and
+; released with release, so the add stays before that.
+define internal i8* @lock_shared(i8* %argument) {
+entry:
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %add ]
+    %is_adding = icmp ult i64 %index, 1048576
+    br i1 %is_adding, label %lock, label %exit
+
+lock:
+    %was_locked = call i1 @atomic_SEP_Flag_SEP_test_and_set(%atomic_SEP_Flag* @lock, i32 1) ; acquire
+    br i1 %was_locked, label %yield, label %add
+
+yield: ; The thread holding it may not be running
+    call i32 @sched_yield()
+    br label %lock
+
+add:
+    %count = load i64, i64* @locked_count
+    %next_count = add i64 %count, 1
+    store i64 %next_count, i64* @locked_count
+    call void @atomic_SEP_Flag_SEP_clear(%atomic_SEP_Flag* @lock, i32 2) ; release
+    %next_index = add i64 %index, 1
+    br label %condition
+
+exit:
+    ret i8* null
+}
+
+; Takes what every counter holds, zeroing them.
+define internal i64 @take_counts() {
+entry:
+    %shared = getelementptr %Counter, %Counter* @shared, i64 0, i32 0
+    %shared_count = call i64 @atomic_SEP_Int_SEP_exchange(%atomic_SEP_Int* %shared, i64 0, i32 4) ; seq_cst
+    %locked_count = load i64, i64* @locked_count
+    store i64 0, i64* @locked_count
+    %first_total = add i64 %shared_count, %locked_count
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %body ]
+    %total = phi i64 [ %first_total, %entry ], [ %next_total, %body ]
+    %is_taking = icmp ult i64 %index, 8
+    br i1 %is_taking, label %body, label %exit
+
+body:
+    %packed = getelementptr [8 x %atomic_SEP_Int], [8 x %atomic_SEP_Int]* @packed, i64 0, i64 %index
+    %packed_count = call i64 @atomic_SEP_Int_SEP_exchange(%atomic_SEP_Int* %packed, i64 0, i32 4) ; seq_cst
+    %padded = getelementptr [8 x %Counter], [8 x %Counter]* @padded, i64 0, i64 %index, i32 0
+    %padded_count = call i64 @atomic_SEP_Int_SEP_exchange(%atomic_SEP_Int* %padded, i64 0, i32 4) ; seq_cst
+    %counts = add i64 %packed_count, %padded_count
+    %next_total = add i64 %total, %counts
+    %next_index = add i64 %index, 1
+    br label %condition
+
+exit:
+    ret i64 %total
+}
+
+; Runs 'function' on 'threads' threads, each given its index, then prints
+; how long each add took, and whether the counters added up.
+define internal void @run(i8* (i8*)* %function, i8* %name, i64 %threads) {
+entry:
+    %ids = alloca [8 x i64]
+    %start = call i64 @now()
+    br label %create_condition
+
+create_condition:
+    %create_index = phi i64 [ 0, %entry ], [ %next_create_index, %create ]
+    %is_creating = icmp ult i64 %create_index, %threads
+    br i1 %is_creating, label %create, label %join_condition
+
+create:
+    %create_id = getelementptr [8 x i64], [8 x i64]* %ids, i64 0, i64 %create_index
+    %argument = inttoptr i64 %create_index to i8*
+    call i32 @pthread_create(i64* %create_id, i8* null, i8* (i8*)* %function, i8* %argument)
+    %next_create_index = add i64 %create_index, 1
+    br label %create_condition
+
+join_condition:
+    %join_index = phi i64 [ 0, %create_condition ], [ %next_join_index, %join ]
+    %is_joining = icmp ult i64 %join_index, %threads
+    br i1 %is_joining, label %join, label %exit
+
+join:
+    %join_id_pointer = getelementptr [8 x i64], [8 x i64]* %ids, i64 0, i64 %join_index
+    %join_id = load i64, i64* %join_id_pointer
+    call i32 @pthread_join(i64 %join_id, i8** null)
+    %next_join_index = add i64 %join_index, 1
+    br label %join_condition
+
+exit:
+    %end = call i64 @now()
+    %elapsed = sub i64 %end, %start
+    %elapsed_float = sitofp i64 %elapsed to double
+    %adds = mul i64 %threads, 1048576
+    %adds_float = sitofp i64 %adds to double
+    %per_add = fdiv double %elapsed_float, %adds_float
+    %total = call i64 @take_counts()
+    %is_correct = icmp eq i64 %total, %adds
+    %correct = getelementptr [1 x i8], [1 x i8]* @.correct, i64 0, i64 0
+    %incorrect = getelementptr [13 x i8], [13 x i8]* @.incorrect, i64 0, i64 0
+    %suffix = select i1 %is_correct, i8* %correct, i8* %incorrect
+    %format = getelementptr [37 x i8], [37 x i8]* @.format, i64 0, i64 0
+    call i32 (i8*, ...) @printf(i8* %format, i8* %name, double %per_add, i64 %threads, i8* %suffix)
+
+    ret void
+}
+
+define i32 @main() {
+entry:
+    %packed_name = getelementptr [20 x i8], [20 x i8]* @.packed_name, i64 0, i64 0
+    %padded_name = getelementptr [24 x i8], [24 x i8]* @.padded_name, i64 0, i64 0
+    %add_name = getelementptr [18 x i8], [18 x i8]* @.add_name, i64 0, i64 0
+    %exchange_name = getelementptr [30 x i8], [30 x i8]* @.exchange_name, i64 0, i64 0
+    %lock_name = getelementptr [18 x i8], [18 x i8]* @.lock_name, i64 0, i64 0
+    br label %condition
+
+condition:
+    %threads = phi i64 [ 1, %entry ], [ %next_threads, %body ]
+    %is_running = icmp ule i64 %threads, 8
+    br i1 %is_running, label %body, label %exit
+
+body:
+    call void @run(i8* (i8*)* @add_packed, i8* %packed_name, i64 %threads)
+    call void @run(i8* (i8*)* @add_padded, i8* %padded_name, i64 %threads)
+    call void @run(i8* (i8*)* @add_shared, i8* %add_name, i64 %threads)
+    call void @run(i8* (i8*)* @exchange_shared, i8* %exchange_name, i64 %threads)
+    call void @run(i8* (i8*)* @lock_shared, i8* %lock_name, i64 %threads)
+    %next_threads = mul i64 %threads, 2
+    br label %condition
+
+exit:
+    ret i32 0
+}
+
+!exeme.align = !{!0}
+!0 = !{%Counter* null, i64 64}
@@ -0,0 +1,444 @@
+; Benchmarks std.sync's channels and queues. Channels are contended by 1
+; to 64 threads, each sending then receiving, one value or a batch at a
+; time, then a producer and consumer pass values through a queue, and
+; through both between tasks, which park while they wait. Build and run
+; with 'exeme build programs/benchmarks/channels.ll -o channels' and
+; './channels'.
+
+%sync_SEP_Channel = type { i64, [7 x i64], i64, [7 x i64], i8*, i64, i64, i64, i8*, i8*, [5 x i64] }
+%sync_SEP_Queue = type { i8*, i64, i64, [5 x i64], i8*, i64, i64, i64, [4 x i64], i8*, i8* }
+%scheduler_SEP_Task = type opaque
+%timespec = type { i64, i64 }
+
+@.format = private unnamed_addr constant [37 x i8] c"%-28s %12.0f ops/s  (%ld threads%s)\0A\00"
+@.single_name = private unnamed_addr constant [19 x i8] c"channel, one value\00"
+@.batch_name = private unnamed_addr constant [23 x i8] c"channel, batches of 16\00"
+@.queue_name = private unnamed_addr constant [17 x i8] c"queue, one value\00"
+@.queue_batch_name = private unnamed_addr constant [21 x i8] c"queue, batches of 64\00"
+@.channel_task_name = private unnamed_addr constant [23 x i8] c"channel, parking tasks\00"
+@.queue_task_name = private unnamed_addr constant [21 x i8] c"queue, parking tasks\00"
+@.correct = private unnamed_addr constant [1 x i8] zeroinitializer
+@.incorrect = private unnamed_addr constant [15 x i8] c", values lost!\00"
+
+@channel = internal global %sync_SEP_Channel zeroinitializer
+@queue = internal global %sync_SEP_Queue zeroinitializer
+@received_sum = internal global i64 0
+
+declare void @sync_SEP_Channel_SEP___init__(%sync_SEP_Channel*, i64)
+declare void @sync_SEP_Channel_SEP___del__(%sync_SEP_Channel*)
+declare i1 @sync_SEP_Channel_SEP_try_send(%sync_SEP_Channel*, i64)
+declare i1 @sync_SEP_Channel_SEP_try_receive(%sync_SEP_Channel*, i64*)
+declare void @sync_SEP_Channel_SEP_send(%sync_SEP_Channel*, i64)
+declare i64 @sync_SEP_Channel_SEP_receive(%sync_SEP_Channel*)
+declare void @sync_SEP_Channel_SEP_send_batch(%sync_SEP_Channel*, i64*, i64)
+declare i64 @sync_SEP_Channel_SEP_receive_batch(%sync_SEP_Channel*, i64*, i64)
+declare void @sync_SEP_Queue_SEP___init__(%sync_SEP_Queue*)
+declare void @sync_SEP_Queue_SEP___del__(%sync_SEP_Queue*)
+declare void @sync_SEP_Queue_SEP_send(%sync_SEP_Queue*, i64)
+declare void @sync_SEP_Queue_SEP_send_batch(%sync_SEP_Queue*, i64*, i64)
+declare i64 @sync_SEP_Queue_SEP_receive(%sync_SEP_Queue*)
+declare i64 @sync_SEP_Queue_SEP_receive_batch(%sync_SEP_Queue*, i64*, i64)
+declare %scheduler_SEP_Task* @scheduler_SEP_spawn(void (i8*)*, i8*)
+declare void @scheduler_SEP_wait()
+declare i32 @pthread_create(i64*, i8*, i8* (i8*)*, i8*)
+declare i32 @pthread_join(i64, i8**)
+declare i32 @clock_gettime(i32, %timespec*)
+declare i32 @printf(i8*, ...)
+
+; Gets the time, in nanoseconds.
+define internal i64 @now() {
+    %time = alloca %timespec
+    call i32 @clock_gettime(i32 1, %timespec* %time) ; CLOCK_MONOTONIC
+    %seconds_pointer = getelementptr %timespec, %timespec* %time, i64 0, i32 0
+    %seconds = load i64, i64* %seconds_pointer
+    %nanoseconds_pointer = getelementptr %timespec, %timespec* %time, i64 0, i32 1
+    %nanoseconds = load i64, i64* %nanoseconds_pointer
+    %scaled = mul i64 %seconds, 1000000000
+    %total = add i64 %scaled, %nanoseconds
+
+    ret i64 %total
+}
+
+; Sends then receives 'argument' values, one at a time, adding up those
+; received.
+define internal i8* @send_receive(i8* %argument) {
+entry:
+    %count = ptrtoint i8* %argument to i64
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %receive ]
+    %sum = phi i64 [ 0, %entry ], [ %next_sum, %receive ]
+    %is_running = icmp ult i64 %index, %count
+    br i1 %is_running, label %send, label %exit
+
+send:
+    call void @sync_SEP_Channel_SEP_send(%sync_SEP_Channel* @channel, i64 %index)
+    br label %receive
+
+receive:
+    %value = call i64 @sync_SEP_Channel_SEP_receive(%sync_SEP_Channel* @channel)
+    %next_sum = add i64 %sum, %value
+    %next_index = add i64 %index, 1
+    br label %condition
+
+exit:
+    atomicrmw add i64* @received_sum, i64 %sum monotonic
+
+    ret i8* null
+}
+
+; Sends then receives 'argument' values, 16 at a time, adding up those
+; received.
+define internal i8* @send_receive_batch(i8* %argument) {
+entry:
+    %values = alloca [16 x i64]
+    %first_value = getelementptr [16 x i64], [16 x i64]* %values, i64 0, i64 0
+    %count = ptrtoint i8* %argument to i64
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %received ]
+    %sum = phi i64 [ 0, %entry ], [ %batch_sum, %received ]
+    %is_running = icmp ult i64 %index, %count
+    br i1 %is_running, label %fill, label %exit
+
+fill:
+    %fill_index = phi i64 [ 0, %condition ], [ %next_fill_index, %fill ]
+    %fill_pointer = getelementptr [16 x i64], [16 x i64]* %values, i64 0, i64 %fill_index
+    %fill_value = add i64 %index, %fill_index
+    store i64 %fill_value, i64* %fill_pointer
+    %next_fill_index = add i64 %fill_index, 1
+    %is_filling = icmp ult i64 %next_fill_index, 16
+    br i1 %is_filling, label %fill, label %send
+
+send:
+    call void @sync_SEP_Channel_SEP_send_batch(%sync_SEP_Channel* @channel, i64* %first_value, i64 16)
+    br label %receive
+
+receive: ; Until as many as were sent are received
+    %receiving_sum = phi i64 [ %sum, %send ], [ %adding_sum, %add ]
+    %left = phi i64 [ 16, %send ], [ %next_left, %add ]
+    %is_receiving = icmp ne i64 %left, 0
+    br i1 %is_receiving, label %receive_batch, label %received
+
+receive_batch:
+    %received_count = call i64 @sync_SEP_Channel_SEP_receive_batch(%sync_SEP_Channel* @channel, i64* %first_value,
+                                                                      i64 %left)
+    %next_left = sub i64 %left, %received_count
+    br label %add
+
+add:
+    %add_index = phi i64 [ 0, %receive_batch ], [ %next_add_index, %add_value ]
+    %adding_sum = phi i64 [ %receiving_sum, %receive_batch ], [ %added_sum, %add_value ]
+    %is_adding = icmp ult i64 %add_index, %received_count
+    br i1 %is_adding, label %add_value, label %receive
+
+add_value:
+    %add_pointer = getelementptr [16 x i64], [16 x i64]* %values, i64 0, i64 %add_index
+    %add_value_loaded = load i64, i64* %add_pointer
+    %added_sum = add i64 %adding_sum, %add_value_loaded
+    %next_add_index = add i64 %add_index, 1
+    br label %add
+
+received:
+    %batch_sum = phi i64 [ %receiving_sum, %receive ]
+    %next_index = add i64 %index, 16
+    br label %condition
+
+exit:
+    atomicrmw add i64* @received_sum, i64 %sum monotonic
+
+    ret i8* null
+}
+
+; Prints how many operations a second were done since 'start', and whether
+; the values received added up to 'expected_sum'.
+define internal void @report(i8* %name, i64 %start, i64 %operations, i64 %threads, i64 %expected_sum) {
+    %end = call i64 @now()
+    %elapsed = sub i64 %end, %start
+    %elapsed_float = sitofp i64 %elapsed to double
+    %operations_float = sitofp i64 %operations to double
+    %scaled = fmul double %operations_float, 1000000000.0
+    %per_second = fdiv double %scaled, %elapsed_float
+    %sum = atomicrmw xchg i64* @received_sum, i64 0 monotonic
+    %is_correct = icmp eq i64 %sum, %expected_sum
+    %correct = getelementptr [1 x i8], [1 x i8]* @.correct, i64 0, i64 0
+    %incorrect = getelementptr [15 x i8], [15 x i8]* @.incorrect, i64 0, i64 0
+    %suffix = select i1 %is_correct, i8* %correct, i8* %incorrect
+    %format = getelementptr [37 x i8], [37 x i8]* @.format, i64 0, i64 0
+    call i32 (i8*, ...) @printf(i8* %format, i8* %name, double %per_second, i64 %threads, i8* %suffix)
+
+    ret void
+}
+
+; Runs 'function' on 'threads' threads contending for one channel, each
+; sending and receiving a share of 2^20 values.
+define internal void @contend(i8* (i8*)* %function, i8* %name, i64 %threads) {
+entry:
+    %ids = alloca [64 x i64]
+    call void @sync_SEP_Channel_SEP___init__(%sync_SEP_Channel* @channel, i64 1024)
+    %count = udiv i64 1048576, %threads
+    %argument = inttoptr i64 %count to i8*
+    %start = call i64 @now()
+    br label %create_condition
+
+create_condition:
+    %create_index = phi i64 [ 0, %entry ], [ %next_create_index, %create ]
+    %is_creating = icmp ult i64 %create_index, %threads
+    br i1 %is_creating, label %create, label %join_condition
+
+create:
+    %create_id = getelementptr [64 x i64], [64 x i64]* %ids, i64 0, i64 %create_index
+    call i32 @pthread_create(i64* %create_id, i8* null, i8* (i8*)* %function, i8* %argument)
+    %next_create_index = add i64 %create_index, 1
+    br label %create_condition
+
+join_condition:
+    %join_index = phi i64 [ 0, %create_condition ], [ %next_join_index, %join ]
+    %is_joining = icmp ult i64 %join_index, %threads
+    br i1 %is_joining, label %join, label %exit
+
+join:
+    %join_id_pointer = getelementptr [64 x i64], [64 x i64]* %ids, i64 0, i64 %join_index
+    %join_id = load i64, i64* %join_id_pointer
+    call i32 @pthread_join(i64 %join_id, i8** null)
+    %next_join_index = add i64 %join_index, 1
+    br label %join_condition
+
+exit:
+    %operations = mul i64 %count, %threads
+    %round_trips = mul i64 %operations, 2
+    %count_below = sub i64 %count, 1
+    %pairs = mul i64 %count, %count_below
+    %thread_sum = udiv i64 %pairs, 2 ; 0 to 'count' minus 1, which each thread sends
+    %expected_sum = mul i64 %thread_sum, %threads
+    call void @report(i8* %name, i64 %start, i64 %round_trips, i64 %threads, i64 %expected_sum)
+    call void @sync_SEP_Channel_SEP___del__(%sync_SEP_Channel* @channel)
+
+    ret void
+}
+
+; Sends 0 to 'argument' minus 1 to the queue, one at a time.
+define internal i8* @produce(i8* %argument) {
+entry:
+    %count = ptrtoint i8* %argument to i64
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %send ]
+    %is_sending = icmp ult i64 %index, %count
+    br i1 %is_sending, label %send, label %exit
+
+send:
+    call void @sync_SEP_Queue_SEP_send(%sync_SEP_Queue* @queue, i64 %index)
+    %next_index = add i64 %index, 1
+    br label %condition
+
+exit:
+    ret i8* null
+}
+
+; Sends 0 to 'argument' minus 1 to the queue, 64 at a time.
+define internal i8* @produce_batch(i8* %argument) {
+entry:
+    %values = alloca [64 x i64]
+    %first_value = getelementptr [64 x i64], [64 x i64]* %values, i64 0, i64 0
+    %count = ptrtoint i8* %argument to i64
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %send ]
+    %is_sending = icmp ult i64 %index, %count
+    br i1 %is_sending, label %fill, label %exit
+
+fill:
+    %fill_index = phi i64 [ 0, %condition ], [ %next_fill_index, %fill ]
+    %fill_pointer = getelementptr [64 x i64], [64 x i64]* %values, i64 0, i64 %fill_index
+    %fill_value = add i64 %index, %fill_index
+    store i64 %fill_value, i64* %fill_pointer
+    %next_fill_index = add i64 %fill_index, 1
+    %is_filling = icmp ult i64 %next_fill_index, 64
+    br i1 %is_filling, label %fill, label %send
+
+send:
+    call void @sync_SEP_Queue_SEP_send_batch(%sync_SEP_Queue* @queue, i64* %first_value, i64 64)
+    %next_index = add i64 %index, 64
+    br label %condition
+
+exit:
+    ret i8* null
+}
+
+; Receives 'argument' values from the queue, one at a time, adding them up.
+define internal void @consume(i8* %argument) {
+entry:
+    %count = ptrtoint i8* %argument to i64
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %receive ]
+    %sum = phi i64 [ 0, %entry ], [ %next_sum, %receive ]
+    %is_receiving = icmp ult i64 %index, %count
+    br i1 %is_receiving, label %receive, label %exit
+
+receive:
+    %value = call i64 @sync_SEP_Queue_SEP_receive(%sync_SEP_Queue* @queue)
+    %next_sum = add i64 %sum, %value
+    %next_index = add i64 %index, 1
+    br label %condition
+
+exit:
+    atomicrmw add i64* @received_sum, i64 %sum monotonic
+
+    ret void
+}
+
+; Receives 'argument' values from the queue, up to 64 at a time, adding
+; them up.
+define internal void @consume_batch(i8* %argument) {
+entry:
+    %values = alloca [64 x i64]
+    %first_value = getelementptr [64 x i64], [64 x i64]* %values, i64 0, i64 0
+    %count = ptrtoint i8* %argument to i64
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %added ]
+    %sum = phi i64 [ 0, %entry ], [ %added_sum, %added ]
+    %is_receiving = icmp ult i64 %index, %count
+    br i1 %is_receiving, label %receive, label %exit
+
+receive:
+    %received = call i64 @sync_SEP_Queue_SEP_receive_batch(%sync_SEP_Queue* @queue, i64* %first_value, i64 64)
+    br label %add
+
+add:
+    %add_index = phi i64 [ 0, %receive ], [ %next_add_index, %add_value ]
+    %adding_sum = phi i64 [ %sum, %receive ], [ %next_adding_sum, %add_value ]
+    %is_adding = icmp ult i64 %add_index, %received
+    br i1 %is_adding, label %add_value, label %added
+
+add_value:
+    %value_pointer = getelementptr [64 x i64], [64 x i64]* %values, i64 0, i64 %add_index
+    %value = load i64, i64* %value_pointer
+    %next_adding_sum = add i64 %adding_sum, %value
+    %next_add_index = add i64 %add_index, 1
+    br label %add
+
+added:
+    %added_sum = phi i64 [ %adding_sum, %add ]
+    %next_index = add i64 %index, %received
+    br label %condition
+
+exit:
+    atomicrmw add i64* @received_sum, i64 %sum monotonic
+
+    ret void
+}
+
+; Passes 2^22 values through the queue, from a producer thread to 'main'.
+define internal void @pass(i8* (i8*)* %producer, void (i8*)* %consumer, i8* %name) {
+    %id = alloca i64
+    call void @sync_SEP_Queue_SEP___init__(%sync_SEP_Queue* @queue)
+    %start = call i64 @now()
+    call i32 @pthread_create(i64* %id, i8* null, i8* (i8*)* %producer, i8* inttoptr (i64 4194304 to i8*))
+    call void %consumer(i8* inttoptr (i64 4194304 to i8*))
+    %loaded_id = load i64, i64* %id
+    call i32 @pthread_join(i64 %loaded_id, i8** null)
+    call void @report(i8* %name, i64 %start, i64 4194304, i64 2, i64 8796090925056) ; 0 to 2^22 minus 1
+    call void @sync_SEP_Queue_SEP___del__(%sync_SEP_Queue* @queue)
+
+    ret void
+}
+
+define internal void @channel_producer(i8* %argument) {
+entry:
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %send ]
+    %is_sending = icmp ult i64 %index, 1048576
+    br i1 %is_sending, label %send, label %exit
+
+send:
+    call void @sync_SEP_Channel_SEP_send(%sync_SEP_Channel* @channel, i64 %index)
+    %next_index = add i64 %index, 1
+    br label %condition
+
+exit:
+    ret void
+}
+
+define internal void @channel_consumer(i8* %argument) {
+entry:
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %receive ]
+    %sum = phi i64 [ 0, %entry ], [ %next_sum, %receive ]
+    %is_receiving = icmp ult i64 %index, 1048576
+    br i1 %is_receiving, label %receive, label %exit
+
+receive:
+    %value = call i64 @sync_SEP_Channel_SEP_receive(%sync_SEP_Channel* @channel)
+    %next_sum = add i64 %sum, %value
+    %next_index = add i64 %index, 1
+    br label %condition
+
+exit:
+    atomicrmw add i64* @received_sum, i64 %sum monotonic
+
+    ret void
+}
+
+define internal void @queue_producer(i8* %argument) {
+    call i8* @produce(i8* inttoptr (i64 1048576 to i8*))
+
+    ret void
+}
+
+define i32 @main() {
+entry:
+    %single_name = getelementptr [19 x i8], [19 x i8]* @.single_name, i64 0, i64 0
+    %batch_name = getelementptr [23 x i8], [23 x i8]* @.batch_name, i64 0, i64 0
+    br label %condition
+
+condition: ; 1, 2, 4 and so on to 64 threads
+    %threads = phi i64 [ 1, %entry ], [ %next_threads, %contend ]
+    %is_contending = icmp ule i64 %threads, 64
+    br i1 %is_contending, label %contend, label %queue
+
+contend:
+    call void @contend(i8* (i8*)* @send_receive, i8* %single_name, i64 %threads)
+    call void @contend(i8* (i8*)* @send_receive_batch, i8* %batch_name, i64 %threads)
+    %next_threads = shl i64 %threads, 1
+    br label %condition
+
+queue:
+    %queue_name = getelementptr [17 x i8], [17 x i8]* @.queue_name, i64 0, i64 0
+    call void @pass(i8* (i8*)* @produce, void (i8*)* @consume, i8* %queue_name)
+    %queue_batch_name = getelementptr [21 x i8], [21 x i8]* @.queue_batch_name, i64 0, i64 0
+    call void @pass(i8* (i8*)* @produce_batch, void (i8*)* @consume_batch, i8* %queue_batch_name)
+
+    ; A small channel, so the producer parks while it is full and the consumer while it is empty
+    call void @sync_SEP_Channel_SEP___init__(%sync_SEP_Channel* @channel, i64 4)
+    %channel_start = call i64 @now()
+    call %scheduler_SEP_Task* @scheduler_SEP_spawn(void (i8*)* @channel_consumer, i8* null)
+    call %scheduler_SEP_Task* @scheduler_SEP_spawn(void (i8*)* @channel_producer, i8* null)
+    call void @scheduler_SEP_wait()
+    %channel_task_name = getelementptr [23 x i8], [23 x i8]* @.channel_task_name, i64 0, i64 0
+    call void @report(i8* %channel_task_name, i64 %channel_start, i64 1048576, i64 2, i64 549755289600)
+    call void @sync_SEP_Channel_SEP___del__(%sync_SEP_Channel* @channel)
+
+    call void @sync_SEP_Queue_SEP___init__(%sync_SEP_Queue* @queue)
+    %queue_start = call i64 @now()
+    call %scheduler_SEP_Task* @scheduler_SEP_spawn(void (i8*)* @consume, i8* inttoptr (i64 1048576 to i8*))
+    call %scheduler_SEP_Task* @scheduler_SEP_spawn(void (i8*)* @queue_producer, i8* null)
+    call void @scheduler_SEP_wait()
+    %queue_task_name = getelementptr [21 x i8], [21 x i8]* @.queue_task_name, i64 0, i64 0
+    call void @report(i8* %queue_task_name, i64 %queue_start, i64 1048576, i64 2, i64 549755289600)
+    call void @sync_SEP_Queue_SEP___del__(%sync_SEP_Queue* @queue)
+
+    ret i32 0
+}
@@ -0,0 +1,249 @@
+; Benchmarks dividing by a divisor known only at runtime in a loop, with
+; the hardware's divide each iteration, then with the magic number the
+; compiler computes in the loop's preheader, once per loop. 64-bit
+; dividends start at 2^40, so x86's check for operands which fit in 32 bits
+; does not pick the faster 32-bit divide. The short loops run 16 or 128
+; iterations each time they start, so a 64-bit magic number's '__udivti3'
+; is paid every 16 or 128 divides. That pays from about 8 a loop, and
+; costs more than it saves at 4, so loops are only changed when they are
+; nested or known or profiled to run at least 8 times. The loops of 16
+; take their length as an argument, so keep the hardware's divide, while
+; the loops of 128 count to a constant. Build and run with 'exeme build
+; programs/benchmarks/divisor.ll -o divisor' and './divisor'.
+;
+;   divisor: u64 = 7
+;   total: u64 = 0
+;   for n = range(start, start + 10000000) {
+;       total += n / divisor
+;   }
+
+%timespec = type { i64, i64 }
+
+@.format = private unnamed_addr constant [37 x i8] c"%-32s %8.2f ns/divide  (result %lu)\0A\00"
+@.hardware_32_name = private unnamed_addr constant [21 x i8] c"u32, hardware divide\00"
+@.magic_32_name = private unnamed_addr constant [18 x i8] c"u32, magic number\00"
+@.hardware_64_name = private unnamed_addr constant [21 x i8] c"u64, hardware divide\00"
+@.magic_64_name = private unnamed_addr constant [18 x i8] c"u64, magic number\00"
+@.short_hardware_64_name = private unnamed_addr constant [32 x i8] c"u64, hardware divide, 16 a loop\00"
+@.short_magic_64_name = private unnamed_addr constant [31 x i8] c"u64, left as divide, 16 a loop\00"
+@.long_hardware_64_name = private unnamed_addr constant [33 x i8] c"u64, hardware divide, 128 a loop\00"
+@.long_magic_64_name = private unnamed_addr constant [30 x i8] c"u64, magic number, 128 a loop\00"
+
+; Read through volatile loads, so the divisor is not known when optimising
+@divisor = internal global i64 7
+
+declare i32 @clock_gettime(i32, %timespec*)
+declare i32 @printf(i8*, ...)
+
+; Gets the time, in nanoseconds.
+define internal i64 @now() {
+    %time = alloca %timespec
+    call i32 @clock_gettime(i32 1, %timespec* %time) ; CLOCK_MONOTONIC
+    %seconds_pointer = getelementptr %timespec, %timespec* %time, i64 0, i32 0
+    %seconds = load i64, i64* %seconds_pointer
+    %nanoseconds_pointer = getelementptr %timespec, %timespec* %time, i64 0, i32 1
+    %nanoseconds = load i64, i64* %nanoseconds_pointer
+    %scaled = mul i64 %seconds, 1000000000
+    %total = add i64 %scaled, %nanoseconds
+
+    ret i64 %total
+}
+
+; Sums 'n / divisor' for 10000000 32-bit 'n', loading the divisor each
+; iteration, so it changes in the loop and is left as a divide.
+define internal i64 @sum_hardware_32() {
+entry:
+    br label %condition
+
+condition:
+    %n = phi i32 [ 0, %entry ], [ %next_n, %body ]
+    %total = phi i64 [ 0, %entry ], [ %next_total, %body ]
+    %is_summing = icmp ult i32 %n, 10000000
+    br i1 %is_summing, label %body, label %exit
+
+body:
+    %divisor = load volatile i64, i64* @divisor
+    %divisor_32 = trunc i64 %divisor to i32
+    %quotient = udiv i32 %n, %divisor_32
+    %wide_quotient = zext i32 %quotient to i64
+    %next_total = add i64 %total, %wide_quotient
+    %next_n = add i32 %n, 1
+    br label %condition
+
+exit:
+    ret i64 %total
+}
+
+; Sums 'n / divisor' for 10000000 32-bit 'n', loading the divisor before
+; the loop, so it is divided by with a magic number.
+define internal i64 @sum_magic_32() {
+entry:
+    %divisor = load volatile i64, i64* @divisor
+    %divisor_32 = trunc i64 %divisor to i32
+    br label %condition
+
+condition:
+    %n = phi i32 [ 0, %entry ], [ %next_n, %body ]
+    %total = phi i64 [ 0, %entry ], [ %next_total, %body ]
+    %is_summing = icmp ult i32 %n, 10000000
+    br i1 %is_summing, label %body, label %exit
+
+body:
+    %quotient = udiv i32 %n, %divisor_32
+    %wide_quotient = zext i32 %quotient to i64
+    %next_total = add i64 %total, %wide_quotient
+    %next_n = add i32 %n, 1
+    br label %condition
+
+exit:
+    ret i64 %total
+}
+
+; Sums 'n / divisor' for 'length' 64-bit 'n' from 'start', loading the
+; divisor each iteration.
+define internal i64 @sum_hardware_64(i64 %start, i64 %length) {
+entry:
+    %end = add i64 %start, %length
+    br label %condition
+
+condition:
+    %n = phi i64 [ %start, %entry ], [ %next_n, %body ]
+    %total = phi i64 [ 0, %entry ], [ %next_total, %body ]
+    %is_summing = icmp ult i64 %n, %end
+    br i1 %is_summing, label %body, label %exit
+
+body:
+    %divisor = load volatile i64, i64* @divisor
+    %quotient = udiv i64 %n, %divisor
+    %next_total = add i64 %total, %quotient
+    %next_n = add i64 %n, 1
+    br label %condition
+
+exit:
+    ret i64 %total
+}
+
+; Sums 'n / divisor' for 'length' 64-bit 'n' from 'start', loading the
+; divisor before the loop.
+define internal i64 @sum_magic_64(i64 %start, i64 %length) {
+entry:
+    %divisor = load volatile i64, i64* @divisor
+    %end = add i64 %start, %length
+    br label %condition
+
+condition:
+    %n = phi i64 [ %start, %entry ], [ %next_n, %body ]
+    %total = phi i64 [ 0, %entry ], [ %next_total, %body ]
+    %is_summing = icmp ult i64 %n, %end
+    br i1 %is_summing, label %body, label %exit
+
+body:
+    %quotient = udiv i64 %n, %divisor
+    %next_total = add i64 %total, %quotient
+    %next_n = add i64 %n, 1
+    br label %condition
+
+exit:
+    ret i64 %total
+}
+
+; Sums 128 64-bit 'n / divisor' from 'start', loading the divisor before
+; the loop. It ignores 'length', so its trip count is known.
+define internal i64 @sum_magic_128(i64 %start, i64 %length) {
+entry:
+    %divisor = load volatile i64, i64* @divisor
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %body ]
+    %total = phi i64 [ 0, %entry ], [ %next_total, %body ]
+    %is_summing = icmp ult i64 %index, 128
+    br i1 %is_summing, label %body, label %exit
+
+body:
+    %n = add i64 %start, %index
+    %quotient = udiv i64 %n, %divisor
+    %next_total = add i64 %total, %quotient
+    %next_index = add i64 %index, 1
+    br label %condition
+
+exit:
+    ret i64 %total
+}
+
+; Sums 10000000 64-bit 'n / divisor' from 2^40, 'length' at a time with
+; 'sum', which is kept as a call so each 'length' is a loop of its own.
+define internal i64 @sum_short_64(i64 (i64, i64)* %sum, i64 %length) {
+entry:
+    br label %condition
+
+condition:
+    %start = phi i64 [ 1099511627776, %entry ], [ %next_start, %body ]
+    %total = phi i64 [ 0, %entry ], [ %next_total, %body ]
+    %is_summing = icmp ult i64 %start, 1099521627776
+    br i1 %is_summing, label %body, label %exit
+
+body:
+    %part = call i64 %sum(i64 %start, i64 %length) noinline
+    %next_total = add i64 %total, %part
+    %next_start = add i64 %start, %length
+    br label %condition
+
+exit:
+    ret i64 %total
+}
+
+define internal void @report(i8* %name, i64 %start, i64 %result) {
+    %end = call i64 @now()
+    %elapsed = sub i64 %end, %start
+    %elapsed_float = sitofp i64 %elapsed to double
+    %per_divide = fdiv double %elapsed_float, 10000000.0
+    %format = getelementptr [37 x i8], [37 x i8]* @.format, i64 0, i64 0
+    call i32 (i8*, ...) @printf(i8* %format, i8* %name, double %per_divide, i64 %result)
+
+    ret void
+}
+
+define i32 @main() {
+    %hardware_32_start = call i64 @now()
+    %hardware_32_total = call i64 @sum_hardware_32()
+    %hardware_32_name = getelementptr [21 x i8], [21 x i8]* @.hardware_32_name, i64 0, i64 0
+    call void @report(i8* %hardware_32_name, i64 %hardware_32_start, i64 %hardware_32_total)
+
+    %magic_32_start = call i64 @now()
+    %magic_32_total = call i64 @sum_magic_32()
+    %magic_32_name = getelementptr [18 x i8], [18 x i8]* @.magic_32_name, i64 0, i64 0
+    call void @report(i8* %magic_32_name, i64 %magic_32_start, i64 %magic_32_total)
+
+    %hardware_64_start = call i64 @now()
+    %hardware_64_total = call i64 @sum_hardware_64(i64 1099511627776, i64 10000000)
+    %hardware_64_name = getelementptr [21 x i8], [21 x i8]* @.hardware_64_name, i64 0, i64 0
+    call void @report(i8* %hardware_64_name, i64 %hardware_64_start, i64 %hardware_64_total)
+
+    %magic_64_start = call i64 @now()
+    %magic_64_total = call i64 @sum_magic_64(i64 1099511627776, i64 10000000)
+    %magic_64_name = getelementptr [18 x i8], [18 x i8]* @.magic_64_name, i64 0, i64 0
+    call void @report(i8* %magic_64_name, i64 %magic_64_start, i64 %magic_64_total)
+
+    %short_hardware_64_start = call i64 @now()
+    %short_hardware_64_total = call i64 @sum_short_64(i64 (i64, i64)* @sum_hardware_64, i64 16)
+    %short_hardware_64_name = getelementptr [32 x i8], [32 x i8]* @.short_hardware_64_name, i64 0, i64 0
+    call void @report(i8* %short_hardware_64_name, i64 %short_hardware_64_start, i64 %short_hardware_64_total)
+
+    %short_magic_64_start = call i64 @now()
+    %short_magic_64_total = call i64 @sum_short_64(i64 (i64, i64)* @sum_magic_64, i64 16)
+    %short_magic_64_name = getelementptr [31 x i8], [31 x i8]* @.short_magic_64_name, i64 0, i64 0
+    call void @report(i8* %short_magic_64_name, i64 %short_magic_64_start, i64 %short_magic_64_total)
+
+    %long_hardware_64_start = call i64 @now()
+    %long_hardware_64_total = call i64 @sum_short_64(i64 (i64, i64)* @sum_hardware_64, i64 128)
+    %long_hardware_64_name = getelementptr [33 x i8], [33 x i8]* @.long_hardware_64_name, i64 0, i64 0
+    call void @report(i8* %long_hardware_64_name, i64 %long_hardware_64_start, i64 %long_hardware_64_total)
+
+    %long_magic_64_start = call i64 @now()
+    %long_magic_64_total = call i64 @sum_short_64(i64 (i64, i64)* @sum_magic_128, i64 128)
+    %long_magic_64_name = getelementptr [30 x i8], [30 x i8]* @.long_magic_64_name, i64 0, i64 0
+    call void @report(i8* %long_magic_64_name, i64 %long_magic_64_start, i64 %long_magic_64_total)
+
+    ret i32 0
+}
@@ -0,0 +1,212 @@
+; Benchmarks std.parallel's loops, counting primes like 'isPrime' in
+; 'programs/main.exl' does, which are uneven iterations, as later ones take
+; longer. Build and run with 'exeme build programs/benchmarks/parallel.ll
+; -o parallel' and './parallel', setting 'EXEME_WORKERS' to vary the
+; number of workers.
+;
+;   count = 0
+;   for n = prange(2, 3000000) {
+;       if (isPrime(n)) {
+;           count += 1
+;       }
+;   }
+
+%scheduler_SEP_Task = type opaque
+%timespec = type { i64, i64 }
+
+@.format = private unnamed_addr constant [44 x i8] c"%-28s %10.1f ms  (result %ld, %ld workers)\0A\00"
+@.serial_name = private unnamed_addr constant [14 x i8] c"count, serial\00"
+@.sum_name = private unnamed_addr constant [27 x i8] c"count, parallel_SEP_reduce\00"
+@.max_name = private unnamed_addr constant [19 x i8] c"largest, max, task\00"
+@.for_name = private unnamed_addr constant [29 x i8] c"mark, parallel_SEP_for, then\00"
+
+@sieve = internal global [3000000 x i8] zeroinitializer
+@largest = internal global i64 0
+
+declare i64 @parallel_SEP_reduce(i64, i64, i64 (i8*, i64, i64)*, i8*, i64 (i64, i64)*, i64)
+declare void @parallel_SEP_for(i64, i64, void (i8*, i64, i64)*, i8*)
+declare i64 @parallel_SEP_sum(i64, i64)
+declare i64 @parallel_SEP_max(i64, i64)
+declare %scheduler_SEP_Task* @scheduler_SEP_spawn(void (i8*)*, i8*)
+declare void @scheduler_SEP_wait()
+declare i64 @scheduler_SEP_workers()
+declare i32 @clock_gettime(i32, %timespec*)
+declare i32 @printf(i8*, ...)
+
+; Gets the time, in nanoseconds.
+define internal i64 @now() {
+    %time = alloca %timespec
+    call i32 @clock_gettime(i32 1, %timespec* %time) ; CLOCK_MONOTONIC
+    %seconds_pointer = getelementptr %timespec, %timespec* %time, i64 0, i32 0
+    %seconds = load i64, i64* %seconds_pointer
+    %nanoseconds_pointer = getelementptr %timespec, %timespec* %time, i64 0, i32 1
+    %nanoseconds = load i64, i64* %nanoseconds_pointer
+    %scaled = mul i64 %seconds, 1000000000
+    %total = add i64 %scaled, %nanoseconds
+
+    ret i64 %total
+}
+
+; Returns whether 'n' is prime, by trial division up to its square root.
+define internal i1 @is_prime(i64 %n) {
+entry:
+    br label %condition
+
+condition:
+    %divisor = phi i64 [ 2, %entry ], [ %next_divisor, %check ]
+    %squared = mul i64 %divisor, %divisor
+    %is_dividing = icmp ule i64 %squared, %n
+    br i1 %is_dividing, label %check, label %exit
+
+check:
+    %remainder = urem i64 %n, %divisor
+    %next_divisor = add i64 %divisor, 1
+    %is_divisible = icmp eq i64 %remainder, 0
+    br i1 %is_divisible, label %exit, label %condition
+
+exit:
+    %is_prime = phi i1 [ true, %condition ], [ false, %check ]
+
+    ret i1 %is_prime
+}
+
+; Counts the primes from 'start' to before 'end'.
+define internal i64 @count_primes(i8* %context, i64 %start, i64 %end) {
+entry:
+    br label %condition
+
+condition:
+    %n = phi i64 [ %start, %entry ], [ %next_n, %body ]
+    %count = phi i64 [ 0, %entry ], [ %next_count, %body ]
+    %is_counting = icmp ult i64 %n, %end
+    br i1 %is_counting, label %body, label %exit
+
+body:
+    %is_prime = call i1 @is_prime(i64 %n)
+    %increment = zext i1 %is_prime to i64
+    %next_count = add i64 %count, %increment
+    %next_n = add i64 %n, 1
+    br label %condition
+
+exit:
+    ret i64 %count
+}
+
+; Finds the largest prime from 'start' to before 'end', or 0.
+define internal i64 @largest_prime(i8* %context, i64 %start, i64 %end) {
+entry:
+    br label %condition
+
+condition: ; Backwards, stopping at the first prime
+    %n = phi i64 [ %end, %entry ], [ %previous_n, %check ]
+    %is_searching = icmp ugt i64 %n, %start
+    br i1 %is_searching, label %check, label %exit
+
+check:
+    %previous_n = sub i64 %n, 1
+    %is_prime = call i1 @is_prime(i64 %previous_n)
+    br i1 %is_prime, label %exit, label %condition
+
+exit:
+    %largest = phi i64 [ 0, %condition ], [ %previous_n, %check ]
+
+    ret i64 %largest
+}
+
+; Marks which numbers from 'start' to before 'end' are prime in the sieve.
+define internal void @mark_primes(i8* %context, i64 %start, i64 %end) {
+entry:
+    br label %condition
+
+condition:
+    %n = phi i64 [ %start, %entry ], [ %next_n, %body ]
+    %is_marking = icmp ult i64 %n, %end
+    br i1 %is_marking, label %body, label %exit
+
+body:
+    %is_prime = call i1 @is_prime(i64 %n)
+    %mark = zext i1 %is_prime to i8
+    %mark_pointer = getelementptr [3000000 x i8], [3000000 x i8]* @sieve, i64 0, i64 %n
+    store i8 %mark, i8* %mark_pointer
+    %next_n = add i64 %n, 1
+    br label %condition
+
+exit:
+    ret void
+}
+
+; Reads back the marks in the sieve from 'start' to before 'end', counting
+; them.
+define internal i64 @count_marks(i8* %context, i64 %start, i64 %end) {
+entry:
+    br label %condition
+
+condition:
+    %n = phi i64 [ %start, %entry ], [ %next_n, %body ]
+    %count = phi i64 [ 0, %entry ], [ %next_count, %body ]
+    %is_counting = icmp ult i64 %n, %end
+    br i1 %is_counting, label %body, label %exit
+
+body:
+    %mark_pointer = getelementptr [3000000 x i8], [3000000 x i8]* @sieve, i64 0, i64 %n
+    %mark = load i8, i8* %mark_pointer
+    %increment = zext i8 %mark to i64
+    %next_count = add i64 %count, %increment
+    %next_n = add i64 %n, 1
+    br label %condition
+
+exit:
+    ret i64 %count
+}
+
+; Finds the largest prime from inside of a task, which runs iterations
+; itself and parks, rather than blocking its worker, until the rest have.
+define internal void @find_largest(i8* %argument) {
+    %largest = call i64 @parallel_SEP_reduce(i64 2, i64 3000000, i64 (i8*, i64, i64)* @largest_prime, i8* null,
+                                             i64 (i64, i64)* @parallel_SEP_max, i64 0)
+    store i64 %largest, i64* @largest
+
+    ret void
+}
+
+define internal void @report(i8* %name, i64 %start, i64 %result, i64 %workers) {
+    %end = call i64 @now()
+    %elapsed = sub i64 %end, %start
+    %elapsed_float = sitofp i64 %elapsed to double
+    %milliseconds = fdiv double %elapsed_float, 1000000.0
+    %format = getelementptr [44 x i8], [44 x i8]* @.format, i64 0, i64 0
+    call i32 (i8*, ...) @printf(i8* %format, i8* %name, double %milliseconds, i64 %result, i64 %workers)
+
+    ret void
+}
+
+define i32 @main() {
+    %workers = call i64 @scheduler_SEP_workers()
+
+    %serial_start = call i64 @now()
+    %serial_count = call i64 @count_primes(i8* null, i64 2, i64 3000000)
+    %serial_name = getelementptr [14 x i8], [14 x i8]* @.serial_name, i64 0, i64 0
+    call void @report(i8* %serial_name, i64 %serial_start, i64 %serial_count, i64 %workers)
+
+    %sum_start = call i64 @now()
+    %sum_count = call i64 @parallel_SEP_reduce(i64 2, i64 3000000, i64 (i8*, i64, i64)* @count_primes, i8* null,
+                                               i64 (i64, i64)* @parallel_SEP_sum, i64 0)
+    %sum_name = getelementptr [27 x i8], [27 x i8]* @.sum_name, i64 0, i64 0
+    call void @report(i8* %sum_name, i64 %sum_start, i64 %sum_count, i64 %workers)
+
+    %max_start = call i64 @now()
+    call %scheduler_SEP_Task* @scheduler_SEP_spawn(void (i8*)* @find_largest, i8* null)
+    call void @scheduler_SEP_wait()
+    %largest = load i64, i64* @largest
+    %max_name = getelementptr [19 x i8], [19 x i8]* @.max_name, i64 0, i64 0
+    call void @report(i8* %max_name, i64 %max_start, i64 %largest, i64 %workers)
+
+    %for_start = call i64 @now()
+    call void @parallel_SEP_for(i64 2, i64 3000000, void (i8*, i64, i64)* @mark_primes, i8* null)
+    %marked = call i64 @parallel_SEP_reduce(i64 2, i64 3000000, i64 (i8*, i64, i64)* @count_marks, i8* null,
+                                            i64 (i64, i64)* @parallel_SEP_sum, i64 0)
+    %for_name = getelementptr [29 x i8], [29 x i8]* @.for_name, i64 0, i64 0
+    call void @report(i8* %for_name, i64 %for_start, i64 %marked, i64 %workers)
+
+    ret i32 0
+}
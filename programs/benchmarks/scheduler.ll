@@ -0,0 +1,167 @@
+; Benchmarks the scheduler runtime's throughput and latency. Build and run
+; with 'exeme build programs/benchmarks/scheduler.ll -o scheduler' and
+; './scheduler', setting 'EXEME_WORKERS' to vary the number of workers.
+
+%scheduler_SEP_Task = type opaque
+%timespec = type { i64, i64 }
+
+@.spawned_format = private unnamed_addr constant [48 x i8] c"%-28s %10.0f tasks/s  (%ld tasks, %ld workers)\0A\00"
+@.latency_format = private unnamed_addr constant [41 x i8] c"%-28s %10.1f ns       (%ld round trips)\0A\00"
+@.inside_name = private unnamed_addr constant [22 x i8] c"spawn inside of tasks\00"
+@.outside_name = private unnamed_addr constant [23 x i8] c"spawn outside of tasks\00"
+@.latency_name = private unnamed_addr constant [23 x i8] c"park to unpark latency\00"
+
+@partner = internal global %scheduler_SEP_Task* null
+@ready = internal global i64 0
+
+declare %scheduler_SEP_Task* @scheduler_SEP_spawn(void (i8*)*, i8*)
+declare %scheduler_SEP_Task* @scheduler_SEP_current()
+declare void @scheduler_SEP_park()
+declare void @scheduler_SEP_unpark(%scheduler_SEP_Task*)
+declare void @scheduler_SEP_wait()
+declare i64 @scheduler_SEP_workers()
+declare i32 @clock_gettime(i32, %timespec*)
+declare i32 @printf(i8*, ...)
+
+; Gets the time, in nanoseconds.
+define internal i64 @now() {
+    %time = alloca %timespec
+    call i32 @clock_gettime(i32 1, %timespec* %time) ; CLOCK_MONOTONIC
+    %seconds_pointer = getelementptr %timespec, %timespec* %time, i64 0, i32 0
+    %seconds = load i64, i64* %seconds_pointer
+    %nanoseconds_pointer = getelementptr %timespec, %timespec* %time, i64 0, i32 1
+    %nanoseconds = load i64, i64* %nanoseconds_pointer
+    %scaled = mul i64 %seconds, 1000000000
+    %total = add i64 %scaled, %nanoseconds
+
+    ret i64 %total
+}
+
+define internal void @empty(i8* %argument) {
+    ret void
+}
+
+; Spawns 'argument' empty tasks from inside of a task, so onto its deque.
+define internal void @spawner(i8* %argument) {
+entry:
+    %count = ptrtoint i8* %argument to i64
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %spawn ]
+    %is_spawning = icmp ult i64 %index, %count
+    br i1 %is_spawning, label %spawn, label %exit
+
+spawn:
+    call %scheduler_SEP_Task* @scheduler_SEP_spawn(void (i8*)* @empty, i8* null)
+    %next_index = add i64 %index, 1
+    br label %condition
+
+exit:
+    ret void
+}
+
+; Parks, then unparks its partner, 'argument' times.
+define internal void @ponger(i8* %argument) {
+entry:
+    %count = ptrtoint i8* %argument to i64
+    %self = call %scheduler_SEP_Task* @scheduler_SEP_current()
+    store atomic %scheduler_SEP_Task* %self, %scheduler_SEP_Task** @partner release, align 8
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %bounce ]
+    %is_bouncing = icmp ult i64 %index, %count
+    br i1 %is_bouncing, label %bounce, label %exit
+
+bounce:
+    call void @scheduler_SEP_park()
+    %pinger = load atomic %scheduler_SEP_Task*, %scheduler_SEP_Task** @partner acquire, align 8
+    call void @scheduler_SEP_unpark(%scheduler_SEP_Task* %pinger)
+    %next_index = add i64 %index, 1
+    br label %condition
+
+exit:
+    ret void
+}
+
+; Unparks its partner, then parks until it is unparked back, 'argument'
+; times.
+define internal void @pinger(i8* %argument) {
+entry:
+    %count = ptrtoint i8* %argument to i64
+    %ponger = load atomic %scheduler_SEP_Task*, %scheduler_SEP_Task** @partner acquire, align 8
+    %self = call %scheduler_SEP_Task* @scheduler_SEP_current()
+    store atomic %scheduler_SEP_Task* %self, %scheduler_SEP_Task** @partner release, align 8
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %bounce ]
+    %is_bouncing = icmp ult i64 %index, %count
+    br i1 %is_bouncing, label %bounce, label %exit
+
+bounce:
+    call void @scheduler_SEP_unpark(%scheduler_SEP_Task* %ponger)
+    call void @scheduler_SEP_park()
+    %next_index = add i64 %index, 1
+    br label %condition
+
+exit:
+    ret void
+}
+
+define internal void @report_throughput(i8* %name, i64 %count, i64 %start, i64 %end, i64 %workers) {
+    %elapsed = sub i64 %end, %start
+    %elapsed_float = sitofp i64 %elapsed to double
+    %count_float = sitofp i64 %count to double
+    %per_nanosecond = fdiv double %count_float, %elapsed_float
+    %per_second = fmul double %per_nanosecond, 1.0e9
+    %format = getelementptr [48 x i8], [48 x i8]* @.spawned_format, i64 0, i64 0
+    call i32 (i8*, ...) @printf(i8* %format, i8* %name, double %per_second, i64 %count, i64 %workers)
+
+    ret void
+}
+
+define i32 @main() {
+    %workers = call i64 @scheduler_SEP_workers()
+
+    ; Throughput, spawning a million tasks from inside of a task
+    %inside_start = call i64 @now()
+    call %scheduler_SEP_Task* @scheduler_SEP_spawn(void (i8*)* @spawner, i8* inttoptr (i64 1000000 to i8*))
+    call void @scheduler_SEP_wait()
+    %inside_end = call i64 @now()
+    %inside_name = getelementptr [22 x i8], [22 x i8]* @.inside_name, i64 0, i64 0
+    call void @report_throughput(i8* %inside_name, i64 1000000, i64 %inside_start, i64 %inside_end, i64 %workers)
+
+    ; Throughput, spawning a hundred thousand tasks from 'main'
+    %outside_start = call i64 @now()
+    call void @spawner(i8* inttoptr (i64 100000 to i8*))
+    call void @scheduler_SEP_wait()
+    %outside_end = call i64 @now()
+    %outside_name = getelementptr [23 x i8], [23 x i8]* @.outside_name, i64 0, i64 0
+    call void @report_throughput(i8* %outside_name, i64 100000, i64 %outside_start, i64 %outside_end, i64 %workers)
+
+    ; Latency, from a task unparking another to that one running, as half of
+    ; a round trip between two tasks
+    call %scheduler_SEP_Task* @scheduler_SEP_spawn(void (i8*)* @ponger, i8* inttoptr (i64 100000 to i8*))
+    br label %wait_for_ponger
+
+wait_for_ponger:
+    %ponger = load atomic %scheduler_SEP_Task*, %scheduler_SEP_Task** @partner acquire, align 8
+    %has_ponger = icmp ne %scheduler_SEP_Task* %ponger, null
+    br i1 %has_ponger, label %latency, label %wait_for_ponger
+
+latency:
+    %latency_start = call i64 @now()
+    call %scheduler_SEP_Task* @scheduler_SEP_spawn(void (i8*)* @pinger, i8* inttoptr (i64 100000 to i8*))
+    call void @scheduler_SEP_wait()
+    %latency_end = call i64 @now()
+    %latency_elapsed = sub i64 %latency_end, %latency_start
+    %latency_float = sitofp i64 %latency_elapsed to double
+    %latency_one_way = fdiv double %latency_float, 200000.0
+    %latency_format = getelementptr [41 x i8], [41 x i8]* @.latency_format, i64 0, i64 0
+    %latency_name = getelementptr [23 x i8], [23 x i8]* @.latency_name, i64 0, i64 0
+    call i32 (i8*, ...) @printf(i8* %latency_format, i8* %latency_name, double %latency_one_way, i64 100000)
+
+    ret i32 0
+}
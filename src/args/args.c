@@ -3,21 +3,32 @@
  * license information. SPDX-License-Identifier: MIT License.
  */
 
+#pragma once
+
 #include "../includes.c"
 
+#include "../utils/array.c"
+#include "../utils/conversions.c"
 #include "../utils/panic.c"
+#include "../utils/string.c"
 #include "./config.c"
 
 /**
  * Represents arguments.
  */
 struct Args {
+    bool cacheReport, checkReport, incremental, inlineReport, instanceReport, lto, profileGenerate, run;
     char **argv;
+    const char *file, *output, *profileUse, *stdlib;
     int argc;
+    size_t codegenUnits;
+    struct Array *packages;
 };
 
 #define ARGS_STRUCT_SIZE sizeof(struct Args)
 
+#define ARGS_MAX_CODEGEN_UNITS 256 // Each unit is compiled by a thread of its own
+
 /* Forward declarations to silence warnings */
 void args_parse(struct Args *self);
 
@@ -36,8 +47,22 @@ struct Args *args_new(int argc, char **argv) {
         panic("failed to malloc Args struct");
     }
 
+    self->cacheReport = false;
+    self->checkReport = false;
+    self->incremental = false;
+    self->inlineReport = false;
+    self->instanceReport = false;
+    self->lto = false;
+    self->profileGenerate = false;
+    self->run = false;
     self->argv = argv;
+    self->file = NULL;
+    self->output = "a.out";
+    self->profileUse = NULL;
+    self->stdlib = "../../lib";
     self->argc = argc;
+    self->codegenUnits = 1;
+    self->packages = array_new();
 
     args_parse(self);
 
@@ -51,6 +76,8 @@ struct Args *args_new(int argc, char **argv) {
  */
 void args_free(struct Args **self) {
     if (self && *self) {
+        array_free(&(*self)->packages);
+
         free(*self);
         *self = NULL;
     } else {
@@ -58,4 +85,123 @@ void args_free(struct Args **self) {
     }
 }
 
-void args_parse(struct Args *self) {}
+/**
+ * Gets the config of a flag argument.
+ *
+ * @param FLAG The flag, either in its short or long form.
+ *
+ * @return The config of the argument, or NULL if there is none.
+ */
+const struct Arg *args_getFlag(const char *FLAG) {
+    for (size_t index = 0; index < CONFIG.length; index++) {
+        const struct Arg *arg = CONFIG._values[index];
+
+        if ((arg->flagShort && strcmp(arg->flagShort, FLAG) == 0) ||
+            (arg->flagLong && strcmp(arg->flagLong, FLAG) == 0)) {
+            return arg;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Checks whether a file holds LLVM IR, going by its extension.
+ *
+ * @param FILE The path to the file.
+ *
+ * @return Whether the file holds LLVM IR.
+ */
+bool args_isLlvmIr_(const char *FILE) {
+    size_t length = strlen(FILE);
+
+    return length > 3 && (strcmp(FILE + length - 3, ".ll") == 0 || strcmp(FILE + length - 3, ".bc") == 0);
+}
+
+/**
+ * Parses the arguments into the Args struct. Values can either follow
+ * their flag, or be joined to a long flag with '=' (e.g. '--output=a.out').
+ *
+ * @param self The current Args struct.
+ */
+void args_parse(struct Args *self) {
+    for (int index = 1; index < self->argc; index++) {
+        char *argument = self->argv[index], *value = NULL, *separator = NULL;
+        const struct Arg *arg = NULL;
+
+        if (argument[0] != '-') { // Positional argument
+            if (index == 1 && (strcmp(argument, "build") == 0 || strcmp(argument, "run") == 0)) {
+                self->run = strcmp(argument, "run") == 0;
+            } else if (!self->file) {
+                self->file = argument;
+            } else {
+                panic(stringConcatenate(3, "unexpected positional argument '", argument, "'"));
+            }
+
+            continue;
+        }
+
+        if (argument[1] == '-' && (separator = strchr(argument, '='))) {
+            value = separator + 1;
+            argument = strndup(argument, (size_t)(separator - argument));
+        }
+
+        arg = args_getFlag(argument);
+
+        if (!arg) {
+            panic(stringConcatenate(3, "unknown argument '", argument, "'"));
+        } else if (!arg->value && value) {
+            panic(stringConcatenate(3, "unexpected value for argument '", argument, "'"));
+        } else if (arg->value && !value) {
+            if (++index >= self->argc) {
+                panic(stringConcatenate(3, "expected a value after argument '", argument, "'"));
+            }
+
+            value = self->argv[index];
+        }
+
+        if (strcmp(arg->name, "stdlib") == 0) {
+            self->stdlib = value;
+        } else if (strcmp(arg->name, "output") == 0) {
+            self->output = value;
+        } else if (strcmp(arg->name, "cacheReport") == 0) {
+            self->cacheReport = true;
+        } else if (strcmp(arg->name, "checkReport") == 0) {
+            self->checkReport = true;
+        } else if (strcmp(arg->name, "incremental") == 0) {
+            self->incremental = true;
+        } else if (strcmp(arg->name, "inlineReport") == 0) {
+            self->inlineReport = true;
+        } else if (strcmp(arg->name, "instanceReport") == 0) {
+            self->instanceReport = true;
+        } else if (strcmp(arg->name, "lto") == 0) {
+            self->lto = true;
+        } else if (strcmp(arg->name, "package") == 0) {
+            array_insert(self->packages, self->packages->length, value);
+        } else if (strcmp(arg->name, "profileGenerate") == 0) {
+            self->profileGenerate = true;
+        } else if (strcmp(arg->name, "profileUse") == 0) {
+            self->profileUse = value;
+        } else if (strcmp(arg->name, "codegenUnits") == 0) {
+            char *end = NULL;
+            long units = strtol(value, &end, 10);
+
+            if (end == value || *end || units <= 0 || units > ARGS_MAX_CODEGEN_UNITS) {
+                panic(stringConcatenate(7, "invalid value '", value, "' for argument '", argument, "', expected 1 to ",
+                                        ulToString(ARGS_MAX_CODEGEN_UNITS), " codegen units"));
+            }
+
+            self->codegenUnits = (size_t)units;
+        }
+
+        if (separator) {
+            free(argument);
+        }
+    }
+
+    if (!self->file) {
+        panic("missing required argument 'file'");
+    } else if (self->run && !args_isLlvmIr_(self->file)) { // The compiler does not emit LLVM IR to run yet
+        panic(stringConcatenate(3, "cannot run '", self->file, "', expected an LLVM IR file ('.ll' or '.bc')"));
+    }
+}
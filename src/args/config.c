@@ -3,6 +3,8 @@
  * license information. SPDX-License-Identifier: MIT License.
  */
 
+#pragma once
+
 #include "../includes.c"
 
 #include "../utils/array.c"
@@ -13,7 +15,7 @@ extern const struct Array CONFIG;
  * Represents an argument.
  */
 struct Arg {
-    bool required;
+    bool required, value;
     char *description, *name, *flagShort, *flagLong;
 };
 
@@ -21,9 +23,18 @@ struct Arg {
  * Represents the config for parsing arguments.
  */
 const struct Array CONFIG = {
-    1,
+    14,
     (const void *[]){&(struct Arg){
+                         false,
+                         false,
+                         "The command to run, either 'build' (default) or 'run'",
+                         "command",
+                         NULL,
+                         NULL,
+                     },
+                     &(struct Arg){
                          true,
+                         false,
                          "The path of the file to compile",
                          "file",
                          NULL,
@@ -31,9 +42,98 @@ const struct Array CONFIG = {
                      },
                      &(struct Arg){
                          false,
+                         true,
                          "The path to the folder containing the standard library",
                          "stdlib",
                          "-s",
                          "--stdlib",
+                     },
+                     &(struct Arg){
+                         false,
+                         true,
+                         "The path of the executable to output",
+                         "output",
+                         "-o",
+                         "--output",
+                     },
+                     &(struct Arg){
+                         false,
+                         true,
+                         "The number of codegen units to split a module into, from 1 to 256, each emitted on its own thread",
+                         "codegenUnits",
+                         "-j",
+                         "--codegen-units",
+                     },
+                     &(struct Arg){
+                         false,
+                         false,
+                         "Only recompile the functions which have changed since the last build",
+                         "incremental",
+                         "-i",
+                         "--incremental",
+                     },
+                     &(struct Arg){
+                         false,
+                         false,
+                         "Optimise the whole program across packages when linking",
+                         "lto",
+                         NULL,
+                         "--lto",
+                     },
+                     &(struct Arg){
+                         false,
+                         true,
+                         "The path of a package's bitcode to link into the program, can be given multiple times",
+                         "package",
+                         "-p",
+                         "--package",
+                     },
+                     &(struct Arg){
+                         false,
+                         false,
+                         "Instrument the program to write a profile to 'default.exlprof' (or $EXEME_PROFILE_FILE) when run",
+                         "profileGenerate",
+                         NULL,
+                         "--profile-generate",
+                     },
+                     &(struct Arg){
+                         false,
+                         true,
+                         "The path of a profile to optimise the program with",
+                         "profileUse",
+                         NULL,
+                         "--profile-use",
+                     },
+                     &(struct Arg){
+                         false,
+                         false,
+                         "Print why each call was or was not inlined",
+                         "inlineReport",
+                         NULL,
+                         "--inline-report",
+                     },
+                     &(struct Arg){
+                         false,
+                         false,
+                         "Print how many safety checks were removed from each function",
+                         "checkReport",
+                         NULL,
+                         "--check-report",
+                     },
+                     &(struct Arg){
+                         false,
+                         false,
+                         "Print how many instances of generics were made, shared and merged",
+                         "instanceReport",
+                         NULL,
+                         "--instance-report",
+                     },
+                     &(struct Arg){
+                         false,
+                         false,
+                         "Print how many functions changed and were recompiled by an incremental build",
+                         "cacheReport",
+                         NULL,
+                         "--cache-report",
                      }},
 };
@@ -0,0 +1,243 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+#pragma once
+
+#include "../includes.c"
+
+#include <llvm-c/Core.h>
+
+#include "../utils/array.c"
+#include "../utils/panic.c"
+
+#define ALIGN_METADATA "exeme.align" // Lists the classes marked '@align(N)', as '!{%Class* null, i64 N}'
+
+/**
+ * Gets whether two struct types are the same class. Classes are compared
+ * by name, as linking modules which declare a class with different field
+ * types, like 'i8*' for a pointer to a class they do not use, renames one
+ * of them with a '.N' suffix.
+ *
+ * @param type  The type.
+ * @param other The other type.
+ *
+ * @return Whether they are the same class.
+ */
+bool align_isClass_(LLVMTypeRef type, LLVMTypeRef other) {
+    const char *NAME = LLVMGetStructName(type), *OTHER_NAME = LLVMGetStructName(other);
+    size_t length = 0, otherLength = 0;
+
+    if (type == other) {
+        return true;
+    } else if (!NAME || !OTHER_NAME) {
+        return false;
+    }
+
+    length = strlen(NAME);
+    otherLength = strlen(OTHER_NAME);
+
+    while (length && isdigit(NAME[length - 1])) {
+        length--;
+    }
+
+    while (otherLength && isdigit(OTHER_NAME[otherLength - 1])) {
+        otherLength--;
+    }
+
+    length = length && NAME[length - 1] == '.' && length < strlen(NAME) ? length - 1 : strlen(NAME);
+    otherLength = otherLength && OTHER_NAME[otherLength - 1] == '.' && otherLength < strlen(OTHER_NAME)
+                      ? otherLength - 1
+                      : strlen(OTHER_NAME);
+
+    return length == otherLength && strncmp(NAME, OTHER_NAME, length) == 0;
+}
+
+/**
+ * Gets the alignment a type is marked '@align(N)' with. Arrays of it are
+ * aligned as it is, which only aligns their first element, unless its size
+ * is a multiple of the alignment.
+ *
+ * @param module The module.
+ * @param type   The type.
+ *
+ * @return The alignment, or 0 if the type is not marked.
+ */
+unsigned align_getAlignment_(LLVMModuleRef module, LLVMTypeRef type) {
+    unsigned length = LLVMGetNamedMetadataNumOperands(module, ALIGN_METADATA), alignment = 0;
+    LLVMValueRef *classes = NULL;
+
+    while (LLVMGetTypeKind(type) == LLVMArrayTypeKind) {
+        type = LLVMGetElementType(type);
+    }
+
+    if (!length || LLVMGetTypeKind(type) != LLVMStructTypeKind) {
+        return 0;
+    }
+
+    classes = malloc(length * sizeof(LLVMValueRef));
+
+    if (!classes) {
+        panic("failed to malloc aligned classes");
+    }
+
+    LLVMGetNamedMetadataOperands(module, ALIGN_METADATA, classes);
+
+    for (unsigned index = 0; index < length && !alignment; index++) {
+        LLVMValueRef operands[2];
+
+        if (LLVMGetMDNodeNumOperands(classes[index]) != 2) {
+            continue;
+        }
+
+        LLVMGetMDNodeOperands(classes[index], operands);
+
+        if (LLVMGetTypeKind(LLVMTypeOf(operands[0])) == LLVMPointerTypeKind &&
+            align_isClass_(LLVMGetElementType(LLVMTypeOf(operands[0])), type)) {
+            alignment = (unsigned)LLVMConstIntGetZExtValue(operands[1]);
+        }
+    }
+
+    free(classes);
+
+    return alignment;
+}
+
+/**
+ * Gets the alignment of the class a heap allocation is cast to, if it is
+ * marked '@align(N)'.
+ *
+ * @param module The module.
+ * @param call   The call to malloc.
+ *
+ * @return The alignment, or 0 if the class is not marked.
+ */
+unsigned align_getHeapAlignment_(LLVMModuleRef module, LLVMValueRef call) {
+    unsigned alignment = 0;
+
+    for (LLVMUseRef use = LLVMGetFirstUse(call); use; use = LLVMGetNextUse(use)) {
+        LLVMValueRef user = LLVMGetUser(use);
+
+        if (LLVMIsABitCastInst(user)) {
+            unsigned castAlignment = align_getAlignment_(module, LLVMGetElementType(LLVMTypeOf(user)));
+
+            alignment = castAlignment > alignment ? castAlignment : alignment;
+        }
+    }
+
+    return alignment;
+}
+
+/**
+ * Aligns the instances of classes marked '@align(N)', which are listed in
+ * the module's 'exeme.align' metadata, so structures shared between threads
+ * never share a cache line with anything else. Global variables and
+ * allocas of them, or of arrays of them, are aligned, and calls to malloc
+ * whose memory is cast to them become calls to aligned_alloc, with their
+ * sizes rounded up to the alignment. Runs before escape analysis, which
+ * leaves calls to aligned_alloc on the heap.
+ *
+ * @param module The module.
+ */
+void align_apply(LLVMModuleRef module) {
+    LLVMContextRef context = LLVMGetModuleContext(module);
+    LLVMBuilderRef builder = NULL;
+    LLVMTypeRef int64 = LLVMInt64TypeInContext(context), alignedAllocType = NULL;
+    LLVMValueRef alignedAlloc = NULL;
+
+    if (!LLVMGetNamedMetadataNumOperands(module, ALIGN_METADATA)) {
+        return;
+    }
+
+    builder = LLVMCreateBuilderInContext(context);
+    alignedAllocType = LLVMFunctionType(LLVMPointerType(LLVMInt8TypeInContext(context), 0),
+                                        (LLVMTypeRef[]){int64, int64}, 2, false);
+
+    for (LLVMValueRef global = LLVMGetFirstGlobal(module); global; global = LLVMGetNextGlobal(global)) {
+        unsigned alignment = align_getAlignment_(module, LLVMGlobalGetValueType(global));
+
+        if (alignment > LLVMGetAlignment(global)) {
+            LLVMSetAlignment(global, alignment);
+        }
+    }
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+        for (LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function); block; block = LLVMGetNextBasicBlock(block)) {
+            LLVMValueRef instruction = LLVMGetFirstInstruction(block), next = NULL;
+
+            for (; instruction; instruction = next) {
+                LLVMValueRef callee = LLVMIsACallInst(instruction) ? LLVMGetCalledValue(instruction) : NULL;
+                LLVMValueRef mask = NULL, size = NULL, allocation = NULL;
+                unsigned alignment = 0;
+
+                next = LLVMGetNextInstruction(instruction);
+
+                if (LLVMIsAAllocaInst(instruction)) {
+                    alignment = align_getAlignment_(module, LLVMGetAllocatedType(instruction));
+
+                    if (alignment > LLVMGetAlignment(instruction)) {
+                        LLVMSetAlignment(instruction, alignment);
+                    }
+
+                    continue;
+                } else if (!callee || !LLVMIsAFunction(callee) || strcmp(LLVMGetValueName(callee), "malloc") != 0 ||
+                           !(alignment = align_getHeapAlignment_(module, instruction))) {
+                    continue;
+                }
+
+                if (!alignedAlloc && !(alignedAlloc = LLVMGetNamedFunction(module, "aligned_alloc"))) {
+                    alignedAlloc = LLVMAddFunction(module, "aligned_alloc", alignedAllocType);
+                }
+
+                // aligned_alloc needs sizes which are multiples of the alignment
+                LLVMPositionBuilderBefore(builder, instruction);
+                mask = LLVMConstInt(int64, alignment - 1, false);
+                size = LLVMBuildAnd(builder, LLVMBuildAdd(builder, LLVMGetOperand(instruction, 0), mask, ""),
+                                    LLVMConstNot(mask), "");
+                allocation = LLVMBuildCall2(builder, alignedAllocType, alignedAlloc,
+                                            (LLVMValueRef[]){LLVMConstInt(int64, alignment, false), size}, 2, "");
+
+                LLVMReplaceAllUsesWith(instruction, allocation);
+                LLVMInstructionEraseFromParent(instruction);
+            }
+        }
+    }
+
+    LLVMDisposeBuilder(builder);
+}
+
+/**
+ * Shares the classes marked '@align(N)' between modules which are compiled
+ * separately, as the JIT's are, so instances of a class one module marks
+ * are aligned in the others. Those collected from earlier modules are added
+ * to the module, then those it marks itself are collected.
+ *
+ * @param module  The module.
+ * @param classes The classes collected so far, as metadata.
+ */
+void align_share(LLVMModuleRef module, struct Array *classes) {
+    unsigned length = LLVMGetNamedMetadataNumOperands(module, ALIGN_METADATA);
+    size_t previousLength = classes->length;
+    LLVMValueRef *marked = NULL;
+
+    if (length) {
+        marked = malloc(length * sizeof(LLVMValueRef));
+
+        if (!marked) {
+            panic("failed to malloc aligned classes");
+        }
+
+        LLVMGetNamedMetadataOperands(module, ALIGN_METADATA, marked);
+
+        for (unsigned index = 0; index < length; index++) {
+            array_insert(classes, classes->length, marked[index]);
+        }
+
+        free(marked);
+    }
+
+    for (size_t index = 0; index < previousLength; index++) {
+        LLVMAddNamedMetadataOperand(module, ALIGN_METADATA, (LLVMValueRef)array_get(classes, index));
+    }
+}
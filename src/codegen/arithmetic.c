@@ -0,0 +1,340 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+#pragma once
+
+#include "../includes.c"
+
+#include <limits.h>
+
+#include <llvm-c/Core.h>
+
+#include "../utils/panic.c"
+
+/**
+ * Builds a call to an overloaded intrinsic.
+ *
+ * @param builder         The builder.
+ * @param NAME            The name of the intrinsic.
+ * @param overloads       The types the intrinsic is overloaded on.
+ * @param overloadsLength The number of types.
+ * @param arguments       The arguments.
+ * @param length          The number of arguments.
+ *
+ * @return The call.
+ */
+LLVMValueRef arithmetic_buildIntrinsic(LLVMBuilderRef builder, const char *NAME, LLVMTypeRef *overloads,
+                                       size_t overloadsLength, LLVMValueRef *arguments, unsigned length) {
+    LLVMModuleRef module = LLVMGetGlobalParent(LLVMGetBasicBlockParent(LLVMGetInsertBlock(builder)));
+    unsigned id = LLVMLookupIntrinsicID(NAME, strlen(NAME));
+
+    return LLVMBuildCall2(builder, LLVMIntrinsicGetType(LLVMGetModuleContext(module), id, overloads, overloadsLength),
+                          LLVMGetIntrinsicDeclaration(module, id, overloads, overloadsLength), arguments, length, "");
+}
+
+/**
+ * Builds an integer to a negative power, which truncates to 0 unless the
+ * integer is 1 or -1.
+ *
+ * @param builder  The builder.
+ * @param base     The integer.
+ * @param exponent The power, of the same type.
+ *
+ * @return The result.
+ */
+LLVMValueRef arithmetic_buildNegativePower_(LLVMBuilderRef builder, LLVMValueRef base, LLVMValueRef exponent) {
+    LLVMTypeRef type = LLVMTypeOf(base);
+    LLVMValueRef one = LLVMConstInt(type, 1, false), minusOne = LLVMConstAllOnes(type);
+    LLVMValueRef odd = LLVMBuildTrunc(builder, exponent, LLVMInt1TypeInContext(LLVMGetTypeContext(type)), "");
+
+    return LLVMBuildSelect(builder, LLVMBuildICmp(builder, LLVMIntEQ, base, minusOne, ""),
+                           LLVMBuildSelect(builder, odd, minusOne, one, ""),
+                           LLVMBuildZExt(builder, LLVMBuildICmp(builder, LLVMIntEQ, base, one, ""), type, ""), "");
+}
+
+/**
+ * Builds an integer to a constant power, unrolling exponentiation by
+ * squaring, so 'x ** 5' is 3 multiplies.
+ *
+ * @param builder  The builder.
+ * @param base     The integer.
+ * @param exponent The power, which must not be negative.
+ *
+ * @return The result.
+ */
+LLVMValueRef arithmetic_buildConstantPower_(LLVMBuilderRef builder, LLVMValueRef base, unsigned long long exponent) {
+    LLVMValueRef result = NULL, square = base;
+
+    for (; exponent; exponent >>= 1) {
+        if (exponent & 1) {
+            result = result ? LLVMBuildMul(builder, result, square, "") : square;
+        }
+
+        if (exponent > 1) {
+            square = LLVMBuildMul(builder, square, square, "");
+        }
+    }
+
+    return result ? result : LLVMConstInt(LLVMTypeOf(base), 1, false);
+}
+
+/**
+ * Builds a number to a power known only at runtime, as a loop of
+ * exponentiation by squaring which runs once per bit of the power.
+ *
+ * @param builder  The builder, positioned at the end of a block. It is left
+ * positioned after the loop.
+ * @param base     The integer or float, not a vector, as the loop branches
+ * on the power's bits.
+ * @param exponent The power, an integer treated as unsigned, of the same
+ * type as an integer base.
+ *
+ * @return The result.
+ */
+LLVMValueRef arithmetic_buildVariablePower_(LLVMBuilderRef builder, LLVMValueRef base, LLVMValueRef exponent) {
+    LLVMBasicBlockRef entry = LLVMGetInsertBlock(builder), next = LLVMGetNextBasicBlock(entry), body = NULL,
+                      exit = NULL;
+    LLVMContextRef context = LLVMGetTypeContext(LLVMTypeOf(base));
+    LLVMTypeRef type = LLVMTypeOf(base), exponentType = LLVMTypeOf(exponent);
+    LLVMValueRef function = LLVMGetBasicBlockParent(entry), result = NULL, square = NULL, remaining = NULL,
+                 nextResult = NULL, nextSquare = NULL, nextRemaining = NULL, one = NULL;
+    bool isFloat = LLVMGetTypeKind(type) != LLVMIntegerTypeKind;
+
+    if (LLVMGetTypeKind(type) == LLVMVectorTypeKind) {
+        panic("vectors cannot be raised to powers known only at runtime");
+    }
+
+    one = isFloat ? LLVMConstReal(type, 1) : LLVMConstInt(type, 1, false);
+
+    // After the current block, so the function reads in order
+    body = next ? LLVMInsertBasicBlockInContext(context, next, "power.body")
+                : LLVMAppendBasicBlockInContext(context, function, "power.body");
+    exit = next ? LLVMInsertBasicBlockInContext(context, next, "power.exit")
+                : LLVMAppendBasicBlockInContext(context, function, "power.exit");
+
+    LLVMBuildBr(builder, body);
+    LLVMPositionBuilderAtEnd(builder, body);
+    result = LLVMBuildPhi(builder, type, "power.result");
+    square = LLVMBuildPhi(builder, type, "power.square");
+    remaining = LLVMBuildPhi(builder, exponentType, "power.remaining");
+
+    nextResult = LLVMBuildSelect(builder, LLVMBuildTrunc(builder, remaining, LLVMInt1TypeInContext(context), ""),
+                                 isFloat ? LLVMBuildFMul(builder, result, square, "")
+                                         : LLVMBuildMul(builder, result, square, ""),
+                                 result, "");
+    nextSquare = isFloat ? LLVMBuildFMul(builder, square, square, "") : LLVMBuildMul(builder, square, square, "");
+    nextRemaining = LLVMBuildLShr(builder, remaining, LLVMConstInt(exponentType, 1, false), "");
+    LLVMBuildCondBr(builder, LLVMBuildICmp(builder, LLVMIntNE, nextRemaining, LLVMConstNull(exponentType), ""), body,
+                    exit);
+
+    LLVMAddIncoming(result, (LLVMValueRef[]){one, nextResult}, (LLVMBasicBlockRef[]){entry, body}, 2);
+    LLVMAddIncoming(square, (LLVMValueRef[]){base, nextSquare}, (LLVMBasicBlockRef[]){entry, body}, 2);
+    LLVMAddIncoming(remaining, (LLVMValueRef[]){exponent, nextRemaining}, (LLVMBasicBlockRef[]){entry, body}, 2);
+
+    LLVMPositionBuilderAtEnd(builder, exit);
+
+    return nextResult;
+}
+
+/**
+ * Gets whether a floating point constant is a whole number small enough
+ * for 'llvm.powi'.
+ *
+ * @param value The constant.
+ *
+ * @return Whether it is a whole number.
+ */
+bool arithmetic_isWholeNumber_(LLVMValueRef value) {
+    LLVMBool losesInfo = false;
+    double number = LLVMIsAConstantFP(value) ? LLVMConstRealGetDouble(value, &losesInfo) : 0.5;
+
+    return !losesInfo && number >= INT_MIN && number <= INT_MAX && number == (double)(int)number;
+}
+
+/**
+ * Gets whether an integer always fits in a signed 32-bit integer, the power
+ * 'llvm.powi' takes.
+ *
+ * @param value    The integer.
+ * @param isSigned Whether it is signed.
+ *
+ * @return Whether it fits.
+ */
+bool arithmetic_fitsInt32_(LLVMValueRef value, bool isSigned) {
+    unsigned width = LLVMGetIntTypeWidth(LLVMTypeOf(value));
+
+    if (LLVMIsAConstantInt(value)) {
+        return isSigned ? LLVMConstIntGetSExtValue(value) >= INT_MIN && LLVMConstIntGetSExtValue(value) <= INT_MAX
+                        : LLVMConstIntGetZExtValue(value) <= INT_MAX;
+    }
+
+    return isSigned ? width <= 32 : width <= 31;
+}
+
+/**
+ * Builds the '**' operator. Integer powers use exponentiation by squaring,
+ * unrolled when the power is a constant, and negative powers truncate
+ * towards 0 like '/'. Floats raised to whole numbers use 'llvm.powi',
+ * which becomes multiplies for constants rather than a call to 'pow'. Its
+ * power is a signed 32-bit integer, so scalar floats raised to unsigned
+ * integers which may not fit in one use the squaring loop instead. Floats
+ * raised to floats known only at runtime, or to other integers wider than
+ * 32 bits which are not small constants, still use 'llvm.pow', a call to
+ * libm's 'pow'.
+ *
+ * @param builder  The builder, positioned at the end of a block. It may be
+ * left in a new block.
+ * @param base     The number, a scalar or a vector of floats.
+ * @param exponent The power.
+ * @param isSigned Whether integers are signed.
+ *
+ * @return The result.
+ */
+LLVMValueRef arithmetic_buildPower(LLVMBuilderRef builder, LLVMValueRef base, LLVMValueRef exponent, bool isSigned) {
+    LLVMTypeRef type = LLVMTypeOf(base), int32 = LLVMInt32TypeInContext(LLVMGetTypeContext(type));
+    LLVMTypeRef elementType = LLVMGetTypeKind(type) == LLVMVectorTypeKind ? LLVMGetElementType(type) : type;
+    LLVMValueRef negative = NULL, result = NULL;
+
+    if (LLVMGetTypeKind(elementType) != LLVMIntegerTypeKind) {
+        bool isInteger = LLVMGetTypeKind(LLVMTypeOf(exponent)) == LLVMIntegerTypeKind;
+
+        if (isInteger && arithmetic_fitsInt32_(exponent, isSigned)) {
+            exponent = LLVMBuildIntCast2(builder, exponent, int32, isSigned, "");
+        } else if (isInteger && !isSigned && type == elementType) { // 'llvm.powi' would read it as negative
+            return arithmetic_buildVariablePower_(builder, base, exponent);
+        } else if (isInteger) {
+            exponent =
+                isSigned ? LLVMBuildSIToFP(builder, exponent, type, "") : LLVMBuildUIToFP(builder, exponent, type, "");
+        } else if (arithmetic_isWholeNumber_(exponent)) {
+            exponent = LLVMBuildFPToSI(builder, exponent, int32, "");
+        }
+
+        if (LLVMTypeOf(exponent) == int32) {
+            return arithmetic_buildIntrinsic(builder, "llvm.powi", (LLVMTypeRef[]){type, int32}, 2,
+                                             (LLVMValueRef[]){base, exponent}, 2);
+        }
+
+        return arithmetic_buildIntrinsic(builder, "llvm.pow", &type, 1, (LLVMValueRef[]){base, exponent}, 2);
+    }
+
+    exponent = LLVMBuildIntCast2(builder, exponent, type, isSigned, "");
+
+    if (LLVMIsAConstantInt(exponent)) {
+        return isSigned && LLVMConstIntGetSExtValue(exponent) < 0
+                   ? arithmetic_buildNegativePower_(builder, base, exponent)
+                   : arithmetic_buildConstantPower_(builder, base, LLVMConstIntGetZExtValue(exponent));
+    } else if (!isSigned) {
+        return arithmetic_buildVariablePower_(builder, base, exponent);
+    }
+
+    // Negative powers skip the loop, as it would run once for every bit
+    negative = LLVMBuildICmp(builder, LLVMIntSLT, exponent, LLVMConstNull(type), "");
+    result = arithmetic_buildVariablePower_(builder, base,
+                                            LLVMBuildSelect(builder, negative, LLVMConstNull(type), exponent, ""));
+
+    return LLVMBuildSelect(builder, negative, arithmetic_buildNegativePower_(builder, base, exponent), result, "");
+}
+
+/**
+ * Gets the base 2 logarithm of a constant integer, if it is a power of 2.
+ *
+ * @param value The constant.
+ *
+ * @return The logarithm, or -1 if the constant is not a positive power of
+ * 2.
+ */
+int arithmetic_getLog2_(LLVMValueRef value) {
+    unsigned long long number = LLVMConstIntGetZExtValue(value);
+
+    if (!number || (number & (number - 1)) || LLVMConstIntGetSExtValue(value) < 0) {
+        return -1;
+    }
+
+    return __builtin_ctzll(number);
+}
+
+/**
+ * Builds the '//' operator, which rounds towards negative infinity rather
+ * than 0 like '/'. For constant positive divisors, signed division needs no
+ * correction: powers of 2 are an arithmetic shift, and other divisors flip
+ * negative numbers to their complement around an unsigned divide, which
+ * LLVM turns into a multiply by a magic number.
+ *
+ * @param builder  The builder.
+ * @param left     The dividend.
+ * @param right    The divisor, of the same type.
+ * @param isSigned Whether integers are signed.
+ *
+ * @return The result.
+ */
+LLVMValueRef arithmetic_buildFloorDivision(LLVMBuilderRef builder, LLVMValueRef left, LLVMValueRef right,
+                                           bool isSigned) {
+    LLVMTypeRef type = LLVMTypeOf(left);
+    LLVMTypeRef elementType = LLVMGetTypeKind(type) == LLVMVectorTypeKind ? LLVMGetElementType(type) : type;
+    LLVMValueRef sign = NULL, quotient = NULL, remainder = NULL, zero = LLVMConstNull(type), adjust = NULL;
+    int log2 = 0;
+
+    if (LLVMGetTypeKind(elementType) != LLVMIntegerTypeKind) {
+        return arithmetic_buildIntrinsic(builder, "llvm.floor", &type, 1,
+                                         (LLVMValueRef[]){LLVMBuildFDiv(builder, left, right, "")}, 1);
+    } else if (!isSigned) {
+        return LLVMBuildUDiv(builder, left, right, "");
+    } else if (LLVMIsAConstantInt(right) && (log2 = arithmetic_getLog2_(right)) >= 0) {
+        return LLVMBuildAShr(builder, left, LLVMConstInt(type, (unsigned long long)log2, false), "");
+    } else if (LLVMIsAConstantInt(right) && LLVMConstIntGetSExtValue(right) > 0) {
+        // For negative numbers, floor(n / d) == ~(~n / d), and ~n is not negative
+        sign = LLVMBuildAShr(builder, left, LLVMConstInt(type, LLVMGetIntTypeWidth(type) - 1, false), "");
+
+        return LLVMBuildXor(builder, LLVMBuildUDiv(builder, LLVMBuildXor(builder, left, sign, ""), right, ""), sign,
+                            "");
+    }
+
+    // Division truncates, so is 1 too high when the remainder's sign differs from the divisor's
+    quotient = LLVMBuildSDiv(builder, left, right, "");
+    remainder = LLVMBuildSRem(builder, left, right, "");
+    adjust = LLVMBuildAnd(builder, LLVMBuildICmp(builder, LLVMIntNE, remainder, zero, ""),
+                          LLVMBuildICmp(builder, LLVMIntSLT, LLVMBuildXor(builder, remainder, right, ""), zero, ""), "");
+
+    return LLVMBuildSub(builder, quotient, LLVMBuildZExt(builder, adjust, type, ""), "");
+}
+
+/**
+ * Builds the remainder of '//', which has the divisor's sign rather than
+ * the dividend's like the remainder of '/'. Constant positive powers of 2
+ * are a mask.
+ *
+ * @param builder  The builder.
+ * @param left     The dividend.
+ * @param right    The divisor, of the same type.
+ * @param isSigned Whether integers are signed.
+ *
+ * @return The result.
+ */
+LLVMValueRef arithmetic_buildFloorModulo(LLVMBuilderRef builder, LLVMValueRef left, LLVMValueRef right, bool isSigned) {
+    LLVMTypeRef type = LLVMTypeOf(left);
+    LLVMTypeRef elementType = LLVMGetTypeKind(type) == LLVMVectorTypeKind ? LLVMGetElementType(type) : type;
+    LLVMValueRef remainder = NULL, zero = LLVMConstNull(type), adjust = NULL;
+    int log2 = 0;
+
+    if (LLVMGetTypeKind(elementType) != LLVMIntegerTypeKind) {
+        return LLVMBuildFSub(
+            builder, left, LLVMBuildFMul(builder, arithmetic_buildFloorDivision(builder, left, right, isSigned), right, ""),
+            "");
+    } else if (!isSigned) {
+        return LLVMBuildURem(builder, left, right, "");
+    } else if (LLVMIsAConstantInt(right) && (log2 = arithmetic_getLog2_(right)) >= 0) {
+        return LLVMBuildAnd(builder, left, LLVMConstInt(type, (1ULL << log2) - 1, false), "");
+    } else if (LLVMIsAConstantInt(right) && LLVMConstIntGetSExtValue(right) > 0) {
+        return LLVMBuildSub(
+            builder, left, LLVMBuildMul(builder, arithmetic_buildFloorDivision(builder, left, right, isSigned), right, ""),
+            "");
+    }
+
+    remainder = LLVMBuildSRem(builder, left, right, "");
+    adjust = LLVMBuildAnd(builder, LLVMBuildICmp(builder, LLVMIntNE, remainder, zero, ""),
+                          LLVMBuildICmp(builder, LLVMIntSLT, LLVMBuildXor(builder, remainder, right, ""), zero, ""), "");
+
+    return LLVMBuildAdd(builder, remainder, LLVMBuildSelect(builder, adjust, right, zero, ""), "");
+}
@@ -0,0 +1,468 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+#pragma once
+
+#include "../includes.c"
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include <llvm-c/Core.h>
+#include <llvm/Config/llvm-config.h>
+
+#include "../utils/array.c"
+#include "../utils/panic.c"
+#include "../utils/string.c"
+
+#ifdef _WIN32
+#include <direct.h>
+#define cache_makeDirectory_(PATH) _mkdir(PATH)
+#else
+#define cache_makeDirectory_(PATH) mkdir(PATH, 0755)
+#endif
+
+#define CACHE_HASH_OFFSET 14695981039346656037ULL // FNV-1a
+#define CACHE_HASH_PRIME 1099511628211ULL
+
+#define CACHE_GLOBALS_NAME "$globals" // Cannot clash with a function name
+
+/**
+ * Identifies the build of exeme, which changes whenever exeme or the LLVM
+ * it is built against does, so objects compiled by another are not reused.
+ */
+#define CACHE_VERSION LLVM_VERSION_STRING " " __DATE__ " " __TIME__
+
+/**
+ * Represents a function in the dependency graph.
+ */
+struct CacheEntry {
+    char *name;
+    struct Array *dependencies;
+    uint64_t fingerprint;
+};
+
+#define CACHEENTRY_STRUCT_SIZE sizeof(struct CacheEntry)
+
+/**
+ * Represents the incremental compilation cache, a dependency graph of the
+ * functions of the last build and the object code generated for each of
+ * them, persisted in the build directory.
+ */
+struct Cache {
+    const char *DIRECTORY;
+    struct Array *entries, *previousEntries;
+    uint64_t salt; // Hashes what else changes the generated code, see 'cache_new'
+};
+
+#define CACHE_STRUCT_SIZE sizeof(struct Cache)
+
+/**
+ * Creates a new CacheEntry struct.
+ *
+ * @param name        The name of the function.
+ * @param fingerprint The fingerprint of the function.
+ *
+ * @return The created CacheEntry struct.
+ */
+struct CacheEntry *cacheEntry_new(char *name, uint64_t fingerprint) {
+    struct CacheEntry *self = malloc(CACHEENTRY_STRUCT_SIZE);
+
+    if (!self) {
+        panic("failed to malloc CacheEntry struct");
+    }
+
+    self->name = name;
+    self->dependencies = array_new();
+    self->fingerprint = fingerprint;
+
+    return self;
+}
+
+/**
+ * Frees a CacheEntry struct.
+ *
+ * @param self The current CacheEntry struct.
+ */
+void cacheEntry_free(struct CacheEntry **self) {
+    if (self && *self) {
+        for (size_t index = 0; index < (*self)->dependencies->length; index++) {
+            free((void *)array_get((*self)->dependencies, index));
+        }
+
+        array_free(&(*self)->dependencies);
+        free((*self)->name);
+
+        free(*self);
+        *self = NULL;
+    } else {
+        panic("CacheEntry struct has already been freed");
+    }
+}
+
+/**
+ * Hashes a string, continuing from a previous hash.
+ *
+ * @param STRING The string to hash.
+ * @param hash   The previous hash, or CACHE_HASH_OFFSET.
+ *
+ * @return The hash.
+ */
+uint64_t cache_hash(const char *STRING, uint64_t hash) {
+    for (const char *chr = STRING; *chr; chr++) {
+        hash = (hash ^ (unsigned char)*chr) * CACHE_HASH_PRIME;
+    }
+
+    return (hash ^ 0xff) * CACHE_HASH_PRIME; // Terminate, so "ab" + "c" differs from "a" + "bc"
+}
+
+/**
+ * Hashes the printed form of an LLVM value or type.
+ *
+ * @param printed The printed form, which is disposed of.
+ * @param hash    The previous hash.
+ *
+ * @return The hash.
+ */
+uint64_t cache_hashMessage_(char *printed, uint64_t hash) {
+    hash = cache_hash(printed, hash);
+
+    LLVMDisposeMessage(printed);
+
+    return hash;
+}
+
+/**
+ * Gets the signature of a symbol a function depends on. For functions this
+ * is their type and linkage, as their bodies are compiled separately. For
+ * global variables it also includes constant initializers, since those can
+ * be folded into the code using them.
+ *
+ * @param symbol The function or global variable.
+ *
+ * @return The hash of the signature.
+ */
+uint64_t cache_getSignature(LLVMValueRef symbol) {
+    uint64_t hash = cache_hash(LLVMGetValueName(symbol), CACHE_HASH_OFFSET);
+
+    hash = cache_hashMessage_(LLVMPrintTypeToString(LLVMGlobalGetValueType(symbol)), hash);
+    hash = (hash ^ (uint64_t)LLVMGetLinkage(symbol)) * CACHE_HASH_PRIME;
+
+    if (LLVMIsAGlobalVariable(symbol) && LLVMIsGlobalConstant(symbol) && LLVMGetInitializer(symbol)) {
+        hash = cache_hashMessage_(LLVMPrintValueToString(LLVMGetInitializer(symbol)), hash);
+    }
+
+    return hash;
+}
+
+/**
+ * Hashes the attributes of a function, which its printed form only names
+ * by the number of their group, like those marking functions in call
+ * cycles, which change with the bodies of other functions.
+ *
+ * @param function The function.
+ * @param hash     The previous hash.
+ *
+ * @return The hash.
+ */
+uint64_t cache_hashAttributes_(LLVMValueRef function, uint64_t hash) {
+    unsigned length = LLVMGetAttributeCountAtIndex(function, LLVMAttributeFunctionIndex);
+    LLVMAttributeRef *attributes = NULL;
+
+    if (!length) {
+        return hash;
+    } else if (!(attributes = malloc(length * sizeof(LLVMAttributeRef)))) {
+        panic("failed to malloc function attributes");
+    }
+
+    LLVMGetAttributesAtIndex(function, LLVMAttributeFunctionIndex, attributes);
+
+    for (unsigned index = 0; index < length; index++) {
+        if (LLVMIsStringAttribute(attributes[index])) {
+            unsigned kindLength = 0, valueLength = 0;
+            char *kind = strndup(LLVMGetStringAttributeKind(attributes[index], &kindLength), kindLength),
+                 *value = strndup(LLVMGetStringAttributeValue(attributes[index], &valueLength), valueLength);
+
+            hash = cache_hash(value, cache_hash(kind, hash));
+
+            free(kind);
+            free(value);
+        } else {
+            hash = (hash ^ LLVMGetEnumAttributeKind(attributes[index])) * CACHE_HASH_PRIME;
+            hash = (hash ^ LLVMGetEnumAttributeValue(attributes[index])) * CACHE_HASH_PRIME;
+        }
+    }
+
+    free(attributes);
+
+    return hash;
+}
+
+bool cache_fingerprint_match_(const void *element, const void *match) { return strcmp(element, match) == 0; }
+
+/**
+ * Adds the functions and global variables an operand reaches to a
+ * CacheEntry struct, looking through constant expressions like the
+ * 'getelementptr' string literals are used through.
+ *
+ * @param entry   The CacheEntry struct.
+ * @param operand The operand.
+ */
+void cache_addDependencies_(struct CacheEntry *entry, LLVMValueRef operand) {
+    if (!operand) {
+        return;
+    }
+
+    if (LLVMIsAFunction(operand) || LLVMIsAGlobalVariable(operand)) {
+        entry->fingerprint = (entry->fingerprint ^ cache_getSignature(operand)) * CACHE_HASH_PRIME;
+
+        if (!array_find(entry->dependencies, &cache_fingerprint_match_, LLVMGetValueName(operand))) {
+            array_insert(entry->dependencies, entry->dependencies->length, strdup(LLVMGetValueName(operand)));
+        }
+    } else if (LLVMIsAConstantExpr(operand) || LLVMIsAConstantArray(operand) || LLVMIsAConstantStruct(operand) ||
+               LLVMIsAConstantVector(operand)) {
+        for (int index = 0; index < LLVMGetNumOperands(operand); index++) {
+            cache_addDependencies_(entry, LLVMGetOperand(operand, (unsigned)index));
+        }
+    }
+}
+
+/**
+ * Fingerprints a function, hashing its body and attributes along with the
+ * signatures of the functions and global variables it depends on, directly
+ * or through constant expressions.
+ *
+ * @param self     The current Cache struct.
+ * @param function The function.
+ *
+ * @return The CacheEntry struct for the function.
+ */
+struct CacheEntry *cache_fingerprint(struct Cache *self, LLVMValueRef function) {
+    struct CacheEntry *entry =
+        cacheEntry_new(strdup(LLVMGetValueName(function)), cache_hashMessage_(LLVMPrintValueToString(function),
+                                                                                self->salt));
+
+    entry->fingerprint = cache_hashAttributes_(function, entry->fingerprint);
+
+    for (LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function); block; block = LLVMGetNextBasicBlock(block)) {
+        for (LLVMValueRef instruction = LLVMGetFirstInstruction(block); instruction;
+             instruction = LLVMGetNextInstruction(instruction)) {
+            for (int index = 0; index < LLVMGetNumOperands(instruction); index++) {
+                cache_addDependencies_(entry, LLVMGetOperand(instruction, (unsigned)index));
+            }
+        }
+    }
+
+    return entry;
+}
+
+/**
+ * Fingerprints the global variables of a module, which are all compiled
+ * into one object file.
+ *
+ * @param self   The current Cache struct.
+ * @param module The module.
+ *
+ * @return The CacheEntry struct for the global variables.
+ */
+struct CacheEntry *cache_fingerprintGlobals(struct Cache *self, LLVMModuleRef module) {
+    uint64_t fingerprint = self->salt;
+
+    for (LLVMValueRef global = LLVMGetFirstGlobal(module); global; global = LLVMGetNextGlobal(global)) {
+        fingerprint = cache_hashMessage_(LLVMPrintValueToString(global), fingerprint);
+    }
+
+    return cacheEntry_new(strdup(CACHE_GLOBALS_NAME), fingerprint);
+}
+
+/**
+ * Loads the dependency graph of the last build.
+ *
+ * @param self The current Cache struct.
+ */
+void cache_load(struct Cache *self) {
+    char *line = NULL;
+    size_t capacity = 0;
+    FILE *filePointer = fopen(stringConcatenate(2, self->DIRECTORY, "/graph"), "r");
+    struct CacheEntry *entry = NULL;
+
+    if (!filePointer) { // First build
+        return;
+    }
+
+    while (getline(&line, &capacity, filePointer) != -1) { // Functions with many dependencies have long lines
+        char *name = strtok(line, " \n"), *fingerprint = strtok(NULL, " \n"), *dependency = NULL;
+
+        if (!name || !fingerprint) {
+            continue;
+        }
+
+        entry = cacheEntry_new(strdup(name), strtoull(fingerprint, NULL, 16));
+
+        while ((dependency = strtok(NULL, " \n"))) {
+            array_insert(entry->dependencies, entry->dependencies->length, strdup(dependency));
+        }
+
+        array_insert(self->previousEntries, self->previousEntries->length, entry);
+    }
+
+    free(line);
+    fclose(filePointer);
+}
+
+/**
+ * Creates a new Cache struct, loading the last build's dependency graph.
+ * Every fingerprint starts from a salt, hashing the build of exeme along
+ * with the settings given, so changing either recompiles everything.
+ *
+ * @param DIRECTORY The directory to persist the cache in.
+ * @param SETTINGS  What else changes the generated code, like the target
+ * and the flags given.
+ *
+ * @return The created Cache struct.
+ */
+struct Cache *cache_new(const char *DIRECTORY, const char *SETTINGS) {
+    struct Cache *self = malloc(CACHE_STRUCT_SIZE);
+
+    if (!self) {
+        panic("failed to malloc Cache struct");
+    }
+
+    cache_makeDirectory_(DIRECTORY); // Fails if it already exists, which is fine
+
+    self->DIRECTORY = DIRECTORY;
+    self->entries = array_new();
+    self->previousEntries = array_new();
+    self->salt = cache_hash(SETTINGS, cache_hash(CACHE_VERSION, CACHE_HASH_OFFSET));
+
+    cache_load(self);
+
+    return self;
+}
+
+/**
+ * Frees a Cache struct.
+ *
+ * @param self The current Cache struct.
+ */
+void cache_free(struct Cache **self) {
+    struct CacheEntry *entry = NULL;
+
+    if (self && *self) {
+        for (size_t index = 0; index < (*self)->entries->length; index++) {
+            entry = (struct CacheEntry *)array_get((*self)->entries, index);
+            cacheEntry_free(&entry);
+        }
+
+        for (size_t index = 0; index < (*self)->previousEntries->length; index++) {
+            entry = (struct CacheEntry *)array_get((*self)->previousEntries, index);
+            cacheEntry_free(&entry);
+        }
+
+        array_free(&(*self)->entries);
+        array_free(&(*self)->previousEntries);
+
+        free(*self);
+        *self = NULL;
+    } else {
+        panic("Cache struct has already been freed");
+    }
+}
+
+/**
+ * Gets the path of the object file generated for a fingerprint.
+ *
+ * @param self        The current Cache struct.
+ * @param fingerprint The fingerprint.
+ *
+ * @return The path of the object file.
+ */
+char *cache_getObjectPath(struct Cache *self, uint64_t fingerprint) {
+    char name[21];
+
+    snprintf(name, sizeof(name), "%016" PRIx64 ".o", fingerprint);
+
+    return stringConcatenate(3, self->DIRECTORY, "/", name);
+}
+
+/**
+ * Gets whether object code has already been generated for a fingerprint.
+ *
+ * @param self        The current Cache struct.
+ * @param fingerprint The fingerprint.
+ *
+ * @return Whether the object file exists.
+ */
+bool cache_has(struct Cache *self, uint64_t fingerprint) {
+    FILE *filePointer = fopen(cache_getObjectPath(self, fingerprint), "rb");
+
+    if (filePointer) {
+        fclose(filePointer);
+    }
+
+    return filePointer != NULL;
+}
+
+/**
+ * Gets whether a function has changed since the last build.
+ *
+ * @param self  The current Cache struct.
+ * @param ENTRY The function's CacheEntry struct.
+ *
+ * @return Whether the function is new or its fingerprint has changed.
+ */
+bool cache_hasChanged(struct Cache *self, const struct CacheEntry *ENTRY) {
+    for (size_t index = 0; index < self->previousEntries->length; index++) {
+        const struct CacheEntry *PREVIOUS = array_get(self->previousEntries, index);
+
+        if (strcmp(PREVIOUS->name, ENTRY->name) == 0) {
+            return PREVIOUS->fingerprint != ENTRY->fingerprint;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Saves the dependency graph of this build, and removes object files which
+ * are no longer used by it.
+ *
+ * @param self The current Cache struct.
+ */
+void cache_save(struct Cache *self) {
+    FILE *filePointer = fopen(stringConcatenate(2, self->DIRECTORY, "/graph"), "w");
+
+    if (!filePointer) {
+        panic(stringConcatenate(3, "failed to save incremental compilation cache in '", self->DIRECTORY, "'"));
+    }
+
+    for (size_t index = 0; index < self->entries->length; index++) {
+        const struct CacheEntry *ENTRY = array_get(self->entries, index);
+
+        fprintf(filePointer, "%s %016" PRIx64, ENTRY->name, ENTRY->fingerprint);
+
+        for (size_t dependency = 0; dependency < ENTRY->dependencies->length; dependency++) {
+            fprintf(filePointer, " %s", (const char *)array_get(ENTRY->dependencies, dependency));
+        }
+
+        fprintf(filePointer, "\n");
+    }
+
+    fclose(filePointer);
+
+    for (size_t index = 0; index < self->previousEntries->length; index++) {
+        const struct CacheEntry *PREVIOUS = array_get(self->previousEntries, index);
+        bool used = false;
+
+        for (size_t other = 0; other < self->entries->length && !used; other++) {
+            used = ((const struct CacheEntry *)array_get(self->entries, other))->fingerprint == PREVIOUS->fingerprint;
+        }
+
+        if (!used) {
+            remove(cache_getObjectPath(self, PREVIOUS->fingerprint));
+        }
+    }
+}
@@ -0,0 +1,740 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+#pragma once
+
+#include "../includes.c"
+
+#include <inttypes.h>
+#include <threads.h>
+
+#include <llvm-c/BitReader.h>
+#include <llvm-c/BitWriter.h>
+#include <llvm-c/Core.h>
+#include <llvm-c/IRReader.h>
+#include <llvm-c/Linker.h>
+#include <llvm-c/Target.h>
+#include <llvm-c/TargetMachine.h>
+#include <llvm-c/Transforms/IPO.h>
+#include <llvm-c/Transforms/PassManagerBuilder.h>
+
+#include "../utils/conversions.c"
+#include "../utils/panic.c"
+#include "../utils/string.c"
+#include "./align.c"
+#include "./cache.c"
+#include "./coroutine.c"
+#include "./devirtualize.c"
+#include "./divisor.c"
+#include "./escape.c"
+#include "./evaluator.c"
+#include "./inliner.c"
+#include "./loop.c"
+#include "./monomorphizer.c"
+#include "./profile.c"
+#include "./range.c"
+#include "./split.c"
+#include "./vector.c"
+
+/**
+ * Represents a code generator, which emits a module as a native executable.
+ */
+struct Codegen {
+    bool cacheReport, checkReport, inlineReport, instanceReport, lto, profileGenerate;
+    struct Cache *cache;
+    struct Monomorphizer *monomorphizer;
+    struct Profile *profile;
+    LLVMContextRef context;
+    LLVMModuleRef module;
+    size_t units;
+};
+
+#define CODEGEN_STRUCT_SIZE sizeof(struct Codegen)
+
+#define CODEGEN_OPT_LEVEL 2 // Of each codegen unit, see 'codegen_emitUnit_'
+
+static const char *CODEGEN_ENTRY_PREFIXES[] = {"async_SEP_", "io_SEP_", "scheduler_SEP_"}; // Runtime packages whose
+                                                                                          // public functions are kept
+
+#define CODEGEN_ENTRY_PREFIXES_LENGTH (sizeof(CODEGEN_ENTRY_PREFIXES) / sizeof(const char *))
+
+/**
+ * Represents a codegen unit, a part of the module which is optimised and
+ * emitted on its own thread.
+ */
+struct CodegenUnit {
+    char *error, *report; // Checks removed, if they are reported
+    const char *OBJECT_PATH;
+    LLVMMemoryBufferRef bitcode;
+};
+
+/**
+ * Represents a function's size, used to partition functions into units.
+ */
+struct CodegenFunctionSize {
+    size_t index, size;
+};
+
+/* Forward declarations to silence warnings */
+char *codegen_describeSettings_(struct Codegen *self);
+
+/**
+ * Creates a new Codegen struct.
+ *
+ * @param units           The number of codegen units to split the module
+ * into, or the number of threads to use when compiling incrementally.
+ * @param CACHE_DIRECTORY The directory to keep the incremental compilation
+ * cache in, or NULL to compile the whole module every time.
+ * @param lto             Whether to optimise the whole program before it is
+ * split into codegen units.
+ * @param profileGenerate Whether to instrument the program to write a
+ * profile when it is run.
+ * @param PROFILE_PATH    The path of a profile to optimise the program
+ * with, or NULL to not use one.
+ * @param inlineReport    Whether to print the inliner's decisions.
+ * @param checkReport     Whether to print how many safety checks were
+ * removed from each function.
+ * @param instanceReport  Whether to print how many instances of generics
+ * were made, shared and merged.
+ * @param cacheReport     Whether to print how many functions an incremental
+ * build recompiled.
+ *
+ * @return The created Codegen struct.
+ */
+struct Codegen *codegen_new(size_t units, const char *CACHE_DIRECTORY, bool lto, bool profileGenerate,
+                            const char *PROFILE_PATH, bool inlineReport, bool checkReport,
+                            bool instanceReport, bool cacheReport) {
+    struct Codegen *self = malloc(CODEGEN_STRUCT_SIZE);
+
+    if (!self) {
+        panic("failed to malloc Codegen struct");
+    }
+
+    if (CACHE_DIRECTORY && lto) {
+        panic("incremental compilation cannot be used with link-time optimisation");
+    } else if (profileGenerate && PROFILE_PATH) {
+        panic("a profile cannot be generated and used at the same time");
+    }
+
+    LLVMInitializeNativeTarget();
+    LLVMInitializeNativeAsmPrinter();
+    LLVMInitializeNativeAsmParser(); // For the scheduler runtime's inline assembly
+
+    self->cacheReport = cacheReport;
+    self->checkReport = checkReport;
+    self->inlineReport = inlineReport;
+    self->instanceReport = instanceReport;
+    self->lto = lto;
+    self->profileGenerate = profileGenerate;
+    self->profile = PROFILE_PATH ? profile_new(PROFILE_PATH) : NULL;
+    self->cache = CACHE_DIRECTORY ? cache_new(CACHE_DIRECTORY, codegen_describeSettings_(self)) : NULL;
+    self->monomorphizer = monomorphizer_new();
+    self->context = LLVMContextCreate();
+    self->module = NULL;
+    self->units = units;
+
+    return self;
+}
+
+/**
+ * Frees a Codegen struct.
+ *
+ * @param self The current Codegen struct.
+ */
+void codegen_free(struct Codegen **self) {
+    if (self && *self) {
+        if ((*self)->cache) {
+            cache_free(&(*self)->cache);
+        }
+
+        if ((*self)->profile) {
+            profile_free(&(*self)->profile);
+        }
+
+        monomorphizer_free(&(*self)->monomorphizer);
+
+        if ((*self)->module) {
+            LLVMDisposeModule((*self)->module);
+        }
+
+        LLVMContextDispose((*self)->context);
+
+        free(*self);
+        *self = NULL;
+    } else {
+        panic("Codegen struct has already been freed");
+    }
+}
+
+/**
+ * Parses an LLVM IR or bitcode file and links it into the module.
+ *
+ * @param self      The current Codegen struct.
+ * @param FILE_PATH The path of the LLVM IR or bitcode file.
+ */
+void codegen_addFile(struct Codegen *self, const char *FILE_PATH) {
+    char *message = NULL;
+    LLVMMemoryBufferRef buffer = NULL;
+    LLVMModuleRef module = NULL;
+
+    if (LLVMCreateMemoryBufferWithContentsOfFile(FILE_PATH, &buffer, &message)) {
+        panic(stringConcatenate(4, "failed to open file '", FILE_PATH, "': ", message));
+    }
+
+    if (LLVMParseIRInContext(self->context, buffer, &module, &message)) {
+        panic(stringConcatenate(4, "failed to parse LLVM IR in file '", FILE_PATH, "': ", message));
+    }
+
+    monomorphizer_share(self->monomorphizer, module); // Before linking, so instances made by both are kept once
+
+    if (!self->module) {
+        self->module = module;
+    } else if (LLVMLinkModules2(self->module, module)) {
+        panic(stringConcatenate(3, "failed to link file '", FILE_PATH, "'"));
+    }
+}
+
+/**
+ * Creates a target machine for the host.
+ *
+ * @return The created target machine.
+ */
+LLVMTargetMachineRef codegen_createTargetMachine(void) {
+    char *message = NULL, *triple = LLVMGetDefaultTargetTriple();
+    LLVMTargetRef target = NULL;
+    LLVMTargetMachineRef targetMachine = NULL;
+
+    if (LLVMGetTargetFromTriple(triple, &target, &message)) {
+        panic(stringConcatenate(2, "failed to get target: ", message));
+    }
+
+    targetMachine = LLVMCreateTargetMachine(target, triple, "generic", "", LLVMCodeGenLevelDefault, LLVMRelocPIC,
+                                            LLVMCodeModelDefault);
+
+    LLVMDisposeMessage(triple);
+
+    return targetMachine;
+}
+
+/**
+ * Describes what changes the code generated for the module besides the
+ * module itself, which salts the incremental compilation cache: the target,
+ * the optimisation level, and the flags which change code generation.
+ *
+ * @param self The current Codegen struct, with its profile loaded.
+ *
+ * @return The description.
+ */
+char *codegen_describeSettings_(struct Codegen *self) {
+    LLVMTargetMachineRef targetMachine = codegen_createTargetMachine();
+    LLVMTargetDataRef dataLayout = LLVMCreateTargetDataLayout(targetMachine);
+    char *triple = LLVMGetTargetMachineTriple(targetMachine), *layout = LLVMCopyStringRepOfTargetData(dataLayout);
+    char flags[128], *settings = NULL;
+
+    snprintf(flags, sizeof(flags), " -O%d%s%s --profile-use=%016" PRIx64, CODEGEN_OPT_LEVEL,
+             self->checkReport ? " --check-report" : "", self->profileGenerate ? " --profile-generate" : "",
+             self->profile ? profile_fingerprint(self->profile, CACHE_HASH_OFFSET) : 0);
+    settings = stringConcatenate(4, triple, " ", layout, flags);
+
+    LLVMDisposeMessage(triple);
+    LLVMDisposeMessage(layout);
+    LLVMDisposeTargetData(dataLayout);
+    LLVMDisposeTargetMachine(targetMachine);
+
+    return settings;
+}
+
+int codegen_compareFunctionSizes_(const void *a, const void *b) {
+    const struct CodegenFunctionSize *A = a, *B = b;
+
+    if (A->size != B->size) {
+        return A->size > B->size ? -1 : 1; // Largest first
+    }
+
+    return A->index < B->index ? -1 : 1; // Then in module order, so sorting is stable
+}
+
+/**
+ * Partitions the module's functions into codegen units. Functions are
+ * placed largest first into the least loaded unit, so the partitioning only
+ * depends on the module and the number of units, and the output is identical
+ * between builds.
+ *
+ * @param self            The current Codegen struct.
+ * @param functionsLength Set to the number of functions in the module.
+ *
+ * @return The unit of each function, indexed by its position in the module.
+ */
+size_t *codegen_partition(struct Codegen *self, size_t *functionsLength) {
+    size_t index = 0, *loads = calloc(self->units, sizeof(size_t)), *partition = NULL;
+    struct CodegenFunctionSize *sizes = NULL;
+
+    *functionsLength = 0;
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(self->module); function; function = LLVMGetNextFunction(function)) {
+        (*functionsLength)++;
+    }
+
+    partition = calloc(*functionsLength ? *functionsLength : 1, sizeof(size_t));
+    sizes = calloc(*functionsLength ? *functionsLength : 1, sizeof(struct CodegenFunctionSize));
+
+    if (!loads || !partition || !sizes) {
+        panic("failed to calloc codegen partition");
+    }
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(self->module); function;
+         function = LLVMGetNextFunction(function), index++) {
+        sizes[index].index = index;
+
+        for (LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function); block; block = LLVMGetNextBasicBlock(block)) {
+            for (LLVMValueRef instruction = LLVMGetFirstInstruction(block); instruction;
+                 instruction = LLVMGetNextInstruction(instruction)) {
+                sizes[index].size++;
+            }
+        }
+    }
+
+    qsort(sizes, *functionsLength, sizeof(struct CodegenFunctionSize), codegen_compareFunctionSizes_);
+
+    for (index = 0; index < *functionsLength; index++) {
+        size_t unit = 0;
+
+        for (size_t other = 1; other < self->units; other++) {
+            if (loads[other] < loads[unit]) {
+                unit = other;
+            }
+        }
+
+        partition[sizes[index].index] = unit;
+        loads[unit] += sizes[index].size + 1;
+    }
+
+    free(loads);
+    free(sizes);
+
+    return partition;
+}
+
+/**
+ * Optimises and emits a codegen unit to an object file. Runs on its own
+ * thread, so it uses its own context and target machine.
+ *
+ * @param data The CodegenUnit struct.
+ *
+ * @return 0 on success, else 1 with the unit's error set.
+ */
+int codegen_emitUnit_(void *data) {
+    struct CodegenUnit *unit = data;
+    LLVMContextRef context = LLVMContextCreate();
+    LLVMModuleRef module = NULL;
+    LLVMPassManagerBuilderRef passManagerBuilder = LLVMPassManagerBuilderCreate();
+    LLVMPassManagerRef passManager = LLVMCreatePassManager();
+    LLVMTargetMachineRef targetMachine = codegen_createTargetMachine();
+    LLVMTargetDataRef dataLayout = LLVMCreateTargetDataLayout(targetMachine);
+    char *triple = LLVMGetTargetMachineTriple(targetMachine);
+    int result = 0;
+    bool changed = false;
+
+    if (LLVMParseBitcodeInContext2(context, unit->bitcode, &module)) {
+        unit->error = "failed to parse codegen unit bitcode";
+        result = 1;
+    } else {
+        LLVMSetTarget(module, triple);
+        LLVMSetModuleDataLayout(module, dataLayout);
+
+        LLVMAddAnalysisPasses(targetMachine, passManager);
+        coroutine_addPasses(module, passManager, passManagerBuilder);
+        LLVMPassManagerBuilderSetOptLevel(passManagerBuilder, CODEGEN_OPT_LEVEL);
+        LLVMPassManagerBuilderPopulateModulePassManager(passManagerBuilder, passManager);
+        LLVMRunPassManager(passManager, module);
+
+        // After optimising, so inlining and inferred attributes show more objects don't escape and loops are in their
+        // final shape, then again to break up the objects moved onto the stack and vectorise loops without checks
+        changed = escape_promote(module);
+        changed = range_removeChecks(module, unit->report ? &unit->report : NULL) || changed;
+
+        if (changed) {
+            LLVMRunPassManager(passManager, module);
+        }
+
+        divisor_reduce(module); // Last, as it needs loops in their final shape to see which divisors don't change
+
+        if (LLVMTargetMachineEmitToFile(targetMachine, module, (char *)unit->OBJECT_PATH, LLVMObjectFile,
+                                        &unit->error)) {
+            result = 1;
+        }
+
+        LLVMDisposeModule(module);
+    }
+
+    LLVMDisposeMessage(triple);
+    LLVMDisposeTargetData(dataLayout);
+    LLVMDisposeTargetMachine(targetMachine);
+    LLVMDisposePassManager(passManager);
+    LLVMPassManagerBuilderDispose(passManagerBuilder);
+    LLVMContextDispose(context);
+
+    return result;
+}
+
+/**
+ * Extracts a codegen unit from the module.
+ *
+ * @param self          The current Codegen struct.
+ * @param PARTITION     The unit of each function, by its position in the module.
+ * @param unit          The unit to extract.
+ * @param defineGlobals Whether the unit defines the global variables.
+ *
+ * @return The unit as bitcode.
+ */
+LLVMMemoryBufferRef codegen_extractUnit_(struct Codegen *self, const size_t *PARTITION, size_t unit, bool defineGlobals) {
+    LLVMMemoryBufferRef bitcode = NULL;
+    LLVMModuleRef module = LLVMCloneModule(self->module);
+    size_t functionIndex = 0;
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function;
+         function = LLVMGetNextFunction(function), functionIndex++) {
+        if (PARTITION[functionIndex] != unit) {
+            split_removeBody(function);
+        }
+    }
+
+    if (!defineGlobals) {
+        split_declareGlobals(module);
+    }
+
+    bitcode = LLVMWriteBitcodeToMemoryBuffer(module);
+
+    LLVMDisposeModule(module);
+
+    return bitcode;
+}
+
+/**
+ * Optimises and emits codegen units, running at most as many threads at once
+ * as there are codegen units configured.
+ *
+ * @param self        The current Codegen struct.
+ * @param units       The units to emit.
+ * @param unitsLength The number of units.
+ */
+void codegen_emitUnits_(struct Codegen *self, struct CodegenUnit *units, size_t unitsLength) {
+    thrd_t *threads = calloc(self->units, sizeof(thrd_t));
+
+    if (!threads) {
+        panic("failed to calloc codegen threads");
+    }
+
+    for (size_t start = 0; start < unitsLength; start += self->units) {
+        size_t end = start + self->units < unitsLength ? start + self->units : unitsLength;
+
+        for (size_t index = start; index < end; index++) {
+            if (thrd_create(&threads[index - start], codegen_emitUnit_, &units[index]) != thrd_success) {
+                panic("failed to create codegen thread");
+            }
+        }
+
+        for (size_t index = start; index < end; index++) {
+            int result = 0;
+
+            thrd_join(threads[index - start], &result);
+            LLVMDisposeMemoryBuffer(units[index].bitcode);
+
+            if (result != 0) {
+                panic(stringConcatenate(4, "failed to emit '", units[index].OBJECT_PATH, "': ", units[index].error));
+            } else if (units[index].report) { // Printed in order, rather than as each thread finishes
+                printf("%s", units[index].report);
+            }
+        }
+    }
+
+    free(threads);
+}
+
+/**
+ * Links object files into a native executable.
+ *
+ * @param OUTPUT_PATH       The path of the executable.
+ * @param objectPaths       The paths of the object files.
+ * @param objectPathsLength The number of object files.
+ */
+void codegen_link_(const char *OUTPUT_PATH, const char **objectPaths, size_t objectPathsLength) {
+    char *linkCommand = stringConcatenate(3, "cc -o \"", OUTPUT_PATH, "\"");
+
+    for (size_t index = 0; index < objectPathsLength; index++) {
+        linkCommand = stringConcatenate(4, linkCommand, " \"", objectPaths[index], "\"");
+    }
+
+    linkCommand = stringConcatenate(2, linkCommand, " -lm"); // After the objects, for 'llvm.pow' and others calling libm
+
+    if (system(linkCommand) != 0) {
+        panic(stringConcatenate(3, "failed to link '", OUTPUT_PATH, "'"));
+    }
+}
+
+/**
+ * Emits the module as a native executable, only recompiling the functions
+ * which have changed since the last build. Each function is compiled into
+ * its own object file, named after its fingerprint, so a function is reused
+ * unless its body or the signature of something it depends on changes.
+ *
+ * @param self        The current Codegen struct.
+ * @param OUTPUT_PATH The path of the executable.
+ */
+void codegen_emitIncremental_(struct Codegen *self, const char *OUTPUT_PATH) {
+    size_t changed = 0, functionIndex = 0, functionsLength = 0, objectPathsLength = 0, unitsLength = 0,
+           *partition = NULL;
+    const char **objectPaths = NULL;
+    struct CacheEntry *entry = NULL;
+    struct CodegenUnit *units = NULL;
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(self->module); function; function = LLVMGetNextFunction(function)) {
+        functionsLength++;
+    }
+
+    partition = calloc(functionsLength + 1, sizeof(size_t));
+    objectPaths = calloc(functionsLength + 1, sizeof(char *));
+    units = calloc(functionsLength + 1, sizeof(struct CodegenUnit));
+
+    if (!partition || !objectPaths || !units) {
+        panic("failed to calloc codegen units");
+    }
+
+    for (size_t index = 0; index < functionsLength; index++) {
+        partition[index] = negativeULL; // Declarations, which are not in any unit
+    }
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(self->module); function;
+         function = LLVMGetNextFunction(function), functionIndex++) {
+        if (!split_isDefined(function)) {
+            continue;
+        }
+
+        partition[functionIndex] = objectPathsLength;
+        entry = cache_fingerprint(self->cache, function);
+        array_insert(self->cache->entries, self->cache->entries->length, entry);
+        objectPaths[objectPathsLength] = cache_getObjectPath(self->cache, entry->fingerprint);
+
+        if (cache_hasChanged(self->cache, entry)) {
+            changed++;
+        }
+
+        if (!cache_has(self->cache, entry->fingerprint)) {
+            units[unitsLength].OBJECT_PATH = objectPaths[objectPathsLength];
+            units[unitsLength].report = self->checkReport ? "" : NULL;
+            units[unitsLength++].bitcode = codegen_extractUnit_(self, partition, objectPathsLength, false);
+        }
+
+        objectPathsLength++;
+    }
+
+    entry = cache_fingerprintGlobals(self->cache, self->module);
+    array_insert(self->cache->entries, self->cache->entries->length, entry);
+    objectPaths[objectPathsLength++] = cache_getObjectPath(self->cache, entry->fingerprint);
+
+    if (!cache_has(self->cache, entry->fingerprint)) {
+        units[unitsLength].OBJECT_PATH = objectPaths[objectPathsLength - 1];
+        units[unitsLength].report = self->checkReport ? "" : NULL;
+        units[unitsLength++].bitcode = codegen_extractUnit_(self, partition, negativeULL, true);
+    }
+
+    codegen_emitUnits_(self, units, unitsLength);
+    codegen_link_(OUTPUT_PATH, objectPaths, objectPathsLength);
+    cache_save(self->cache);
+
+    if (self->cacheReport) {
+        printf("%zu of %zu functions changed, compiled %zu object files\n", changed, objectPathsLength - 1, unitsLength);
+    }
+
+    free(partition);
+    free(objectPaths);
+    free(units);
+}
+
+/**
+ * Gets whether a value is passed to a function outside the module, like
+ * 'pthread_create' or 'atexit', directly or through a constant expression,
+ * so is called back from C.
+ *
+ * @param value The value.
+ *
+ * @return Whether the value is called back from C.
+ */
+bool codegen_isCallback_(LLVMValueRef value) {
+    for (LLVMUseRef use = LLVMGetFirstUse(value); use; use = LLVMGetNextUse(use)) {
+        LLVMValueRef user = LLVMGetUser(use), callee = LLVMIsACallInst(user) ? LLVMGetCalledValue(user) : NULL;
+
+        if (callee && callee != value && LLVMIsAFunction(callee) && LLVMIsDeclaration(callee) &&
+            strncmp(LLVMGetValueName(callee), "llvm.", 5) != 0) {
+            return true;
+        } else if (LLVMIsAConstantExpr(user) && codegen_isCallback_(user)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Gets whether the whole program optimisation must keep a symbol external,
+ * as it is reached from outside the program's own code. Those are 'main',
+ * symbols exported with 'dllexport', functions called back from C, and the
+ * public functions of the runtime packages.
+ *
+ * @param symbol The symbol.
+ * @param data   Unused.
+ *
+ * @return Whether the symbol must be kept external.
+ */
+LLVMBool codegen_mustPreserve_(LLVMValueRef symbol, void *data) {
+    const char *NAME = LLVMGetValueName(symbol);
+
+    (void)data;
+
+    if (strcmp(NAME, "main") == 0 || LLVMGetDLLStorageClass(symbol) == LLVMDLLExportStorageClass ||
+        codegen_isCallback_(symbol)) {
+        return true;
+    }
+
+    for (size_t index = 0; index < CODEGEN_ENTRY_PREFIXES_LENGTH; index++) {
+        size_t length = strlen(CODEGEN_ENTRY_PREFIXES[index]);
+
+        if (strncmp(NAME, CODEGEN_ENTRY_PREFIXES[index], length) == 0 && NAME[length] != '_') { // Not private
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Optimises the whole program at once, after every package has been linked
+ * into the module. Everything but the symbols codegen_mustPreserve_ keeps is
+ * internalised, so functions can be inlined across package boundaries and
+ * those left unused are removed. This is full LTO of one module, not
+ * ThinLTO, so it runs on one thread before the module is split.
+ *
+ * @param self The current Codegen struct.
+ */
+void codegen_optimiseWholeProgram_(struct Codegen *self) {
+    LLVMPassManagerBuilderRef passManagerBuilder = LLVMPassManagerBuilderCreate();
+    LLVMPassManagerRef passManager = LLVMCreatePassManager();
+    LLVMTargetMachineRef targetMachine = codegen_createTargetMachine();
+    LLVMTargetDataRef dataLayout = LLVMCreateTargetDataLayout(targetMachine);
+    char *triple = LLVMGetTargetMachineTriple(targetMachine);
+
+    LLVMSetTarget(self->module, triple);
+    LLVMSetModuleDataLayout(self->module, dataLayout);
+
+    LLVMAddAnalysisPasses(targetMachine, passManager);
+    LLVMAddInternalizePassWithMustPreservePredicate(passManager, NULL, &codegen_mustPreserve_);
+    coroutine_addPasses(self->module, passManager, passManagerBuilder); // Split here, so they are inlined across packages
+    LLVMPassManagerBuilderSetOptLevel(passManagerBuilder, 3);
+    LLVMPassManagerBuilderPopulateLTOPassManager(passManagerBuilder, passManager, false, true); // Inlining and global
+                                                                                                // DCE
+    LLVMRunPassManager(passManager, self->module);
+
+    LLVMDisposeMessage(triple);
+    LLVMDisposeTargetData(dataLayout);
+    LLVMDisposeTargetMachine(targetMachine);
+    LLVMDisposePassManager(passManager);
+    LLVMPassManagerBuilderDispose(passManagerBuilder);
+}
+
+/**
+ * Emits the module as a native executable. The module is split into
+ * codegen units which are optimised and emitted in parallel, and the
+ * resulting objects are linked together. If the output path ends in '.bc',
+ * the module is instead written as bitcode, to be linked into a program
+ * later.
+ *
+ * @param self        The current Codegen struct.
+ * @param OUTPUT_PATH The path of the executable.
+ */
+void codegen_emit(struct Codegen *self, const char *OUTPUT_PATH) {
+    size_t functionsLength = 0, *partition = NULL;
+    size_t outputPathLength = strlen(OUTPUT_PATH);
+    bool package = outputPathLength > 3 && strcmp(OUTPUT_PATH + outputPathLength - 3, ".bc") == 0;
+    const char **objectPaths = calloc(self->units, sizeof(char *));
+    struct CodegenUnit *units = calloc(self->units, sizeof(struct CodegenUnit));
+    LLVMTargetMachineRef targetMachine = NULL;
+
+    if (!self->module) {
+        panic("no module to emit");
+    } else if (!objectPaths || !units) {
+        panic("failed to calloc codegen units");
+    }
+
+    targetMachine = self->instanceReport ? codegen_createTargetMachine() : NULL; // To measure the code merging saves
+    monomorphizer_merge(self->monomorphizer, self->module, targetMachine);
+
+    if (self->instanceReport) {
+        monomorphizer_report(self->monomorphizer);
+        LLVMDisposeTargetMachine(targetMachine);
+    }
+
+    align_apply(self->module); // Before inlining, so the allocas inlined into callers are aligned already
+    evaluator_evaluateConstructors(self->module);
+    evaluator_foldCalls(self->module);
+    devirtualize_calls(self->module, !package); // Before inlining, so the calls made direct can be inlined
+
+    // Before inlining, so the inliner sees how hot each function is, and at the same point in the pipeline as each
+    // other, so the functions instrumented are those the profile is matched against
+    if (self->profile) { // Packages keep the profile's metadata, for when they are linked into a program
+        profile_apply(self->profile, self->module);
+    } else if (self->profileGenerate && !package) { // Packages are instrumented once linked into a program
+        profile_instrument(self->module);
+    }
+
+    inliner_inline(self->module, self->inlineReport);
+    evaluator_foldCalls(self->module); // Inlined calls can have made more arguments constant
+
+    if (package) {
+        if (LLVMWriteBitcodeToFile(self->module, OUTPUT_PATH) != 0) {
+            panic(stringConcatenate(3, "failed to write bitcode to '", OUTPUT_PATH, "'"));
+        }
+
+        free(objectPaths);
+        free(units);
+
+        return;
+    }
+
+    if (self->lto) {
+        codegen_optimiseWholeProgram_(self);
+    }
+
+    escape_markRecursive(self->module); // Before splitting, as a unit only holds some of the bodies
+    split_externaliseLocals(self->module);
+
+    if (self->cache) {
+        codegen_emitIncremental_(self, OUTPUT_PATH);
+
+        free(objectPaths);
+        free(units);
+
+        return;
+    }
+
+    partition = codegen_partition(self, &functionsLength);
+
+    for (size_t index = 0; index < self->units; index++) {
+        objectPaths[index] = units[index].OBJECT_PATH = stringConcatenate(4, OUTPUT_PATH, ".", ulToString(index), ".o");
+        units[index].report = self->checkReport ? "" : NULL;
+        units[index].bitcode = codegen_extractUnit_(self, partition, index, index == 0); // Global variables are defined
+                                                                                         // in the first unit
+    }
+
+    codegen_emitUnits_(self, units, self->units);
+    codegen_link_(OUTPUT_PATH, objectPaths, self->units);
+
+    for (size_t index = 0; index < self->units; index++) {
+        remove(objectPaths[index]);
+    }
+
+    free(partition);
+    free(objectPaths);
+    free(units);
+}
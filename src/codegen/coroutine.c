@@ -0,0 +1,88 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+#pragma once
+
+#include "../includes.c"
+
+#include <llvm-c/Core.h>
+#include <llvm-c/Transforms/Coroutines.h>
+#include <llvm-c/Transforms/IPO.h>
+#include <llvm-c/Transforms/PassManagerBuilder.h>
+
+#define COROUTINE_PRESPLIT_ATTRIBUTE "coroutine.presplit" // Set on 'async func's until LLVM splits them
+
+/**
+ * Gets whether a function is an 'async func' that has not been split into
+ * its ramp, resume and destroy functions yet.
+ *
+ * @param function The function.
+ *
+ * @return Whether the function is a coroutine.
+ */
+bool coroutine_isCoroutine(LLVMValueRef function) {
+    return LLVMGetStringAttributeAtIndex(function, LLVMAttributeFunctionIndex, COROUTINE_PRESPLIT_ATTRIBUTE,
+                                         strlen(COROUTINE_PRESPLIT_ATTRIBUTE)) != NULL;
+}
+
+/**
+ * Lowers the intrinsics used on coroutine handles in a module, then adds
+ * the passes which lower coroutines to a pass manager, and to the pipeline
+ * a builder populates after them. The intrinsics are lowered first, in
+ * their own pass, as the last of the passes only cleans up after them if
+ * the module uses them when it starts. Calls the inliner marked to be
+ * inlined into their callers are inlined as soon as the coroutine they
+ * call is split, bottom up, so when the caller destroys the coroutine on
+ * every path its frame is allocated in the caller's rather than on the
+ * heap.
+ *
+ * @param module             The module the pass manager will run on.
+ * @param passManager        The pass manager.
+ * @param passManagerBuilder The builder populating it.
+ */
+void coroutine_addPasses(LLVMModuleRef module, LLVMPassManagerRef passManager,
+                         LLVMPassManagerBuilderRef passManagerBuilder) {
+    LLVMPassManagerRef earlyPassManager = LLVMCreatePassManager();
+
+    LLVMAddCoroEarlyPass(earlyPassManager);
+    LLVMRunPassManager(earlyPassManager, module);
+    LLVMDisposePassManager(earlyPassManager);
+
+    LLVMAddAlwaysInlinerPass(passManager); // Grouped with the passes below, so it sees each callee split first
+    LLVMAddCoroSplitPass(passManager);
+    LLVMAddCoroElidePass(passManager);
+    LLVMPassManagerBuilderAddCoroutinePassesToExtensionPoints(passManagerBuilder);
+}
+
+/**
+ * Lowers the coroutines in a module without optimising it, for the JIT.
+ *
+ * @param module The module.
+ */
+void coroutine_lower(LLVMModuleRef module) {
+    LLVMPassManagerBuilderRef passManagerBuilder = LLVMPassManagerBuilderCreate();
+    LLVMPassManagerRef functionPassManager = LLVMCreateFunctionPassManagerForModule(module);
+    LLVMPassManagerRef passManager = LLVMCreatePassManager();
+
+    LLVMPassManagerBuilderSetOptLevel(passManagerBuilder, 0);
+    LLVMPassManagerBuilderAddCoroutinePassesToExtensionPoints(passManagerBuilder);
+
+    // The function passes lower the intrinsics used on handles, then the module passes split the coroutines
+    LLVMPassManagerBuilderPopulateFunctionPassManager(passManagerBuilder, functionPassManager);
+    LLVMPassManagerBuilderPopulateModulePassManager(passManagerBuilder, passManager);
+
+    LLVMInitializeFunctionPassManager(functionPassManager);
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+        LLVMRunFunctionPassManager(functionPassManager, function);
+    }
+
+    LLVMFinalizeFunctionPassManager(functionPassManager);
+    LLVMRunPassManager(passManager, module);
+
+    LLVMDisposePassManager(functionPassManager);
+    LLVMDisposePassManager(passManager);
+    LLVMPassManagerBuilderDispose(passManagerBuilder);
+}
@@ -0,0 +1,658 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+#pragma once
+
+#include "../includes.c"
+
+#include <llvm-c/Core.h>
+#include <llvm-c/Target.h>
+
+#include "../utils/array.c"
+#include "../utils/panic.c"
+#include "../utils/string.c"
+
+#define DEVIRTUALIZE_MAX_GUARDS 2 // Most implementations tested for at a call before it falls back to the vtable
+
+/**
+ * Represents a vtable compatible with a class, from its '!type' metadata.
+ * A class's vtable is compatible with the class and each class it inherits
+ * from, so the hierarchy below a class is every vtable compatible with it.
+ */
+struct DevirtualizeVtable {
+    LLVMValueRef global, type; // The type is the class's metadata identifier
+    long long offset;          // Where the class's methods start in the global, in bytes
+};
+
+#define DEVIRTUALIZE_VTABLE_STRUCT_SIZE sizeof(struct DevirtualizeVtable)
+
+/**
+ * Represents a method's implementation, and how many classes use it.
+ */
+struct DevirtualizeTarget {
+    LLVMValueRef function;
+    size_t classes;
+};
+
+#define DEVIRTUALIZE_TARGET_STRUCT_SIZE sizeof(struct DevirtualizeTarget)
+
+/**
+ * Adds the offset of a getelementptr to an offset.
+ *
+ * @param dataLayout The data layout of the module.
+ * @param pointer    The getelementptr, an instruction or constant.
+ * @param offset     The offset.
+ *
+ * @return Whether the getelementptr has constant indices, else the offset
+ * is left as is.
+ */
+bool devirtualize_addOffset_(LLVMTargetDataRef dataLayout, LLVMValueRef pointer, long long *offset) {
+    LLVMTypeRef type = LLVMGetGEPSourceElementType(pointer);
+    long long total = 0, index = 0;
+
+    for (unsigned operand = 1; operand < (unsigned)LLVMGetNumOperands(pointer); operand++) {
+        if (!LLVMIsAConstantInt(LLVMGetOperand(pointer, operand))) {
+            return false;
+        }
+
+        index = LLVMConstIntGetSExtValue(LLVMGetOperand(pointer, operand));
+
+        if (operand == 1) { // Steps over whole elements of the source type
+            total += index * (long long)LLVMABISizeOfType(dataLayout, type);
+        } else if (LLVMGetTypeKind(type) == LLVMStructTypeKind) {
+            total += (long long)LLVMOffsetOfElement(dataLayout, type, (unsigned)index);
+            type = LLVMStructGetTypeAtIndex(type, (unsigned)index);
+        } else {
+            type = LLVMGetElementType(type);
+            total += index * (long long)LLVMABISizeOfType(dataLayout, type);
+        }
+    }
+
+    *offset += total;
+
+    return true;
+}
+
+/**
+ * Gets the pointer a pointer is derived from by casts and getelementptrs
+ * with constant indices.
+ *
+ * @param dataLayout The data layout of the module.
+ * @param pointer    The pointer.
+ * @param offset     Where to add the pointer's offset from it, in bytes.
+ *
+ * @return The pointer it is derived from.
+ */
+LLVMValueRef devirtualize_getBase_(LLVMTargetDataRef dataLayout, LLVMValueRef pointer, long long *offset) {
+    bool derived = true;
+
+    while (derived) {
+        LLVMOpcode opcode = LLVMIsAInstruction(pointer)    ? LLVMGetInstructionOpcode(pointer)
+                            : LLVMIsAConstantExpr(pointer) ? LLVMGetConstOpcode(pointer)
+                                                           : LLVMRet; // Neither, so is the base
+
+        derived = opcode == LLVMBitCast ||
+                  (opcode == LLVMGetElementPtr && devirtualize_addOffset_(dataLayout, pointer, offset));
+
+        if (derived) {
+            pointer = LLVMGetOperand(pointer, 0);
+        }
+    }
+
+    return pointer;
+}
+
+/**
+ * Gets the function at an offset in a constant, like a vtable's initializer.
+ *
+ * @param dataLayout The data layout of the module.
+ * @param constant   The constant.
+ * @param offset     The offset, in bytes.
+ *
+ * @return The function, or NULL if there is not one at the offset.
+ */
+LLVMValueRef devirtualize_getFunction_(LLVMTargetDataRef dataLayout, LLVMValueRef constant, long long offset) {
+    LLVMTypeRef type = LLVMTypeOf(constant);
+    unsigned long long size = 0;
+    unsigned index = 0;
+
+    while (LLVMIsAConstantExpr(constant) && LLVMGetConstOpcode(constant) == LLVMBitCast) {
+        constant = LLVMGetOperand(constant, 0);
+    }
+
+    if (LLVMIsAFunction(constant)) {
+        return offset == 0 ? constant : NULL;
+    } else if (offset < 0 || (unsigned long long)offset >= LLVMABISizeOfType(dataLayout, type)) {
+        return NULL;
+    } else if (LLVMIsAConstantStruct(constant)) {
+        index = LLVMElementAtOffset(dataLayout, type, (unsigned long long)offset);
+
+        return devirtualize_getFunction_(dataLayout, LLVMGetOperand(constant, index),
+                                         offset - (long long)LLVMOffsetOfElement(dataLayout, type, index));
+    } else if (LLVMIsAConstantArray(constant)) {
+        size = LLVMABISizeOfType(dataLayout, LLVMGetElementType(type));
+
+        return devirtualize_getFunction_(dataLayout, LLVMGetOperand(constant, (unsigned)((unsigned long long)offset / size)),
+                                         (long long)((unsigned long long)offset % size));
+    }
+
+    return NULL;
+}
+
+/**
+ * Collects the vtables in a module, from the '!type' metadata on constant
+ * globals.
+ *
+ * @param module  The module.
+ * @param vtables Where to collect the DevirtualizeVtable structs.
+ */
+void devirtualize_collectVtables_(LLVMModuleRef module, struct Array *vtables) {
+    LLVMContextRef context = LLVMGetModuleContext(module);
+    unsigned kind = LLVMGetMDKindIDInContext(context, "type", 4);
+
+    for (LLVMValueRef global = LLVMGetFirstGlobal(module); global; global = LLVMGetNextGlobal(global)) {
+        LLVMValueMetadataEntry *entries = NULL;
+        size_t entriesLength = 0;
+
+        if (!LLVMGetInitializer(global) || !LLVMIsGlobalConstant(global)) {
+            continue;
+        }
+
+        entries = LLVMGlobalCopyAllMetadata(global, &entriesLength);
+
+        for (unsigned index = 0; index < entriesLength; index++) {
+            LLVMValueRef node = NULL, operands[2];
+            struct DevirtualizeVtable *vtable = NULL;
+
+            if (LLVMValueMetadataEntriesGetKind(entries, index) != kind) {
+                continue;
+            }
+
+            node = LLVMMetadataAsValue(context, LLVMValueMetadataEntriesGetMetadata(entries, index));
+
+            if (LLVMGetMDNodeNumOperands(node) != 2) {
+                continue;
+            }
+
+            LLVMGetMDNodeOperands(node, operands);
+
+            if (!LLVMIsAConstantInt(operands[0])) {
+                continue;
+            }
+
+            vtable = malloc(DEVIRTUALIZE_VTABLE_STRUCT_SIZE);
+
+            if (!vtable) {
+                panic("failed to malloc DevirtualizeVtable struct");
+            }
+
+            vtable->global = global;
+            vtable->type = operands[1];
+            vtable->offset = LLVMConstIntGetSExtValue(operands[0]);
+
+            array_insert(vtables, vtables->length, vtable);
+        }
+
+        if (entries) {
+            LLVMDisposeValueMetadataEntries(entries);
+        }
+    }
+}
+
+/**
+ * Collects the loads of methods from a vtable.
+ *
+ * @param pointer The vtable, or a pointer derived from it.
+ * @param loads   Where to collect the loads.
+ */
+void devirtualize_collectLoads_(LLVMValueRef pointer, struct Array *loads) {
+    for (LLVMUseRef use = LLVMGetFirstUse(pointer); use; use = LLVMGetNextUse(use)) {
+        LLVMValueRef user = LLVMGetUser(use);
+
+        if (LLVMIsALoadInst(user)) {
+            array_insert(loads, loads->length, user);
+        } else if ((LLVMIsABitCastInst(user) || LLVMIsAGetElementPtrInst(user)) && LLVMGetOperand(user, 0) == pointer) {
+            devirtualize_collectLoads_(user, loads);
+        }
+    }
+}
+
+/**
+ * Collects the calls to a method loaded from a vtable.
+ *
+ * @param method The method, or a cast of it.
+ * @param calls  Where to collect the calls.
+ */
+void devirtualize_collectCalls_(LLVMValueRef method, struct Array *calls) {
+    for (LLVMUseRef use = LLVMGetFirstUse(method); use; use = LLVMGetNextUse(use)) {
+        LLVMValueRef user = LLVMGetUser(use);
+
+        if (LLVMIsACallInst(user) && LLVMGetCalledValue(user) == method) {
+            array_insert(calls, calls->length, user);
+        } else if (LLVMIsABitCastInst(user)) {
+            devirtualize_collectCalls_(user, calls);
+        }
+    }
+}
+
+/**
+ * Gets the vtable an object was just given, when it is loaded straight
+ * after being stored, so the object's class is known.
+ *
+ * @param dataLayout The data layout of the module.
+ * @param vtable     The vtable loaded from the object.
+ *
+ * @return The vtable stored, or NULL if it is not known.
+ */
+LLVMValueRef devirtualize_getKnownVtable_(LLVMTargetDataRef dataLayout, LLVMValueRef vtable) {
+    LLVMValueRef object = NULL, stored = NULL;
+    long long offset = 0, storedOffset = 0;
+
+    if (LLVMIsAConstant(vtable)) {
+        return vtable;
+    } else if (!LLVMIsALoadInst(vtable)) {
+        return NULL;
+    }
+
+    object = devirtualize_getBase_(dataLayout, LLVMGetOperand(vtable, 0), &offset);
+
+    for (LLVMValueRef instruction = LLVMGetPreviousInstruction(vtable); instruction;
+         instruction = LLVMGetPreviousInstruction(instruction)) {
+        if (LLVMIsAStoreInst(instruction)) {
+            storedOffset = 0;
+            stored = devirtualize_getBase_(dataLayout, LLVMGetOperand(instruction, 1), &storedOffset);
+
+            return stored == object && storedOffset == offset && LLVMIsAConstant(LLVMGetOperand(instruction, 0))
+                       ? LLVMGetOperand(instruction, 0)
+                       : NULL;
+        } else if (LLVMIsACallInst(instruction) || LLVMIsAInvokeInst(instruction) ||
+                   LLVMIsAAtomicRMWInst(instruction) || LLVMIsAAtomicCmpXchgInst(instruction)) { // Can change it
+            return NULL;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Makes a call through a vtable a direct call to a method.
+ *
+ * @param call     The call.
+ * @param function The method.
+ */
+void devirtualize_setCallee_(LLVMValueRef call, LLVMValueRef function) {
+    LLVMTypeRef type = LLVMTypeOf(LLVMGetCalledValue(call));
+
+    LLVMSetOperand(call, (unsigned)LLVMGetNumOperands(call) - 1,
+                   LLVMTypeOf(function) == type ? function : LLVMConstBitCast(function, type));
+}
+
+/**
+ * Replaces a block coming into the phis of another block, by building them
+ * again, as their incoming blocks cannot be set.
+ *
+ * @param builder The builder.
+ * @param block   The other block.
+ * @param from    The block replaced.
+ * @param to      The block replacing it.
+ */
+void devirtualize_replaceIncoming_(LLVMBuilderRef builder, LLVMBasicBlockRef block, LLVMBasicBlockRef from,
+                                   LLVMBasicBlockRef to) {
+    LLVMValueRef phi = LLVMGetFirstInstruction(block), next = NULL;
+
+    for (; LLVMIsAPHINode(phi); phi = next) {
+        LLVMValueRef replacement = NULL, value = NULL;
+        LLVMBasicBlockRef incoming = NULL;
+        char *name = stringConcatenate(2, LLVMGetValueName(phi), "");
+        bool replaced = false;
+
+        next = LLVMGetNextInstruction(phi);
+
+        for (unsigned index = 0; index < LLVMCountIncoming(phi) && !replaced; index++) {
+            replaced = LLVMGetIncomingBlock(phi, index) == from;
+        }
+
+        if (!replaced) { // Already built again, when the block is reached by more than one of the branch's cases
+            continue;
+        }
+
+        LLVMPositionBuilderBefore(builder, phi);
+        replacement = LLVMBuildPhi(builder, LLVMTypeOf(phi), "");
+
+        for (unsigned index = 0; index < LLVMCountIncoming(phi); index++) {
+            value = LLVMGetIncomingValue(phi, index);
+            incoming = LLVMGetIncomingBlock(phi, index) == from ? to : LLVMGetIncomingBlock(phi, index);
+
+            LLVMAddIncoming(replacement, &value, &incoming, 1);
+        }
+
+        LLVMReplaceAllUsesWith(phi, replacement);
+        LLVMInstructionEraseFromParent(phi);
+        LLVMSetValueName2(replacement, name, strlen(name));
+    }
+}
+
+/**
+ * Splits a block after an instruction, moving the rest of the block into a
+ * new block.
+ *
+ * @param builder     The builder.
+ * @param instruction The instruction.
+ *
+ * @return The new block.
+ */
+LLVMBasicBlockRef devirtualize_splitAfter_(LLVMBuilderRef builder, LLVMValueRef instruction) {
+    LLVMBasicBlockRef block = LLVMGetInstructionParent(instruction), next = LLVMGetNextBasicBlock(block), join = NULL;
+    LLVMValueRef function = LLVMGetBasicBlockParent(block), moved = NULL, terminator = NULL;
+    LLVMContextRef context = LLVMGetTypeContext(LLVMTypeOf(instruction));
+
+    join = next ? LLVMInsertBasicBlockInContext(context, next, "devirtualize.join")
+                : LLVMAppendBasicBlockInContext(context, function, "devirtualize.join");
+
+    LLVMPositionBuilderAtEnd(builder, join);
+
+    while ((moved = LLVMGetNextInstruction(instruction))) {
+        LLVMInstructionRemoveFromParent(moved);
+        LLVMInsertIntoBuilderWithName(builder, moved, LLVMGetValueName(moved));
+    }
+
+    terminator = LLVMGetBasicBlockTerminator(join);
+
+    for (unsigned index = 0; index < LLVMGetNumSuccessors(terminator); index++) { // Now branched to from the new block
+        devirtualize_replaceIncoming_(builder, LLVMGetSuccessor(terminator, index), block, join);
+    }
+
+    return join;
+}
+
+/**
+ * Copies the attributes of a call, at every index, and whether it is a tail
+ * call, to a call made in its place, so arguments passed 'byval' or 'sret'
+ * and extended ones are still passed the same way.
+ *
+ * @param call        The call.
+ * @param replacement The call made in its place.
+ */
+void devirtualize_copyCallAttributes_(LLVMValueRef call, LLVMValueRef replacement) {
+    for (int index = -1; index <= (int)LLVMGetNumArgOperands(call); index++) { // -1 is the function itself, 0 its result
+        LLVMAttributeIndex attributeIndex = (LLVMAttributeIndex)index; // -1 wraps to LLVMAttributeFunctionIndex
+        unsigned attributesLength = LLVMGetCallSiteAttributeCount(call, attributeIndex);
+        LLVMAttributeRef *attributes = NULL;
+
+        if (!attributesLength) {
+            continue;
+        }
+
+        attributes = malloc(attributesLength * sizeof(LLVMAttributeRef));
+
+        if (!attributes) {
+            panic("failed to malloc call attributes");
+        }
+
+        LLVMGetCallSiteAttributes(call, attributeIndex, attributes);
+
+        for (unsigned attribute = 0; attribute < attributesLength; attribute++) {
+            LLVMAddCallSiteAttribute(replacement, attributeIndex, attributes[attribute]);
+        }
+
+        free(attributes);
+    }
+
+    LLVMSetInstructionCallConv(replacement, LLVMGetInstructionCallConv(call));
+    LLVMSetTailCall(replacement, LLVMIsTailCall(call));
+}
+
+/**
+ * Guards a call through a vtable with checks for its most common methods,
+ * which are called directly, so they can be inlined, and the branches
+ * predicted. The call is left as the fallback, unless every method is
+ * checked for, when the last is called directly in its place.
+ *
+ * @param builder       The builder.
+ * @param call          The call.
+ * @param TARGETS       The methods, the most common first.
+ * @param targetsLength The number of methods.
+ */
+void devirtualize_buildGuards_(LLVMBuilderRef builder, LLVMValueRef call, const struct DevirtualizeTarget *TARGETS,
+                               size_t targetsLength) {
+    LLVMBasicBlockRef block = LLVMGetInstructionParent(call), join = devirtualize_splitAfter_(builder, call),
+                      fallback = NULL, direct = NULL, next = NULL;
+    LLVMContextRef context = LLVMGetTypeContext(LLVMTypeOf(call));
+    LLVMValueRef method = LLVMGetCalledValue(call), phi = NULL, result = NULL;
+    LLVMTypeRef type = LLVMTypeOf(method), functionType = LLVMGetCalledFunctionType(call);
+    unsigned argumentsLength = LLVMGetNumArgOperands(call);
+    LLVMValueRef *arguments = malloc((argumentsLength + 1) * sizeof(LLVMValueRef));
+    bool complete = targetsLength <= DEVIRTUALIZE_MAX_GUARDS;
+    size_t guards = complete ? targetsLength - 1 : DEVIRTUALIZE_MAX_GUARDS;
+
+    if (!arguments) {
+        panic("failed to malloc call arguments");
+    }
+
+    for (unsigned index = 0; index < argumentsLength; index++) {
+        arguments[index] = LLVMGetOperand(call, index);
+    }
+
+    fallback = LLVMInsertBasicBlockInContext(context, join, "devirtualize.fallback");
+
+    if (LLVMGetTypeKind(LLVMTypeOf(call)) != LLVMVoidTypeKind) {
+        LLVMPositionBuilder(builder, join, LLVMGetFirstInstruction(join));
+        phi = LLVMBuildPhi(builder, LLVMTypeOf(call), "");
+        LLVMReplaceAllUsesWith(call, phi);
+    }
+
+    LLVMInstructionRemoveFromParent(call);
+    LLVMPositionBuilderAtEnd(builder, fallback);
+    LLVMInsertIntoBuilderWithName(builder, call, LLVMGetValueName(call));
+    LLVMBuildBr(builder, join);
+
+    if (complete) {
+        devirtualize_setCallee_(call, TARGETS[targetsLength - 1].function);
+    }
+
+    if (phi) {
+        LLVMAddIncoming(phi, &call, &fallback, 1);
+    }
+
+    LLVMPositionBuilderAtEnd(builder, block);
+
+    for (size_t index = 0; index < guards; index++) {
+        LLVMValueRef function = LLVMTypeOf(TARGETS[index].function) == type
+                                    ? TARGETS[index].function
+                                    : LLVMConstBitCast(TARGETS[index].function, type);
+
+        direct = LLVMInsertBasicBlockInContext(context, fallback, "devirtualize.direct");
+        next = index + 1 < guards ? LLVMInsertBasicBlockInContext(context, fallback, "devirtualize.guard") : fallback;
+
+        LLVMBuildCondBr(builder, LLVMBuildICmp(builder, LLVMIntEQ, method, function, ""), direct, next);
+        LLVMPositionBuilderAtEnd(builder, direct);
+        result = LLVMBuildCall2(builder, functionType, function, arguments, argumentsLength, "");
+        devirtualize_copyCallAttributes_(call, result);
+        LLVMBuildBr(builder, join);
+
+        if (phi) {
+            LLVMAddIncoming(phi, &result, &direct, 1);
+        }
+
+        LLVMPositionBuilderAtEnd(builder, next);
+    }
+
+    if (!guards) { // Only reached by the fallback
+        LLVMPositionBuilderAtEnd(builder, block);
+        LLVMBuildBr(builder, fallback);
+    }
+
+    free(arguments);
+}
+
+/**
+ * Compares DevirtualizeTarget structs, so the methods used by the most
+ * classes come first.
+ *
+ * @param a The first DevirtualizeTarget struct.
+ * @param b The second DevirtualizeTarget struct.
+ *
+ * @return The order of the structs.
+ */
+int devirtualize_compareTargets_(const void *a, const void *b) {
+    const struct DevirtualizeTarget *A = a, *B = b;
+
+    return A->classes < B->classes ? 1 : (A->classes > B->classes ? -1 : 0);
+}
+
+/**
+ * Gets the methods a call through a vtable can reach, from the vtables of
+ * the classes below the receiver's class.
+ *
+ * @param dataLayout The data layout of the module.
+ * @param vtables    The DevirtualizeVtable structs.
+ * @param type       The receiver's class's metadata identifier.
+ * @param offset     The offset of the method in the vtable, in bytes.
+ * @param targets    Where to store the methods, with room for one per vtable.
+ *
+ * @return The number of methods, or 0 if one cannot be found.
+ */
+size_t devirtualize_getTargets_(LLVMTargetDataRef dataLayout, struct Array *vtables, LLVMValueRef type,
+                                long long offset, struct DevirtualizeTarget *targets) {
+    size_t targetsLength = 0, index = 0;
+
+    for (size_t vtableIndex = 0; vtableIndex < vtables->length; vtableIndex++) {
+        const struct DevirtualizeVtable *VTABLE = array_get(vtables, vtableIndex);
+        LLVMValueRef function = NULL;
+
+        if (VTABLE->type != type) {
+            continue;
+        }
+
+        function = devirtualize_getFunction_(dataLayout, LLVMGetInitializer(VTABLE->global), VTABLE->offset + offset);
+
+        if (!function) {
+            return 0;
+        }
+
+        for (index = 0; index < targetsLength && targets[index].function != function; index++) {
+        }
+
+        if (index == targetsLength) {
+            targets[targetsLength++] = (struct DevirtualizeTarget){function, 0};
+        }
+
+        targets[index].classes++;
+    }
+
+    qsort(targets, targetsLength, DEVIRTUALIZE_TARGET_STRUCT_SIZE, devirtualize_compareTargets_);
+
+    return targetsLength;
+}
+
+/**
+ * Turns calls to class methods through vtables into direct calls, so they
+ * can be inlined. Receivers are found from the 'llvm.type.test' of the
+ * vtable each call loads its method from. Calls whose receiver's vtable is
+ * known, or whose method has one implementation in the classes below the
+ * receiver's class, are made direct, and the rest test for their most
+ * common implementations before falling back to the vtable. The class
+ * hierarchy is only known once the whole program is, so before that only
+ * receivers with known vtables are made direct, and the type tests are
+ * kept for when it is.
+ *
+ * @param module       The module.
+ * @param wholeProgram Whether the module is the whole program.
+ */
+void devirtualize_calls(LLVMModuleRef module, bool wholeProgram) {
+    LLVMValueRef typeTest = LLVMGetNamedFunction(module, "llvm.type.test");
+    LLVMTargetDataRef dataLayout = LLVMGetModuleDataLayout(module);
+    struct Array *vtables = NULL, *tests = NULL, *loads = NULL, *calls = NULL;
+    struct DevirtualizeTarget *targets = NULL;
+    LLVMBuilderRef builder = NULL;
+
+    if (!typeTest) {
+        return;
+    }
+
+    vtables = array_new();
+    tests = array_new();
+    loads = array_new();
+    calls = array_new();
+    builder = LLVMCreateBuilderInContext(LLVMGetModuleContext(module));
+    devirtualize_collectVtables_(module, vtables);
+    targets = malloc((vtables->length + 1) * DEVIRTUALIZE_TARGET_STRUCT_SIZE);
+
+    if (!targets) {
+        panic("failed to malloc DevirtualizeTarget structs");
+    }
+
+    for (LLVMUseRef use = LLVMGetFirstUse(typeTest); use; use = LLVMGetNextUse(use)) {
+        if (LLVMIsACallInst(LLVMGetUser(use)) && LLVMGetCalledValue(LLVMGetUser(use)) == typeTest) {
+            array_insert(tests, tests->length, LLVMGetUser(use));
+        }
+    }
+
+    for (size_t index = 0; index < tests->length; index++) { // Each call's vtable is tested once
+        LLVMValueRef test = (LLVMValueRef)array_get(tests, index), vtable = NULL, type = LLVMGetOperand(test, 1),
+                     known = NULL;
+        long long testOffset = 0, knownOffset = 0; // Where the class's methods start in the vtable tested
+
+        vtable = devirtualize_getBase_(dataLayout, LLVMGetOperand(test, 0), &testOffset);
+        known = devirtualize_getKnownVtable_(dataLayout, vtable);
+        known = known ? devirtualize_getBase_(dataLayout, known, &knownOffset) : NULL;
+        known = known && LLVMIsAGlobalVariable(known) && LLVMGetInitializer(known) ? known : NULL;
+
+        devirtualize_collectLoads_(vtable, loads);
+
+        for (size_t loadIndex = 0; loadIndex < loads->length; loadIndex++) {
+            LLVMValueRef load = (LLVMValueRef)array_get(loads, loadIndex), function = NULL;
+            long long offset = 0;
+            size_t targetsLength = 0;
+
+            if (devirtualize_getBase_(dataLayout, LLVMGetOperand(load, 0), &offset) != vtable) {
+                continue;
+            }
+
+            offset -= testOffset;
+
+            devirtualize_collectCalls_(load, calls);
+
+            for (size_t callIndex = 0; callIndex < calls->length; callIndex++) {
+                LLVMValueRef call = (LLVMValueRef)array_get(calls, callIndex);
+
+                function = known ? devirtualize_getFunction_(dataLayout, LLVMGetInitializer(known), knownOffset + offset)
+                                 : NULL;
+
+                if (function) {
+                    devirtualize_setCallee_(call, function);
+                } else if (wholeProgram &&
+                           (targetsLength = devirtualize_getTargets_(dataLayout, vtables, type, offset, targets)) == 1) {
+                    devirtualize_setCallee_(call, targets[0].function);
+                } else if (targetsLength) {
+                    devirtualize_buildGuards_(builder, call, targets, targetsLength);
+                }
+            }
+
+            array_clear(calls, NULL);
+        }
+
+        array_clear(loads, NULL);
+    }
+
+    if (wholeProgram) { // Nothing is left to use them, and they would stop the vtables being optimised away
+        for (size_t index = 0; index < tests->length; index++) {
+            LLVMReplaceAllUsesWith((LLVMValueRef)array_get(tests, index),
+                                   LLVMConstInt(LLVMInt1TypeInContext(LLVMGetModuleContext(module)), 1, false));
+            LLVMInstructionEraseFromParent((LLVMValueRef)array_get(tests, index));
+        }
+    }
+
+    for (size_t index = 0; index < vtables->length; index++) {
+        free((void *)array_get(vtables, index));
+    }
+
+    free(targets);
+    LLVMDisposeBuilder(builder);
+    array_free(&calls);
+    array_free(&loads);
+    array_free(&tests);
+    array_free(&vtables);
+}
@@ -0,0 +1,688 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+#pragma once
+
+#include "../includes.c"
+
+#include <limits.h>
+
+#include <llvm-c/Core.h>
+
+#include "../utils/array.c"
+#include "../utils/panic.c"
+#include "./arithmetic.c"
+
+/**
+ * Represents the magic number of a divisor, computed once outside a loop
+ * so dividing by it in the loop is a multiply and shifts, like libdivide.
+ * Signed divisions use the magic number of the divisor's magnitude.
+ */
+struct DivisorMagic {
+    LLVMValueRef divisor, multiplier, firstShift, secondShift;
+    LLVMBasicBlockRef preheader; // Of the loop it is computed before
+    bool isSigned;
+};
+
+#define DIVISOR_MAGIC_STRUCT_SIZE sizeof(struct DivisorMagic)
+
+/**
+ * Represents a natural loop, the blocks which can reach a branch back to
+ * its header without passing through the header.
+ */
+struct DivisorLoop {
+    LLVMBasicBlockRef header, preheader; // The preheader is NULL unless it is the only way in, and only leads in
+    unsigned long long *body;            // A bit for each of the function's blocks
+    size_t size;
+};
+
+#define DIVISOR_LOOP_STRUCT_SIZE sizeof(struct DivisorLoop)
+
+/**
+ * Represents the blocks of a function, and the loops they make up.
+ */
+struct DivisorGraph {
+    LLVMBasicBlockRef *blocks;
+    size_t length, words; // The number of blocks, and of words in a set of them
+    struct Array *loops;
+};
+
+#define DIVISOR_GRAPH_STRUCT_SIZE sizeof(struct DivisorGraph)
+#define DIVISOR_WORD_BITS 64
+#define DIVISOR_MIN_TRIP_COUNT 8 // Iterations each time a loop starts for its magic number's wide divide to pay off
+
+/**
+ * Gets whether a set of blocks has a block.
+ *
+ * @param set   The set.
+ * @param index The index of the block.
+ *
+ * @return Whether the set has the block.
+ */
+bool divisor_hasBlock_(const unsigned long long *set, size_t index) {
+    return (set[index / DIVISOR_WORD_BITS] >> (index % DIVISOR_WORD_BITS)) & 1;
+}
+
+/**
+ * Adds a block to a set of blocks.
+ *
+ * @param set   The set.
+ * @param index The index of the block.
+ */
+void divisor_addBlock_(unsigned long long *set, size_t index) {
+    set[index / DIVISOR_WORD_BITS] |= 1ULL << (index % DIVISOR_WORD_BITS);
+}
+
+/**
+ * Gets the index of a block in a function.
+ *
+ * @param GRAPH The function's DivisorGraph struct.
+ * @param block The block.
+ *
+ * @return The index, or the number of blocks if the block is not in the
+ * function.
+ */
+size_t divisor_getIndex_(const struct DivisorGraph *GRAPH, LLVMBasicBlockRef block) {
+    size_t index = 0;
+
+    while (index < GRAPH->length && GRAPH->blocks[index] != block) {
+        index++;
+    }
+
+    return index;
+}
+
+/**
+ * Adds the blocks of the loop made by a branch back to a header, merging
+ * them into any loop the header already has.
+ *
+ * @param self         The current DivisorGraph struct.
+ * @param header       The index of the header.
+ * @param latch        The index of the block branching back to it.
+ * @param predecessors The predecessors of each block.
+ */
+void divisor_addLoop_(struct DivisorGraph *self, size_t header, size_t latch, const unsigned long long *predecessors) {
+    struct DivisorLoop *loop = NULL;
+    size_t *queue = calloc(self->length, sizeof(size_t)), queueLength = 0;
+
+    if (!queue) {
+        panic("failed to calloc loop queue");
+    }
+
+    for (size_t index = 0; index < self->loops->length && !loop; index++) {
+        struct DivisorLoop *other = (struct DivisorLoop *)array_get(self->loops, index);
+
+        loop = other->header == self->blocks[header] ? other : NULL;
+    }
+
+    if (!loop) {
+        loop = malloc(DIVISOR_LOOP_STRUCT_SIZE);
+
+        if (!loop || !(loop->body = calloc(self->words, sizeof(unsigned long long)))) {
+            panic("failed to malloc loop");
+        }
+
+        loop->header = self->blocks[header];
+        loop->preheader = NULL;
+        loop->size = 1;
+        divisor_addBlock_(loop->body, header);
+        array_insert(self->loops, self->loops->length, loop);
+    }
+
+    if (!divisor_hasBlock_(loop->body, latch)) { // Searched backwards, stopping at the header
+        divisor_addBlock_(loop->body, latch);
+        loop->size++;
+        queue[queueLength++] = latch;
+    }
+
+    while (queueLength) {
+        const unsigned long long *PREDECESSORS = predecessors + queue[--queueLength] * self->words;
+
+        for (size_t index = 0; index < self->length; index++) {
+            if (divisor_hasBlock_(PREDECESSORS, index) && !divisor_hasBlock_(loop->body, index)) {
+                divisor_addBlock_(loop->body, index);
+                loop->size++;
+                queue[queueLength++] = index;
+            }
+        }
+    }
+
+    free(queue);
+}
+
+/**
+ * Finds the preheader of a loop, its header's only predecessor from
+ * outside of it, if that block only branches to the header.
+ *
+ * @param self         The current DivisorGraph struct.
+ * @param loop         The loop.
+ * @param predecessors The predecessors of each block.
+ */
+void divisor_findPreheader_(struct DivisorGraph *self, struct DivisorLoop *loop, const unsigned long long *predecessors) {
+    const unsigned long long *PREDECESSORS = predecessors + divisor_getIndex_(self, loop->header) * self->words;
+    LLVMBasicBlockRef preheader = NULL;
+
+    for (size_t index = 0; index < self->length; index++) {
+        if (!divisor_hasBlock_(PREDECESSORS, index) || divisor_hasBlock_(loop->body, index)) {
+            continue;
+        } else if (preheader) { // More than one way in
+            return;
+        }
+
+        preheader = self->blocks[index];
+    }
+
+    if (preheader && LLVMGetNumSuccessors(LLVMGetBasicBlockTerminator(preheader)) == 1) {
+        loop->preheader = preheader;
+    }
+}
+
+/**
+ * Creates a new DivisorGraph struct, finding a function's loops from the
+ * blocks dominating each block.
+ *
+ * @param function The function.
+ *
+ * @return The created DivisorGraph struct.
+ */
+struct DivisorGraph *divisor_newGraph_(LLVMValueRef function) {
+    struct DivisorGraph *self = malloc(DIVISOR_GRAPH_STRUCT_SIZE);
+    unsigned long long *predecessors = NULL, *dominators = NULL, *next = NULL;
+    bool changed = true;
+
+    if (!self) {
+        panic("failed to malloc DivisorGraph struct");
+    }
+
+    self->length = LLVMCountBasicBlocks(function);
+    self->words = (self->length + DIVISOR_WORD_BITS - 1) / DIVISOR_WORD_BITS;
+    self->blocks = calloc(self->length, sizeof(LLVMBasicBlockRef));
+    self->loops = array_new();
+    predecessors = calloc(self->length * self->words, sizeof(unsigned long long));
+    dominators = calloc(self->length * self->words, sizeof(unsigned long long));
+    next = calloc(self->words, sizeof(unsigned long long));
+
+    if (!self->blocks || !predecessors || !dominators || !next) {
+        panic("failed to calloc DivisorGraph struct");
+    }
+
+    LLVMGetBasicBlocks(function, self->blocks);
+
+    for (size_t index = 0; index < self->length; index++) {
+        LLVMValueRef terminator = LLVMGetBasicBlockTerminator(self->blocks[index]);
+
+        for (unsigned successor = 0; terminator && successor < LLVMGetNumSuccessors(terminator); successor++) {
+            divisor_addBlock_(predecessors + divisor_getIndex_(self, LLVMGetSuccessor(terminator, successor)) *
+                                                 self->words,
+                              index);
+        }
+
+        // The entry block is only dominated by itself, and the rest start dominated by everything
+        memset(dominators + index * self->words, index == 0 ? 0 : 0xff, self->words * sizeof(unsigned long long));
+    }
+
+    divisor_addBlock_(dominators, 0);
+
+    while (changed) { // A block's dominators are itself and the blocks dominating all of its predecessors
+        changed = false;
+
+        for (size_t index = 1; index < self->length; index++) {
+            memset(next, 0xff, self->words * sizeof(unsigned long long));
+
+            for (size_t predecessor = 0; predecessor < self->length; predecessor++) {
+                if (divisor_hasBlock_(predecessors + index * self->words, predecessor)) {
+                    for (size_t word = 0; word < self->words; word++) {
+                        next[word] &= dominators[predecessor * self->words + word];
+                    }
+                }
+            }
+
+            divisor_addBlock_(next, index);
+
+            if (memcmp(next, dominators + index * self->words, self->words * sizeof(unsigned long long)) != 0) {
+                memcpy(dominators + index * self->words, next, self->words * sizeof(unsigned long long));
+                changed = true;
+            }
+        }
+    }
+
+    for (size_t index = 0; index < self->length; index++) { // Branches to a dominator go back around a loop
+        LLVMValueRef terminator = LLVMGetBasicBlockTerminator(self->blocks[index]);
+
+        for (unsigned successor = 0; terminator && successor < LLVMGetNumSuccessors(terminator); successor++) {
+            size_t header = divisor_getIndex_(self, LLVMGetSuccessor(terminator, successor));
+
+            if (divisor_hasBlock_(dominators + index * self->words, header)) {
+                divisor_addLoop_(self, header, index, predecessors);
+            }
+        }
+    }
+
+    for (size_t index = 0; index < self->loops->length; index++) {
+        divisor_findPreheader_(self, (struct DivisorLoop *)array_get(self->loops, index), predecessors);
+    }
+
+    free(predecessors);
+    free(dominators);
+    free(next);
+
+    return self;
+}
+
+/**
+ * Frees a DivisorGraph struct.
+ *
+ * @param self The current DivisorGraph struct.
+ */
+void divisor_freeGraph_(struct DivisorGraph **self) {
+    if (self && *self) {
+        for (size_t index = 0; index < (*self)->loops->length; index++) {
+            struct DivisorLoop *loop = (struct DivisorLoop *)array_get((*self)->loops, index);
+
+            free(loop->body);
+            free(loop);
+        }
+
+        array_free(&(*self)->loops);
+        free((*self)->blocks);
+        free(*self);
+        *self = NULL;
+    } else {
+        panic("DivisorGraph struct has already been freed");
+    }
+}
+
+/**
+ * Gets the outermost loop around a block which a divisor does not change
+ * in, and which has a preheader to build its magic number in.
+ *
+ * @param GRAPH      The function's DivisorGraph struct.
+ * @param block      The block dividing.
+ * @param definition The block defining the divisor, or NULL for a
+ * parameter.
+ *
+ * @return The loop, or NULL if there is none.
+ */
+const struct DivisorLoop *divisor_getLoop_(const struct DivisorGraph *GRAPH, LLVMBasicBlockRef block,
+                                           LLVMBasicBlockRef definition) {
+    const struct DivisorLoop *outermost = NULL;
+    size_t index = divisor_getIndex_(GRAPH, block), definitionIndex = divisor_getIndex_(GRAPH, definition);
+
+    for (size_t loopIndex = 0; loopIndex < GRAPH->loops->length; loopIndex++) {
+        const struct DivisorLoop *LOOP = array_get(GRAPH->loops, loopIndex);
+
+        // Loops around the same block nest, so the largest is the outermost
+        if (LOOP->preheader && divisor_hasBlock_(LOOP->body, index) &&
+            (definitionIndex == GRAPH->length || !divisor_hasBlock_(LOOP->body, definitionIndex)) &&
+            (!outermost || LOOP->size > outermost->size)) {
+            outermost = LOOP;
+        }
+    }
+
+    return outermost;
+}
+
+/**
+ * Gets whether a value is defined outside of a loop, so does not change in
+ * it.
+ *
+ * @param GRAPH The function's DivisorGraph struct.
+ * @param LOOP  The loop.
+ * @param value The value.
+ *
+ * @return Whether the value is defined outside of the loop.
+ */
+bool divisor_isInvariant_(const struct DivisorGraph *GRAPH, const struct DivisorLoop *LOOP, LLVMValueRef value) {
+    return !LLVMIsAInstruction(value) ||
+           !divisor_hasBlock_(LOOP->body, divisor_getIndex_(GRAPH, LLVMGetInstructionParent(value)));
+}
+
+/**
+ * Gets how far one value is from another, if it is known at compile time,
+ * as both are constants or one is the other plus a constant.
+ *
+ * @param from     The first value.
+ * @param to       The second value.
+ * @param distance Where to put the second value minus the first.
+ *
+ * @return Whether the distance is known.
+ */
+bool divisor_getDistance_(LLVMValueRef from, LLVMValueRef to, long long *distance) {
+    if (LLVMIsAConstantInt(from) && LLVMIsAConstantInt(to)) {
+        *distance = LLVMConstIntGetSExtValue(to) - LLVMConstIntGetSExtValue(from);
+    } else if (LLVMIsAInstruction(to) && LLVMGetInstructionOpcode(to) == LLVMAdd && LLVMGetOperand(to, 0) == from &&
+               LLVMIsAConstantInt(LLVMGetOperand(to, 1))) {
+        *distance = LLVMConstIntGetSExtValue(LLVMGetOperand(to, 1));
+    } else if (LLVMIsAInstruction(from) && LLVMGetInstructionOpcode(from) == LLVMAdd &&
+               LLVMGetOperand(from, 0) == to && LLVMIsAConstantInt(LLVMGetOperand(from, 1))) {
+        *distance = -LLVMConstIntGetSExtValue(LLVMGetOperand(from, 1));
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Gets roughly how many times a loop runs each time it starts, from the
+ * only branch out of it. Profiled branches give it from their weights, and
+ * others from an induction variable stepping by a constant towards a bound
+ * a known distance from where it starts.
+ *
+ * @param GRAPH    The function's DivisorGraph struct.
+ * @param LOOP     The loop.
+ * @param profKind The kind of '!prof' metadata.
+ *
+ * @return The trip count, or 0 if it is not known.
+ */
+unsigned long long divisor_getTripCount_(const struct DivisorGraph *GRAPH, const struct DivisorLoop *LOOP,
+                                         unsigned profKind) {
+    LLVMValueRef exit = NULL, condition = NULL, weights = NULL;
+    bool isLeavingFirst = false;
+
+    for (size_t index = 0; index < GRAPH->length; index++) {
+        LLVMValueRef terminator = LLVMGetBasicBlockTerminator(GRAPH->blocks[index]);
+
+        for (unsigned successor = 0; divisor_hasBlock_(LOOP->body, index) && terminator &&
+                                     successor < LLVMGetNumSuccessors(terminator);
+             successor++) {
+            if (divisor_hasBlock_(LOOP->body, divisor_getIndex_(GRAPH, LLVMGetSuccessor(terminator, successor)))) {
+                continue;
+            } else if (exit || !LLVMIsABranchInst(terminator) || !LLVMIsConditional(terminator)) {
+                return 0; // More than one way out, or one which is not a branch
+            }
+
+            exit = terminator;
+            isLeavingFirst = successor == 0;
+        }
+    }
+
+    if (!exit) {
+        return 0;
+    } else if ((weights = LLVMGetMetadata(exit, profKind)) && LLVMGetMDNodeNumOperands(weights) == 3) {
+        LLVMValueRef operands[3];
+        unsigned long long leaving = 0, staying = 0;
+
+        LLVMGetMDNodeOperands(weights, operands);
+
+        if (LLVMIsAConstantInt(operands[1]) && LLVMIsAConstantInt(operands[2])) {
+            leaving = LLVMConstIntGetZExtValue(operands[isLeavingFirst ? 1 : 2]);
+            staying = LLVMConstIntGetZExtValue(operands[isLeavingFirst ? 2 : 1]);
+
+            return leaving ? (leaving + staying) / leaving : ULLONG_MAX;
+        }
+    }
+
+    condition = LLVMGetCondition(exit);
+
+    for (unsigned side = 0; LLVMIsAICmpInst(condition) && side < 2; side++) {
+        LLVMValueRef induction = LLVMGetOperand(condition, side), bound = LLVMGetOperand(condition, 1 - side),
+                     start = NULL, next = NULL;
+        long long distance = 0, step = 0;
+
+        if (LLVMIsAInstruction(induction) && LLVMGetInstructionOpcode(induction) == LLVMAdd &&
+            LLVMIsAConstantInt(LLVMGetOperand(induction, 1))) { // Compared once stepped, as in rotated loops
+            induction = LLVMGetOperand(induction, 0);
+        }
+
+        if (!divisor_isInvariant_(GRAPH, LOOP, bound) || !LLVMIsAPHINode(induction) ||
+            LLVMGetInstructionParent(induction) != LOOP->header || LLVMCountIncoming(induction) != 2) {
+            continue;
+        }
+
+        for (unsigned incoming = 0; incoming < 2; incoming++) {
+            LLVMValueRef value = LLVMGetIncomingValue(induction, incoming);
+
+            if (divisor_hasBlock_(LOOP->body, divisor_getIndex_(GRAPH, LLVMGetIncomingBlock(induction, incoming)))) {
+                next = value;
+            } else {
+                start = value;
+            }
+        }
+
+        if (!start || !next || !LLVMIsAInstruction(next) || LLVMGetInstructionOpcode(next) != LLVMAdd ||
+            LLVMGetOperand(next, 0) != induction || !LLVMIsAConstantInt(LLVMGetOperand(next, 1)) ||
+            !(step = LLVMConstIntGetSExtValue(LLVMGetOperand(next, 1))) || !divisor_getDistance_(start, bound, &distance) ||
+            distance / step <= 0) {
+            continue;
+        }
+
+        return (unsigned long long)(distance / step);
+    }
+
+    return 0;
+}
+
+/**
+ * Gets whether replacing a division in a loop pays for the wide divide its
+ * magic number costs each time the loop starts. It does if the division is
+ * in a loop nested in that one, so runs for every iteration of both, or if
+ * the loop's trip count is known or profiled to be high enough.
+ *
+ * @param GRAPH    The function's DivisorGraph struct.
+ * @param LOOP     The loop the magic number is computed before.
+ * @param block    The block dividing.
+ * @param profKind The kind of '!prof' metadata.
+ *
+ * @return Whether replacing the division pays.
+ */
+bool divisor_isProfitable_(const struct DivisorGraph *GRAPH, const struct DivisorLoop *LOOP, LLVMBasicBlockRef block,
+                           unsigned profKind) {
+    size_t index = divisor_getIndex_(GRAPH, block);
+
+    for (size_t loopIndex = 0; loopIndex < GRAPH->loops->length; loopIndex++) {
+        const struct DivisorLoop *OTHER = array_get(GRAPH->loops, loopIndex);
+
+        // Loops around the same block nest, so a smaller one is inside
+        if (divisor_hasBlock_(OTHER->body, index) && OTHER->size < LOOP->size) {
+            return true;
+        }
+    }
+
+    return divisor_getTripCount_(GRAPH, LOOP, profKind) >= DIVISOR_MIN_TRIP_COUNT;
+}
+
+/**
+ * Builds the magic number of a divisor. For an N bit divisor d with
+ * l = ceil(log2(d)), the multiplier is floor(2^N * (2^l - d) / d) + 1, and
+ * dividing by d becomes a multiply, an add and two shifts, without branches
+ * for d of 1.
+ *
+ * @param builder  The builder, positioned at the end of a loop's
+ * preheader.
+ * @param divisor  The divisor.
+ * @param isSigned Whether the divisor is signed.
+ *
+ * @return The DivisorMagic struct.
+ */
+struct DivisorMagic *divisor_buildMagic_(LLVMBuilderRef builder, LLVMValueRef divisor, bool isSigned) {
+    struct DivisorMagic *magic = malloc(DIVISOR_MAGIC_STRUCT_SIZE);
+    LLVMTypeRef type = LLVMTypeOf(divisor);
+    unsigned width = LLVMGetIntTypeWidth(type);
+    LLVMTypeRef wideType = LLVMIntTypeInContext(LLVMGetTypeContext(type), width * 2);
+    LLVMValueRef magnitude = divisor, ceilLog2 = NULL, numerator = NULL, one = LLVMConstInt(type, 1, false);
+
+    if (isSigned) {
+        magnitude = LLVMBuildSelect(builder, LLVMBuildICmp(builder, LLVMIntSLT, divisor, LLVMConstNull(type), ""),
+                                    LLVMBuildNeg(builder, divisor, ""), divisor, "");
+    }
+
+    // Dividing by 0 is undefined, but the magic number is computed even when the division would not run
+    magnitude = LLVMBuildSelect(builder, LLVMBuildICmp(builder, LLVMIntEQ, magnitude, LLVMConstNull(type), ""), one,
+                                magnitude, "");
+
+    ceilLog2 = LLVMBuildSub(
+        builder, LLVMConstInt(type, width, false),
+        arithmetic_buildIntrinsic(builder, "llvm.ctlz", &type, 1,
+                                  (LLVMValueRef[]){LLVMBuildSub(builder, magnitude, one, ""),
+                                                   LLVMConstInt(LLVMInt1TypeInContext(LLVMGetTypeContext(type)), 0, false)},
+                                  2),
+        "");
+    numerator = LLVMBuildShl(builder,
+                             LLVMBuildSub(builder,
+                                          LLVMBuildShl(builder, LLVMConstInt(wideType, 1, false),
+                                                       LLVMBuildZExt(builder, ceilLog2, wideType, ""), ""),
+                                          LLVMBuildZExt(builder, magnitude, wideType, ""), ""),
+                             LLVMConstInt(wideType, width, false), "");
+
+    magic->divisor = divisor;
+    magic->preheader = LLVMGetInsertBlock(builder);
+    magic->multiplier = LLVMBuildAdd(
+        builder,
+        LLVMBuildTrunc(builder, LLVMBuildUDiv(builder, numerator, LLVMBuildZExt(builder, magnitude, wideType, ""), ""),
+                       type, ""),
+        one, "divisor.magic");
+    magic->firstShift =
+        LLVMBuildZExt(builder, LLVMBuildICmp(builder, LLVMIntNE, ceilLog2, LLVMConstNull(type), ""), type, "");
+    magic->secondShift = LLVMBuildSub(builder, ceilLog2, magic->firstShift, "");
+    magic->isSigned = isSigned;
+
+    return magic;
+}
+
+/**
+ * Builds a division by a divisor with a magic number.
+ *
+ * @param builder  The builder, positioned at the division.
+ * @param dividend The dividend.
+ * @param MAGIC    The magic number of the divisor.
+ *
+ * @return The quotient, truncated towards 0.
+ */
+LLVMValueRef divisor_buildDivision_(LLVMBuilderRef builder, LLVMValueRef dividend, const struct DivisorMagic *MAGIC) {
+    LLVMTypeRef type = LLVMTypeOf(dividend);
+    unsigned width = LLVMGetIntTypeWidth(type);
+    LLVMTypeRef wideType = LLVMIntTypeInContext(LLVMGetTypeContext(type), width * 2);
+    LLVMValueRef magnitude = dividend, high = NULL, quotient = NULL;
+
+    if (MAGIC->isSigned) {
+        magnitude = LLVMBuildSelect(builder, LLVMBuildICmp(builder, LLVMIntSLT, dividend, LLVMConstNull(type), ""),
+                                    LLVMBuildNeg(builder, dividend, ""), dividend, "");
+    }
+
+    high = LLVMBuildTrunc(builder,
+                          LLVMBuildLShr(builder,
+                                        LLVMBuildMul(builder, LLVMBuildZExt(builder, magnitude, wideType, ""),
+                                                     LLVMBuildZExt(builder, MAGIC->multiplier, wideType, ""), ""),
+                                        LLVMConstInt(wideType, width, false), ""),
+                          type, "");
+    quotient = LLVMBuildLShr(
+        builder,
+        LLVMBuildAdd(builder, high,
+                     LLVMBuildLShr(builder, LLVMBuildSub(builder, magnitude, high, ""), MAGIC->firstShift, ""), ""),
+        MAGIC->secondShift, "");
+
+    if (MAGIC->isSigned) { // Negative when exactly one side is
+        quotient = LLVMBuildSelect(builder,
+                                   LLVMBuildICmp(builder, LLVMIntSLT, LLVMBuildXor(builder, dividend, MAGIC->divisor, ""),
+                                                 LLVMConstNull(type), ""),
+                                   LLVMBuildNeg(builder, quotient, ""), quotient, "");
+    }
+
+    return quotient;
+}
+
+/**
+ * Replaces divisions in loops by divisors which do not change in them with
+ * a multiply by a magic number, computed in the preheader of the outermost
+ * such loop. LLVM's loop rotation guards loops with their condition before
+ * the preheader, so loops which never run never compute it. Hardware
+ * divides cost from several to tens of cycles each iteration, depending on
+ * the CPU, while the magic number costs one divide of twice the width, a
+ * call to '__udivti3' for 64 bits, each time the loop starts, so loops
+ * are only changed when divisor_isProfitable_ expects them to run enough
+ * times. See 'programs/benchmarks/divisor.ll'. Constant divisors are left
+ * to LLVM, which already does this at compile time.
+ *
+ * @param module The module.
+ *
+ * @return Whether any division was replaced.
+ */
+bool divisor_reduce(LLVMModuleRef module) {
+    LLVMBuilderRef builder = LLVMCreateBuilderInContext(LLVMGetModuleContext(module));
+    unsigned profKind = LLVMGetMDKindIDInContext(LLVMGetModuleContext(module), "prof", 4);
+    struct Array *magics = array_new();
+    bool changed = false;
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+        struct DivisorGraph *graph = NULL; // Only found for functions dividing, and kept as no blocks are added
+
+        for (LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function); block; block = LLVMGetNextBasicBlock(block)) {
+            LLVMValueRef instruction = LLVMGetFirstInstruction(block), next = NULL;
+
+            for (; instruction; instruction = next) {
+                LLVMOpcode opcode = LLVMGetInstructionOpcode(instruction);
+                bool isSigned = opcode == LLVMSDiv || opcode == LLVMSRem;
+                LLVMValueRef divisor = NULL, result = NULL;
+                const struct DivisorLoop *loop = NULL;
+                const struct DivisorMagic *magic = NULL;
+
+                next = LLVMGetNextInstruction(instruction);
+
+                if (!isSigned && opcode != LLVMUDiv && opcode != LLVMURem) {
+                    continue;
+                }
+
+                divisor = LLVMGetOperand(instruction, 1);
+
+                if (LLVMIsAConstant(divisor) || LLVMGetTypeKind(LLVMTypeOf(divisor)) != LLVMIntegerTypeKind ||
+                    LLVMGetIntTypeWidth(LLVMTypeOf(divisor)) < 8 ||
+                    LLVMGetIntTypeWidth(LLVMTypeOf(divisor)) > 64 || LLVMIsAInvokeInst(divisor)) {
+                    continue;
+                } else if (!graph) {
+                    graph = divisor_newGraph_(function);
+                }
+
+                if (!(loop = divisor_getLoop_(graph, block,
+                                              LLVMIsAInstruction(divisor) ? LLVMGetInstructionParent(divisor) : NULL)) ||
+                    !divisor_isProfitable_(graph, loop, block, profKind)) {
+                    continue;
+                }
+
+                for (size_t index = 0; index < magics->length && !magic; index++) {
+                    const struct DivisorMagic *OTHER = array_get(magics, index);
+
+                    magic = OTHER->divisor == divisor && OTHER->isSigned == isSigned &&
+                                    OTHER->preheader == loop->preheader
+                                ? OTHER
+                                : NULL;
+                }
+
+                if (!magic) { // The divisor dominates the loop, so is defined by the end of its preheader
+                    LLVMPositionBuilderBefore(builder, LLVMGetBasicBlockTerminator(loop->preheader));
+                    magic = divisor_buildMagic_(builder, divisor, isSigned);
+                    array_insert(magics, magics->length, magic);
+                }
+
+                LLVMPositionBuilderBefore(builder, instruction);
+                result = divisor_buildDivision_(builder, LLVMGetOperand(instruction, 0), magic);
+
+                if (opcode == LLVMSRem || opcode == LLVMURem) {
+                    result = LLVMBuildSub(builder, LLVMGetOperand(instruction, 0),
+                                          LLVMBuildMul(builder, result, divisor, ""), "");
+                }
+
+                LLVMReplaceAllUsesWith(instruction, result);
+                LLVMInstructionEraseFromParent(instruction);
+                changed = true;
+            }
+        }
+
+        for (size_t index = 0; index < magics->length; index++) {
+            free((void *)array_get(magics, index));
+        }
+
+        array_clear(magics, NULL);
+
+        if (graph) {
+            divisor_freeGraph_(&graph);
+        }
+    }
+
+    array_free(&magics);
+    LLVMDisposeBuilder(builder);
+
+    return changed;
+}
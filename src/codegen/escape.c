@@ -0,0 +1,351 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+#pragma once
+
+#include "../includes.c"
+
+#include <llvm-c/Core.h>
+
+#include "../utils/array.c"
+#include "../utils/panic.c"
+
+#define ESCAPE_MAX_SIZE 256       // Largest object moved to the stack
+#define ESCAPE_MAX_FRAME_SIZE 512 // Most memory moved to the stack per function, as tasks only have 256 KiB stacks
+#define ESCAPE_ALIGNMENT 16       // What malloc guarantees
+#define ESCAPE_RECURSIVE_ATTRIBUTE "exeme-recursive" // Set on functions in call cycles, before the module is split
+
+/**
+ * Gets whether a call is to a function with a name.
+ *
+ * @param call The call.
+ * @param NAME The name.
+ *
+ * @return Whether the call is to the function.
+ */
+bool escape_isCallTo_(LLVMValueRef call, const char *NAME) {
+    LLVMValueRef callee = LLVMIsACallInst(call) ? LLVMGetCalledValue(call) : NULL;
+
+    return callee && LLVMIsAFunction(callee) && strcmp(LLVMGetValueName(callee), NAME) == 0;
+}
+
+/**
+ * Gets whether a function has an attribute.
+ *
+ * @param function The function.
+ * @param index    The index of the attribute, LLVMAttributeFunctionIndex or
+ * a parameter's index + 1.
+ * @param NAME     The name of the attribute.
+ *
+ * @return Whether the function has the attribute.
+ */
+bool escape_hasAttribute_(LLVMValueRef function, LLVMAttributeIndex index, const char *NAME) {
+    return LLVMGetEnumAttributeAtIndex(function, index, LLVMGetEnumAttributeKindForName(NAME, strlen(NAME))) != NULL;
+}
+
+/**
+ * Gets whether a function can call another, directly or through other
+ * functions.
+ *
+ * @param function The function.
+ * @param target   The other function.
+ * @param visited  The functions already searched.
+ *
+ * @return Whether the function can call the other.
+ */
+bool escape_canReach_(LLVMValueRef function, LLVMValueRef target, struct Array *visited) {
+    for (size_t index = 0; index < visited->length; index++) {
+        if (array_get(visited, index) == function) {
+            return false;
+        }
+    }
+
+    array_insert(visited, visited->length, function);
+
+    for (LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function); block; block = LLVMGetNextBasicBlock(block)) {
+        for (LLVMValueRef instruction = LLVMGetFirstInstruction(block); instruction;
+             instruction = LLVMGetNextInstruction(instruction)) {
+            LLVMValueRef callee = LLVMIsACallInst(instruction) ? LLVMGetCalledValue(instruction) : NULL;
+
+            if (callee && LLVMIsAFunction(callee) && (callee == target || escape_canReach_(callee, target, visited))) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Gets whether a function is part of a call cycle, so can have any number
+ * of frames on the stack at once.
+ *
+ * @param function The function.
+ *
+ * @return Whether the function can call itself.
+ */
+bool escape_isRecursive_(LLVMValueRef function) {
+    struct Array *visited = array_new();
+    bool recursive = escape_canReach_(function, function, visited);
+
+    array_free(&visited);
+
+    return recursive;
+}
+
+/**
+ * Marks the functions in call cycles, while the whole program is still in
+ * one module. Once it is split, a codegen unit only holds some of the
+ * bodies, so cannot see cycles through the others.
+ *
+ * @param module The module.
+ */
+void escape_markRecursive(LLVMModuleRef module) {
+    LLVMContextRef context = LLVMGetModuleContext(module);
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+        if (LLVMGetFirstBasicBlock(function) && escape_isRecursive_(function)) {
+            LLVMAddAttributeAtIndex(function, LLVMAttributeFunctionIndex,
+                                    LLVMCreateStringAttribute(context, ESCAPE_RECURSIVE_ATTRIBUTE,
+                                                              (unsigned)strlen(ESCAPE_RECURSIVE_ATTRIBUTE), "", 0));
+        }
+    }
+}
+
+/**
+ * Gets whether a function makes a 'musttail' call. LLVM's C API only tells
+ * whether a call is a tail call, so those are told apart by how they print.
+ *
+ * @param function The function.
+ *
+ * @return Whether the function makes a 'musttail' call.
+ */
+bool escape_hasMustTailCall_(LLVMValueRef function) {
+    for (LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function); block; block = LLVMGetNextBasicBlock(block)) {
+        for (LLVMValueRef instruction = LLVMGetFirstInstruction(block); instruction;
+             instruction = LLVMGetNextInstruction(instruction)) {
+            char *printed = NULL, *start = NULL;
+            bool mustTail = false;
+
+            if (!LLVMIsACallInst(instruction) || !LLVMIsTailCall(instruction)) {
+                continue;
+            }
+
+            printed = LLVMPrintValueToString(instruction);
+            start = printed + strspn(printed, " ");
+
+            if (*start == '%' && strstr(start, " = ")) { // Skips the result's name
+                start = strstr(start, " = ") + 3;
+            }
+
+            mustTail = strncmp(start, "musttail ", 9) == 0;
+            LLVMDisposeMessage(printed);
+
+            if (mustTail) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Gets whether a pointer escapes, either outliving the function or being
+ * captured somewhere the function cannot see. Calls which free it are
+ * collected, as they go once the object is on the stack.
+ *
+ * @param pointer The pointer, or a pointer derived from it.
+ * @param frees   Where to collect the calls freeing it.
+ *
+ * @return Whether the pointer escapes.
+ */
+bool escape_isEscaping_(LLVMValueRef pointer, struct Array *frees) {
+    for (LLVMUseRef use = LLVMGetFirstUse(pointer); use; use = LLVMGetNextUse(use)) {
+        LLVMValueRef user = LLVMGetUser(use), callee = NULL;
+
+        switch (LLVMIsAInstruction(user) ? LLVMGetInstructionOpcode(user) : LLVMRet) {
+        case LLVMLoad:
+        case LLVMICmp:
+            break;
+        case LLVMStore:
+            if (LLVMGetOperand(user, 0) == pointer) { // Stores the pointer itself somewhere
+                return true;
+            }
+
+            break;
+        case LLVMGetElementPtr:
+        case LLVMBitCast:
+            if (escape_isEscaping_(user, frees)) {
+                return true;
+            }
+
+            break;
+        case LLVMCall:
+            callee = LLVMGetCalledValue(user);
+
+            if (!LLVMIsAFunction(callee) || callee == pointer) {
+                return true;
+            } else if (escape_isCallTo_(user, "free")) {
+                array_insert(frees, frees->length, user);
+                break;
+            } else if (strncmp(LLVMGetValueName(callee), "llvm.mem", 8) == 0 ||
+                       strncmp(LLVMGetValueName(callee), "llvm.lifetime", 13) == 0) {
+                break;
+            }
+
+            // Passed to a function, which must neither keep nor free it
+            for (unsigned index = 0; index < LLVMGetNumArgOperands(user); index++) {
+                if (LLVMGetOperand(user, index) == pointer &&
+                    (!escape_hasAttribute_(callee, index + 1, "nocapture") ||
+                     !escape_hasAttribute_(callee, LLVMAttributeFunctionIndex, "nofree"))) {
+                    return true;
+                }
+            }
+
+            break;
+        default: // Returned, merged with other pointers in a phi or select, or turned into an integer
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Gets the size of an allocation, if it is known at compile time.
+ *
+ * @param call The call to malloc or calloc.
+ *
+ * @return The size, or 0 if it is not known.
+ */
+unsigned long long escape_getSize_(LLVMValueRef call) {
+    unsigned long long size = 1;
+
+    for (unsigned index = 0; index < LLVMGetNumArgOperands(call); index++) {
+        LLVMValueRef argument = LLVMGetOperand(call, index);
+
+        if (!LLVMIsAConstantInt(argument)) {
+            return 0;
+        }
+
+        size *= LLVMConstIntGetZExtValue(argument);
+    }
+
+    return size;
+}
+
+/**
+ * Clears the 'tail' marker from a function's calls, as it promises the
+ * callee does not touch the caller's stack, which stops holding once an
+ * object passed to it is moved there.
+ *
+ * @param function The function.
+ */
+void escape_clearTailCalls_(LLVMValueRef function) {
+    for (LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function); block; block = LLVMGetNextBasicBlock(block)) {
+        for (LLVMValueRef instruction = LLVMGetFirstInstruction(block); instruction;
+             instruction = LLVMGetNextInstruction(instruction)) {
+            if (LLVMIsACallInst(instruction)) {
+                LLVMSetTailCall(instruction, false);
+            }
+        }
+    }
+}
+
+/**
+ * Moves heap objects which do not escape their function onto its stack.
+ * Calls to malloc and calloc with small constant sizes become allocas in
+ * the function's entry block, and the calls to free them are removed. Once
+ * on the stack, LLVM's scalar replacement can break them up into registers.
+ * Functions in call cycles are left alone, as their frames could pile up
+ * until they overflow a task's stack, so escape_markRecursive must have
+ * run on the whole program first. So are functions making 'musttail' calls,
+ * which must keep the marker and cannot be given the caller's stack.
+ *
+ * @param module The module.
+ *
+ * @return Whether anything was moved.
+ */
+bool escape_promote(LLVMModuleRef module) {
+    LLVMContextRef context = LLVMGetModuleContext(module);
+    LLVMBuilderRef builder = LLVMCreateBuilderInContext(context);
+    LLVMTypeRef int8 = LLVMInt8TypeInContext(context), int64 = LLVMInt64TypeInContext(context);
+    struct Array *frees = array_new();
+    bool changed = false;
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+        unsigned long long frameSize = 0;
+
+        if (!LLVMGetFirstBasicBlock(function) ||
+            LLVMGetStringAttributeAtIndex(function, LLVMAttributeFunctionIndex, ESCAPE_RECURSIVE_ATTRIBUTE,
+                                          (unsigned)strlen(ESCAPE_RECURSIVE_ATTRIBUTE)) ||
+            escape_hasMustTailCall_(function)) {
+            continue;
+        }
+
+        for (LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function); block; block = LLVMGetNextBasicBlock(block)) {
+            LLVMValueRef instruction = LLVMGetFirstInstruction(block), next = NULL;
+
+            for (; instruction; instruction = next) {
+                unsigned long long size = 0;
+                LLVMValueRef allocation = NULL, entryInstruction = NULL;
+                bool zeroed = escape_isCallTo_(instruction, "calloc");
+
+                next = LLVMGetNextInstruction(instruction);
+
+                if ((!zeroed && !escape_isCallTo_(instruction, "malloc")) || !(size = escape_getSize_(instruction)) ||
+                    size > ESCAPE_MAX_SIZE || frameSize + size > ESCAPE_MAX_FRAME_SIZE) {
+                    continue;
+                }
+
+                array_clear(frees, NULL);
+
+                if (escape_isEscaping_(instruction, frees)) {
+                    continue;
+                }
+
+                // In the entry block, so it is allocated once however often the call runs. Each run's pointer is
+                // dead by the next, as it cannot reach a phi.
+                entryInstruction = LLVMGetFirstInstruction(LLVMGetEntryBasicBlock(function));
+
+                while (entryInstruction && LLVMIsAAllocaInst(entryInstruction)) {
+                    entryInstruction = LLVMGetNextInstruction(entryInstruction);
+                }
+
+                LLVMPositionBuilderBefore(builder, entryInstruction);
+                allocation = LLVMBuildArrayAlloca(builder, int8, LLVMConstInt(int64, size, false), "");
+                LLVMSetAlignment(allocation, ESCAPE_ALIGNMENT);
+
+                if (zeroed) {
+                    LLVMPositionBuilderBefore(builder, instruction);
+                    LLVMBuildMemSet(builder, allocation, LLVMConstNull(int8), LLVMConstInt(int64, size, false),
+                                    ESCAPE_ALIGNMENT);
+                }
+
+                LLVMReplaceAllUsesWith(instruction, LLVMBuildBitCast(builder, allocation, LLVMTypeOf(instruction), ""));
+
+                for (size_t index = 0; index < frees->length; index++) {
+                    LLVMInstructionEraseFromParent((LLVMValueRef)array_get(frees, index));
+                }
+
+                next = LLVMGetNextInstruction(instruction);
+                LLVMInstructionEraseFromParent(instruction);
+
+                frameSize += size;
+            }
+        }
+
+        if (frameSize) {
+            escape_clearTailCalls_(function);
+            changed = true;
+        }
+    }
+
+    array_free(&frees);
+    LLVMDisposeBuilder(builder);
+
+    return changed;
+}
@@ -0,0 +1,1136 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+#pragma once
+
+#include "../includes.c"
+
+#include <stdint.h>
+
+#include <llvm-c/Core.h>
+#include <llvm-c/Target.h>
+
+#include "../utils/array.c"
+#include "../utils/panic.c"
+#include "../utils/string.c"
+#include "./split.c"
+
+#define EVALUATOR_MAX_STEPS 1000000  // Instructions run per evaluation
+#define EVALUATOR_MAX_MEMORY 1048576 // Bytes allocated per evaluation
+#define EVALUATOR_MAX_DEPTH 128      // Nested calls
+
+#define EVALUATOR_CONST_ATTRIBUTE "exeme-const" // Set on functions marked '@const'
+
+/**
+ * Represents memory the evaluator can load from and store to, either a
+ * global variable or a stack allocation.
+ */
+struct EvaluatorObject {
+    bool written;
+    LLVMValueRef global;
+    unsigned char *bytes;
+    size_t size;
+};
+
+#define EVALUATOROBJECT_STRUCT_SIZE sizeof(struct EvaluatorObject)
+
+/**
+ * Represents a value during evaluation, either an integer or a pointer to
+ * an offset in an object.
+ */
+struct EvaluatorValue {
+    struct EvaluatorObject *object;
+    uint64_t integer;
+};
+
+/**
+ * Represents the value of an instruction or argument in a call.
+ */
+struct EvaluatorBinding {
+    LLVMValueRef key;
+    struct EvaluatorValue value;
+};
+
+#define EVALUATORBINDING_STRUCT_SIZE sizeof(struct EvaluatorBinding)
+
+/**
+ * Represents a compile-time evaluator, an interpreter for LLVM IR which
+ * gives up on anything it cannot evaluate exactly, or which goes over its
+ * step and memory budgets.
+ */
+struct Evaluator {
+    bool storesGlobals;
+    LLVMTargetDataRef targetData;
+    struct Array *objects;
+    size_t memory, steps;
+};
+
+#define EVALUATOR_STRUCT_SIZE sizeof(struct Evaluator)
+
+/* Forward declarations to silence warnings */
+bool evaluator_call(struct Evaluator *self, LLVMValueRef function, const struct EvaluatorValue *arguments, size_t depth,
+                    struct EvaluatorValue *result);
+
+/**
+ * Creates a new Evaluator struct.
+ *
+ * @param module        The module to evaluate functions of.
+ * @param storesGlobals Whether evaluated code can store to global
+ * variables. If not, only functions without side effects can be evaluated.
+ *
+ * @return The created Evaluator struct.
+ */
+struct Evaluator *evaluator_new(LLVMModuleRef module, bool storesGlobals) {
+    struct Evaluator *self = malloc(EVALUATOR_STRUCT_SIZE);
+
+    if (!self) {
+        panic("failed to malloc Evaluator struct");
+    }
+
+    self->storesGlobals = storesGlobals;
+    self->targetData = LLVMGetModuleDataLayout(module);
+    self->objects = array_new();
+    self->memory = 0;
+    self->steps = 0;
+
+    return self;
+}
+
+/**
+ * Frees an Evaluator struct.
+ *
+ * @param self The current Evaluator struct.
+ */
+void evaluator_free(struct Evaluator **self) {
+    if (self && *self) {
+        for (size_t index = 0; index < (*self)->objects->length; index++) {
+            struct EvaluatorObject *object = (struct EvaluatorObject *)array_get((*self)->objects, index);
+
+            free(object->bytes);
+            free(object);
+        }
+
+        array_free(&(*self)->objects);
+
+        free(*self);
+        *self = NULL;
+    } else {
+        panic("Evaluator struct has already been freed");
+    }
+}
+
+/**
+ * Reserves memory from the evaluator's budget.
+ *
+ * @param self The current Evaluator struct.
+ * @param size The number of bytes.
+ *
+ * @return Whether the budget allows it.
+ */
+bool evaluator_reserve_(struct Evaluator *self, size_t size) {
+    self->memory += size;
+
+    return self->memory <= EVALUATOR_MAX_MEMORY;
+}
+
+/**
+ * Gets the width of an integer type.
+ *
+ * @param type The type.
+ *
+ * @return The width, or 0 if the type is not an integer the evaluator
+ * supports.
+ */
+unsigned evaluator_getWidth_(LLVMTypeRef type) {
+    unsigned width = LLVMGetTypeKind(type) == LLVMIntegerTypeKind ? LLVMGetIntTypeWidth(type) : 0;
+
+    return width <= 64 ? width : 0;
+}
+
+/**
+ * Truncates an integer to a width.
+ *
+ * @param integer The integer.
+ * @param width   The width.
+ *
+ * @return The truncated integer.
+ */
+uint64_t evaluator_truncate_(uint64_t integer, unsigned width) {
+    return width >= 64 ? integer : integer & ((1ULL << width) - 1);
+}
+
+/**
+ * Sign extends an integer from a width.
+ *
+ * @param integer The integer.
+ * @param width   The width.
+ *
+ * @return The sign extended integer.
+ */
+int64_t evaluator_signExtend_(uint64_t integer, unsigned width) {
+    return width >= 64 ? (int64_t)integer : (int64_t)(integer << (64 - width)) >> (64 - width);
+}
+
+/**
+ * Creates an object.
+ *
+ * @param self   The current Evaluator struct.
+ * @param global The global variable the object is for, or NULL for a stack
+ * allocation.
+ * @param size   The size of the object.
+ *
+ * @return The created object, or NULL if it would go over the budget.
+ */
+struct EvaluatorObject *evaluator_createObject_(struct Evaluator *self, LLVMValueRef global, size_t size) {
+    struct EvaluatorObject *object = NULL;
+
+    if (!evaluator_reserve_(self, size)) {
+        return NULL;
+    }
+
+    object = malloc(EVALUATOROBJECT_STRUCT_SIZE);
+
+    if (!object) {
+        panic("failed to malloc EvaluatorObject struct");
+    }
+
+    object->written = false;
+    object->global = global;
+    object->bytes = calloc(size ? size : 1, 1);
+    object->size = size;
+
+    if (!object->bytes) {
+        panic("failed to calloc evaluator object");
+    }
+
+    array_insert(self->objects, self->objects->length, object);
+
+    return object;
+}
+
+/**
+ * Writes a constant into memory.
+ *
+ * @param self     The current Evaluator struct.
+ * @param constant The constant.
+ * @param bytes    The memory, which must be zeroed.
+ *
+ * @return Whether the constant could be written.
+ */
+bool evaluator_writeConstant_(struct Evaluator *self, LLVMValueRef constant, unsigned char *bytes) {
+    LLVMTypeRef type = LLVMTypeOf(constant);
+    unsigned width = evaluator_getWidth_(type);
+
+    if (LLVMIsAConstantInt(constant) && width) {
+        uint64_t integer = LLVMConstIntGetZExtValue(constant);
+
+        for (unsigned long long index = 0; index < LLVMStoreSizeOfType(self->targetData, type); index++) {
+            bytes[index] = (unsigned char)(integer >> (index * 8));
+        }
+
+        return true;
+    } else if (LLVMIsNull(constant) && !LLVMIsUndef(constant)) { // Already zero
+        return true;
+    } else if (LLVMIsAConstantDataSequential(constant) && LLVMGetTypeKind(type) == LLVMArrayTypeKind) {
+        unsigned long long size = LLVMABISizeOfType(self->targetData, LLVMGetElementType(type));
+
+        for (unsigned index = 0; index < LLVMGetArrayLength(type); index++) {
+            if (!evaluator_writeConstant_(self, LLVMGetElementAsConstant(constant, index), bytes + index * size)) {
+                return false;
+            }
+        }
+
+        return true;
+    } else if (LLVMIsAConstantArray(constant)) {
+        unsigned long long size = LLVMABISizeOfType(self->targetData, LLVMGetElementType(type));
+
+        for (int index = 0; index < LLVMGetNumOperands(constant); index++) {
+            if (!evaluator_writeConstant_(self, LLVMGetOperand(constant, (unsigned)index), bytes + index * size)) {
+                return false;
+            }
+        }
+
+        return true;
+    } else if (LLVMIsAConstantStruct(constant)) {
+        for (int index = 0; index < LLVMGetNumOperands(constant); index++) {
+            if (!evaluator_writeConstant_(self, LLVMGetOperand(constant, (unsigned)index),
+                                          bytes + LLVMOffsetOfElement(self->targetData, type, (unsigned)index))) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    return false; // Floating point numbers, pointers and undefined values
+}
+
+/**
+ * Reads a constant from memory.
+ *
+ * @param self  The current Evaluator struct.
+ * @param type  The type of the constant.
+ * @param BYTES The memory.
+ *
+ * @return The constant, or NULL if it cannot be represented.
+ */
+LLVMValueRef evaluator_readConstant_(struct Evaluator *self, LLVMTypeRef type, const unsigned char *BYTES) {
+    unsigned long long size = LLVMStoreSizeOfType(self->targetData, type);
+    LLVMValueRef constant = NULL, *elements = NULL;
+    unsigned length = 0;
+
+    switch (LLVMGetTypeKind(type)) {
+    case LLVMIntegerTypeKind: {
+        uint64_t integer = 0;
+
+        if (!evaluator_getWidth_(type)) {
+            return NULL;
+        }
+
+        for (unsigned long long index = 0; index < size; index++) {
+            integer |= (uint64_t)BYTES[index] << (index * 8);
+        }
+
+        return LLVMConstInt(type, evaluator_truncate_(integer, LLVMGetIntTypeWidth(type)), false);
+    }
+    case LLVMArrayTypeKind:
+    case LLVMStructTypeKind:
+        length = LLVMGetTypeKind(type) == LLVMArrayTypeKind ? LLVMGetArrayLength(type) : LLVMCountStructElementTypes(type);
+        elements = calloc(length ? length : 1, sizeof(LLVMValueRef));
+
+        if (!elements) {
+            panic("failed to calloc constant elements");
+        }
+
+        for (unsigned index = 0; index < length; index++) {
+            if (LLVMGetTypeKind(type) == LLVMArrayTypeKind) {
+                elements[index] = evaluator_readConstant_(
+                    self, LLVMGetElementType(type),
+                    BYTES + index * LLVMABISizeOfType(self->targetData, LLVMGetElementType(type)));
+            } else {
+                elements[index] = evaluator_readConstant_(self, LLVMStructGetTypeAtIndex(type, index),
+                                                          BYTES + LLVMOffsetOfElement(self->targetData, type, index));
+            }
+
+            if (!elements[index]) {
+                free(elements);
+
+                return NULL;
+            }
+        }
+
+        if (LLVMGetTypeKind(type) == LLVMArrayTypeKind) {
+            constant = LLVMConstArray(LLVMGetElementType(type), elements, length);
+        } else if (LLVMGetStructName(type)) {
+            constant = LLVMConstNamedStruct(type, elements, length);
+        } else {
+            constant = LLVMConstStructInContext(LLVMGetTypeContext(type), elements, length, LLVMIsPackedStruct(type));
+        }
+
+        free(elements);
+
+        return constant;
+    default: // Never stored to, so only representable if it was zero
+        for (unsigned long long index = 0; index < size; index++) {
+            if (BYTES[index] != 0) {
+                return NULL;
+            }
+        }
+
+        return LLVMConstNull(type);
+    }
+}
+
+/**
+ * Gets the object for a global variable, creating it from the global
+ * variable's initializer the first time it is used.
+ *
+ * @param self   The current Evaluator struct.
+ * @param global The global variable.
+ *
+ * @return The object, or NULL if the global variable's value is not known
+ * at compile time.
+ */
+struct EvaluatorObject *evaluator_getGlobal_(struct Evaluator *self, LLVMValueRef global) {
+    struct EvaluatorObject *object = NULL;
+    LLVMLinkage linkage = LLVMGetLinkage(global);
+
+    for (size_t index = 0; index < self->objects->length; index++) {
+        object = (struct EvaluatorObject *)array_get(self->objects, index);
+
+        if (object->global == global) {
+            return object;
+        }
+    }
+
+    if (!LLVMGetInitializer(global) || LLVMIsThreadLocal(global) ||
+        (linkage != LLVMExternalLinkage && linkage != LLVMInternalLinkage &&
+         linkage != LLVMPrivateLinkage)) { // Could be replaced when linked
+        return NULL;
+    }
+
+    object = evaluator_createObject_(self, global, LLVMABISizeOfType(self->targetData, LLVMGlobalGetValueType(global)));
+
+    return object && evaluator_writeConstant_(self, LLVMGetInitializer(global), object->bytes) ? object : NULL;
+}
+
+/**
+ * Gets the value of an operand.
+ *
+ * @param self    The current Evaluator struct.
+ * @param frame   The bindings of the current call.
+ * @param operand The operand.
+ * @param depth   The depth of the current call.
+ * @param result  Where to store the value.
+ *
+ * @return Whether the value is known.
+ */
+bool evaluator_getValue_(struct Evaluator *self, struct Array *frame, LLVMValueRef operand, size_t depth,
+                         struct EvaluatorValue *result);
+
+/**
+ * Evaluates an instruction or constant expression.
+ *
+ * @param self   The current Evaluator struct.
+ * @param frame  The bindings of the current call.
+ * @param value  The instruction or constant expression.
+ * @param opcode The opcode of the value.
+ * @param depth  The depth of the current call.
+ * @param result Where to store the result.
+ *
+ * @return Whether the value could be evaluated.
+ */
+bool evaluator_evaluateOperation_(struct Evaluator *self, struct Array *frame, LLVMValueRef value, LLVMOpcode opcode,
+                                  size_t depth, struct EvaluatorValue *result) {
+    struct EvaluatorValue left = {NULL, 0}, right = {NULL, 0};
+    unsigned width = evaluator_getWidth_(LLVMTypeOf(value));
+
+    result->object = NULL;
+    result->integer = 0;
+
+    switch (opcode) {
+    case LLVMAdd:
+    case LLVMSub:
+    case LLVMMul:
+    case LLVMUDiv:
+    case LLVMSDiv:
+    case LLVMURem:
+    case LLVMSRem:
+    case LLVMShl:
+    case LLVMLShr:
+    case LLVMAShr:
+    case LLVMAnd:
+    case LLVMOr:
+    case LLVMXor: {
+        int64_t signedLeft = 0, signedRight = 0;
+
+        if (!width || !evaluator_getValue_(self, frame, LLVMGetOperand(value, 0), depth, &left) ||
+            !evaluator_getValue_(self, frame, LLVMGetOperand(value, 1), depth, &right) || left.object || right.object) {
+            return false;
+        }
+
+        signedLeft = evaluator_signExtend_(left.integer, width);
+        signedRight = evaluator_signExtend_(right.integer, width);
+
+        if (((opcode == LLVMUDiv || opcode == LLVMURem || opcode == LLVMSDiv || opcode == LLVMSRem) &&
+             right.integer == 0) ||
+            ((opcode == LLVMSDiv || opcode == LLVMSRem) && signedRight == -1 &&
+             left.integer == evaluator_truncate_(1ULL << (width - 1), width)) || // Overflows
+            ((opcode == LLVMShl || opcode == LLVMLShr || opcode == LLVMAShr) && right.integer >= width)) { // Poison
+            return false;
+        }
+
+        switch (opcode) {
+        case LLVMAdd:
+            result->integer = left.integer + right.integer;
+            break;
+        case LLVMSub:
+            result->integer = left.integer - right.integer;
+            break;
+        case LLVMMul:
+            result->integer = left.integer * right.integer;
+            break;
+        case LLVMUDiv:
+            result->integer = left.integer / right.integer;
+            break;
+        case LLVMSDiv:
+            result->integer = (uint64_t)(signedLeft / signedRight);
+            break;
+        case LLVMURem:
+            result->integer = left.integer % right.integer;
+            break;
+        case LLVMSRem:
+            result->integer = (uint64_t)(signedLeft % signedRight);
+            break;
+        case LLVMShl:
+            result->integer = left.integer << right.integer;
+            break;
+        case LLVMLShr:
+            result->integer = left.integer >> right.integer;
+            break;
+        case LLVMAShr:
+            result->integer = (uint64_t)(signedLeft >> right.integer);
+            break;
+        case LLVMAnd:
+            result->integer = left.integer & right.integer;
+            break;
+        case LLVMOr:
+            result->integer = left.integer | right.integer;
+            break;
+        default:
+            result->integer = left.integer ^ right.integer;
+            break;
+        }
+
+        result->integer = evaluator_truncate_(result->integer, width);
+
+        return true;
+    }
+    case LLVMICmp: {
+        LLVMIntPredicate predicate = LLVMGetICmpPredicate(value);
+        unsigned operandWidth = 0;
+        int64_t signedLeft = 0, signedRight = 0;
+
+        if (!evaluator_getValue_(self, frame, LLVMGetOperand(value, 0), depth, &left) ||
+            !evaluator_getValue_(self, frame, LLVMGetOperand(value, 1), depth, &right)) {
+            return false;
+        }
+
+        if (left.object || right.object) { // Pointers can only be compared for equality within an object
+            if (left.object != right.object || (predicate != LLVMIntEQ && predicate != LLVMIntNE)) {
+                return false;
+            }
+
+            result->integer = (left.integer == right.integer) == (predicate == LLVMIntEQ);
+
+            return true;
+        }
+
+        operandWidth = evaluator_getWidth_(LLVMTypeOf(LLVMGetOperand(value, 0)));
+        signedLeft = evaluator_signExtend_(left.integer, operandWidth ? operandWidth : 64);
+        signedRight = evaluator_signExtend_(right.integer, operandWidth ? operandWidth : 64);
+
+        switch (predicate) {
+        case LLVMIntEQ:
+            result->integer = left.integer == right.integer;
+            break;
+        case LLVMIntNE:
+            result->integer = left.integer != right.integer;
+            break;
+        case LLVMIntUGT:
+            result->integer = left.integer > right.integer;
+            break;
+        case LLVMIntUGE:
+            result->integer = left.integer >= right.integer;
+            break;
+        case LLVMIntULT:
+            result->integer = left.integer < right.integer;
+            break;
+        case LLVMIntULE:
+            result->integer = left.integer <= right.integer;
+            break;
+        case LLVMIntSGT:
+            result->integer = signedLeft > signedRight;
+            break;
+        case LLVMIntSGE:
+            result->integer = signedLeft >= signedRight;
+            break;
+        case LLVMIntSLT:
+            result->integer = signedLeft < signedRight;
+            break;
+        default:
+            result->integer = signedLeft <= signedRight;
+            break;
+        }
+
+        return true;
+    }
+    case LLVMSelect:
+        if (!evaluator_getValue_(self, frame, LLVMGetOperand(value, 0), depth, &left)) {
+            return false;
+        }
+
+        return evaluator_getValue_(self, frame, LLVMGetOperand(value, left.integer ? 1 : 2), depth, result);
+    case LLVMZExt:
+    case LLVMSExt:
+    case LLVMTrunc: {
+        unsigned operandWidth = evaluator_getWidth_(LLVMTypeOf(LLVMGetOperand(value, 0)));
+
+        if (!width || !operandWidth || !evaluator_getValue_(self, frame, LLVMGetOperand(value, 0), depth, &left) ||
+            left.object) {
+            return false;
+        }
+
+        result->integer = evaluator_truncate_(
+            opcode == LLVMSExt ? (uint64_t)evaluator_signExtend_(left.integer, operandWidth) : left.integer, width);
+
+        return true;
+    }
+    case LLVMBitCast: // Only between pointers, as memory holds no other bit casts' types
+        if (LLVMGetTypeKind(LLVMTypeOf(value)) != LLVMPointerTypeKind) {
+            return false;
+        }
+
+        return evaluator_getValue_(self, frame, LLVMGetOperand(value, 0), depth, result);
+    case LLVMGetElementPtr: {
+        LLVMTypeRef type = LLVMGetGEPSourceElementType(value);
+
+        if (!evaluator_getValue_(self, frame, LLVMGetOperand(value, 0), depth, result) || !result->object) {
+            return false;
+        }
+
+        for (int index = 1; index < LLVMGetNumOperands(value); index++) {
+            LLVMValueRef operand = LLVMGetOperand(value, (unsigned)index);
+            unsigned operandWidth = evaluator_getWidth_(LLVMTypeOf(operand));
+
+            if (!operandWidth || !evaluator_getValue_(self, frame, operand, depth, &left)) {
+                return false;
+            }
+
+            if (index == 1) { // Steps over the pointer itself
+                result->integer += (uint64_t)evaluator_signExtend_(left.integer, operandWidth) *
+                                   LLVMABISizeOfType(self->targetData, type);
+            } else if (LLVMGetTypeKind(type) == LLVMArrayTypeKind) {
+                type = LLVMGetElementType(type);
+                result->integer += (uint64_t)evaluator_signExtend_(left.integer, operandWidth) *
+                                   LLVMABISizeOfType(self->targetData, type);
+            } else if (LLVMGetTypeKind(type) == LLVMStructTypeKind) {
+                result->integer += LLVMOffsetOfElement(self->targetData, type, (unsigned)left.integer);
+                type = LLVMStructGetTypeAtIndex(type, (unsigned)left.integer);
+            } else {
+                return false;
+            }
+        }
+
+        return true;
+    }
+    case LLVMAlloca: {
+        LLVMTypeRef type = LLVMGetAllocatedType(value);
+
+        if (!evaluator_getValue_(self, frame, LLVMGetOperand(value, 0), depth, &left) || left.object) {
+            return false;
+        }
+
+        result->object = evaluator_createObject_(self, NULL, LLVMABISizeOfType(self->targetData, type) * left.integer);
+
+        return result->object != NULL;
+    }
+    case LLVMLoad:
+    case LLVMStore: {
+        LLVMTypeRef type = LLVMTypeOf(opcode == LLVMLoad ? value : LLVMGetOperand(value, 0));
+        unsigned long long size = LLVMStoreSizeOfType(self->targetData, type);
+        struct EvaluatorObject *object = NULL;
+
+        if (!evaluator_getWidth_(type) || LLVMGetVolatile(value) ||
+            !evaluator_getValue_(self, frame, LLVMGetOperand(value, opcode == LLVMLoad ? 0 : 1), depth, &right) ||
+            !(object = right.object) || right.integer > object->size || size > object->size - right.integer) {
+            return false;
+        }
+
+        if (opcode == LLVMLoad) {
+            if (object->global && !LLVMIsGlobalConstant(object->global) && !self->storesGlobals) { // Could have changed
+                return false;
+            }
+
+            for (unsigned long long index = 0; index < size; index++) {
+                result->integer |= (uint64_t)object->bytes[right.integer + index] << (index * 8);
+            }
+
+            result->integer = evaluator_truncate_(result->integer, evaluator_getWidth_(type));
+
+            return true;
+        }
+
+        if ((object->global && (!self->storesGlobals || LLVMIsGlobalConstant(object->global))) ||
+            !evaluator_getValue_(self, frame, LLVMGetOperand(value, 0), depth, &left) || left.object) {
+            return false;
+        }
+
+        for (unsigned long long index = 0; index < size; index++) {
+            object->bytes[right.integer + index] = (unsigned char)(left.integer >> (index * 8));
+        }
+
+        object->written = true;
+
+        return true;
+    }
+    case LLVMCall: {
+        LLVMValueRef callee = LLVMGetCalledValue(value);
+        unsigned argumentsLength = LLVMGetNumArgOperands(value);
+        struct EvaluatorValue *arguments = NULL;
+        bool success = false;
+
+        if (!LLVMIsAFunction(callee) || !split_isDefined(callee) || LLVMGetFunctionCallConv(callee) != LLVMCCallConv ||
+            LLVMIsFunctionVarArg(LLVMGlobalGetValueType(callee))) {
+            return false;
+        }
+
+        arguments = calloc(argumentsLength ? argumentsLength : 1, sizeof(struct EvaluatorValue));
+
+        if (!arguments) {
+            panic("failed to calloc evaluator arguments");
+        }
+
+        success = true;
+
+        for (unsigned index = 0; index < argumentsLength && success; index++) {
+            success = evaluator_getValue_(self, frame, LLVMGetOperand(value, index), depth, &arguments[index]);
+        }
+
+        success = success && evaluator_call(self, callee, arguments, depth + 1, result);
+
+        free(arguments);
+
+        return success;
+    }
+    default:
+        return false;
+    }
+}
+
+bool evaluator_getValue_(struct Evaluator *self, struct Array *frame, LLVMValueRef operand, size_t depth,
+                         struct EvaluatorValue *result) {
+    result->object = NULL;
+    result->integer = 0;
+
+    if (LLVMIsAConstantInt(operand)) {
+        if (!evaluator_getWidth_(LLVMTypeOf(operand))) {
+            return false;
+        }
+
+        result->integer = LLVMConstIntGetZExtValue(operand);
+
+        return true;
+    } else if (LLVMIsAConstantPointerNull(operand)) {
+        return true;
+    } else if (LLVMIsAGlobalVariable(operand)) {
+        return (result->object = evaluator_getGlobal_(self, operand)) != NULL;
+    } else if (LLVMIsAConstantExpr(operand)) {
+        return evaluator_evaluateOperation_(self, frame, operand, LLVMGetConstOpcode(operand), depth, result);
+    } else if (LLVMIsAInstruction(operand) || LLVMIsAArgument(operand)) {
+        for (size_t index = 0; index < frame->length; index++) {
+            const struct EvaluatorBinding *BINDING = array_get(frame, index);
+
+            if (BINDING->key == operand) {
+                *result = BINDING->value;
+
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Binds a value to an instruction or argument in a call.
+ *
+ * @param self  The current Evaluator struct.
+ * @param frame The bindings of the call.
+ * @param key   The instruction or argument.
+ * @param VALUE The value.
+ *
+ * @return Whether the budget allows it.
+ */
+bool evaluator_bind_(struct Evaluator *self, struct Array *frame, LLVMValueRef key, const struct EvaluatorValue VALUE) {
+    struct EvaluatorBinding *binding = NULL;
+
+    for (size_t index = 0; index < frame->length; index++) {
+        binding = (struct EvaluatorBinding *)array_get(frame, index);
+
+        if (binding->key == key) { // Run again in a loop
+            binding->value = VALUE;
+
+            return true;
+        }
+    }
+
+    if (!evaluator_reserve_(self, EVALUATORBINDING_STRUCT_SIZE)) {
+        return false;
+    }
+
+    binding = malloc(EVALUATORBINDING_STRUCT_SIZE);
+
+    if (!binding) {
+        panic("failed to malloc EvaluatorBinding struct");
+    }
+
+    binding->key = key;
+    binding->value = VALUE;
+
+    array_insert(frame, frame->length, binding);
+
+    return true;
+}
+
+/**
+ * Evaluates the phi nodes at the start of a block, all at once as they can
+ * refer to each other.
+ *
+ * @param self     The current Evaluator struct.
+ * @param frame    The bindings of the current call.
+ * @param block    The block.
+ * @param previous The block run before it.
+ * @param depth    The depth of the current call.
+ *
+ * @return Whether the phi nodes could be evaluated.
+ */
+bool evaluator_evaluatePhis_(struct Evaluator *self, struct Array *frame, LLVMBasicBlockRef block,
+                             LLVMBasicBlockRef previous, size_t depth) {
+    size_t phisLength = 0, phiIndex = 0;
+    struct EvaluatorValue *values = NULL;
+    bool success = true;
+
+    for (LLVMValueRef phi = LLVMGetFirstInstruction(block); phi && LLVMIsAPHINode(phi); phi = LLVMGetNextInstruction(phi)) {
+        phisLength++;
+    }
+
+    if (phisLength == 0) {
+        return true;
+    }
+
+    values = calloc(phisLength, sizeof(struct EvaluatorValue));
+
+    if (!values) {
+        panic("failed to calloc evaluator phi values");
+    }
+
+    for (LLVMValueRef phi = LLVMGetFirstInstruction(block); phi && LLVMIsAPHINode(phi) && success;
+         phi = LLVMGetNextInstruction(phi), phiIndex++) {
+        success = false;
+
+        for (unsigned index = 0; index < LLVMCountIncoming(phi) && !success; index++) {
+            if (LLVMGetIncomingBlock(phi, index) == previous) {
+                success = evaluator_getValue_(self, frame, LLVMGetIncomingValue(phi, index), depth, &values[phiIndex]);
+                break;
+            }
+        }
+    }
+
+    phiIndex = 0;
+
+    for (LLVMValueRef phi = LLVMGetFirstInstruction(block); phi && LLVMIsAPHINode(phi) && success;
+         phi = LLVMGetNextInstruction(phi), phiIndex++) {
+        success = evaluator_bind_(self, frame, phi, values[phiIndex]);
+    }
+
+    free(values);
+
+    return success;
+}
+
+/**
+ * Runs the body of a function.
+ *
+ * @param self     The current Evaluator struct.
+ * @param frame    The bindings of the call, with the arguments bound.
+ * @param function The function.
+ * @param depth    The depth of the call.
+ * @param result   Where to store the returned value.
+ *
+ * @return Whether the function could be evaluated.
+ */
+bool evaluator_run_(struct Evaluator *self, struct Array *frame, LLVMValueRef function, size_t depth,
+                    struct EvaluatorValue *result) {
+    LLVMBasicBlockRef block = LLVMGetEntryBasicBlock(function), previous = NULL;
+
+    while (block) {
+        LLVMBasicBlockRef next = NULL;
+        struct EvaluatorValue value = {NULL, 0};
+
+        if (previous && !evaluator_evaluatePhis_(self, frame, block, previous, depth)) {
+            return false;
+        }
+
+        for (LLVMValueRef instruction = LLVMGetFirstInstruction(block); instruction && !next;
+             instruction = LLVMGetNextInstruction(instruction)) {
+            LLVMOpcode opcode = LLVMGetInstructionOpcode(instruction);
+
+            if (++self->steps > EVALUATOR_MAX_STEPS) {
+                return false;
+            }
+
+            switch (opcode) {
+            case LLVMPHI:
+                break;
+            case LLVMBr:
+                if (!LLVMIsConditional(instruction)) {
+                    next = LLVMGetSuccessor(instruction, 0);
+                } else if (evaluator_getValue_(self, frame, LLVMGetCondition(instruction), depth, &value)) {
+                    next = LLVMGetSuccessor(instruction, value.integer ? 0 : 1);
+                } else {
+                    return false;
+                }
+
+                break;
+            case LLVMSwitch:
+                if (!evaluator_getValue_(self, frame, LLVMGetOperand(instruction, 0), depth, &value)) {
+                    return false;
+                }
+
+                next = LLVMGetSwitchDefaultDest(instruction);
+
+                // Operands are the condition and default, followed by a value and destination for each case
+                for (unsigned index = 1; index < LLVMGetNumSuccessors(instruction); index++) {
+                    if (LLVMConstIntGetZExtValue(LLVMGetOperand(instruction, index * 2)) == value.integer) {
+                        next = LLVMGetSuccessor(instruction, index);
+                        break;
+                    }
+                }
+
+                break;
+            case LLVMRet:
+                if (LLVMGetNumOperands(instruction) == 0) {
+                    result->object = NULL;
+                    result->integer = 0;
+
+                    return true;
+                }
+
+                return evaluator_getValue_(self, frame, LLVMGetOperand(instruction, 0), depth, result);
+            default:
+                if (!evaluator_evaluateOperation_(self, frame, instruction, opcode, depth, &value) ||
+                    !evaluator_bind_(self, frame, instruction, value)) {
+                    return false;
+                }
+
+                break;
+            }
+        }
+
+        if (!next) { // Fell off the end of the block, or hit 'unreachable'
+            return false;
+        }
+
+        previous = block;
+        block = next;
+    }
+
+    return false;
+}
+
+/**
+ * Evaluates a call to a function.
+ *
+ * @param self      The current Evaluator struct.
+ * @param function  The function.
+ * @param arguments The arguments.
+ * @param depth     The depth of the call, 0 for the outermost.
+ * @param result    Where to store the returned value.
+ *
+ * @return Whether the call could be evaluated.
+ */
+bool evaluator_call(struct Evaluator *self, LLVMValueRef function, const struct EvaluatorValue *arguments, size_t depth,
+                    struct EvaluatorValue *result) {
+    struct Array *frame = NULL;
+    bool success = true;
+
+    if (depth > EVALUATOR_MAX_DEPTH || !split_isDefined(function)) {
+        return false;
+    }
+
+    frame = array_new();
+
+    for (unsigned index = 0; index < LLVMCountParams(function) && success; index++) {
+        success = evaluator_bind_(self, frame, LLVMGetParam(function, index), arguments[index]);
+    }
+
+    success = success && evaluator_run_(self, frame, function, depth, result);
+
+    for (size_t index = 0; index < frame->length; index++) {
+        free((void *)array_get(frame, index));
+    }
+
+    self->memory -= frame->length * EVALUATORBINDING_STRUCT_SIZE;
+
+    array_free(&frame);
+
+    return success;
+}
+
+/**
+ * Gets whether a function is marked '@const', so must be evaluated at
+ * compile time when called with constant arguments.
+ *
+ * @param function The function.
+ *
+ * @return Whether the function is marked '@const'.
+ */
+bool evaluator_isConst(LLVMValueRef function) {
+    return LLVMGetStringAttributeAtIndex(function, LLVMAttributeFunctionIndex, EVALUATOR_CONST_ATTRIBUTE,
+                                         strlen(EVALUATOR_CONST_ATTRIBUTE)) != NULL;
+}
+
+/**
+ * Replaces calls which only have constant arguments with their results,
+ * when the functions called are pure: they only read constant global
+ * variables, store to nothing but their own stack, and only call other pure
+ * functions. Purity is found by evaluating the call, so functions do not
+ * have to be marked '@const', though those which are must be evaluated.
+ *
+ * @param module The module.
+ */
+void evaluator_foldCalls(LLVMModuleRef module) {
+    if (LLVMByteOrder(LLVMGetModuleDataLayout(module)) != LLVMLittleEndian) { // Memory is laid out little endian
+        return;
+    }
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+        for (LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function); block; block = LLVMGetNextBasicBlock(block)) {
+            LLVMValueRef instruction = LLVMGetFirstInstruction(block), next = NULL;
+
+            for (; instruction; instruction = next) {
+                LLVMValueRef callee = NULL;
+                struct Evaluator *evaluator = NULL;
+                struct EvaluatorValue *arguments = NULL, result = {NULL, 0};
+                unsigned argumentsLength = 0;
+                bool constant = true, success = false;
+
+                next = LLVMGetNextInstruction(instruction);
+
+                if (!LLVMIsACallInst(instruction) || !(callee = LLVMGetCalledValue(instruction)) ||
+                    !LLVMIsAFunction(callee) || !split_isDefined(callee) ||
+                    !evaluator_getWidth_(LLVMTypeOf(instruction))) {
+                    continue;
+                }
+
+                argumentsLength = LLVMGetNumArgOperands(instruction);
+
+                for (unsigned index = 0; index < argumentsLength && constant; index++) {
+                    constant = LLVMIsAConstantInt(LLVMGetOperand(instruction, index)) != NULL;
+                }
+
+                if (!constant) {
+                    continue;
+                }
+
+                evaluator = evaluator_new(module, false);
+                arguments = calloc(argumentsLength ? argumentsLength : 1, sizeof(struct EvaluatorValue));
+
+                if (!arguments) {
+                    panic("failed to calloc evaluator arguments");
+                }
+
+                for (unsigned index = 0; index < argumentsLength; index++) {
+                    arguments[index].integer = LLVMConstIntGetZExtValue(LLVMGetOperand(instruction, index));
+                }
+
+                success = evaluator_call(evaluator, callee, arguments, 0, &result) && !result.object;
+
+                if (success) {
+                    LLVMReplaceAllUsesWith(instruction, LLVMConstInt(LLVMTypeOf(instruction), result.integer, false));
+                    LLVMInstructionEraseFromParent(instruction);
+                } else if (evaluator_isConst(callee)) {
+                    panic(stringConcatenate(3, "failed to evaluate call to '@const' function '", LLVMGetValueName(callee),
+                                            "' at compile time"));
+                }
+
+                free(arguments);
+                evaluator_free(&evaluator);
+            }
+        }
+    }
+}
+
+/**
+ * Evaluates a module's global constructors at compile time, so tables
+ * they fill in are built into the program rather than computed when it
+ * starts. Constructors run in order of priority, and are evaluated up to
+ * the first which cannot be, so any that are left still run in order.
+ *
+ * @param module The module.
+ */
+void evaluator_evaluateConstructors(LLVMModuleRef module) {
+    LLVMValueRef constructors = LLVMGetNamedGlobal(module, "llvm.global_ctors"), initializer = NULL, *remaining = NULL;
+    size_t *order = NULL;
+    unsigned length = 0, remainingLength = 0;
+
+    if (!constructors || !(initializer = LLVMGetInitializer(constructors)) || !LLVMIsAConstantArray(initializer) ||
+        LLVMByteOrder(LLVMGetModuleDataLayout(module)) != LLVMLittleEndian) {
+        return;
+    }
+
+    length = (unsigned)LLVMGetNumOperands(initializer);
+    order = calloc(length ? length : 1, sizeof(size_t));
+    remaining = calloc(length ? length : 1, sizeof(LLVMValueRef));
+
+    if (!order || !remaining) {
+        panic("failed to calloc global constructors");
+    }
+
+    for (unsigned index = 0; index < length; index++) { // Stable insertion sort by priority
+        uint64_t priority = LLVMConstIntGetZExtValue(LLVMGetOperand(LLVMGetOperand(initializer, index), 0));
+        unsigned position = index;
+
+        while (position > 0 &&
+               LLVMConstIntGetZExtValue(LLVMGetOperand(LLVMGetOperand(initializer, order[position - 1]), 0)) >
+                   priority) {
+            order[position] = order[position - 1];
+            position--;
+        }
+
+        order[position] = index;
+    }
+
+    for (unsigned index = 0; index < length; index++) {
+        LLVMValueRef entry = LLVMGetOperand(initializer, order[index]), function = LLVMGetOperand(entry, 1);
+        struct Evaluator *evaluator = evaluator_new(module, true);
+        struct EvaluatorValue result = {NULL, 0};
+        LLVMValueRef *values = NULL;
+        bool success = LLVMIsAFunction(function) && LLVMCountParams(function) == 0 &&
+                       evaluator_call(evaluator, function, NULL, 0, &result);
+
+        values = calloc(evaluator->objects->length ? evaluator->objects->length : 1, sizeof(LLVMValueRef));
+
+        if (!values) {
+            panic("failed to calloc global initializers");
+        }
+
+        for (size_t objectIndex = 0; objectIndex < evaluator->objects->length && success; objectIndex++) {
+            const struct EvaluatorObject *OBJECT = array_get(evaluator->objects, objectIndex);
+
+            if (OBJECT->global && OBJECT->written) {
+                success = (values[objectIndex] = evaluator_readConstant_(
+                               evaluator, LLVMGlobalGetValueType(OBJECT->global), OBJECT->bytes)) != NULL;
+            }
+        }
+
+        if (success) { // Only commits once every global variable the constructor wrote to can be represented
+            for (size_t objectIndex = 0; objectIndex < evaluator->objects->length; objectIndex++) {
+                if (values[objectIndex]) {
+                    LLVMSetInitializer(
+                        ((const struct EvaluatorObject *)array_get(evaluator->objects, objectIndex))->global,
+                        values[objectIndex]);
+                }
+            }
+        }
+
+        free(values);
+        evaluator_free(&evaluator);
+
+        if (!success) {
+            for (; index < length; index++) {
+                remaining[remainingLength++] = LLVMGetOperand(initializer, order[index]);
+            }
+
+            break;
+        }
+    }
+
+    if (remainingLength < length) {
+        LLVMTypeRef entryType = LLVMGetElementType(LLVMTypeOf(initializer));
+
+        LLVMDeleteGlobal(constructors);
+
+        if (remainingLength > 0) {
+            constructors = LLVMAddGlobal(module, LLVMArrayType(entryType, remainingLength), "llvm.global_ctors");
+            LLVMSetInitializer(constructors, LLVMConstArray(entryType, remaining, remainingLength));
+            LLVMSetLinkage(constructors, LLVMAppendingLinkage);
+        }
+    }
+
+    free(order);
+    free(remaining);
+}
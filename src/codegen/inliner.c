@@ -0,0 +1,236 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+#pragma once
+
+#include "../includes.c"
+
+#include <llvm-c/Core.h>
+#include <llvm-c/Transforms/IPO.h>
+
+#include "../utils/array.c"
+#include "../utils/conversions.c"
+#include "../utils/string.c"
+#include "./coroutine.c"
+#include "./split.c"
+
+#define INLINER_THRESHOLD 50        // Most a call can cost to be inlined
+#define INLINER_CALL_BONUS 5        // Saved by not making the call
+#define INLINER_CONSTANT_BONUS 10   // Per constant argument, as they let the body be specialised
+#define INLINER_LAST_CALL_BONUS 100 // When the only call to a local function goes, so does the function
+#define INLINER_HOT_BONUS 40        // When the profile shows the callee is among the hottest functions
+#define INLINER_COLD_PENALTY 40     // When the profile shows the call never ran, so inlining would only grow the code
+
+#define INLINER_INLINE_ATTRIBUTE "exeme-inline" // Set on functions marked '@inline'
+
+/**
+ * Gets whether a function has an attribute.
+ *
+ * @param function The function.
+ * @param NAME     The name of the attribute.
+ *
+ * @return Whether the function has the attribute.
+ */
+bool inliner_hasAttribute_(LLVMValueRef function, const char *NAME) {
+    return LLVMGetEnumAttributeAtIndex(function, LLVMAttributeFunctionIndex,
+                                       LLVMGetEnumAttributeKindForName(NAME, strlen(NAME))) != NULL ||
+           LLVMGetStringAttributeAtIndex(function, LLVMAttributeFunctionIndex, NAME, (unsigned)strlen(NAME)) != NULL;
+}
+
+/**
+ * Gets the function a call is to.
+ *
+ * @param instruction The instruction.
+ *
+ * @return The function, or NULL if the instruction is not a direct call to
+ * a function with a body.
+ */
+LLVMValueRef inliner_getCallee_(LLVMValueRef instruction) {
+    LLVMValueRef callee = LLVMIsACallInst(instruction) ? LLVMGetCalledValue(instruction) : NULL;
+
+    return callee && LLVMIsAFunction(callee) && split_isDefined(callee) ? callee : NULL;
+}
+
+/**
+ * Gets whether a function can call another, directly or through other
+ * functions.
+ *
+ * @param function The function.
+ * @param target   The other function.
+ * @param visited  The functions already searched.
+ *
+ * @return Whether the function can call the other.
+ */
+bool inliner_canReach_(LLVMValueRef function, LLVMValueRef target, struct Array *visited) {
+    for (size_t index = 0; index < visited->length; index++) {
+        if (array_get(visited, index) == function) {
+            return false;
+        }
+    }
+
+    array_insert(visited, visited->length, function);
+
+    for (LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function); block; block = LLVMGetNextBasicBlock(block)) {
+        for (LLVMValueRef instruction = LLVMGetFirstInstruction(block); instruction;
+             instruction = LLVMGetNextInstruction(instruction)) {
+            LLVMValueRef callee = inliner_getCallee_(instruction);
+
+            if (callee && (callee == target || inliner_canReach_(callee, target, visited))) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Gets the size of a function, in instructions.
+ *
+ * @param function The function.
+ *
+ * @return The size.
+ */
+long inliner_getSize_(LLVMValueRef function) {
+    long size = 0;
+
+    for (LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function); block; block = LLVMGetNextBasicBlock(block)) {
+        for (LLVMValueRef instruction = LLVMGetFirstInstruction(block); instruction;
+             instruction = LLVMGetNextInstruction(instruction)) {
+            size++;
+        }
+    }
+
+    return size;
+}
+
+/**
+ * Decides whether to inline a call.
+ *
+ * @param call   The call.
+ * @param callee The function called.
+ * @param reason Where to store the reason for the decision.
+ *
+ * @return Whether to inline the call.
+ */
+bool inliner_decide_(LLVMValueRef call, LLVMValueRef callee, char **reason) {
+    LLVMValueRef caller = LLVMGetBasicBlockParent(LLVMGetInstructionParent(call));
+    struct Array *visited = NULL;
+    long cost = inliner_getSize_(callee) - INLINER_CALL_BONUS;
+    unsigned constants = 0;
+    bool recursive = false;
+    const char *profile = "";
+
+    if (inliner_hasAttribute_(callee, "noinline")) {
+        *reason = "marked '@noinline'";
+
+        return false;
+    } else if (LLVMIsFunctionVarArg(LLVMGlobalGetValueType(callee))) {
+        *reason = "takes variable arguments";
+
+        return false;
+    }
+
+    visited = array_new();
+    recursive = callee == caller || inliner_canReach_(callee, caller, visited);
+    array_free(&visited);
+
+    if (recursive) { // Inlining would never finish
+        *reason = "recursive";
+
+        return false;
+    } else if (inliner_hasAttribute_(callee, INLINER_INLINE_ATTRIBUTE)) {
+        *reason = "marked '@inline'";
+
+        return true;
+    } else if (coroutine_isCoroutine(callee)) { // Inlined once LLVM splits it, see 'coroutine_addPasses'
+        *reason = "'async func', so its frame can be allocated in the caller's";
+
+        return true;
+    }
+
+    for (unsigned index = 0; index < LLVMGetNumArgOperands(call); index++) {
+        constants += LLVMIsAConstant(LLVMGetOperand(call, index)) != NULL;
+    }
+
+    cost -= (long)constants * INLINER_CONSTANT_BONUS;
+
+    // Set by 'profile_apply' from the profile's entry counts
+    if (inliner_hasAttribute_(caller, "cold") || inliner_hasAttribute_(callee, "cold")) {
+        cost += INLINER_COLD_PENALTY;
+        profile = ", never ran when profiled";
+    } else if (inliner_hasAttribute_(callee, "hot")) {
+        cost -= INLINER_HOT_BONUS;
+        profile = ", hot when profiled";
+    }
+
+    if ((LLVMGetLinkage(callee) == LLVMInternalLinkage || LLVMGetLinkage(callee) == LLVMPrivateLinkage) &&
+        LLVMGetFirstUse(callee) && !LLVMGetNextUse(LLVMGetFirstUse(callee))) {
+        cost -= INLINER_LAST_CALL_BONUS;
+    }
+
+    *reason = stringConcatenate(7, "cost ", cost < 0 ? "-" : "", ulToString((unsigned long)labs(cost)),
+                                cost <= INLINER_THRESHOLD ? " <= threshold " : " > threshold ",
+                                ulToString(INLINER_THRESHOLD),
+                                constants ? stringConcatenate(3, ", ", ulToString(constants), " constant arguments")
+                                          : "",
+                                profile);
+
+    return cost <= INLINER_THRESHOLD;
+}
+
+/**
+ * Inlines small functions into their callers, before the rest of the
+ * compiler's passes, so calls can be specialised with their arguments. The
+ * decisions are made here, with a cost model of the callee's size less
+ * bonuses for constant arguments, removing the last call to a local
+ * function and callees a profile shows are hot, plus a penalty for calls a
+ * profile shows never ran, and LLVM's always-inliner carries them out.
+ *
+ * @param module The module.
+ * @param report Whether to print the decision made for each call.
+ */
+void inliner_inline(LLVMModuleRef module, bool report) {
+    LLVMContextRef context = LLVMGetModuleContext(module);
+    LLVMAttributeRef alwaysInline = LLVMCreateEnumAttribute(context, LLVMGetEnumAttributeKindForName("alwaysinline", 12), 0);
+    LLVMPassManagerRef passManager = NULL;
+    bool changed = false;
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+        for (LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function); block; block = LLVMGetNextBasicBlock(block)) {
+            for (LLVMValueRef instruction = LLVMGetFirstInstruction(block); instruction;
+                 instruction = LLVMGetNextInstruction(instruction)) {
+                LLVMValueRef callee = inliner_getCallee_(instruction);
+                char *reason = NULL;
+                bool inlined = false;
+
+                if (!callee) {
+                    continue;
+                }
+
+                inlined = inliner_decide_(instruction, callee, &reason);
+
+                if (inlined) {
+                    LLVMAddCallSiteAttribute(instruction, LLVMAttributeFunctionIndex, alwaysInline);
+                    changed = true;
+                }
+
+                if (report) {
+                    printf("%s '%s' into '%s': %s\n", inlined ? "inlined" : "not inlined", LLVMGetValueName(callee),
+                           LLVMGetValueName(function), reason);
+                }
+            }
+        }
+    }
+
+    if (!changed) {
+        return;
+    }
+
+    passManager = LLVMCreatePassManager();
+    LLVMAddAlwaysInlinerPass(passManager);
+    LLVMRunPassManager(passManager, module);
+    LLVMDisposePassManager(passManager);
+}
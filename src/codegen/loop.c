@@ -0,0 +1,127 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+#pragma once
+
+#include "../includes.c"
+
+#include <llvm-c/Core.h>
+#include <llvm-c/DebugInfo.h>
+
+#define LOOP_RANGE_NAME "range" // 'for index, value = range(start, end)' from std
+
+/**
+ * Represents a counted loop over 'range(start, end)'. It is lowered to a
+ * bare induction variable, like a C 'for' loop, rather than an iterator
+ * object, so there are no calls or allocations for the optimiser to see
+ * through.
+ */
+struct LoopRange {
+    LLVMBasicBlockRef preheader, body, latch, exit;
+    LLVMValueRef start, end, value;
+};
+
+/**
+ * Gets whether a function called in a 'for' loop is std's 'range', which
+ * is lowered to a counted loop.
+ *
+ * @param NAME The name of the function.
+ *
+ * @return Whether the function is 'range'.
+ */
+bool loop_isRange(const char *NAME) { return strcmp(NAME, LOOP_RANGE_NAME) == 0; }
+
+/**
+ * Begins a loop over a range, positioning the builder at the start of its
+ * body. The loop is emitted in rotated form, with a guard before it and the
+ * condition at the end, which is what LLVM's loop passes expect.
+ *
+ * @param builder The builder, positioned where the loop goes.
+ * @param start   The first value, inclusive.
+ * @param end     The last value, exclusive. Must have the same type as
+ * start.
+ *
+ * @return The LoopRange struct, whose value is the induction variable.
+ */
+struct LoopRange loop_beginRange(LLVMBuilderRef builder, LLVMValueRef start, LLVMValueRef end) {
+    struct LoopRange range = {LLVMGetInsertBlock(builder), NULL, NULL, NULL, start, end, NULL};
+    LLVMValueRef function = LLVMGetBasicBlockParent(range.preheader);
+    LLVMContextRef context = LLVMGetTypeContext(LLVMTypeOf(start));
+
+    range.body = LLVMAppendBasicBlockInContext(context, function, "range.body");
+    range.latch = LLVMAppendBasicBlockInContext(context, function, "range.latch");
+    range.exit = LLVMAppendBasicBlockInContext(context, function, "range.exit");
+
+    LLVMBuildCondBr(builder, LLVMBuildICmp(builder, LLVMIntSLT, start, end, "range.guard"), range.body, range.exit);
+
+    LLVMPositionBuilderAtEnd(builder, range.body);
+    range.value = LLVMBuildPhi(builder, LLVMTypeOf(start), "range.value");
+
+    return range;
+}
+
+/**
+ * Gets the index of the current iteration of a loop over a range. It is
+ * only computed when asked for, so an unused '_' index costs nothing.
+ *
+ * @param builder The builder, positioned in the loop's body.
+ * @param RANGE   The loop.
+ *
+ * @return The index.
+ */
+LLVMValueRef loop_getRangeIndex(LLVMBuilderRef builder, const struct LoopRange *RANGE) {
+    return LLVMBuildNSWSub(builder, RANGE->value, RANGE->start, "range.index");
+}
+
+/**
+ * Creates the '!llvm.loop' metadata of a counted loop. Loops over ranges
+ * always finish, so they are marked as making progress, which lets LLVM
+ * treat them like loops in C and C++.
+ *
+ * @param context The context.
+ *
+ * @return The metadata.
+ */
+LLVMMetadataRef loop_createMetadata_(LLVMContextRef context) {
+    LLVMMetadataRef placeholder = LLVMTemporaryMDNode(context, NULL, 0), metadata = NULL;
+    LLVMMetadataRef operands[] = {placeholder, LLVMMDNodeInContext2(context,
+                                                                    (LLVMMetadataRef[]){LLVMMDStringInContext2(
+                                                                        context, "llvm.loop.mustprogress", 22)},
+                                                                    1)};
+
+    metadata = LLVMMDNodeInContext2(context, operands, 2);
+    LLVMMetadataReplaceAllUsesWith(placeholder, metadata); // Loop IDs refer to themselves
+
+    return metadata;
+}
+
+/**
+ * Ends a loop over a range, positioning the builder after it. The body
+ * falls through to the latch if it does not end in a branch of its own, and
+ * 'continue' and 'break' branch to the latch and exit blocks.
+ *
+ * @param builder The builder, positioned at the end of the loop's body.
+ * @param RANGE   The loop.
+ */
+void loop_endRange(LLVMBuilderRef builder, const struct LoopRange *RANGE) {
+    LLVMContextRef context = LLVMGetTypeContext(LLVMTypeOf(RANGE->start));
+    LLVMValueRef next = NULL, branch = NULL;
+
+    if (!LLVMGetBasicBlockTerminator(LLVMGetInsertBlock(builder))) {
+        LLVMBuildBr(builder, RANGE->latch);
+    }
+
+    LLVMPositionBuilderAtEnd(builder, RANGE->latch);
+    next = LLVMBuildNSWAdd(builder, RANGE->value, LLVMConstInt(LLVMTypeOf(RANGE->value), 1, false), "range.next");
+    branch = LLVMBuildCondBr(builder, LLVMBuildICmp(builder, LLVMIntSLT, next, RANGE->end, "range.more"), RANGE->body,
+                             RANGE->exit);
+    LLVMSetMetadata(branch, LLVMGetMDKindIDInContext(context, "llvm.loop", 9),
+                    LLVMMetadataAsValue(context, loop_createMetadata_(context)));
+
+    LLVMAddIncoming(RANGE->value, (LLVMValueRef[]){RANGE->start, next},
+                    (LLVMBasicBlockRef[]){RANGE->preheader, RANGE->latch}, 2);
+
+    LLVMPositionBuilderAtEnd(builder, RANGE->exit);
+}
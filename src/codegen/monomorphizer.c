@@ -0,0 +1,565 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+#pragma once
+
+#include "../includes.c"
+
+#include <stdint.h>
+
+#include <llvm-c/Core.h>
+#include <llvm-c/Object.h>
+#include <llvm-c/TargetMachine.h>
+
+#include "../utils/array.c"
+#include "../utils/conversions.c"
+#include "../utils/panic.c"
+#include "../utils/string.c"
+#include "./cache.c"
+#include "./split.c"
+
+#define MONOMORPHIZER_GENERIC_ATTRIBUTE "exeme-generic"               // Set on instances, to their generic's name
+#define MONOMORPHIZER_TYPE_ARGUMENTS_ATTRIBUTE "exeme-type-arguments" // Set on instances, to their type arguments
+#define MONOMORPHIZER_INITIAL_CAPACITY 64                              // A power of 2
+#define MONOMORPHIZER_MERGE_NAME "exeme.merge" // What instances are renamed to while printed, so names don't differ
+
+/**
+ * Represents an instance of a generic, which is kept in the first module
+ * to make it.
+ */
+struct MonomorphizerInstance {
+    uint64_t key, genericKey; // The key hashes the generic and its type arguments, the generic key just the generic
+    char *name;               // NULL while the slot is empty
+    char *generic, *typeArguments;
+};
+
+/**
+ * Represents an instance's function, and its body once printed.
+ */
+struct MonomorphizerBody {
+    LLVMValueRef function;
+    uint64_t hash;
+    char *body; // The whole function as compiled, see 'monomorphizer_describe_'
+    unsigned callConv;
+    bool merged;
+    size_t kept; // The index of the body it is merged into
+};
+
+#define MONOMORPHIZER_BODY_STRUCT_SIZE sizeof(struct MonomorphizerBody)
+
+/**
+ * Represents the instances of generics made across the modules of a build,
+ * so each instance is only compiled once.
+ */
+struct Monomorphizer {
+    struct MonomorphizerInstance *instances; // A hash table of the instances, keyed by their key
+    size_t capacity, length, shared, merged;
+    unsigned long long bytesSaved;
+};
+
+#define MONOMORPHIZER_STRUCT_SIZE sizeof(struct Monomorphizer)
+
+/**
+ * Creates a new Monomorphizer struct.
+ *
+ * @return The created Monomorphizer struct.
+ */
+struct Monomorphizer *monomorphizer_new(void) {
+    struct Monomorphizer *self = malloc(MONOMORPHIZER_STRUCT_SIZE);
+
+    if (!self) {
+        panic("failed to malloc Monomorphizer struct");
+    }
+
+    self->instances = calloc(MONOMORPHIZER_INITIAL_CAPACITY, sizeof(struct MonomorphizerInstance));
+
+    if (!self->instances) {
+        panic("failed to calloc monomorphizer instances");
+    }
+
+    self->capacity = MONOMORPHIZER_INITIAL_CAPACITY;
+    self->length = 0;
+    self->shared = 0;
+    self->merged = 0;
+    self->bytesSaved = 0;
+
+    return self;
+}
+
+/**
+ * Frees a Monomorphizer struct.
+ *
+ * @param self The current Monomorphizer struct.
+ */
+void monomorphizer_free(struct Monomorphizer **self) {
+    if (self && *self) {
+        for (size_t index = 0; index < (*self)->capacity; index++) {
+            free((*self)->instances[index].name);
+            free((*self)->instances[index].generic);
+            free((*self)->instances[index].typeArguments);
+        }
+
+        free((*self)->instances);
+
+        free(*self);
+        *self = NULL;
+    } else {
+        panic("Monomorphizer struct has already been freed");
+    }
+}
+
+/**
+ * Gets a string attribute of a function.
+ *
+ * @param function The function.
+ * @param NAME     The name of the attribute.
+ *
+ * @return The attribute's value, or NULL if the function does not have it.
+ */
+char *monomorphizer_getAttribute_(LLVMValueRef function, const char *NAME) {
+    LLVMAttributeRef attribute =
+        LLVMGetStringAttributeAtIndex(function, LLVMAttributeFunctionIndex, NAME, (unsigned)strlen(NAME));
+    const char *value = NULL;
+    unsigned length = 0;
+
+    if (!attribute) {
+        return NULL;
+    }
+
+    value = LLVMGetStringAttributeValue(attribute, &length);
+
+    return strndup(value, length);
+}
+
+/**
+ * Describes an instance as compiled, its printed signature and body along
+ * with its function attributes, which are only numbered in the signature.
+ * The number is left out, as it depends on the order of the module's
+ * functions, and so are the attributes naming its generic and type
+ * arguments, which always differ.
+ *
+ * @param function The function.
+ * @param PRINTED  The function printed, with its name replaced and made
+ * external.
+ *
+ * @return The description.
+ */
+char *monomorphizer_describe_(LLVMValueRef function, const char *PRINTED) {
+    const char *start = strstr(PRINTED, "define"), *body = strchr(PRINTED, '{');
+    unsigned attributesLength = LLVMGetAttributeCountAtIndex(function, LLVMAttributeFunctionIndex);
+    LLVMAttributeRef *attributes = malloc((attributesLength + 1) * sizeof(LLVMAttributeRef));
+    char *description = NULL, *signature = NULL;
+    size_t length = 0;
+
+    if (!attributes || !start || !body) {
+        panic("failed to describe monomorphizer instance");
+    }
+
+    signature = malloc((size_t)(body - start) + 1);
+
+    if (!signature) {
+        panic("failed to malloc monomorphizer signature");
+    }
+
+    for (const char *chr = start; chr < body; chr++) {
+        if (chr[0] == ' ' && chr[1] == '#' && chr[2] >= '0' && chr[2] <= '9') { // The number of its attributes
+            chr += 2;
+
+            while (chr[1] >= '0' && chr[1] <= '9') {
+                chr++;
+            }
+
+            continue;
+        } else if (strncmp(chr, "dso_local ", 10) == 0) { // Follows from its linkage, which merging keeps with an alias
+            chr += 9;
+
+            continue;
+        }
+
+        signature[length++] = *chr;
+    }
+
+    signature[length] = '\0';
+    description = stringConcatenate(2, signature, "");
+    LLVMGetAttributesAtIndex(function, LLVMAttributeFunctionIndex, attributes);
+
+    for (unsigned index = 0; index < attributesLength; index++) {
+        const char *kind = NULL, *value = NULL;
+        unsigned kindLength = 0, valueLength = 0;
+
+        if (LLVMIsStringAttribute(attributes[index])) {
+            kind = LLVMGetStringAttributeKind(attributes[index], &kindLength);
+            value = LLVMGetStringAttributeValue(attributes[index], &valueLength);
+
+            if ((kindLength == strlen(MONOMORPHIZER_GENERIC_ATTRIBUTE) &&
+                 strncmp(kind, MONOMORPHIZER_GENERIC_ATTRIBUTE, kindLength) == 0) ||
+                (kindLength == strlen(MONOMORPHIZER_TYPE_ARGUMENTS_ATTRIBUTE) &&
+                 strncmp(kind, MONOMORPHIZER_TYPE_ARGUMENTS_ATTRIBUTE, kindLength) == 0)) {
+                continue;
+            }
+
+            description = stringConcatenate(5, description, " ", strndup(kind, kindLength), "=",
+                                            strndup(value, valueLength));
+        } else if (LLVMIsTypeAttribute(attributes[index])) {
+            description = stringConcatenate(5, description, " ", ulToString(LLVMGetEnumAttributeKind(attributes[index])),
+                                            "=", LLVMPrintTypeToString(LLVMGetTypeAttributeValue(attributes[index])));
+        } else {
+            description = stringConcatenate(5, description, " ", ulToString(LLVMGetEnumAttributeKind(attributes[index])),
+                                            "=", ulToString(LLVMGetEnumAttributeValue(attributes[index])));
+        }
+    }
+
+    description = stringConcatenate(3, description, " ", body);
+
+    free(signature);
+    free(attributes);
+
+    return description;
+}
+
+/**
+ * Gets the slot of an instance in the hash table, growing it first if an
+ * instance is being added and it is half full. Slots are matched on their
+ * generic and type arguments as well as their key, so instances whose keys
+ * collide are kept apart.
+ *
+ * @param self           The current Monomorphizer struct.
+ * @param key            The instance's key.
+ * @param GENERIC        The name of the instance's generic.
+ * @param TYPE_ARGUMENTS The instance's type arguments.
+ *
+ * @return The slot, which has no name if the instance has not been made.
+ */
+struct MonomorphizerInstance *monomorphizer_getInstance_(struct Monomorphizer *self, uint64_t key, const char *GENERIC,
+                                                         const char *TYPE_ARGUMENTS) {
+    struct MonomorphizerInstance *instances = self->instances;
+    size_t capacity = self->capacity, index = 0;
+
+    if (self->length * 2 >= self->capacity) {
+        self->capacity *= 2;
+        self->instances = calloc(self->capacity, sizeof(struct MonomorphizerInstance));
+
+        if (!self->instances) {
+            panic("failed to calloc monomorphizer instances");
+        }
+
+        for (size_t other = 0; other < capacity; other++) {
+            if (instances[other].name) {
+                *monomorphizer_getInstance_(self, instances[other].key, instances[other].generic,
+                                            instances[other].typeArguments) = instances[other];
+            }
+        }
+
+        free(instances);
+    }
+
+    index = (size_t)key & (self->capacity - 1);
+
+    while (self->instances[index].name &&
+           (self->instances[index].key != key || strcmp(self->instances[index].generic, GENERIC) != 0 ||
+            strcmp(self->instances[index].typeArguments, TYPE_ARGUMENTS) != 0)) {
+        index = (index + 1) & (self->capacity - 1);
+    }
+
+    return &self->instances[index];
+}
+
+/**
+ * Shares the instances of generics in a module with the modules before it,
+ * before it is linked with them. Instances already made by an earlier
+ * module are replaced with a declaration of it, and the rest are kept, and
+ * made visible to the modules after it.
+ *
+ * @param self   The current Monomorphizer struct.
+ * @param module The module.
+ */
+void monomorphizer_share(struct Monomorphizer *self, LLVMModuleRef module) {
+    LLVMValueRef function = LLVMGetFirstFunction(module), next = NULL;
+
+    for (; function; function = next) {
+        char *generic = monomorphizer_getAttribute_(function, MONOMORPHIZER_GENERIC_ATTRIBUTE),
+             *typeArguments = monomorphizer_getAttribute_(function, MONOMORPHIZER_TYPE_ARGUMENTS_ATTRIBUTE);
+        struct MonomorphizerInstance *instance = NULL;
+        LLVMValueRef existing = NULL;
+        uint64_t genericKey = 0;
+
+        next = LLVMGetNextFunction(function);
+
+        if (!generic || !typeArguments || !split_isDefined(function)) {
+            free(generic);
+            free(typeArguments);
+
+            continue;
+        }
+
+        genericKey = cache_hash(generic, CACHE_HASH_OFFSET);
+        instance = monomorphizer_getInstance_(self, cache_hash(typeArguments, genericKey), generic, typeArguments);
+
+        if (!instance->name) {
+            instance->key = cache_hash(typeArguments, genericKey);
+            instance->genericKey = genericKey;
+            instance->name = stringConcatenate(2, LLVMGetValueName(function), "");
+            instance->generic = generic;
+            instance->typeArguments = typeArguments;
+            generic = typeArguments = NULL; // Kept by the instance
+            self->length++;
+
+            if (LLVMGetLinkage(function) == LLVMInternalLinkage || LLVMGetLinkage(function) == LLVMPrivateLinkage) {
+                LLVMSetLinkage(function, LLVMLinkOnceODRLinkage);
+                LLVMSetVisibility(function, LLVMHiddenVisibility);
+            }
+        } else if (strcmp(instance->name, LLVMGetValueName(function)) == 0) { // Linked with the one kept
+            split_removeBody(function);
+            self->shared++;
+        } else {
+            existing = LLVMGetNamedFunction(module, instance->name);
+
+            if (!existing) {
+                existing = LLVMAddFunction(module, instance->name, LLVMGlobalGetValueType(function));
+            }
+
+            LLVMReplaceAllUsesWith(function, LLVMTypeOf(existing) == LLVMTypeOf(function)
+                                                 ? existing
+                                                 : LLVMConstBitCast(existing, LLVMTypeOf(function)));
+            LLVMDeleteFunction(function);
+            self->shared++;
+        }
+
+        free(generic);
+        free(typeArguments);
+    }
+}
+
+/**
+ * Compares MonomorphizerBody structs by their hashes.
+ *
+ * @param a The first MonomorphizerBody struct.
+ * @param b The second MonomorphizerBody struct.
+ *
+ * @return The order of the structs.
+ */
+int monomorphizer_compareBodies_(const void *a, const void *b) {
+    const struct MonomorphizerBody *A = a, *B = b;
+
+    return A->hash < B->hash ? -1 : (A->hash > B->hash ? 1 : 0);
+}
+
+/**
+ * Gets the size of the machine code of some of a module's functions.
+ *
+ * @param module        The module.
+ * @param functions     The functions.
+ * @param targetMachine The target machine.
+ *
+ * @return The size, in bytes.
+ */
+unsigned long long monomorphizer_getCodeSize_(LLVMModuleRef module, struct Array *functions,
+                                              LLVMTargetMachineRef targetMachine) {
+    LLVMModuleRef clone = LLVMCloneModule(module);
+    LLVMTargetDataRef dataLayout = LLVMCreateTargetDataLayout(targetMachine);
+    LLVMMemoryBufferRef buffer = NULL;
+    LLVMBinaryRef binary = NULL;
+    LLVMSectionIteratorRef section = NULL;
+    char *message = NULL, *triple = LLVMGetTargetMachineTriple(targetMachine);
+    unsigned long long size = 0;
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(clone); function; function = LLVMGetNextFunction(function)) {
+        bool measured = false;
+
+        for (size_t index = 0; index < functions->length && !measured; index++) {
+            measured = strcmp(LLVMGetValueName(function), array_get(functions, index)) == 0;
+        }
+
+        if (!measured) {
+            split_removeBody(function);
+        }
+    }
+
+    LLVMSetTarget(clone, triple);
+    LLVMSetModuleDataLayout(clone, dataLayout);
+
+    if (!LLVMTargetMachineEmitToMemoryBuffer(targetMachine, clone, LLVMObjectFile, &message, &buffer)) {
+        binary = LLVMCreateBinary(buffer, LLVMGetModuleContext(clone), &message);
+    }
+
+    if (binary) {
+        section = LLVMObjectFileCopySectionIterator(binary);
+
+        for (; !LLVMObjectFileIsSectionIteratorAtEnd(binary, section); LLVMMoveToNextSection(section)) {
+            if (LLVMGetSectionName(section) && strncmp(LLVMGetSectionName(section), ".text", 5) == 0) {
+                size += LLVMGetSectionSize(section);
+            }
+        }
+
+        LLVMDisposeSectionIterator(section);
+        LLVMDisposeBinary(binary);
+    }
+
+    if (buffer) {
+        LLVMDisposeMemoryBuffer(buffer);
+    }
+
+    LLVMDisposeMessage(triple);
+    LLVMDisposeTargetData(dataLayout);
+    LLVMDisposeModule(clone);
+
+    return size;
+}
+
+/**
+ * Merges the instances of generics which compile to the same code, like
+ * those of a generic with type arguments of the same size. Their bodies,
+ * signatures, attributes and calling conventions are compared. Each is
+ * replaced with the first, and left as an alias of it if it could be used
+ * from outside the module.
+ *
+ * @param self          The current Monomorphizer struct.
+ * @param module        The module.
+ * @param targetMachine The target machine to measure the code saved with,
+ * or NULL to not measure it.
+ */
+void monomorphizer_merge(struct Monomorphizer *self, LLVMModuleRef module, LLVMTargetMachineRef targetMachine) {
+    struct MonomorphizerBody *bodies = NULL;
+    struct Array *merged = array_new();
+    size_t bodiesLength = 0, capacity = 0;
+    char *name = NULL, *printed = NULL, *typeArguments = NULL;
+    LLVMLinkage linkage = LLVMExternalLinkage;
+    LLVMVisibility visibility = LLVMDefaultVisibility;
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+        typeArguments = monomorphizer_getAttribute_(function, MONOMORPHIZER_TYPE_ARGUMENTS_ATTRIBUTE);
+
+        if (!typeArguments || !split_isDefined(function)) {
+            free(typeArguments);
+
+            continue;
+        } else if (bodiesLength == capacity) {
+            capacity = capacity ? capacity * 2 : MONOMORPHIZER_INITIAL_CAPACITY;
+            bodies = realloc(bodies, capacity * MONOMORPHIZER_BODY_STRUCT_SIZE);
+
+            if (!bodies) {
+                panic("failed to realloc monomorphizer bodies");
+            }
+        }
+
+        // Renamed while printed, as their names always differ, and made external, as merging keeps their linkage with an
+        // alias. The name is free again once renamed, so it is given back as is
+        name = stringConcatenate(2, LLVMGetValueName(function), "");
+        linkage = LLVMGetLinkage(function);
+        visibility = LLVMGetVisibility(function);
+        LLVMSetValueName2(function, MONOMORPHIZER_MERGE_NAME, strlen(MONOMORPHIZER_MERGE_NAME));
+        LLVMSetLinkage(function, LLVMExternalLinkage);
+        LLVMSetVisibility(function, LLVMDefaultVisibility);
+        printed = LLVMPrintValueToString(function);
+        LLVMSetValueName2(function, name, strlen(name));
+        LLVMSetLinkage(function, linkage);
+        LLVMSetVisibility(function, visibility);
+
+        bodies[bodiesLength].body = monomorphizer_describe_(function, printed);
+        bodies[bodiesLength].callConv = LLVMGetFunctionCallConv(function);
+        bodies[bodiesLength].hash =
+            (cache_hash(bodies[bodiesLength].body, CACHE_HASH_OFFSET) ^ bodies[bodiesLength].callConv) * CACHE_HASH_PRIME;
+        bodies[bodiesLength].function = function;
+        bodies[bodiesLength++].merged = false;
+
+        LLVMDisposeMessage(printed);
+        free(name);
+        free(typeArguments);
+    }
+
+    if (bodiesLength) {
+        qsort(bodies, bodiesLength, MONOMORPHIZER_BODY_STRUCT_SIZE, monomorphizer_compareBodies_);
+    }
+
+    for (size_t index = 0; index < bodiesLength; index++) { // Until merged into another
+        bodies[index].kept = index;
+    }
+
+    for (size_t index = 1; index < bodiesLength; index++) {
+        size_t kept = index - 1;
+
+        if (bodies[kept].merged) { // So the one it was merged into is before it
+            kept = bodies[kept].kept;
+        }
+
+        if (bodies[kept].hash == bodies[index].hash && bodies[kept].callConv == bodies[index].callConv &&
+            LLVMGlobalGetValueType(bodies[kept].function) == LLVMGlobalGetValueType(bodies[index].function) &&
+            strcmp(bodies[kept].body, bodies[index].body) == 0) {
+            array_insert(merged, merged->length, stringConcatenate(2, LLVMGetValueName(bodies[index].function), ""));
+            bodies[index].merged = true;
+            bodies[index].kept = kept;
+        }
+    }
+
+    if (targetMachine && merged->length) {
+        self->bytesSaved += monomorphizer_getCodeSize_(module, merged, targetMachine);
+    }
+
+    for (size_t index = 0; index < bodiesLength; index++) { // After measuring, as they are gone
+        const char *NAME = NULL;
+        LLVMValueRef function = bodies[index].function, kept = bodies[bodies[index].kept].function, alias = NULL;
+        LLVMLinkage linkage = LLVMGetLinkage(function);
+
+        free(bodies[index].body);
+
+        if (!bodies[index].merged) {
+            continue;
+        }
+
+        NAME = stringConcatenate(2, LLVMGetValueName(function), "");
+
+        LLVMReplaceAllUsesWith(function, kept);
+        LLVMDeleteFunction(function);
+        self->merged++;
+
+        if (linkage != LLVMInternalLinkage && linkage != LLVMPrivateLinkage) { // Could be used from outside
+            alias = LLVMAddAlias2(module, LLVMGlobalGetValueType(kept), LLVMGetPointerAddressSpace(LLVMTypeOf(kept)), kept,
+                                  NAME);
+            LLVMSetLinkage(alias, linkage);
+        }
+
+        free((void *)NAME);
+    }
+
+    for (size_t index = 0; index < merged->length; index++) {
+        free((void *)array_get(merged, index));
+    }
+
+    free(bodies);
+    array_free(&merged);
+}
+
+/**
+ * Prints how many instances of generics were made, shared between modules
+ * and merged, and how much code that saved.
+ *
+ * @param self The current Monomorphizer struct.
+ */
+void monomorphizer_report(struct Monomorphizer *self) {
+    uint64_t *genericKeys = malloc((self->length + 1) * sizeof(uint64_t));
+    size_t genericKeysLength = 0, generics = 0;
+
+    if (!genericKeys) {
+        panic("failed to malloc generic keys");
+    }
+
+    for (size_t index = 0; index < self->capacity; index++) {
+        bool seen = false;
+
+        for (size_t other = 0; other < genericKeysLength && !seen; other++) {
+            seen = genericKeys[other] == self->instances[index].genericKey;
+        }
+
+        if (self->instances[index].name && !seen) {
+            genericKeys[genericKeysLength++] = self->instances[index].genericKey;
+            generics++;
+        }
+    }
+
+    printf("%zu instances of %zu generics, %zu shared between modules, %zu merged as identical, %llu bytes saved\n",
+           self->length, generics, self->shared, self->merged, self->bytesSaved);
+
+    free(genericKeys);
+}
@@ -0,0 +1,503 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+#pragma once
+
+#include "../includes.c"
+
+#include <inttypes.h>
+#include <stdint.h>
+
+#include <llvm-c/Core.h>
+
+#include "../utils/array.c"
+#include "../utils/panic.c"
+#include "../utils/string.c"
+#include "./cache.c"
+#include "./split.c"
+
+#define PROFILE_VERSION 1
+#define PROFILE_RUNTIME_PREFIX "__exeme_profile"
+
+/**
+ * Represents the counters of a function in a profile.
+ */
+struct ProfileRecord {
+    char *name;
+    size_t length;
+    uint64_t hash, *counters;
+};
+
+#define PROFILERECORD_STRUCT_SIZE sizeof(struct ProfileRecord)
+
+/**
+ * Represents a profile, the counters of every run of an instrumented
+ * program merged together.
+ */
+struct Profile {
+    struct Array *records;
+};
+
+#define PROFILE_STRUCT_SIZE sizeof(struct Profile)
+
+/**
+ * Gets the record of a function in the profile.
+ *
+ * @param self The current Profile struct.
+ * @param NAME The name of the function.
+ * @param hash The hash of the function.
+ *
+ * @return The record, or NULL if the function has not been profiled.
+ */
+struct ProfileRecord *profile_get(struct Profile *self, const char *NAME, uint64_t hash) {
+    for (size_t index = 0; index < self->records->length; index++) {
+        struct ProfileRecord *record = (struct ProfileRecord *)array_get(self->records, index);
+
+        if (record->hash == hash && strcmp(record->name, NAME) == 0) {
+            return record;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Loads a profile, merging the counters of every run in it.
+ *
+ * @param self      The current Profile struct.
+ * @param FILE_PATH The path of the profile.
+ */
+void profile_load(struct Profile *self, const char *FILE_PATH) {
+    char name[1024];
+    FILE *filePointer = fopen(FILE_PATH, "r");
+
+    if (!filePointer) {
+        panic(stringConcatenate(3, "failed to open profile '", FILE_PATH, "'"));
+    }
+
+    while (fscanf(filePointer, "%1023s", name) == 1) {
+        struct ProfileRecord *record = NULL;
+        size_t length = 0;
+        uint64_t count = 0, hash = 0;
+
+        if (strcmp(name, "exlprof") == 0) { // The start of a run
+            int version = 0;
+
+            if (fscanf(filePointer, "%d", &version) != 1 || version != PROFILE_VERSION) {
+                panic(stringConcatenate(3, "unsupported version of profile '", FILE_PATH, "'"));
+            }
+
+            continue;
+        }
+
+        if (fscanf(filePointer, "%" SCNx64 " %zu", &hash, &length) != 2) {
+            panic(stringConcatenate(3, "malformed profile '", FILE_PATH, "'"));
+        }
+
+        record = profile_get(self, name, hash);
+
+        if (record && record->length != length) {
+            panic(stringConcatenate(5, "mismatched counters for function '", name, "' in profile '", FILE_PATH, "'"));
+        } else if (!record) {
+            record = malloc(PROFILERECORD_STRUCT_SIZE);
+
+            if (!record) {
+                panic("failed to malloc ProfileRecord struct");
+            }
+
+            record->name = strdup(name);
+            record->length = length;
+            record->hash = hash;
+            record->counters = calloc(length ? length : 1, sizeof(uint64_t));
+
+            array_insert(self->records, self->records->length, record);
+        }
+
+        for (size_t index = 0; index < length; index++) {
+            if (fscanf(filePointer, "%" SCNu64, &count) != 1) {
+                panic(stringConcatenate(3, "malformed profile '", FILE_PATH, "'"));
+            }
+
+            record->counters[index] += count;
+        }
+    }
+
+    fclose(filePointer);
+}
+
+/**
+ * Creates a new Profile struct.
+ *
+ * @param FILE_PATH The path of the profile to load.
+ *
+ * @return The created Profile struct.
+ */
+struct Profile *profile_new(const char *FILE_PATH) {
+    struct Profile *self = malloc(PROFILE_STRUCT_SIZE);
+
+    if (!self) {
+        panic("failed to malloc Profile struct");
+    }
+
+    self->records = array_new();
+
+    profile_load(self, FILE_PATH);
+
+    return self;
+}
+
+/**
+ * Frees a Profile struct.
+ *
+ * @param self The current Profile struct.
+ */
+void profile_free(struct Profile **self) {
+    if (self && *self) {
+        for (size_t index = 0; index < (*self)->records->length; index++) {
+            struct ProfileRecord *record = (struct ProfileRecord *)array_get((*self)->records, index);
+
+            free(record->name);
+            free(record->counters);
+            free(record);
+        }
+
+        array_free(&(*self)->records);
+
+        free(*self);
+        *self = NULL;
+    } else {
+        panic("Profile struct has already been freed");
+    }
+}
+
+/**
+ * Hashes every counter in a profile, so code optimised with it is only
+ * reused while the profile is the same.
+ *
+ * @param self The current Profile struct.
+ * @param hash The previous hash.
+ *
+ * @return The hash.
+ */
+uint64_t profile_fingerprint(struct Profile *self, uint64_t hash) {
+    for (size_t index = 0; index < self->records->length; index++) {
+        const struct ProfileRecord *RECORD = array_get(self->records, index);
+
+        hash = (cache_hash(RECORD->name, hash) ^ RECORD->hash) * CACHE_HASH_PRIME;
+
+        for (size_t counter = 0; counter < RECORD->length; counter++) {
+            hash = (hash ^ RECORD->counters[counter]) * CACHE_HASH_PRIME;
+        }
+    }
+
+    return hash;
+}
+
+/**
+ * Hashes a function, so counters are only used for the code they were
+ * collected from.
+ *
+ * @param function The function.
+ *
+ * @return The hash.
+ */
+uint64_t profile_hash(LLVMValueRef function) {
+    return cache_hashMessage_(LLVMPrintValueToString(function), CACHE_HASH_OFFSET);
+}
+
+/**
+ * Gets whether a function should be profiled.
+ *
+ * @param function The function.
+ *
+ * @return Whether the function is defined, and not part of the profile
+ * runtime.
+ */
+bool profile_isProfiled(LLVMValueRef function) {
+    return split_isDefined(function) &&
+           strncmp(LLVMGetValueName(function), PROFILE_RUNTIME_PREFIX, strlen(PROFILE_RUNTIME_PREFIX)) != 0;
+}
+
+/**
+ * Gets the conditional branch terminating a block.
+ *
+ * @param block The block.
+ *
+ * @return The branch, or NULL if the block does not end in one.
+ */
+LLVMValueRef profile_getConditionalBranch(LLVMBasicBlockRef block) {
+    LLVMValueRef terminator = LLVMGetBasicBlockTerminator(block);
+
+    return terminator && LLVMIsABranchInst(terminator) && LLVMIsConditional(terminator) ? terminator : NULL;
+}
+
+/**
+ * Gets the first instruction of a block which code can be inserted before.
+ *
+ * @param block The block.
+ *
+ * @return The instruction.
+ */
+LLVMValueRef profile_getInsertionPoint_(LLVMBasicBlockRef block) {
+    LLVMValueRef instruction = LLVMGetFirstInstruction(block);
+
+    while (LLVMIsAPHINode(instruction) || LLVMIsALandingPadInst(instruction)) {
+        instruction = LLVMGetNextInstruction(instruction);
+    }
+
+    return instruction;
+}
+
+/**
+ * Builds code adding a value to a counter.
+ *
+ * @param builder  The builder, positioned where the code is inserted.
+ * @param counters The function's counters.
+ * @param index    The index of the counter.
+ * @param value    The value to add.
+ */
+void profile_buildIncrement_(LLVMBuilderRef builder, LLVMValueRef counters, size_t index, LLVMValueRef value) {
+    LLVMTypeRef int64 = LLVMTypeOf(value);
+    LLVMValueRef indices[] = {LLVMConstInt(int64, 0, false), LLVMConstInt(int64, index, false)}, counter = NULL;
+
+    // Atomic, as programs run functions on several threads at once, but unordered, as nothing reads them until exit
+    counter = LLVMBuildInBoundsGEP2(builder, LLVMGlobalGetValueType(counters), counters, indices, 2, "");
+    LLVMBuildAtomicRMW(builder, LLVMAtomicRMWBinOpAdd, counter, value, LLVMAtomicOrderingMonotonic, false);
+}
+
+/**
+ * Instruments a module to count how many times each block is run and each
+ * conditional branch is taken. The counters are written to a profile when
+ * the program exits, by the runtime in 'std-llvm-ir/profile.ll'.
+ *
+ * @param module The module, which the profile runtime has been linked into.
+ */
+void profile_instrument(LLVMModuleRef module) {
+    LLVMBuilderRef builder = NULL;
+    LLVMContextRef context = LLVMGetModuleContext(module);
+    LLVMTypeRef int8Pointer = LLVMPointerType(LLVMInt8TypeInContext(context), 0),
+                int64 = LLVMInt64TypeInContext(context), int64Pointer = LLVMPointerType(int64, 0),
+                recordType = NULL;
+    LLVMValueRef mainFunction = LLVMGetNamedFunction(module, "main"),
+                 registerFunction = LLVMGetNamedFunction(module, PROFILE_RUNTIME_PREFIX "_register"), table = NULL,
+                 *records = NULL;
+    size_t recordsLength = 0;
+
+    if (!mainFunction || !split_isDefined(mainFunction) || !registerFunction) {
+        panic("profiled programs need a 'main' function, and to be linked with the profile runtime");
+    }
+
+    recordType = LLVMStructTypeInContext(context, (LLVMTypeRef[]){int8Pointer, int64, int64, int64Pointer}, 4, false);
+    builder = LLVMCreateBuilderInContext(context);
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+        recordsLength++;
+    }
+
+    records = calloc(recordsLength, sizeof(LLVMValueRef));
+    recordsLength = 0;
+
+    if (!records) {
+        panic("failed to calloc profile records");
+    }
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+        const char *NAME = LLVMGetValueName(function);
+        size_t blocksLength = LLVMCountBasicBlocks(function), branchesLength = 0, blockIndex = 0;
+        uint64_t hash = 0;
+        LLVMValueRef counters = NULL, name = NULL;
+
+        if (!profile_isProfiled(function)) {
+            continue;
+        }
+
+        hash = profile_hash(function);
+
+        for (LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function); block; block = LLVMGetNextBasicBlock(block)) {
+            branchesLength += profile_getConditionalBranch(block) != NULL;
+        }
+
+        counters = LLVMAddGlobal(module, LLVMArrayType(int64, (unsigned)(blocksLength + branchesLength)),
+                                 stringConcatenate(2, PROFILE_RUNTIME_PREFIX "_counters.", NAME));
+        LLVMSetInitializer(counters, LLVMConstNull(LLVMGlobalGetValueType(counters)));
+        LLVMSetLinkage(counters, LLVMInternalLinkage);
+
+        branchesLength = 0;
+
+        for (LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function); block;
+             block = LLVMGetNextBasicBlock(block), blockIndex++) {
+            LLVMValueRef branch = profile_getConditionalBranch(block);
+
+            LLVMPositionBuilderBefore(builder, profile_getInsertionPoint_(block));
+            profile_buildIncrement_(builder, counters, blockIndex, LLVMConstInt(int64, 1, false));
+
+            if (branch) { // Counts the times the branch is taken, the rest come from the block's counter
+                LLVMPositionBuilderBefore(builder, branch);
+                profile_buildIncrement_(builder, counters, blocksLength + branchesLength++,
+                                        LLVMBuildZExt(builder, LLVMGetCondition(branch), int64, ""));
+            }
+        }
+
+        name = LLVMAddGlobal(module, LLVMArrayType(LLVMInt8TypeInContext(context), (unsigned)strlen(NAME) + 1),
+                             stringConcatenate(2, PROFILE_RUNTIME_PREFIX "_name.", NAME));
+        LLVMSetInitializer(name, LLVMConstStringInContext(context, NAME, (unsigned)strlen(NAME), false));
+        LLVMSetLinkage(name, LLVMPrivateLinkage);
+        LLVMSetGlobalConstant(name, true);
+
+        records[recordsLength++] = LLVMConstNamedStruct(
+            recordType, (LLVMValueRef[]){LLVMConstBitCast(name, int8Pointer), LLVMConstInt(int64, hash, false),
+                                         LLVMConstInt(int64, blocksLength + branchesLength, false),
+                                         LLVMConstBitCast(counters, int64Pointer)},
+            4);
+    }
+
+    table = LLVMAddGlobal(module, LLVMArrayType(recordType, (unsigned)recordsLength), PROFILE_RUNTIME_PREFIX "_table");
+    LLVMSetInitializer(table, LLVMConstArray(recordType, records, (unsigned)recordsLength));
+    LLVMSetLinkage(table, LLVMInternalLinkage);
+
+    LLVMPositionBuilderBefore(builder, profile_getInsertionPoint_(LLVMGetEntryBasicBlock(mainFunction)));
+    LLVMBuildCall2(builder, LLVMGlobalGetValueType(registerFunction), registerFunction,
+                   (LLVMValueRef[]){
+                       LLVMConstBitCast(table, LLVMTypeOf(LLVMGetParam(registerFunction, 0))),
+                       LLVMConstInt(int64, recordsLength, false),
+                   },
+                   2, "");
+
+    LLVMDisposeBuilder(builder);
+    free(records);
+}
+
+/**
+ * Creates '!prof' metadata.
+ *
+ * @param context The context.
+ * @param NAME    The name of the metadata.
+ * @param type    The type of the values.
+ * @param values  The values.
+ * @param length  The number of values.
+ *
+ * @return The metadata.
+ */
+LLVMMetadataRef profile_createMetadata_(LLVMContextRef context, const char *NAME, LLVMTypeRef type,
+                                        const uint64_t *values, size_t length) {
+    LLVMMetadataRef operands[3] = {LLVMMDStringInContext2(context, NAME, strlen(NAME))};
+
+    for (size_t index = 0; index < length; index++) {
+        operands[index + 1] = LLVMValueAsMetadata(LLVMConstInt(type, values[index], false));
+    }
+
+    return LLVMMDNodeInContext2(context, operands, length + 1);
+}
+
+/**
+ * Adds an attribute to a function.
+ *
+ * @param function The function.
+ * @param NAME     The name of the attribute.
+ */
+void profile_addAttribute_(LLVMValueRef function, const char *NAME) {
+    LLVMAddAttributeAtIndex(function, LLVMAttributeFunctionIndex,
+                            LLVMCreateEnumAttribute(LLVMGetModuleContext(LLVMGetGlobalParent(function)),
+                                                    LLVMGetEnumAttributeKindForName(NAME, strlen(NAME)), 0));
+}
+
+/**
+ * Applies a profile to a module. Functions get their entry counts, which
+ * block placement uses, and conditional branches get their weights.
+ * Functions which never ran are marked cold and placed in '.text.unlikely',
+ * while the hottest are marked hot, which the inliner's cost model favours,
+ * and placed together in '.text.hot'. Functions are placed whole, not split
+ * into hot and cold parts.
+ *
+ * @param self   The current Profile struct.
+ * @param module The module, which must not have changed since it was
+ * profiled for the counters to be used.
+ */
+void profile_apply(struct Profile *self, LLVMModuleRef module) {
+    LLVMContextRef context = LLVMGetModuleContext(module);
+    unsigned profKind = LLVMGetMDKindIDInContext(context, "prof", 4);
+    uint64_t maxEntryCount = 0;
+    size_t functionsLength = 0, functionIndex = 0;
+    const struct ProfileRecord **records = NULL;
+
+    for (size_t index = 0; index < self->records->length; index++) {
+        const struct ProfileRecord *RECORD = array_get(self->records, index);
+
+        if (RECORD->length > 0 && RECORD->counters[0] > maxEntryCount) {
+            maxEntryCount = RECORD->counters[0];
+        }
+    }
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+        functionsLength++;
+    }
+
+    records = calloc(functionsLength ? functionsLength : 1, sizeof(struct ProfileRecord *));
+
+    if (!records) {
+        panic("failed to calloc profile records");
+    }
+
+    // Functions are matched before any attributes are added, as those change how other functions are printed
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function;
+         function = LLVMGetNextFunction(function), functionIndex++) {
+        if (profile_isProfiled(function)) {
+            records[functionIndex] = profile_get(self, LLVMGetValueName(function), profile_hash(function));
+        }
+    }
+
+    functionIndex = 0;
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function;
+         function = LLVMGetNextFunction(function), functionIndex++) {
+        const struct ProfileRecord *RECORD = records[functionIndex];
+        size_t blocksLength = LLVMCountBasicBlocks(function), branchesLength = 0, blockIndex = 0;
+
+        if (!RECORD || RECORD->length < 1) {
+            continue;
+        }
+
+        LLVMGlobalSetMetadata(function, profKind,
+                              profile_createMetadata_(context, "function_entry_count", LLVMInt64TypeInContext(context),
+                                                      RECORD->counters, 1));
+
+        if (RECORD->counters[0] == 0) {
+            profile_addAttribute_(function, "cold");
+            LLVMSetSection(function, ".text.unlikely");
+        } else if (RECORD->counters[0] >= maxEntryCount / 10) { // Within an order of magnitude of the hottest
+            profile_addAttribute_(function, "hot");
+            profile_addAttribute_(function, "inlinehint");
+            LLVMSetSection(function, ".text.hot");
+        }
+
+        for (LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function); block;
+             block = LLVMGetNextBasicBlock(block), blockIndex++) {
+            LLVMValueRef branch = profile_getConditionalBranch(block);
+            uint64_t weights[2] = {0, 0}, taken = 0, total = 0;
+
+            if (!branch) {
+                continue;
+            }
+
+            total = RECORD->counters[blockIndex];
+            taken = RECORD->counters[blocksLength + branchesLength++];
+
+            weights[0] = taken;
+            weights[1] = total > taken ? total - taken : 0;
+
+            while (weights[0] > UINT32_MAX || weights[1] > UINT32_MAX) { // Weights are 32-bit
+                weights[0] >>= 1;
+                weights[1] >>= 1;
+            }
+
+            LLVMSetMetadata(branch, profKind,
+                            LLVMMetadataAsValue(context, profile_createMetadata_(context, "branch_weights",
+                                                                                 LLVMInt32TypeInContext(context),
+                                                                                 weights, 2)));
+        }
+    }
+
+    free(records);
+}
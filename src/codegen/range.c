@@ -0,0 +1,1638 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+#pragma once
+
+#include "../includes.c"
+
+#include <stdint.h>
+
+#include <llvm-c/Core.h>
+
+#include "../utils/array.c"
+#include "../utils/conversions.c"
+#include "../utils/panic.c"
+#include "../utils/string.c"
+
+#define RANGE_WIDENING_UPDATES 3  // Times a phi can grow before it jumps to the bounds its loop allows
+#define RANGE_NARROWING_PASSES 2  // Passes which tighten ranges again after widening
+#define RANGE_MAX_PASSES 64       // Passes before a function is given up on
+#define RANGE_MAX_FACT_DEPTH 64   // Blocks walked back through for the conditions known in a block
+
+/**
+ * Represents the values an integer of at most 64 bits can have, as a signed
+ * interval and the bits known to be 0. It is empty, for code which cannot
+ * run, when min is greater than max.
+ */
+struct Range {
+    long long min, max;
+    unsigned long long zeros;
+};
+
+/**
+ * Represents a comparison known to be true in a block.
+ */
+struct RangeFact {
+    LLVMIntPredicate predicate;
+    LLVMValueRef left, right;
+};
+
+#define RANGE_FACT_STRUCT_SIZE sizeof(struct RangeFact)
+
+/**
+ * Represents the range of an instruction or parameter.
+ */
+struct RangeEntry {
+    LLVMValueRef value;
+    struct Range range;
+    unsigned updates;
+};
+
+/**
+ * Represents the analysis of a function.
+ */
+struct RangeAnalysis {
+    struct RangeEntry *entries;
+    size_t capacity, blocksLength;
+    LLVMBasicBlockRef *blocks, *predecessors; // A block's only predecessor, or NULL
+    bool *cyclic;                             // Whether a block can run more than once
+    struct Array **facts, *ownedFacts;
+};
+
+#define RANGE_ANALYSIS_STRUCT_SIZE sizeof(struct RangeAnalysis)
+
+/**
+ * Gets the width of an integer value, if ranges are kept for it.
+ *
+ * @param value The value.
+ *
+ * @return The width in bits, or 0 if it is not an integer of at most 64 bits.
+ */
+unsigned range_getWidth_(LLVMValueRef value) {
+    LLVMTypeRef type = LLVMTypeOf(value);
+
+    return LLVMGetTypeKind(type) == LLVMIntegerTypeKind && LLVMGetIntTypeWidth(type) <= 64 ? LLVMGetIntTypeWidth(type)
+                                                                                            : 0;
+}
+
+/**
+ * Gets the smallest signed integer of a width.
+ *
+ * @param width The width.
+ *
+ * @return The integer.
+ */
+__int128 range_getMinimum_(unsigned width) { return -((__int128)1 << (width - 1)); }
+
+/**
+ * Gets the largest signed integer of a width.
+ *
+ * @param width The width.
+ *
+ * @return The integer.
+ */
+__int128 range_getMaximum_(unsigned width) { return ((__int128)1 << (width - 1)) - 1; }
+
+/**
+ * Gets the mask of a width's bits.
+ *
+ * @param width The width.
+ *
+ * @return The mask.
+ */
+unsigned long long range_getMask_(unsigned width) { return width == 64 ? ~0ULL : (1ULL << width) - 1; }
+
+/**
+ * Gets the range of every integer of a width.
+ *
+ * @param width The width.
+ *
+ * @return The range.
+ */
+struct Range range_getFull_(unsigned width) {
+    return (struct Range){(long long)range_getMinimum_(width), (long long)range_getMaximum_(width), 0};
+}
+
+/**
+ * Gets the empty range.
+ *
+ * @return The range.
+ */
+struct Range range_getEmpty_(void) { return (struct Range){1, 0, 0}; }
+
+/**
+ * Gets whether a range is empty.
+ *
+ * @param RANGE The range.
+ *
+ * @return Whether it is empty.
+ */
+bool range_isEmpty_(struct Range RANGE) { return RANGE.min > RANGE.max; }
+
+/**
+ * Makes a range from bounds which may not fit in a width, as integers
+ * wrap.
+ *
+ * @param min   The smallest value.
+ * @param max   The largest value.
+ * @param width The width.
+ *
+ * @return The range, which is full if either bound does not fit.
+ */
+struct Range range_fromBounds_(__int128 min, __int128 max, unsigned width) {
+    if (min > max) {
+        return range_getEmpty_();
+    } else if (min < range_getMinimum_(width) || max > range_getMaximum_(width)) {
+        return range_getFull_(width);
+    }
+
+    return (struct Range){(long long)min, (long long)max, 0};
+}
+
+/**
+ * Makes known bits and an interval agree, tightening each with the other.
+ *
+ * @param range The range.
+ * @param width The width.
+ *
+ * @return The range.
+ */
+struct Range range_normalise_(struct Range range, unsigned width) {
+    unsigned long long mask = range_getMask_(width), signBit = 1ULL << (width - 1);
+
+    if (range_isEmpty_(range)) {
+        return range;
+    }
+
+    range.zeros &= mask;
+
+    if (range.zeros & signBit) { // Not negative, and at most the bits which may be set
+        range.min = range.min < 0 ? 0 : range.min;
+        range.max = range.max > (long long)(~range.zeros & mask) ? (long long)(~range.zeros & mask) : range.max;
+    }
+
+    if (range.min >= 0) { // Bits above the highest bit of max are 0
+        range.zeros |= range.max ? mask & ~((2ULL << (63 - __builtin_clzll((unsigned long long)range.max))) - 1) : mask;
+    }
+
+    return range;
+}
+
+/**
+ * Gets the smallest range containing two ranges.
+ *
+ * @param A The first range.
+ * @param B The second range.
+ *
+ * @return The range.
+ */
+struct Range range_union_(struct Range A, struct Range B) {
+    if (range_isEmpty_(A)) {
+        return B;
+    } else if (range_isEmpty_(B)) {
+        return A;
+    }
+
+    return (struct Range){A.min < B.min ? A.min : B.min, A.max > B.max ? A.max : B.max, A.zeros & B.zeros};
+}
+
+/**
+ * Gets the values two ranges have in common.
+ *
+ * @param A The first range.
+ * @param B The second range.
+ *
+ * @return The range.
+ */
+struct Range range_intersect_(struct Range A, struct Range B) {
+    return (struct Range){A.min > B.min ? A.min : B.min, A.max < B.max ? A.max : B.max, A.zeros | B.zeros};
+}
+
+/**
+ * Gets a range as unsigned integers, if it does not cross from negative to
+ * not negative.
+ *
+ * @param RANGE The range.
+ * @param width The width.
+ * @param min   Where to store the smallest unsigned value.
+ * @param max   Where to store the largest unsigned value.
+ */
+void range_getUnsigned_(struct Range RANGE, unsigned width, __int128 *min, __int128 *max) {
+    __int128 offset = (__int128)1 << width;
+
+    if (RANGE.min >= 0) {
+        *min = RANGE.min, *max = RANGE.max;
+    } else if (RANGE.max < 0) { // Negative integers are the top half
+        *min = RANGE.min + offset, *max = RANGE.max + offset;
+    } else {
+        *min = 0, *max = offset - 1;
+    }
+}
+
+/**
+ * Makes a range from unsigned bounds, if they are all in one half.
+ *
+ * @param min   The smallest unsigned value.
+ * @param max   The largest unsigned value.
+ * @param width The width.
+ *
+ * @return The range, which is full if the bounds cross halves.
+ */
+struct Range range_fromUnsigned_(__int128 min, __int128 max, unsigned width) {
+    __int128 offset = (__int128)1 << width;
+
+    if (min > max) {
+        return range_getEmpty_();
+    } else if (max <= range_getMaximum_(width)) {
+        return (struct Range){(long long)min, (long long)max, 0};
+    } else if (min > range_getMaximum_(width) && max < offset) {
+        return (struct Range){(long long)(min - offset), (long long)(max - offset), 0};
+    }
+
+    return range_getFull_(width);
+}
+
+/**
+ * Gets the predicate which is true when another is false.
+ *
+ * @param predicate The predicate.
+ *
+ * @return The inverse.
+ */
+LLVMIntPredicate range_invert_(LLVMIntPredicate predicate) {
+    switch (predicate) {
+    case LLVMIntEQ:
+        return LLVMIntNE;
+    case LLVMIntNE:
+        return LLVMIntEQ;
+    case LLVMIntSLT:
+        return LLVMIntSGE;
+    case LLVMIntSGE:
+        return LLVMIntSLT;
+    case LLVMIntSGT:
+        return LLVMIntSLE;
+    case LLVMIntSLE:
+        return LLVMIntSGT;
+    case LLVMIntULT:
+        return LLVMIntUGE;
+    case LLVMIntUGE:
+        return LLVMIntULT;
+    case LLVMIntUGT:
+        return LLVMIntULE;
+    default:
+        return LLVMIntUGT;
+    }
+}
+
+/**
+ * Gets the predicate which is true with the operands swapped.
+ *
+ * @param predicate The predicate.
+ *
+ * @return The swapped predicate.
+ */
+LLVMIntPredicate range_swap_(LLVMIntPredicate predicate) {
+    switch (predicate) {
+    case LLVMIntSLT:
+        return LLVMIntSGT;
+    case LLVMIntSGT:
+        return LLVMIntSLT;
+    case LLVMIntSLE:
+        return LLVMIntSGE;
+    case LLVMIntSGE:
+        return LLVMIntSLE;
+    case LLVMIntULT:
+        return LLVMIntUGT;
+    case LLVMIntUGT:
+        return LLVMIntULT;
+    case LLVMIntULE:
+        return LLVMIntUGE;
+    case LLVMIntUGE:
+        return LLVMIntULE;
+    default:
+        return predicate;
+    }
+}
+
+/**
+ * Gets the entry of a value in an analysis.
+ *
+ * @param analysis The analysis.
+ * @param value    The value.
+ * @param insert   Whether to add the value if it has no entry.
+ *
+ * @return The entry, or NULL if it has none.
+ */
+struct RangeEntry *range_getEntry_(struct RangeAnalysis *analysis, LLVMValueRef value, bool insert) {
+    size_t index = (size_t)(((uintptr_t)value >> 4) * 0x9E3779B97F4A7C15ULL) & (analysis->capacity - 1);
+
+    for (; analysis->entries[index].value; index = (index + 1) & (analysis->capacity - 1)) {
+        if (analysis->entries[index].value == value) {
+            return &analysis->entries[index];
+        }
+    }
+
+    if (!insert) {
+        return NULL;
+    }
+
+    analysis->entries[index].value = value;
+
+    return &analysis->entries[index];
+}
+
+/**
+ * Gets the range of a value.
+ *
+ * @param analysis The analysis.
+ * @param value    The value, an integer of at most 64 bits.
+ *
+ * @return The range.
+ */
+struct Range range_get_(struct RangeAnalysis *analysis, LLVMValueRef value) {
+    unsigned width = range_getWidth_(value);
+    struct RangeEntry *entry = NULL;
+
+    if (LLVMIsAConstantInt(value)) {
+        long long constant = LLVMConstIntGetSExtValue(value);
+
+        return range_normalise_((struct Range){constant, constant, ~(unsigned long long)constant}, width);
+    } else if (LLVMIsAUndefValue(value) || !(entry = range_getEntry_(analysis, value, false))) {
+        return range_getFull_(width);
+    }
+
+    return entry->range;
+}
+
+/**
+ * Narrows a range with a comparison known to be true of it.
+ *
+ * @param range     The range of the left operand.
+ * @param predicate The comparison.
+ * @param OTHER     The range of the right operand.
+ * @param width     The width.
+ *
+ * @return The range.
+ */
+struct Range range_refine_(struct Range range, LLVMIntPredicate predicate, struct Range OTHER, unsigned width) {
+    __int128 min = range.min, max = range.max, otherMin = OTHER.min, otherMax = OTHER.max;
+    struct Range limit = range_getFull_(width);
+
+    if (range_isEmpty_(range) || range_isEmpty_(OTHER)) {
+        return range;
+    }
+
+    if (predicate >= LLVMIntUGT && predicate <= LLVMIntULE) { // Narrowed as unsigned integers, then converted back
+        range_getUnsigned_(range, width, &min, &max);
+        range_getUnsigned_(OTHER, width, &otherMin, &otherMax);
+    }
+
+    switch (predicate) {
+    case LLVMIntEQ:
+        return range_intersect_(range, OTHER);
+    case LLVMIntNE:
+        if (OTHER.min == OTHER.max && range.min == OTHER.min) {
+            range.min++;
+        } else if (OTHER.min == OTHER.max && range.max == OTHER.min) {
+            range.max--;
+        }
+
+        return range;
+    case LLVMIntSLT:
+    case LLVMIntULT:
+        max = max < otherMax - 1 ? max : otherMax - 1;
+        break;
+    case LLVMIntSLE:
+    case LLVMIntULE:
+        max = max < otherMax ? max : otherMax;
+        break;
+    case LLVMIntSGT:
+    case LLVMIntUGT:
+        min = min > otherMin + 1 ? min : otherMin + 1;
+        break;
+    default:
+        min = min > otherMin ? min : otherMin;
+        break;
+    }
+
+    if (min > max) {
+        return range_getEmpty_();
+    }
+
+    limit = predicate >= LLVMIntUGT && predicate <= LLVMIntULE ? range_fromUnsigned_(min, max, width)
+                                                               : (struct Range){(long long)min, (long long)max, 0};
+
+    return range_normalise_(range_intersect_(range, limit), width);
+}
+
+/**
+ * Gets the range of a value where some comparisons are known to be true.
+ *
+ * @param analysis The analysis.
+ * @param value    The value.
+ * @param facts    The comparisons.
+ *
+ * @return The range.
+ */
+struct Range range_getRefined_(struct RangeAnalysis *analysis, LLVMValueRef value, struct Array *facts) {
+    unsigned width = range_getWidth_(value);
+    struct Range range = range_get_(analysis, value);
+
+    for (size_t index = 0; facts && index < facts->length; index++) {
+        const struct RangeFact *FACT = array_get(facts, index);
+
+        if (FACT->left == value) {
+            range = range_refine_(range, FACT->predicate, range_get_(analysis, FACT->right), width);
+        } else if (FACT->right == value) {
+            range = range_refine_(range, range_swap_(FACT->predicate), range_get_(analysis, FACT->left), width);
+        }
+    }
+
+    return range;
+}
+
+/**
+ * Gets whether a value is defined in one of some blocks.
+ *
+ * @param value  The value.
+ * @param blocks The blocks, or NULL.
+ *
+ * @return Whether it is defined in them.
+ */
+bool range_isDefinedIn_(LLVMValueRef value, struct Array *blocks) {
+    for (size_t index = 0; blocks && LLVMIsAInstruction(value) && index < blocks->length; index++) {
+        if (array_get(blocks, index) == LLVMGetInstructionParent(value)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Adds the comparisons which must be true for a condition to have a value.
+ *
+ * @param analysis  The analysis, which owns the facts.
+ * @param facts     Where to add the comparisons.
+ * @param condition The condition.
+ * @param value     The condition's value.
+ * @param excluded  Blocks which redefine values if they run again, so
+ * comparisons of values from them are left out, or NULL.
+ */
+void range_addConditionFacts_(struct RangeAnalysis *analysis, struct Array *facts, LLVMValueRef condition, bool value,
+                              struct Array *excluded) {
+    struct RangeFact *fact = NULL;
+    LLVMOpcode opcode = LLVMIsAInstruction(condition) ? LLVMGetInstructionOpcode(condition) : LLVMRet;
+
+    if (opcode == LLVMICmp && range_getWidth_(LLVMGetOperand(condition, 0))) {
+        if (range_isDefinedIn_(LLVMGetOperand(condition, 0), excluded) ||
+            range_isDefinedIn_(LLVMGetOperand(condition, 1), excluded)) {
+            return;
+        }
+
+        fact = malloc(RANGE_FACT_STRUCT_SIZE);
+
+        if (!fact) {
+            panic("failed to malloc RangeFact struct");
+        }
+
+        fact->predicate = value ? LLVMGetICmpPredicate(condition) : range_invert_(LLVMGetICmpPredicate(condition));
+        fact->left = LLVMGetOperand(condition, 0);
+        fact->right = LLVMGetOperand(condition, 1);
+
+        array_insert(analysis->ownedFacts, analysis->ownedFacts->length, fact);
+        array_insert(facts, facts->length, fact);
+    } else if ((opcode == LLVMAnd && value) || (opcode == LLVMOr && !value)) { // Both sides have the value
+        range_addConditionFacts_(analysis, facts, LLVMGetOperand(condition, 0), value, excluded);
+        range_addConditionFacts_(analysis, facts, LLVMGetOperand(condition, 1), value, excluded);
+    }
+}
+
+/**
+ * Adds the comparisons known to be true when a branch goes from one block
+ * to another.
+ *
+ * @param analysis    The analysis.
+ * @param facts       Where to add the comparisons.
+ * @param predecessor The block branching.
+ * @param block       The block branched to.
+ * @param excluded    Blocks whose values are left out, or NULL.
+ */
+void range_addEdgeFacts_(struct RangeAnalysis *analysis, struct Array *facts, LLVMBasicBlockRef predecessor,
+                         LLVMBasicBlockRef block, struct Array *excluded) {
+    LLVMValueRef terminator = LLVMGetBasicBlockTerminator(predecessor);
+
+    if (terminator && LLVMIsABranchInst(terminator) && LLVMIsConditional(terminator) &&
+        LLVMGetSuccessor(terminator, 0) != LLVMGetSuccessor(terminator, 1)) {
+        range_addConditionFacts_(analysis, facts, LLVMGetCondition(terminator), LLVMGetSuccessor(terminator, 0) == block,
+                                 excluded);
+    }
+}
+
+/**
+ * Gets the index of a block in an analysis.
+ *
+ * @param ANALYSIS The analysis.
+ * @param block    The block.
+ *
+ * @return The index.
+ */
+size_t range_getBlockIndex_(const struct RangeAnalysis *ANALYSIS, LLVMBasicBlockRef block) {
+    size_t index = 0;
+
+    while (ANALYSIS->blocks[index] != block) {
+        index++;
+    }
+
+    return index;
+}
+
+/**
+ * Finds the blocks of a function, their only predecessors, whether they
+ * are in loops, and the comparisons known to be true in them from the
+ * branches on the way there.
+ *
+ * @param analysis The analysis.
+ * @param function The function.
+ */
+void range_analyseBlocks_(struct RangeAnalysis *analysis, LLVMValueRef function) {
+    size_t *counts = NULL;
+
+    analysis->blocksLength = LLVMCountBasicBlocks(function);
+    analysis->blocks = calloc(analysis->blocksLength + 1, sizeof(LLVMBasicBlockRef));
+    analysis->predecessors = calloc(analysis->blocksLength + 1, sizeof(LLVMBasicBlockRef));
+    analysis->cyclic = calloc(analysis->blocksLength + 1, sizeof(bool));
+    analysis->facts = calloc(analysis->blocksLength + 1, sizeof(struct Array *));
+    counts = calloc(analysis->blocksLength + 1, sizeof(size_t));
+
+    if (!analysis->blocks || !analysis->predecessors || !analysis->cyclic || !analysis->facts || !counts) {
+        panic("failed to calloc range analysis blocks");
+    }
+
+    LLVMGetBasicBlocks(function, analysis->blocks);
+
+    for (size_t index = 0; index < analysis->blocksLength; index++) {
+        LLVMValueRef terminator = LLVMGetBasicBlockTerminator(analysis->blocks[index]);
+
+        for (unsigned successor = 0; terminator && successor < LLVMGetNumSuccessors(terminator); successor++) {
+            size_t successorIndex = range_getBlockIndex_(analysis, LLVMGetSuccessor(terminator, successor));
+
+            analysis->predecessors[successorIndex] = counts[successorIndex]++ ? NULL : analysis->blocks[index];
+        }
+    }
+
+    for (size_t index = 0; index < analysis->blocksLength; index++) { // Blocks reachable from themselves
+        struct Array *visited = array_new();
+
+        array_insert(visited, 0, analysis->blocks[index]);
+
+        for (size_t cursor = 0; cursor < visited->length && !analysis->cyclic[index]; cursor++) {
+            LLVMValueRef terminator = LLVMGetBasicBlockTerminator((LLVMBasicBlockRef)array_get(visited, cursor));
+
+            for (unsigned successor = 0; terminator && successor < LLVMGetNumSuccessors(terminator); successor++) {
+                LLVMBasicBlockRef block = LLVMGetSuccessor(terminator, successor);
+                bool seen = false;
+
+                analysis->cyclic[index] |= block == analysis->blocks[index];
+
+                for (size_t visitedIndex = 0; visitedIndex < visited->length && !seen; visitedIndex++) {
+                    seen = array_get(visited, visitedIndex) == block;
+                }
+
+                if (!seen) {
+                    array_insert(visited, visited->length, block);
+                }
+            }
+        }
+
+        array_free(&visited);
+    }
+
+    for (size_t index = 0; index < analysis->blocksLength; index++) { // Conditions on the way into the block
+        struct Array *chain = array_new();
+        size_t current = index;
+
+        analysis->facts[index] = array_new();
+        array_insert(chain, 0, analysis->blocks[index]);
+
+        for (size_t depth = 0; depth < RANGE_MAX_FACT_DEPTH && counts[current] == 1; depth++) {
+            range_addEdgeFacts_(analysis, analysis->facts[index], analysis->predecessors[current],
+                                analysis->blocks[current], chain);
+
+            current = range_getBlockIndex_(analysis, analysis->predecessors[current]);
+            array_insert(chain, chain->length, analysis->blocks[current]);
+        }
+
+        array_free(&chain);
+    }
+
+    free(counts);
+}
+
+/**
+ * Gets the range of a call to an intrinsic.
+ *
+ * @param analysis The analysis.
+ * @param call     The call.
+ * @param facts    The comparisons known to be true.
+ * @param width    The width of the result.
+ *
+ * @return The range.
+ */
+struct Range range_evaluateIntrinsic_(struct RangeAnalysis *analysis, LLVMValueRef call, struct Array *facts,
+                                      unsigned width) {
+    LLVMValueRef callee = LLVMGetCalledValue(call);
+    const char *NAME = LLVMIsAFunction(callee) ? LLVMGetValueName(callee) : "";
+    struct Range left = range_getFull_(width), right = range_getFull_(width);
+
+    if (strncmp(NAME, "llvm.ctpop.", 11) == 0 || strncmp(NAME, "llvm.ctlz.", 10) == 0 ||
+        strncmp(NAME, "llvm.cttz.", 10) == 0) {
+        return range_fromBounds_(0, width, width);
+    } else if (strncmp(NAME, "llvm.s", 6) != 0 && strncmp(NAME, "llvm.u", 6) != 0 && strncmp(NAME, "llvm.abs.", 9) != 0) {
+        return range_getFull_(width);
+    }
+
+    left = range_getRefined_(analysis, LLVMGetOperand(call, 0), facts);
+    right = LLVMGetNumArgOperands(call) > 1 && range_getWidth_(LLVMGetOperand(call, 1))
+                ? range_getRefined_(analysis, LLVMGetOperand(call, 1), facts)
+                : right;
+
+    if (range_isEmpty_(left) || range_isEmpty_(right)) {
+        return range_getEmpty_();
+    } else if (strncmp(NAME, "llvm.smin.", 10) == 0 ||
+               (strncmp(NAME, "llvm.umin.", 10) == 0 && left.min >= 0 && right.min >= 0)) {
+        return (struct Range){left.min < right.min ? left.min : right.min, left.max < right.max ? left.max : right.max, 0};
+    } else if (strncmp(NAME, "llvm.smax.", 10) == 0 ||
+               (strncmp(NAME, "llvm.umax.", 10) == 0 && left.min >= 0 && right.min >= 0)) {
+        return (struct Range){left.min > right.min ? left.min : right.min, left.max > right.max ? left.max : right.max, 0};
+    } else if (strncmp(NAME, "llvm.abs.", 9) == 0) { // abs(INT_MIN) is INT_MIN unless it is poison
+        if (left.min >= 0) {
+            return left;
+        } else if (left.max <= 0 && left.min > range_getMinimum_(width)) {
+            return (struct Range){-left.max, -left.min, 0};
+        }
+
+        return left.min > range_getMinimum_(width)
+                   ? (struct Range){0, -left.min > left.max ? -left.min : left.max, 0}
+                   : range_getFull_(width);
+    }
+
+    return range_getFull_(width);
+}
+
+/**
+ * Gets the range of a binary operator's result, as if it could not
+ * overflow.
+ *
+ * @param OPCODE The operator.
+ * @param LEFT   The range of the left operand.
+ * @param RIGHT  The range of the right operand.
+ * @param min    Where to store the smallest result.
+ * @param max    Where to store the largest result.
+ *
+ * @return Whether the operator is supported.
+ */
+bool range_evaluateExact_(const LLVMOpcode OPCODE, const struct Range LEFT, const struct Range RIGHT, __int128 *min,
+                          __int128 *max) {
+    __int128 products[4] = {0};
+
+    switch (OPCODE) {
+    case LLVMAdd:
+        *min = (__int128)LEFT.min + RIGHT.min, *max = (__int128)LEFT.max + RIGHT.max;
+        return true;
+    case LLVMSub:
+        *min = (__int128)LEFT.min - RIGHT.max, *max = (__int128)LEFT.max - RIGHT.min;
+        return true;
+    case LLVMMul:
+        products[0] = (__int128)LEFT.min * RIGHT.min, products[1] = (__int128)LEFT.min * RIGHT.max;
+        products[2] = (__int128)LEFT.max * RIGHT.min, products[3] = (__int128)LEFT.max * RIGHT.max;
+        *min = *max = products[0];
+
+        for (size_t index = 1; index < 4; index++) {
+            *min = products[index] < *min ? products[index] : *min;
+            *max = products[index] > *max ? products[index] : *max;
+        }
+
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * Gets the range of a signed division, where the divisor is not 0.
+ *
+ * @param LEFT  The range of the dividend.
+ * @param RIGHT The range of the divisor, all on one side of 0.
+ * @param width The width.
+ *
+ * @return The range.
+ */
+struct Range range_evaluateDivision_(const struct Range LEFT, const struct Range RIGHT, unsigned width) {
+    __int128 quotients[4] = {(__int128)LEFT.min / RIGHT.min, (__int128)LEFT.min / RIGHT.max,
+                             (__int128)LEFT.max / RIGHT.min, (__int128)LEFT.max / RIGHT.max};
+    __int128 min = quotients[0], max = quotients[0];
+
+    for (size_t index = 1; index < 4; index++) {
+        min = quotients[index] < min ? quotients[index] : min;
+        max = quotients[index] > max ? quotients[index] : max;
+    }
+
+    return range_fromBounds_(min, max, width);
+}
+
+/**
+ * Gets the select to split a binary operator on, one of its operands in the
+ * same block whose condition is a comparison. Its sides' ranges alone
+ * forget which side goes with which values of the compared integers, e.g.
+ * 'i + (i > 58 ? -59 : 5)' is below 64 when i is.
+ *
+ * @param instruction The binary operator.
+ * @param facts       The comparisons known to be true in its block.
+ *
+ * @return The select, or NULL if there is none or it is already split.
+ */
+LLVMValueRef range_getSplit_(LLVMValueRef instruction, struct Array *facts) {
+    for (unsigned index = 0; LLVMIsABinaryOperator(instruction) && index < 2; index++) {
+        LLVMValueRef select = LLVMGetOperand(instruction, index), condition = NULL;
+        bool split = false;
+
+        if (!LLVMIsASelectInst(select) || LLVMGetInstructionParent(select) != LLVMGetInstructionParent(instruction) ||
+            !LLVMIsAICmpInst(condition = LLVMGetOperand(select, 0)) || !range_getWidth_(LLVMGetOperand(condition, 0))) {
+            continue;
+        }
+
+        for (size_t factIndex = 0; facts && factIndex < facts->length && !split; factIndex++) {
+            const struct RangeFact *FACT = array_get(facts, factIndex);
+
+            split = FACT->predicate == LLVMIntEQ && FACT->left == select;
+        }
+
+        if (!split) {
+            return select;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Gets the range of an instruction from the ranges of its operands.
+ *
+ * @param analysis    The analysis.
+ * @param instruction The instruction, an integer of at most 64 bits.
+ * @param facts       The comparisons known to be true in its block.
+ *
+ * @return The range.
+ */
+struct Range range_evaluate_(struct RangeAnalysis *analysis, LLVMValueRef instruction, struct Array *facts) {
+    LLVMOpcode opcode = LLVMGetInstructionOpcode(instruction);
+    unsigned width = range_getWidth_(instruction), operandWidth = 0;
+    unsigned long long mask = range_getMask_(width), shift = 0;
+    struct Range left = range_getFull_(width), right = range_getFull_(width), result = range_getFull_(width);
+    __int128 min = 0, max = 0, magnitude = 0;
+    LLVMValueRef aggregate = NULL, select = range_getSplit_(instruction, facts);
+
+    if (select) { // Once for each side, where the select is that side and its condition has the value picking it
+        LLVMValueRef condition = LLVMGetOperand(select, 0);
+        struct Range split = range_getEmpty_();
+
+        for (unsigned side = 1; side <= 2; side++) {
+            struct RangeFact picked = {side == 1 ? LLVMGetICmpPredicate(condition)
+                                                 : range_invert_(LLVMGetICmpPredicate(condition)),
+                                       LLVMGetOperand(condition, 0), LLVMGetOperand(condition, 1)},
+                             equal = {LLVMIntEQ, select, LLVMGetOperand(select, side)};
+            struct Array *sideFacts = array_new();
+
+            for (size_t index = 0; facts && index < facts->length; index++) {
+                array_insert(sideFacts, sideFacts->length, array_get(facts, index));
+            }
+
+            array_insert(sideFacts, sideFacts->length, &picked);
+            array_insert(sideFacts, sideFacts->length, &equal);
+            split = range_union_(split, range_evaluate_(analysis, instruction, sideFacts));
+            array_free(&sideFacts);
+        }
+
+        return split;
+    }
+
+    if (LLVMGetNumOperands(instruction) > 0 && (operandWidth = range_getWidth_(LLVMGetOperand(instruction, 0)))) {
+        left = range_getRefined_(analysis, LLVMGetOperand(instruction, 0), facts);
+    }
+
+    if (LLVMGetNumOperands(instruction) > 1 && range_getWidth_(LLVMGetOperand(instruction, 1)) == width &&
+        opcode != LLVMSelect) {
+        right = range_getRefined_(analysis, LLVMGetOperand(instruction, 1), facts);
+    }
+
+    if ((operandWidth && range_isEmpty_(left)) || range_isEmpty_(right)) {
+        return range_getEmpty_();
+    }
+
+    switch (opcode) {
+    case LLVMAdd:
+    case LLVMSub:
+    case LLVMMul:
+        range_evaluateExact_(opcode, left, right, &min, &max);
+        result = range_fromBounds_(min, max, width);
+        break;
+    case LLVMUDiv:
+    case LLVMSDiv:
+        if (opcode == LLVMUDiv && (left.min < 0 || right.min < 0)) {
+            break;
+        } else if (right.min > 0 || right.max < 0) {
+            result = range_evaluateDivision_(left, right, width);
+        } else { // Either side of 0, which cannot be divided by
+            result = range_union_(right.min < 0 ? range_evaluateDivision_(left, (struct Range){right.min, -1, 0}, width)
+                                                : range_getEmpty_(),
+                                  right.max > 0 ? range_evaluateDivision_(left, (struct Range){1, right.max, 0}, width)
+                                                : range_getEmpty_());
+        }
+
+        break;
+    case LLVMURem:
+        if (right.min >= 0 && right.max > 0) { // Less than the divisor, and no more than the dividend
+            result = (struct Range){0, left.min >= 0 && left.max < right.max - 1 ? left.max : right.max - 1, 0};
+        }
+
+        break;
+    case LLVMSRem:
+        magnitude = -(__int128)right.min > right.max ? -(__int128)right.min : right.max;
+        min = left.min < 0 ? (left.min > -(magnitude - 1) ? left.min : -(magnitude - 1)) : 0;
+        max = left.max > 0 ? (left.max < magnitude - 1 ? left.max : magnitude - 1) : 0;
+        result = range_fromBounds_(min, max, width);
+        break;
+    case LLVMAnd:
+        if (left.min >= 0 || right.min >= 0) {
+            result.min = 0;
+            result.max = left.min >= 0 && right.min >= 0 ? (left.max < right.max ? left.max : right.max)
+                                                         : (left.min >= 0 ? left.max : right.max);
+        } else if (left.max < 0 && right.max < 0) {
+            result.max = -1;
+        }
+
+        result.zeros = left.zeros | right.zeros;
+        break;
+    case LLVMOr:
+    case LLVMXor:
+        if (left.min >= 0 && right.min >= 0) {
+            max = left.max > right.max ? left.max : right.max;
+            result = (struct Range){opcode == LLVMOr ? (left.min > right.min ? left.min : right.min) : 0,
+                                    max ? (long long)((2ULL << (63 - __builtin_clzll((unsigned long long)max))) - 1) : 0,
+                                    0};
+        } else if (opcode == LLVMOr && (left.max < 0 || right.max < 0)) { // Stays negative
+            result.max = -1;
+        }
+
+        result.zeros = left.zeros & right.zeros;
+        break;
+    case LLVMShl:
+    case LLVMLShr:
+    case LLVMAShr:
+        if (!LLVMIsAConstantInt(LLVMGetOperand(instruction, 1)) ||
+            (shift = LLVMConstIntGetZExtValue(LLVMGetOperand(instruction, 1))) >= width) {
+            result = opcode == LLVMLShr && left.min >= 0   ? (struct Range){0, left.max, 0}
+                     : opcode == LLVMAShr                  ? (struct Range){left.min < 0 ? left.min : 0,
+                                                                            left.max < 0 ? -1 : left.max, 0}
+                                                           : result;
+        } else if (opcode == LLVMShl) {
+            result = range_fromBounds_((__int128)left.min << shift, (__int128)left.max << shift, width);
+            result.zeros = (left.zeros << shift) | ((1ULL << shift) - 1);
+        } else if (opcode == LLVMAShr) {
+            result = (struct Range){left.min >> shift, left.max >> shift, 0};
+        } else if (left.min >= 0) {
+            result = (struct Range){left.min >> shift, left.max >> shift, 0};
+        } else if (shift) {
+            result = (struct Range){0, (long long)(mask >> shift), (left.zeros & mask) >> shift | ~(mask >> shift)};
+        }
+
+        break;
+    case LLVMZExt:
+        result = left.min >= 0 ? left : (struct Range){0, (long long)range_getMask_(operandWidth), 0};
+        result.zeros |= ~range_getMask_(operandWidth);
+        break;
+    case LLVMSExt:
+        result = left;
+        break;
+    case LLVMTrunc:
+        result = left.min >= range_getMinimum_(width) && left.max <= range_getMaximum_(width) ? left : result;
+        result.zeros = left.zeros;
+        break;
+    case LLVMSelect:
+        result = range_union_(range_getRefined_(analysis, LLVMGetOperand(instruction, 1), facts),
+                              range_getRefined_(analysis, LLVMGetOperand(instruction, 2), facts));
+        break;
+    case LLVMCall:
+        result = range_evaluateIntrinsic_(analysis, instruction, facts, width);
+        break;
+    case LLVMExtractValue: // The result of an arithmetic intrinsic checking for overflow, which wraps
+        aggregate = LLVMGetOperand(instruction, 0);
+
+        if (LLVMIsACallInst(aggregate) && LLVMGetIndices(instruction)[0] == 0 &&
+            LLVMIsAFunction(LLVMGetCalledValue(aggregate)) &&
+            strstr(LLVMGetValueName(LLVMGetCalledValue(aggregate)), ".with.overflow.")) {
+            const char *NAME = LLVMGetValueName(LLVMGetCalledValue(aggregate));
+
+            left = range_getRefined_(analysis, LLVMGetOperand(aggregate, 0), facts);
+            right = range_getRefined_(analysis, LLVMGetOperand(aggregate, 1), facts);
+
+            if (range_isEmpty_(left) || range_isEmpty_(right)) {
+                return range_getEmpty_();
+            } else if (range_evaluateExact_(strstr(NAME, "add") ? LLVMAdd : (strstr(NAME, "sub") ? LLVMSub : LLVMMul),
+                                            left, right, &min, &max) &&
+                       NAME[5] == 's') {
+                result = range_fromBounds_(min, max, width);
+            }
+        }
+
+        break;
+    default:
+        break;
+    }
+
+    return range_normalise_(result, width);
+}
+
+/**
+ * Gets the range of a phi from the values coming into it, each narrowed by
+ * the branch it comes along.
+ *
+ * @param analysis The analysis.
+ * @param phi      The phi.
+ * @param limit    Where to store the most the branches allow, or NULL.
+ *
+ * @return The range.
+ */
+struct Range range_evaluatePhi_(struct RangeAnalysis *analysis, LLVMValueRef phi, struct Range *limit) {
+    unsigned width = range_getWidth_(phi);
+    struct Range result = range_getEmpty_();
+
+    if (limit) {
+        *limit = range_getEmpty_();
+    }
+
+    for (unsigned index = 0; index < LLVMCountIncoming(phi); index++) {
+        LLVMBasicBlockRef predecessor = LLVMGetIncomingBlock(phi, index);
+        LLVMValueRef value = LLVMGetIncomingValue(phi, index);
+        struct Array *facts = array_new();
+        struct Array *predecessorFacts = analysis->facts[range_getBlockIndex_(analysis, predecessor)];
+        struct Range full = LLVMIsAConstantInt(value) ? range_get_(analysis, value) : range_getFull_(width);
+
+        for (size_t factIndex = 0; factIndex < predecessorFacts->length; factIndex++) {
+            array_insert(facts, facts->length, array_get(predecessorFacts, factIndex));
+        }
+
+        range_addEdgeFacts_(analysis, facts, predecessor, LLVMGetInstructionParent(phi), NULL);
+        result = range_union_(result, range_getRefined_(analysis, value, facts));
+
+        if (limit) { // What the branch allows of any value, e.g. 'i < n' allows up to n - 1
+            for (size_t factIndex = 0; factIndex < facts->length; factIndex++) {
+                const struct RangeFact *FACT = array_get(facts, factIndex);
+
+                if (FACT->left == value) {
+                    full = range_refine_(full, FACT->predicate, range_get_(analysis, FACT->right), width);
+                } else if (FACT->right == value) {
+                    full = range_refine_(full, range_swap_(FACT->predicate), range_get_(analysis, FACT->left), width);
+                }
+            }
+
+            *limit = range_union_(*limit, full);
+        }
+
+        array_free(&facts);
+    }
+
+    return result;
+}
+
+/**
+ * Runs one pass over a function, updating the range of each value from its
+ * operands.
+ *
+ * @param analysis The analysis.
+ * @param narrowing Whether ranges can only shrink, after widening.
+ *
+ * @return Whether any range changed.
+ */
+bool range_runPass_(struct RangeAnalysis *analysis, bool narrowing) {
+    bool changed = false;
+
+    for (size_t blockIndex = 0; blockIndex < analysis->blocksLength; blockIndex++) {
+        for (LLVMValueRef instruction = LLVMGetFirstInstruction(analysis->blocks[blockIndex]); instruction;
+             instruction = LLVMGetNextInstruction(instruction)) {
+            struct RangeEntry *entry = range_getWidth_(instruction) ? range_getEntry_(analysis, instruction, false) : NULL;
+            struct Range range = {0}, limit = {0};
+
+            if (!entry) {
+                continue;
+            }
+
+            range = LLVMIsAPHINode(instruction) ? range_evaluatePhi_(analysis, instruction, &limit)
+                                                : range_evaluate_(analysis, instruction, analysis->facts[blockIndex]);
+
+            if (narrowing) {
+                range = range_isEmpty_(entry->range) ? entry->range : range_intersect_(entry->range, range);
+            } else {
+                range = range_union_(entry->range, range);
+
+                if (LLVMIsAPHINode(instruction) && !range_isEmpty_(entry->range) &&
+                    ++entry->updates > RANGE_WIDENING_UPDATES) { // Jump to what the loop allows, so it ends
+                    limit = range_isEmpty_(limit) ? range_getFull_(range_getWidth_(instruction)) : limit;
+                    range.min = range.min < entry->range.min ? (limit.min < range.min ? limit.min : range.min) : range.min;
+                    range.max = range.max > entry->range.max ? (limit.max > range.max ? limit.max : range.max) : range.max;
+                    range.zeros = 0;
+                }
+            }
+
+            range = range_normalise_(range, range_getWidth_(instruction));
+
+            if (range.min != entry->range.min || range.max != entry->range.max || range.zeros != entry->range.zeros) {
+                entry->range = range;
+                changed = true;
+            }
+        }
+    }
+
+    return changed;
+}
+
+/**
+ * Gets whether one comparison being true means another is, for the same
+ * operands.
+ *
+ * @param analysis The analysis.
+ * @param known    The comparison known to be true.
+ * @param wanted   The other comparison.
+ * @param left     The left operand.
+ * @param right    The right operand.
+ *
+ * @return Whether the other comparison is true.
+ */
+bool range_implies_(struct RangeAnalysis *analysis, LLVMIntPredicate known, LLVMIntPredicate wanted, LLVMValueRef left,
+                    LLVMValueRef right) {
+    bool leftPositive = range_get_(analysis, left).min >= 0, rightPositive = range_get_(analysis, right).min >= 0;
+
+    if (known == wanted) {
+        return true;
+    }
+
+    switch (known) {
+    case LLVMIntEQ:
+        return wanted == LLVMIntSLE || wanted == LLVMIntSGE || wanted == LLVMIntULE || wanted == LLVMIntUGE;
+    case LLVMIntSLT: // A signed comparison of integers which are not negative is also an unsigned one
+        return wanted == LLVMIntSLE || wanted == LLVMIntNE ||
+               (leftPositive && (wanted == LLVMIntULT || wanted == LLVMIntULE));
+    case LLVMIntSLE:
+        return leftPositive && wanted == LLVMIntULE;
+    case LLVMIntSGT:
+        return wanted == LLVMIntSGE || wanted == LLVMIntNE ||
+               (rightPositive && (wanted == LLVMIntUGT || wanted == LLVMIntUGE));
+    case LLVMIntSGE:
+        return rightPositive && wanted == LLVMIntUGE;
+    case LLVMIntULT:
+        return wanted == LLVMIntULE || wanted == LLVMIntNE ||
+               (rightPositive && (wanted == LLVMIntSLT || wanted == LLVMIntSLE));
+    case LLVMIntULE:
+        return rightPositive && wanted == LLVMIntSLE;
+    case LLVMIntUGT:
+        return wanted == LLVMIntUGE || wanted == LLVMIntNE ||
+               (leftPositive && (wanted == LLVMIntSGT || wanted == LLVMIntSGE));
+    case LLVMIntUGE:
+        return leftPositive && wanted == LLVMIntSGE;
+    default:
+        return false;
+    }
+}
+
+/**
+ * Gets whether a value is never 0, which a range cannot always show, as
+ * ORing in a set bit leaves a value of any sign.
+ *
+ * @param analysis The analysis.
+ * @param value    The value.
+ * @param facts    The comparisons known to be true.
+ *
+ * @return Whether the value is never 0.
+ */
+bool range_isNonZero_(struct RangeAnalysis *analysis, LLVMValueRef value, struct Array *facts) {
+    struct Range range = range_getRefined_(analysis, value, facts);
+
+    if (!range_isEmpty_(range) && (range.min > 0 || range.max < 0)) {
+        return true;
+    }
+
+    return LLVMIsAInstruction(value) && LLVMGetInstructionOpcode(value) == LLVMOr &&
+           (range_isNonZero_(analysis, LLVMGetOperand(value, 0), facts) ||
+            range_isNonZero_(analysis, LLVMGetOperand(value, 1), facts));
+}
+
+/**
+ * Decides a comparison from the ranges of its operands and the comparisons
+ * known to be true.
+ *
+ * @param analysis  The analysis.
+ * @param predicate The comparison.
+ * @param left      The left operand.
+ * @param right     The right operand.
+ * @param facts     The comparisons known to be true.
+ *
+ * @return 1 if it is always true, 0 if it is always false, else -1.
+ */
+int range_decideComparison_(struct RangeAnalysis *analysis, LLVMIntPredicate predicate, LLVMValueRef left,
+                            LLVMValueRef right, struct Array *facts) {
+    unsigned width = range_getWidth_(left);
+    struct Range leftRange = range_getRefined_(analysis, left, facts),
+                 rightRange = range_getRefined_(analysis, right, facts);
+    __int128 leftMin = leftRange.min, leftMax = leftRange.max, rightMin = rightRange.min, rightMax = rightRange.max;
+
+    for (size_t index = 0; facts && index < facts->length; index++) {
+        const struct RangeFact *FACT = array_get(facts, index);
+        LLVMIntPredicate known = FACT->predicate;
+
+        if (FACT->left == right && FACT->right == left) {
+            known = range_swap_(known);
+        } else if (FACT->left != left || FACT->right != right) {
+            continue;
+        }
+
+        if (range_implies_(analysis, known, predicate, left, right)) {
+            return 1;
+        } else if (range_implies_(analysis, known, range_invert_(predicate), left, right)) {
+            return 0;
+        }
+    }
+
+    if (range_isEmpty_(leftRange) || range_isEmpty_(rightRange)) { // Cannot run, so is left to LLVM
+        return -1;
+    } else if (predicate >= LLVMIntUGT && predicate <= LLVMIntULE) {
+        range_getUnsigned_(leftRange, width, &leftMin, &leftMax);
+        range_getUnsigned_(rightRange, width, &rightMin, &rightMax);
+    }
+
+    switch (predicate) {
+    case LLVMIntEQ:
+    case LLVMIntNE:
+        if (leftMin == leftMax && rightMin == rightMax && leftMin == rightMin) {
+            return predicate == LLVMIntEQ;
+        } else if (leftMax < rightMin || rightMax < leftMin ||
+                   (rightMin == rightMax && (leftRange.zeros & (unsigned long long)rightRange.min)) ||
+                   (leftMin == leftMax && (rightRange.zeros & (unsigned long long)leftRange.min))) { // A bit differs
+            return predicate == LLVMIntNE;
+        } else if ((rightMin == 0 && rightMax == 0 && range_isNonZero_(analysis, left, facts)) ||
+                   (leftMin == 0 && leftMax == 0 && range_isNonZero_(analysis, right, facts))) {
+            return predicate == LLVMIntNE;
+        }
+
+        return -1;
+    case LLVMIntSLT:
+    case LLVMIntULT:
+        return leftMax < rightMin ? 1 : (leftMin >= rightMax ? 0 : -1);
+    case LLVMIntSLE:
+    case LLVMIntULE:
+        return leftMax <= rightMin ? 1 : (leftMin > rightMax ? 0 : -1);
+    case LLVMIntSGT:
+    case LLVMIntUGT:
+        return leftMin > rightMax ? 1 : (leftMax <= rightMin ? 0 : -1);
+    default:
+        return leftMin >= rightMax ? 1 : (leftMax < rightMin ? 0 : -1);
+    }
+}
+
+/**
+ * Decides whether an arithmetic intrinsic checking for overflow can
+ * overflow.
+ *
+ * @param analysis The analysis.
+ * @param call     The call to the intrinsic.
+ * @param facts    The comparisons known to be true.
+ *
+ * @return 0 if it never overflows, else -1.
+ */
+int range_decideOverflow_(struct RangeAnalysis *analysis, LLVMValueRef call, struct Array *facts) {
+    const char *NAME = LLVMGetValueName(LLVMGetCalledValue(call));
+    unsigned width = range_getWidth_(LLVMGetOperand(call, 0));
+    struct Range left = {0}, right = {0};
+    __int128 min = 0, max = 0, leftMin = 0, leftMax = 0, rightMin = 0, rightMax = 0;
+    LLVMOpcode opcode = strstr(NAME, "add") ? LLVMAdd : (strstr(NAME, "sub") ? LLVMSub : LLVMMul);
+
+    if (!width) {
+        return -1;
+    }
+
+    left = range_getRefined_(analysis, LLVMGetOperand(call, 0), facts);
+    right = range_getRefined_(analysis, LLVMGetOperand(call, 1), facts);
+
+    if (range_isEmpty_(left) || range_isEmpty_(right)) {
+        return -1;
+    } else if (NAME[5] == 's') {
+        range_evaluateExact_(opcode, left, right, &min, &max);
+
+        return min >= range_getMinimum_(width) && max <= range_getMaximum_(width) ? 0 : -1;
+    }
+
+    range_getUnsigned_(left, width, &leftMin, &leftMax);
+    range_getUnsigned_(right, width, &rightMin, &rightMax);
+
+    if (opcode == LLVMAdd) {
+        return leftMax + rightMax < ((__int128)1 << width) ? 0 : -1;
+    } else if (opcode == LLVMSub) {
+        return leftMin >= rightMax ? 0 : -1;
+    }
+
+    return (leftMax >> 32) * (rightMax >> 32) == 0 && leftMax * rightMax < ((__int128)1 << width) ? 0 : -1;
+}
+
+/**
+ * Decides a condition from the ranges of the values in it.
+ *
+ * @param analysis  The analysis.
+ * @param condition The condition.
+ * @param facts     The comparisons known to be true.
+ *
+ * @return 1 if it is always true, 0 if it is always false, else -1.
+ */
+int range_decide_(struct RangeAnalysis *analysis, LLVMValueRef condition, struct Array *facts) {
+    LLVMOpcode opcode = LLVMIsAInstruction(condition) ? LLVMGetInstructionOpcode(condition) : LLVMRet;
+    LLVMValueRef aggregate = NULL;
+    int left = 0, right = 0;
+
+    if (LLVMIsAConstantInt(condition)) {
+        return LLVMConstIntGetZExtValue(condition) != 0;
+    }
+
+    switch (opcode) {
+    case LLVMICmp:
+        if (!range_getWidth_(LLVMGetOperand(condition, 0))) {
+            return -1;
+        }
+
+        return range_decideComparison_(analysis, LLVMGetICmpPredicate(condition), LLVMGetOperand(condition, 0),
+                                       LLVMGetOperand(condition, 1), facts);
+    case LLVMAnd:
+    case LLVMOr:
+        left = range_decide_(analysis, LLVMGetOperand(condition, 0), facts);
+        right = range_decide_(analysis, LLVMGetOperand(condition, 1), facts);
+
+        if (opcode == LLVMAnd) {
+            return left == 0 || right == 0 ? 0 : (left == 1 && right == 1 ? 1 : -1);
+        }
+
+        return left == 1 || right == 1 ? 1 : (left == 0 && right == 0 ? 0 : -1);
+    case LLVMXor:
+        if (LLVMIsAConstantInt(LLVMGetOperand(condition, 1)) && LLVMConstIntGetZExtValue(LLVMGetOperand(condition, 1))) {
+            left = range_decide_(analysis, LLVMGetOperand(condition, 0), facts);
+
+            return left == -1 ? -1 : !left;
+        }
+
+        return -1;
+    case LLVMExtractValue: // The overflow flag of an arithmetic intrinsic
+        aggregate = LLVMGetOperand(condition, 0);
+
+        if (LLVMIsACallInst(aggregate) && LLVMGetIndices(condition)[0] == 1 &&
+            LLVMIsAFunction(LLVMGetCalledValue(aggregate)) &&
+            strstr(LLVMGetValueName(LLVMGetCalledValue(aggregate)), ".with.overflow.")) {
+            return range_decideOverflow_(analysis, aggregate, facts);
+        }
+
+        return -1;
+    default:
+        return -1;
+    }
+}
+
+/**
+ * Gets whether a value stays the same for as long as the function runs,
+ * once it is defined.
+ *
+ * @param ANALYSIS The analysis.
+ * @param value    The value.
+ *
+ * @return Whether the value stays the same.
+ */
+bool range_isStable_(const struct RangeAnalysis *ANALYSIS, LLVMValueRef value) {
+    return LLVMIsAConstantInt(value) || LLVMIsAArgument(value) ||
+           (LLVMIsAInstruction(value) &&
+            !ANALYSIS->cyclic[range_getBlockIndex_(ANALYSIS, LLVMGetInstructionParent(value))]);
+}
+
+/**
+ * Finds comparisons which are true of a loop's phis wherever they are used,
+ * as they hold for the value coming along every branch into the loop, like
+ * 'i < n' for a counter starting below n and only going round again while
+ * it is below n.
+ *
+ * @param analysis The analysis.
+ *
+ * @return The comparisons.
+ */
+struct Array *range_findPhiFacts_(struct RangeAnalysis *analysis) {
+    struct Array *phiFacts = array_new();
+
+    for (size_t blockIndex = 0; blockIndex < analysis->blocksLength; blockIndex++) {
+        for (LLVMValueRef phi = LLVMGetFirstInstruction(analysis->blocks[blockIndex]); LLVMIsAPHINode(phi);
+             phi = LLVMGetNextInstruction(phi)) {
+            struct Array *candidates = array_new();
+
+            if (!range_getWidth_(phi)) {
+                array_free(&candidates);
+                continue;
+            }
+
+            for (unsigned index = 0; index < LLVMCountIncoming(phi); index++) { // Comparisons made on the way in
+                range_addEdgeFacts_(analysis, candidates, LLVMGetIncomingBlock(phi, index), analysis->blocks[blockIndex],
+                                    NULL);
+            }
+
+            for (size_t candidateIndex = 0; candidateIndex < candidates->length; candidateIndex++) {
+                const struct RangeFact *CANDIDATE = array_get(candidates, candidateIndex);
+                struct RangeFact *fact = NULL;
+                LLVMValueRef bound = NULL;
+                LLVMIntPredicate predicate = CANDIDATE->predicate;
+                bool holds = true;
+
+                for (unsigned index = 0; index < LLVMCountIncoming(phi) && !bound; index++) {
+                    if (CANDIDATE->left == LLVMGetIncomingValue(phi, index)) {
+                        bound = CANDIDATE->right;
+                    } else if (CANDIDATE->right == LLVMGetIncomingValue(phi, index)) {
+                        bound = CANDIDATE->left;
+                        predicate = range_swap_(predicate);
+                    }
+                }
+
+                if (!bound || bound == phi || !range_isStable_(analysis, bound)) {
+                    continue;
+                }
+
+                for (unsigned index = 0; index < LLVMCountIncoming(phi) && holds; index++) {
+                    LLVMBasicBlockRef predecessor = LLVMGetIncomingBlock(phi, index);
+                    struct Array *facts = array_new(),
+                                 *predecessorFacts = analysis->facts[range_getBlockIndex_(analysis, predecessor)];
+
+                    for (size_t factIndex = 0; factIndex < predecessorFacts->length; factIndex++) {
+                        array_insert(facts, facts->length, array_get(predecessorFacts, factIndex));
+                    }
+
+                    range_addEdgeFacts_(analysis, facts, predecessor, analysis->blocks[blockIndex], NULL);
+                    holds =
+                        range_decideComparison_(analysis, predicate, LLVMGetIncomingValue(phi, index), bound, facts) == 1;
+
+                    array_free(&facts);
+                }
+
+                if (holds) {
+                    fact = malloc(RANGE_FACT_STRUCT_SIZE);
+
+                    if (!fact) {
+                        panic("failed to malloc RangeFact struct");
+                    }
+
+                    *fact = (struct RangeFact){predicate, phi, bound};
+                    array_insert(analysis->ownedFacts, analysis->ownedFacts->length, fact);
+                    array_insert(phiFacts, phiFacts->length, fact);
+                }
+            }
+
+            array_free(&candidates);
+        }
+    }
+
+    return phiFacts;
+}
+
+/**
+ * Gets whether a block is where a failed check goes, one which ends the
+ * program rather than returning.
+ *
+ * @param block The block.
+ *
+ * @return Whether the block is for failed checks.
+ */
+bool range_isFailure_(LLVMBasicBlockRef block) {
+    LLVMValueRef terminator = LLVMGetBasicBlockTerminator(block);
+
+    return terminator && LLVMGetInstructionOpcode(terminator) == LLVMUnreachable &&
+           !LLVMIsAPHINode(LLVMGetFirstInstruction(block));
+}
+
+/**
+ * Frees a RangeAnalysis struct.
+ *
+ * @param self The current RangeAnalysis struct.
+ */
+void range_freeAnalysis_(struct RangeAnalysis **self) {
+    if (self && *self) {
+        for (size_t index = 0; index < (*self)->blocksLength; index++) {
+            array_free(&(*self)->facts[index]);
+        }
+
+        for (size_t index = 0; index < (*self)->ownedFacts->length; index++) {
+            free((void *)array_get((*self)->ownedFacts, index));
+        }
+
+        array_free(&(*self)->ownedFacts);
+        free((*self)->entries);
+        free((*self)->blocks);
+        free((*self)->predecessors);
+        free((*self)->cyclic);
+        free((*self)->facts);
+
+        free(*self);
+        *self = NULL;
+    } else {
+        panic("RangeAnalysis struct has already been freed");
+    }
+}
+
+/**
+ * Analyses the ranges of a function's integers.
+ *
+ * @param function The function.
+ *
+ * @return The RangeAnalysis struct, or NULL if it did not settle.
+ */
+struct RangeAnalysis *range_analyse_(LLVMValueRef function) {
+    struct RangeAnalysis *analysis = calloc(1, RANGE_ANALYSIS_STRUCT_SIZE);
+    struct Array *phiFacts = NULL;
+    size_t values = LLVMCountParams(function) + 1, passes = 0;
+
+    if (!analysis) {
+        panic("failed to malloc RangeAnalysis struct");
+    }
+
+    analysis->ownedFacts = array_new();
+    range_analyseBlocks_(analysis, function);
+
+    for (size_t index = 0; index < analysis->blocksLength; index++) {
+        for (LLVMValueRef instruction = LLVMGetFirstInstruction(analysis->blocks[index]); instruction;
+             instruction = LLVMGetNextInstruction(instruction)) {
+            values++;
+        }
+    }
+
+    for (analysis->capacity = 16; analysis->capacity < values * 2; analysis->capacity *= 2) {
+    }
+
+    analysis->entries = calloc(analysis->capacity, sizeof(struct RangeEntry));
+
+    if (!analysis->entries) {
+        panic("failed to calloc range analysis entries");
+    }
+
+    for (LLVMValueRef parameter = LLVMGetFirstParam(function); parameter; parameter = LLVMGetNextParam(parameter)) {
+        if (range_getWidth_(parameter)) {
+            range_getEntry_(analysis, parameter, true)->range = range_getFull_(range_getWidth_(parameter));
+        }
+    }
+
+    for (size_t index = 0; index < analysis->blocksLength; index++) { // Nothing until shown otherwise
+        for (LLVMValueRef instruction = LLVMGetFirstInstruction(analysis->blocks[index]); instruction;
+             instruction = LLVMGetNextInstruction(instruction)) {
+            if (range_getWidth_(instruction)) {
+                range_getEntry_(analysis, instruction, true)->range = range_getEmpty_();
+            }
+        }
+    }
+
+    for (size_t round = 0; round < 2; round++) { // Again with the facts about phis, which need ranges to find
+        while (range_runPass_(analysis, false)) {
+            if (++passes > RANGE_MAX_PASSES) {
+                range_freeAnalysis_(&analysis);
+
+                return NULL;
+            }
+        }
+
+        for (size_t pass = 0; pass < RANGE_NARROWING_PASSES; pass++) {
+            range_runPass_(analysis, true);
+        }
+
+        if (round == 0) {
+            phiFacts = range_findPhiFacts_(analysis);
+
+            for (size_t index = 0; index < analysis->blocksLength; index++) {
+                for (size_t factIndex = 0; factIndex < phiFacts->length; factIndex++) {
+                    array_insert(analysis->facts[index], analysis->facts[index]->length, array_get(phiFacts, factIndex));
+                }
+            }
+
+            array_free(&phiFacts);
+        }
+    }
+
+    return analysis;
+}
+
+/**
+ * Removes the safety checks in a function which can never fail.
+ *
+ * @param function The function.
+ * @param checks   Where to add the number of checks in the function.
+ *
+ * @return The number of checks removed.
+ */
+size_t range_removeFunctionChecks_(LLVMValueRef function, size_t *checks) {
+    struct RangeAnalysis *analysis = range_analyse_(function);
+    LLVMBuilderRef builder = NULL;
+    struct Array *removed = NULL;
+    size_t count = 0;
+
+    if (!analysis) {
+        return 0;
+    }
+
+    builder = LLVMCreateBuilderInContext(LLVMGetTypeContext(LLVMTypeOf(function)));
+    removed = array_new();
+
+    for (size_t index = 0; index < analysis->blocksLength; index++) {
+        LLVMValueRef terminator = LLVMGetBasicBlockTerminator(analysis->blocks[index]);
+        LLVMBasicBlockRef passed = NULL, failed = NULL;
+
+        if (!terminator || !LLVMIsABranchInst(terminator) || !LLVMIsConditional(terminator) ||
+            range_isFailure_(LLVMGetSuccessor(terminator, 0)) == range_isFailure_(LLVMGetSuccessor(terminator, 1))) {
+            continue;
+        }
+
+        failed = LLVMGetSuccessor(terminator, range_isFailure_(LLVMGetSuccessor(terminator, 0)) ? 0 : 1);
+        passed = LLVMGetSuccessor(terminator, failed == LLVMGetSuccessor(terminator, 0) ? 1 : 0);
+        (*checks)++;
+
+        if (range_decide_(analysis, LLVMGetCondition(terminator), analysis->facts[index]) ==
+            (passed == LLVMGetSuccessor(terminator, 0))) {
+            LLVMPositionBuilderBefore(builder, terminator);
+            LLVMBuildBr(builder, passed);
+            LLVMInstructionEraseFromParent(terminator);
+            array_insert(removed, removed->length, failed);
+        }
+    }
+
+    for (size_t index = 0; index < removed->length; index++) { // Failure blocks nothing branches to anymore
+        LLVMBasicBlockRef block = (LLVMBasicBlockRef)array_get(removed, index);
+        bool used = false;
+
+        for (size_t other = 0; other < index && !used; other++) { // Already deleted
+            used = array_get(removed, other) == block;
+        }
+
+        for (LLVMBasicBlockRef other = LLVMGetFirstBasicBlock(function); other && !used;
+             other = LLVMGetNextBasicBlock(other)) {
+            LLVMValueRef terminator = LLVMGetBasicBlockTerminator(other);
+
+            for (unsigned successor = 0; terminator && successor < LLVMGetNumSuccessors(terminator) && !used;
+                 successor++) {
+                used = LLVMGetSuccessor(terminator, successor) == block;
+            }
+        }
+
+        if (!used) {
+            LLVMDeleteBasicBlock(block);
+        }
+    }
+
+    count = removed->length;
+
+    array_free(&removed);
+    LLVMDisposeBuilder(builder);
+    range_freeAnalysis_(&analysis);
+
+    return count;
+}
+
+/**
+ * Removes safety checks which can never fail, like divide-by-zero,
+ * overflow and bounds checks. A check is a branch to a block which ends the
+ * program, and it is removed when the ranges of the integers it compares,
+ * found from the operations making them and the comparisons made on the
+ * way to it, show it always passes. Loop counters are known to stay within
+ * the loop's bounds, so checks in inner loops indexing by them go.
+ *
+ * @param module The module.
+ * @param report Where to append how many checks were removed from each
+ * function, or NULL to not report them.
+ *
+ * @return Whether any checks were removed.
+ */
+bool range_removeChecks(LLVMModuleRef module, char **report) {
+    bool changed = false;
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+        size_t checks = 0, removed = 0;
+
+        if (!LLVMGetFirstBasicBlock(function)) {
+            continue;
+        }
+
+        removed = range_removeFunctionChecks_(function, &checks);
+        changed |= removed > 0;
+
+        if (report && checks) {
+            *report = stringConcatenate(7, *report, "removed ", ulToString(removed), " of ", ulToString(checks),
+                                        stringConcatenate(3, " checks from '", LLVMGetValueName(function), "'"), "\n");
+        }
+    }
+
+    return changed;
+}
@@ -0,0 +1,92 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+#pragma once
+
+#include "../includes.c"
+
+#include <llvm-c/Core.h>
+
+/**
+ * Gives every local symbol in a module external linkage and hidden
+ * visibility. Once a module is split, the parts reference each others'
+ * symbols, so nothing can stay local to one part.
+ *
+ * @param module The module.
+ */
+void split_externaliseLocals(LLVMModuleRef module) {
+    for (LLVMValueRef global = LLVMGetFirstGlobal(module); global; global = LLVMGetNextGlobal(global)) {
+        if (LLVMGetLinkage(global) == LLVMInternalLinkage || LLVMGetLinkage(global) == LLVMPrivateLinkage) {
+            LLVMSetLinkage(global, LLVMExternalLinkage);
+            LLVMSetVisibility(global, LLVMHiddenVisibility);
+        }
+    }
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+        if (LLVMGetLinkage(function) == LLVMInternalLinkage || LLVMGetLinkage(function) == LLVMPrivateLinkage) {
+            LLVMSetLinkage(function, LLVMExternalLinkage);
+            LLVMSetVisibility(function, LLVMHiddenVisibility);
+        }
+    }
+}
+
+/**
+ * Removes the body of a function, turning it into a declaration.
+ *
+ * @param function The function.
+ */
+void split_removeBody(LLVMValueRef function) {
+    LLVMBasicBlockRef block = NULL;
+
+    if (LLVMCountBasicBlocks(function) == 0) {
+        return;
+    }
+
+    // Later blocks use earlier blocks' values, and branches point back at earlier blocks, so nothing can be deleted
+    // while it is still used
+    for (block = LLVMGetFirstBasicBlock(function); block; block = LLVMGetNextBasicBlock(block)) {
+        for (LLVMValueRef instruction = LLVMGetFirstInstruction(block); instruction;
+             instruction = LLVMGetNextInstruction(instruction)) {
+            if (LLVMGetTypeKind(LLVMTypeOf(instruction)) != LLVMVoidTypeKind) {
+                LLVMReplaceAllUsesWith(instruction, LLVMGetUndef(LLVMTypeOf(instruction)));
+            }
+        }
+
+        if (LLVMGetBasicBlockTerminator(block)) {
+            LLVMInstructionEraseFromParent(LLVMGetBasicBlockTerminator(block));
+        }
+    }
+
+    while ((block = LLVMGetFirstBasicBlock(function))) {
+        LLVMDeleteBasicBlock(block);
+    }
+
+    LLVMSetLinkage(function, LLVMExternalLinkage); // Declarations can only be external
+}
+
+/**
+ * Turns the global variable definitions of a module into declarations, as
+ * they are defined by another part of the split module. Their initializers
+ * are kept so they can still be used for optimisation.
+ *
+ * @param module The module.
+ */
+void split_declareGlobals(LLVMModuleRef module) {
+    for (LLVMValueRef global = LLVMGetFirstGlobal(module); global; global = LLVMGetNextGlobal(global)) {
+        if (LLVMGetInitializer(global)) {
+            LLVMSetLinkage(global, LLVMAvailableExternallyLinkage);
+            LLVMSetVisibility(global, LLVMDefaultVisibility);
+        }
+    }
+}
+
+/**
+ * Gets whether a function has a body.
+ *
+ * @param function The function.
+ *
+ * @return Whether the function has a body.
+ */
+bool split_isDefined(LLVMValueRef function) { return LLVMCountBasicBlocks(function) > 0; }
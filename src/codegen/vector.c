@@ -0,0 +1,490 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+#pragma once
+
+#include "../includes.c"
+
+#include <llvm-c/Core.h>
+#include <llvm-c/TargetMachine.h>
+
+#include "../lexer/tokens.c"
+#include "../utils/conversions.c"
+#include "../utils/panic.c"
+#include "../utils/string.c"
+#include "./arithmetic.c"
+
+#define VECTOR_TYPE_NAME "vec"           // 'vec[f32, 8]'
+#define VECTOR_TARGET_ATTRIBUTE "target" // '@target("avx2")'
+
+/**
+ * Represents a CPU feature which functions can be specialised for, and its
+ * bit in the features word of libgcc's '__cpu_model', which compiler-rt
+ * shares.
+ */
+struct VectorFeature {
+    const char *NAME;
+    unsigned bit;
+};
+
+/**
+ * Contains the CPU features functions can be specialised for.
+ */
+static const struct VectorFeature VECTOR_FEATURES[] = {
+    {"sse3", 5},  {"ssse3", 6}, {"sse4.1", 7},   {"sse4.2", 8}, {"avx", 9},
+    {"avx2", 10}, {"fma", 14},  {"avx512f", 15}, {"bmi", 16},   {"bmi2", 17},
+};
+
+#define VECTOR_FEATURES_LENGTH (sizeof(VECTOR_FEATURES) / sizeof(struct VectorFeature))
+
+/**
+ * Gets the LLVM type of a vector's elements.
+ *
+ * @param context The context.
+ * @param NAME    The name of the element type, e.g. 'f32'.
+ *
+ * @return The type, or NULL if vectors cannot hold it.
+ */
+LLVMTypeRef vector_getElementType(LLVMContextRef context, const char *NAME) {
+    if (strcmp(NAME, "f32") == 0) {
+        return LLVMFloatTypeInContext(context);
+    } else if (strcmp(NAME, "f64") == 0) {
+        return LLVMDoubleTypeInContext(context);
+    } else if (strcmp(NAME, "bool") == 0) {
+        return LLVMInt1TypeInContext(context);
+    } else if ((NAME[0] == 'i' || NAME[0] == 'u') &&
+               (strcmp(NAME + 1, "8") == 0 || strcmp(NAME + 1, "16") == 0 || strcmp(NAME + 1, "32") == 0 ||
+                strcmp(NAME + 1, "64") == 0)) {
+        return LLVMIntTypeInContext(context, (unsigned)strtoul(NAME + 1, NULL, 10));
+    }
+
+    return NULL;
+}
+
+/**
+ * Gets the LLVM type of a vector type, e.g. 'vec[f32, 8]' is '<8 x float>'.
+ *
+ * @param context      The context.
+ * @param ELEMENT_NAME The name of the element type.
+ * @param length       The number of elements.
+ *
+ * @return The type.
+ */
+LLVMTypeRef vector_getType(LLVMContextRef context, const char *ELEMENT_NAME, unsigned length) {
+    LLVMTypeRef elementType = vector_getElementType(context, ELEMENT_NAME);
+
+    if (!elementType) {
+        panic(stringConcatenate(3, "vectors cannot hold elements of type '", ELEMENT_NAME, "'"));
+    } else if (length == 0) {
+        panic("vectors must have at least 1 element");
+    }
+
+    return LLVMVectorType(elementType, length);
+}
+
+/**
+ * Gets whether a vector holds floating point numbers.
+ *
+ * @param value The vector.
+ *
+ * @return Whether the vector's elements are floating point numbers.
+ */
+bool vector_isFloat_(LLVMValueRef value) {
+    LLVMTypeKind kind = LLVMGetTypeKind(LLVMGetElementType(LLVMTypeOf(value)));
+
+    return kind == LLVMFloatTypeKind || kind == LLVMDoubleTypeKind;
+}
+
+/**
+ * Builds a vector with every element set to a scalar, so scalars can be
+ * used with vectors in operators.
+ *
+ * @param builder The builder.
+ * @param type    The type of the vector.
+ * @param scalar  The scalar.
+ *
+ * @return The vector.
+ */
+LLVMValueRef vector_buildSplat(LLVMBuilderRef builder, LLVMTypeRef type, LLVMValueRef scalar) {
+    LLVMValueRef vector = LLVMBuildInsertElement(builder, LLVMGetUndef(type), scalar,
+                                                 LLVMConstInt(LLVMInt32TypeInContext(LLVMGetTypeContext(type)), 0, false),
+                                                 "");
+
+    return LLVMBuildShuffleVector(
+        builder, vector, LLVMGetUndef(type),
+        LLVMConstNull(LLVMVectorType(LLVMInt32TypeInContext(LLVMGetTypeContext(type)), LLVMGetVectorSize(type))), "");
+}
+
+/**
+ * Builds an element-wise binary operator on two vectors of the same type.
+ * Comparison operators give a 'vec[bool, N]' mask.
+ *
+ * @param builder  The builder.
+ * @param OPERATOR The lexer token of the operator.
+ * @param left     The left vector.
+ * @param right    The right vector.
+ * @param isSigned Whether integer elements are signed.
+ *
+ * @return The result.
+ */
+LLVMValueRef vector_buildOperation(LLVMBuilderRef builder, const enum LexerTokenIdentifiers OPERATOR, LLVMValueRef left,
+                                   LLVMValueRef right, bool isSigned) {
+    bool isFloat = vector_isFloat_(left);
+
+    switch (OPERATOR) {
+    case LEXERTOKENS_MODULO:
+        return isFloat ? LLVMBuildFRem(builder, left, right, "")
+                       : (isSigned ? LLVMBuildSRem(builder, left, right, "") : LLVMBuildURem(builder, left, right, ""));
+    case LEXERTOKENS_MULTIPLICATION:
+        return isFloat ? LLVMBuildFMul(builder, left, right, "") : LLVMBuildMul(builder, left, right, "");
+    case LEXERTOKENS_EXPONENT:
+        if (!isFloat) { // Needs a loop per element
+            break;
+        }
+
+        return arithmetic_buildPower(builder, left, right, isSigned);
+    case LEXERTOKENS_DIVISION:
+        return isFloat ? LLVMBuildFDiv(builder, left, right, "")
+                       : (isSigned ? LLVMBuildSDiv(builder, left, right, "") : LLVMBuildUDiv(builder, left, right, ""));
+    case LEXERTOKENS_FLOOR_DIVISION:
+        return arithmetic_buildFloorDivision(builder, left, right, isSigned);
+    case LEXERTOKENS_ADDITION:
+        return isFloat ? LLVMBuildFAdd(builder, left, right, "") : LLVMBuildAdd(builder, left, right, "");
+    case LEXERTOKENS_SUBTRACTION:
+        return isFloat ? LLVMBuildFSub(builder, left, right, "") : LLVMBuildSub(builder, left, right, "");
+    case LEXERTOKENS_EQUAL_TO:
+        return isFloat ? LLVMBuildFCmp(builder, LLVMRealOEQ, left, right, "")
+                       : LLVMBuildICmp(builder, LLVMIntEQ, left, right, "");
+    case LEXERTOKENS_NOT_EQUAL_TO:
+        return isFloat ? LLVMBuildFCmp(builder, LLVMRealUNE, left, right, "")
+                       : LLVMBuildICmp(builder, LLVMIntNE, left, right, "");
+    case LEXERTOKENS_GREATER_THAN:
+        return isFloat ? LLVMBuildFCmp(builder, LLVMRealOGT, left, right, "")
+                       : LLVMBuildICmp(builder, isSigned ? LLVMIntSGT : LLVMIntUGT, left, right, "");
+    case LEXERTOKENS_LESS_THAN:
+        return isFloat ? LLVMBuildFCmp(builder, LLVMRealOLT, left, right, "")
+                       : LLVMBuildICmp(builder, isSigned ? LLVMIntSLT : LLVMIntULT, left, right, "");
+    case LEXERTOKENS_GREATER_THAN_OR_EQUAL:
+        return isFloat ? LLVMBuildFCmp(builder, LLVMRealOGE, left, right, "")
+                       : LLVMBuildICmp(builder, isSigned ? LLVMIntSGE : LLVMIntUGE, left, right, "");
+    case LEXERTOKENS_LESS_THAN_OR_EQUAL:
+        return isFloat ? LLVMBuildFCmp(builder, LLVMRealOLE, left, right, "")
+                       : LLVMBuildICmp(builder, isSigned ? LLVMIntSLE : LLVMIntULE, left, right, "");
+    case LEXERTOKENS_BITWISE_AND:
+    case LEXERTOKENS_BITWISE_OR:
+    case LEXERTOKENS_BITWISE_XOR:
+    case LEXERTOKENS_BITWISE_LEFT_SHIFT:
+    case LEXERTOKENS_BITWISE_RIGHT_SHIFT:
+        if (isFloat) {
+            break;
+        } else if (OPERATOR == LEXERTOKENS_BITWISE_AND) {
+            return LLVMBuildAnd(builder, left, right, "");
+        } else if (OPERATOR == LEXERTOKENS_BITWISE_OR) {
+            return LLVMBuildOr(builder, left, right, "");
+        } else if (OPERATOR == LEXERTOKENS_BITWISE_XOR) {
+            return LLVMBuildXor(builder, left, right, "");
+        } else if (OPERATOR == LEXERTOKENS_BITWISE_LEFT_SHIFT) {
+            return LLVMBuildShl(builder, left, right, "");
+        }
+
+        return isSigned ? LLVMBuildAShr(builder, left, right, "") : LLVMBuildLShr(builder, left, right, "");
+    default:
+        break;
+    }
+
+    panic(stringConcatenate(3, "unsupported ", lexerTokens_getName(OPERATOR), " for vectors"));
+
+    return NULL;
+}
+
+/**
+ * Builds an element-wise unary operator on a vector.
+ *
+ * @param builder  The builder.
+ * @param OPERATOR The lexer token of the operator, either '-' or '~'.
+ * @param value    The vector.
+ *
+ * @return The result.
+ */
+LLVMValueRef vector_buildUnaryOperation(LLVMBuilderRef builder, const enum LexerTokenIdentifiers OPERATOR,
+                                        LLVMValueRef value) {
+    if (OPERATOR == LEXERTOKENS_SUBTRACTION) {
+        return vector_isFloat_(value) ? LLVMBuildFNeg(builder, value, "") : LLVMBuildNeg(builder, value, "");
+    } else if (OPERATOR == LEXERTOKENS_BITWISE_NOT && !vector_isFloat_(value)) {
+        return LLVMBuildNot(builder, value, "");
+    }
+
+    panic(stringConcatenate(3, "unsupported unary ", lexerTokens_getName(OPERATOR), " for vectors"));
+
+    return NULL;
+}
+
+/**
+ * Builds a shuffle, picking elements from two vectors of the same type by
+ * index. Indices below the vectors' length pick from the left vector, the
+ * rest pick from the right.
+ *
+ * @param builder The builder.
+ * @param left    The left vector.
+ * @param right   The right vector.
+ * @param INDICES The indices, which must be constant.
+ * @param length  The number of indices, the length of the result.
+ *
+ * @return The shuffled vector.
+ */
+LLVMValueRef vector_buildShuffle(LLVMBuilderRef builder, LLVMValueRef left, LLVMValueRef right, const unsigned *INDICES,
+                                 unsigned length) {
+    LLVMTypeRef int32 = LLVMInt32TypeInContext(LLVMGetTypeContext(LLVMTypeOf(left)));
+    LLVMValueRef *mask = calloc(length, sizeof(LLVMValueRef)), shuffle = NULL;
+
+    if (!mask) {
+        panic("failed to calloc shuffle mask");
+    }
+
+    for (unsigned index = 0; index < length; index++) {
+        if (INDICES[index] >= LLVMGetVectorSize(LLVMTypeOf(left)) * 2) {
+            panic(stringConcatenate(3, "shuffle index ", ulToString(INDICES[index]), " is out of range"));
+        }
+
+        mask[index] = LLVMConstInt(int32, INDICES[index], false);
+    }
+
+    shuffle = LLVMBuildShuffleVector(builder, left, right, LLVMConstVector(mask, length), "");
+
+    free(mask);
+
+    return shuffle;
+}
+
+/**
+ * Builds a reduction of a vector to a scalar. '+', '*', '&', '|' and '^'
+ * combine every element, while '<' and '>' find the smallest and largest.
+ * Floating point sums and products are reduced pairwise, halving the vector
+ * each step, rather than in order, so they stay in vector registers. That
+ * needs a length which is a power of two, so other lengths reduce in order.
+ *
+ * @param builder  The builder.
+ * @param OPERATOR The lexer token of the operator.
+ * @param vector   The vector.
+ * @param isSigned Whether integer elements are signed.
+ *
+ * @return The scalar.
+ */
+LLVMValueRef vector_buildReduction(LLVMBuilderRef builder, const enum LexerTokenIdentifiers OPERATOR,
+                                   LLVMValueRef vector, bool isSigned) {
+    LLVMTypeRef type = LLVMTypeOf(vector);
+    unsigned length = LLVMGetVectorSize(type);
+    bool isFloat = vector_isFloat_(vector);
+    const char *NAME = NULL;
+
+    if (isFloat && (OPERATOR == LEXERTOKENS_ADDITION || OPERATOR == LEXERTOKENS_MULTIPLICATION) &&
+        (length & (length - 1)) == 0) {
+        unsigned *indices = calloc(length, sizeof(unsigned));
+
+        if (!indices) {
+            panic("failed to calloc shuffle indices");
+        }
+
+        for (unsigned half = length / 2; half > 0; half /= 2) { // Combines the top half with the bottom half
+            for (unsigned index = 0; index < length; index++) {
+                indices[index] = index < half ? index + half : index;
+            }
+
+            vector = vector_buildOperation(builder, OPERATOR, vector,
+                                           vector_buildShuffle(builder, vector, vector, indices, length), isSigned);
+        }
+
+        free(indices);
+
+        return LLVMBuildExtractElement(builder, vector,
+                                       LLVMConstInt(LLVMInt32TypeInContext(LLVMGetTypeContext(type)), 0, false), "");
+    }
+
+    switch (OPERATOR) {
+    case LEXERTOKENS_ADDITION:
+        NAME = isFloat ? "llvm.vector.reduce.fadd" : "llvm.vector.reduce.add";
+        break;
+    case LEXERTOKENS_MULTIPLICATION:
+        NAME = isFloat ? "llvm.vector.reduce.fmul" : "llvm.vector.reduce.mul";
+        break;
+    case LEXERTOKENS_BITWISE_AND:
+        NAME = isFloat ? NULL : "llvm.vector.reduce.and";
+        break;
+    case LEXERTOKENS_BITWISE_OR:
+        NAME = isFloat ? NULL : "llvm.vector.reduce.or";
+        break;
+    case LEXERTOKENS_BITWISE_XOR:
+        NAME = isFloat ? NULL : "llvm.vector.reduce.xor";
+        break;
+    case LEXERTOKENS_LESS_THAN:
+        NAME = isFloat ? "llvm.vector.reduce.fmin" : (isSigned ? "llvm.vector.reduce.smin" : "llvm.vector.reduce.umin");
+        break;
+    case LEXERTOKENS_GREATER_THAN:
+        NAME = isFloat ? "llvm.vector.reduce.fmax" : (isSigned ? "llvm.vector.reduce.smax" : "llvm.vector.reduce.umax");
+        break;
+    default:
+        break;
+    }
+
+    if (!NAME) {
+        panic(stringConcatenate(3, "unsupported reduction with ", lexerTokens_getName(OPERATOR), " for this vector"));
+    } else if (isFloat && (OPERATOR == LEXERTOKENS_ADDITION || OPERATOR == LEXERTOKENS_MULTIPLICATION)) {
+        // Starts from values which leave the first element as it is, as -0.0 + -0.0 is -0.0 where 0.0 + -0.0 is not
+        LLVMValueRef start = LLVMConstReal(LLVMGetElementType(type), OPERATOR == LEXERTOKENS_ADDITION ? -0.0 : 1.0);
+
+        return arithmetic_buildIntrinsic(builder, NAME, &type, 1, (LLVMValueRef[]){start, vector}, 2);
+    }
+
+    return arithmetic_buildIntrinsic(builder, NAME, &type, 1, &vector, 1);
+}
+
+/**
+ * Gets the bit of a CPU feature in '__cpu_model'.
+ *
+ * @param FEATURE The name of the feature.
+ *
+ * @return The bit.
+ */
+unsigned vector_getFeatureBit_(const char *FEATURE) {
+    for (size_t index = 0; index < VECTOR_FEATURES_LENGTH; index++) {
+        if (strcmp(VECTOR_FEATURES[index].NAME, FEATURE) == 0) {
+            return VECTOR_FEATURES[index].bit;
+        }
+    }
+
+    panic(stringConcatenate(3, "unknown target feature '", FEATURE, "'"));
+
+    return 0;
+}
+
+/**
+ * Specialises a function for CPU features, from '@target("avx2")'. It can
+ * then use instructions from them, so must only be called through
+ * vector_buildDispatch.
+ *
+ * @param function The function.
+ * @param FEATURES The features, separated by commas.
+ */
+void vector_setTarget(LLVMValueRef function, const char *FEATURES) {
+    char *copy = strdup(FEATURES), *features = "", *feature = NULL;
+
+    for (feature = strtok(copy, ", "); feature; feature = strtok(NULL, ", ")) {
+        vector_getFeatureBit_(feature); // Checks the feature is known
+        features = stringConcatenate(4, features, *features ? "," : "", "+", feature);
+    }
+
+    LLVMAddAttributeAtIndex(function, LLVMAttributeFunctionIndex,
+                            LLVMCreateStringAttribute(LLVMGetModuleContext(LLVMGetGlobalParent(function)),
+                                                      "target-features", 15, features, (unsigned)strlen(features)));
+
+    free(copy);
+}
+
+/**
+ * Builds a function which picks between a version of a function specialised
+ * for a CPU feature and a fallback, depending on whether the CPU running it
+ * has the feature. The version is picked on the first call and kept in a
+ * global variable, so later calls only cost a load and a tail call.
+ *
+ * @param module      The module.
+ * @param NAME        The name of the function to build.
+ * @param FEATURE     The CPU feature.
+ * @param specialised The version for CPUs with the feature.
+ * @param fallback    The version for every other CPU, with the same type.
+ *
+ * @return The function.
+ */
+LLVMValueRef vector_buildDispatch(LLVMModuleRef module, const char *NAME, const char *FEATURE,
+                                  LLVMValueRef specialised, LLVMValueRef fallback) {
+    LLVMContextRef context = LLVMGetModuleContext(module);
+    LLVMTypeRef functionType = LLVMGlobalGetValueType(fallback), int32 = LLVMInt32TypeInContext(context),
+                pointerType = LLVMPointerType(functionType, 0), modelType = NULL;
+    LLVMValueRef resolver = LLVMAddFunction(module, stringConcatenate(2, NAME, ".resolver"),
+                                            LLVMFunctionType(pointerType, NULL, 0, false)),
+                 dispatch = LLVMAddFunction(module, NAME, functionType),
+                 target = LLVMAddGlobal(module, pointerType, stringConcatenate(2, NAME, ".target")),
+                 initialise = LLVMGetNamedFunction(module, "__cpu_indicator_init"),
+                 model = LLVMGetNamedGlobal(module, "__cpu_model"), features = NULL, picked = NULL, resolved = NULL,
+                 call = NULL,
+                 *arguments = calloc(LLVMCountParams(fallback) + 1, sizeof(LLVMValueRef));
+    LLVMBasicBlockRef entry = NULL, resolve = NULL, forward = NULL;
+    LLVMBuilderRef builder = LLVMCreateBuilderInContext(context);
+    char *triple = LLVMGetDefaultTargetTriple();
+    unsigned bit = vector_getFeatureBit_(FEATURE);
+
+    LLVMSetLinkage(resolver, LLVMInternalLinkage);
+    LLVMPositionBuilderAtEnd(builder, LLVMAppendBasicBlockInContext(context, resolver, "entry"));
+
+    if (strncmp(triple, "x86_64", 6) != 0 && strncmp(triple, "i686", 4) != 0) { // Not an x86 feature
+        LLVMBuildRet(builder, fallback);
+    } else {
+        modelType = LLVMStructTypeInContext(context, (LLVMTypeRef[]){int32, int32, int32, LLVMArrayType(int32, 1)}, 4,
+                                            false);
+
+        if (!initialise) { // Could be called before constructors, so it has to be called here
+            initialise = LLVMAddFunction(module, "__cpu_indicator_init",
+                                         LLVMFunctionType(LLVMVoidTypeInContext(context), NULL, 0, false));
+        }
+
+        if (!model) {
+            model = LLVMAddGlobal(module, modelType, "__cpu_model");
+        }
+
+        LLVMBuildCall2(builder, LLVMGlobalGetValueType(initialise), initialise, NULL, 0, "");
+        features = LLVMBuildLoad2(
+            builder, int32,
+            LLVMBuildInBoundsGEP2(builder, modelType, LLVMConstBitCast(model, LLVMPointerType(modelType, 0)),
+                                  (LLVMValueRef[]){LLVMConstInt(int32, 0, false), LLVMConstInt(int32, 3, false),
+                                                   LLVMConstInt(int32, 0, false)},
+                                  3, ""),
+            "features");
+        LLVMBuildRet(builder, LLVMBuildSelect(builder,
+                                              LLVMBuildICmp(builder, LLVMIntNE,
+                                                            LLVMBuildAnd(builder, features,
+                                                                         LLVMConstInt(int32, 1ULL << bit, false), ""),
+                                                            LLVMConstNull(int32), ""),
+                                              specialised, fallback, ""));
+    }
+
+    if (!arguments) {
+        panic("failed to calloc dispatch arguments");
+    }
+
+    LLVMSetInitializer(target, LLVMConstNull(pointerType));
+    LLVMSetLinkage(target, LLVMInternalLinkage);
+
+    entry = LLVMAppendBasicBlockInContext(context, dispatch, "entry");
+    resolve = LLVMAppendBasicBlockInContext(context, dispatch, "resolve");
+    forward = LLVMAppendBasicBlockInContext(context, dispatch, "forward");
+
+    LLVMPositionBuilderAtEnd(builder, entry);
+    picked = LLVMBuildLoad2(builder, pointerType, target, "picked");
+    LLVMSetOrdering(picked, LLVMAtomicOrderingMonotonic); // Threads racing to pick store the same version
+    LLVMBuildCondBr(builder, LLVMBuildIsNull(builder, picked, ""), resolve, forward);
+
+    LLVMPositionBuilderAtEnd(builder, resolve);
+    resolved = LLVMBuildCall2(builder, LLVMGlobalGetValueType(resolver), resolver, NULL, 0, "resolved");
+    LLVMSetOrdering(LLVMBuildStore(builder, resolved, target), LLVMAtomicOrderingMonotonic);
+    LLVMBuildBr(builder, forward);
+
+    LLVMPositionBuilderAtEnd(builder, forward);
+    call = LLVMBuildPhi(builder, pointerType, "version");
+    LLVMAddIncoming(call, (LLVMValueRef[]){picked, resolved}, (LLVMBasicBlockRef[]){entry, resolve}, 2);
+    LLVMGetParams(dispatch, arguments);
+    call = LLVMBuildCall2(builder, functionType, call, arguments, LLVMCountParams(dispatch), "");
+    LLVMSetTailCall(call, true);
+
+    if (LLVMGetTypeKind(LLVMGetReturnType(functionType)) == LLVMVoidTypeKind) {
+        LLVMBuildRetVoid(builder);
+    } else {
+        LLVMBuildRet(builder, call);
+    }
+
+    free(arguments);
+    LLVMDisposeBuilder(builder);
+    LLVMDisposeMessage(triple);
+
+    return dispatch;
+}
@@ -0,0 +1,779 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+#pragma once
+
+#include "../includes.c"
+
+#include <llvm-c/Core.h>
+#include <llvm-c/Error.h>
+#include <llvm-c/IRReader.h>
+#include <llvm-c/LLJIT.h>
+#include <llvm-c/Orc.h>
+#include <llvm-c/Target.h>
+#include <stdatomic.h>
+#include <threads.h>
+
+#include "../codegen/align.c"
+#include "../codegen/coroutine.c"
+#include "../codegen/split.c"
+#include "../utils/array.c"
+#include "../utils/panic.c"
+#include "../utils/string.c"
+
+/**
+ * The suffix given to the symbol holding a function's body. The function's
+ * own name is a lazy stub, which compiles the body on its first call.
+ */
+#define JIT_IMPL_SUFFIX "$impl"
+
+/**
+ * The name of the function giving the calling thread's copy of a
+ * thread-local variable, see 'jit_getThreadLocal_'.
+ */
+#define JIT_THREAD_LOCAL_FUNCTION "exeme.jit.thread_local"
+
+/**
+ * The name calls to '__cxa_atexit' are given. The JIT's own '__cxa_atexit'
+ * only runs handlers when the JIT is torn down, which it never is as
+ * programs exit, so they call the process's instead.
+ */
+#define JIT_AT_EXIT_FUNCTION "exeme.jit.cxa_atexit"
+
+/**
+ * Describes a thread-local variable of a program the JIT runs. The JIT's
+ * linker cannot resolve thread-local relocations, so each is replaced by one
+ * of these, laid out as '{i8*, i64, i64, i32, i32}', and each thread copies
+ * its image into memory of its own on first use.
+ */
+struct JitThreadLocal {
+    const void *IMAGE; // The initial value, copied for each thread
+    size_t size;
+    size_t alignment;
+    tss_t key;
+    atomic_int created; // Whether 'key' has been created
+};
+
+mtx_t jit_threadLocalsLock; // Guards creating the keys of thread-local variables
+
+int __cxa_atexit(void (*function)(void *), void *argument, void *handle);
+
+/**
+ * Represents a JIT, which compiles modules in memory and runs them.
+ */
+struct Jit {
+    bool mainReturnsInt;
+    struct Array *alignedClasses; // Marked '@align(N)' by the modules added so far, see 'align_share'
+    LLVMOrcIndirectStubsManagerRef stubsManager;
+    LLVMOrcJITDylibRef dylib;
+    LLVMOrcLazyCallThroughManagerRef callThroughManager;
+    LLVMOrcLLJITRef lljit;
+    LLVMOrcThreadSafeContextRef context;
+};
+
+#define JIT_STRUCT_SIZE sizeof(struct Jit)
+
+/**
+ * Panics with the message of an LLVM error, if there is one.
+ *
+ * @param error   The error returned by LLVM.
+ * @param MESSAGE What was being done when the error occurred.
+ */
+void jit_check(LLVMErrorRef error, const char *MESSAGE) {
+    if (error) {
+        panic(stringConcatenate(4, "failed to ", MESSAGE, ": ", LLVMGetErrorMessage(error)));
+    }
+}
+
+/**
+ * Gets the calling thread's copy of a thread-local variable, copying its
+ * image the first time the thread uses it. The copy is freed when the
+ * thread exits.
+ *
+ * @param variable The thread-local variable.
+ *
+ * @return The calling thread's copy.
+ */
+void *jit_getThreadLocal_(struct JitThreadLocal *variable) {
+    void *copy = NULL;
+    size_t size = 0;
+
+    if (!atomic_load_explicit(&variable->created, memory_order_acquire)) {
+        mtx_lock(&jit_threadLocalsLock);
+
+        if (!atomic_load_explicit(&variable->created, memory_order_relaxed)) {
+            if (tss_create(&variable->key, free) != thrd_success) {
+                panic("failed to create thread-local variable key");
+            }
+
+            atomic_store_explicit(&variable->created, true, memory_order_release);
+        }
+
+        mtx_unlock(&jit_threadLocalsLock);
+    }
+
+    if ((copy = tss_get(variable->key))) {
+        return copy;
+    }
+
+    // aligned_alloc needs sizes which are multiples of the alignment
+    size = (variable->size + variable->alignment - 1) & ~(variable->alignment - 1);
+    copy = aligned_alloc(variable->alignment, size ? size : variable->alignment);
+
+    if (!copy || tss_set(variable->key, copy) != thrd_success) {
+        panic("failed to allocate thread-local variable");
+    }
+
+    memcpy(copy, variable->IMAGE, variable->size);
+
+    return copy;
+}
+
+/**
+ * Creates a new Jit struct.
+ *
+ * @return The created Jit struct.
+ */
+struct Jit *jit_new(void) {
+    struct Jit *self = malloc(JIT_STRUCT_SIZE);
+    LLVMOrcDefinitionGeneratorRef processSymbols = NULL;
+    LLVMJITSymbolFlags functionFlags = {LLVMJITSymbolGenericFlagsExported | LLVMJITSymbolGenericFlagsCallable, 0};
+    LLVMJITCSymbolMapPair hostSymbols[2];
+
+    if (!self) {
+        panic("failed to malloc Jit struct");
+    }
+
+    LLVMInitializeNativeTarget();
+    LLVMInitializeNativeAsmPrinter();
+    LLVMInitializeNativeAsmParser(); // For the scheduler runtime's inline assembly
+
+    jit_check(LLVMOrcCreateLLJIT(&self->lljit, NULL), "create JIT");
+
+    self->mainReturnsInt = false;
+    self->alignedClasses = array_new();
+    self->dylib = LLVMOrcLLJITGetMainJITDylib(self->lljit);
+    self->context = LLVMOrcCreateNewThreadSafeContext();
+    self->stubsManager = LLVMOrcCreateLocalIndirectStubsManager(LLVMOrcLLJITGetTripleString(self->lljit));
+
+    jit_check(LLVMOrcCreateLocalLazyCallThroughManager(LLVMOrcLLJITGetTripleString(self->lljit),
+                                                        LLVMOrcLLJITGetExecutionSession(self->lljit), 0,
+                                                        &self->callThroughManager),
+              "create lazy call-through manager");
+
+    // Symbols not defined by any module (libc, etc) are resolved in-process
+    jit_check(LLVMOrcCreateDynamicLibrarySearchGeneratorForProcess(
+                  &processSymbols, LLVMOrcLLJITGetGlobalPrefix(self->lljit), NULL, NULL),
+              "create process symbol generator");
+    LLVMOrcJITDylibAddGenerator(self->dylib, processSymbols);
+
+    if (mtx_init(&jit_threadLocalsLock, mtx_plain) != thrd_success) {
+        panic("failed to create thread-local variables lock");
+    }
+
+    hostSymbols[0] = (LLVMJITCSymbolMapPair){
+        LLVMOrcLLJITMangleAndIntern(self->lljit, JIT_THREAD_LOCAL_FUNCTION),
+        {(LLVMOrcExecutorAddress)jit_getThreadLocal_, functionFlags},
+    };
+    hostSymbols[1] = (LLVMJITCSymbolMapPair){
+        LLVMOrcLLJITMangleAndIntern(self->lljit, JIT_AT_EXIT_FUNCTION),
+        {(LLVMOrcExecutorAddress)__cxa_atexit, functionFlags},
+    };
+    jit_check(LLVMOrcJITDylibDefine(self->dylib, LLVMOrcAbsoluteSymbols(hostSymbols, 2)), "define host symbols");
+
+    return self;
+}
+
+/**
+ * Frees a Jit struct.
+ *
+ * @param self The current Jit struct.
+ */
+void jit_free(struct Jit **self) {
+    if (self && *self) {
+        jit_check(LLVMOrcDisposeLLJIT((*self)->lljit), "dispose JIT");
+
+        LLVMOrcDisposeLazyCallThroughManager((*self)->callThroughManager);
+        LLVMOrcDisposeIndirectStubsManager((*self)->stubsManager);
+        LLVMOrcDisposeThreadSafeContext((*self)->context);
+        array_free(&(*self)->alignedClasses);
+
+        free(*self);
+        *self = NULL;
+    } else {
+        panic("Jit struct has already been freed");
+    }
+}
+
+/**
+ * Adds a module to the JIT.
+ *
+ * @param self   The current Jit struct.
+ * @param module The module to add, which the JIT takes ownership of.
+ */
+void jit_addModule_(struct Jit *self, LLVMModuleRef module) {
+    jit_check(LLVMOrcLLJITAddLLVMIRModule(self->lljit, self->dylib, LLVMOrcCreateNewThreadSafeModule(module, self->context)),
+              "add module to JIT");
+}
+
+/**
+ * Gets whether a value is a global variable, or a constant expression using
+ * it.
+ *
+ * @param value  The value.
+ * @param global The global variable.
+ *
+ * @return Whether the value uses the global variable.
+ */
+bool jit_usesGlobal_(LLVMValueRef value, LLVMValueRef global) {
+    if (value == global) {
+        return true;
+    } else if (!LLVMIsAConstantExpr(value)) {
+        return false;
+    }
+
+    for (int index = 0; index < LLVMGetNumOperands(value); index++) {
+        if (jit_usesGlobal_(LLVMGetOperand(value, index), global)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Builds the instructions computing a value with a global variable replaced,
+ * as constant expressions using it cannot use the instruction replacing it.
+ *
+ * @param builder     The builder, positioned where the value is used.
+ * @param value       The value.
+ * @param global      The global variable.
+ * @param replacement What replaces the global variable.
+ *
+ * @return The value with the global variable replaced.
+ */
+LLVMValueRef jit_rebuild_(LLVMBuilderRef builder, LLVMValueRef value, LLVMValueRef global, LLVMValueRef replacement) {
+    LLVMOpcode opcode = 0;
+    LLVMValueRef *operands = NULL, rebuilt = NULL;
+    int length = 0;
+
+    if (value == global) {
+        return replacement;
+    } else if (!jit_usesGlobal_(value, global)) {
+        return value;
+    }
+
+    opcode = LLVMGetConstOpcode(value);
+    length = LLVMGetNumOperands(value);
+    operands = malloc(length * sizeof(LLVMValueRef));
+
+    if (!operands) {
+        panic("failed to malloc constant expression operands");
+    }
+
+    for (int index = 0; index < length; index++) {
+        operands[index] = jit_rebuild_(builder, LLVMGetOperand(value, index), global, replacement);
+    }
+
+    if (opcode == LLVMGetElementPtr) {
+        rebuilt = LLVMIsInBounds(value) ? LLVMBuildInBoundsGEP2(builder, LLVMGetGEPSourceElementType(value), operands[0],
+                                                                 operands + 1, length - 1, "")
+                                        : LLVMBuildGEP2(builder, LLVMGetGEPSourceElementType(value), operands[0],
+                                                        operands + 1, length - 1, "");
+    } else if (opcode >= LLVMTrunc && opcode <= LLVMAddrSpaceCast) {
+        rebuilt = LLVMBuildCast(builder, opcode, operands[0], LLVMTypeOf(value), "");
+    } else if (opcode >= LLVMAdd && opcode <= LLVMXor) {
+        rebuilt = LLVMBuildBinOp(builder, opcode, operands[0], operands[1], "");
+    } else {
+        panic("unsupported constant expression using a thread-local variable");
+    }
+
+    free(operands);
+
+    return rebuilt;
+}
+
+/**
+ * Collects the instructions using a value, directly or through constant
+ * expressions. An instruction may be collected more than once.
+ *
+ * @param value The value.
+ * @param users The instructions collected so far.
+ */
+void jit_collectUsers_(LLVMValueRef value, struct Array *users) {
+    for (LLVMUseRef use = LLVMGetFirstUse(value); use; use = LLVMGetNextUse(use)) {
+        LLVMValueRef user = LLVMGetUser(use);
+
+        if (LLVMIsAInstruction(user)) {
+            array_insert(users, users->length, user);
+        } else if (LLVMIsAConstantExpr(user)) {
+            jit_collectUsers_(user, users);
+        } else {
+            panic("thread-local variables can only be used by functions when run by the JIT");
+        }
+    }
+}
+
+/**
+ * Replaces the module's thread-local variables with 'struct JitThreadLocal'
+ * descriptors, as the JIT's linker cannot resolve thread-local relocations.
+ * Each use becomes a call getting the calling thread's copy, so programs
+ * the JIT runs still have one copy of each variable per thread.
+ *
+ * @param module The module.
+ */
+void jit_emulateThreadLocals_(LLVMModuleRef module) {
+    LLVMContextRef context = LLVMGetModuleContext(module);
+    LLVMBuilderRef builder = LLVMCreateBuilderInContext(context);
+    LLVMTypeRef int8Pointer = LLVMPointerType(LLVMInt8TypeInContext(context), 0);
+    LLVMTypeRef int64 = LLVMInt64TypeInContext(context), int32 = LLVMInt32TypeInContext(context);
+    LLVMTypeRef descriptorType = LLVMStructTypeInContext(context, (LLVMTypeRef[]){int8Pointer, int64, int64, int32, int32},
+                                                         5, false);
+    LLVMTypeRef functionType = LLVMFunctionType(int8Pointer, (LLVMTypeRef[]){LLVMPointerType(descriptorType, 0)}, 1, false);
+    LLVMValueRef function = NULL, next = NULL;
+
+    for (LLVMValueRef global = LLVMGetFirstGlobal(module); global; global = next) {
+        LLVMTypeRef type = LLVMGlobalGetValueType(global);
+        LLVMValueRef descriptor = NULL, initializer = LLVMGetInitializer(global);
+        struct Array *users = NULL;
+        char *name = NULL;
+
+        next = LLVMGetNextGlobal(global);
+
+        if (!LLVMIsThreadLocal(global)) {
+            continue;
+        } else if (!function && !(function = LLVMGetNamedFunction(module, JIT_THREAD_LOCAL_FUNCTION))) {
+            function = LLVMAddFunction(module, JIT_THREAD_LOCAL_FUNCTION, functionType);
+        }
+
+        name = stringConcatenate(1, LLVMGetValueName(global));
+        descriptor = LLVMAddGlobal(module, descriptorType, "");
+        LLVMSetLinkage(descriptor, LLVMGetLinkage(global));
+        LLVMSetVisibility(descriptor, LLVMGetVisibility(global));
+
+        if (initializer) { // Otherwise it is defined by another module
+            LLVMValueRef image = LLVMAddGlobal(module, type, stringConcatenate(2, name, ".image"));
+
+            LLVMSetInitializer(image, initializer);
+            LLVMSetGlobalConstant(image, true);
+            LLVMSetLinkage(image, LLVMPrivateLinkage);
+            LLVMSetInitializer(
+                descriptor,
+                LLVMConstStructInContext(context,
+                                         (LLVMValueRef[]){
+                                             LLVMConstBitCast(image, int8Pointer),
+                                             LLVMSizeOf(type),
+                                             LLVMGetAlignment(global) ? LLVMConstInt(int64, LLVMGetAlignment(global), false)
+                                                                      : LLVMAlignOf(type),
+                                             LLVMConstInt(int32, 0, false),
+                                             LLVMConstInt(int32, 0, false),
+                                         },
+                                         5, false));
+        }
+
+        users = array_new();
+        jit_collectUsers_(global, users);
+
+        for (size_t index = 0; index < users->length; index++) {
+            LLVMValueRef user = (LLVMValueRef)array_get(users, index);
+
+            for (int operand = 0; operand < LLVMGetNumOperands(user); operand++) {
+                LLVMValueRef copy = NULL;
+
+                if (!jit_usesGlobal_(LLVMGetOperand(user, operand), global)) {
+                    continue;
+                }
+
+                // A phi's incoming values are computed at the end of the block they come from
+                LLVMPositionBuilderBefore(builder, LLVMIsAPHINode(user)
+                                                       ? LLVMGetBasicBlockTerminator(LLVMGetIncomingBlock(user, operand))
+                                                       : user);
+                copy = LLVMBuildCall2(builder, functionType, function, &descriptor, 1, "");
+                copy = LLVMBuildBitCast(builder, copy, LLVMTypeOf(global), "");
+                LLVMSetOperand(user, operand, jit_rebuild_(builder, LLVMGetOperand(user, operand), global, copy));
+            }
+        }
+
+        array_free(&users);
+
+        // Only constant expressions no longer used are left using it
+        LLVMReplaceAllUsesWith(global, LLVMGetUndef(LLVMTypeOf(global)));
+        LLVMDeleteGlobal(global);
+        LLVMSetValueName(descriptor, name);
+        free(name);
+    }
+
+    LLVMDisposeBuilder(builder);
+}
+
+/**
+ * Copies the attributes and calling convention of a function to another.
+ *
+ * @param function The function copied from.
+ * @param other    The function copied to.
+ */
+void jit_copyAttributes_(LLVMValueRef function, LLVMValueRef other) {
+    LLVMSetFunctionCallConv(other, LLVMGetFunctionCallConv(function));
+
+    for (int index = -1; index <= (int)LLVMCountParams(function); index++) { // -1 is the function itself, 0 its result
+        LLVMAttributeIndex attributeIndex = (LLVMAttributeIndex)index; // -1 wraps to LLVMAttributeFunctionIndex
+        unsigned length = LLVMGetAttributeCountAtIndex(function, attributeIndex);
+        LLVMAttributeRef *attributes = NULL;
+
+        if (!length) {
+            continue;
+        } else if (!(attributes = malloc(length * sizeof(LLVMAttributeRef)))) {
+            panic("failed to malloc function attributes");
+        }
+
+        LLVMGetAttributesAtIndex(function, attributeIndex, attributes);
+
+        for (unsigned attribute = 0; attribute < length; attribute++) {
+            LLVMAddAttributeAtIndex(other, attributeIndex, attributes[attribute]);
+        }
+
+        free(attributes);
+    }
+}
+
+LLVMValueRef jit_map_(LLVMModuleRef module, LLVMValueRef function, LLVMValueRef value);
+
+/**
+ * Gets a global value's counterpart in another module, declaring it there
+ * the first time. Global variables keep their initializers, as in
+ * 'split_declareGlobals', so they can still be used for optimisation.
+ *
+ * @param module The other module.
+ * @param global The global value.
+ *
+ * @return The declaration.
+ */
+LLVMValueRef jit_declare_(LLVMModuleRef module, LLVMValueRef global) {
+    const char *NAME = LLVMGetValueName(global);
+    LLVMTypeRef type = LLVMGlobalGetValueType(global);
+    LLVMValueRef declaration = NULL, initializer = NULL;
+
+    if (LLVMGetTypeKind(type) == LLVMFunctionTypeKind) {
+        if (!(declaration = LLVMGetNamedFunction(module, NAME))) {
+            declaration = LLVMAddFunction(module, NAME, type);
+
+            if (LLVMIsAFunction(global)) {
+                jit_copyAttributes_(global, declaration);
+            }
+        }
+
+        return declaration;
+    } else if ((declaration = LLVMGetNamedGlobal(module, NAME))) {
+        return declaration;
+    }
+
+    declaration = LLVMAddGlobal(module, type, NAME);
+    LLVMSetAlignment(declaration, LLVMGetAlignment(global));
+
+    if (LLVMIsAGlobalVariable(global) && (initializer = LLVMGetInitializer(global))) {
+        LLVMSetGlobalConstant(declaration, LLVMIsGlobalConstant(global));
+        LLVMSetInitializer(declaration, jit_map_(module, NULL, initializer)); // Declared first, in case it is used
+        LLVMSetLinkage(declaration, LLVMAvailableExternallyLinkage);
+    }
+
+    return declaration;
+}
+
+/**
+ * Gets whether a constant uses a global value.
+ *
+ * @param constant The constant.
+ *
+ * @return Whether it uses a global value.
+ */
+bool jit_usesGlobalValue_(LLVMValueRef constant) {
+    if (LLVMIsAGlobalValue(constant)) {
+        return true;
+    } else if (!LLVMIsAConstantExpr(constant) && !LLVMIsAConstantStruct(constant) && !LLVMIsAConstantArray(constant) &&
+               !LLVMIsAConstantVector(constant) && !LLVMIsABlockAddress(constant)) {
+        return false;
+    }
+
+    for (int index = 0; index < LLVMGetNumOperands(constant); index++) {
+        if (jit_usesGlobalValue_(LLVMGetOperand(constant, index))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Maps a value used by a function's body, which is being moved to another
+ * module, to its counterpart there. Global values are declared there and
+ * constants using them rebuilt, while instructions, blocks and constants
+ * which use no global values move with the body.
+ *
+ * @param module   The other module.
+ * @param function The function the body was moved from, or NULL when
+ *                 mapping a global variable's initializer.
+ * @param value    The value.
+ *
+ * @return The counterpart.
+ */
+LLVMValueRef jit_map_(LLVMModuleRef module, LLVMValueRef function, LLVMValueRef value) {
+    LLVMValueRef *operands = NULL, mapped = NULL;
+    int length = 0;
+
+    if (LLVMIsAArgument(value)) {
+        for (unsigned index = 0; index < LLVMCountParams(function); index++) {
+            if (LLVMGetParam(function, index) == value) {
+                return LLVMGetParam(LLVMGetFirstFunction(module), index);
+            }
+        }
+
+        panic("failed to map argument of a function moved to another module");
+    } else if (function && value == function) { // Recursive calls skip the lazy stub
+        return LLVMGetFirstFunction(module);
+    } else if (LLVMIsAGlobalValue(value)) {
+        return jit_declare_(module, value);
+    } else if (!LLVMIsAConstant(value) || !jit_usesGlobalValue_(value)) {
+        return value;
+    } else if (LLVMIsABlockAddress(value)) {
+        panic("block addresses cannot be used by functions the JIT compiles lazily");
+    }
+
+    length = LLVMGetNumOperands(value);
+    operands = malloc((length ? length : 1) * sizeof(LLVMValueRef));
+
+    if (!operands) {
+        panic("failed to malloc constant operands");
+    }
+
+    for (int index = 0; index < length; index++) {
+        operands[index] = jit_map_(module, function, LLVMGetOperand(value, index));
+    }
+
+    if (LLVMIsAConstantStruct(value)) {
+        mapped = LLVMGetStructName(LLVMTypeOf(value))
+                     ? LLVMConstNamedStruct(LLVMTypeOf(value), operands, length)
+                     : LLVMConstStructInContext(LLVMGetTypeContext(LLVMTypeOf(value)), operands, length,
+                                                LLVMIsPackedStruct(LLVMTypeOf(value)));
+    } else if (LLVMIsAConstantArray(value)) {
+        mapped = LLVMConstArray(LLVMGetElementType(LLVMTypeOf(value)), operands, length);
+    } else if (LLVMIsAConstantVector(value)) {
+        mapped = LLVMConstVector(operands, length);
+    } else {
+        switch (LLVMGetConstOpcode(value)) {
+        case LLVMGetElementPtr:
+            mapped = LLVMIsInBounds(value) ? LLVMConstInBoundsGEP2(LLVMGetGEPSourceElementType(value), operands[0],
+                                                                  operands + 1, length - 1)
+                                           : LLVMConstGEP2(LLVMGetGEPSourceElementType(value), operands[0],
+                                                           operands + 1, length - 1);
+            break;
+        case LLVMBitCast:
+            mapped = LLVMConstBitCast(operands[0], LLVMTypeOf(value));
+            break;
+        case LLVMPtrToInt:
+            mapped = LLVMConstPtrToInt(operands[0], LLVMTypeOf(value));
+            break;
+        case LLVMIntToPtr:
+            mapped = LLVMConstIntToPtr(operands[0], LLVMTypeOf(value));
+            break;
+        case LLVMAddrSpaceCast:
+            mapped = LLVMConstAddrSpaceCast(operands[0], LLVMTypeOf(value));
+            break;
+        case LLVMTrunc:
+            mapped = LLVMConstTrunc(operands[0], LLVMTypeOf(value));
+            break;
+        case LLVMAdd:
+            mapped = LLVMConstAdd(operands[0], operands[1]);
+            break;
+        case LLVMSub:
+            mapped = LLVMConstSub(operands[0], operands[1]);
+            break;
+        case LLVMICmp:
+            mapped = LLVMConstICmp(LLVMGetICmpPredicate(value), operands[0], operands[1]);
+            break;
+        case LLVMSelect:
+            mapped = LLVMConstSelect(operands[0], operands[1], operands[2]);
+            break;
+        default:
+            panic("unsupported constant expression in a function the JIT compiles lazily");
+        }
+    }
+
+    free(operands);
+
+    return mapped;
+}
+
+/**
+ * Moves a function's body to a module of its own, as its first function,
+ * named with 'JIT_IMPL_SUFFIX', leaving the function a declaration. Only the global
+ * values the body uses are declared in the module, so moving each body
+ * takes time in proportion to its own size, not the whole module's.
+ *
+ * @param function The function.
+ *
+ * @return The module.
+ */
+LLVMModuleRef jit_moveBody_(LLVMValueRef function) {
+    const char *NAME = LLVMGetValueName(function);
+    LLVMModuleRef source = LLVMGetGlobalParent(function);
+    LLVMModuleRef module = LLVMModuleCreateWithNameInContext(NAME, LLVMGetModuleContext(source));
+    LLVMValueRef body = LLVMAddFunction(module, stringConcatenate(2, NAME, JIT_IMPL_SUFFIX),
+                                        LLVMGlobalGetValueType(function));
+    LLVMBasicBlockRef anchor = LLVMAppendBasicBlockInContext(LLVMGetModuleContext(source), body, ""), block = NULL;
+
+    LLVMSetDataLayout(module, LLVMGetDataLayoutStr(source));
+    LLVMSetTarget(module, LLVMGetTarget(source));
+    jit_copyAttributes_(function, body);
+    LLVMSetAlignment(body, LLVMGetAlignment(function));
+
+    if (LLVMGetSection(function)) {
+        LLVMSetSection(body, LLVMGetSection(function));
+    }
+
+    if (LLVMHasPersonalityFn(function)) {
+        LLVMSetPersonalityFn(body, jit_map_(module, function, LLVMGetPersonalityFn(function)));
+        LLVMSetPersonalityFn(function, NULL);
+    }
+
+    for (LLVMBasicBlockRef last = anchor; (block = LLVMGetFirstBasicBlock(function)); last = block) {
+        LLVMMoveBasicBlockAfter(block, last);
+    }
+
+    LLVMDeleteBasicBlock(anchor);
+    LLVMSetLinkage(function, LLVMExternalLinkage); // Declarations can only be external
+
+    for (block = LLVMGetFirstBasicBlock(body); block; block = LLVMGetNextBasicBlock(block)) {
+        for (LLVMValueRef instruction = LLVMGetFirstInstruction(block); instruction;
+             instruction = LLVMGetNextInstruction(instruction)) {
+            for (int index = 0; index < LLVMGetNumOperands(instruction); index++) {
+                LLVMValueRef operand = LLVMGetOperand(instruction, index);
+                LLVMValueRef mapped = operand ? jit_map_(module, function, operand) : NULL;
+
+                if (mapped != operand) {
+                    LLVMSetOperand(instruction, index, mapped);
+                }
+            }
+        }
+    }
+
+    return module;
+}
+
+/**
+ * Splits a module into one module per function, and adds each of them to
+ * the JIT behind a lazy stub. A function is only compiled the first time it
+ * is called, so programs start running before every function has been
+ * compiled.
+ *
+ * @param self   The current Jit struct.
+ * @param module The module to add, which the JIT takes ownership of.
+ */
+void jit_addModuleLazily(struct Jit *self, LLVMModuleRef module) {
+    LLVMModuleRef dataModule = NULL;
+    LLVMOrcCSymbolAliasMapPairs aliases = NULL;
+    LLVMOrcMaterializationUnitRef stubs = NULL;
+    LLVMValueRef mainFunction = LLVMGetNamedFunction(module, "main"), atExit = LLVMGetNamedFunction(module, "__cxa_atexit");
+    size_t aliasesLength = 0, functionsLength = 0;
+
+    if (mainFunction && split_isDefined(mainFunction)) {
+        self->mainReturnsInt = LLVMGetTypeKind(LLVMGetReturnType(LLVMGlobalGetValueType(mainFunction))) ==
+                               LLVMIntegerTypeKind;
+    }
+
+    align_share(module, self->alignedClasses); // The standard library is added first, so programs see its classes
+    align_apply(module);
+    coroutine_lower(module); // Before splitting, as each coroutine becomes several functions
+    jit_emulateThreadLocals_(module);
+    split_externaliseLocals(module);
+
+    if (atExit) {
+        LLVMSetValueName(atExit, JIT_AT_EXIT_FUNCTION);
+    }
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+        if (split_isDefined(function)) {
+            functionsLength++;
+        }
+    }
+
+    aliases = malloc(functionsLength * sizeof(LLVMOrcCSymbolAliasMapPair));
+
+    if (!aliases) {
+        panic("failed to malloc JIT symbol aliases");
+    }
+
+    for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+        const char *NAME = LLVMGetValueName(function);
+        LLVMModuleRef functionModule = NULL;
+
+        if (!split_isDefined(function)) {
+            continue;
+        }
+
+        functionModule = jit_moveBody_(function);
+        jit_addModule_(self, functionModule);
+
+        aliases[aliasesLength++] = (LLVMOrcCSymbolAliasMapPair){
+            LLVMOrcLLJITMangleAndIntern(self->lljit, NAME),
+            {
+                LLVMOrcLLJITMangleAndIntern(self->lljit, stringConcatenate(2, NAME, JIT_IMPL_SUFFIX)),
+                {LLVMJITSymbolGenericFlagsExported | LLVMJITSymbolGenericFlagsCallable, 0},
+            },
+        };
+    }
+
+    // What is left of the original module holds the global variables
+    dataModule = module;
+
+    jit_addModule_(self, dataModule);
+
+    stubs = LLVMOrcLazyReexports(self->callThroughManager, self->stubsManager, self->dylib, aliases, aliasesLength);
+    jit_check(LLVMOrcJITDylibDefine(self->dylib, stubs), "define lazy function stubs");
+
+    free(aliases);
+}
+
+/**
+ * Parses an LLVM IR file and adds it to the JIT.
+ *
+ * @param self      The current Jit struct.
+ * @param FILE_PATH The path of the LLVM IR file.
+ */
+void jit_addFile(struct Jit *self, const char *FILE_PATH) {
+    char *message = NULL;
+    LLVMMemoryBufferRef buffer = NULL;
+    LLVMModuleRef module = NULL;
+
+    if (LLVMCreateMemoryBufferWithContentsOfFile(FILE_PATH, &buffer, &message)) {
+        panic(stringConcatenate(4, "failed to open file '", FILE_PATH, "': ", message));
+    }
+
+    if (LLVMParseIRInContext(LLVMOrcThreadSafeContextGetContext(self->context), buffer, &module, &message)) {
+        panic(stringConcatenate(4, "failed to parse LLVM IR in file '", FILE_PATH, "': ", message));
+    }
+
+    jit_addModuleLazily(self, module);
+}
+
+/**
+ * Runs the 'main' function of the added modules.
+ *
+ * @param self The current Jit struct.
+ *
+ * @return The exit code of the program.
+ */
+int jit_run(struct Jit *self) {
+    LLVMOrcExecutorAddress address = 0;
+
+    jit_check(LLVMOrcLLJITLookup(self->lljit, &address, "main"), "look up 'main' function");
+
+    if (self->mainReturnsInt) {
+        return ((int (*)(void))address)();
+    }
+
+    ((void (*)(void))address)();
+
+    return EXIT_SUCCESS;
+}
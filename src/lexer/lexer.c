@@ -18,8 +18,10 @@
  * Used to identify keywords.
  */
 static const struct Array KEYWORDS = {
-    16,
+    19,
     (const void *[]){
+        "async",
+        "await",
         "break",
         "case",
         "class",
@@ -6,10 +6,73 @@
 #include "./includes.c"
 
 #include "./args/args.c"
+#include "./codegen/codegen.c"
 #include "./compiler/compiler.c"
+#include "./jit/jit.c"
 
 #pragma pack(1)
 
+/**
+ * Runs an LLVM IR file, along with the standard library, in the JIT.
+ *
+ * @param args The parsed arguments.
+ *
+ * @return The exit code of the program.
+ */
+int main_run(struct Args *args) {
+    int exitCode = EXIT_SUCCESS;
+    struct Jit *jit = jit_new();
+
+    jit_addFile(jit, stringConcatenate(2, args->stdlib, "/std-llvm-ir/std.ll"));
+    jit_addFile(jit, stringConcatenate(2, args->stdlib, "/runtime-llvm-ir/scheduler.ll"));
+    jit_addFile(jit, stringConcatenate(2, args->stdlib, "/runtime-llvm-ir/async.ll"));
+    jit_addFile(jit, args->file);
+
+    exitCode = jit_run(jit);
+
+    // Not freed, as the program's exit handlers, like the one flushing std.io's buffers, run after this returns
+    return exitCode;
+}
+
+/**
+ * Builds an LLVM IR file, along with the standard library, into an
+ * executable.
+ *
+ * @param args The parsed arguments.
+ *
+ * @return The exit code of the build.
+ */
+int main_build(struct Args *args) {
+    size_t outputLength = strlen(args->output);
+    struct Codegen *codegen =
+        codegen_new(args->codegenUnits, args->incremental ? stringConcatenate(2, args->output, ".cache") : NULL, args->lto,
+                    args->profileGenerate, args->profileUse, args->inlineReport, args->checkReport,
+                    args->instanceReport, args->cacheReport);
+
+    codegen_addFile(codegen, args->file);
+
+    for (size_t index = 0; index < args->packages->length; index++) {
+        codegen_addFile(codegen, array_get(args->packages, index));
+    }
+
+    if (outputLength <= 3 || strcmp(args->output + outputLength - 3, ".bc") != 0) { // Packages are linked against the
+                                                                                   // standard library by the program
+        codegen_addFile(codegen, stringConcatenate(2, args->stdlib, "/std-llvm-ir/std.ll"));
+        codegen_addFile(codegen, stringConcatenate(2, args->stdlib, "/runtime-llvm-ir/scheduler.ll"));
+        codegen_addFile(codegen, stringConcatenate(2, args->stdlib, "/runtime-llvm-ir/async.ll"));
+
+        if (args->profileGenerate) {
+            codegen_addFile(codegen, stringConcatenate(2, args->stdlib, "/std-llvm-ir/profile.ll"));
+        }
+    }
+
+    codegen_emit(codegen, args->output);
+
+    codegen_free(&codegen);
+
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, char **argv) {
     struct Args *args = NULL;
     struct Compiler *compiler = NULL;
@@ -18,10 +81,16 @@ int main(int argc, char **argv) {
 
     args = args_new(argc, argv);
 
-    compiler = compiler_new("../../programs/test.exl");
+    if (args_isLlvmIr_(args->file)) {
+        return args->run ? main_run(args) : main_build(args);
+    }
+
+    compiler = compiler_new(args->file);
 
     while (compiler_compile(compiler)) {
     }
 
     compiler_free(&compiler);
+
+    args_free(&args);
 }
@@ -452,6 +452,35 @@ void parser_parseKeyword_func(struct Parser *self, const struct LexerToken *func
     parser_parseFunction(self, funcKeywordLexerToken, NULL);
 }
 
+/**
+ * Parses the current async function, which must follow 'async'. Errors, as
+ * async functions are not lowered yet.
+ *
+ * @param self                   The current Parser struct.
+ * @param asyncKeywordLexerToken The current lexer token.
+ */
+void parser_parseKeyword_async(struct Parser *self, const struct LexerToken *asyncKeywordLexerToken) {
+    size_t funcKeywordLexerTokenIndex = 0;
+    const struct LexerToken *funcKeywordLexerToken = NULL;
+
+    if (!lexer_lex(self->lexer, false)) {
+        lexer_error(self->lexer, P0001, "expected 'func' keyword after 'async' keyword, got 0", asyncKeywordLexerToken);
+    }
+
+    funcKeywordLexerToken = lexer_getToken(self->lexer, &funcKeywordLexerTokenIndex);
+
+    if (funcKeywordLexerToken->identifier != LEXERTOKENS_KEYWORD ||
+        strcmp(funcKeywordLexerToken->value->_value, "func") != 0) {
+        lexer_error(self->lexer, P0002,
+                    stringConcatenate(3, "expected 'func' keyword after 'async' keyword, got '",
+                                      funcKeywordLexerToken->value->_value, "'"),
+                    funcKeywordLexerToken);
+    }
+
+    // TODO: Mark the function async, to be lowered to a coroutine as 'runtime-llvm-ir/async.ll' describes
+    lexer_error(self->lexer, P0003, "async functions are not supported yet", asyncKeywordLexerToken);
+}
+
 /**
  * Parses the current keyword.
  *
@@ -459,7 +488,12 @@ void parser_parseKeyword_func(struct Parser *self, const struct LexerToken *func
  * @param lexerToken The current lexer token.
  */
 void parser_parseKeyword(struct Parser *self, const struct LexerToken *lexerToken) {
-    if (strcmp(lexerToken->value->_value, "class") == 0) {
+    if (strcmp(lexerToken->value->_value, "async") == 0) {
+        parser_parseKeyword_async(self, lexerToken);
+    } else if (strcmp(lexerToken->value->_value, "await") == 0) {
+        // TODO: Add await handling logic, lowered as 'runtime-llvm-ir/async.ll' describes
+        lexer_error(self->lexer, P0003, "'await' is not supported yet", lexerToken);
+    } else if (strcmp(lexerToken->value->_value, "class") == 0) {
         parser_parseKeyword_class(self, lexerToken);
     } else if (strcmp(lexerToken->value->_value, "func") == 0) {
         parser_parseKeyword_func(self, lexerToken);
@@ -471,6 +505,121 @@ void parser_parseKeyword(struct Parser *self, const struct LexerToken *lexerToke
     }
 }
 
+/**
+ * Lexes the next token of an attribute, which must be of a type.
+ *
+ * @param self               The current Parser struct.
+ * @param previousLexerToken The attribute's token before it.
+ * @param IDENTIFIER         The type of the token.
+ * @param DESCRIPTION        What the token is, for errors.
+ *
+ * @return The token.
+ */
+const struct LexerToken *parser_parseAttributeToken(struct Parser *self, const struct LexerToken *previousLexerToken,
+                                                    const enum LexerTokenIdentifiers IDENTIFIER,
+                                                    const char *DESCRIPTION) {
+    size_t lexerTokenIndex = 0;
+    const struct LexerToken *lexerToken = NULL;
+
+    if (!lexer_lex(self->lexer, false)) {
+        lexer_error(self->lexer, P0001,
+                    stringConcatenate(3, "expected ", DESCRIPTION, " in attribute, got 0"), previousLexerToken);
+    }
+
+    lexerToken = lexer_getToken(self->lexer, &lexerTokenIndex);
+
+    if (lexerToken->identifier != IDENTIFIER) {
+        lexer_error(self->lexer, P0002,
+                    stringConcatenate(5, "expected ", DESCRIPTION, " in attribute, got '", lexerToken->value->_value,
+                                      "'"),
+                    lexerToken);
+    }
+
+    return lexerToken;
+}
+
+/**
+ * Parses an '@align(N)' attribute, which aligns each instance of the class
+ * after it to N bytes, a power of 2, so ones shared between threads can
+ * start their own cache lines. Errors once parsed, as it is not applied
+ * yet.
+ *
+ * @param self           The current Parser struct.
+ * @param nameLexerToken The attribute's name.
+ */
+void parser_parseAttribute_align(struct Parser *self, const struct LexerToken *nameLexerToken) {
+    const struct LexerToken *openBraceLexerToken =
+        parser_parseAttributeToken(self, nameLexerToken, LEXERTOKENS_OPEN_BRACE, "'('");
+    const struct LexerToken *alignmentLexerToken =
+        parser_parseAttributeToken(self, openBraceLexerToken, LEXERTOKENS_INTEGER, "alignment");
+    unsigned long alignment = strtoul(alignmentLexerToken->value->_value, NULL, 10);
+
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        lexer_error(self->lexer, P0002,
+                    stringConcatenate(3, "expected alignment which is a power of 2, got '",
+                                      alignmentLexerToken->value->_value, "'"),
+                    alignmentLexerToken);
+    }
+
+    parser_parseAttributeToken(self, alignmentLexerToken, LEXERTOKENS_CLOSE_BRACE, "')'");
+
+    // TODO: Mark the class after it, listing it in 'exeme.align' metadata as 'codegen/align.c' describes
+    lexer_error(self->lexer, P0003, "'@align' is not supported yet", nameLexerToken);
+}
+
+/**
+ * Parses a '@target("avx2")' attribute, which specialises the function
+ * after it for CPU features, separated by commas, so it can use their
+ * instructions when the CPU running it has them. Errors once parsed, as it
+ * is not applied yet.
+ *
+ * @param self           The current Parser struct.
+ * @param nameLexerToken The attribute's name.
+ */
+void parser_parseAttribute_target(struct Parser *self, const struct LexerToken *nameLexerToken) {
+    const struct LexerToken *openBraceLexerToken =
+        parser_parseAttributeToken(self, nameLexerToken, LEXERTOKENS_OPEN_BRACE, "'('");
+    const struct LexerToken *featuresLexerToken =
+        parser_parseAttributeToken(self, openBraceLexerToken, LEXERTOKENS_STRING, "CPU features");
+
+    if (featuresLexerToken->value->length == 0) {
+        lexer_error(self->lexer, P0002, "expected CPU features, got an empty string", featuresLexerToken);
+    }
+
+    parser_parseAttributeToken(self, featuresLexerToken, LEXERTOKENS_CLOSE_BRACE, "')'");
+
+    // TODO: Mark the function after it, with 'vector_setTarget' as 'codegen/vector.c' describes
+    lexer_error(self->lexer, P0003, "'@target' is not supported yet", nameLexerToken);
+}
+
+/**
+ * Parses the current attribute, which marks the class or function after it.
+ *
+ * @param self         The current Parser struct.
+ * @param atLexerToken The current lexer token.
+ */
+void parser_parseAttribute(struct Parser *self, const struct LexerToken *atLexerToken) {
+    const struct LexerToken *nameLexerToken =
+        parser_parseAttributeToken(self, atLexerToken, LEXERTOKENS_IDENTIFIER, "attribute name after '@'");
+
+    if (strcmp(nameLexerToken->value->_value, "align") == 0) {
+        parser_parseAttribute_align(self, nameLexerToken);
+    } else if (strcmp(nameLexerToken->value->_value, "const") == 0) {
+        // TODO: Mark the function after it with the 'exeme-const' attribute, as 'codegen/evaluator.c' describes
+        lexer_error(self->lexer, P0003, "'@const' is not supported yet", nameLexerToken);
+    } else if (strcmp(nameLexerToken->value->_value, "inline") == 0 ||
+               strcmp(nameLexerToken->value->_value, "noinline") == 0) {
+        // TODO: Mark the function after it, as 'codegen/inliner.c' describes
+        lexer_error(self->lexer, P0003,
+                    stringConcatenate(3, "'@", nameLexerToken->value->_value, "' is not supported yet"), nameLexerToken);
+    } else if (strcmp(nameLexerToken->value->_value, "target") == 0) {
+        parser_parseAttribute_target(self, nameLexerToken);
+    } else {
+        lexer_error(self->lexer, P0002,
+                    stringConcatenate(3, "unknown attribute '", nameLexerToken->value->_value, "'"), nameLexerToken);
+    }
+}
+
 /**
  * Parses the current identifier.
  *
@@ -644,6 +793,9 @@ void parser_parseNext(struct Parser *self) {
     case LEXERTOKENS_BITWISE_RIGHT_SHIFT_ASSIGNMENT:
         parser_parseAssignment(self, lexerToken);
         break;
+    case LEXERTOKENS_AT:
+        parser_parseAttribute(self, lexerToken);
+        break;
     case LEXERTOKENS_OPEN_BRACE:
         array_insert(self->parserTokens, self->parserTokens->length,
                      ast_new(ASTTOKENS_OPEN_BRACE, AST_OPEN_BRACE, lexerToken));
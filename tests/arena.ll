@@ -0,0 +1,152 @@
+; Checks which allocator std's strings and builders grow with, exiting with
+; the number of the first check to fail, or 0. Strings only take an arena
+; as their allocator with 'reserve_in', so one made outside a 'using' scope
+; and appended to inside it stays on the heap, and outlives the arena.
+
+%str = type { i8*, i64, i64 }
+%strings_SEP_Builder = type { i8*, i64, i64 }
+%mem_SEP_Arena = type { i8*, i8*, i8* }
+
+@.characters = private unnamed_addr constant [40 x i8] c"abcdefghijabcdefghijabcdefghijabcdefghi\00"
+
+declare void @str_SEP___init__(%str*)
+declare void @str_SEP___del__(%str*)
+declare void @str_SEP_append(%str*, i8*, i64)
+declare void @str_SEP_reserve_in(%str*, i64, %mem_SEP_Arena*)
+declare i8* @str_SEP_data(%str*)
+declare i64 @str_SEP_length(%str*)
+declare void @strings_SEP_Builder_SEP___init__(%strings_SEP_Builder*)
+declare void @strings_SEP_Builder_SEP_reserve_in(%strings_SEP_Builder*, i64, %mem_SEP_Arena*)
+declare void @strings_SEP_Builder_SEP_append_int(%strings_SEP_Builder*, i64)
+declare void @strings_SEP_Builder_SEP_finish(%strings_SEP_Builder*, %str*)
+declare void @mem_SEP_Arena_SEP___init__(%mem_SEP_Arena*)
+declare %mem_SEP_Arena* @mem_SEP_Arena_SEP___enter__(%mem_SEP_Arena*)
+declare void @mem_SEP_Arena_SEP___exit__(%mem_SEP_Arena*, %mem_SEP_Arena*)
+declare %mem_SEP_Arena* @mem_SEP_current_arena()
+declare i32 @memcmp(i8*, i8*, i64)
+
+; Appends the 39 characters 'count' times.
+define internal void @append(%str* %string, i32 %count) {
+entry:
+    %characters = getelementptr [40 x i8], [40 x i8]* @.characters, i64 0, i64 0
+    br label %condition
+
+condition:
+    %index = phi i32 [ 0, %entry ], [ %next_index, %body ]
+    %is_appending = icmp ult i32 %index, %count
+    br i1 %is_appending, label %body, label %exit
+
+body:
+    call void @str_SEP_append(%str* %string, i8* %characters, i64 39)
+    %next_index = add i32 %index, 1
+    br label %condition
+
+exit:
+    ret void
+}
+
+; Gets whether a string's characters are in an arena, from the flag in its
+; capacity.
+define internal i1 @is_in_arena(%str* %string) {
+    %capacity_pointer = getelementptr %str, %str* %string, i64 0, i32 2
+    %capacity = load i64, i64* %capacity_pointer
+    %arena_flag = and i64 %capacity, 4611686018427387904 ; 1 << 62
+    %is_in_arena = icmp ne i64 %arena_flag, 0
+
+    ret i1 %is_in_arena
+}
+
+; Gets the arena a string's characters are in, from before them.
+define internal %mem_SEP_Arena* @get_arena(%str* %string) {
+    %data = call i8* @str_SEP_data(%str* %string)
+    %header = getelementptr i8, i8* %data, i64 -16
+    %arena_pointer = bitcast i8* %header to %mem_SEP_Arena**
+    %arena = load %mem_SEP_Arena*, %mem_SEP_Arena** %arena_pointer
+
+    ret %mem_SEP_Arena* %arena
+}
+
+define i32 @main() {
+entry:
+    %outer = alloca %mem_SEP_Arena
+    %inner = alloca %mem_SEP_Arena
+    %outside = alloca %str
+    %taken = alloca %str
+    %built = alloca %str
+    %builder = alloca %strings_SEP_Builder
+    call void @mem_SEP_Arena_SEP___init__(%mem_SEP_Arena* %outer)
+    call void @mem_SEP_Arena_SEP___init__(%mem_SEP_Arena* %inner)
+    call void @str_SEP___init__(%str* %outside)
+    call void @str_SEP_append(%str* %outside, i8* getelementptr ([40 x i8], [40 x i8]* @.characters, i64 0, i64 0),
+                              i64 39)
+
+    ; 1: Appending inside a scope to a string made outside it keeps it on the heap
+    %previous = call %mem_SEP_Arena* @mem_SEP_Arena_SEP___enter__(%mem_SEP_Arena* %outer)
+    call void @append(%str* %outside, i32 4)
+    %is_outside_in_arena = call i1 @is_in_arena(%str* %outside)
+    br i1 %is_outside_in_arena, label %fail_1, label %check_2
+
+check_2: ; 2: The current arena is the one entered
+    %current = call %mem_SEP_Arena* @mem_SEP_current_arena()
+    %is_current = icmp eq %mem_SEP_Arena* %current, %outer
+    br i1 %is_current, label %check_3, label %fail_2
+
+check_3: ; 3: 'reserve_in' moves a string into the arena, which it keeps growing in, with an inner arena entered
+    call void @str_SEP___init__(%str* %taken)
+    call void @str_SEP_reserve_in(%str* %taken, i64 8, %mem_SEP_Arena* %current)
+    %inner_previous = call %mem_SEP_Arena* @mem_SEP_Arena_SEP___enter__(%mem_SEP_Arena* %inner)
+    call void @append(%str* %taken, i32 10)
+    call void @mem_SEP_Arena_SEP___exit__(%mem_SEP_Arena* %inner, %mem_SEP_Arena* %inner_previous)
+    %is_taken_in_arena = call i1 @is_in_arena(%str* %taken)
+    %taken_arena = call %mem_SEP_Arena* @get_arena(%str* %taken)
+    %is_taken_in_outer = icmp eq %mem_SEP_Arena* %taken_arena, %outer
+    %is_taken = and i1 %is_taken_in_arena, %is_taken_in_outer
+    %taken_length = call i64 @str_SEP_length(%str* %taken)
+    %is_taken_length = icmp eq i64 %taken_length, 390
+    %is_taken_kept = and i1 %is_taken, %is_taken_length
+    br i1 %is_taken_kept, label %check_4, label %fail_3
+
+check_4: ; 4: A builder moved into the arena finishes a string in it
+    call void @strings_SEP_Builder_SEP___init__(%strings_SEP_Builder* %builder)
+    call void @strings_SEP_Builder_SEP_reserve_in(%strings_SEP_Builder* %builder, i64 1, %mem_SEP_Arena* %outer)
+    call void @strings_SEP_Builder_SEP_append_int(%strings_SEP_Builder* %builder, i64 -1234567890123456789)
+    call void @strings_SEP_Builder_SEP_append_int(%strings_SEP_Builder* %builder, i64 -1234567890123456789)
+    call void @strings_SEP_Builder_SEP_finish(%strings_SEP_Builder* %builder, %str* %built)
+    %is_built_in_arena = call i1 @is_in_arena(%str* %built)
+    %built_arena = call %mem_SEP_Arena* @get_arena(%str* %built)
+    %is_built_in_outer = icmp eq %mem_SEP_Arena* %built_arena, %outer
+    %is_built = and i1 %is_built_in_arena, %is_built_in_outer
+    br i1 %is_built, label %check_5, label %fail_4
+
+check_5: ; 5: Once the arena is freed, the string made outside it still has its characters
+    call void @mem_SEP_Arena_SEP___exit__(%mem_SEP_Arena* %outer, %mem_SEP_Arena* %previous)
+    call void @append(%str* %outside, i32 1)
+    %outside_length = call i64 @str_SEP_length(%str* %outside)
+    %is_outside_length = icmp eq i64 %outside_length, 234
+    %outside_data = call i8* @str_SEP_data(%str* %outside)
+    %last = getelementptr i8, i8* %outside_data, i64 195
+    %difference = call i32 @memcmp(i8* %last, i8* getelementptr ([40 x i8], [40 x i8]* @.characters, i64 0, i64 0),
+                                   i64 39)
+    %is_same = icmp eq i32 %difference, 0
+    %is_outside_kept = and i1 %is_outside_length, %is_same
+    call void @str_SEP___del__(%str* %outside)
+    br i1 %is_outside_kept, label %pass, label %fail_5
+
+pass:
+    ret i32 0
+
+fail_1:
+    ret i32 1
+
+fail_2:
+    ret i32 2
+
+fail_3:
+    ret i32 3
+
+fail_4:
+    ret i32 4
+
+fail_5:
+    ret i32 5
+}
@@ -0,0 +1,23 @@
+# Builds 'tests/cache.ll' incrementally, changes its string literal and builds it again, checking the function folding
+# the literal was recompiled. Run with 'cmake -DEXEME=... -DSOURCE=... -DLIBRARY=... -DBINARY_DIR=... -P cache.cmake'.
+
+file(REMOVE_RECURSE ${BINARY_DIR}/cache.cache)
+file(READ ${SOURCE} source)
+
+foreach(literal abc azc)
+    string(REPLACE "abc" ${literal} changed "${source}")
+    file(WRITE ${BINARY_DIR}/cache.ll "${changed}")
+
+    execute_process(COMMAND ${EXEME} build ${BINARY_DIR}/cache.ll -s ${LIBRARY} -i -o ${BINARY_DIR}/cache
+                    RESULT_VARIABLE result)
+
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "failed to build the literal '${literal}'")
+    endif()
+endforeach()
+
+execute_process(COMMAND ${BINARY_DIR}/cache RESULT_VARIABLE result)
+
+if(NOT result EQUAL 122)
+    message(FATAL_ERROR "expected the changed literal's 'z', 122, got ${result}")
+endif()
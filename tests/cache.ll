@@ -0,0 +1,22 @@
+; A function which 'codegen/cache.c' has to recompile when a string literal
+; changes, though it only uses the literal through a constant expression.
+; 'tests/cache.cmake' builds it incrementally, changes "abc" to "azc" and
+; builds it again, which should exit with 'z', 122, rather than the 'b', 98,
+; folded into the first build's object file.
+
+@string = internal constant [4 x i8] c"abc\00"
+
+; Gets the literal's second character plus 'offset', which is not known
+; until runtime, so the call is left for each build's codegen to fold.
+define internal i32 @second(i32 %offset) noinline {
+    %character = load i8, i8* getelementptr ([4 x i8], [4 x i8]* @string, i64 0, i64 1)
+    %wide_character = zext i8 %character to i32
+    %result = add i32 %wide_character, %offset
+    ret i32 %result
+}
+
+define i32 @main(i32 %argc, i8** %argv) {
+    %offset = sub i32 %argc, 1
+    %result = call i32 @second(i32 %offset)
+    ret i32 %result
+}
@@ -0,0 +1,407 @@
+/**
+ * Part of the Exeme Project, under the MIT license. See '/LICENSE' for
+ * license information. SPDX-License-Identifier: MIT License.
+ */
+
+/**
+ * Builds a module which checks the builders in 'codegen/arithmetic.c',
+ * 'codegen/loop.c' and 'codegen/vector.c', verifies it and writes it to the file given, for
+ * 'lli' to run. Its exit code is the number of the first check which
+ * failed, or 0 if they all passed.
+ */
+
+#include "../src/includes.c"
+
+#include <llvm-c/Analysis.h>
+#include <llvm-c/BitWriter.h>
+#include <llvm-c/Core.h>
+
+#include "../src/codegen/arithmetic.c"
+#include "../src/codegen/loop.c"
+#include "../src/codegen/vector.c"
+
+/**
+ * Represents the module being built, and the 'main' function running its
+ * checks.
+ */
+struct Test {
+    LLVMContextRef context;
+    LLVMModuleRef module;
+    LLVMBuilderRef builder;
+    LLVMValueRef main;
+    unsigned checks;
+};
+
+/**
+ * Builds a check that a value equals what it should, returning the check's
+ * number from 'main' if it does not.
+ *
+ * @param self     The current Test struct.
+ * @param actual   The value, an integer or float.
+ * @param expected The value it should be, of the same type.
+ */
+void test_expect_(struct Test *self, LLVMValueRef actual, LLVMValueRef expected) {
+    LLVMBasicBlockRef failed = LLVMAppendBasicBlockInContext(self->context, self->main, "failed"),
+                      passed = LLVMAppendBasicBlockInContext(self->context, self->main, "passed");
+    LLVMValueRef equal = LLVMGetTypeKind(LLVMTypeOf(actual)) == LLVMIntegerTypeKind
+                             ? LLVMBuildICmp(self->builder, LLVMIntEQ, actual, expected, "")
+                             : LLVMBuildFCmp(self->builder, LLVMRealOEQ, actual, expected, "");
+
+    LLVMBuildCondBr(self->builder, equal, passed, failed);
+
+    LLVMPositionBuilderAtEnd(self->builder, failed);
+    LLVMBuildRet(self->builder, LLVMConstInt(LLVMInt32TypeInContext(self->context), ++self->checks, false));
+
+    LLVMPositionBuilderAtEnd(self->builder, passed);
+}
+
+/**
+ * Builds a constant vector of 32-bit integers.
+ *
+ * @param self     The current Test struct.
+ * @param ELEMENTS The elements.
+ * @param length   The number of elements.
+ *
+ * @return The vector.
+ */
+LLVMValueRef test_buildIntegers_(struct Test *self, const long long *ELEMENTS, unsigned length) {
+    LLVMValueRef elements[8];
+
+    for (unsigned index = 0; index < length; index++) {
+        elements[index] = LLVMConstInt(LLVMInt32TypeInContext(self->context), (unsigned long long)ELEMENTS[index], true);
+    }
+
+    return LLVMConstVector(elements, length);
+}
+
+/**
+ * Hides a constant behind a store and a load, so the builders treat it as
+ * a value known only at runtime.
+ *
+ * @param self  The current Test struct.
+ * @param value The constant.
+ *
+ * @return The loaded value.
+ */
+LLVMValueRef test_buildOpaque_(struct Test *self, LLVMValueRef value) {
+    LLVMValueRef slot = LLVMBuildAlloca(self->builder, LLVMTypeOf(value), "opaque");
+
+    LLVMBuildStore(self->builder, value, slot);
+
+    return LLVMBuildLoad2(self->builder, LLVMTypeOf(value), slot, "");
+}
+
+/**
+ * Checks '**', '//' and the remainder of '//' on scalars, with operands
+ * known at compile time and only at runtime, including unsigned powers too
+ * big for 'llvm.powi'.
+ *
+ * @param self The current Test struct.
+ */
+void test_checkArithmetic_(struct Test *self) {
+    LLVMTypeRef int32 = LLVMInt32TypeInContext(self->context), int64 = LLVMInt64TypeInContext(self->context),
+                float64 = LLVMDoubleTypeInContext(self->context);
+
+#define TEST_INTEGER(VALUE) LLVMConstInt(int64, (unsigned long long)(VALUE), true)
+#define TEST_FLOAT(VALUE) LLVMConstReal(float64, VALUE)
+#define TEST_OPAQUE(VALUE) test_buildOpaque_(self, VALUE)
+#define TEST_POWER(BASE, EXPONENT, IS_SIGNED) arithmetic_buildPower(self->builder, BASE, EXPONENT, IS_SIGNED)
+#define TEST_DIVIDE(LEFT, RIGHT, IS_SIGNED) arithmetic_buildFloorDivision(self->builder, LEFT, RIGHT, IS_SIGNED)
+#define TEST_MODULO(LEFT, RIGHT, IS_SIGNED) arithmetic_buildFloorModulo(self->builder, LEFT, RIGHT, IS_SIGNED)
+
+    test_expect_(self, TEST_POWER(TEST_OPAQUE(TEST_INTEGER(3)), TEST_OPAQUE(TEST_INTEGER(5)), true), TEST_INTEGER(243));
+    test_expect_(self, TEST_POWER(TEST_OPAQUE(TEST_INTEGER(-2)), TEST_INTEGER(3), true), TEST_INTEGER(-8));
+    test_expect_(self, TEST_POWER(TEST_OPAQUE(TEST_INTEGER(7)), TEST_OPAQUE(TEST_INTEGER(0)), false), TEST_INTEGER(1));
+    test_expect_(self, TEST_POWER(TEST_OPAQUE(TEST_INTEGER(2)), TEST_OPAQUE(TEST_INTEGER(-1)), true), TEST_INTEGER(0));
+    test_expect_(self, TEST_POWER(TEST_OPAQUE(TEST_INTEGER(-1)), TEST_OPAQUE(TEST_INTEGER(-3)), true), TEST_INTEGER(-1));
+    test_expect_(self, TEST_POWER(TEST_OPAQUE(TEST_FLOAT(2)), TEST_OPAQUE(LLVMConstInt(int32, -2ULL, true)), true),
+                 TEST_FLOAT(0.25));
+    test_expect_(self, TEST_POWER(TEST_OPAQUE(TEST_FLOAT(2)), TEST_OPAQUE(LLVMConstInt(int32, 3, false)), false),
+                 TEST_FLOAT(8));
+    test_expect_(self, // Read as signed, 2^31 is INT_MIN, which would give infinity
+                 TEST_POWER(TEST_OPAQUE(TEST_FLOAT(0.5)), TEST_OPAQUE(LLVMConstInt(int32, 0x80000000, false)), false),
+                 TEST_FLOAT(0));
+    test_expect_(self, // Read as signed, 2^32 - 1 is -1, which would give 2
+                 TEST_POWER(TEST_OPAQUE(TEST_FLOAT(0.5)), LLVMConstInt(int32, 0xffffffff, false), false), TEST_FLOAT(0));
+
+    test_expect_(self, TEST_DIVIDE(TEST_OPAQUE(TEST_INTEGER(-7)), TEST_OPAQUE(TEST_INTEGER(2)), true), TEST_INTEGER(-4));
+    test_expect_(self, TEST_DIVIDE(TEST_OPAQUE(TEST_INTEGER(7)), TEST_OPAQUE(TEST_INTEGER(-2)), true), TEST_INTEGER(-4));
+    test_expect_(self, TEST_DIVIDE(TEST_OPAQUE(TEST_INTEGER(-7)), TEST_INTEGER(3), true), TEST_INTEGER(-3));
+    test_expect_(self, TEST_DIVIDE(TEST_OPAQUE(TEST_INTEGER(-7)), TEST_INTEGER(4), true), TEST_INTEGER(-2));
+    test_expect_(self, TEST_DIVIDE(TEST_OPAQUE(TEST_INTEGER(7)), TEST_INTEGER(2), false), TEST_INTEGER(3));
+    test_expect_(self, TEST_DIVIDE(TEST_OPAQUE(TEST_FLOAT(-7)), TEST_FLOAT(2), true), TEST_FLOAT(-4));
+
+    test_expect_(self, TEST_MODULO(TEST_OPAQUE(TEST_INTEGER(-7)), TEST_OPAQUE(TEST_INTEGER(2)), true), TEST_INTEGER(1));
+    test_expect_(self, TEST_MODULO(TEST_OPAQUE(TEST_INTEGER(7)), TEST_OPAQUE(TEST_INTEGER(-2)), true), TEST_INTEGER(-1));
+    test_expect_(self, TEST_MODULO(TEST_OPAQUE(TEST_INTEGER(-7)), TEST_INTEGER(3), true), TEST_INTEGER(2));
+    test_expect_(self, TEST_MODULO(TEST_OPAQUE(TEST_INTEGER(-7)), TEST_INTEGER(4), true), TEST_INTEGER(1));
+    test_expect_(self, TEST_MODULO(TEST_OPAQUE(TEST_FLOAT(-7.5)), TEST_FLOAT(2), true), TEST_FLOAT(0.5));
+
+#undef TEST_INTEGER
+#undef TEST_FLOAT
+#undef TEST_OPAQUE
+#undef TEST_POWER
+#undef TEST_DIVIDE
+#undef TEST_MODULO
+}
+
+/**
+ * Builds a function summing 'value + 100 * index' over 'range(start, end)',
+ * and checks it for a few ranges, including empty ones.
+ *
+ * @param self The current Test struct.
+ */
+void test_checkRange_(struct Test *self) {
+    LLVMTypeRef int64 = LLVMInt64TypeInContext(self->context);
+    LLVMValueRef function = LLVMAddFunction(self->module, "sum_range",
+                                            LLVMFunctionType(int64, (LLVMTypeRef[]){int64, int64}, 2, false)),
+                 total = NULL;
+    LLVMBuilderRef builder = LLVMCreateBuilderInContext(self->context);
+    struct LoopRange range;
+    static const long long RANGES[][3] = {{3, 10, 2142}, {-2, 1, 297}, {10, 3, 0}, {5, 5, 0}};
+
+    if (!loop_isRange("range") || loop_isRange("ranges")) {
+        panic("loop_isRange does not match only 'range'");
+    }
+
+    LLVMPositionBuilderAtEnd(builder, LLVMAppendBasicBlockInContext(self->context, function, "entry"));
+    total = LLVMBuildAlloca(builder, int64, "total");
+    LLVMBuildStore(builder, LLVMConstNull(int64), total);
+
+    range = loop_beginRange(builder, LLVMGetParam(function, 0), LLVMGetParam(function, 1));
+    LLVMBuildStore(builder,
+                   LLVMBuildAdd(builder, LLVMBuildLoad2(builder, int64, total, ""),
+                                LLVMBuildAdd(builder, range.value,
+                                             LLVMBuildMul(builder, loop_getRangeIndex(builder, &range),
+                                                          LLVMConstInt(int64, 100, false), ""),
+                                             ""),
+                                ""),
+                   total);
+    loop_endRange(builder, &range);
+
+    LLVMBuildRet(builder, LLVMBuildLoad2(builder, int64, total, ""));
+    LLVMDisposeBuilder(builder);
+
+    for (size_t index = 0; index < sizeof(RANGES) / sizeof(RANGES[0]); index++) {
+        test_expect_(self,
+                     LLVMBuildCall2(self->builder, LLVMGlobalGetValueType(function), function,
+                                    (LLVMValueRef[]){LLVMConstInt(int64, (unsigned long long)RANGES[index][0], true),
+                                                     LLVMConstInt(int64, (unsigned long long)RANGES[index][1], true)},
+                                    2, ""),
+                     LLVMConstInt(int64, (unsigned long long)RANGES[index][2], true));
+    }
+}
+
+/**
+ * Checks the element-wise operators and reductions on vectors of integers.
+ *
+ * @param self The current Test struct.
+ */
+void test_checkIntegerVector_(struct Test *self) {
+    LLVMTypeRef type = vector_getType(self->context, "i32", 4), int32 = LLVMGetElementType(type);
+    LLVMValueRef numbers = test_buildIntegers_(self, (long long[]){1, -2, 3, 4}, 4),
+                 twos = vector_buildSplat(self->builder, type, LLVMConstInt(int32, 2, false)),
+                 places = test_buildIntegers_(self, (long long[]){1000, 100, 10, 1}, 4), shuffle = NULL,
+                 slot = LLVMBuildAlloca(self->builder, type, "numbers");
+
+    // Loaded, so the operators are not folded away as constants before 'lli' runs them
+    LLVMBuildStore(self->builder, numbers, slot);
+    numbers = LLVMBuildLoad2(self->builder, type, slot, "");
+
+#define TEST_REDUCE(OPERATOR, VECTOR) vector_buildReduction(self->builder, OPERATOR, VECTOR, true)
+#define TEST_OPERATE(OPERATOR, LEFT, RIGHT) vector_buildOperation(self->builder, OPERATOR, LEFT, RIGHT, true)
+#define TEST_INTEGER(VALUE) LLVMConstInt(int32, (unsigned long long)(VALUE), true)
+
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_ADDITION, TEST_OPERATE(LEXERTOKENS_ADDITION, numbers, twos)),
+                 TEST_INTEGER(14));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_ADDITION, TEST_OPERATE(LEXERTOKENS_SUBTRACTION, numbers, twos)),
+                 TEST_INTEGER(-2));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_MULTIPLICATION, TEST_OPERATE(LEXERTOKENS_MULTIPLICATION, numbers, twos)),
+                 TEST_INTEGER(-384));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_ADDITION, TEST_OPERATE(LEXERTOKENS_DIVISION, numbers, twos)),
+                 TEST_INTEGER(2));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_ADDITION, TEST_OPERATE(LEXERTOKENS_FLOOR_DIVISION, numbers, twos)),
+                 TEST_INTEGER(2));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_ADDITION, TEST_OPERATE(LEXERTOKENS_MODULO, numbers, twos)),
+                 TEST_INTEGER(2));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_ADDITION, TEST_OPERATE(LEXERTOKENS_BITWISE_LEFT_SHIFT, numbers, twos)),
+                 TEST_INTEGER(24));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_ADDITION, TEST_OPERATE(LEXERTOKENS_BITWISE_RIGHT_SHIFT, numbers, twos)),
+                 TEST_INTEGER(0));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_BITWISE_AND, numbers), TEST_INTEGER(0));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_BITWISE_OR, numbers), TEST_INTEGER(-1));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_BITWISE_XOR, numbers), TEST_INTEGER(-8));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_LESS_THAN, numbers), TEST_INTEGER(-2));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_GREATER_THAN, numbers), TEST_INTEGER(4));
+    test_expect_(self, vector_buildReduction(self->builder, LEXERTOKENS_GREATER_THAN, numbers, false),
+                 TEST_INTEGER(-2));
+    test_expect_(self,
+                 TEST_REDUCE(LEXERTOKENS_ADDITION, vector_buildUnaryOperation(self->builder, LEXERTOKENS_SUBTRACTION,
+                                                                             numbers)),
+                 TEST_INTEGER(-6));
+    test_expect_(self,
+                 TEST_REDUCE(LEXERTOKENS_ADDITION, vector_buildUnaryOperation(self->builder, LEXERTOKENS_BITWISE_NOT,
+                                                                             numbers)),
+                 TEST_INTEGER(-10));
+    test_expect_(self,
+                 TEST_REDUCE(LEXERTOKENS_ADDITION,
+                             LLVMBuildZExt(self->builder, TEST_OPERATE(LEXERTOKENS_GREATER_THAN, numbers, twos), type,
+                                           "")),
+                 TEST_INTEGER(2));
+    test_expect_(self,
+                 TEST_REDUCE(LEXERTOKENS_ADDITION,
+                             LLVMBuildZExt(self->builder, TEST_OPERATE(LEXERTOKENS_LESS_THAN_OR_EQUAL, numbers, twos),
+                                           type, "")),
+                 TEST_INTEGER(2));
+
+    // Picks 4, 3, then 2 from the splat, then 1, as digits
+    shuffle = vector_buildShuffle(self->builder, numbers, twos, (unsigned[]){3, 2, 5, 0}, 4);
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_ADDITION, TEST_OPERATE(LEXERTOKENS_MULTIPLICATION, shuffle, places)),
+                 TEST_INTEGER(4321));
+
+#undef TEST_REDUCE
+#undef TEST_OPERATE
+#undef TEST_INTEGER
+}
+
+/**
+ * Checks the element-wise operators and reductions on vectors of floats,
+ * including the pairwise sums and products.
+ *
+ * @param self The current Test struct.
+ */
+void test_checkFloatVector_(struct Test *self) {
+    LLVMTypeRef type = vector_getType(self->context, "f64", 8), float64 = LLVMGetElementType(type);
+    LLVMValueRef elements[8], numbers = NULL, threes = vector_buildSplat(self->builder, type, LLVMConstReal(float64, 3)),
+                              slot = LLVMBuildAlloca(self->builder, type, "floats");
+
+    for (unsigned index = 0; index < 8; index++) {
+        elements[index] = LLVMConstReal(float64, index + 1);
+    }
+
+    LLVMBuildStore(self->builder, LLVMConstVector(elements, 8), slot);
+    numbers = LLVMBuildLoad2(self->builder, type, slot, "");
+
+#define TEST_REDUCE(OPERATOR, VECTOR) vector_buildReduction(self->builder, OPERATOR, VECTOR, true)
+#define TEST_OPERATE(OPERATOR, LEFT, RIGHT) vector_buildOperation(self->builder, OPERATOR, LEFT, RIGHT, true)
+#define TEST_FLOAT(VALUE) LLVMConstReal(float64, VALUE)
+
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_ADDITION, numbers), TEST_FLOAT(36));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_MULTIPLICATION, numbers), TEST_FLOAT(40320));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_LESS_THAN, numbers), TEST_FLOAT(1));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_GREATER_THAN, numbers), TEST_FLOAT(8));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_ADDITION, TEST_OPERATE(LEXERTOKENS_SUBTRACTION, numbers, threes)),
+                 TEST_FLOAT(12));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_ADDITION, TEST_OPERATE(LEXERTOKENS_DIVISION, numbers, threes)),
+                 TEST_FLOAT(12));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_ADDITION, TEST_OPERATE(LEXERTOKENS_FLOOR_DIVISION, numbers, threes)),
+                 TEST_FLOAT(9));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_ADDITION, TEST_OPERATE(LEXERTOKENS_MODULO, numbers, threes)),
+                 TEST_FLOAT(9));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_ADDITION, TEST_OPERATE(LEXERTOKENS_EXPONENT, numbers, threes)),
+                 TEST_FLOAT(1296));
+    test_expect_(self,
+                 TEST_REDUCE(LEXERTOKENS_ADDITION, vector_buildUnaryOperation(self->builder, LEXERTOKENS_SUBTRACTION,
+                                                                             numbers)),
+                 TEST_FLOAT(-36));
+
+    type = vector_getType(self->context, "f64", 3); // Not a power of two, so not reduced pairwise
+    slot = LLVMBuildAlloca(self->builder, type, "odd");
+    LLVMBuildStore(self->builder, LLVMConstVector((LLVMValueRef[]){TEST_FLOAT(1.5), TEST_FLOAT(2), TEST_FLOAT(-0.5)}, 3),
+                   slot);
+    numbers = LLVMBuildLoad2(self->builder, type, slot, "");
+
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_ADDITION, numbers), TEST_FLOAT(3));
+    test_expect_(self, TEST_REDUCE(LEXERTOKENS_MULTIPLICATION, numbers), TEST_FLOAT(-1.5));
+
+#undef TEST_REDUCE
+#undef TEST_OPERATE
+#undef TEST_FLOAT
+}
+
+/**
+ * Builds a function returning a number, for vector_buildDispatch to pick.
+ *
+ * @param self     The current Test struct.
+ * @param NAME     The name of the function.
+ * @param number   The number it returns.
+ * @param FEATURES The CPU features it is specialised for, or NULL.
+ *
+ * @return The function.
+ */
+LLVMValueRef test_buildVersion_(struct Test *self, const char *NAME, unsigned number, const char *FEATURES) {
+    LLVMTypeRef int32 = LLVMInt32TypeInContext(self->context);
+    LLVMValueRef function = LLVMAddFunction(self->module, NAME, LLVMFunctionType(int32, NULL, 0, false));
+    LLVMBuilderRef builder = LLVMCreateBuilderInContext(self->context);
+
+    if (FEATURES) {
+        vector_setTarget(function, FEATURES);
+    }
+
+    LLVMPositionBuilderAtEnd(builder, LLVMAppendBasicBlockInContext(self->context, function, "entry"));
+    LLVMBuildRet(builder, LLVMConstInt(int32, number, false));
+    LLVMDisposeBuilder(builder);
+
+    return function;
+}
+
+/**
+ * Checks a dispatch picks the version for the CPU running it, both when it
+ * resolves the version and once it has kept it.
+ *
+ * @param self The current Test struct.
+ */
+void test_checkDispatch_(struct Test *self) {
+    LLVMValueRef dispatch = vector_buildDispatch(self->module, "pick", "avx2",
+                                                 test_buildVersion_(self, "pick.avx2", 1, "avx2, fma"),
+                                                 test_buildVersion_(self, "pick.fallback", 2, NULL));
+    unsigned expected = 2;
+
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    expected = __builtin_cpu_supports("avx2") ? 1 : 2; // 'lli' runs on the CPU building the test
+#endif
+
+    for (unsigned call = 0; call < 2; call++) {
+        test_expect_(self, LLVMBuildCall2(self->builder, LLVMGlobalGetValueType(dispatch), dispatch, NULL, 0, ""),
+                     LLVMConstInt(LLVMInt32TypeInContext(self->context), expected, false));
+    }
+}
+
+int main(const int argc, const char **argv) {
+    struct Test test = {LLVMContextCreate(), NULL, NULL, NULL, 0};
+    char *error = NULL;
+
+    if (argc != 2) {
+        panic("expected the file to write the module to");
+    }
+
+    test.module = LLVMModuleCreateWithNameInContext("codegen", test.context);
+    test.builder = LLVMCreateBuilderInContext(test.context);
+    test.main = LLVMAddFunction(test.module, "main",
+                                LLVMFunctionType(LLVMInt32TypeInContext(test.context), NULL, 0, false));
+    LLVMPositionBuilderAtEnd(test.builder, LLVMAppendBasicBlockInContext(test.context, test.main, "entry"));
+
+    test_checkArithmetic_(&test);
+    test_checkRange_(&test);
+    test_checkIntegerVector_(&test);
+    test_checkFloatVector_(&test);
+    test_checkDispatch_(&test);
+
+    LLVMBuildRet(test.builder, LLVMConstNull(LLVMInt32TypeInContext(test.context)));
+
+    if (LLVMVerifyModule(test.module, LLVMReturnStatusAction, &error)) {
+        panic(stringConcatenate(2, "built an invalid module: ", error));
+    } else if (LLVMWriteBitcodeToFile(test.module, argv[1]) != 0) {
+        panic(stringConcatenate(3, "failed to write '", argv[1], "'"));
+    }
+
+    LLVMDisposeMessage(error);
+    LLVMDisposeBuilder(test.builder);
+    LLVMDisposeModule(test.module);
+    LLVMContextDispose(test.context);
+
+    printf("built %u checks\n", test.checks);
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+; Checks the calls 'codegen/devirtualize.c' guards pass their arguments as
+; the call through the vtable did, exiting with the number of the first
+; check to fail, or 0. The methods take a pair 'byval', so they get a copy
+; of it to change, and the caller's pair must be left as it was. Their
+; 'self' is untyped, so the calls made direct are through a bitcast, and
+; only take the attributes the call gives them.
+
+%Counter = type { i8** }
+%Pair = type { i64, i64, i64, i64 } ; Too big for registers, so 'byval' copies it on the stack
+
+declare i1 @llvm.type.test(i8*, metadata)
+declare void @llvm.assume(i1)
+
+; Adds one to the first of its copy of the pair, and returns the sum.
+define i64 @Up_SEP_step(i8* %self, %Pair* byval(%Pair) %pair) noinline {
+    %first_pointer = getelementptr %Pair, %Pair* %pair, i64 0, i32 0
+    %first = load i64, i64* %first_pointer
+    %stepped = add i64 %first, 1
+    store i64 %stepped, i64* %first_pointer
+    %last_pointer = getelementptr %Pair, %Pair* %pair, i64 0, i32 3
+    %last = load i64, i64* %last_pointer
+    %sum = add i64 %stepped, %last
+    ret i64 %sum
+}
+
+; Takes one from the first of its copy of the pair, and returns the sum.
+define i64 @Down_SEP_step(i8* %self, %Pair* byval(%Pair) %pair) noinline {
+    %first_pointer = getelementptr %Pair, %Pair* %pair, i64 0, i32 0
+    %first = load i64, i64* %first_pointer
+    %stepped = sub i64 %first, 1
+    store i64 %stepped, i64* %first_pointer
+    %last_pointer = getelementptr %Pair, %Pair* %pair, i64 0, i32 3
+    %last = load i64, i64* %last_pointer
+    %sum = add i64 %stepped, %last
+    ret i64 %sum
+}
+
+@Up_vtable = constant { [1 x i8*] } { [1 x i8*] [i8* bitcast (i64 (i8*, %Pair*)* @Up_SEP_step to i8*)] },
+             !type !0, !type !1
+@Down_vtable = constant { [1 x i8*] } { [1 x i8*] [i8* bitcast (i64 (i8*, %Pair*)* @Down_SEP_step to i8*)] },
+               !type !0, !type !2
+
+@up = global %Counter { i8** getelementptr ({ [1 x i8*] }, { [1 x i8*] }* @Up_vtable, i32 0, i32 0, i32 0) }
+@down = global %Counter { i8** getelementptr ({ [1 x i8*] }, { [1 x i8*] }* @Down_vtable, i32 0, i32 0, i32 0) }
+
+; Calls 'step' through the counter's vtable.
+define i64 @step(%Counter* %counter, %Pair* %pair) noinline {
+    %vtable_pointer = getelementptr %Counter, %Counter* %counter, i32 0, i32 0
+    %vtable = load i8**, i8*** %vtable_pointer
+    %vtable_bytes = bitcast i8** %vtable to i8*
+    %is_counter = call i1 @llvm.type.test(i8* %vtable_bytes, metadata !"Counter")
+    call void @llvm.assume(i1 %is_counter)
+    %method_bytes = load i8*, i8** %vtable
+    %method = bitcast i8* %method_bytes to i64 (%Counter*, %Pair*)*
+    %sum = call i64 %method(%Counter* %counter, %Pair* byval(%Pair) %pair)
+    ret i64 %sum
+}
+
+define i32 @main(i32 %argc, i8** %argv) {
+entry:
+    %pair = alloca %Pair
+    store %Pair { i64 10, i64 0, i64 0, i64 5 }, %Pair* %pair
+    %is_up = icmp eq i32 %argc, 1 ; Not known until runtime, so both methods can be called
+    %counter = select i1 %is_up, %Counter* @up, %Counter* @down
+    %sum = call i64 @step(%Counter* %counter, %Pair* %pair)
+
+    ; 1: The method got the pair's values
+    %is_sum = icmp eq i64 %sum, 16
+    br i1 %is_sum, label %check_2, label %fail_1
+
+check_2: ; 2: The method changed its copy, not the caller's pair
+    %first_pointer = getelementptr %Pair, %Pair* %pair, i64 0, i32 0
+    %first = load i64, i64* %first_pointer
+    %is_kept = icmp eq i64 %first, 10
+    br i1 %is_kept, label %pass, label %fail_2
+
+pass:
+    ret i32 0
+
+fail_1:
+    ret i32 1
+
+fail_2:
+    ret i32 2
+}
+
+!0 = !{i64 0, !"Counter"}
+!1 = !{i64 0, !"Up"}
+!2 = !{i64 0, !"Down"}
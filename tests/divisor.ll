@@ -0,0 +1,284 @@
+; Checks the divisions 'codegen/divisor.c' turns into magic numbers give
+; the hardware's results. Each check divides 1000 dividends from a start by
+; a divisor given as an argument, so it does not change in the loop, and
+; again by the same divisor loaded each iteration, which is left as a
+; divide. 'check_nested' takes its loops' lengths as arguments, so is only
+; changed as one loop is nested in the other. Divisors include 1, -1, powers
+; of 2 and the largest and smallest of each type, and dividends reach both
+; ends of it. Exits with 0 if every result is the same, else the number of
+; the first check which failed.
+;
+;   for start = starts {
+;       for divisor = divisors {
+;           for n = range(start, start + 1000) {
+;               assert(n / divisor == n / volatile_divisor)
+;           }
+;       }
+;   }
+
+@divisor = internal global i64 0
+@divisors_64 = internal constant [10 x i64] [
+    i64 1, i64 -1, i64 2, i64 3, i64 7, i64 641, i64 4294967297, i64 -1000000007, i64 9223372036854775807,
+    i64 -9223372036854775808
+]
+@starts_64 = internal constant [5 x i64] [
+    i64 0, i64 -500, i64 1099511627776, i64 9223372036854774808, i64 -9223372036854775807
+]
+@divisors_32 = internal constant [8 x i32] [i32 1, i32 -1, i32 2, i32 3, i32 7, i32 641, i32 2147483647, i32 -2147483648]
+@starts_32 = internal constant [4 x i32] [i32 0, i32 -500, i32 2147482648, i32 -2147483647]
+
+; Gets whether 1000 unsigned 64-bit divisions and remainders from 'start'
+; by 'divisor' are the same as the hardware's.
+define i1 @check_unsigned_64(i64 %start, i64 %divisor) noinline {
+entry:
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %body ]
+    %is_same = phi i1 [ true, %entry ], [ %next_is_same, %body ]
+    %is_checking = icmp ult i64 %index, 1000
+    br i1 %is_checking, label %body, label %exit
+
+body:
+    %n = add i64 %start, %index
+    %quotient = udiv i64 %n, %divisor
+    %remainder = urem i64 %n, %divisor
+    %hardware_divisor = load volatile i64, i64* @divisor
+    %hardware_quotient = udiv i64 %n, %hardware_divisor
+    %hardware_remainder = urem i64 %n, %hardware_divisor
+    %is_same_quotient = icmp eq i64 %quotient, %hardware_quotient
+    %is_same_remainder = icmp eq i64 %remainder, %hardware_remainder
+    %is_same_both = and i1 %is_same_quotient, %is_same_remainder
+    %next_is_same = and i1 %is_same, %is_same_both
+    %next_index = add i64 %index, 1
+    br label %condition
+
+exit:
+    ret i1 %is_same
+}
+
+; Gets whether 1000 signed 64-bit divisions and remainders from 'start' by
+; 'divisor' are the same as the hardware's.
+define i1 @check_signed_64(i64 %start, i64 %divisor) noinline {
+entry:
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %body ]
+    %is_same = phi i1 [ true, %entry ], [ %next_is_same, %body ]
+    %is_checking = icmp ult i64 %index, 1000
+    br i1 %is_checking, label %body, label %exit
+
+body:
+    %n = add i64 %start, %index
+    %quotient = sdiv i64 %n, %divisor
+    %remainder = srem i64 %n, %divisor
+    %hardware_divisor = load volatile i64, i64* @divisor
+    %hardware_quotient = sdiv i64 %n, %hardware_divisor
+    %hardware_remainder = srem i64 %n, %hardware_divisor
+    %is_same_quotient = icmp eq i64 %quotient, %hardware_quotient
+    %is_same_remainder = icmp eq i64 %remainder, %hardware_remainder
+    %is_same_both = and i1 %is_same_quotient, %is_same_remainder
+    %next_is_same = and i1 %is_same, %is_same_both
+    %next_index = add i64 %index, 1
+    br label %condition
+
+exit:
+    ret i1 %is_same
+}
+
+; Gets whether 1000 unsigned 32-bit divisions and remainders from 'start'
+; by 'divisor' are the same as the hardware's.
+define i1 @check_unsigned_32(i32 %start, i32 %divisor) noinline {
+entry:
+    br label %condition
+
+condition:
+    %index = phi i32 [ 0, %entry ], [ %next_index, %body ]
+    %is_same = phi i1 [ true, %entry ], [ %next_is_same, %body ]
+    %is_checking = icmp ult i32 %index, 1000
+    br i1 %is_checking, label %body, label %exit
+
+body:
+    %n = add i32 %start, %index
+    %quotient = udiv i32 %n, %divisor
+    %remainder = urem i32 %n, %divisor
+    %hardware_divisor_64 = load volatile i64, i64* @divisor
+    %hardware_divisor = trunc i64 %hardware_divisor_64 to i32
+    %hardware_quotient = udiv i32 %n, %hardware_divisor
+    %hardware_remainder = urem i32 %n, %hardware_divisor
+    %is_same_quotient = icmp eq i32 %quotient, %hardware_quotient
+    %is_same_remainder = icmp eq i32 %remainder, %hardware_remainder
+    %is_same_both = and i1 %is_same_quotient, %is_same_remainder
+    %next_is_same = and i1 %is_same, %is_same_both
+    %next_index = add i32 %index, 1
+    br label %condition
+
+exit:
+    ret i1 %is_same
+}
+
+; Gets whether 1000 signed 32-bit divisions and remainders from 'start' by
+; 'divisor' are the same as the hardware's.
+define i1 @check_signed_32(i32 %start, i32 %divisor) noinline {
+entry:
+    br label %condition
+
+condition:
+    %index = phi i32 [ 0, %entry ], [ %next_index, %body ]
+    %is_same = phi i1 [ true, %entry ], [ %next_is_same, %body ]
+    %is_checking = icmp ult i32 %index, 1000
+    br i1 %is_checking, label %body, label %exit
+
+body:
+    %n = add i32 %start, %index
+    %quotient = sdiv i32 %n, %divisor
+    %remainder = srem i32 %n, %divisor
+    %hardware_divisor_64 = load volatile i64, i64* @divisor
+    %hardware_divisor = trunc i64 %hardware_divisor_64 to i32
+    %hardware_quotient = sdiv i32 %n, %hardware_divisor
+    %hardware_remainder = srem i32 %n, %hardware_divisor
+    %is_same_quotient = icmp eq i32 %quotient, %hardware_quotient
+    %is_same_remainder = icmp eq i32 %remainder, %hardware_remainder
+    %is_same_both = and i1 %is_same_quotient, %is_same_remainder
+    %next_is_same = and i1 %is_same, %is_same_both
+    %next_index = add i32 %index, 1
+    br label %condition
+
+exit:
+    ret i1 %is_same
+}
+
+; Gets whether signed 64-bit divisions by 'divisor' of 'length' dividends
+; from each of the first 'starts' starts are the same as the hardware's.
+define i1 @check_nested(i64 %divisor, i64 %starts, i64 %length) noinline {
+entry:
+    br label %outer_condition
+
+outer_condition:
+    %start_index = phi i64 [ 0, %entry ], [ %next_start_index, %outer_latch ]
+    %is_same = phi i1 [ true, %entry ], [ %inner_is_same, %outer_latch ]
+    %is_starting = icmp ult i64 %start_index, %starts
+    br i1 %is_starting, label %outer_body, label %exit
+
+outer_body:
+    %start_pointer = getelementptr [5 x i64], [5 x i64]* @starts_64, i64 0, i64 %start_index
+    %start = load i64, i64* %start_pointer
+    br label %inner_condition
+
+inner_condition:
+    %index = phi i64 [ 0, %outer_body ], [ %next_index, %inner_body ]
+    %inner_is_same = phi i1 [ %is_same, %outer_body ], [ %next_is_same, %inner_body ]
+    %is_checking = icmp ult i64 %index, %length
+    br i1 %is_checking, label %inner_body, label %outer_latch
+
+inner_body:
+    %n = add i64 %start, %index
+    %quotient = sdiv i64 %n, %divisor
+    %hardware_divisor = load volatile i64, i64* @divisor
+    %hardware_quotient = sdiv i64 %n, %hardware_divisor
+    %is_same_quotient = icmp eq i64 %quotient, %hardware_quotient
+    %next_is_same = and i1 %inner_is_same, %is_same_quotient
+    %next_index = add i64 %index, 1
+    br label %inner_condition
+
+outer_latch:
+    %next_start_index = add i64 %start_index, 1
+    br label %outer_condition
+
+exit:
+    ret i1 %is_same
+}
+
+define i32 @main() {
+entry:
+    br label %divisor_64_condition
+
+divisor_64_condition:
+    %divisor_64_index = phi i64 [ 0, %entry ], [ %next_divisor_64_index, %start_64_exit ]
+    %is_dividing_64 = icmp ult i64 %divisor_64_index, 10
+    br i1 %is_dividing_64, label %divisor_64_body, label %divisor_32_condition
+
+divisor_64_body:
+    %divisor_64_pointer = getelementptr [10 x i64], [10 x i64]* @divisors_64, i64 0, i64 %divisor_64_index
+    %divisor_64 = load i64, i64* %divisor_64_pointer
+    store volatile i64 %divisor_64, i64* @divisor
+    %is_same_nested = call i1 @check_nested(i64 %divisor_64, i64 5, i64 1000)
+    br i1 %is_same_nested, label %start_64_condition, label %failed_nested
+
+start_64_condition:
+    %start_64_index = phi i64 [ 0, %divisor_64_body ], [ %next_start_64_index, %signed_64_passed ]
+    %is_starting_64 = icmp ult i64 %start_64_index, 5
+    br i1 %is_starting_64, label %start_64_body, label %start_64_exit
+
+start_64_body:
+    %start_64_pointer = getelementptr [5 x i64], [5 x i64]* @starts_64, i64 0, i64 %start_64_index
+    %start_64 = load i64, i64* %start_64_pointer
+    %is_same_unsigned_64 = call i1 @check_unsigned_64(i64 %start_64, i64 %divisor_64)
+    br i1 %is_same_unsigned_64, label %unsigned_64_passed, label %failed_unsigned_64
+
+unsigned_64_passed:
+    %is_same_signed_64 = call i1 @check_signed_64(i64 %start_64, i64 %divisor_64)
+    br i1 %is_same_signed_64, label %signed_64_passed, label %failed_signed_64
+
+signed_64_passed:
+    %next_start_64_index = add i64 %start_64_index, 1
+    br label %start_64_condition
+
+start_64_exit:
+    %next_divisor_64_index = add i64 %divisor_64_index, 1
+    br label %divisor_64_condition
+
+divisor_32_condition:
+    %divisor_32_index = phi i64 [ 0, %divisor_64_condition ], [ %next_divisor_32_index, %start_32_exit ]
+    %is_dividing_32 = icmp ult i64 %divisor_32_index, 8
+    br i1 %is_dividing_32, label %divisor_32_body, label %passed
+
+divisor_32_body:
+    %divisor_32_pointer = getelementptr [8 x i32], [8 x i32]* @divisors_32, i64 0, i64 %divisor_32_index
+    %divisor_32 = load i32, i32* %divisor_32_pointer
+    %divisor_32_extended = sext i32 %divisor_32 to i64
+    store volatile i64 %divisor_32_extended, i64* @divisor
+    br label %start_32_condition
+
+start_32_condition:
+    %start_32_index = phi i64 [ 0, %divisor_32_body ], [ %next_start_32_index, %signed_32_passed ]
+    %is_starting_32 = icmp ult i64 %start_32_index, 4
+    br i1 %is_starting_32, label %start_32_body, label %start_32_exit
+
+start_32_body:
+    %start_32_pointer = getelementptr [4 x i32], [4 x i32]* @starts_32, i64 0, i64 %start_32_index
+    %start_32 = load i32, i32* %start_32_pointer
+    %is_same_unsigned_32 = call i1 @check_unsigned_32(i32 %start_32, i32 %divisor_32)
+    br i1 %is_same_unsigned_32, label %unsigned_32_passed, label %failed_unsigned_32
+
+unsigned_32_passed:
+    %is_same_signed_32 = call i1 @check_signed_32(i32 %start_32, i32 %divisor_32)
+    br i1 %is_same_signed_32, label %signed_32_passed, label %failed_signed_32
+
+signed_32_passed:
+    %next_start_32_index = add i64 %start_32_index, 1
+    br label %start_32_condition
+
+start_32_exit:
+    %next_divisor_32_index = add i64 %divisor_32_index, 1
+    br label %divisor_32_condition
+
+passed:
+    ret i32 0
+
+failed_unsigned_64:
+    ret i32 1
+
+failed_signed_64:
+    ret i32 2
+
+failed_unsigned_32:
+    ret i32 3
+
+failed_signed_32:
+    ret i32 4
+
+failed_nested:
+    ret i32 5
+}
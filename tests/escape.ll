@@ -0,0 +1,75 @@
+; Checks 'codegen/escape.c' leaves the objects of functions in call cycles
+; on the heap when the cycle spans codegen units. 'even' and 'odd' call
+; each other 40000 times, each holding a 256 byte buffer, so with the
+; buffers moved onto the stack the frames need over 10 MiB and overflow
+; it. Build with '-i', so each function is in a unit of its own. Exits
+; with 0 once the cycle is done.
+
+declare noalias i8* @malloc(i64)
+declare void @free(i8* nocapture)
+
+; Fills a buffer with a byte.
+define void @fill(i8* nocapture writeonly %buffer, i8 %byte) nofree nounwind noinline {
+    call void @llvm.memset.p0i8.i64(i8* %buffer, i8 %byte, i64 256, i1 false)
+    ret void
+}
+
+; Reads a byte from a buffer.
+define i8 @peek(i8* nocapture readonly %buffer, i64 %index) nofree nounwind noinline {
+    %pointer = getelementptr i8, i8* %buffer, i64 %index
+    %byte = load i8, i8* %pointer
+    ret i8 %byte
+}
+
+declare void @llvm.memset.p0i8.i64(i8* nocapture writeonly, i8, i64, i1 immarg)
+
+; Counts 'n' down to 0 through 'odd', returning 1 if 'n' is even.
+define i8 @even(i64 %n) noinline {
+entry:
+    %buffer = call i8* @malloc(i64 256)
+    call void @fill(i8* %buffer, i8 1)
+    %is_done = icmp eq i64 %n, 0
+    br i1 %is_done, label %done, label %recurse
+
+recurse:
+    %next = sub i64 %n, 1
+    %odd = call i8 @odd(i64 %next)
+    %index = and i64 %n, 255
+    %byte = call i8 @peek(i8* %buffer, i64 %index)
+    %result = and i8 %odd, %byte
+    call void @free(i8* %buffer)
+    ret i8 %result
+
+done:
+    call void @free(i8* %buffer)
+    ret i8 1
+}
+
+; Counts 'n' down to 0 through 'even', returning 1 if 'n' is odd.
+define i8 @odd(i64 %n) noinline {
+entry:
+    %buffer = call i8* @malloc(i64 256)
+    call void @fill(i8* %buffer, i8 1)
+    %is_done = icmp eq i64 %n, 0
+    br i1 %is_done, label %done, label %recurse
+
+recurse:
+    %next = sub i64 %n, 1
+    %even = call i8 @even(i64 %next)
+    %index = and i64 %n, 255
+    %byte = call i8 @peek(i8* %buffer, i64 %index)
+    %result = and i8 %even, %byte
+    call void @free(i8* %buffer)
+    ret i8 %result
+
+done:
+    call void @free(i8* %buffer)
+    ret i8 0
+}
+
+define i32 @main() {
+    %even = call i8 @even(i64 40000)
+    %failed = icmp ne i8 %even, 1
+    %result = zext i1 %failed to i32
+    ret i32 %result
+}
@@ -0,0 +1,212 @@
+; Checks 'codegen/evaluator.c' folds calls to functions with the
+; 'exeme-const' attribute, which '@const' marks them with, and evaluates
+; global constructors, to the results they have when run. Each function is
+; called with constant arguments, which must be folded or the build fails,
+; then with the same arguments loaded through a volatile pointer, which
+; runs it. Exits with 0 if every result is the same, else the number of the
+; first check which failed.
+;
+;   @const
+;   collatz_steps(n: u64) -> u64 { ... }
+;
+;   assert(collatz_steps(27) == collatz_steps(volatile 27))
+
+@arguments = internal global [4 x i64] [i64 27, i64 90, i64 100, i64 -1000]
+@squares = internal global [16 x i64] zeroinitializer
+@offsets = internal constant [4 x i64] [i64 7, i64 -3, i64 11, i64 -5]
+@llvm.global_ctors = appending global [1 x { i32, void ()*, i8* }] [
+    { i32, void ()*, i8* } { i32 65535, void ()* @fill_squares, i8* null }
+]
+
+; Counts the steps from 'n' to 1 of the Collatz sequence.
+define i64 @collatz_steps(i64 %n) #0 {
+entry:
+    br label %condition
+
+condition:
+    %value = phi i64 [ %n, %entry ], [ %next_value, %step ]
+    %steps = phi i64 [ 0, %entry ], [ %next_steps, %step ]
+    %is_done = icmp ule i64 %value, 1
+    br i1 %is_done, label %exit, label %step
+
+step:
+    %bit = and i64 %value, 1
+    %is_odd = icmp ne i64 %bit, 0
+    %tripled = mul i64 %value, 3
+    %odd_value = add i64 %tripled, 1
+    %even_value = lshr i64 %value, 1
+    %next_value = select i1 %is_odd, i64 %odd_value, i64 %even_value
+    %next_steps = add i64 %steps, 1
+    br label %condition
+
+exit:
+    ret i64 %steps
+}
+
+; Gets the 'n'th Fibonacci number.
+define i64 @fibonacci(i64 %n) #0 {
+entry:
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %body ]
+    %current = phi i64 [ 0, %entry ], [ %next, %body ]
+    %next = phi i64 [ 1, %entry ], [ %sum, %body ]
+    %is_stepping = icmp ult i64 %index, %n
+    br i1 %is_stepping, label %body, label %exit
+
+body:
+    %sum = add i64 %current, %next
+    %next_index = add i64 %index, 1
+    br label %condition
+
+exit:
+    ret i64 %current
+}
+
+; Counts the primes below 'n', of at most 256, with a sieve on the stack.
+define i64 @count_primes(i64 %n) #0 {
+entry:
+    %sieve = alloca [256 x i8]
+    br label %clear
+
+clear:
+    %clear_index = phi i64 [ 0, %entry ], [ %next_clear_index, %clear ]
+    %clear_pointer = getelementptr [256 x i8], [256 x i8]* %sieve, i64 0, i64 %clear_index
+    store i8 1, i8* %clear_pointer
+    %next_clear_index = add i64 %clear_index, 1
+    %is_clearing = icmp ult i64 %next_clear_index, 256
+    br i1 %is_clearing, label %clear, label %condition
+
+condition:
+    %candidate = phi i64 [ 2, %clear ], [ %next_candidate, %next ]
+    %count = phi i64 [ 0, %clear ], [ %next_count, %next ]
+    %is_sieving = icmp ult i64 %candidate, %n
+    br i1 %is_sieving, label %check, label %exit
+
+check:
+    %candidate_pointer = getelementptr [256 x i8], [256 x i8]* %sieve, i64 0, i64 %candidate
+    %flag = load i8, i8* %candidate_pointer
+    %is_prime = icmp ne i8 %flag, 0
+    br i1 %is_prime, label %strike, label %next
+
+strike:
+    %multiple = phi i64 [ %candidate, %check ], [ %next_multiple, %strike_body ]
+    %next_multiple = add i64 %multiple, %candidate
+    %is_striking = icmp ult i64 %next_multiple, 256
+    br i1 %is_striking, label %strike_body, label %next
+
+strike_body:
+    %multiple_pointer = getelementptr [256 x i8], [256 x i8]* %sieve, i64 0, i64 %next_multiple
+    store i8 0, i8* %multiple_pointer
+    br label %strike
+
+next:
+    %found = zext i1 %is_prime to i64
+    %next_count = add i64 %count, %found
+    %next_candidate = add i64 %candidate, 1
+    br label %condition
+
+exit:
+    ret i64 %count
+}
+
+; Mixes 'n' with signed arithmetic and a constant table, by another
+; '@const' function's result.
+define i64 @signed_mix(i64 %n) #0 {
+    %index = and i64 %n, 3
+    %offset_pointer = getelementptr [4 x i64], [4 x i64]* @offsets, i64 0, i64 %index
+    %offset = load i64, i64* %offset_pointer
+    %product = mul i64 %n, %offset
+    %quotient = sdiv i64 %product, -7
+    %remainder = srem i64 %product, 13
+    %shifted = ashr i64 %quotient, 2
+    %steps = call i64 @collatz_steps(i64 97)
+    %mixed = xor i64 %shifted, %remainder
+    %result = add i64 %mixed, %steps
+    ret i64 %result
+}
+
+; Fills 'squares' with the squares of its indices, before 'main' starts.
+define internal void @fill_squares() {
+entry:
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %body ]
+    %is_filling = icmp ult i64 %index, 16
+    br i1 %is_filling, label %body, label %exit
+
+body:
+    %square = mul i64 %index, %index
+    %square_pointer = getelementptr [16 x i64], [16 x i64]* @squares, i64 0, i64 %index
+    store i64 %square, i64* %square_pointer
+    %next_index = add i64 %index, 1
+    br label %condition
+
+exit:
+    ret void
+}
+
+; Gets an argument, loaded so it is not known when compiling.
+define internal i64 @argument(i64 %index) {
+    %pointer = getelementptr [4 x i64], [4 x i64]* @arguments, i64 0, i64 %index
+    %argument = load volatile i64, i64* %pointer
+    ret i64 %argument
+}
+
+define i32 @main() {
+entry:
+    %collatz_argument = call i64 @argument(i64 0)
+    %collatz_folded = call i64 @collatz_steps(i64 27)
+    %collatz_run = call i64 @collatz_steps(i64 %collatz_argument)
+    %is_same_collatz = icmp eq i64 %collatz_folded, %collatz_run
+    br i1 %is_same_collatz, label %fibonacci, label %failed_collatz
+
+fibonacci:
+    %fibonacci_argument = call i64 @argument(i64 1)
+    %fibonacci_folded = call i64 @fibonacci(i64 90)
+    %fibonacci_run = call i64 @fibonacci(i64 %fibonacci_argument)
+    %is_same_fibonacci = icmp eq i64 %fibonacci_folded, %fibonacci_run
+    br i1 %is_same_fibonacci, label %primes, label %failed_fibonacci
+
+primes:
+    %primes_argument = call i64 @argument(i64 2)
+    %primes_folded = call i64 @count_primes(i64 100)
+    %primes_run = call i64 @count_primes(i64 %primes_argument)
+    %is_same_primes = icmp eq i64 %primes_folded, %primes_run
+    br i1 %is_same_primes, label %signed, label %failed_primes
+
+signed:
+    %signed_argument = call i64 @argument(i64 3)
+    %signed_folded = call i64 @signed_mix(i64 -1000)
+    %signed_run = call i64 @signed_mix(i64 %signed_argument)
+    %is_same_signed = icmp eq i64 %signed_folded, %signed_run
+    br i1 %is_same_signed, label %squares, label %failed_signed
+
+squares:
+    %square_pointer = getelementptr [16 x i64], [16 x i64]* @squares, i64 0, i64 15
+    %square = load volatile i64, i64* %square_pointer
+    %is_same_square = icmp eq i64 %square, 225
+    br i1 %is_same_square, label %passed, label %failed_squares
+
+passed:
+    ret i32 0
+
+failed_collatz:
+    ret i32 1
+
+failed_fibonacci:
+    ret i32 2
+
+failed_primes:
+    ret i32 3
+
+failed_signed:
+    ret i32 4
+
+failed_squares:
+    ret i32 5
+}
+
+attributes #0 = { noinline "exeme-const" }
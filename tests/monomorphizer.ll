@@ -0,0 +1,60 @@
+; Instances of a generic 'codegen/monomorphizer.c' merges only when they
+; compile to the same code, exiting with the number of the first check to
+; fail, or 0. 'pick<i32>' and 'pick<u32>' are the same but for their type
+; arguments, so are merged, but 'pick<f32>' returns its value 'zeroext'
+; and 'pick<i64>' is in a section of its own, so each is kept. Building
+; with '--instance-report' should print "1 merged as identical".
+
+define internal i32 @"pick<i32>"(i32* %values, i64 %index) #0 {
+    %pointer = getelementptr i32, i32* %values, i64 %index
+    %value = load i32, i32* %pointer
+    ret i32 %value
+}
+
+define internal i32 @"pick<u32>"(i32* %values, i64 %index) #1 {
+    %pointer = getelementptr i32, i32* %values, i64 %index
+    %value = load i32, i32* %pointer
+    ret i32 %value
+}
+
+define internal zeroext i32 @"pick<f32>"(i32* %values, i64 %index) #2 {
+    %pointer = getelementptr i32, i32* %values, i64 %index
+    %value = load i32, i32* %pointer
+    ret i32 %value
+}
+
+define internal i32 @"pick<i64>"(i32* %values, i64 %index) #3 section ".text.pick" {
+    %pointer = getelementptr i32, i32* %values, i64 %index
+    %value = load i32, i32* %pointer
+    ret i32 %value
+}
+
+define i32 @main(i32 %argc, i8** %argv) {
+entry:
+    %values = alloca [2 x i32]
+    store [2 x i32] [i32 7, i32 9], [2 x i32]* %values
+    %first = getelementptr [2 x i32], [2 x i32]* %values, i64 0, i64 0
+    %index = sext i32 %argc to i64 ; 1, so not known until runtime
+    %signed = call i32 @"pick<i32>"(i32* %first, i64 %index)
+    %unsigned = call i32 @"pick<u32>"(i32* %first, i64 %index)
+    %float = call i32 @"pick<f32>"(i32* %first, i64 %index)
+    %long = call i32 @"pick<i64>"(i32* %first, i64 %index)
+    %signed_and_unsigned = add i32 %signed, %unsigned
+    %float_and_long = add i32 %float, %long
+    %sum = add i32 %signed_and_unsigned, %float_and_long
+
+    ; 1: Each instance, merged or not, picks the value
+    %is_sum = icmp eq i32 %sum, 36
+    br i1 %is_sum, label %pass, label %fail_1
+
+pass:
+    ret i32 0
+
+fail_1:
+    ret i32 1
+}
+
+attributes #0 = { noinline "exeme-generic"="pick" "exeme-type-arguments"="i32" }
+attributes #1 = { noinline "exeme-generic"="pick" "exeme-type-arguments"="u32" }
+attributes #2 = { noinline "exeme-generic"="pick" "exeme-type-arguments"="f32" }
+attributes #3 = { noinline "exeme-generic"="pick" "exeme-type-arguments"="i64" }
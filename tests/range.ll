@@ -0,0 +1,65 @@
+; A bounds check which LLVM's -O2 keeps and 'codegen/range.c' removes. A
+; ring buffer's position steps by 5 and wraps at 64, which instcombine
+; turns into 'position + (position > 58 ? -59 : 5)'. The two sides of the
+; select only stay below 64 with the positions picking them. Build with
+; 'exeme build tests/range.ll -o range --check-report', which should print
+; "removed 1 of 1 checks from 'ring_step'".
+;
+;   ring: [i64, 64]
+;   position = 0
+;   for _ = range(0, n) {
+;       total += ring[position]
+;       position += 5
+;       if (position >= 64) {
+;           position -= 64
+;       }
+;   }
+
+@ring = internal global [64 x i64] zeroinitializer
+@.format = private unnamed_addr constant [5 x i8] c"%ld\0A\00"
+
+declare void @abort() noreturn nounwind
+declare i32 @printf(i8*, ...)
+
+; Sums 'n' elements of the ring, stepping through it by 5.
+define i64 @ring_step(i64 %n) noinline {
+entry:
+    br label %condition
+
+condition:
+    %index = phi i64 [ 0, %entry ], [ %next_index, %passed ]
+    %position = phi i64 [ 0, %entry ], [ %next_position, %passed ]
+    %total = phi i64 [ 0, %entry ], [ %next_total, %passed ]
+    %is_summing = icmp ult i64 %index, %n
+    br i1 %is_summing, label %body, label %exit
+
+body:
+    %is_in_bounds = icmp ult i64 %position, 64
+    br i1 %is_in_bounds, label %passed, label %failed
+
+passed:
+    %element_pointer = getelementptr [64 x i64], [64 x i64]* @ring, i64 0, i64 %position
+    %element = load i64, i64* %element_pointer
+    %next_total = add i64 %total, %element
+    %stepped = add i64 %position, 5
+    %is_wrapping = icmp uge i64 %stepped, 64
+    %wrapped = sub i64 %stepped, 64
+    %next_position = select i1 %is_wrapping, i64 %wrapped, i64 %stepped
+    %next_index = add i64 %index, 1
+    br label %condition
+
+failed: ; Where a failed check goes, ending the program
+    call void @abort()
+    unreachable
+
+exit:
+    ret i64 %total
+}
+
+define i32 @main() {
+    %total = call i64 @ring_step(i64 1000)
+    %format = getelementptr [5 x i8], [5 x i8]* @.format, i64 0, i64 0
+    call i32 (i8*, ...) @printf(i8* %format, i64 %total)
+
+    ret i32 0
+}